@@ -43,6 +43,7 @@ void CDifodoDatasets::loadConfiguration(const utils::CConfigFileBase &ini )
 	rows = ini.read_int("DIFODO_CONFIG", "rows", 240, true);
 	cols = ini.read_int("DIFODO_CONFIG", "cols", 320, true);
 	ctf_levels = ini.read_int("DIFODO_CONFIG", "ctf_levels", 5, true);
+	num_threads = ini.read_int("DIFODO_CONFIG", "num_threads", 0, false);
 	string filename = ini.read_string("DIFODO_CONFIG", "filename", "no file", true);
 
 	//						Open Rawlog File
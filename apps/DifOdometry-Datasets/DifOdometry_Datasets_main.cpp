@@ -30,6 +30,9 @@ const char *default_cfg_txt =
 	"cols = 320 \n"
 	"ctf_levels = 5 \n\n"
 
+	";Number of threads for the per-pixel computations (0: as many as CPU cores) \n"
+	"num_threads = 0 \n\n"
+
 	";Absolute path of the rawlog file \n"
 	"filename = C:/Users/Mariano/Desktop/rawlog_rgbd_dataset_freiburg1_desk/rgbd_dataset_freiburg1_desk.rawlog \n";
 	//"filename = .../file.rawlog \n";
@@ -47,6 +50,7 @@ int main(int num_arg, char *argv[])
 		//						Read function arguments
 		//----------------------------------------------------------------------
 		bool use_config_file = false;
+		bool benchmark = false;
 		string filename;
 		CDifodoDatasets odo;
 
@@ -60,6 +64,8 @@ int main(int num_arg, char *argv[])
 			printf(" --create-config FICH.txt: Save the default config parameters \n\n");
 			printf(" \t\t\t   in FICH.txt and close the program \n\n");
 			printf(" --save-logfile: Enable saving a file with results of the pose estimate \n\n");
+			printf(" --benchmark: Process the whole dataset without GUI and show \n\n");
+			printf(" \t\t\t   the average runtime of each stage \n\n");
 			system::os::getch();
 			return 1;
 		}
@@ -84,6 +90,9 @@ int main(int num_arg, char *argv[])
 					odo.CreateResultsFile();
 				}
 
+				if ( string(argv[i]) == "--benchmark")
+					benchmark = true;
+
 				if ( string(argv[i]) == "--config")
 				{
 					use_config_file = true;
@@ -106,6 +115,50 @@ int main(int num_arg, char *argv[])
 			odo.loadConfiguration( configDifodo );
 		}
 
+		//Benchmark: run the odometry over the whole dataset and report the average runtimes
+		//------------------------------------------------------------------------------
+		if (benchmark)
+		{
+			odo.reset();
+
+			unsigned int num_frames = 0;
+			double total = 0, pyramid = 0, warping = 0, coordinates = 0, derivatives = 0, weights = 0, solver = 0, filter = 0;
+			while (!odo.dataset_finished)
+			{
+				odo.loadFrame();
+				odo.odometryCalculation();
+				if (odo.save_results == 1)
+					odo.writeTrajectoryFile();
+
+				num_frames++;
+				total += odo.execution_time;
+				pyramid += odo.stage_times.pyramid;
+				warping += odo.stage_times.warping;
+				coordinates += odo.stage_times.coordinates;
+				derivatives += odo.stage_times.derivatives;
+				weights += odo.stage_times.weights;
+				solver += odo.stage_times.solver;
+				filter += odo.stage_times.filter;
+			}
+			if (odo.f_res.is_open())
+				odo.f_res.close();
+
+			if (num_frames)
+			{
+				const double k = 1.0/num_frames;
+				printf("\nProcessed frames: %u (num_threads = %u)\n", num_frames, odo.num_threads);
+				printf("Average runtime per frame (ms): %.3f\n", k*total);
+				printf("  Pyramid:     %.3f\n", k*pyramid);
+				printf("  Warping:     %.3f\n", k*warping);
+				printf("  Coordinates: %.3f\n", k*coordinates);
+				printf("  Derivatives: %.3f\n", k*derivatives);
+				printf("  Weights:     %.3f\n", k*weights);
+				printf("  Solver:      %.3f\n", k*solver);
+				printf("  Filter:      %.3f\n", k*filter);
+			}
+			return 0;
+		}
+
 		odo.initializeScene();
 
 		//==============================================================================
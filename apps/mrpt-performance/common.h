@@ -16,6 +16,7 @@
 
 // All the register functions: --------------------
 void register_tests_icpslam();
+void register_tests_rbpf();
 void register_tests_poses();
 void register_tests_matrices();
 void register_tests_grids();
@@ -30,6 +31,8 @@ void register_tests_graph();
 void register_tests_graphslam();
 void register_tests_CObservation3DRangeScan();
 void register_tests_atan2lut();
+void register_tests_nav();
+void register_tests_data_association();
 // -------------------------------------------------
 
 typedef double (*TestFunctor)(int a1, int a2);  // return run-time in secs.
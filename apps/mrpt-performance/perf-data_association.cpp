@@ -0,0 +1,72 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/utils.h>
+#include <mrpt/random.h>
+#include <mrpt/slam/data_association.h>
+
+#include "common.h"
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace mrpt::slam;
+using namespace mrpt::math;
+using namespace mrpt::random;
+using namespace std;
+
+
+// ------------------------------------------------------
+//	Benchmark: JCBB data association of 20 range-bearing-like observations
+//   with a map of landmarks with full cross-covariances.
+//   a1: Number of predicted landmarks
+//   a2: Number of threads (0=one per core)
+// ------------------------------------------------------
+double da_test_1(int a1, int a2)
+{
+	CRandomGenerator rng(1234);
+
+	const size_t nPreds = a1, nObs = 20, O = 2;
+	CMatrixDouble y(nPreds,O), y_cov, z(nObs,O);
+	CMatrixDouble J(nPreds*O,O);
+	J.zeros();
+	for (size_t i=0;i<nPreds;i++)
+	{
+		y(i,0) = rng.drawUniform(-100,100);
+		y(i,1) = rng.drawUniform(-100,100);
+		J(i*O+0,0) = J(i*O+1,1) = 1;
+	}
+	// Common uncertainty (e.g. the vehicle pose) plus an independent one for each prediction:
+	y_cov = J * J.transpose() * 0.01;
+	for (size_t i=0;i<nPreds*O;i++)
+		y_cov(i,i) += 0.0025;
+
+	for (size_t j=0;j<nObs;j++)
+	{
+		const size_t i = (j*37+11)%nPreds;
+		z(j,0) = y(i,0) + rng.drawGaussian1D(0,0.05);
+		z(j,1) = y(i,1) + rng.drawGaussian1D(0,0.05);
+	}
+
+	TDataAssociationResults results;
+	const long N = 20;
+	CTicTac	 tictac;
+	for (long k=0;k<N;k++)
+		data_association_full_covariance(z, y, y_cov, results, assocJCBB, metricMaha, 0.99, true, std::vector<prediction_index_t>(), metricMaha, 0.0, a2);
+	return tictac.Tac()/N;
+}
+
+// ------------------------------------------------------
+// register_tests_data_association
+// ------------------------------------------------------
+void register_tests_data_association()
+{
+	lstTests.push_back( TestData("data_association: JCBB, 100 landmarks, 1 thread",da_test_1, 100, 1) );
+	lstTests.push_back( TestData("data_association: JCBB, 1000 landmarks, 1 thread",da_test_1, 1000, 1) );
+	lstTests.push_back( TestData("data_association: JCBB, 1000 landmarks, all cores",da_test_1, 1000, 0) );
+}
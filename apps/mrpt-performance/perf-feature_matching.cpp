@@ -9,6 +9,8 @@
 
 #include <mrpt/utils/CImage.h>
 #include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/vision/descriptor_pairing.h>
+#include <mrpt/random.h>
 
 #include "common.h"
 
@@ -254,6 +256,110 @@ double feature_matching_test_FAST_SAD( int w, int h )
 	return T;
 }
 
+// ------------------------------------------------------
+//	Auxiliary: random list of features with 32-byte ORB descriptors
+// ------------------------------------------------------
+void generateRandomORBFeatures( const size_t N, CFeatureList &feats )
+{
+	feats.clear();
+	feats.resize(N);
+	for (size_t i=0;i<N;i++)
+	{
+		CFeaturePtr ft = CFeature::Create();
+		ft->ID = i;
+		ft->x = mrpt::random::randomGenerator.drawUniform(0,640);
+		ft->y = mrpt::random::randomGenerator.drawUniform(0,480);
+		ft->descriptors.ORB.resize(32);
+		for (size_t k=0;k<32;k++)
+			ft->descriptors.ORB[k] = static_cast<uint8_t>( mrpt::random::randomGenerator.drawUniform32bit() );
+		feats[i] = ft;
+	}
+}
+
+// ------------------------------------------------------
+//	Benchmark: matchFeatures() with N x N ORB features
+// ------------------------------------------------------
+double feature_matching_test_ORB_matchFeatures( int N, int )
+{
+	mrpt::random::randomGenerator.randomize(1234);
+	CFeatureList  feats_L, feats_R;
+	generateRandomORBFeatures(N,feats_L);
+	generateRandomORBFeatures(N,feats_R);
+
+	TMatchingOptions	opt;
+	opt.matching_method = TMatchingOptions::mmDescriptorORB;
+	CMatchedFeatureList	matches;
+
+	CTicTac	 tictac;
+	matchFeatures( feats_L, feats_R, matches, opt );
+	return tictac.Tac();
+}
+
+// ------------------------------------------------------
+//	Benchmark: only the columnar snapshots of both lists taken by matchFeatures()
+// ------------------------------------------------------
+double feature_matching_test_ORB_snapshot( int N, int )
+{
+	mrpt::random::randomGenerator.randomize(1234);
+	CFeatureList  feats_L, feats_R;
+	generateRandomORBFeatures(N,feats_L);
+	generateRandomORBFeatures(N,feats_R);
+
+	CTicTac	 tictac;
+	const TFeatureListColumns cols_L(feats_L), cols_R(feats_R);
+	return tictac.Tac();
+}
+
+// ------------------------------------------------------
+//	Benchmark: the two nearest neighbors of all the features with the
+//   per-feature descriptors, as matchFeatures() did without snapshots
+// ------------------------------------------------------
+double feature_matching_test_ORB_per_feature( int N, int )
+{
+	mrpt::random::randomGenerator.randomize(1234);
+	CFeatureList  feats_L, feats_R;
+	generateRandomORBFeatures(N,feats_L);
+	generateRandomORBFeatures(N,feats_R);
+
+	std::vector<size_t> best(N);
+	CTicTac	 tictac;
+	for (int i=0;i<N;i++)
+	{
+		unsigned int dist1 = 0xFFFF, dist2 = 0xFFFF;
+		for (int j=0;j<N;j++)
+		{
+			const unsigned int d = feats_L[i]->descriptorORBDistanceTo(*feats_R[j]);
+			if (d<dist1) { dist2 = dist1; dist1 = d; best[i] = j; }
+			else if (d<dist2) dist2 = d;
+		}
+	}
+	return tictac.Tac();
+}
+
+// ------------------------------------------------------
+//	Benchmark: findDescriptorMatchesHamming() + ratio test & cross-check
+// ------------------------------------------------------
+double feature_matching_test_ORB_engine( int N, int num_threads )
+{
+	mrpt::random::randomGenerator.randomize(1234);
+	CFeatureList  feats_L, feats_R;
+	generateRandomORBFeatures(N,feats_L);
+	generateRandomORBFeatures(N,feats_R);
+
+	std::vector<uint8_t> descs_L, descs_R;
+	size_t len;
+	std::vector<TDescriptorMatchCandidate> m_LR, m_RL;
+	std::vector<std::pair<size_t,size_t> > pairings;
+
+	CTicTac	 tictac;
+	packDescriptorsORB(feats_L,descs_L,len);
+	packDescriptorsORB(feats_R,descs_R,len);
+	findDescriptorMatchesHamming(&descs_L[0],N,&descs_R[0],N,len,m_LR,num_threads);
+	findDescriptorMatchesHamming(&descs_R[0],N,&descs_L[0],N,len,m_RL,num_threads);
+	filterDescriptorMatches(m_LR,&m_RL,64,0.8f,pairings);
+	return tictac.Tac();
+}
+
 // ------------------------------------------------------
 // register_tests_feature_extraction
 // ------------------------------------------------------
@@ -265,4 +371,11 @@ void register_tests_feature_matching()
 	lstTests.push_back( TestData("feature_matching [640x480]: SURF", feature_matching_test_SURF, 640, 480 ) );
 	lstTests.push_back( TestData("feature_matching [640x480]: FAST + CC", feature_matching_test_FAST_CC, 640, 480 ) );
 	lstTests.push_back( TestData("feature_matching [640x480]: FAST + SAD", feature_matching_test_FAST_SAD, 640, 480 ) );
+	lstTests.push_back( TestData("feature_matching: ORB matchFeatures() 1000x1000", feature_matching_test_ORB_matchFeatures, 1000 ) );
+	lstTests.push_back( TestData("feature_matching: ORB matchFeatures() 5000x5000", feature_matching_test_ORB_matchFeatures, 5000 ) );
+	lstTests.push_back( TestData("feature_matching: ORB per-feature descriptors 2-NN 1000x1000", feature_matching_test_ORB_per_feature, 1000 ) );
+	lstTests.push_back( TestData("feature_matching: ORB columnar snapshots 1000+1000", feature_matching_test_ORB_snapshot, 1000 ) );
+	lstTests.push_back( TestData("feature_matching: ORB columnar snapshots 5000+5000", feature_matching_test_ORB_snapshot, 5000 ) );
+	lstTests.push_back( TestData("feature_matching: ORB engine + cross-check 5000x5000 (1 thread)", feature_matching_test_ORB_engine, 5000, 1 ) );
+	lstTests.push_back( TestData("feature_matching: ORB engine + cross-check 5000x5000 (all threads)", feature_matching_test_ORB_engine, 5000, 0 ) );
 }
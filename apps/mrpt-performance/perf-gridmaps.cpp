@@ -87,7 +87,8 @@ double grid_test_4(int a1, int a2)
 
 	float	p=0.57f;
 	COccupancyGridMap2D::cellType  logodd_obs = COccupancyGridMap2D::p2l( p );
-	COccupancyGridMap2D::cellType  *theMapArray = gridMap.getRow(0);
+	std::vector<COccupancyGridMap2D::cellType> cells(gridMap.getSizeX()*gridMap.getSizeY(), COccupancyGridMap2D::p2l(0.5f));
+	COccupancyGridMap2D::cellType  *theMapArray = &cells[0];
 	unsigned  theMapSize_x = gridMap.getSizeX();
 	COccupancyGridMap2D::cellType   logodd_thres_occupied = COccupancyGridMap2D::OCCGRID_CELLTYPE_MIN+logodd_obs;
 
@@ -185,6 +185,29 @@ double image_halfsample_smooth(int w, int h)
 }
 
 
+// Creates, fills and destroys one RGB image per "frame", as grabbing loops do, with the given max. size of the pool of image buffers:
+template <int POOL_SIZE>
+double image_create_destroy(int w, int h)
+{
+	const size_t old_pool_size = CImage::getImageBuffersPoolMaxSize();
+	CImage::setImageBuffersPoolMaxSize(POOL_SIZE);
+
+	CTicTac	 tictac;
+
+	const size_t N = 300;
+
+	tictac.Tic();
+	for (size_t i=0;i<N;i++)
+	{
+		CImage  img(w,h,CH_RGB);
+		memset(img.get_unsafe(0,0), i & 0xFF, img.getRowStride()*h);
+	}
+	const double R = tictac.Tac()/N;
+
+	CImage::setImageBuffersPoolMaxSize(old_pool_size);
+	return R;
+}
+
 double image_rgb2gray_8u(int w, int h)
 {
 	CImage  img(w,h,CH_RGB), img2;
@@ -249,6 +272,24 @@ double image_buildPyramid(int N, int NOCTS)
 	return R;
 }
 
+// As image_buildPyramid(), but with a new pyramid object (hence, new image buffers) for each frame:
+template <bool DO_SMOOTH, bool CONVERT_GRAY>
+double image_buildPyramid_new_object(int N, int NOCTS)
+{
+	CImage  img;
+	getTestImage(0,img);
+
+	CTicTac	 tictac;
+	tictac.Tic();
+	for (int i=0;i<N;i++)
+	{
+		mrpt::vision::CImagePyramid pyr;
+		pyr.buildPyramid(img,NOCTS,DO_SMOOTH,CONVERT_GRAY);
+	}
+	double R = tictac.Tac()/N;
+	return R;
+}
+
 
 const char* EXAMPLE_STEREO_CALIB =
     "[CAMERA_PARAMS_LEFT]\n"
@@ -297,7 +338,7 @@ double stereoimage_rectify_prepare_map(int, int)
 }
 
 template <int IMG_CHANNELS,int w, int h, int w2, int h2>
-double stereoimage_rectify(int, int)
+double stereoimage_rectify(int num_threads, int)
 {
 	const CImage  imgL(w,h,IMG_CHANNELS), imgR(w,h,IMG_CHANNELS);
 	CImage  imgL2, imgR2;
@@ -309,6 +350,7 @@ double stereoimage_rectify(int, int)
 	mrpt::vision::CStereoRectifyMap  rectify_map;
 	rectify_map.enableResizeOutput((w2!=w || h2!=h), w2,h2);
 	rectify_map.setFromCamParams(params);
+	rectify_map.setNumThreads(num_threads);
 
 	CTicTac	 tictac;
 	const size_t N = 20;
@@ -355,6 +397,11 @@ void register_tests_image()
 	lstTests.push_back( TestData("images: Gauss filter (800x600)",image_test_2,  800,600) );
 	lstTests.push_back( TestData("images: Gauss filter (1024x768)",image_test_2,  1024,768) );
 
+	lstTests.push_back( TestData("images: create & fill RGB (1280x960), no buffers pool",image_create_destroy<0>,  1280,960) );
+	lstTests.push_back( TestData("images: create & fill RGB (1280x960), with buffers pool",image_create_destroy<8>,  1280,960) );
+	lstTests.push_back( TestData("images: create & fill RGB (2592x1944), no buffers pool",image_create_destroy<0>,  2592,1944) );
+	lstTests.push_back( TestData("images: create & fill RGB (2592x1944), with buffers pool",image_create_destroy<8>,  2592,1944) );
+
 	lstTests.push_back( TestData("images: Half sample GRAY (160x120)",image_halfsample<CH_GRAY>,  160,120) );
 	lstTests.push_back( TestData("images: Half sample GRAY (320x240)",image_halfsample<CH_GRAY>,  320,240) );
 	lstTests.push_back( TestData("images: Half sample GRAY (640x480)",image_halfsample<CH_GRAY>,  640,480) );
@@ -419,6 +466,9 @@ void register_tests_image()
 	lstTests.push_back( TestData("images: buildPyramid 640x480,8 levs,no smooth,   gray",    image_buildPyramid<false,true>, 500, 8) );
 	lstTests.push_back( TestData("images: buildPyramid 640x480,8 levs,   smooth,   gray",       image_buildPyramid<true,true>, 500, 8) );
 
+	lstTests.push_back( TestData("images: buildPyramid 640x480,4 levs,   smooth,no gray (new buffers each frame)", image_buildPyramid_new_object<true,false>, 500, 4) );
+	lstTests.push_back( TestData("images: buildPyramid 640x480,4 levs,   smooth,   gray (new buffers each frame)", image_buildPyramid_new_object<true,true>, 500, 4) );
+
 
 	lstTests.push_back( TestData("stereo: prepare rectify map 640x480 RGB",  stereoimage_rectify_prepare_map<CH_RGB,640,480,640,480>) );
 	lstTests.push_back( TestData("stereo: prepare rectify map 800x600 RGB", stereoimage_rectify_prepare_map<CH_RGB,800,600,800,600>) );
@@ -438,6 +488,11 @@ void register_tests_image()
 	lstTests.push_back( TestData("stereo: rectify 1024x768->800x600 GRAY", stereoimage_rectify<CH_GRAY,1024,768,800,600>) );
 	lstTests.push_back( TestData("stereo: rectify 1024x768->640x480 GRAY", stereoimage_rectify<CH_GRAY,1024,768,640,480>) );
 
+	lstTests.push_back( TestData("stereo: rectify 1280x960 GRAY (1 thread)", stereoimage_rectify<CH_GRAY,1280,960,1280,960>, 1) );
+	lstTests.push_back( TestData("stereo: rectify 1280x960 GRAY (all threads)", stereoimage_rectify<CH_GRAY,1280,960,1280,960>, 0) );
+	lstTests.push_back( TestData("stereo: rectify 1280x960 RGB (1 thread)", stereoimage_rectify<CH_RGB,1280,960,1280,960>, 1) );
+	lstTests.push_back( TestData("stereo: rectify 1280x960 RGB (all threads)", stereoimage_rectify<CH_RGB,1280,960,1280,960>, 0) );
+
 }
 
 
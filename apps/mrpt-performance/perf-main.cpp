@@ -133,6 +133,7 @@ int main(int argc, char **argv)
 		// Start tests:
 		// --------------------
 		register_tests_icpslam();
+		register_tests_rbpf();
 		register_tests_poses();
 		register_tests_matrices();
 		register_tests_grids();
@@ -147,6 +148,8 @@ int main(int argc, char **argv)
 		register_tests_graphslam();
 		register_tests_CObservation3DRangeScan();
 		register_tests_atan2lut();
+		register_tests_nav();
+		register_tests_data_association();
 
 		if (doLog)
 		{
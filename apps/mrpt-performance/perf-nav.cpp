@@ -0,0 +1,122 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/nav/planners/PlannerRRT_SE2_TPS.h>
+#include <mrpt/maps/CSimpleMap.h>
+#include <mrpt/utils/CFileGZInputStream.h>
+#include <mrpt/utils/CConfigFile.h>
+#include <mrpt/system/filesystem.h>
+#include <mrpt/random.h>
+
+#include "common.h"
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace mrpt::nav;
+using namespace mrpt::random;
+using namespace std;
+
+
+// ------------------------------------------------------
+//				Benchmark: path planning
+// ------------------------------------------------------
+
+// Nearest node queries in a tree with "nNodes" nodes uniformly spread over a 100x100m area.
+double tree_nearest_node(int nNodes, int cell_size_cm)
+{
+	randomGenerator.randomize(1234);
+
+	TMoveTreeSE2_TP tree;
+	tree.setSpatialIndexCellSize(cell_size_cm*0.01);
+	for (int i=0;i<nNodes;i++)
+	{
+		const mrpt::math::TPose2D p(randomGenerator.drawUniform(-50.0,50.0),randomGenerator.drawUniform(-50.0,50.0),randomGenerator.drawUniform(-M_PI,M_PI));
+		if (i==0)
+		     tree.insertNode(0, TNodeSE2_TP(p));
+		else tree.insertNodeAndEdge(0,i, TNodeSE2_TP(p), TMoveEdgeSE2_TP(0,p));
+	}
+
+	const PoseDistanceMetric<TNodeSE2> metric;
+	const size_t N = 1000;
+	double dummy_sum = 0;
+	CTicTac tictac;
+	for (size_t i=0;i<N;i++)
+	{
+		const TNodeSE2 query( mrpt::math::TPose2D(randomGenerator.drawUniform(-50.0,50.0),randomGenerator.drawUniform(-50.0,50.0),0) );
+		dummy_sum+=tree.getNearestNode(query,metric);
+	}
+	const double t = tictac.Tac()/N;
+	dummy_do_nothing_with_string(mrpt::format("%f",dummy_sum));
+	return t;
+}
+
+// Full RRT planning on the Malaga CS building map, until the first solution is found.
+double planner_rrt_solve(int cell_size_cm, int )
+{
+#ifdef MRPT_DATASET_DIR
+	const string map_file = MRPT_DATASET_DIR "/malaga-cs-fac-building.simplemap.gz";
+	const string cfg_file = MRPT_DATASET_DIR "/../config_files/navigation-ptgs/ptrrt_config_example1.ini";
+	if (!mrpt::system::fileExists(map_file) || !mrpt::system::fileExists(cfg_file))
+		throw std::runtime_error("Dataset files not found!");
+
+	mrpt::maps::CSimpleMap simplemap;
+	CFileGZInputStream(map_file) >> simplemap;
+
+	PlannerRRT_SE2_TPS planner;
+	planner.loadConfig( CConfigFile(cfg_file) );
+	planner.params.maxLength = 2.0;
+	planner.params.minDistanceBetweenNewNodes = 0.10;
+	planner.params.minAngBetweenNewNodes = DEG2RAD(20);
+	planner.params.goalBias = 0.05;
+	planner.params.ptg_verbose = false;
+	planner.params.ptg_cache_files_directory = mrpt::system::extractFileDirectory( mrpt::system::getTempFileName() );
+
+	planner.end_criteria.acceptedDistToTarget = 0.25;
+	planner.end_criteria.acceptedAngToTarget  = DEG2RAD(180);
+	planner.end_criteria.maxComputationTime = 60.0;
+	planner.end_criteria.minComputationTime = 0;
+
+	planner.initialize();
+
+	PlannerRRT_SE2_TPS::TPlannerInput planner_input;
+	planner_input.start_pose = mrpt::math::TPose2D(0,0,0);
+	planner_input.goal_pose  = mrpt::math::TPose2D(-20,-30,0);
+	planner_input.obstacles_points.loadFromSimpleMap( simplemap );
+	mrpt::math::TPoint3D bbox_min,bbox_max;
+	planner_input.obstacles_points.boundingBox(bbox_min,bbox_max);
+	planner_input.world_bbox_min = mrpt::math::TPoint2D(bbox_min.x,bbox_min.y);
+	planner_input.world_bbox_max = mrpt::math::TPoint2D(bbox_max.x,bbox_max.y);
+
+	randomGenerator.randomize(1234);
+
+	PlannerRRT_SE2_TPS::TPlannerResult planner_result;
+	planner_result.move_tree.setSpatialIndexCellSize(cell_size_cm*0.01);
+
+	CTicTac tictac;
+	planner.solve( planner_input, planner_result);
+	return tictac.Tac();
+#else
+	throw std::runtime_error("MRPT_DATASET_DIR not defined!");
+#endif
+}
+
+// ------------------------------------------------------
+// register_tests_nav
+// ------------------------------------------------------
+void register_tests_nav()
+{
+	lstTests.push_back( TestData("TMoveTree: getNearestNode (1e3 nodes, linear search)", tree_nearest_node, 1000, 0) );
+	lstTests.push_back( TestData("TMoveTree: getNearestNode (1e3 nodes, 1m index)", tree_nearest_node, 1000, 100) );
+	lstTests.push_back( TestData("TMoveTree: getNearestNode (1e4 nodes, linear search)", tree_nearest_node, 10000, 0) );
+	lstTests.push_back( TestData("TMoveTree: getNearestNode (1e4 nodes, 1m index)", tree_nearest_node, 10000, 100) );
+	lstTests.push_back( TestData("TMoveTree: getNearestNode (1e5 nodes, 1m index)", tree_nearest_node, 100000, 100) );
+
+	lstTests.push_back( TestData("PlannerRRT_SE2_TPS: solve() Malaga map (linear search)", planner_rrt_solve, 0) );
+	lstTests.push_back( TestData("PlannerRRT_SE2_TPS: solve() Malaga map (1m index)", planner_rrt_solve, 100) );
+}
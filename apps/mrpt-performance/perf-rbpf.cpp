@@ -0,0 +1,122 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/utils.h>
+#include <mrpt/random.h>
+#include <mrpt/system/filesystem.h>
+#include <mrpt/slam/CMetricMapBuilderRBPF.h>
+#include <mrpt/maps/CMultiMetricMap.h>
+#include <mrpt/obs/CRawlog.h>
+
+#include "common.h"
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace mrpt::slam;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::bayes;
+using namespace mrpt::random;
+using namespace std;
+
+
+// ------------------------------------------------------
+//	Benchmark: A whole RBPF-SLAM run with a grid map
+//   a1: 0=pfOptimalProposal, 1=pfAuxiliaryPFOptimal
+//   a2: Number of threads (0=one per core)
+// ------------------------------------------------------
+double rbpf_test_1(int a1, int a2)
+{
+#ifdef MRPT_DATASET_DIR
+	const string rawlog_file = MRPT_DATASET_DIR  "/2006-01ENE-21-SENA_Telecom Faculty_one_loop_only.rawlog";
+	if (!mrpt::system::fileExists(rawlog_file))
+		return 1;
+
+	randomGenerator.randomize(1234);
+
+	CTicTac	 tictac;
+
+	int			step = 0;
+	size_t		rawlogEntry = 0;
+	CFileGZInputStream	rawlogFile( rawlog_file );
+
+	CMetricMapBuilderRBPF::TConstructionOptions  rbpfOptions;
+	{
+		COccupancyGridMap2D::TMapDefinition def;
+		def.resolution = 0.05;
+		def.insertionOpts.maxOccupancyUpdateCertainty = 0.8;
+		def.likelihoodOpts.likelihoodMethod = COccupancyGridMap2D::lmLikelihoodField_Thrun;
+		def.likelihoodOpts.LF_decimation = 5;
+		rbpfOptions.mapsInitializers.push_back( def );
+	}
+
+	rbpfOptions.insertionLinDistance = 1.0;
+	rbpfOptions.insertionAngDistance = DEG2RAD(40);
+	rbpfOptions.localizeLinDistance  = 1.0;
+	rbpfOptions.localizeAngDistance  = DEG2RAD(40);
+
+	rbpfOptions.PF_options.sampleSize = 40;
+	rbpfOptions.PF_options.PF_algorithm = a1==0 ? CParticleFilter::pfOptimalProposal : CParticleFilter::pfAuxiliaryPFOptimal;
+	rbpfOptions.PF_options.pfAuxFilterOptimal_MaximumSearchSamples = 250;
+
+	rbpfOptions.predictionOptions.pfOptimalProposal_mapSelection = 0;
+	rbpfOptions.predictionOptions.num_threads = a2;
+
+	// ---------------------------------
+	//		Constructor
+	// ---------------------------------
+	CMetricMapBuilderRBPF mapBuilder( rbpfOptions );
+
+	// Start with an empty map:
+	mapBuilder.initialize( CSimpleMap() );
+
+	mapBuilder.setVerbosityLevel( mrpt::utils::LVL_ERROR);
+	mapBuilder.options.enableMapUpdating		= true;
+
+	// ----------------------------------------------------------
+	//						Map Building
+	// ----------------------------------------------------------
+	CActionCollectionPtr	action;
+	CSensoryFramePtr		observations;
+
+	for (;;)
+	{
+		// Load action/observation pair from the rawlog:
+		// --------------------------------------------------
+		if (! CRawlog::readActionObservationPair( rawlogFile, action, observations, rawlogEntry) )
+			break; // file EOF
+
+		// Execute:
+		mapBuilder.processActionObservation( *action, *observations );
+
+		step++;
+
+		// Free memory:
+		action.clear_unique();
+		observations.clear_unique();
+	}
+
+	if (!step) step++;
+
+	return tictac.Tac()/step;
+#else
+	return 1;
+#endif
+}
+
+// ------------------------------------------------------
+// register_tests_rbpf
+// ------------------------------------------------------
+void register_tests_rbpf()
+{
+	lstTests.push_back( TestData("rbpf-slam (grid, optimal proposal, 1 thread): Run with sample dataset",rbpf_test_1,  0, 1) );
+	lstTests.push_back( TestData("rbpf-slam (grid, optimal proposal, all cores): Run with sample dataset",rbpf_test_1,  0, 0) );
+	lstTests.push_back( TestData("rbpf-slam (grid, APF optimal sampling, 1 thread): Run with sample dataset",rbpf_test_1,  1, 1) );
+	lstTests.push_back( TestData("rbpf-slam (grid, APF optimal sampling, all cores): Run with sample dataset",rbpf_test_1,  1, 0) );
+}
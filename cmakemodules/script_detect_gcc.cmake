@@ -2,7 +2,7 @@
 # Detect GNU version:
 # ----------------------------------------------------------------------------
 IF(CMAKE_COMPILER_IS_GNUCXX)
-	execute_process(COMMAND ${CMAKE_CXX_COMPILER} -dumpversion
+	execute_process(COMMAND ${CMAKE_CXX_COMPILER} -dumpfullversion
 		          OUTPUT_VARIABLE CMAKE_MRPT_GCC_VERSION_FULL
 		          OUTPUT_STRIP_TRAILING_WHITESPACE)
 
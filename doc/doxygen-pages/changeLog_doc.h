@@ -43,8 +43,20 @@
 				- mrpt::math::RANSAC_Template::execute()
 				- mrpt::math::CLevenbergMarquardtTempl::execute()
 			- Deleted methods in Eigen-extensions: leftDivideSquare(), rightDivideSquare()
+			- mrpt::utils::CImage::scaleHalf(), mrpt::utils::CImage::scaleHalfSmooth(), mrpt::utils::CImage::grayscale() and the copy operator reuse the buffer of the output image if it already has the right size and format. New SSSE3-optimized 2x2 smoothing for RGB images in mrpt::utils::CImage::scaleHalfSmooth().
+			- mrpt::utils::CImage keeps the pixel buffers of destroyed images in a global, thread-safe pool and reuses them for new images of the same size and format, avoiding per-frame memory allocations in grabbing and processing loops. The pool is enabled by default and keeps up to 8 buffers of any size, which remain allocated after the program stops using images of that size (e.g. 48 MB for 1920x1080 RGB images). Use mrpt::utils::CImage::setImageBuffersPoolMaxSize() to change the limit, or 0 to disable the pool.
+			- mrpt::system::CGenericMemoryPool::setMemoryPoolMaxSize() frees the entries above the new limit, a limit of 0 disables the pool, and the new mrpt::system::CGenericMemoryPool::getMemoryPoolSize() returns the number of entries (also mrpt::utils::CImage::getImageBuffersPoolSize()).
+			- New class mrpt::utils::CCopyOnWriteTiledGrid: 2D grid stored as reference-counted tiles shared between copies until written.
+			- New mrpt::poses::CPoseRandomSampler::drawSample() overloads drawing from a user-supplied mrpt::random::CRandomGenerator, so several threads can sample concurrently.
+			- New method mrpt::poses::CPoseRandomSampler::drawSamples() to draw many 2D samples at once into separate arrays of coordinates.
+			- New class mrpt::poses::CPosePDFSparseGrid: a 2D pose PDF on a sparse grid with adaptive resolution, refined coarse-to-fine only where the probability is high. Normalization, mean/covariance and sampling scale with the number of occupied cells instead of the volume; so do the marginals, except where the cells are coarser than the requested resolution.
 		- \ref mrpt_bayes_grp
 			-  [API change] `verbose` is no longer a field of mrpt::bayes::CParticleFilter::TParticleFilterOptions. Use the setVerbosityLevel() method of the CParticleFilter class itself.
+			- mrpt::bayes::CParticleFilterCapable::computeResampling() runs in O(M+N) for all the methods, with no sorting nor temporary arrays of thresholds, and supports a number of output particles different than the input one in all the methods.
+			- mrpt::bayes::CParticleFilterCapable::fastDrawSample() finds the particle with a binary search for a dynamic number of particles, and new mrpt::bayes::CParticleFilterCapable::fastDrawSamples() draws many samples at once.
+			- New method mrpt::bayes::kfSEIF in mrpt::bayes::CKalmanFilterCapable: a Sparse Extended Information Filter with constant-time updates for landmark-based SLAM, bounded by the new option `SEIF_max_active_landmarks`. Its vehicle and landmark covariances are recovered from Markov blankets, so they are overconfident; the full covariance (CKalmanFilterCapable::getStateCovariance()) is exact but O(N^3).
+			- mrpt::bayes::CKalmanFilterCapable updates the covariance in kfEKFNaive and kfIKFFull with the non-zero blocks of the observation Jacobian only, by square tiles, instead of building the full Jacobian. The predictions, their Jacobians, the innovation matrix and the covariance update can run in parallel for large maps: see the new option mrpt::bayes::TKF_options::num_threads (default: 1).
+			- New method mrpt::bayes::CRejectionSamplingCapable::rejectionSamplingParallel(), which draws and evaluates blocks of candidates in several threads, each with its own random generator, and stops as soon as enough samples are accepted. mrpt::slam::CRejectionSamplingRangeOnlyLocalization supports it.
 		- \ref mrpt_gui_grp
 			- mrpt::gui::CMyGLCanvasBase is now derived from mrpt::opengl::CTextMessageCapable so they can draw text labels
 			- New class mrpt::gui::CDisplayWindow3DLocker for exception-safe 3D scene lock in 3D windows.
@@ -55,6 +67,7 @@
 		- \ref mrpt_maps_grp
 			- mrpt::maps::COccupancyGridMap2D::loadFromBitmapFile() correct description of `yCentralPixel` parameter.
 			- mrpt::maps::CPointsMap `liblas` import/export methods are now in a separate header. See \ref mrpt_maps_liblas_grp and \ref dep-liblas
+			- mrpt::maps::CBeaconMap evaluates the likelihood of a range observation for many robot poses at once (new method mrpt::maps::CMetricMap::computeObservationLikelihoodForPoses()), with the beacon modes flattened into contiguous arrays and, optionally, several threads (new option `num_threads` in mrpt::maps::CBeaconMap::TLikelihoodOptions). The ranges to different Gaussian or SOG beacons are fused in parallel with the new option `num_threads` in mrpt::maps::CBeaconMap::TInsertionOptions.
 		- \ref mrpt_obs_grp
 			- [ABI change] mrpt::obs::CObservation3DRangeScan:
 				- Now uses more SSE2 optimized code
@@ -66,6 +79,11 @@
 			- [ABI change] mrpt::opengl::CAxis now has many new options exposed to configure its look.
 		- \ref mrpt_slam_grp
 			- [API change] mrpt::slam::CMetricMapBuilder::TOptions does not have a `verbose` field anymore. It's supersedded now by the verbosity level of the CMetricMapBuilder class itself.
+			- KLD-sampling in mrpt::slam::PF_implementation keeps its bins in a reusable hash table (mrpt::slam::detail::TKLDBinsHashSet) instead of a `std::set`, and the standard proposal draws the particles to propagate in batches.
+			- mrpt::slam::CMonteCarloLocalization2D moves all its particles at once through contiguous arrays of coordinates in the standard proposal with a fixed sample size (new hook mrpt::slam::PF_implementation::PF_SLAM_implementation_moveAllParticles()), 2-3x faster than one particle at a time.
+			- mrpt::slam::CMonteCarloLocalization2D evaluates the observation likelihood for all its particles at once in the standard proposal (new hook mrpt::slam::PF_implementation::PF_SLAM_computeObservationLikelihoodForAllParticles()) when all the particles share one map.
+			- mrpt::slam::CRangeBearingKFSLAM and mrpt::slam::CRangeBearingKFSLAM2D support the new Kalman filter method mrpt::bayes::kfSEIF.
+			- mrpt::slam::data_association_full_covariance() and mrpt::slam::data_association_independent_predictions(): the KD-tree is now used as a conservative Euclidean gate (a radius search) instead of sorting all the predictions for each observation, the Cholesky factorization of each prediction covariance is computed only once, and JCBB extends the Cholesky factorization of the joint covariance incrementally instead of inverting it at each leaf. New optional argument `num_threads` to evaluate the individual compatibilities and explore the JCBB tree in parallel.
 		- \ref mrpt_hwdrivers_grp
 			- mrpt::hwdrivers::CGenericSensor: external image format is now `png` by default instead of `jpg` to avoid losses.
 			- [ABI change] mrpt::hwdrivers::COpenNI2Generic:
@@ -78,6 +96,9 @@
 			- mrpt::hwdrivers::CHokuyoURG no longer as a "verbose" field. It's superseded now by the COutputLogger interface.
 		- \ref mrpt_maps_grp
 			- mrpt::maps::CMultiMetricMapPDF added method CMultiMetricMapPDF::prediction_and_update_pfAuxiliaryPFStandard().
+			- mrpt::maps::COccupancyGridMap2D stores its cells in copy-on-write tiles (mrpt::utils::CCopyOnWriteTiledGrid), so copying a grid (e.g. duplicating RBPF particles while resampling) only copies one pointer per tile, and only the modified tiles are duplicated afterwards.
+			- [API change] mrpt::maps::COccupancyGridMap2D::getRow() copies a row into a user buffer instead of returning a pointer, new COccupancyGridMap2D::setRow(), and COccupancyGridMap2D::getRawMap() returns the tiled grid.
+			- mrpt::maps::CMultiMetricMapPDF can run its per-particle stages in parallel (proposals, weight updates, the APF look-ahead and rejection sampling, and the insertion of observations into the particle maps), with one random generator per thread seeded from the global one. See the new option mrpt::maps::CMultiMetricMapPDF::TPredictionParams::num_threads (default: 1). Beacon maps are always updated from one thread.
 		- \ref mrpt_nav_grp
 			- New mrpt::nav::CWaypointsNavigator interface for waypoint list-based navigation.
 			- [ABI & API change] PTG classes refactored (see new virtual base class mrpt::nav::CParameterizedTrajectoryGenerator and its derived classes):
@@ -87,6 +108,24 @@
 				- Parameters are no longer passed via a mrpt::utils::TParameters class, but via a mrpt::utils::CConfigFileBase which makes parameter passing to PTGs much more maintainable and consistent.
 				- PTGs now have a score_priority field to manually set hints about preferences for path planning.
 				- PTGs are now mrpt::utils::CLoadableOptions classes
+			- mrpt::nav::CPTG_DiffDrive_CollisionGridBased: collision grid cache files use a new flat binary format, validated with a hash of the PTG trajectories, robot shape and grid geometry. The grid is built in parallel if no valid cache file is found.
+			- mrpt::nav::TMoveTree::getNearestNode() uses a grid-based spatial index of the tree nodes instead of a linear search. See mrpt::nav::TMoveTree::setSpatialIndexCellSize()
+		- \ref mrpt_vision_grp
+			- New brute-force descriptor matching engine working on contiguous descriptor buffers, with `popcnt`-based Hamming distances, vectorized L2 distances, ratio test, cross-check and multithreading: mrpt::vision::findDescriptorMatchesHamming(), mrpt::vision::findDescriptorMatchesL2(), mrpt::vision::filterDescriptorMatches()
+			- mrpt::vision::matchFeatures() uses the new engine for SIFT, SURF and ORB descriptors.
+			- Faster descriptor matching in mrpt::vision::matchFeatures() and the descriptor KD-tree adaptors, which now read coordinates and descriptors from a contiguous copy of each list taken once per call (new helper mrpt::vision::TFeatureListColumns) instead of going through each mrpt::vision::CFeature. The features themselves are stored as before.
+			- Fix mrpt::vision::TSURFDescriptorsKDTreeIndex using SIFT descriptors instead of SURF ones.
+			- New tile-based, multithreaded FASTER detection: mrpt::vision::CFeatureExtraction::detectFeatures_SSE2_FASTER_tiled(), for single images and image pyramids, with per-tile adaptive thresholds, non-maximal suppression and per-tile feature limits. Enabled in mrpt::vision::CFeatureExtraction for FASTER detectors with the new option `FASTOptions.tiled_detection`.
+			- Fix FASTER detectors assuming the image row stride to be equal to the image width.
+			- mrpt::vision::CFeatureTracker_KL builds each LK pyramid once with cv::buildOpticalFlowPyramid(), reuses the one of the previous frame when possible, and splits features among threads (requires OpenCV>=2.4). See the new parameters `LK_cache_pyramids` and `LK_num_threads`.
+			- mrpt::vision::bundle_adj_full(): multithreaded evaluation of residuals and Jacobians, new optional block-Jacobi preconditioned conjugate gradient solver for the reduced camera system (`use_pcg`), linear-time back substitution of landmarks and per-iteration timing in verbose mode.
+			- mrpt::vision::CStereoRectifyMap and mrpt::vision::CUndistortMap remap 8-bit images with a native fixed-point, SSE2-optimized and multithreaded implementation, rectifying both stereo images concurrently. See their new `setNumThreads()` methods.
+			- mrpt::vision::CImagePyramid reuses the buffers of all octaves when built repeatedly for images of the same size and format.
+			- mrpt::vision::CUndistortMap and mrpt::vision::CStereoRectifyMap take their output images from the pool of image buffers.
+			- mrpt::vision::CDifodo: multithreaded per-pixel stages (pyramid, warping, derivatives, weights) over blocks of image columns, normal equations of the solver accumulated without building the full system matrix, and per-stage timings in `CDifodo::stage_times`. See the new `CDifodo::num_threads`. The app DifOdometry-Datasets gets a `--benchmark` option and a `num_threads` config parameter.
+			- New bag-of-binary-words place recognition: mrpt::vision::CBinaryVocabulary (vocabulary tree of ORB words, trained by hierarchical k-majority clustering) and mrpt::vision::CBoWDatabase (incremental database with an inverted index).
+		- \ref mrpt_hmtslam_grp
+			- New appearance-based loop-closure detector mrpt::hmtslam::CTopLCDetector_BoW (`TLC_detectors=bow`), which also proposes candidate areas through the new mrpt::hmtslam::CTopLCDetectorBase::proposeLoopClosureCandidates().
 	- Changes in build system:
 		- [Windows only] `DLL`s/`LIB`s now have the signature `lib-${name}${2-digits-version}${compiler-name}_{x32|x64}.{dll/lib}`, allowing several MRPT versions to coexist in the system PATH.
 		- [Visual Studio only] There are no longer `pragma comment(lib...)` in any MRPT header, so it is the user responsibility to correctly tell user projects to link against MRPT libraries.
@@ -103,8 +142,14 @@
 		- Fix PTG look-up-tables will always fail to load from cache files and will re-generate (Closes [GitHub #243](https://github.com/MRPT/mrpt/issues/243))
 		- Fix mrpt::maps::COccupancyGridMap2D::simulateScanRay() fails to mark out-of-range ranges as "invalid".
 		- Fix mrpt::utils::CMemoryStream::Clear() after assigning read-only memory blocks.
+		- Fix build of mrpt::vision::CDifodo with recent Eigen versions (floating-point matrix indices).
 		- Fix point into polygon checking not working for concave polygons. Now, mrpt::math::TPolygon2D::contains() uses the winding number test which works for any geometry.
 		- Fix inconsistent internal state after externalizing mrpt::obs::CObservation3DRangeScan
+		- Fix mrpt::maps::COccupancyGridMap2D::computeClearance() (and hence buildVoronoiDiagram()) reading wrong cells in non-square grids.
+		- Fix uninitialized internal state of the Gaussian generator in mrpt::random::CRandomGenerator objects created with a seed, and mrpt::random::CRandomGenerator::randomize() keeping a Gaussian sample of the previous seed.
+		- Fix the auxiliary particle filter with standard proposal (pfAuxiliaryPFStandard) in mrpt::slam::PF_implementation using the likelihoods of the optimal proposal when evaluating particles, and the adaptive sample size variants recording the wrong source particle when an unlikely particle was replaced.
+		- Fix residual, stratified and systematic resampling in mrpt::bayes::CParticleFilterCapable::computeResampling() reading out of bounds when asked for more output particles than input ones.
+		- Fix mrpt::poses::CPoseRandomSampler::drawSample() always returning the first particle of a mrpt::poses::CPosePDFParticles with unnormalized weights (e.g. the samples of Thrun's odometry model, all with log_w=0), instead of drawing them according to their weights as mrpt::poses::CPoseRandomSampler::drawSamples() does.
 
 <hr>
 <a name="1.4.0">
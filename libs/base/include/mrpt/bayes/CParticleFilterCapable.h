@@ -28,9 +28,6 @@ namespace bayes
 	{
 		friend class CParticleFilter;
 
-	private:
-		static const unsigned PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS;
-
 	public:
 
 		CParticleFilterCapable() : m_fastDrawAuxiliary()
@@ -80,8 +77,8 @@ namespace bayes
 		  *			the random indexes generated according to the selected resample scheme in TParticleFilterOptions. Those indexes are
 		  *			read sequentially by subsequent calls to fastDrawSample.
 		  *		- <b>DYNAMIC SAMPLE SIZE=YES</b>: Then:
-		  *			- If TParticleFilterOptions.resamplingMethod = prMultinomial, the internal buffers will be filled out (m_fastDrawAuxiliary.CDF, CDF_indexes & PDF) and
-		  *				then fastDrawSample can be called an arbitrary number of times to generate random indexes.
+		  *			- If TParticleFilterOptions.resamplingMethod = prMultinomial, the internal buffers will be filled out (m_fastDrawAuxiliary.PDF and its cumulative sum, m_fastDrawAuxiliary.CDF) and
+		  *				then fastDrawSample can be called an arbitrary number of times to generate random indexes, each in O(log M) by a binary search in the CDF.
 		  *			- For the rest of resampling algorithms, an exception will be raised since they are not appropriate for a dynamic (unknown in advance) number of particles.
 		  *
 		  * The function pointed by "partEvaluator" should take into account the particle filter algorithm selected in "m_PFAlgorithm".
@@ -110,6 +107,12 @@ namespace bayes
 		  */
 		size_t  fastDrawSample( const bayes::CParticleFilter::TParticleFilterOptions &PF_options  ) const;
 
+		/** Draws \a n random samples at once, as calling fastDrawSample() \a n times, but in O(n+M) time (instead of O(n log M)) for a dynamic number of particles.
+		  *  In that case the indices are returned in ascending order.
+		  * \sa prepareFastDrawSample, fastDrawSample
+		  */
+		void  fastDrawSamples( const bayes::CParticleFilter::TParticleFilterOptions &PF_options, const size_t n, std::vector<size_t> &out_indexes ) const;
+
 		/** Access to i'th particle (logarithm) weight, where first one is index 0.
 		 */
 		virtual double  getW(size_t i) const = 0;
@@ -158,8 +161,9 @@ namespace bayes
 		void  performResampling( const bayes::CParticleFilter::TParticleFilterOptions &PF_options,size_t out_particle_count = 0 );
 
 		/** A static method to perform the computation of the samples resulting from resampling a given set of particles, given their logarithmic weights, and a resampling method.
-		  * It returns the sequence of indexes from the resampling. The number of output samples is the same than the input population.
+		  * It returns the sequence of indexes from the resampling, in ascending order. The number of output samples is the same than the input population.
 		  *  This generic method just computes these indexes, to actually perform a resampling in a particle filter object, call performResampling
+		  *  All the methods take O(M+N) time, with M and N the number of input and output particles.
 		  * \param[in] out_particle_count The desired number of output particles after resampling; 0 means don't modify the current number.
 		  * \sa performResampling
 		  */
@@ -214,15 +218,13 @@ namespace bayes
 		{
 			TFastDrawAuxVars() :
 				CDF(),
-				CDF_indexes(),
 				PDF(),
 				alreadyDrawnIndexes(),
 				alreadyDrawnNextOne(0)
 			{ }
 
-			std::vector<double>	CDF;
-			vector_uint		CDF_indexes;
-			std::vector<double>	PDF;
+			std::vector<double>	CDF;	//!< Cumulative sum of PDF (the last one is exactly 1)
+			std::vector<double>	PDF;	//!< Normalized probability of drawing each particle
 
 			vector_uint		alreadyDrawnIndexes;
 			size_t			alreadyDrawnNextOne;
@@ -24,6 +24,7 @@
 #include <mrpt/poses/CPointPDF.h>
 #include <mrpt/poses/CPose3DQuat.h>
 #include <mrpt/poses/CPosePDFGrid.h>
+#include <mrpt/poses/CPosePDFSparseGrid.h>
 #include <mrpt/poses/CPointPDFGaussian.h>
 #include <mrpt/poses/CPoint2DPDFGaussian.h>
 #include <mrpt/poses/CPose3DPDF.h>
@@ -24,7 +24,7 @@ namespace poses
 	 *    function (PDF) of a 2D pose (x,y,phi).
 	 *   This class implements that PDF using a 3D grid.
 	 *
-	 * \sa CPose2D, CPosePDF, CPose2DGridTemplate
+	 * \sa CPose2D, CPosePDF, CPose2DGridTemplate, CPosePDFSparseGrid (for large volumes or fine resolutions)
 	 * \ingroup poses_pdf_grp
 	 */
 	class BASE_IMPEXP CPosePDFGrid : public CPosePDF, public CPose2DGridTemplate<double>
@@ -0,0 +1,278 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef CPosePDFSparseGrid_H
+#define CPosePDFSparseGrid_H
+
+#include <mrpt/poses/CPosePDF.h>
+#include <mrpt/poses/CPose2D.h>
+#include <mrpt/utils/bits.h> // DEG2RAD()
+#include <map>
+
+namespace mrpt
+{
+namespace poses
+{
+	// This must be added to any CSerializable derived class:
+	DEFINE_SERIALIZABLE_PRE_CUSTOM_BASE( CPosePDFSparseGrid, CPosePDF )
+
+	/** A Probability Distribution function (PDF) of a 2D pose (x,y,phi), as a sparse grid with adaptive resolution.
+	 *
+	 *  The (x,y,phi) volume is divided into a coarse grid of cells of size resolutionXY x resolutionXY x resolutionPhi (level 0).
+	 *  Any cell can be refined into its 8 halves (next level), and so on, so that only the cells with a high probability are
+	 *  divided down to a fine resolution. Only the "leaves" of this hierarchy are stored, each with its probability mass,
+	 *  in a sparse container: the memory and the cost of normalize(), the mean/covariance and the sampling methods
+	 *  grow with the number of leaves, not with the volume at the finest resolution as in CPosePDFGrid. The marginals are
+	 *  an exception when asked at a level finer than some leaves, see getMarginalXY().
+	 *
+	 *  The typical use is a coarse-to-fine evaluation of an observation likelihood for global localization, see computeFromLikelihood():
+	 *  \code
+	 *    CPosePDFSparseGrid pdf(xMin,xMax,yMin,yMax, 1.0, DEG2RAD(45));  // Coarse cells: 1m, 45deg
+	 *    pdf.computeFromLikelihood(myLikelihood, 5);  // Finest cells: 3cm, 1.4deg
+	 *  \endcode
+	 *  where "myLikelihood" is any object with an operator "double operator()(const CPose2D &p, double cellSizeXY, double cellSizePhi)"
+	 *  returning the likelihood of the pose "p" at the center of a cell of the given size. Since the masses of cells of different sizes are
+	 *  compared, it must be a density (the same up to a constant factor for all the cell sizes). Likelihoods narrower than the coarse cells
+	 *  should account for the cell size (e.g. a Gaussian with the variance of the cell, size^2/12, added to that of the sensor noise) so
+	 *  their peaks are not missed at the coarse levels.
+	 *
+	 * \sa CPosePDFGrid, CPosePDF
+	 * \ingroup poses_pdf_grp
+	 */
+	class BASE_IMPEXP CPosePDFSparseGrid : public CPosePDF
+	{
+		// This must be added to any CSerializable derived class:
+		DEFINE_SERIALIZABLE( CPosePDFSparseGrid )
+
+	 public:
+		/** The index of a cell in the grid: cells of level "l" have a size of resolutionXY/2^l x resolutionXY/2^l x resolutionPhi/2^l,
+		  *  and the cell (ix,iy,iphi) covers x in [xMin + ix * size_xy, xMin + (ix+1) * size_xy), and so on. */
+		struct BASE_IMPEXP TCellIndex
+		{
+			TCellIndex() : level(0), ix(0), iy(0), iphi(0) { }
+			TCellIndex(uint8_t level_, int32_t ix_, int32_t iy_, int32_t iphi_) : level(level_), ix(ix_), iy(iy_), iphi(iphi_) { }
+
+			uint8_t level;
+			int32_t ix, iy, iphi;
+
+			bool operator <(const TCellIndex &o) const
+			{
+				if (level!=o.level) return level<o.level;
+				if (iphi!=o.iphi) return iphi<o.iphi;
+				if (iy!=o.iy) return iy<o.iy;
+				return ix<o.ix;
+			}
+			bool operator ==(const TCellIndex &o) const { return level==o.level && ix==o.ix && iy==o.iy && iphi==o.iphi; }
+		};
+
+		typedef std::map<TCellIndex,double> TCells; //!< The probability mass of each leaf cell
+
+		static const unsigned int MAX_LEVEL = 16; //!< Maximum refinement level
+
+		/** Constructor: Initializes a uniform distribution over the whole given range, at the coarse resolution.
+		  */
+		CPosePDFSparseGrid(
+			double		xMin = -1.0f,
+			double		xMax = 1.0f,
+			double		yMin = -1.0f,
+			double		yMax = 1.0f,
+			double		resolutionXY = 0.5f,
+			double		resolutionPhi = mrpt::utils::DEG2RAD(180),
+			double		phiMin = -M_PIf,
+			double		phiMax = M_PIf
+			);
+
+		virtual ~CPosePDFSparseGrid(); //!< Destructor
+
+		/** Changes the limits and the coarse resolution of the grid, and sets a uniform distribution */
+		void setSize(
+			double		xMin,
+			double		xMax,
+			double		yMin,
+			double		yMax,
+			double		resolutionXY,
+			double		resolutionPhi,
+			double		phiMin = -M_PIf,
+			double		phiMax = M_PIf
+			);
+
+		/** @name Access to the cells
+		    @{ */
+		const TCells & getCells() const { return m_cells; } //!< The leaf cells with their probability mass
+		size_t size() const { return m_cells.size(); } //!< Number of leaf cells
+		void clear() { m_cells.clear(); } //!< Removes all the cells (the PDF will be empty until new cells are inserted with setCellMass())
+		void setCellMass(const TCellIndex &idx, double mass); //!< Sets the mass of a leaf cell, inserting it if needed (the caller is responsible for not overlapping other leaves)
+
+		void getCellCenter(const TCellIndex &idx, CPose2D &p) const; //!< Returns the pose at the center of the part of a cell within the grid limits
+		/** Returns the fraction of the volume of a cell within the grid limits: 1 except for the cells at the upper borders, when the
+		  *  ranges are not multiples of the resolution. The probability of the cells is spread only over this part. */
+		double getCellVolumeFraction(const TCellIndex &idx) const;
+		double getCellSizeXY(unsigned int level) const { return m_resolutionXY/(1u<<level); } //!< Size of cells in x and y, for a given level
+		double getCellSizePhi(unsigned int level) const { return m_resolutionPhi/(1u<<level); } //!< Size of cells in phi, for a given level
+		/** Returns the index of the cell of the given level which contains the pose "p", or false if "p" is out of the grid */
+		bool getCellIndex(const CPose2D &p, unsigned int level, TCellIndex &idx) const;
+
+		double  getXMin() const { return m_xMin; }
+		double  getXMax() const { return m_xMax; }
+		double  getYMin() const { return m_yMin; }
+		double  getYMax() const { return m_yMax; }
+		double  getPhiMin() const { return m_phiMin; }
+		double  getPhiMax() const { return m_phiMax; }
+		double  getResolutionXY() const { return m_resolutionXY; }
+		double  getResolutionPhi() const { return m_resolutionPhi; }
+		size_t  getSizeX() const { return m_sizeX; } //!< Number of cells in x at level 0
+		size_t  getSizeY() const { return m_sizeY; } //!< Number of cells in y at level 0
+		size_t  getSizePhi() const { return m_sizePhi; } //!< Number of cells in phi at level 0
+		/** @} */
+
+		/** @name Coarse-to-fine construction
+		    @{ */
+		void normalize(); //!< Normalizes the PDF, such as all cells sum the unity.
+		void uniformDistribution(); //!< Resets the grid to the coarse cells (level 0), all with the same mass, so the sum is 1.
+
+		/** Multiplies the mass of each leaf cell by the likelihood of the pose at its center (the PDF is not normalized).
+		  *  \tparam LIKELIHOOD Any object with an operator "double operator()(const CPose2D &p, double cellSizeXY, double cellSizePhi)".
+		  */
+		template <class LIKELIHOOD>
+		void multiplyByLikelihood(LIKELIHOOD &likelihood)
+		{
+			CPose2D p;
+			for (TCells::iterator it=m_cells.begin();it!=m_cells.end();++it)
+			{
+				getCellCenter(it->first,p);
+				it->second*=likelihood(p,getCellSizeXY(it->first.level),getCellSizePhi(it->first.level));
+			}
+		}
+
+		/** Refines the most probable cells into their 8 halves. The masses of the cells must already include the likelihood (see multiplyByLikelihood()):
+		  *  the likelihood of each refined cell is divided out, leaving its prior mass, which is spread among the children in proportion to their
+		  *  volume within the grid limits (see getCellVolumeFraction()), and multiplied
+		  *  by the likelihood at their centers. If the likelihood of a refined cell is zero, its mass is split among the children in proportion
+		  *  to their likelihoods instead. The PDF is not normalized.
+		  * \param massFraction The refined cells are the most probable ones whose sum is at least this fraction of the total mass.
+		  * \param maxLevel Cells of this level or finer are not refined.
+		  * \return The number of refined cells.
+		  * \tparam LIKELIHOOD Any object with an operator "double operator()(const CPose2D &p, double cellSizeXY, double cellSizePhi)".
+		  */
+		template <class LIKELIHOOD>
+		size_t refineByLikelihood(LIKELIHOOD &likelihood, double massFraction = 0.99, unsigned int maxLevel = MAX_LEVEL)
+		{
+			std::vector<TCellIndex> toRefine;
+			getMostProbableCells(massFraction, maxLevel, toRefine);
+
+			TCellIndex children[8];
+			double     liks[8], vols[8];
+			CPose2D p;
+			for (size_t i=0;i<toRefine.size();i++)
+			{
+				TCells::iterator it = m_cells.find(toRefine[i]);
+				const double mass = it->second;
+				m_cells.erase(it);
+
+				getCellCenter(toRefine[i],p);
+				const double parentLik = likelihood(p,getCellSizeXY(toRefine[i].level),getCellSizePhi(toRefine[i].level));
+
+				getCellChildren(toRefine[i],children);
+				const double sizeXY = getCellSizeXY(children[0].level), sizePhi = getCellSizePhi(children[0].level);
+				double sumVols = 0, sumLiks = 0;
+				for (int k=0;k<8;k++)
+				{
+					vols[k] = getCellVolumeFraction(children[k]);
+					if (vols[k]<=0) { liks[k] = 0; continue; }
+					getCellCenter(children[k],p);
+					liks[k] = likelihood(p,sizeXY,sizePhi)*vols[k];
+					sumVols+=vols[k];
+					sumLiks+=liks[k];
+				}
+				for (int k=0;k<8;k++)
+				{
+					if (vols[k]<=0) continue; // Out of the grid
+					m_cells[children[k]] =
+						parentLik>0 ? mass/parentLik*liks[k]/sumVols :
+						(sumLiks>0 ? mass*liks[k]/sumLiks : mass*vols[k]/sumVols);
+				}
+			}
+			return toRefine.size();
+		}
+
+		/** Removes the leaf cells whose probability density is below a fraction of the maximum density among all the cells. The PDF is not normalized.
+		  * \return The number of removed cells. */
+		size_t pruneCells(double minRelativeDensity);
+
+		/** Builds the PDF of a likelihood function from a uniform prior, coarse to fine: it evaluates the likelihood at the coarse cells,
+		  *  and then refines the most probable cells "nLevels" times with refineByLikelihood(), pruning the negligible cells
+		  *  after each step. The PDF is normalized at the end.
+		  * \tparam LIKELIHOOD Any object with an operator "double operator()(const CPose2D &p, double cellSizeXY, double cellSizePhi)".
+		  */
+		template <class LIKELIHOOD>
+		void computeFromLikelihood(LIKELIHOOD &likelihood, unsigned int nLevels, double massFraction = 0.99, double minRelativeDensity = 1e-6)
+		{
+			ASSERT_(nLevels<=MAX_LEVEL)
+			uniformDistribution();
+			multiplyByLikelihood(likelihood);
+			pruneCells(minRelativeDensity);
+			normalize();
+			for (unsigned int l=0;l<nLevels;l++)
+			{
+				if (!refineByLikelihood(likelihood,massFraction,l+1))
+					break;
+				pruneCells(minRelativeDensity);
+				normalize();
+			}
+		}
+		/** @} */
+
+		/** @name Marginals
+		    @{ */
+		/** Returns the marginal PDF of (x,y) as a sparse grid with the cell size of the given level. Coarser leaves are spread uniformly
+		  *  over the cells they cover, and finer leaves are added up into their ancestors. The keys of the output are the (ix,iy) cell indexes.
+		  *  \note The cost does not only grow with the number of leaves: each leaf of a level "l" coarser than "level" is spread over
+		  *   4^(level-l) output cells, so the cost and the size of the output grow with the area covered by coarse leaves at the
+		  *   resolution of "level", as in a dense grid. Ask for the level of the finest leaves of interest, not a finer one.
+		  */
+		void getMarginalXY(std::map<std::pair<int32_t,int32_t>,double> &outMarginal, unsigned int level) const;
+
+		/** Returns the marginal PDF of phi, with the cell size of the given level (the i'th element is the cell starting at
+		  *  phiMin + i*getCellSizePhi(level)).
+		  *  \note The output has getSizePhi()*2^level elements, and each leaf of a level "l" coarser than "level" is spread over
+		  *   2^(level-l) of them, so the cost grows with 2^level besides the number of leaves. \sa getMarginalXY */
+		void getMarginalPhi(std::vector<double> &outMarginal, unsigned int level) const;
+		/** @} */
+
+		void copyFrom(const CPosePDF &o) MRPT_OVERRIDE; //!< Copy operator, only from another CPosePDFSparseGrid
+		void getMean(CPose2D &mean_pose) const MRPT_OVERRIDE; //!< Returns an estimate of the pose, (the mean, or mathematical expectation of the PDF). \sa getCovariance
+		/** Returns an estimate of the pose covariance matrix (3x3 cov matrix) and the mean, both at once. The covariance includes the spread of the mass within each cell. \sa getMean */
+		void getCovarianceAndMean(mrpt::math::CMatrixDouble33 &cov,CPose2D &mean_point) const MRPT_OVERRIDE;
+		void saveToTextFile(const std::string &dataFile) const MRPT_OVERRIDE; //!< Save the leaf cells to a text file, one per line: "level ix iy iphi x y phi mass", with (x,y,phi) the cell center.
+
+		void  changeCoordinatesReference( const CPose3D &newReferenceBase ) MRPT_OVERRIDE; //!< Not implemented: throws an exception
+		void bayesianFusion(const  CPosePDF &p1,const  CPosePDF &p2, const double &minMahalanobisDistToDrop = 0 ) MRPT_OVERRIDE; //!< Not implemented: throws an exception
+		void inverse(CPosePDF &o) const MRPT_OVERRIDE; //!< Not implemented: throws an exception
+		void drawSingleSample( CPose2D &outPart ) const MRPT_OVERRIDE; //!< Draws a single sample from the distribution: a cell is chosen according to its mass, and the pose drawn uniformly within it.
+		void drawManySamples( size_t N, std::vector<mrpt::math::CVectorDouble> & outSamples ) const MRPT_OVERRIDE; //!< Draws a number of samples from the distribution, and saves as a list of 1x3 vectors, where each row contains a (x,y,phi) datum. Runs in O(C+N log C), with C the number of cells.
+
+	 protected:
+		/** The limits and the coarse resolution of the grid */
+		double m_xMin, m_xMax, m_yMin, m_yMax, m_phiMin, m_phiMax, m_resolutionXY, m_resolutionPhi;
+		size_t m_sizeX, m_sizeY, m_sizePhi; //!< Number of cells at level 0
+		TCells m_cells; //!< The leaf cells
+
+		/** Sets the limits and the coarse resolution of the grid, leaving the cells untouched \sa setSize */
+		void setLimits(double xMin, double xMax, double yMin, double yMax, double resolutionXY, double resolutionPhi, double phiMin, double phiMax);
+
+		/** Returns the most probable cells of a level below maxLevel, whose sum is at least massFraction of the total mass */
+		void getMostProbableCells(double massFraction, unsigned int maxLevel, std::vector<TCellIndex> &outCells) const;
+		static void getCellChildren(const TCellIndex &idx, TCellIndex children[8]); //!< The 8 halves of a cell, in the next level
+		/** The limits of the part of a cell within the grid limits: lims = {x0,x1,y0,y1,phi0,phi1} */
+		void getCellLimits(const TCellIndex &idx, double lims[6]) const;
+
+	}; // End of class def.
+	DEFINE_SERIALIZABLE_POST_CUSTOM_BASE( CPosePDFSparseGrid, CPosePDF )
+	} // End of namespace
+} // End of namespace
+#endif
@@ -16,6 +16,8 @@
 
 namespace mrpt
 {
+	namespace random { class BASE_IMPEXP CRandomGenerator; }
+
     namespace poses
     {
         /** An efficient generator of random samples drawn from a given 2D (CPosePDF) or 3D (CPose3DPDF) pose probability density function (pdf).
@@ -46,8 +48,8 @@ namespace mrpt
 
             void clear(); //!< Clear internal pdf
 
-			void do_sample_2D( CPose2D &p ) const;	//!< Used internally: sample from m_pdf2D
-			void do_sample_3D( CPose3D &p ) const;	//!< Used internally: sample from m_pdf3D
+			void do_sample_2D( CPose2D &p, mrpt::random::CRandomGenerator &rng ) const;	//!< Used internally: sample from m_pdf2D
+			void do_sample_3D( CPose3D &p, mrpt::random::CRandomGenerator &rng ) const;	//!< Used internally: sample from m_pdf3D
 
         public:
             /** Default constructor */
@@ -98,6 +100,22 @@ namespace mrpt
               */
             CPose3D & drawSample( CPose3D &p ) const;
 
+            /** Generate a new sample from the selected PDF, using the given random generator instead of mrpt::random::randomGenerator
+              *  (e.g. one generator per thread, since this method is const and can be called from several threads at once).
+              * \return A reference to the same object passed as argument.
+              */
+            CPose2D & drawSample( CPose2D &p, mrpt::random::CRandomGenerator &rng ) const;
+
+            /** \overload */
+            CPose3D & drawSample( CPose3D &p, mrpt::random::CRandomGenerator &rng ) const;
+
+            /** Generate N 2D samples at once, as N calls to drawSample(CPose2D&), but stored as separate arrays of coordinates
+              *  (a "structure of arrays"), which is much faster for large N: e.g. Gaussian samples are obtained with a few
+              *  loops over contiguous memory, without creating any CPose2D object. The output vectors are resized to N.
+              *  For 3D pdfs, the samples are the (x,y,yaw) parts of the 3D samples.
+              */
+            void drawSamples( size_t N, std::vector<double> &out_x, std::vector<double> &out_y, std::vector<double> &out_phi, mrpt::random::CRandomGenerator &rng ) const;
+
 			/** Return true if samples can be generated, which only requires a previous call to setPosePDF */
 			bool isPrepared() const;
 
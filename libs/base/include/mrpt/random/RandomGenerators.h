@@ -57,7 +57,7 @@ namespace mrpt
 				CRandomGenerator() : m_MT19937_data(),m_std_gauss_set(false) { randomize(); }
 
 				/** Constructor for providing a custom random seed to initialize the PRNG */
-				CRandomGenerator(const uint32_t seed) : m_MT19937_data() { randomize(seed); }
+				CRandomGenerator(const uint32_t seed) : m_MT19937_data(),m_std_gauss_set(false) { randomize(seed); }
 
 				void randomize(const uint32_t seed);  //!< Initialize the PRNG from the given random seed
 				void randomize();	//!< Randomize the generators, based on current time
@@ -51,7 +51,23 @@ namespace mrpt
 
 		public:
 			inline size_t getMemoryPoolMaxSize() const                     { return m_maxPoolEntries; }
-			inline void   setMemoryPoolMaxSize(const size_t maxNumEntries) { m_maxPoolEntries = maxNumEntries; }
+			/** Returns the number of blocks currently in the pool */
+			size_t getMemoryPoolSize() const
+			{
+				mrpt::synch::CCriticalSectionLocker lock( &m_pool_cs );
+				return m_pool.size();
+			}
+			/** Changes the maximum number of entries, freeing the oldest ones if there are more than that in the pool. */
+			void setMemoryPoolMaxSize(const size_t maxNumEntries)
+			{
+				mrpt::synch::CCriticalSectionLocker lock( &m_pool_cs );
+				m_maxPoolEntries = maxNumEntries;
+				while (m_pool.size()>m_maxPoolEntries)
+				{
+					delete m_pool.begin()->second;
+					m_pool.erase(m_pool.begin());
+				}
+			}
 
 			/** Construct-on-first-use (~singleton) pattern: Return the unique instance of this class for a given template arguments,
 			  *  or NULL if it was once created but it's been destroyed (which means we're in the program global destruction phase).
@@ -86,14 +102,20 @@ namespace mrpt
 			}
 
 			/** Saves the passed data block (characterized by \a params) to the pool.
-			  *  If the overall size of the pool is above the limit, the oldest entry is removed.
+			  *  If the overall size of the pool is above the limit, the oldest entry is removed. If the limit is 0, the block is freed right away.
 			  *  \note It is a responsibility of the user to allocate in dynamic memory the "POOLABLE_DATA" object with "new".
 			  */
 			void dump_to_pool(const DATA_PARAMS &params, POOLABLE_DATA *block)
 			{
 				mrpt::synch::CCriticalSectionLocker lock( &m_pool_cs );
 
-				while (m_pool.size()>=m_maxPoolEntries) // Free old data if needed
+				if (!m_maxPoolEntries)
+				{
+					delete block;
+					return;
+				}
+
+				while (!m_pool.empty() && m_pool.size()>=m_maxPoolEntries) // Free old data if needed
 				{
 					if (m_pool.begin()->second) delete m_pool.begin()->second;
 					m_pool.erase(m_pool.begin());
@@ -10,6 +10,9 @@
 #define  MRPT_SYSTEM_THREADS_H
 
 #include <mrpt/utils/core_defs.h>
+#include <vector>
+#include <string>
+#include <stdexcept>
 
 namespace mrpt
 {
@@ -291,6 +294,90 @@ namespace mrpt
 		  */
 		bool BASE_IMPEXP  launchProcess( const std::string & command );
 
+		namespace detail	{
+			/** Auxiliary struct used internally by parallelForBlocks() */
+			template <class FUNCTOR>
+			struct TParallelForBlock
+			{
+				FUNCTOR      *functor;
+				size_t        first, last;
+				unsigned int  block_index;
+				std::string   error_msg;
+
+				static void run(TParallelForBlock<FUNCTOR> &b)	{
+					try {
+						(*b.functor)(b.first,b.last,b.block_index);
+					}
+					catch (std::exception &e) {
+						b.error_msg = e.what();
+						if (b.error_msg.empty()) b.error_msg = "(empty exception message)";
+					}
+					catch (...) {
+						b.error_msg = "Unknown exception";
+					}
+				}
+			};
+		} // end detail
+
+		/** Splits the range of indices [0,N) into contiguous blocks and processes them in parallel, calling
+		  *  `functor(first,last,block_index)` once per block, with `first` inclusive and `last` exclusive.
+		  *  The calling thread processes the first block itself, and this function only returns once all the blocks are done.
+		  *
+		  *  `block_index` is in the range [0,number_of_blocks) and is handy for indexing per-thread buffers, random generators, partial sums, etc.
+		  *  Since the same functor object is used by all the threads, its `operator()` should only write to data which is specific to the given block.
+		  *
+		  *  Example of usage:
+		  *  \code
+		  *    struct TSquare {
+		  *      std::vector<double> &v;
+		  *      TSquare(std::vector<double> &v_) : v(v_) {}
+		  *      void operator()(size_t first, size_t last, unsigned int) {
+		  *        for (size_t i=first;i<last;i++) v[i]*=v[i];
+		  *      }
+		  *    };
+		  *    ...
+		  *    TSquare f(v);
+		  *    mrpt::system::parallelForBlocks(v.size(), f);
+		  *  \endcode
+		  *
+		  * \param N The number of elements to process.
+		  * \param functor The object to call for each block of indices.
+		  * \param num_threads The maximum number of threads (including the calling one) to use. Use 0 for getNumberOfProcessors().
+		  * \return The number of blocks in which the range was split (0 if N=0).
+		  * \exception std::exception If any block raised an exception, its message is re-thrown once all the threads have finished.
+		  * \sa createThread, getNumberOfProcessors
+		  */
+		template <class FUNCTOR>
+		unsigned int parallelForBlocks(const size_t N, FUNCTOR &functor, unsigned int num_threads = 0)
+		{
+			if (!N) return 0;
+			if (!num_threads) num_threads = getNumberOfProcessors();
+			if (num_threads>N) num_threads = static_cast<unsigned int>(N);
+			if (num_threads<1) num_threads = 1;
+
+			std::vector<detail::TParallelForBlock<FUNCTOR> > blocks(num_threads);
+			for (unsigned int i=0;i<num_threads;i++)
+			{
+				blocks[i].functor = &functor;
+				blocks[i].first = (N*i)/num_threads;
+				blocks[i].last = (N*(i+1))/num_threads;
+				blocks[i].block_index = i;
+			}
+
+			std::vector<TThreadHandle> threads(num_threads);
+			for (unsigned int i=1;i<num_threads;i++)
+				threads[i] = createThreadRef(&detail::TParallelForBlock<FUNCTOR>::run, blocks[i]);
+			detail::TParallelForBlock<FUNCTOR>::run(blocks[0]);
+			for (unsigned int i=1;i<num_threads;i++)
+				joinThread(threads[i]);
+
+			for (unsigned int i=0;i<num_threads;i++)
+				if (!blocks[i].error_msg.empty())
+					throw std::runtime_error(blocks[i].error_msg);
+
+			return num_threads;
+		}
+
 		/**  @} */
 
 	} // End of namespace
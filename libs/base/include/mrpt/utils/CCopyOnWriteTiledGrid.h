@@ -0,0 +1,252 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef CCopyOnWriteTiledGrid_H
+#define CCopyOnWriteTiledGrid_H
+
+#include <mrpt/utils/core_defs.h>
+#include <mrpt/synch/atomic_incr.h>
+#include <vector>
+#include <algorithm>
+
+namespace mrpt
+{
+	namespace utils
+	{
+		/** A 2D array of cells stored as square tiles of 2^TILE_BITS x 2^TILE_BITS cells which are shared, with reference counting,
+		  *  between copies of the grid until one of them writes into a tile (copy-on-write).
+		  *
+		  *  Copying a grid only copies one pointer per tile, and modifying a copy only duplicates the tiles actually modified,
+		  *  which is the typical situation of the maps of particles duplicated while resampling in Rao-Blackwellized particle filters.
+		  *  Besides, all the tiles of a freshly created or filled grid share one single tile, so unexplored areas need no memory.
+		  *
+		  *  Read access is through operator(); write access must be done through cellForWrite() or getTileForWrite(), which make
+		  *  the tile unique before returning it. Cells are not bound-checked.
+		  *
+		  *  Different grids sharing tiles can be read and modified from different threads, but one grid instance must not be
+		  *  modified (or copied from) while other thread writes into it.
+		  *
+		  * \tparam T The type of each cell.
+		  * \tparam TILE_BITS Log2 of the tile side length, in cells.
+		  * \sa CDynamicGrid
+		  * \ingroup mrpt_base_grp
+		  */
+		template <typename T, unsigned int TILE_BITS = 6>
+		class CCopyOnWriteTiledGrid
+		{
+			struct TTile;
+		public:
+			static const size_t TILE_SIZE  = static_cast<size_t>(1) << TILE_BITS;	//!< Tile side length, in cells
+			static const size_t TILE_MASK  = TILE_SIZE-1;
+			static const size_t TILE_CELLS = TILE_SIZE*TILE_SIZE;	//!< Cells in one tile, stored row by row
+
+			CCopyOnWriteTiledGrid() : m_tiles(), m_size_x(0), m_size_y(0), m_tiles_x(0), m_tiles_y(0) { }
+
+			/** Copy constructor: shares all the tiles of the other grid. */
+			CCopyOnWriteTiledGrid(const CCopyOnWriteTiledGrid &o) :
+				m_tiles(o.m_tiles), m_size_x(o.m_size_x), m_size_y(o.m_size_y), m_tiles_x(o.m_tiles_x), m_tiles_y(o.m_tiles_y)
+			{
+				for (size_t i=0;i<m_tiles.size();i++)
+					++m_tiles[i]->refs;
+			}
+
+			CCopyOnWriteTiledGrid & operator =(const CCopyOnWriteTiledGrid &o)
+			{
+				if (this!=&o)
+				{
+					CCopyOnWriteTiledGrid aux(o);
+					swap(aux);
+				}
+				return *this;
+			}
+
+			~CCopyOnWriteTiledGrid() { clear(); }
+
+			void swap(CCopyOnWriteTiledGrid &o)
+			{
+				m_tiles.swap(o.m_tiles);
+				std::swap(m_size_x,o.m_size_x);
+				std::swap(m_size_y,o.m_size_y);
+				std::swap(m_tiles_x,o.m_tiles_x);
+				std::swap(m_tiles_y,o.m_tiles_y);
+			}
+
+			/** Frees all the tiles, leaving an empty grid */
+			void clear()
+			{
+				for (size_t i=0;i<m_tiles.size();i++)
+					release(m_tiles[i]);
+				m_tiles.clear();
+				m_size_x = m_size_y = m_tiles_x = m_tiles_y = 0;
+			}
+
+			/** Sets the size of the grid, with all the cells (previous contents are lost) equal to the given value. */
+			void resize(size_t size_x, size_t size_y, const T &value)
+			{
+				clear();
+				if (!size_x || !size_y) return;
+				m_size_x  = size_x;
+				m_size_y  = size_y;
+				m_tiles_x = (size_x+TILE_MASK) >> TILE_BITS;
+				m_tiles_y = (size_y+TILE_MASK) >> TILE_BITS;
+				m_tiles.assign(m_tiles_x*m_tiles_y, new TTile(m_tiles_x*m_tiles_y, value));
+			}
+
+			/** Changes the size of the grid keeping its contents, which are displaced (offset_x,offset_y) cells. New cells are set to `value`.
+			  *  If the offsets are multiple of TILE_SIZE, the existing tiles are not copied. */
+			void resize(size_t new_size_x, size_t new_size_y, size_t offset_x, size_t offset_y, const T &value)
+			{
+				ASSERT_(offset_x+m_size_x<=new_size_x && offset_y+m_size_y<=new_size_y)
+				CCopyOnWriteTiledGrid g;
+				g.resize(new_size_x,new_size_y,value);
+				if (!(offset_x & TILE_MASK) && !(offset_y & TILE_MASK))
+				{
+					const size_t otx = offset_x >> TILE_BITS, oty = offset_y >> TILE_BITS;
+					for (size_t ty=0;ty<m_tiles_y;ty++)
+						for (size_t tx=0;tx<m_tiles_x;tx++)
+						{
+							TTile *&dst = g.m_tiles[(tx+otx)+(ty+oty)*g.m_tiles_x];
+							release(dst);
+							dst = m_tiles[tx+ty*m_tiles_x];
+							++dst->refs;
+						}
+					// The padding cells of the old border tiles may now be inside of the grid:
+					const size_t x_end = std::min(new_size_x,offset_x+(m_tiles_x<<TILE_BITS));
+					const size_t y_end = std::min(new_size_y,offset_y+(m_tiles_y<<TILE_BITS));
+					for (size_t y=offset_y;y<y_end;y++)
+						for (size_t x=(y<offset_y+m_size_y ? offset_x+m_size_x : offset_x);x<x_end;x++)
+							if (g(x,y)!=value)
+								g.cellForWrite(x,y) = value;
+				}
+				else
+				{
+					for (size_t y=0;y<m_size_y;y++)
+						for (size_t x=0;x<m_size_x;x++)
+							g.cellForWrite(x+offset_x,y+offset_y) = (*this)(x,y);
+				}
+				swap(g);
+			}
+
+			/** Sets all the cells to the given value */
+			void fill(const T &value) { resize(m_size_x,m_size_y,value); }
+
+			inline size_t getSizeX() const { return m_size_x; }
+			inline size_t getSizeY() const { return m_size_y; }
+			inline size_t size() const { return m_size_x*m_size_y; }	//!< Number of cells
+			inline bool empty() const { return m_tiles.empty(); }
+
+			/** Read access to a cell (no bound checking) */
+			inline const T & operator()(size_t x, size_t y) const {
+				return m_tiles[(x>>TILE_BITS)+(y>>TILE_BITS)*m_tiles_x]->cells[(x&TILE_MASK)+((y&TILE_MASK)<<TILE_BITS)];
+			}
+			/** Write access to a cell (no bound checking): duplicates its tile first if it is shared with other grids */
+			inline T & cellForWrite(size_t x, size_t y) {
+				TTile *&t = m_tiles[(x>>TILE_BITS)+(y>>TILE_BITS)*m_tiles_x];
+				if (t->refs!=1) detach(t);
+				return t->cells[(x&TILE_MASK)+((y&TILE_MASK)<<TILE_BITS)];
+			}
+
+			/** Write access to cells which mostly fall in the same tile as the previous one (e.g. while raytracing): the check for
+			  *  shared tiles is only done when moving into a different tile. It must not be used after other modifications of the grid.
+			  * \code
+			  *  CCopyOnWriteTiledGrid<int16_t>::TWriteCursor cells(grid);
+			  *  for (...) cells(x,y) += 10;
+			  * \endcode
+			  */
+			class TWriteCursor
+			{
+			public:
+				explicit TWriteCursor(CCopyOnWriteTiledGrid &grid) :
+					m_tiles(grid.m_tiles.empty() ? NULL : &grid.m_tiles[0]), m_tiles_x(grid.m_tiles_x), m_tile(size_t(-1)), m_cells(NULL) { }
+
+				inline T & operator()(size_t x, size_t y) {
+					const size_t tile = (x>>TILE_BITS)+(y>>TILE_BITS)*m_tiles_x;
+					if (tile!=m_tile)
+					{
+						TTile *&t = m_tiles[tile];
+						if (t->refs!=1) detach(t);
+						m_cells = t->cells;
+						m_tile  = tile;
+					}
+					return m_cells[(x&TILE_MASK)+((y&TILE_MASK)<<TILE_BITS)];
+				}
+			private:
+				TTile      **m_tiles;
+				const size_t m_tiles_x;
+				size_t       m_tile;
+				T           *m_cells;
+			};
+
+			inline size_t getTilesCountX() const { return m_tiles_x; }
+			inline size_t getTilesCountY() const { return m_tiles_y; }
+
+			/** Read access to the TILE_CELLS cells of a tile, stored row by row. Cells beyond the grid size are padding. */
+			inline const T * getTile(size_t tx, size_t ty) const { return m_tiles[tx+ty*m_tiles_x]->cells; }
+			/** Write access to the TILE_CELLS cells of a tile, duplicating it first if it is shared with other grids */
+			inline T * getTileForWrite(size_t tx, size_t ty) {
+				TTile *&t = m_tiles[tx+ty*m_tiles_x];
+				if (t->refs!=1) detach(t);
+				return t->cells;
+			}
+			/** Whether a tile is shared with other grids (or other tiles of this one) */
+			inline bool isTileShared(size_t tx, size_t ty) const { return m_tiles[tx+ty*m_tiles_x]->refs!=1; }
+
+			/** Copies one row of cells [x0,x0+count) into a buffer */
+			void getRow(size_t y, T *out, size_t x0 = 0, size_t count = size_t(-1)) const
+			{
+				if (count==size_t(-1)) count = m_size_x-x0;
+				while (count)
+				{
+					const size_t n = std::min(count, TILE_SIZE-(x0&TILE_MASK));
+					const T *src = &(*this)(x0,y);
+					std::copy(src,src+n,out);
+					out+=n; x0+=n; count-=n;
+				}
+			}
+			/** Overwrites one row of cells [x0,x0+count) from a buffer */
+			void setRow(size_t y, const T *in, size_t x0 = 0, size_t count = size_t(-1))
+			{
+				if (count==size_t(-1)) count = m_size_x-x0;
+				while (count)
+				{
+					const size_t n = std::min(count, TILE_SIZE-(x0&TILE_MASK));
+					std::copy(in,in+n,&cellForWrite(x0,y));
+					in+=n; x0+=n; count-=n;
+				}
+			}
+
+		private:
+			struct TTile
+			{
+				mrpt::synch::CAtomicCounter refs;
+				T cells[TILE_CELLS];
+
+				TTile(size_t num_refs, const T &value) : refs(static_cast<long>(num_refs)) { std::fill(cells,cells+TILE_CELLS,value); }
+				TTile(const TTile &o) : refs(1) { std::copy(o.cells,o.cells+TILE_CELLS,cells); }
+			private:
+				TTile & operator =(const TTile &); // Forbidden
+			};
+
+			std::vector<TTile*> m_tiles; //!< Row by row
+			size_t m_size_x, m_size_y, m_tiles_x, m_tiles_y;
+
+			static void release(TTile *t) {
+				if (--t->refs==0) delete t;
+			}
+			/** Replaces a shared tile by a private copy. The copy is made before releasing the tile, so grids sharing it can detach concurrently. */
+			static void detach(TTile *&t) {
+				TTile *c = new TTile(*t);
+				release(t);
+				t = c;
+			}
+		};
+
+	} // End of namespace
+} // end of namespace
+
+#endif
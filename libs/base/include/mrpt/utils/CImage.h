@@ -197,6 +197,23 @@ namespace mrpt
 
 			/** @} */
 
+			/** @name Pool of image buffers
+			    @{ */
+
+			/** Sets the maximum number of pixel buffers kept in a global, thread-safe pool (Default = 8).
+			  *  The buffers of destroyed images are kept there and handed over to new images of exactly the same size and format, so
+			  *  grabbing or processing loops running at a constant resolution do not allocate memory for each new frame.
+			  *  Set to 0 to disable the pool and free the buffers right away.
+			  *  \note The limit is a number of buffers, whatever their size: once the program stops using images of some size,
+			  *   up to this many buffers of that size remain allocated (e.g. 8 x 6 MB for 1920x1080 RGB images), until they are displaced
+			  *   by buffers of other sizes or this method is called with a smaller limit.
+			  */
+			static void setImageBuffersPoolMaxSize(size_t max_buffers);
+			static size_t getImageBuffersPoolMaxSize(); //!< \sa setImageBuffersPoolMaxSize
+			static size_t getImageBuffersPoolSize(); //!< Number of buffers currently kept in the pool \sa setImageBuffersPoolMaxSize
+
+			/** @} */
+
 			// ================================================================
 			/** @name Manipulate the image contents or size, various computer-vision methods (image filters, undistortion, etc.)
 			    @{ */
@@ -286,7 +303,9 @@ namespace mrpt
 				return ret;
 			}
 
-			//! \overload
+			/** \overload
+			  * If out_image already holds an image of the target size and format, its buffer is reused instead of allocating a new one,
+			  *  so calling this repeatedly with the same output object (e.g. for each new frame) does not allocate memory. */
 			void scaleHalf(CImage &out_image) const;
 
 
@@ -301,7 +320,8 @@ namespace mrpt
 				return ret;
 			}
 
-			//! \overload
+			/** \overload
+			  * If out_image already holds an image of the target size and format, its buffer is reused instead of allocating a new one. */
 			void scaleHalfSmooth(CImage &out_image) const;
 
 
@@ -493,6 +513,7 @@ namespace mrpt
 			    @{ */
 
 			/** Copy operator (if the image is externally stored, the writen image will be such as well).
+			  *  If this object already holds an image of the same size and format, the pixels are copied into its existing buffer.
 			  * \sa copyFastFrom
 			  */
 			CImage& operator = (const CImage& o);
@@ -935,6 +956,10 @@ namespace mrpt
 					TImageChannels	nChannels,
 					bool			originTopLeft );
 
+			/** Returns the internal IPL image if it is an 8-bit image of the given size and number of channels which can be overwritten
+			  *  (i.e. not read-only nor externally stored), so it can be reused as the output of an image operation; NULL otherwise. */
+			void *getReusableIplImage(int width, int height, int nChannels) const;
+
 			/** Release the internal IPL image, if not NULL or read-only. */
 			void releaseIpl(bool thisIsExternalImgUnload = false) MRPT_NO_THROWS;
 
@@ -21,7 +21,65 @@ using namespace mrpt::math;
 using namespace std;
 
 
-const unsigned CParticleFilterCapable::PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS = 20;
+namespace
+{
+	/** Sets out_indexes[i] to the index j of the particle such that Q(j-1) <= t_i < Q(j), for the N ascending values t_i=target(i) in [0,1)
+	  *  and the cumulative sum Q of the normalized weights linW. This is a single O(M+N) merge of both sequences. */
+	template <class TARGETS>
+	void selectByCumulativeWeights(const vector<double> &linW, const size_t N, TARGETS &target, size_t *out_indexes)
+	{
+		const size_t M = linW.size();
+		size_t j = 0;
+		double Q = linW[0];
+		for (size_t i=0;i<N;i++)
+		{
+			const double t = target(i);
+			while (t>=Q && j+1<M)
+				Q += linW[++j];
+			out_indexes[i] = j;
+		}
+	}
+
+	struct TSortedTargets {
+		const vector<double> &T;
+		TSortedTargets(const vector<double> &T_) : T(T_) { }
+		inline double operator()(size_t i) const { return T[i]; }
+	};
+	struct TStratifiedTargets {
+		const double step;
+		TStratifiedTargets(double step_) : step(step_) { }
+		inline double operator()(size_t i) { return (i+randomGenerator.drawUniform(0.0,1.0))*step; }
+	};
+	struct TSystematicTargets {
+		const double step, offset;
+		TSystematicTargets(double step_, double offset_) : step(step_), offset(offset_) { }
+		inline double operator()(size_t i) const { return (i+offset)*step; }
+	};
+
+	/** Draws a sample from the standard exponential distribution.
+	  *  The uniform sample is taken from the open interval (0,1), at the centers of the 2^32 bins of drawUniform32bit(), so its log is always finite. */
+	inline double drawExponential()
+	{
+		return -std::log(1.0 - (randomGenerator.drawUniform32bit()+0.5)*(1.0/4294967296.0));
+	}
+
+	/** Draws N indices from the normalized weights linW (multinomial resampling), in ascending order.
+	  *  The sorted uniform samples are generated directly, as the normalized cumulative sums of N+1 exponential samples, to avoid sorting them. */
+	void drawMultinomialSorted(const vector<double> &linW, const size_t N, size_t *out_indexes)
+	{
+		vector<double> T(N);
+		double S = 0;
+		for (size_t i=0;i<N;i++)
+			T[i] = (S += drawExponential());
+		S += drawExponential();
+		const double S_1 = 1.0/S;
+		for (size_t i=0;i<N;i++)
+			T[i]*=S_1;
+
+		TSortedTargets targets(T);
+		selectByCumulativeWeights(linW,N,targets,out_indexes);
+	}
+}
 
 /*---------------------------------------------------------------
 					performResampling
@@ -72,26 +130,27 @@ void CParticleFilterCapable::computeResampling(
 	// Compute the normalized linear weights:
 	//  The array "linW" will be the input to the actual
 	//  resampling algorithms.
-	size_t							i,j,M=in_logWeights.size();
+	const size_t M=in_logWeights.size();
 	ASSERT_(M>0)
 
 	if (!out_particle_count)
 		out_particle_count = M;
+	const size_t N = out_particle_count;
 
-	vector<double>					linW( M,0 );
-	vector<double>::const_iterator	inIt;
-	vector<double>::iterator			outIt;
-	double							linW_SUM=0;
+	vector<double>	linW( M );
+	double			linW_SUM=0;
 
 	// This is to avoid float point range problems:
-	double max_log_w = math::maximum( in_logWeights );
-	for (i=0,inIt=in_logWeights.begin(),outIt=linW.begin();i<M;i++,inIt++,outIt++)
-		linW_SUM += ( (*outIt) = exp( (*inIt) - max_log_w ) );
+	const double max_log_w = math::maximum( in_logWeights );
+	for (size_t i=0;i<M;i++)
+		linW_SUM += ( linW[i] = exp( in_logWeights[i] - max_log_w ) );
 
 	// Normalize weights:
 	ASSERT_(linW_SUM>0);
 	linW *= 1.0 / linW_SUM;
 
+	out_indexes.resize(N);
+
 	switch ( method )
 	{
 	case CParticleFilter::prMultinomial:
@@ -99,33 +158,7 @@ void CParticleFilterCapable::computeResampling(
 			// ==============================================
 			//   Select with replacement
 			// ==============================================
-			vector<double>	Q;
-			mrpt::math::cumsum_tmpl<vector<double>,vector<double>,double>(linW, Q);
-			Q[M-1] = 1.1;
-
-			vector<double>	T(M);
-			randomGenerator.drawUniformVector(T,0.0, 0.999999);
-			T.push_back(1.0);
-
-			// Sort:
-			// --------------------
-			sort( T.begin(), T.end() );
-
-			out_indexes.resize(out_particle_count);
-			i=j=0;
-
-			while (i < out_particle_count)
-			{
-				if (T[i]<Q[j])
-				{
-					out_indexes[i++] = (unsigned int) j;
-				}
-				else
-				{
-					j++;
-					if (j>=M) j=M-1;
-				}
-			}
+			drawMultinomialSorted(linW, N, &out_indexes[0]);
 		}
 		break;	// end of "Select with replacement"
 
@@ -134,129 +167,53 @@ void CParticleFilterCapable::computeResampling(
 			// ==============================================
 			//   prResidual
 			// ==============================================
-			// Repetition counts:
-			vector_uint	N(M);
-			size_t 		R=0;	// Remainder or residual count
-			for (i=0;i<M;i++)
+			// Repetition counts (deterministic part), and the weights of the residual part:
+			vector<size_t>	counts(M);
+			vector<double>	linW_mod(M);
+			size_t 		R=0;	// Number of deterministic copies
+			double		linW_mod_SUM=0;
+			for (size_t i=0;i<M;i++)
 			{
-				N[i] = int( M*linW[i] );
-				R+= N[i];
+				counts[i] = static_cast<size_t>( N*linW[i] );
+				R+= counts[i];
+				linW_mod_SUM += ( linW_mod[i] = N*linW[i]-counts[i] );
 			}
-			size_t  N_rnd =  out_particle_count>=R ? (out_particle_count-R) : 0; // # of particles to be drawn randomly (the "residual" part)
+			const size_t N_rnd = N>R ? (N-R) : 0; // # of particles to be drawn randomly (the "residual" part)
 
-			// Fillout the deterministic part of the resampling:
-			out_indexes.resize(out_particle_count);
-			for (i=0, j=0 ;i<out_particle_count;i++)
-				for (size_t k=0;k<N[i];k++)
-					out_indexes[j++] = i;
-
-			size_t M_fixed = j;
-
-			// Prepare a multinomial resampling with the residual part,
-			//  using the modified weights:
-			// ----------------------------------------------------------
-			if (N_rnd)	// If there are "residual" part (should be virtually always!)
+			// Multinomial resampling of the residual part, using the modified weights:
+			if (N_rnd && linW_mod_SUM>0)
 			{
-				// Compute modified weights:
-				vector<double>	linW_mod(M);
-				const double M_R_1 = 1.0/N_rnd;
-				for (i=0;i<M;i++)
-					linW_mod[i] = M_R_1 * (M*linW[i]-N[i]);
-
-				// perform resampling:
-				vector<double>	Q;
-				mrpt::math::cumsum_tmpl<vector<double>,vector<double>,double>(linW_mod, Q);
-				Q[M-1] = 1.1;
-
-				vector<double>	T(M);
-				randomGenerator.drawUniformVector(T, 0.0 , 0.999999);
-				T.push_back(1.0);
-
-				// Sort:
-				sort( T.begin(), T.end() );
-
-				i=0;
-				j=0;
-
-				while (i < N_rnd)
-				{
-					if (T[i]<Q[j])
-					{
-						out_indexes[M_fixed + i++] = (unsigned int) j;
-					}
-					else
-					{
-						j++;
-						if (j>=M) j=M-1;
-					}
-				}
-			} // end if N_rnd!=0
+				linW_mod *= 1.0/linW_mod_SUM;
+				vector<size_t> idxs_rnd(N_rnd);
+				drawMultinomialSorted(linW_mod, N_rnd, &idxs_rnd[0]);
+				for (size_t i=0;i<N_rnd;i++)
+					counts[idxs_rnd[i]]++;
+			}
+			else if (N_rnd)
+				counts[M-1] += N_rnd; // Only possible with round-off errors
+
+			// Expand the counts:
+			for (size_t i=0,j=0;i<M && j<N;i++)
+				for (size_t k=0;k<counts[i] && j<N;k++)
+					out_indexes[j++] = i;
 		}
 		break;
 	case CParticleFilter::prStratified:
 		{
 			// ==============================================
-			//   prStratified
+			//   prStratified: one uniform sample in each interval [i/N,(i+1)/N)
 			// ==============================================
-			vector<double>	Q;
-			mrpt::math::cumsum_tmpl<vector<double>,vector<double>,double>(linW, Q);
-			Q[M-1] = 1.1;
-
-			// Stratified-uniform random vector:
-			vector<double>	T(M+1);
-			const double	_1_M = 1.0 / M;
-			const double	_1_M_eps = _1_M - 0.000001;
-			double   		T_offset = 0;
-			for (i=0;i<M;i++)
-			{
-				T[i] = T_offset + randomGenerator.drawUniform(0.0,_1_M_eps);
-				T_offset+= _1_M;
-			}
-			T[M] = 1;
-
-			out_indexes.resize(out_particle_count);
-			i=j=0;
-			while (i < out_particle_count)
-			{
-				if (T[i]<Q[j])
-					out_indexes[i++] = (unsigned int)j;
-				else
-				{
-					j++;
-					if (j>=M) j=M-1;
-				}
-			}
+			TStratifiedTargets targets(1.0/N);
+			selectByCumulativeWeights(linW,N,targets,&out_indexes[0]);
 		}
 		break;
 	case CParticleFilter::prSystematic:
 		{
 			// ==============================================
-			//   prSystematic
+			//   prSystematic: equally-spaced samples with one uniform offset
 			// ==============================================
-			vector<double>	Q;
-			mrpt::math::cumsum_tmpl<vector<double>,vector<double>,double>(linW, Q);
-			Q[M-1] = 1.1;
-
-			// Uniform random vector:
-			vector<double>	T(M+1);
-			double	_1_M = 1.0 / M;
-			T[0] = randomGenerator.drawUniform(0.0,_1_M);
-			for (i=1;i<M;i++)	T[i] = T[i-1] + _1_M;
-			T[M] = 1;
-
-			out_indexes.resize(out_particle_count);
-			i=j=0;
-			while (i < out_particle_count)
-			{
-				if (T[i]<Q[j])
-					out_indexes[i++] = (unsigned int)j;
-				else
-				{
-					j++;
-					if (j>=M) j=M-1;
-				}
-			}
-
+			TSystematicTargets targets(1.0/N, randomGenerator.drawUniform(0.0,1.0));
+			selectByCumulativeWeights(linW,N,targets,&out_indexes[0]);
 		}
 		break;
 	default:
@@ -357,67 +314,36 @@ void  CParticleFilterCapable::prepareFastDrawSample(
 	{
 		// --------------------------------------------------------
 		// CASE: Dynamic number of particles:
-		//  -> Use m_fastDrawAuxiliary.CDF, PDF, CDF_indexes
+		//  -> Use m_fastDrawAuxiliary.CDF, PDF
 		// --------------------------------------------------------
 		if (PF_options.resamplingMethod!=CParticleFilter::prMultinomial)
 			THROW_EXCEPTION("resamplingMethod must be 'prMultinomial' for a dynamic number of particles!");
 
-		size_t	i,j=666666,M = particlesCount();
-
-		MRPT_START
-
-		// Prepare buffers:
-		m_fastDrawAuxiliary.CDF.resize( 1+PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS, 0);
-		m_fastDrawAuxiliary.CDF_indexes.resize( PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS, 0);
+		const size_t M = particlesCount();
+		ASSERT_(M>0)
 
 		// Compute the vector of each particle's probability (usually
 		//  it will be simply the weight, but there are other algorithms)
 		m_fastDrawAuxiliary.PDF.resize( M, 0);
+		m_fastDrawAuxiliary.CDF.resize( M, 0);
 
 		// This is done to avoid floating point overflow!! (JLBC - SEP 2007)
 		// -------------------------------------------------------------------
 		double	SUM = 0;
 		// Save the log likelihoods:
-		for (i=0;i<M;i++)	m_fastDrawAuxiliary.PDF[i] = partEvaluator(PF_options, this,i,action,observation);
+		for (size_t i=0;i<M;i++)	m_fastDrawAuxiliary.PDF[i] = partEvaluator(PF_options, this,i,action,observation);
 		// "Normalize":
 		m_fastDrawAuxiliary.PDF += -math::maximum( m_fastDrawAuxiliary.PDF );
-		for (i=0;i<M;i++)	SUM += m_fastDrawAuxiliary.PDF[i] = exp( m_fastDrawAuxiliary.PDF[i] );
+		for (size_t i=0;i<M;i++)	SUM += m_fastDrawAuxiliary.PDF[i] = exp( m_fastDrawAuxiliary.PDF[i] );
 		ASSERT_(SUM>=0);
 		MRPT_CHECK_NORMAL_NUMBER(SUM);
 		m_fastDrawAuxiliary.PDF *= 1.0/SUM;
 
-		// Compute the CDF thresholds:
-		for (i=0;i<PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS;i++)
-			m_fastDrawAuxiliary.CDF[i] = ((double)i) / ((double)PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS);
-		m_fastDrawAuxiliary.CDF[PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS] = 1.0;
-
-		// Compute the CDF and save threshold indexes:
+		// Compute the CDF:
 		double	CDF = 0; // Cumulative density func.
-		for (i=0,j=0;i<M && j<PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS;i++)
-		{
-			double CDF_next = CDF + m_fastDrawAuxiliary.PDF[i];
-			if (i==(M-1)) CDF_next = 1.0;	// rounds fix...
-			if (CDF_next>1.0) CDF_next = 1.0;
-
-			while ( m_fastDrawAuxiliary.CDF[j] < CDF_next )
-				m_fastDrawAuxiliary.CDF_indexes[j++] = (unsigned int)i;
-
-			CDF = CDF_next;
-		}
-
-		ASSERT_( j == PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS );
-
-		// Done!
-#if !defined(_MSC_VER) || (_MSC_VER>1400)  // <=VC2005 doesn't work with this!
-		MRPT_END_WITH_CLEAN_UP( \
-			/* Debug: */ \
-			cout << "j=" << j << "\nm_fastDrawAuxiliary.CDF_indexes:" << m_fastDrawAuxiliary.CDF_indexes << endl; \
-			cout << "m_fastDrawAuxiliary.CDF:" << m_fastDrawAuxiliary.CDF << endl; \
-			);
-#else
-		MRPT_END
-#endif
-
+		for (size_t i=0;i<M;i++)
+			m_fastDrawAuxiliary.CDF[i] = (CDF += m_fastDrawAuxiliary.PDF[i]);
+		m_fastDrawAuxiliary.CDF[M-1] = 1.0;	// rounds fix...
 	}
 	else
 	{
@@ -459,34 +385,18 @@ size_t  CParticleFilterCapable::fastDrawSample( const bayes::CParticleFilter::TP
 	{
 		// --------------------------------------------------------
 		// CASE: Dynamic number of particles:
-		//  -> Use m_fastDrawAuxiliary.CDF, PDF, CDF_indexes
+		//  -> Use m_fastDrawAuxiliary.CDF, PDF
 		// --------------------------------------------------------
 		if (PF_options.resamplingMethod!=CParticleFilter::prMultinomial)
 			THROW_EXCEPTION("resamplingMethod must be 'prMultinomial' for a dynamic number of particles!");
 
-		double draw = randomGenerator.drawUniform(0,0.999999);
-		double CDF_next=-1.;
-		double CDF = -1.;
+		const vector<double> &CDF = m_fastDrawAuxiliary.CDF;
+		ASSERTMSG_(!CDF.empty(), "Did you forget calling 'prepareFastDrawSample' before?")
 
-		MRPT_START
-
-		// Use the look-up table to see the starting index we must start looking from:
-		size_t j = (size_t)floor( draw * ((double)PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS-0.05) );
-		CDF = m_fastDrawAuxiliary.CDF[j];
-		size_t i = m_fastDrawAuxiliary.CDF_indexes[j];
-
-		// Find the drawn particle!
-		while ( draw > (CDF_next = CDF+m_fastDrawAuxiliary.PDF[i]) )
-		{
-			CDF = CDF_next;
-			i++;
-		}
-
-		return i;
-
-		MRPT_END_WITH_CLEAN_UP( \
-			printf("\n[CParticleFilterCapable::fastDrawSample] DEBUG: draw=%f, CDF=%f CDF_next=%f\n",draw,CDF,CDF_next); \
-			);
+		// Find the drawn particle with a binary search:
+		const double draw = randomGenerator.drawUniform(0.0,1.0);
+		const size_t i = std::upper_bound(CDF.begin(),CDF.end(),draw) - CDF.begin();
+		return std::min(i,CDF.size()-1);
 	}
 	else
 	{
@@ -503,6 +413,38 @@ size_t  CParticleFilterCapable::fastDrawSample( const bayes::CParticleFilter::TP
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+					fastDrawSamples
+ ---------------------------------------------------------------*/
+void CParticleFilterCapable::fastDrawSamples( const bayes::CParticleFilter::TParticleFilterOptions &PF_options, const size_t n, std::vector<size_t> &out_indexes ) const
+{
+	MRPT_START
+
+	out_indexes.resize(n);
+	if (!n) return;
+
+	if (PF_options.adaptiveSampleSize)
+	{
+		// CASE: Dynamic number of particles: n draws at once from the PDF
+		if (PF_options.resamplingMethod!=CParticleFilter::prMultinomial)
+			THROW_EXCEPTION("resamplingMethod must be 'prMultinomial' for a dynamic number of particles!");
+		ASSERTMSG_(!m_fastDrawAuxiliary.PDF.empty(), "Did you forget calling 'prepareFastDrawSample' before?")
+
+		drawMultinomialSorted(m_fastDrawAuxiliary.PDF, n, &out_indexes[0]);
+	}
+	else
+	{
+		// CASE: Static number of particles: the next n already drawn indexes
+		if ( m_fastDrawAuxiliary.alreadyDrawnNextOne+n>m_fastDrawAuxiliary.alreadyDrawnIndexes.size() )
+			THROW_EXCEPTION("Have you called 'fastDrawSample' more times than the sample size? Did you forget calling 'prepareFastCall' before?");
+
+		for (size_t i=0;i<n;i++)
+			out_indexes[i] = m_fastDrawAuxiliary.alreadyDrawnIndexes[m_fastDrawAuxiliary.alreadyDrawnNextOne++];
+	}
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 						log2linearWeights
  ---------------------------------------------------------------*/
@@ -0,0 +1,135 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/bayes/CParticleFilterCapable.h>
+#include <mrpt/poses/CPosePDFParticles.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace mrpt;
+using namespace mrpt::bayes;
+using namespace std;
+
+namespace
+{
+	void check_resampling(CParticleFilter::TParticleResamplingAlgorithm method, size_t out_count)
+	{
+		// Particle i has a linear weight proportional to (i+1), and the last one, zero:
+		const size_t M = 10;
+		vector<double> log_ws(M);
+		double sum = 0;
+		for (size_t i=0;i<M-1;i++) sum += i+1;
+		for (size_t i=0;i<M-1;i++) log_ws[i] = std::log( (i+1)/sum );
+		log_ws[M-1] = -1e3;
+
+		mrpt::random::randomGenerator.randomize(1234);
+		vector<size_t> idxs;
+		CParticleFilterCapable::computeResampling(method, log_ws, idxs, out_count);
+
+		const size_t N = out_count ? out_count : M;
+		ASSERT_EQ(idxs.size(), N);
+
+		vector<size_t> counts(M,0);
+		for (size_t i=0;i<N;i++)
+		{
+			ASSERT_LT(idxs[i], M-1) << "Method: " << method;  // Never the particle without weight
+			if (i) EXPECT_LE(idxs[i-1], idxs[i]) << "Method: " << method;
+			counts[idxs[i]]++;
+		}
+
+		// Frequencies approximate the weights:
+		for (size_t i=0;i<M-1;i++)
+		{
+			const double expected = N*(i+1)/sum;
+			switch (method)
+			{
+			case CParticleFilter::prSystematic:
+				EXPECT_LE(std::abs(counts[i]-expected), 1.0+1e-9) << "i=" << i;
+				break;
+			case CParticleFilter::prStratified:
+				EXPECT_LE(std::abs(counts[i]-expected), 2.0+1e-9) << "i=" << i;
+				break;
+			case CParticleFilter::prResidual:
+				EXPECT_GE(counts[i], std::floor(expected)) << "i=" << i;
+				// Fall through: the residual part is multinomial
+			default:
+				EXPECT_NEAR(counts[i], expected, 5*std::sqrt(expected)+1) << "Method: " << method << " i=" << i;
+			};
+		}
+	}
+}
+
+TEST(CParticleFilterCapable, computeResampling)
+{
+	const CParticleFilter::TParticleResamplingAlgorithm methods[] = {
+		CParticleFilter::prMultinomial, CParticleFilter::prResidual, CParticleFilter::prStratified, CParticleFilter::prSystematic };
+	for (size_t m=0;m<sizeof(methods)/sizeof(methods[0]);m++)
+	{
+		check_resampling(methods[m], 0);
+		check_resampling(methods[m], 7);
+		check_resampling(methods[m], 10000);
+	}
+}
+
+TEST(CParticleFilterCapable, fastDrawSamples)
+{
+	// Same weights as above: particle i proportional to (i+1), and the last one, zero:
+	const size_t M = 10;
+	mrpt::poses::CPosePDFParticles pdf(M);
+	double sum = 0;
+	for (size_t i=0;i<M-1;i++) sum += i+1;
+	for (size_t i=0;i<M-1;i++) pdf.setW(i, std::log( (i+1)/sum ));
+	pdf.setW(M-1, -1e3);
+
+	CParticleFilter::TParticleFilterOptions opts;
+	mrpt::random::randomGenerator.randomize(1234);
+
+	// Dynamic number of particles: n sorted draws from the weights
+	opts.adaptiveSampleSize = true;
+	opts.resamplingMethod = CParticleFilter::prMultinomial;
+	pdf.prepareFastDrawSample(opts);
+
+	const size_t N = 20000;
+	vector<size_t> idxs;
+	pdf.fastDrawSamples(opts, N, idxs);
+	ASSERT_EQ(idxs.size(), N);
+	vector<size_t> counts(M,0);
+	for (size_t i=0;i<N;i++)
+	{
+		ASSERT_LT(idxs[i], M-1);
+		if (i) EXPECT_LE(idxs[i-1], idxs[i]);
+		counts[idxs[i]]++;
+	}
+	for (size_t i=0;i<M-1;i++)
+	{
+		const double expected = N*(i+1)/sum;
+		EXPECT_NEAR(counts[i], expected, 5*std::sqrt(expected)+1) << "i=" << i;
+	}
+
+	pdf.fastDrawSamples(opts, 0, idxs);
+	EXPECT_TRUE(idxs.empty());
+
+	// Static number of particles: the same sequence than fastDrawSample(), and no more than M in total
+	opts.adaptiveSampleSize = false;
+	opts.resamplingMethod = CParticleFilter::prSystematic;
+	mrpt::random::randomGenerator.randomize(1234);
+	pdf.prepareFastDrawSample(opts);
+	vector<size_t> one_by_one(M);
+	for (size_t i=0;i<M;i++) one_by_one[i] = pdf.fastDrawSample(opts);
+
+	mrpt::random::randomGenerator.randomize(1234);
+	pdf.prepareFastDrawSample(opts);
+	vector<size_t> first, rest;
+	pdf.fastDrawSamples(opts, 3, first);
+	pdf.fastDrawSamples(opts, M-3, rest);
+	first.insert(first.end(), rest.begin(), rest.end());
+	EXPECT_TRUE(first==one_by_one);
+	EXPECT_THROW(pdf.fastDrawSamples(opts, 1, rest), std::exception);
+}
@@ -0,0 +1,88 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/bayes/CRejectionSamplingCapable.h>
+#include <mrpt/synch/CCriticalSection.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace mrpt;
+using namespace mrpt::bayes;
+using namespace std;
+
+namespace
+{
+	// Samples of x in [0,1) with a likelihood proportional to x, and so low that most candidates are rejected.
+	// All the candidates drawn are recorded.
+	class CTestRejectionSampling : public CRejectionSamplingCapable<double>
+	{
+	public:
+		bool                         thread_safe;
+		std::vector<double>          candidates;
+		mrpt::synch::CCriticalSection cs;
+
+		explicit CTestRejectionSampling(bool thread_safe_) : thread_safe(thread_safe_) { }
+
+		static double likelihood(double x) { return 0.02*x; }
+
+	protected:
+		void RS_drawFromProposal( double &outSample ) { RS_drawFromProposal(outSample,mrpt::random::randomGenerator); }
+		void RS_drawFromProposal( double &outSample, mrpt::random::CRandomGenerator &rng )
+		{
+			outSample = rng.drawUniform(0.0,1.0);
+			mrpt::synch::CCriticalSectionLocker lock(&cs);
+			candidates.push_back(outSample);
+		}
+		bool RS_isThreadSafe() const { return thread_safe; }
+		double RS_observationLikelihood( const double &x) { return likelihood(x); }
+	};
+
+	// At timeout, the weighted samples must be the most likely rejected candidates of all those drawn:
+	void test_timeout_keeps_most_likely(bool thread_safe, unsigned int num_threads)
+	{
+		const size_t N = 30, timeoutTrials = 20;
+		CTestRejectionSampling RS(thread_safe);
+		std::vector<CTestRejectionSampling::TParticle> samples;
+		mrpt::random::randomGenerator.randomize(1234);
+		RS.rejectionSamplingParallel(N, samples, timeoutTrials, num_threads);
+		ASSERT_EQ(samples.size(), N);
+		EXPECT_LE(RS.candidates.size(), N*timeoutTrials);
+
+		std::vector<double> rejected = RS.candidates, weighted;
+		for (size_t i=0;i<N;i++)
+		{
+			if (samples[i].log_w==0)
+				rejected.erase( std::find(rejected.begin(),rejected.end(),*samples[i].d) );
+			else
+			{
+				EXPECT_NEAR(samples[i].log_w, std::log(CTestRejectionSampling::likelihood(*samples[i].d)), 1e-9);
+				weighted.push_back(*samples[i].d);
+			}
+		}
+		ASSERT_GT(weighted.size(), 0u);
+		std::sort(rejected.rbegin(),rejected.rend());
+		std::sort(weighted.rbegin(),weighted.rend());
+		for (size_t i=0;i<weighted.size();i++)
+			EXPECT_EQ(weighted[i], rejected[i]) << "i=" << i;
+
+		for (size_t i=0;i<N;i++)
+			delete samples[i].d;
+	}
+}
+
+TEST(CRejectionSamplingCapable, TimeoutKeepsMostLikelyCandidates)
+{
+	test_timeout_keeps_most_likely(false,1);
+}
+
+TEST(CRejectionSamplingCapable, TimeoutKeepsMostLikelyCandidatesThreads)
+{
+	test_timeout_keeps_most_likely(true,3);
+}
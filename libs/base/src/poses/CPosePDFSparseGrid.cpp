@@ -0,0 +1,590 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include "base-precomp.h"  // Precompiled headers
+
+
+#include <mrpt/poses/CPosePDFSparseGrid.h>
+#include <mrpt/utils/CStream.h>
+#include <mrpt/random.h>
+#include <mrpt/system/os.h>
+#include <mrpt/math/wrap2pi.h>
+#include <mrpt/poses/SO_SE_average.h>
+#include <algorithm>
+
+using namespace std;
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace mrpt::math;
+using namespace mrpt::poses;
+using namespace mrpt::random;
+using namespace mrpt::system;
+
+IMPLEMENTS_SERIALIZABLE( CPosePDFSparseGrid, CPosePDF, mrpt::poses )
+
+const unsigned int CPosePDFSparseGrid::MAX_LEVEL;
+
+/*---------------------------------------------------------------
+	Constructor
+  ---------------------------------------------------------------*/
+CPosePDFSparseGrid::CPosePDFSparseGrid(
+	double		xMin,
+	double		xMax,
+	double		yMin,
+	double		yMax,
+	double		resolutionXY,
+	double		resolutionPhi,
+	double		phiMin,
+	double		phiMax
+	) :
+	m_xMin(), m_xMax(), m_yMin(), m_yMax(), m_phiMin(), m_phiMax(), m_resolutionXY(), m_resolutionPhi(),
+	m_sizeX(), m_sizeY(), m_sizePhi(),
+	m_cells()
+{
+	setSize(xMin,xMax,yMin,yMax,resolutionXY,resolutionPhi,phiMin,phiMax);
+}
+
+/*---------------------------------------------------------------
+	Destructor
+  ---------------------------------------------------------------*/
+CPosePDFSparseGrid::~CPosePDFSparseGrid( )
+{
+}
+
+/*---------------------------------------------------------------
+						setSize
+  ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::setSize(
+	double		xMin,
+	double		xMax,
+	double		yMin,
+	double		yMax,
+	double		resolutionXY,
+	double		resolutionPhi,
+	double		phiMin,
+	double		phiMax
+	)
+{
+	setLimits(xMin,xMax,yMin,yMax,resolutionXY,resolutionPhi,phiMin,phiMax);
+	uniformDistribution();
+}
+
+/*---------------------------------------------------------------
+						setLimits
+  ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::setLimits(
+	double		xMin,
+	double		xMax,
+	double		yMin,
+	double		yMax,
+	double		resolutionXY,
+	double		resolutionPhi,
+	double		phiMin,
+	double		phiMax
+	)
+{
+	ASSERT_( xMax > xMin );
+	ASSERT_( yMax > yMin );
+	ASSERT_( phiMax >= phiMin );
+	ASSERT_( resolutionXY>0 );
+	ASSERT_( resolutionPhi>0 );
+
+	m_xMin = xMin;			m_xMax = xMax;
+	m_yMin = yMin;			m_yMax = yMax;
+	m_phiMin = phiMin;		m_phiMax = phiMax;
+	m_resolutionXY = resolutionXY;
+	m_resolutionPhi = resolutionPhi;
+
+	// Number of coarse cells covering the whole volume (at least one):
+	m_sizeX   = std::max<size_t>(1, static_cast<size_t>( ceil( (xMax-xMin)/resolutionXY - 1e-9 ) ) );
+	m_sizeY   = std::max<size_t>(1, static_cast<size_t>( ceil( (yMax-yMin)/resolutionXY - 1e-9 ) ) );
+	m_sizePhi = std::max<size_t>(1, static_cast<size_t>( ceil( (phiMax-phiMin)/resolutionPhi - 1e-9 ) ) );
+}
+
+/*---------------------------------------------------------------
+						uniformDistribution
+  ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::uniformDistribution()
+{
+	m_cells.clear();
+
+	// Insert in the order of the keys, so each insertion takes constant time.
+	// The cells at the upper borders may only be partly within the limits:
+	for (size_t phi=0;phi<m_sizePhi;phi++)
+		for (size_t y=0;y<m_sizeY;y++)
+			for (size_t x=0;x<m_sizeX;x++)
+			{
+				const TCellIndex idx(0,x,y,phi);
+				m_cells.insert( m_cells.end(), TCells::value_type( idx, getCellVolumeFraction(idx) ) );
+			}
+	normalize();
+}
+
+/*---------------------------------------------------------------
+						setCellMass
+  ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::setCellMass(const TCellIndex &idx, double mass)
+{
+	ASSERT_(idx.level<=MAX_LEVEL)
+	ASSERT_(idx.ix>=0 && idx.iy>=0 && idx.iphi>=0)
+	ASSERT_(size_t(idx.ix)<(m_sizeX<<idx.level) && size_t(idx.iy)<(m_sizeY<<idx.level) && size_t(idx.iphi)<(m_sizePhi<<idx.level))
+	m_cells[idx] = mass;
+}
+
+/*---------------------------------------------------------------
+						getCellCenter
+  ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::getCellCenter(const TCellIndex &idx, CPose2D &p) const
+{
+	double lims[6];
+	getCellLimits(idx,lims);
+	p.x( 0.5*(lims[0]+lims[1]) );
+	p.y( 0.5*(lims[2]+lims[3]) );
+	p.phi( 0.5*(lims[4]+lims[5]) );
+}
+
+/*---------------------------------------------------------------
+						getCellLimits
+  ---------------------------------------------------------------*/
+namespace
+{
+	// Clips the interval [x0,x0+size] to [min,max]. Degenerate ranges (max<=min) are kept as a single value.
+	void clipInterval(double x0, double size, double min, double max, double &out0, double &out1)
+	{
+		if (max<=min) { out0 = out1 = min; return; }
+		out0 = std::min(x0,max);
+		out1 = std::min(x0+size,max);
+	}
+
+	// The fraction of the interval [x0,x0+size] within [min,max] (1 for degenerate ranges).
+	double intervalFraction(double x0, double size, double min, double max)
+	{
+		if (max<=min) return 1.0;
+		double a,b;
+		clipInterval(x0,size,min,max,a,b);
+		return (b-a)/size;
+	}
+}
+
+void CPosePDFSparseGrid::getCellLimits(const TCellIndex &idx, double lims[6]) const
+{
+	const double sXY = getCellSizeXY(idx.level), sPhi = getCellSizePhi(idx.level);
+	clipInterval(m_xMin + idx.ix*sXY, sXY, m_xMin, m_xMax, lims[0], lims[1]);
+	clipInterval(m_yMin + idx.iy*sXY, sXY, m_yMin, m_yMax, lims[2], lims[3]);
+	clipInterval(m_phiMin + idx.iphi*sPhi, sPhi, m_phiMin, m_phiMax, lims[4], lims[5]);
+}
+
+/*---------------------------------------------------------------
+						getCellVolumeFraction
+  ---------------------------------------------------------------*/
+double CPosePDFSparseGrid::getCellVolumeFraction(const TCellIndex &idx) const
+{
+	double lims[6];
+	getCellLimits(idx,lims);
+	const double sXY = getCellSizeXY(idx.level), sPhi = getCellSizePhi(idx.level);
+	return
+		(lims[1]-lims[0])/sXY * (lims[3]-lims[2])/sXY *
+		(m_phiMax>m_phiMin ? (lims[5]-lims[4])/sPhi : 1.0);
+}
+
+/*---------------------------------------------------------------
+						getCellIndex
+  ---------------------------------------------------------------*/
+bool CPosePDFSparseGrid::getCellIndex(const CPose2D &p, unsigned int level, TCellIndex &idx) const
+{
+	ASSERT_(level<=MAX_LEVEL)
+	const double sXY = getCellSizeXY(level), sPhi = getCellSizePhi(level);
+	const double ix = floor( (p.x()-m_xMin)/sXY );
+	const double iy = floor( (p.y()-m_yMin)/sXY );
+	const double iphi = floor( (p.phi()-m_phiMin)/sPhi );
+	if (ix<0 || iy<0 || iphi<0 || ix>=(m_sizeX<<level) || iy>=(m_sizeY<<level) || iphi>=(m_sizePhi<<level))
+		return false;
+	idx = TCellIndex(level, static_cast<int32_t>(ix), static_cast<int32_t>(iy), static_cast<int32_t>(iphi));
+	return true;
+}
+
+/*---------------------------------------------------------------
+						getCellChildren
+  ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::getCellChildren(const TCellIndex &idx, TCellIndex children[8])
+{
+	ASSERT_(idx.level<MAX_LEVEL)
+	for (int k=0;k<8;k++)
+		children[k] = TCellIndex( idx.level+1, 2*idx.ix + (k&1), 2*idx.iy + ((k>>1)&1), 2*idx.iphi + ((k>>2)&1) );
+}
+
+/*---------------------------------------------------------------
+						normalize
+  ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::normalize()
+{
+	double SUM = 0;
+	for (TCells::const_iterator it=m_cells.begin();it!=m_cells.end();++it)	SUM += it->second;
+
+	if (SUM>0)
+	{
+		const double K = 1.0/SUM;
+		for (TCells::iterator it=m_cells.begin();it!=m_cells.end();++it)	it->second *= K;
+	}
+}
+
+/*---------------------------------------------------------------
+						pruneCells
+  ---------------------------------------------------------------*/
+size_t CPosePDFSparseGrid::pruneCells(double minRelativeDensity)
+{
+	// Densities relative to the cells of level 0: each level has 8 times smaller cells.
+	vector<double> densities;
+	densities.reserve(m_cells.size());
+	double maxDensity = 0;
+	for (TCells::const_iterator it=m_cells.begin();it!=m_cells.end();++it)
+	{
+		densities.push_back( ldexp(it->second, 3*it->first.level) / getCellVolumeFraction(it->first) );
+		maxDensity = std::max(maxDensity, densities.back() );
+	}
+
+	const double minDensity = minRelativeDensity*maxDensity;
+	size_t nRemoved = 0, i = 0;
+	for (TCells::iterator it=m_cells.begin();it!=m_cells.end();++i)
+	{
+		if (densities[i] < minDensity)
+		{
+			m_cells.erase(it++);
+			nRemoved++;
+		}
+		else ++it;
+	}
+	return nRemoved;
+}
+
+/*---------------------------------------------------------------
+						getMostProbableCells
+  ---------------------------------------------------------------*/
+namespace
+{
+	bool greaterMass(const pair<double,CPosePDFSparseGrid::TCellIndex> &a, const pair<double,CPosePDFSparseGrid::TCellIndex> &b)
+	{
+		return a.first>b.first;
+	}
+}
+
+void CPosePDFSparseGrid::getMostProbableCells(double massFraction, unsigned int maxLevel, std::vector<TCellIndex> &outCells) const
+{
+	outCells.clear();
+
+	vector<pair<double,TCellIndex> > cells;
+	cells.reserve(m_cells.size());
+	double SUM = 0;
+	for (TCells::const_iterator it=m_cells.begin();it!=m_cells.end();++it)
+	{
+		cells.push_back( make_pair(it->second,it->first) );
+		SUM += it->second;
+	}
+	std::sort(cells.begin(),cells.end(),greaterMass);
+
+	const double minMass = massFraction*SUM;
+	double accum = 0;
+	for (size_t i=0;i<cells.size() && (i==0 || accum<minMass);i++)
+	{
+		accum+=cells[i].first;
+		if (cells[i].second.level<maxLevel && cells[i].second.level<MAX_LEVEL)
+			outCells.push_back(cells[i].second);
+	}
+}
+
+/*---------------------------------------------------------------
+						getMarginalXY
+  ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::getMarginalXY(std::map<std::pair<int32_t,int32_t>,double> &outMarginal, unsigned int level) const
+{
+	ASSERT_(level<=MAX_LEVEL)
+	outMarginal.clear();
+	for (TCells::const_iterator it=m_cells.begin();it!=m_cells.end();++it)
+	{
+		const TCellIndex &c = it->first;
+		if (c.level>=level)
+		{
+			// Add up into the ancestor:
+			const unsigned int shift = c.level-level;
+			outMarginal[ make_pair(c.ix>>shift, c.iy>>shift) ] += it->second;
+		}
+		else
+		{
+			// Spread over the covered cells, in proportion to their area within the limits:
+			const unsigned int shift = level-c.level;
+			const int32_t n = 1<<shift;
+			const double s = getCellSizeXY(level);
+			vector<double> fx(n), fy(n);
+			double sumX = 0, sumY = 0;
+			for (int32_t i=0;i<n;i++)
+			{
+				sumX += fx[i] = intervalFraction(m_xMin + ((c.ix<<shift)+i)*s, s, m_xMin, m_xMax);
+				sumY += fy[i] = intervalFraction(m_yMin + ((c.iy<<shift)+i)*s, s, m_yMin, m_yMax);
+			}
+			const double val = it->second/(sumX*sumY);
+			for (int32_t y=0;y<n;y++)
+				for (int32_t x=0;x<n;x++)
+					if (fx[x]>0 && fy[y]>0)
+						outMarginal[ make_pair((c.ix<<shift)+x, (c.iy<<shift)+y) ] += val*fx[x]*fy[y];
+		}
+	}
+}
+
+/*---------------------------------------------------------------
+						getMarginalPhi
+  ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::getMarginalPhi(std::vector<double> &outMarginal, unsigned int level) const
+{
+	ASSERT_(level<=MAX_LEVEL)
+	outMarginal.assign(m_sizePhi<<level, 0);
+	for (TCells::const_iterator it=m_cells.begin();it!=m_cells.end();++it)
+	{
+		const TCellIndex &c = it->first;
+		if (c.level>=level)
+			outMarginal[ c.iphi>>(c.level-level) ] += it->second;
+		else
+		{
+			// Spread over the covered cells, in proportion to their length within the limits:
+			const unsigned int shift = level-c.level;
+			const int32_t n = 1<<shift;
+			const double s = getCellSizePhi(level);
+			vector<double> f(n);
+			double sum = 0;
+			for (int32_t i=0;i<n;i++)
+				sum += f[i] = intervalFraction(m_phiMin + ((c.iphi<<shift)+i)*s, s, m_phiMin, m_phiMax);
+			for (int32_t i=0;i<n;i++)
+				outMarginal[ (c.iphi<<shift)+i ] += it->second*f[i]/sum;
+		}
+	}
+}
+
+/*---------------------------------------------------------------
+						copyFrom
+  ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::copyFrom(const CPosePDF &o)
+{
+	if (this == &o) return;		// It may be used sometimes
+
+	if (IS_CLASS(&o, CPosePDFSparseGrid))
+		*this = *static_cast<const CPosePDFSparseGrid*>(&o);
+	else THROW_EXCEPTION("Not implemented yet!");
+}
+
+/*---------------------------------------------------------------
+						getMean
+ ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::getMean(CPose2D &p) const
+{
+	// Calc average on SE(2)
+	mrpt::poses::SE_average<2> se_averager;
+	CPose2D c;
+	for (TCells::const_iterator it=m_cells.begin();it!=m_cells.end();++it)
+	{
+		getCellCenter(it->first,c);
+		se_averager.append( c, it->second );
+	}
+	se_averager.get_average(p);
+}
+
+/*---------------------------------------------------------------
+						getCovarianceAndMean
+  ---------------------------------------------------------------*/
+void CPosePDFSparseGrid::getCovarianceAndMean(CMatrixDouble33 &cov, CPose2D &p) const
+{
+	getMean(p);
+
+	cov.zeros();
+	double SUM = 0;
+	CPose2D c;
+	for (TCells::const_iterator it=m_cells.begin();it!=m_cells.end();++it)
+	{
+		const double w = it->second;
+		getCellCenter(it->first,c);
+		const double d[3] = { c.x()-p.x(), c.y()-p.y(), wrapToPi(c.phi()-p.phi()) };
+		for (int i=0;i<3;i++)
+			for (int j=i;j<3;j++)
+				cov(i,j) += w*d[i]*d[j];
+
+		// The spread of the mass within the cell (uniform):
+		double lims[6];
+		getCellLimits(it->first,lims);
+		cov(0,0) += w*square(lims[1]-lims[0])/12;
+		cov(1,1) += w*square(lims[3]-lims[2])/12;
+		cov(2,2) += w*square(lims[5]-lims[4])/12;
+		SUM += w;
+	}
+	if (SUM>0)
+		cov *= 1.0/SUM;
+	cov(1,0) = cov(0,1); cov(2,0) = cov(0,2); cov(2,1) = cov(1,2);
+}
+
+/*---------------------------------------------------------------
+						writeToStream
+  ---------------------------------------------------------------*/
+void  CPosePDFSparseGrid::writeToStream(mrpt::utils::CStream &out,int *version) const
+{
+	if (version)
+		*version = 0;
+	else
+	{
+		out << m_xMin << m_xMax
+			<< m_yMin << m_yMax
+			<< m_phiMin << m_phiMax
+			<< m_resolutionXY << m_resolutionPhi;
+
+		out << static_cast<uint32_t>(m_cells.size());
+		for (TCells::const_iterator it=m_cells.begin();it!=m_cells.end();++it)
+			out << it->first.level << it->first.ix << it->first.iy << it->first.iphi << it->second;
+	}
+}
+
+/*---------------------------------------------------------------
+						readFromStream
+  ---------------------------------------------------------------*/
+void  CPosePDFSparseGrid::readFromStream(mrpt::utils::CStream &in, int version)
+{
+	switch(version)
+	{
+	case 0:
+		{
+			double xMin,xMax,yMin,yMax,phiMin,phiMax,resolutionXY,resolutionPhi;
+			in  >> xMin >> xMax
+				>> yMin >> yMax
+				>> phiMin >> phiMax
+				>> resolutionXY >> resolutionPhi;
+			setLimits(xMin,xMax,yMin,yMax,resolutionXY,resolutionPhi,phiMin,phiMax);  // The cells are read next
+
+			uint32_t nCells;
+			in >> nCells;
+			m_cells.clear();
+			for (uint32_t i=0;i<nCells;i++)
+			{
+				TCellIndex idx;
+				double mass;
+				in >> idx.level >> idx.ix >> idx.iy >> idx.iphi >> mass;
+				m_cells.insert( m_cells.end(), TCells::value_type(idx,mass) );
+			}
+		} break;
+	default:
+		MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
+
+	};
+}
+
+/*---------------------------------------------------------------
+						saveToTextFile
+  ---------------------------------------------------------------*/
+void  CPosePDFSparseGrid::saveToTextFile(const std::string &dataFile) const
+{
+	FILE *f = os::fopen(dataFile.c_str(),"wt");
+	if (!f) return;
+
+	CPose2D c;
+	for (TCells::const_iterator it=m_cells.begin();it!=m_cells.end();++it)
+	{
+		getCellCenter(it->first,c);
+		os::fprintf(f,"%u %i %i %i %f %f %f %.5e\n",
+			static_cast<unsigned int>(it->first.level), it->first.ix, it->first.iy, it->first.iphi,
+			c.x(), c.y(), c.phi(), it->second );
+	}
+	os::fclose(f);
+}
+
+/*---------------------------------------------------------------
+						changeCoordinatesReference
+  ---------------------------------------------------------------*/
+void  CPosePDFSparseGrid::changeCoordinatesReference(const CPose3D &newReferenceBase )
+{
+	MRPT_UNUSED_PARAM(newReferenceBase);
+	THROW_EXCEPTION("Not implemented yet!");
+}
+
+/*---------------------------------------------------------------
+					bayesianFusion
+ ---------------------------------------------------------------*/
+void  CPosePDFSparseGrid::bayesianFusion(const  CPosePDF &p1,const  CPosePDF &p2, const double &minMahalanobisDistToDrop )
+{
+	MRPT_UNUSED_PARAM(p1);MRPT_UNUSED_PARAM(p2);MRPT_UNUSED_PARAM(minMahalanobisDistToDrop);
+	THROW_EXCEPTION("Not implemented yet!");
+}
+
+/*---------------------------------------------------------------
+					inverse
+ ---------------------------------------------------------------*/
+void  CPosePDFSparseGrid::inverse(CPosePDF &o) const
+{
+	MRPT_UNUSED_PARAM(o);
+	THROW_EXCEPTION("Not implemented yet!");
+}
+
+/*---------------------------------------------------------------
+					drawSingleSample
+ ---------------------------------------------------------------*/
+void  CPosePDFSparseGrid::drawSingleSample( CPose2D &outPart ) const
+{
+	ASSERT_(!m_cells.empty())
+
+	double SUM = 0;
+	for (TCells::const_iterator it=m_cells.begin();it!=m_cells.end();++it)	SUM += it->second;
+
+	// Find the cell, without any temporary array:
+	const double r = randomGenerator.drawUniform(0,SUM);
+	double accum = 0;
+	TCells::const_iterator it;
+	for (it=m_cells.begin();it!=m_cells.end();++it)
+	{
+		accum += it->second;
+		if (r<accum) break;
+	}
+	if (it==m_cells.end()) --it;
+
+	// Uniform within the part of the cell within the limits:
+	double lims[6];
+	getCellLimits(it->first,lims);
+	outPart.x( randomGenerator.drawUniform(lims[0],lims[1]) );
+	outPart.y( randomGenerator.drawUniform(lims[2],lims[3]) );
+	outPart.phi( wrapToPi( randomGenerator.drawUniform(lims[4],lims[5]) ) );
+}
+
+/*---------------------------------------------------------------
+					drawManySamples
+ ---------------------------------------------------------------*/
+void  CPosePDFSparseGrid::drawManySamples(
+	size_t						N,
+	std::vector<CVectorDouble>	&outSamples ) const
+{
+	ASSERT_(!m_cells.empty())
+
+	// Cumulative mass of the cells:
+	vector<double> cumMass;
+	vector<TCellIndex> cells;
+	cumMass.reserve(m_cells.size());
+	cells.reserve(m_cells.size());
+	double SUM = 0;
+	for (TCells::const_iterator it=m_cells.begin();it!=m_cells.end();++it)
+	{
+		SUM += it->second;
+		cumMass.push_back(SUM);
+		cells.push_back(it->first);
+	}
+
+	outSamples.resize(N);
+	for (size_t i=0;i<N;i++)
+	{
+		const size_t k = std::min<size_t>( std::upper_bound(cumMass.begin(),cumMass.end(),randomGenerator.drawUniform(0,SUM)) - cumMass.begin(), cells.size()-1 );
+		double lims[6];
+		getCellLimits(cells[k],lims);
+
+		CVectorDouble &s = outSamples[i];
+		s.resize(3);
+		s[0] = randomGenerator.drawUniform(lims[0],lims[1]);
+		s[1] = randomGenerator.drawUniform(lims[2],lims[3]);
+		s[2] = wrapToPi( randomGenerator.drawUniform(lims[4],lims[5]) );
+	}
+}
@@ -0,0 +1,198 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/poses/CPosePDFSparseGrid.h>
+#include <mrpt/utils/CMemoryStream.h>
+#include <mrpt/math/wrap2pi.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+#include <numeric> // std::accumulate()
+
+using namespace mrpt;
+using namespace mrpt::poses;
+using namespace mrpt::utils;
+using namespace mrpt::math;
+using namespace std;
+
+namespace
+{
+	// A narrow Gaussian density, widened by the size of the evaluated cell:
+	struct TGaussianLikelihood
+	{
+		CPose2D mean;
+		double  std_xy, std_phi;
+
+		double operator()(const CPose2D &p, double cellSizeXY, double cellSizePhi) const
+		{
+			const double var_xy = square(std_xy) + square(cellSizeXY)/12;
+			const double var_phi = square(std_phi) + square(cellSizePhi)/12;
+			return exp( -0.5*( (square(p.x()-mean.x())+square(p.y()-mean.y()))/var_xy + square(wrapToPi(p.phi()-mean.phi()))/var_phi ) )
+				/ (var_xy*std::sqrt(var_phi));
+		}
+	};
+
+	// 20x20m with 1m x 45deg coarse cells, refined down to 3cm x 1.4deg:
+	void build_pdf(CPosePDFSparseGrid &pdf, TGaussianLikelihood &lik)
+	{
+		lik.mean = CPose2D(1.23,-0.71,0.4);
+		lik.std_xy = 0.05;
+		lik.std_phi = DEG2RAD(2.0);
+
+		pdf.setSize(-10,10,-10,10, 1.0, DEG2RAD(45));
+		pdf.computeFromLikelihood(lik, 5);
+	}
+}
+
+TEST(CPosePDFSparseGrid, CoarseToFine)
+{
+	CPosePDFSparseGrid pdf;
+	TGaussianLikelihood lik;
+	build_pdf(pdf,lik);
+
+	// A dense grid at the finest resolution would have 640x640x256 cells:
+	EXPECT_LT(pdf.size(), 20000u);
+
+	double SUM = 0;
+	unsigned int maxLevel = 0;
+	for (CPosePDFSparseGrid::TCells::const_iterator it=pdf.getCells().begin();it!=pdf.getCells().end();++it)
+	{
+		SUM += it->second;
+		maxLevel = std::max<unsigned int>(maxLevel, it->first.level);
+	}
+	EXPECT_NEAR(SUM, 1.0, 1e-9);
+	EXPECT_EQ(maxLevel, 5u);
+
+	CMatrixDouble33 cov;
+	CPose2D mean;
+	pdf.getCovarianceAndMean(cov,mean);
+	EXPECT_NEAR(mean.x(), lik.mean.x(), 0.01);
+	EXPECT_NEAR(mean.y(), lik.mean.y(), 0.01);
+	EXPECT_NEAR(wrapToPi(mean.phi()-lik.mean.phi()), 0, DEG2RAD(0.5));
+	EXPECT_NEAR(std::sqrt(cov(0,0)), lik.std_xy, 0.3*lik.std_xy);
+	EXPECT_NEAR(std::sqrt(cov(1,1)), lik.std_xy, 0.3*lik.std_xy);
+	EXPECT_NEAR(std::sqrt(cov(2,2)), lik.std_phi, 0.3*lik.std_phi);
+}
+
+TEST(CPosePDFSparseGrid, MarginalsAndSampling)
+{
+	CPosePDFSparseGrid pdf;
+	TGaussianLikelihood lik;
+	build_pdf(pdf,lik);
+
+	for (unsigned int level=2;level<=6;level+=2)
+	{
+		std::map<std::pair<int32_t,int32_t>,double> mXY;
+		pdf.getMarginalXY(mXY, level);
+		double SUM = 0, maxVal = 0;
+		std::pair<int32_t,int32_t> best;
+		for (std::map<std::pair<int32_t,int32_t>,double>::const_iterator it=mXY.begin();it!=mXY.end();++it)
+		{
+			SUM += it->second;
+			if (it->second>maxVal) { maxVal = it->second; best = it->first; }
+		}
+		EXPECT_NEAR(SUM, 1.0, 1e-9) << "level=" << level;
+
+		CPosePDFSparseGrid::TCellIndex idx;
+		ASSERT_TRUE(pdf.getCellIndex(lik.mean, level, idx));
+		EXPECT_LE(std::abs(best.first-idx.ix), 1) << "level=" << level;
+		EXPECT_LE(std::abs(best.second-idx.iy), 1) << "level=" << level;
+
+		std::vector<double> mPhi;
+		pdf.getMarginalPhi(mPhi, level);
+		ASSERT_EQ(mPhi.size(), pdf.getSizePhi()<<level);
+		EXPECT_NEAR(std::accumulate(mPhi.begin(),mPhi.end(),0.0), 1.0, 1e-9);
+		const int bestPhi = std::max_element(mPhi.begin(),mPhi.end()) - mPhi.begin();
+		EXPECT_LE(std::abs(bestPhi-idx.iphi), 1) << "level=" << level;
+	}
+
+	mrpt::random::randomGenerator.randomize(1234);
+	const size_t N = 5000;
+	std::vector<CVectorDouble> samples;
+	pdf.drawManySamples(N, samples);
+	ASSERT_EQ(samples.size(), N);
+	double mx=0, my=0, mphi=0;
+	for (size_t i=0;i<N;i++)
+	{
+		mx += samples[i][0]/N;
+		my += samples[i][1]/N;
+		mphi += samples[i][2]/N;
+	}
+	EXPECT_NEAR(mx, lik.mean.x(), 0.01);
+	EXPECT_NEAR(my, lik.mean.y(), 0.01);
+	EXPECT_NEAR(mphi, lik.mean.phi(), DEG2RAD(0.5));
+
+	CPose2D p;
+	pdf.drawSingleSample(p);
+	EXPECT_LT(p.distanceTo(lik.mean), 0.5);
+}
+
+TEST(CPosePDFSparseGrid, Serialization)
+{
+	CPosePDFSparseGrid pdf;
+	TGaussianLikelihood lik;
+	build_pdf(pdf,lik);
+
+	CMemoryStream buf;
+	buf << pdf;
+	buf.Seek(0);
+	CSerializablePtr obj;
+	buf >> obj;
+	ASSERT_TRUE(IS_CLASS(obj, CPosePDFSparseGrid));
+	const CPosePDFSparseGrid &pdf2 = *static_cast<CPosePDFSparseGrid*>(obj.pointer());
+
+	EXPECT_EQ(pdf2.getSizeX(), pdf.getSizeX());
+	EXPECT_EQ(pdf2.getSizePhi(), pdf.getSizePhi());
+	ASSERT_EQ(pdf2.size(), pdf.size());
+	EXPECT_TRUE(pdf2.getCells()==pdf.getCells());
+}
+
+TEST(CPosePDFSparseGrid, PartialBorderCells)
+{
+	// 2.5m in x with 1m cells: the last column of cells is half out of the limits.
+	// Angles in [0,2pi): the samples must be wrapped to [-pi,pi].
+	CPosePDFSparseGrid pdf(0,2.5, 0,2, 1.0, 0.5*M_PI, 0, 2*M_PI);
+	ASSERT_EQ(pdf.getSizeX(), 3u);
+
+	CPosePDFSparseGrid::TCellIndex inner(0,0,0,0), border(0,2,0,0);
+	EXPECT_NEAR(pdf.getCellVolumeFraction(border), 0.5, 1e-9);
+	EXPECT_NEAR(pdf.getCells().find(inner)->second, 1.0/(2.5*2*4), 1e-9);
+	EXPECT_NEAR(pdf.getCells().find(border)->second, 0.5/(2.5*2*4), 1e-9);
+
+	CPose2D c;
+	pdf.getCellCenter(border,c);
+	EXPECT_NEAR(c.x(), 2.25, 1e-9);
+
+	std::map<std::pair<int32_t,int32_t>,double> mXY;
+	pdf.getMarginalXY(mXY, 1);
+	double SUM = 0;
+	for (std::map<std::pair<int32_t,int32_t>,double>::const_iterator it=mXY.begin();it!=mXY.end();++it)
+	{
+		SUM += it->second;
+		EXPECT_LT(it->first.first, 5) << "Cell beyond xMax";
+		EXPECT_NEAR(it->second, 1.0/20, 1e-9);
+	}
+	EXPECT_NEAR(SUM, 1.0, 1e-9);
+
+	mrpt::random::randomGenerator.randomize(1234);
+	std::vector<CVectorDouble> samples;
+	pdf.drawManySamples(1000, samples);
+	for (size_t i=0;i<samples.size();i++)
+	{
+		EXPECT_LE(samples[i][0], 2.5);
+		EXPECT_LE(std::abs(samples[i][2]), M_PI);
+	}
+	for (int i=0;i<1000;i++)
+	{
+		CPose2D p;
+		pdf.drawSingleSample(p);
+		EXPECT_LE(p.x(), 2.5);
+		EXPECT_LE(std::abs(p.phi()), M_PI);
+		EXPECT_NEAR(p.phi(), wrapToPi(p.phi()), 1e-12);
+	}
+}
@@ -17,6 +17,8 @@
 #include <mrpt/poses/CPose3DPDFParticles.h>
 #include <mrpt/poses/CPose3DPDFSOG.h>
 #include <mrpt/random.h>
+#include <mrpt/math/wrap2pi.h>
+#include <algorithm>
 
 using namespace mrpt;
 using namespace mrpt::math;
@@ -156,17 +158,22 @@ void CPoseRandomSampler::setPosePDF( const CPosePDFPtr &pdf ) {
                     drawSample
   ---------------------------------------------------------------*/
 CPose2D & CPoseRandomSampler::drawSample( CPose2D &p ) const
+{
+	return drawSample(p,randomGenerator);
+}
+
+CPose2D & CPoseRandomSampler::drawSample( CPose2D &p, CRandomGenerator &rng ) const
 {
     MRPT_START
 
 	if (m_pdf2D)
 	{
-		do_sample_2D(p);
+		do_sample_2D(p,rng);
 	}
 	else if (m_pdf3D)
 	{
 		CPose3D  q;
-		do_sample_3D(q);
+		do_sample_3D(q,rng);
 		p.x(q.x());
 		p.y(q.y());
 		p.phi(q.yaw());
@@ -181,18 +188,23 @@ CPose2D & CPoseRandomSampler::drawSample( CPose2D &p ) const
                     drawSample
   ---------------------------------------------------------------*/
 CPose3D & CPoseRandomSampler::drawSample( CPose3D &p ) const
+{
+	return drawSample(p,randomGenerator);
+}
+
+CPose3D & CPoseRandomSampler::drawSample( CPose3D &p, CRandomGenerator &rng ) const
 {
     MRPT_START
 
 	if (m_pdf2D)
 	{
 		CPose2D q;
-		do_sample_2D(q);
+		do_sample_2D(q,rng);
 		p.setFromValues(q.x(),q.y(),0,q.phi(),0,0);
 	}
 	else if (m_pdf3D)
 	{
-		do_sample_3D(p);
+		do_sample_3D(p,rng);
 	}
 	else THROW_EXCEPTION("No associated pdf: setPosePDF must be called first.");
 
@@ -200,11 +212,83 @@ CPose3D & CPoseRandomSampler::drawSample( CPose3D &p ) const
     MRPT_END
 }
 
+/*---------------------------------------------------------------
+                    drawSamples
+  ---------------------------------------------------------------*/
+void CPoseRandomSampler::drawSamples( size_t N, std::vector<double> &out_x, std::vector<double> &out_y, std::vector<double> &out_phi, CRandomGenerator &rng ) const
+{
+	MRPT_START
+
+	out_x.resize(N);
+	out_y.resize(N);
+	out_phi.resize(N);
+	if (!N) return;
+
+	double *x = &out_x[0], *y = &out_y[0], *phi = &out_phi[0];
+
+	if (m_pdf2D && IS_CLASS(m_pdf2D,CPosePDFGaussian) )
+	{
+		// Draw all the normalized gaussian values first, then transform them with Z3 in one loop:
+		for (size_t i=0;i<N;i++) x[i] = rng.drawGaussian1D_normalized();
+		for (size_t i=0;i<N;i++) y[i] = rng.drawGaussian1D_normalized();
+		for (size_t i=0;i<N;i++) phi[i] = rng.drawGaussian1D_normalized();
+
+		const CMatrixDouble33 &Z = m_fastdraw_gauss_Z3;
+		const double Z00=Z.get_unsafe(0,0), Z01=Z.get_unsafe(0,1), Z02=Z.get_unsafe(0,2);
+		const double Z10=Z.get_unsafe(1,0), Z11=Z.get_unsafe(1,1), Z12=Z.get_unsafe(1,2);
+		const double Z20=Z.get_unsafe(2,0), Z21=Z.get_unsafe(2,1), Z22=Z.get_unsafe(2,2);
+		const double mx = m_fastdraw_gauss_M_2D.x(), my = m_fastdraw_gauss_M_2D.y(), mphi = m_fastdraw_gauss_M_2D.phi();
+		for (size_t i=0;i<N;i++)
+		{
+			const double r0 = x[i], r1 = y[i], r2 = phi[i];
+			x[i]   = mx   + Z00*r0 + Z01*r1 + Z02*r2;
+			y[i]   = my   + Z10*r0 + Z11*r1 + Z12*r2;
+			phi[i] = mphi + Z20*r0 + Z21*r1 + Z22*r2;
+		}
+		for (size_t i=0;i<N;i++)
+			mrpt::math::wrapToPiInPlace(phi[i]);
+	}
+	else if (m_pdf2D && IS_CLASS(m_pdf2D,CPosePDFParticles) )
+	{
+		// Particles (e.g. Thrun's odometry model): one cumulative sum, then a binary search per sample:
+		const CPosePDFParticles* pdf = static_cast<const CPosePDFParticles*>(m_pdf2D);
+		ASSERT_(!pdf->m_particles.empty())
+		const size_t M = pdf->m_particles.size();
+		std::vector<double> cum_w(M);
+		double cum = 0;
+		for (size_t j=0;j<M;j++)
+			cum_w[j] = (cum+= exp(pdf->m_particles[j].log_w));
+
+		for (size_t i=0;i<N;i++)
+		{
+			const size_t j = std::min<size_t>(M-1, std::upper_bound(cum_w.begin(),cum_w.end(), rng.drawUniform(0.0,cum) ) - cum_w.begin() );
+			const CPose2D &p = *pdf->m_particles[j].d;
+			x[i] = p.x();
+			y[i] = p.y();
+			phi[i] = p.phi();
+		}
+	}
+	else
+	{
+		// Generic case, one sample at a time:
+		CPose2D p;
+		for (size_t i=0;i<N;i++)
+		{
+			drawSample(p,rng);
+			x[i] = p.x();
+			y[i] = p.y();
+			phi[i] = p.phi();
+		}
+	}
+
+	MRPT_END
+}
+
 
 /*---------------------------------------------------------------
                   do_sample_2D: Sample from a 2D PDF
   ---------------------------------------------------------------*/
-void CPoseRandomSampler::do_sample_2D( CPose2D &p ) const
+void CPoseRandomSampler::do_sample_2D( CPose2D &p, CRandomGenerator &rng ) const
 {
 	MRPT_START
 	ASSERT_(m_pdf2D);
@@ -219,7 +303,7 @@ void CPoseRandomSampler::do_sample_2D( CPose2D &p ) const
 		rndVector.setZero();
 		for (size_t i=0;i<3;i++)
 		{
-			double	rnd = randomGenerator.drawGaussian1D_normalized();
+			double	rnd = rng.drawGaussian1D_normalized();
 			for (size_t d=0;d<3;d++)
 				rndVector[d]+= ( m_fastdraw_gauss_Z3.get_unsafe(d,i)*rnd );
 		}
@@ -243,8 +327,22 @@ void CPoseRandomSampler::do_sample_2D( CPose2D &p ) const
 		// -------------------------------------
 		//      Particles: just sample as usual
 		// -------------------------------------
+		// (As in drawSamples(): the weights need not be normalized, e.g. all log_w=0 after resetDeterministic())
 		const CPosePDFParticles* pdf = static_cast<const CPosePDFParticles*>(m_pdf2D);
-		pdf->drawSingleSample(p);
+		ASSERT_(!pdf->m_particles.empty())
+		CPosePDFParticles::CParticleList::const_iterator it;
+		double total_w = 0;
+		for (it=pdf->m_particles.begin();it!=pdf->m_particles.end();++it)
+			total_w+= exp(it->log_w);
+		const double uni = rng.drawUniform(0.0,total_w);
+		double cum = 0;
+		for (it=pdf->m_particles.begin();it!=pdf->m_particles.end();++it)
+		{
+			cum+= exp(it->log_w);
+			if (uni<cum) break;
+		}
+		if (it==pdf->m_particles.end()) --it; // Might not come here normally
+		p = *it->d;
 	}
 	else
 		THROW_EXCEPTION_CUSTOM_MSG1("Unsoported class: %s", m_pdf2D->GetRuntimeClass()->className );
@@ -255,7 +353,7 @@ void CPoseRandomSampler::do_sample_2D( CPose2D &p ) const
 /*---------------------------------------------------------------
                   do_sample_3D: Sample from a 3D PDF
   ---------------------------------------------------------------*/
-void CPoseRandomSampler::do_sample_3D( CPose3D &p ) const
+void CPoseRandomSampler::do_sample_3D( CPose3D &p, CRandomGenerator &rng ) const
 {
 	MRPT_START
 	ASSERT_(m_pdf3D);
@@ -270,7 +368,7 @@ void CPoseRandomSampler::do_sample_3D( CPose3D &p ) const
 		rndVector.setZero();
 		for (size_t i=0;i<6;i++)
 		{
-			double	rnd = randomGenerator.drawGaussian1D_normalized();
+			double	rnd = rng.drawGaussian1D_normalized();
 			for (size_t d=0;d<6;d++)
 				rndVector[d]+= ( m_fastdraw_gauss_Z6.get_unsafe(d,i)*rnd );
 		}
@@ -0,0 +1,135 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/poses/CPoseRandomSampler.h>
+#include <mrpt/poses/CPosePDFParticles.h>
+#include <mrpt/poses/CPosePDFGaussian.h>
+#include <mrpt/poses/CPose3DPDFGaussian.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::poses;
+using namespace mrpt::random;
+using namespace mrpt::math;
+using namespace std;
+
+namespace
+{
+	// Histogram of the particle index (the particle "k" is at x=k) of N samples, drawn one by one or all at once:
+	void sample_histogram(const CPoseRandomSampler &sampler, size_t M, size_t N, bool all_at_once, CRandomGenerator &rng, std::vector<double> &freqs)
+	{
+		freqs.assign(M,0);
+		if (all_at_once)
+		{
+			std::vector<double> xs,ys,phis;
+			sampler.drawSamples(N, xs,ys,phis, rng);
+			ASSERT_EQ(xs.size(),N);
+			for (size_t i=0;i<N;i++)
+				freqs[ static_cast<size_t>(xs[i]+0.5) ] += 1.0/N;
+		}
+		else
+		{
+			CPose2D p;
+			for (size_t i=0;i<N;i++)
+			{
+				sampler.drawSample(p,rng);
+				freqs[ static_cast<size_t>(p.x()+0.5) ] += 1.0/N;
+			}
+		}
+	}
+
+	void test_unnormalized_weights(const std::vector<double> &log_w)
+	{
+		const size_t M = log_w.size(), N = 50000;
+		CPosePDFParticles pdf(M);
+		double sum_w = 0;
+		for (size_t k=0;k<M;k++)
+		{
+			*pdf.m_particles[k].d = CPose2D(k,0,0);
+			pdf.m_particles[k].log_w = log_w[k];
+			sum_w += exp(log_w[k]);
+		}
+
+		CPoseRandomSampler sampler;
+		sampler.setPosePDF(pdf);
+
+		CRandomGenerator rng(1234);
+		std::vector<double> freqs_one, freqs_all;
+		sample_histogram(sampler,M,N,false,rng,freqs_one);
+		sample_histogram(sampler,M,N,true,rng,freqs_all);
+
+		for (size_t k=0;k<M;k++)
+		{
+			const double expected = exp(log_w[k])/sum_w;
+			EXPECT_NEAR(freqs_one[k],expected,0.01) << "k=" << k;
+			EXPECT_NEAR(freqs_all[k],expected,0.01) << "k=" << k;
+		}
+	}
+
+	// Samples drawn with drawSample(p,rng) must only depend on "rng", and leave the global generator untouched:
+	void test_draws_from_given_generator(const CPoseRandomSampler &sampler, const std::string &msg)
+	{
+		const size_t N = 20;
+		std::vector<CPose3D> samples[2];
+		for (int run=0;run<2;run++)
+		{
+			randomGenerator.randomize(run==0 ? 1:2);  // Different global state in each run
+			CRandomGenerator rng(1234);
+			for (size_t i=0;i<N;i++)
+			{
+				CPose2D p2;
+				CPose3D p3;
+				sampler.drawSample(p2,rng);
+				sampler.drawSample(p3,rng);
+				samples[run].push_back(CPose3D(p2));
+				samples[run].push_back(p3);
+			}
+
+			CRandomGenerator fresh_global(run==0 ? 1:2);
+			EXPECT_EQ(randomGenerator.drawUniform32bit(), fresh_global.drawUniform32bit()) << msg << ": the global generator was used";
+		}
+		for (size_t i=0;i<samples[0].size();i++)
+			EXPECT_EQ(samples[0][i], samples[1][i]) << msg << " i=" << i;
+	}
+}
+
+TEST(CPoseRandomSampler, ParticlesEqualUnnormalizedWeights)
+{
+	// As after CPosePDFParticles::resetDeterministic(), or in Thrun's odometry model:
+	test_unnormalized_weights(std::vector<double>(5,0.0));
+}
+
+TEST(CPoseRandomSampler, ParticlesDifferentUnnormalizedWeights)
+{
+	std::vector<double> log_w(4);
+	for (size_t k=0;k<log_w.size();k++) log_w[k] = log(1.0+k);  // Weights 1,2,3,4
+	test_unnormalized_weights(log_w);
+}
+
+TEST(CPoseRandomSampler, DrawSampleUsesGivenGenerator)
+{
+	CMatrixDouble33 cov2;
+	cov2(0,0)=cov2(1,1)=0.1; cov2(2,2)=0.05;
+	CMatrixDouble66 cov3;
+	for (int i=0;i<6;i++) cov3(i,i) = 0.1;
+
+	CPoseRandomSampler sampler;
+	sampler.setPosePDF( CPosePDFGaussian(CPose2D(1,2,0.3),cov2) );
+	test_draws_from_given_generator(sampler,"CPosePDFGaussian");
+
+	sampler.setPosePDF( CPose3DPDFGaussian(CPose3D(1,2,3,0.1,0.2,0.3),cov3) );
+	test_draws_from_given_generator(sampler,"CPose3DPDFGaussian");
+
+	CPosePDFParticles parts(10);
+	for (size_t k=0;k<parts.m_particles.size();k++)
+		*parts.m_particles[k].d = CPose2D(k,-double(k),0.1*k);
+	sampler.setPosePDF(parts);
+	test_draws_from_given_generator(sampler,"CPosePDFParticles");
+}
@@ -106,6 +106,7 @@ void CRandomGenerator::randomize(const uint32_t seed)
 {
 	MT19937_initializeGenerator(seed);
 	m_MT19937_data.index = 0;
+	m_std_gauss_set = false;  // Discard the second Gaussian sample cached from the previous seed
 }
 
 /*---------------------------------------------------------------
@@ -115,6 +116,7 @@ void CRandomGenerator::randomize()
 {
 	MT19937_initializeGenerator( static_cast<uint32_t>(mrpt::system::getCurrentTime()) );
 	m_MT19937_data.index = 0;
+	m_std_gauss_set = false;  // Discard the second Gaussian sample cached from the previous seed
 }
 
 /*---------------------------------------------------------------
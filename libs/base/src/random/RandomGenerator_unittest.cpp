@@ -0,0 +1,25 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt::random;
+
+TEST(CRandomGenerator, SameSeedSameGaussianSamples)
+{
+	// An odd number of Gaussian samples leaves the second one of the last pair cached: it must be discarded by randomize()
+	CRandomGenerator rng(1234);
+	rng.drawGaussian1D_normalized();
+	rng.randomize(5678);
+
+	CRandomGenerator fresh(5678);
+	for (int i=0;i<10;i++)
+		EXPECT_EQ(rng.drawGaussian1D_normalized(), fresh.drawGaussian1D_normalized()) << "i=" << i;
+}
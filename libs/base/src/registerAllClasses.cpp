@@ -74,6 +74,7 @@ void registerAllClasses_mrpt_base()
 	registerClass( CLASS_ID( CPosePDFGaussianInf ) );
 	registerClass( CLASS_ID( CPosePDFParticles ) );
 	registerClass( CLASS_ID( CPosePDFGrid ) );
+	registerClass( CLASS_ID( CPosePDFSparseGrid ) );
 	registerClass( CLASS_ID( CPosePDFSOG ) );
 
 	registerClass( CLASS_ID( CPointPDF ) );
@@ -0,0 +1,117 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/system/CGenericMemoryPool.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::system;
+using namespace std;
+
+namespace
+{
+	struct TTestPoolParams
+	{
+		size_t len;
+		bool isSuitable(const TTestPoolParams &req) const { return len==req.len; }
+	};
+
+	// A block which counts how many of them are alive, to check that the pool frees them:
+	struct TTestPoolData
+	{
+		static int num_alive;
+		std::vector<char> buf;
+		explicit TTestPoolData(size_t len) : buf(len) { ++num_alive; }
+		~TTestPoolData() { --num_alive; }
+	};
+	int TTestPoolData::num_alive = 0;
+
+	typedef CGenericMemoryPool<TTestPoolParams,TTestPoolData> TTestPool;
+
+	TTestPoolParams params(size_t len) { TTestPoolParams p; p.len = len; return p; }
+
+	// Empties the (global) pool and sets its maximum size:
+	TTestPool *reset_pool(size_t max_size)
+	{
+		TTestPool *pool = TTestPool::getInstance();
+		pool->setMemoryPoolMaxSize(0);
+		pool->setMemoryPoolMaxSize(max_size);
+		EXPECT_EQ(TTestPoolData::num_alive, 0);
+		return pool;
+	}
+}
+
+TEST(CGenericMemoryPool, ReusesSuitableBlocks)
+{
+	TTestPool *pool = reset_pool(5);
+
+	TTestPoolData *a = new TTestPoolData(10), *b = new TTestPoolData(20);
+	pool->dump_to_pool(params(10),a);
+	pool->dump_to_pool(params(20),b);
+	EXPECT_EQ(pool->getMemoryPoolSize(), 2u);
+
+	EXPECT_TRUE(pool->request_memory(params(30))==NULL);
+	TTestPoolData *c = pool->request_memory(params(20));
+	EXPECT_EQ(c, b);
+	EXPECT_EQ(pool->getMemoryPoolSize(), 1u);
+	delete c;
+
+	pool->setMemoryPoolMaxSize(0);
+	EXPECT_EQ(TTestPoolData::num_alive, 0);
+}
+
+TEST(CGenericMemoryPool, KeepsAtMostMaxSizeBlocks)
+{
+	TTestPool *pool = reset_pool(3);
+	for (size_t i=0;i<5;i++)
+		pool->dump_to_pool(params(i),new TTestPoolData(i));
+	EXPECT_EQ(pool->getMemoryPoolSize(), 3u);
+	EXPECT_EQ(TTestPoolData::num_alive, 3);
+
+	// The oldest blocks are those freed:
+	EXPECT_TRUE(pool->request_memory(params(1))==NULL);
+	TTestPoolData *d = pool->request_memory(params(4));
+	EXPECT_TRUE(d!=NULL);
+	delete d;
+
+	pool->setMemoryPoolMaxSize(0);
+	EXPECT_EQ(TTestPoolData::num_alive, 0);
+}
+
+TEST(CGenericMemoryPool, setMemoryPoolMaxSizeFreesExtraBlocks)
+{
+	TTestPool *pool = reset_pool(5);
+	for (size_t i=0;i<5;i++)
+		pool->dump_to_pool(params(i),new TTestPoolData(i));
+	EXPECT_EQ(TTestPoolData::num_alive, 5);
+
+	pool->setMemoryPoolMaxSize(2);
+	EXPECT_EQ(pool->getMemoryPoolMaxSize(), 2u);
+	EXPECT_EQ(pool->getMemoryPoolSize(), 2u);
+	EXPECT_EQ(TTestPoolData::num_alive, 2);
+
+	// The newest ones are kept:
+	for (size_t i=3;i<5;i++)
+	{
+		TTestPoolData *d = pool->request_memory(params(i));
+		EXPECT_TRUE(d!=NULL) << "i=" << i;
+		delete d;
+	}
+	EXPECT_EQ(TTestPoolData::num_alive, 0);
+}
+
+TEST(CGenericMemoryPool, ZeroMaxSizeDisablesPool)
+{
+	TTestPool *pool = reset_pool(0);
+	pool->dump_to_pool(params(10),new TTestPoolData(10));
+	pool->dump_to_pool(params(10),new TTestPoolData(10));
+	EXPECT_EQ(pool->getMemoryPoolSize(), 0u);
+	EXPECT_EQ(TTestPoolData::num_alive, 0);
+	EXPECT_TRUE(pool->request_memory(params(10))==NULL);
+}
@@ -0,0 +1,76 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/system/threads.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace std;
+
+struct TAuxMarkVisited
+{
+	std::vector<int> &visits;
+	std::vector<size_t> &block_sizes;
+
+	TAuxMarkVisited(std::vector<int> &v, std::vector<size_t> &bs) : visits(v), block_sizes(bs) {}
+
+	void operator()(size_t first, size_t last, unsigned int block_index)
+	{
+		for (size_t i=first;i<last;i++)
+			visits[i]++;
+		block_sizes[block_index] = last-first;
+	}
+};
+
+TEST(Threads, parallelForBlocks)
+{
+	const size_t N = 1003;
+	for (unsigned int nThreads=1;nThreads<=8;nThreads++)
+	{
+		std::vector<int> visits(N,0);
+		std::vector<size_t> block_sizes(nThreads,0);
+		TAuxMarkVisited f(visits,block_sizes);
+
+		const unsigned int nBlocks = mrpt::system::parallelForBlocks(N,f,nThreads);
+		EXPECT_EQ(nBlocks,nThreads);
+
+		size_t total = 0;
+		for (unsigned int i=0;i<nBlocks;i++) total+=block_sizes[i];
+		EXPECT_EQ(total,N);
+
+		for (size_t i=0;i<N;i++)
+			EXPECT_EQ(visits[i],1) << "Index " << i << " with nThreads=" << nThreads;
+	}
+}
+
+TEST(Threads, parallelForBlocksFewElements)
+{
+	std::vector<int> visits(2,0);
+	std::vector<size_t> block_sizes(16,0);
+	TAuxMarkVisited f(visits,block_sizes);
+
+	EXPECT_EQ(mrpt::system::parallelForBlocks(0,f,4), 0u);
+	EXPECT_EQ(mrpt::system::parallelForBlocks(2,f,16), 2u);
+	EXPECT_EQ(visits[0],1);
+	EXPECT_EQ(visits[1],1);
+}
+
+struct TAuxThrow
+{
+	void operator()(size_t first, size_t last, unsigned int block_index)
+	{
+		if (block_index==1) throw std::runtime_error("error in block #1");
+	}
+};
+
+TEST(Threads, parallelForBlocksRethrows)
+{
+	TAuxThrow f;
+	EXPECT_THROW(mrpt::system::parallelForBlocks(10,f,2), std::exception);
+}
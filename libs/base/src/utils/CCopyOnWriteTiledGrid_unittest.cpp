@@ -0,0 +1,96 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/utils/CCopyOnWriteTiledGrid.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt::utils;
+
+typedef CCopyOnWriteTiledGrid<int,3> grid_t; // 8x8 tiles
+
+TEST(CCopyOnWriteTiledGrid, ReadWrite)
+{
+	grid_t g;
+	g.resize(20,13,7);
+	EXPECT_EQ(g.getTilesCountX(),3u);
+	EXPECT_EQ(g.getTilesCountY(),2u);
+	for (size_t y=0;y<13;y++)
+		for (size_t x=0;x<20;x++)
+			EXPECT_EQ(g(x,y),7);
+
+	for (size_t y=0;y<13;y++)
+		for (size_t x=0;x<20;x++)
+			g.cellForWrite(x,y) = int(x+100*y);
+	for (size_t y=0;y<13;y++)
+		for (size_t x=0;x<20;x++)
+			EXPECT_EQ(g(x,y),int(x+100*y));
+
+	std::vector<int> row(20);
+	g.getRow(11,&row[0]);
+	for (size_t x=0;x<20;x++)
+		EXPECT_EQ(row[x],int(x+1100));
+	for (size_t x=0;x<20;x++) row[x] = -int(x);
+	g.setRow(12,&row[0]);
+	for (size_t x=0;x<20;x++)
+		EXPECT_EQ(g(x,12),-int(x));
+}
+
+TEST(CCopyOnWriteTiledGrid, CopyOnWrite)
+{
+	grid_t g1;
+	g1.resize(32,32,0);
+	for (size_t y=0;y<32;y++)
+		for (size_t x=0;x<32;x++)
+			g1.cellForWrite(x,y) = int(x+y);
+	for (size_t ty=0;ty<4;ty++)
+		for (size_t tx=0;tx<4;tx++)
+			EXPECT_FALSE(g1.isTileShared(tx,ty));
+
+	grid_t g2(g1);
+	EXPECT_TRUE(g1.isTileShared(0,0));
+	EXPECT_TRUE(g2.isTileShared(0,0));
+	EXPECT_EQ(g1.getTile(2,3),g2.getTile(2,3));
+
+	// Writing into one tile only duplicates that tile:
+	g2.cellForWrite(9,17) = -1;
+	EXPECT_FALSE(g2.isTileShared(1,2));
+	EXPECT_FALSE(g1.isTileShared(1,2));
+	EXPECT_NE(g1.getTile(1,2),g2.getTile(1,2));
+	EXPECT_EQ(g1.getTile(2,3),g2.getTile(2,3));
+	EXPECT_EQ(g1(9,17),26);
+	EXPECT_EQ(g2(9,17),-1);
+
+	// Releasing the copy leaves the original unique again:
+	g2.clear();
+	EXPECT_FALSE(g1.isTileShared(2,3));
+	EXPECT_EQ(g1(31,31),62);
+}
+
+TEST(CCopyOnWriteTiledGrid, ResizeKeepingContents)
+{
+	for (int aligned=0;aligned<2;aligned++)
+	{
+		grid_t g;
+		g.resize(10,5,1);
+		for (size_t y=0;y<5;y++)
+			for (size_t x=0;x<10;x++)
+				g.cellForWrite(x,y) = int(10+x+100*y);
+
+		const size_t ox = aligned ? 16:5, oy = aligned ? 8:3;
+		g.resize(40,30,ox,oy,-7);
+		ASSERT_EQ(g.getSizeX(),40u);
+		ASSERT_EQ(g.getSizeY(),30u);
+		for (size_t y=0;y<30;y++)
+			for (size_t x=0;x<40;x++)
+			{
+				const bool old = x>=ox && x<ox+10 && y>=oy && y<oy+5;
+				EXPECT_EQ(g(x,y), old ? int(10+(x-ox)+100*(y-oy)) : -7) << "x=" << x << " y=" << y << " aligned=" << aligned;
+			}
+	}
+}
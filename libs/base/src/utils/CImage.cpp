@@ -60,6 +60,131 @@ std::string CImage::IMAGES_PATH_BASE(".");
 mrpt::utils::CTimeLogger alloc_tims;
 #endif
 
+// Whether to keep the buffers of released images in a pool, for reuse by new images:
+#define CIMAGE_USE_MEMPOOL
+
+#if MRPT_HAS_OPENCV
+#ifdef CIMAGE_USE_MEMPOOL
+#	include <mrpt/system/CGenericMemoryPool.h>
+
+	// Memory pool for the IplImage's of CImage ----------------
+	struct CImage_MemPoolParams
+	{
+		int width,height,depth,nChannels;
+		inline bool isSuitable(const CImage_MemPoolParams &req) const {
+			return width==req.width && height==req.height && depth==req.depth && nChannels==req.nChannels;
+		}
+	};
+	struct CImage_MemPoolData
+	{
+		IplImage *ipl;
+		explicit CImage_MemPoolData(IplImage *i) : ipl(i) { }
+		~CImage_MemPoolData() { if (ipl) cvReleaseImage(&ipl); }
+	private:
+		CImage_MemPoolData(const CImage_MemPoolData &);
+		CImage_MemPoolData & operator =(const CImage_MemPoolData &);
+	};
+	typedef mrpt::system::CGenericMemoryPool<CImage_MemPoolParams,CImage_MemPoolData> TMyImageMemPool;
+
+	const size_t CIMAGE_MEMPOOL_DEFAULT_SIZE = 8;
+#endif
+
+// Like cvCreateImage(), but taking the buffer from the pool if one with the same size & format is available.
+IplImage *ipl_create_image(const CvSize size, const int depth, const int nChannels)
+{
+#ifdef CIMAGE_USE_MEMPOOL
+	TMyImageMemPool *pool = TMyImageMemPool::getInstance(CIMAGE_MEMPOOL_DEFAULT_SIZE);
+	if (pool)
+	{
+		CImage_MemPoolParams mem_params;
+		mem_params.width = size.width;
+		mem_params.height = size.height;
+		mem_params.depth = depth;
+		mem_params.nChannels = nChannels;
+
+		CImage_MemPoolData *mem_block = pool->request_memory(mem_params);
+		if (mem_block)
+		{
+			IplImage *ipl = mem_block->ipl;
+			mem_block->ipl = NULL;
+			delete mem_block;
+			return ipl;
+		}
+	}
+#endif
+	return cvCreateImage(size,depth,nChannels);
+}
+
+// Like cvReleaseImage(), but donating the buffer to the pool, if enabled.
+void ipl_release_image(IplImage *ipl)
+{
+#ifdef CIMAGE_USE_MEMPOOL
+	TMyImageMemPool *pool = TMyImageMemPool::getInstance(CIMAGE_MEMPOOL_DEFAULT_SIZE);
+	// Only images owning an interleaved pixel buffer are recycled:
+	if (pool && pool->getMemoryPoolMaxSize()>0 && ipl->imageDataOrigin!=NULL && ipl->dataOrder==IPL_DATA_ORDER_PIXEL && !ipl->maskROI && !ipl->tileInfo)
+	{
+		// Restore the header to that of a newly created image:
+		if (ipl->roi) cvResetImageROI(ipl);
+		ipl->origin = IPL_ORIGIN_TL;
+		if (ipl->nChannels==1)      { memcpy(ipl->colorModel,"GRAY",4); memcpy(ipl->channelSeq,"GRAY",4); }
+		else if (ipl->nChannels==3) { memcpy(ipl->colorModel,"RGB\0",4); memcpy(ipl->channelSeq,"BGR\0",4); }
+
+		CImage_MemPoolParams mem_params;
+		mem_params.width = ipl->width;
+		mem_params.height = ipl->height;
+		mem_params.depth = ipl->depth;
+		mem_params.nChannels = ipl->nChannels;
+		pool->dump_to_pool(mem_params, new CImage_MemPoolData(ipl));
+		return;
+	}
+#endif
+	cvReleaseImage(&ipl);
+}
+
+// Like cvCloneImage(), but using the pool of buffers.
+IplImage *ipl_clone_image(const IplImage *src)
+{
+	if (src->roi || src->dataOrder!=IPL_DATA_ORDER_PIXEL)
+		return cvCloneImage(src);
+	IplImage *ipl = ipl_create_image(cvGetSize(src),src->depth,src->nChannels);
+	cvCopy(src,ipl);
+	ipl->origin = src->origin;
+	memcpy(ipl->colorModel,src->colorModel,4);
+	memcpy(ipl->channelSeq,src->channelSeq,4);
+	return ipl;
+}
+#endif
+
+void CImage::setImageBuffersPoolMaxSize(size_t max_buffers)
+{
+#if MRPT_HAS_OPENCV && defined(CIMAGE_USE_MEMPOOL)
+	TMyImageMemPool *pool = TMyImageMemPool::getInstance(CIMAGE_MEMPOOL_DEFAULT_SIZE);
+	if (pool) pool->setMemoryPoolMaxSize(max_buffers);
+#else
+	MRPT_UNUSED_PARAM(max_buffers);
+#endif
+}
+
+size_t CImage::getImageBuffersPoolMaxSize()
+{
+#if MRPT_HAS_OPENCV && defined(CIMAGE_USE_MEMPOOL)
+	TMyImageMemPool *pool = TMyImageMemPool::getInstance(CIMAGE_MEMPOOL_DEFAULT_SIZE);
+	return pool ? pool->getMemoryPoolMaxSize() : 0;
+#else
+	return 0;
+#endif
+}
+
+size_t CImage::getImageBuffersPoolSize()
+{
+#if MRPT_HAS_OPENCV && defined(CIMAGE_USE_MEMPOOL)
+	TMyImageMemPool *pool = TMyImageMemPool::getInstance(CIMAGE_MEMPOOL_DEFAULT_SIZE);
+	return pool ? pool->getMemoryPoolSize() : 0;
+#else
+	return 0;
+#endif
+}
+
 /*---------------------------------------------------------------
 						Constructor
  ---------------------------------------------------------------*/
@@ -110,6 +235,22 @@ CImage& CImage::operator = (const CImage& o)
 {
 	MRPT_START
 	if (this==&o) return *this;
+#if MRPT_HAS_OPENCV
+	if (!o.m_imgIsExternalStorage && o.img)
+	{
+		// Same size & format: just copy the pixels, reusing our buffer:
+		const IplImage *ipl_src = static_cast<const IplImage*>(o.img);
+		IplImage *ipl_dst = (ipl_src->depth==IPL_DEPTH_8U && !ipl_src->roi) ? static_cast<IplImage*>(getReusableIplImage(ipl_src->width,ipl_src->height,ipl_src->nChannels)) : NULL;
+		if (ipl_dst)
+		{
+			cvCopy(ipl_src,ipl_dst);
+			ipl_dst->origin = ipl_src->origin;
+			memcpy(ipl_dst->colorModel,ipl_src->colorModel,4);
+			memcpy(ipl_dst->channelSeq,ipl_src->channelSeq,4);
+			return *this;
+		}
+	}
+#endif
 	releaseIpl();
 	m_imgIsExternalStorage = o.m_imgIsExternalStorage;
 	m_imgIsReadOnly = false;
@@ -118,7 +259,7 @@ CImage& CImage::operator = (const CImage& o)
 	{ 	// A normal image
 #if MRPT_HAS_OPENCV
 		ASSERTMSG_(o.img!=NULL,"Source image in = operator has NULL IplImage*")
-		img = cvCloneImage( (IplImage*)o.img );
+		img = ipl_clone_image( (IplImage*)o.img );
 #endif
 	}
 	else
@@ -209,7 +350,7 @@ CImage::CImage( void *iplImage ) :
 	if (!iplImage)
 		changeSize( 1, 1, 1, true );
 	else
-		img = cvCloneImage( (IplImage*) iplImage );
+		img = ipl_clone_image( (IplImage*) iplImage );
 #endif
 	MRPT_END
 }
@@ -257,7 +398,7 @@ void  CImage::changeSize(
 	alloc_tims.enter(sLog.c_str());
 #	endif
 
-	img = cvCreateImage( cvSize(width,height),IPL_DEPTH_8U, nChannels );
+	img = ipl_create_image( cvSize(width,height),IPL_DEPTH_8U, nChannels );
 	((IplImage*)img)->origin = originTopLeft ? 0:1;
 
 #	if IMAGE_ALLOC_PERFLOG
@@ -329,7 +470,7 @@ void  CImage::loadFromIplImage( void* iplImage )
 	if (iplImage)
 	{
 #if MRPT_HAS_OPENCV
-		img = cvCloneImage( (IplImage*)iplImage );
+		img = ipl_clone_image( (IplImage*)iplImage );
 #else
 		THROW_EXCEPTION("The MRPT has been compiled with MRPT_HAS_OPENCV=0 !");
 #endif
@@ -998,9 +1139,11 @@ CImage  CImage::grayscale() const
 
 // Auxiliary function for both ::grayscale() and ::grayscaleInPlace()
 #if MRPT_HAS_OPENCV
-IplImage *ipl_to_grayscale(const IplImage * img_src)
+// img_dest: An existing gray image of the same size to write to, or NULL to create a new one.
+IplImage *ipl_to_grayscale(const IplImage * img_src, IplImage * img_dest = NULL)
 {
-	IplImage * img_dest = cvCreateImage( cvSize(img_src->width,img_src->height),IPL_DEPTH_8U, 1 );
+	if (!img_dest)
+		img_dest = ipl_create_image( cvSize(img_src->width,img_src->height),IPL_DEPTH_8U, 1 );
 	img_dest->origin = img_src->origin;
 
 	// If possible, use SSE optimized version:
@@ -1040,8 +1183,11 @@ void CImage::grayscale( CImage  &ret ) const
 	}
 	else
 	{
-		// Convert to a single luminance channel image
-		ret.setFromIplImage(ipl_to_grayscale(ipl));
+		// Convert to a single luminance channel image, reusing the output buffer if possible:
+		IplImage *ipl_dest = &ret!=this ? static_cast<IplImage*>(ret.getReusableIplImage(ipl->width,ipl->height,1)) : NULL;
+		if (ipl_dest)
+		     ipl_to_grayscale(ipl,ipl_dest);
+		else ret.setFromIplImage(ipl_to_grayscale(ipl));
 	}
 #endif
 }
@@ -1076,8 +1222,11 @@ void CImage::scaleHalf(CImage &out)const
 	const int w = img_src->width;
 	const int h = img_src->height;
 
-	// Create target image:
-	IplImage * img_dest = cvCreateImage( cvSize(w>>1,h>>1),IPL_DEPTH_8U, img_src->nChannels );
+	// Create target image, or reuse the one in "out":
+	IplImage * img_dest = &out!=this ? static_cast<IplImage*>(out.getReusableIplImage(w>>1,h>>1,img_src->nChannels)) : NULL;
+	const bool reused_dest = (img_dest!=NULL);
+	if (!reused_dest)
+		img_dest = ipl_create_image( cvSize(w>>1,h>>1),IPL_DEPTH_8U, img_src->nChannels );
 	img_dest->origin = img_src->origin;
 	memcpy(img_dest->colorModel,img_src->colorModel,4);
 	memcpy(img_dest->channelSeq,img_src->channelSeq,4);
@@ -1094,7 +1243,7 @@ void CImage::scaleHalf(CImage &out)const
 		img_dest->widthStep==img_dest->width*img_dest->nChannels )
 	{
 		image_SSSE3_scale_half_3c8u( (const uint8_t*)img_src->imageData, (uint8_t*)img_dest->imageData, w,h);
-		out.setFromIplImage(img_dest);
+		if (!reused_dest) out.setFromIplImage(img_dest);
 		return;
 	}
 #endif
@@ -1109,14 +1258,14 @@ void CImage::scaleHalf(CImage &out)const
 	{
 		image_SSE2_scale_half_1c8u( (const uint8_t*)img_src->imageData, (uint8_t*)img_dest->imageData, w,h);
 
-		out.setFromIplImage(img_dest);
+		if (!reused_dest) out.setFromIplImage(img_dest);
 		return;
 	}
 #endif
 
 	// Fall back to slow method:
 	cvResize( img_src, img_dest, IMG_INTERP_NN );
-	out.setFromIplImage(img_dest);
+	if (!reused_dest) out.setFromIplImage(img_dest);
 #endif
 }
 
@@ -1134,8 +1283,11 @@ void CImage::scaleHalfSmooth(CImage &out)const
 	const int w = img_src->width;
 	const int h = img_src->height;
 
-	// Create target image:
-	IplImage * img_dest = cvCreateImage( cvSize(w>>1,h>>1),IPL_DEPTH_8U, img_src->nChannels );
+	// Create target image, or reuse the one in "out":
+	IplImage * img_dest = &out!=this ? static_cast<IplImage*>(out.getReusableIplImage(w>>1,h>>1,img_src->nChannels)) : NULL;
+	const bool reused_dest = (img_dest!=NULL);
+	if (!reused_dest)
+		img_dest = ipl_create_image( cvSize(w>>1,h>>1),IPL_DEPTH_8U, img_src->nChannels );
 	img_dest->origin = img_src->origin;
 	memcpy(img_dest->colorModel,img_src->colorModel,4);
 	memcpy(img_dest->channelSeq,img_src->channelSeq,4);
@@ -1153,14 +1305,24 @@ void CImage::scaleHalfSmooth(CImage &out)const
 	{
 		image_SSE2_scale_half_smooth_1c8u( (const uint8_t*)img_src->imageData, (uint8_t*)img_dest->imageData, w,h);
 
-		out.setFromIplImage(img_dest);
+		if (!reused_dest) out.setFromIplImage(img_dest);
+		return;
+	}
+#endif
+
+#if MRPT_HAS_SSE3
+	if (img_src->nChannels==3 && img_src->depth==IPL_DEPTH_8U)
+	{
+		image_SSSE3_scale_half_smooth_3c8u( (const uint8_t*)img_src->imageData, (uint8_t*)img_dest->imageData, w,h, img_src->widthStep, img_dest->widthStep);
+
+		if (!reused_dest) out.setFromIplImage(img_dest);
 		return;
 	}
 #endif
 
 	// Fall back to slow method:
 	cvResize( img_src, img_dest, IMG_INTERP_LINEAR );
-	out.setFromIplImage(img_dest);
+	if (!reused_dest) out.setFromIplImage(img_dest);
 #endif
 }
 
@@ -1908,6 +2070,24 @@ void CImage::unload() const MRPT_NO_THROWS
 		const_cast<CImage*>(this)->releaseIpl( true ); // Do NOT mark the image as NON external
 }
 
+/*---------------------------------------------------------------
+						getReusableIplImage
+ ---------------------------------------------------------------*/
+void *CImage::getReusableIplImage(int width, int height, int nChannels) const
+{
+#if MRPT_HAS_OPENCV
+	if (!img || m_imgIsReadOnly || m_imgIsExternalStorage)
+		return NULL;
+	const IplImage *ipl = static_cast<const IplImage*>(img);
+	if (ipl->width!=width || ipl->height!=height || ipl->nChannels!=nChannels || ipl->depth!=IPL_DEPTH_8U || ipl->roi!=NULL)
+		return NULL;
+	return img;
+#else
+	MRPT_UNUSED_PARAM(width); MRPT_UNUSED_PARAM(height); MRPT_UNUSED_PARAM(nChannels);
+	return NULL;
+#endif
+}
+
 /*---------------------------------------------------------------
 						releaseIpl
  ---------------------------------------------------------------*/
@@ -1916,8 +2096,7 @@ void CImage::releaseIpl(bool thisIsExternalImgUnload) MRPT_NO_THROWS
 #if MRPT_HAS_OPENCV
 	if (img && !m_imgIsReadOnly)
 	{
-		IplImage *ptr=(IplImage*)img;
-		cvReleaseImage( &ptr );
+		ipl_release_image( static_cast<IplImage*>(img) );
 	}
 	img = NULL;
 	m_imgIsReadOnly = false;
@@ -2019,7 +2198,7 @@ void CImage::rectifyImageInPlace( void *mapX, void *mapY )
 #else
 
     IplImage *srcImg = getAs<IplImage>();	// Source Image
-	IplImage *outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
+	IplImage *outImg = ipl_create_image( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
 
     cv::Mat *_mapX, *_mapY;
     _mapX = static_cast<cv::Mat*>(mapX);
@@ -2047,7 +2226,7 @@ void CImage::rectifyImageInPlace( const mrpt::utils::TCamera &cameraParams  )
 	// MRPT -> OpenCV Input Transformation
 	IplImage *srcImg = getAs<IplImage>();	// Source Image
 	IplImage *outImg;												// Output Image
-	outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
+	outImg = ipl_create_image( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
 
 	double aux1[3][3], aux2[1][5];
 	const CMatrixDouble33 &cameraMatrix = cameraParams.intrinsicParams;
@@ -2083,7 +2262,7 @@ void CImage::rectifyImage(
 	// MRPT -> OpenCV Input Transformation
 	const IplImage *srcImg = getAs<IplImage>();	// Source Image
 	IplImage *outImg;												// Output Image
-	outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
+	outImg = ipl_create_image( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
 
 	double aux1[3][3], aux2[1][5];
 	const CMatrixDouble33 &cameraMatrix = cameraParams.intrinsicParams;
@@ -2101,10 +2280,7 @@ void CImage::rectifyImage(
 	cvUndistort2( srcImg, outImg, &inMat, &distM );
 
 	// OpenCV -> MRPT Output Transformation
-	out_img.loadFromIplImage( outImg );
-
-	// Release Output Image
-	cvReleaseImage( &outImg );
+	out_img.setFromIplImage( outImg );
 #endif
 } // end CImage::rectifyImage
 
@@ -2120,7 +2296,7 @@ void CImage::filterMedian( CImage &out_img, int W ) const
 	// MRPT -> OpenCV Input Transformation
 	const IplImage *srcImg = getAs<IplImage>();	// Source Image
 	IplImage *outImg;												// Output Image
-	outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
+	outImg = ipl_create_image( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
 
 	// Filter
 	cvSmooth( srcImg, outImg, CV_MEDIAN, W );
@@ -2128,10 +2304,7 @@ void CImage::filterMedian( CImage &out_img, int W ) const
 	outImg->origin = srcImg->origin;
 
 	// OpenCV -> MRPT Output Transformation
-	out_img.loadFromIplImage( outImg );
-
-	// Release Output Image
-	cvReleaseImage( &outImg );
+	out_img.setFromIplImage( outImg );
 #endif
 }
 
@@ -2146,7 +2319,7 @@ void CImage::filterMedianInPlace( int W )
 	// MRPT -> OpenCV Input Transformation
 	IplImage *srcImg = getAs<IplImage>();	// Source Image
 	IplImage *outImg;												// Output Image
-	outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
+	outImg = ipl_create_image( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
 
 	// Filter
 	cvSmooth( srcImg, outImg, CV_MEDIAN, W );
@@ -2170,7 +2343,7 @@ void CImage::filterGaussian( CImage &out_img, int W, int H ) const
 	// MRPT -> OpenCV Input Transformation
 	const IplImage *srcImg = getAs<IplImage>();	// Source Image
 	IplImage *outImg;												// Output Image
-	outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
+	outImg = ipl_create_image( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
 
 	// Filter
 	cvSmooth( srcImg, outImg, CV_GAUSSIAN, W, H );
@@ -2178,10 +2351,7 @@ void CImage::filterGaussian( CImage &out_img, int W, int H ) const
 	outImg->origin = srcImg->origin;
 
 	// OpenCV -> MRPT Output Transformation
-	out_img.loadFromIplImage( outImg );
-
-	// Release Output Image
-	cvReleaseImage( &outImg );
+	out_img.setFromIplImage( outImg );
 #endif
 }
 
@@ -2196,7 +2366,7 @@ void CImage::filterGaussianInPlace( int W, int H )
 	// MRPT -> OpenCV Input Transformation
 	IplImage *srcImg = getAs<IplImage>();	// Source Image
 	IplImage *outImg;												// Output Image
-	outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
+	outImg = ipl_create_image( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
 
 	// Filter
 	cvSmooth( srcImg, outImg, CV_GAUSSIAN, W, H );
@@ -2224,7 +2394,7 @@ void CImage::scaleImage( unsigned int width, unsigned int height, TInterpolation
 		return;
 
 	IplImage *outImg;												// Output Image
-	outImg = cvCreateImage( cvSize(width,height), srcImg->depth, srcImg->nChannels );
+	outImg = ipl_create_image( cvSize(width,height), srcImg->depth, srcImg->nChannels );
 
 	// Resize:
 	cvResize( srcImg, outImg, (int)interp );
@@ -2255,7 +2425,7 @@ void CImage::scaleImage( CImage &out_img, unsigned int width, unsigned int heigh
 	}
 
 	IplImage *outImg;		// Output Image
-	outImg = cvCreateImage( cvSize(width,height), srcImg->depth, srcImg->nChannels );
+	outImg = ipl_create_image( cvSize(width,height), srcImg->depth, srcImg->nChannels );
 
 	// Resize:
 	cvResize( srcImg, outImg, (int)interp );
@@ -2278,7 +2448,7 @@ void CImage::rotateImage( double angle_radians, unsigned int center_x, unsigned
 
 	IplImage *srcImg = getAs<IplImage>();	// Source Image
 	IplImage *outImg;												// Output Image
-	outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
+	outImg = ipl_create_image( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
 
 	// Based on the blog entry:
 	// http://blog.weisu.org/2007/12/opencv-image-rotate-and-zoom-rotation.html
@@ -2390,7 +2560,7 @@ void CImage::colorImage( CImage  &ret ) const
 	}
 
 	const IplImage *srcImg = getAs<IplImage>();	// Source Image
-	IplImage *outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, 3 );
+	IplImage *outImg = ipl_create_image( cvGetSize( srcImg ), srcImg->depth, 3 );
 
 	cvCvtColor( srcImg, outImg, CV_GRAY2BGR );
 
@@ -2411,7 +2581,7 @@ void CImage::colorImageInPlace()
 
 	IplImage *srcImg = getAs<IplImage>();	// Source Image
 	IplImage *outImg;												// Output Image
-	outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, 3 );
+	outImg = ipl_create_image( cvGetSize( srcImg ), srcImg->depth, 3 );
 
 	cvCvtColor( srcImg, outImg, CV_GRAY2BGR );
 
@@ -2510,7 +2680,7 @@ void CImage::equalizeHistInPlace()
 	IplImage *srcImg = getAs<IplImage>();	// Source Image
     ASSERT_(srcImg!=NULL);
 
-	IplImage *outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
+	IplImage *outImg = ipl_create_image( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
 	outImg->origin = srcImg->origin;
 
 	if (srcImg->nChannels==1)
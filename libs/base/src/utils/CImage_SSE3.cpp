@@ -85,6 +85,55 @@ void image_SSSE3_scale_half_3c8u(const uint8_t* in, uint8_t* out, int w, int h)
 }
 
 
+/** Average each 2x2 pixels into 1x1 pixel (arithmetic average, with the same rounding than image_SSE2_scale_half_smooth_1c8u())
+  *  - <b>Input format:</b> uint8_t, 3 channels (RGB or BGR)
+  *  - <b>Output format:</b> uint8_t, 3 channels (RGB or BGR)
+  *  - <b>Preconditions:</b> None: unaligned loads are used and the row strides (in bytes) are explicit, so it applies to any image size.
+  *  - <b>Notes:</b> Each iteration reads 6 pixels (18 bytes) of two rows and writes 3 output pixels, the rest of the row is done pixel by pixel.
+  *  - <b>Requires:</b> SSSE3
+  *  - <b>Invoked from:</b> mrpt::utils::CImage::scaleHalfSmooth()
+  */
+void image_SSSE3_scale_half_smooth_3c8u(const uint8_t* in, uint8_t* out, int w, int h, size_t step_in, size_t step_out)
+{
+	// Picks the channels of pixels #0, #2 and #4 into the lowest 9 bytes:
+	MRPT_ALIGN16 const unsigned long long mask[2] = { 0x0D0C080706020100ull, 0x808080808080800Eull };
+	const __m128i m = _mm_load_si128((const __m128i*)mask);
+
+	const int sw = w >> 1;
+	const int sh = h >> 1;
+	const int row_bytes = 3*w;
+
+	for (int i=0; i<sh; i++)
+	{
+		const uint8_t *r0 = in + (2*i)*step_in;
+		const uint8_t *r1 = r0 + step_in;
+		uint8_t *o = out + i*step_out;
+
+		int x = 0; // output pixel
+		for (; 6*x+19<=row_bytes; x+=3)
+		{
+			const int k = 6*x;
+			// Average of the two rows, for each pixel (A) and its right neighbor (B):
+			const __m128i A = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(r0+k)), _mm_loadu_si128((const __m128i*)(r1+k)));
+			const __m128i B = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(r0+k+3)), _mm_loadu_si128((const __m128i*)(r1+k+3)));
+			const __m128i res = _mm_shuffle_epi8(_mm_avg_epu8(A,B), m);
+			_mm_storel_epi64((__m128i*)(o+3*x), res);
+			o[3*x+8] = static_cast<uint8_t>(_mm_extract_epi16(res,4));
+		}
+		for (; x<sw; x++)
+		{
+			const int k = 6*x;
+			for (int ch=0;ch<3;ch++)
+			{
+				const int a = (r0[k+ch]+r1[k+ch]+1)>>1;
+				const int b = (r0[k+3+ch]+r1[k+3+ch]+1)>>1;
+				o[3*x+ch] = static_cast<uint8_t>((a+b+1)>>1);
+			}
+		}
+	}
+}
+
+
 // This is the actual function behind both: image_SSSE3_rgb_to_gray_8u() and image_SSSE3_bgr_to_gray_8u():
 template <bool IS_RGB>
 void private_image_SSSE3_rgb_or_bgr_to_gray_8u(const uint8_t* in, uint8_t* out, int w, int h)
@@ -0,0 +1,234 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/utils/CImage.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+#include "CImage_SSEx.h"
+
+// Universal include for all versions of OpenCV
+#include <mrpt/otherlibs/do_opencv_includes.h>
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace std;
+
+#if MRPT_HAS_SSE3 || MRPT_HAS_OPENCV
+namespace
+{
+	// Reference for scaleHalfSmooth() on 8-bit images: each output pixel is the average of the averages of the two rows of a 2x2 block,
+	//  rounding up like the SSE kernels. The last column or row of odd-sized images is dropped.
+	void scale_half_smooth_reference(const uint8_t *in, uint8_t *out, int w, int h, int nChannels, size_t step_in, size_t step_out)
+	{
+		for (int y=0;y<h/2;y++)
+		{
+			const uint8_t *r0 = in + 2*y*step_in, *r1 = r0 + step_in;
+			for (int x=0;x<w/2;x++)
+				for (int ch=0;ch<nChannels;ch++)
+				{
+					const int k = 2*x*nChannels+ch;
+					const int a = (r0[k]+r1[k]+1)>>1;
+					const int b = (r0[k+nChannels]+r1[k+nChannels]+1)>>1;
+					out[y*step_out+x*nChannels+ch] = static_cast<uint8_t>((a+b+1)>>1);
+				}
+		}
+	}
+}
+#endif
+
+#if MRPT_HAS_SSE3
+TEST(CImage, SSSE3_scale_half_smooth_3c8u_same_as_reference)
+{
+	mrpt::random::CRandomGenerator rng(1234);
+	// Even and odd widths, below and above one vector iteration (6 input pixels), and rows with padding at the end:
+	for (int w=2;w<=45;w++)
+	{
+		for (int h=2;h<=5;h++)
+		{
+			const size_t step_in = 3*w + (w%3), step_out = 3*(w/2) + 5;
+			std::vector<uint8_t> in(step_in*h), out(step_out*(h/2), 0xAA), expected(out);
+			for (size_t i=0;i<in.size();i++) in[i] = static_cast<uint8_t>(rng.drawUniform32bit());
+
+			image_SSSE3_scale_half_smooth_3c8u(&in[0],&out[0],w,h,step_in,step_out);
+			scale_half_smooth_reference(&in[0],&expected[0],w,h,3,step_in,step_out);
+
+			// Also checks that the padding bytes of the output rows are untouched:
+			EXPECT_TRUE(out==expected) << "w=" << w << " h=" << h;
+		}
+	}
+}
+#endif
+
+#if MRPT_HAS_OPENCV
+
+namespace
+{
+	// Empties the pool of image buffers and sets its maximum size, restoring the previous one on destruction:
+	struct TImagePoolScope
+	{
+		const size_t old_max_size;
+		explicit TImagePoolScope(size_t max_size) : old_max_size(CImage::getImageBuffersPoolMaxSize())
+		{
+			CImage::setImageBuffersPoolMaxSize(0);
+			CImage::setImageBuffersPoolMaxSize(max_size);
+		}
+		~TImagePoolScope() { CImage::setImageBuffersPoolMaxSize(old_max_size); }
+	};
+}
+
+TEST(CImage, BuffersPoolReusesBuffers)
+{
+	TImagePoolScope scope(8);
+
+	const unsigned char *buf;
+	{
+		CImage a(320,240,CH_RGB);
+		buf = a.get_unsafe(0,0);
+	}
+	EXPECT_EQ(CImage::getImageBuffersPoolSize(), 1u);
+
+	// Other size or format: not taken from the pool
+	CImage b(320,240,CH_GRAY), c(240,320,CH_RGB);
+	EXPECT_EQ(CImage::getImageBuffersPoolSize(), 1u);
+
+	CImage d(320,240,CH_RGB);
+	EXPECT_EQ(d.get_unsafe(0,0), buf);
+	EXPECT_EQ(CImage::getImageBuffersPoolSize(), 0u);
+
+	// Also through resize():
+	{
+		CImage e(64,48,CH_GRAY);
+		buf = e.get_unsafe(0,0);
+	}
+	CImage f(10,10,CH_GRAY);
+	f.resize(64,48,CH_GRAY,true);
+	EXPECT_EQ(f.get_unsafe(0,0), buf);
+}
+
+TEST(CImage, BuffersPoolKeepsAtMostMaxSize)
+{
+	TImagePoolScope scope(2);
+	{
+		CImage a(32,32,CH_GRAY), b(33,32,CH_GRAY), c(34,32,CH_GRAY);
+	}
+	EXPECT_EQ(CImage::getImageBuffersPoolSize(), 2u);
+
+	CImage::setImageBuffersPoolMaxSize(1);
+	EXPECT_EQ(CImage::getImageBuffersPoolSize(), 1u);
+}
+
+TEST(CImage, BuffersPoolZeroSizeDisablesPool)
+{
+	TImagePoolScope scope(8);
+	{
+		CImage a(320,240,CH_RGB);
+	}
+	EXPECT_EQ(CImage::getImageBuffersPoolSize(), 1u);
+
+	// Frees the buffers in the pool, and does not keep new ones:
+	CImage::setImageBuffersPoolMaxSize(0);
+	EXPECT_EQ(CImage::getImageBuffersPoolMaxSize(), 0u);
+	EXPECT_EQ(CImage::getImageBuffersPoolSize(), 0u);
+	{
+		CImage a(320,240,CH_RGB), b(320,240,CH_RGB);
+		CImage c;
+		a.scaleHalf(c);
+		c = b;
+	}
+	EXPECT_EQ(CImage::getImageBuffersPoolSize(), 0u);
+}
+
+namespace
+{
+	void fill_random_image(CImage &img, unsigned int w, unsigned int h, TImageChannels ch)
+	{
+		img.resize(w,h,ch,true);
+		for (unsigned int y=0;y<h;y++)
+		{
+			unsigned char *row = img.get_unsafe(0,y);
+			for (unsigned int x=0;x<w*ch;x++)
+				row[x] = static_cast<unsigned char>(mrpt::random::randomGenerator.drawUniform32bit());
+		}
+	}
+}
+
+TEST(CImage, scaleHalfSmoothRGB)
+{
+	mrpt::random::randomGenerator.randomize(1234);
+	// Odd widths and heights go through the pixel-by-pixel tail of the SSSE3 kernel:
+	const unsigned int sizes[][2] = { {640,480}, {641,481}, {33,7}, {7,33}, {2,2} };
+	for (size_t i=0;i<sizeof(sizes)/sizeof(sizes[0]);i++)
+	{
+		const unsigned int w = sizes[i][0], h = sizes[i][1];
+		CImage img, half;
+		fill_random_image(img,w,h,CH_RGB);
+		img.scaleHalfSmooth(half);
+		ASSERT_EQ(half.getWidth(), w/2);
+		ASSERT_EQ(half.getHeight(), h/2);
+
+		std::vector<uint8_t> expected(3*(w/2)*(h/2));
+		scale_half_smooth_reference(img.get_unsafe(0,0),&expected[0],w,h,3,img.getRowStride(),3*(w/2));
+		int max_diff = 0;
+		for (unsigned int y=0;y<h/2;y++)
+			for (unsigned int x=0;x<3*(w/2);x++)
+				max_diff = std::max(max_diff, std::abs(int(half.get_unsafe(0,y)[x]) - int(expected[y*3*(w/2)+x])));
+#if MRPT_HAS_SSE3
+		EXPECT_EQ(max_diff,0) << "w=" << w << " h=" << h;
+#else
+		EXPECT_LE(max_diff,1) << "w=" << w << " h=" << h;   // cvResize() rounds once, not twice
+#endif
+
+		// The scalar path, cvResize(), gives the same up to rounding:
+		cv::Mat ref;
+		const cv::Mat src = cv::cvarrToMat(img.getAs<IplImage>());
+		cv::resize(src, ref, cv::Size(w/2,h/2), 0,0, cv::INTER_LINEAR);
+		EXPECT_LE(cv::norm(cv::cvarrToMat(half.getAs<IplImage>()), ref, cv::NORM_INF), 1) << "w=" << w << " h=" << h;
+	}
+}
+
+TEST(CImage, ReusesOutputImageBuffers)
+{
+	mrpt::random::randomGenerator.randomize(1234);
+	CImage img, gray, half, half_smooth, copy;
+	fill_random_image(img,320,240,CH_RGB);
+
+	// The first call allocates the outputs...
+	img.grayscale(gray);
+	img.scaleHalf(half);
+	img.scaleHalfSmooth(half_smooth);
+	copy = img;
+	const unsigned char *bufs[4] = { gray.get_unsafe(0,0), half.get_unsafe(0,0), half_smooth.get_unsafe(0,0), copy.get_unsafe(0,0) };
+
+	// ... and the next ones, with the same size and format, write into them:
+	fill_random_image(img,320,240,CH_RGB);
+	img.grayscale(gray);
+	img.scaleHalf(half);
+	img.scaleHalfSmooth(half_smooth);
+	copy = img;
+	EXPECT_EQ(gray.get_unsafe(0,0), bufs[0]);
+	EXPECT_EQ(half.get_unsafe(0,0), bufs[1]);
+	EXPECT_EQ(half_smooth.get_unsafe(0,0), bufs[2]);
+	EXPECT_EQ(copy.get_unsafe(0,0), bufs[3]);
+
+	// With the right contents:
+	CImage gray2, half_smooth2;
+	img.grayscale(gray2);
+	img.scaleHalfSmooth(half_smooth2);
+	EXPECT_EQ(cv::norm(cv::cvarrToMat(gray.getAs<IplImage>()), cv::cvarrToMat(gray2.getAs<IplImage>()), cv::NORM_INF), 0);
+	EXPECT_EQ(cv::norm(cv::cvarrToMat(half_smooth.getAs<IplImage>()), cv::cvarrToMat(half_smooth2.getAs<IplImage>()), cv::NORM_INF), 0);
+	EXPECT_EQ(cv::norm(cv::cvarrToMat(copy.getAs<IplImage>()), cv::cvarrToMat(img.getAs<IplImage>()), cv::NORM_INF), 0);
+
+	// A different size needs a new buffer:
+	CImage small;
+	fill_random_image(small,160,120,CH_RGB);
+	small.scaleHalf(half);
+	EXPECT_EQ(half.getWidth(), 80u);
+}
+
+#endif
@@ -26,6 +26,12 @@
 #include <mrpt/utils/CFileOutputStream.h>
 #include <mrpt/utils/TEnumType.h>
 #include <mrpt/system/vector_loadsave.h>
+#include <mrpt/system/threads.h>  // parallelForBlocks()
+
+#if EIGEN_VERSION_AT_LEAST(3,1,0) // eigen 3.1+
+	#include <Eigen/SparseCore>
+	#include <Eigen/SparseCholesky>
+#endif
 
 
 namespace mrpt
@@ -41,7 +47,8 @@ namespace mrpt
 			kfEKFNaive = 0,
 			kfEKFAlaDavison,
 			kfIKFFull,
-			kfIKF
+			kfIKF,
+			kfSEIF   //!< Sparse Extended Information Filter (only for SLAM problems). See CKalmanFilterCapable::recoverMean(), CKalmanFilterCapable::getStateCovariance()
 		};
 
 		// Forward declaration:
@@ -60,7 +67,9 @@ namespace mrpt
 				use_analytic_transition_jacobian	(true),
 				use_analytic_observation_jacobian	(true),
 				debug_verify_analytic_jacobians		(false),
-				debug_verify_analytic_jacobians_threshold	(1e-2)
+				debug_verify_analytic_jacobians_threshold	(1e-2),
+				SEIF_max_active_landmarks	(10),
+				num_threads	(1)
 			{
 			}
 
@@ -74,6 +83,8 @@ namespace mrpt
 				MRPT_LOAD_CONFIG_VAR( use_analytic_observation_jacobian, bool    , iniFile, section  );
 				MRPT_LOAD_CONFIG_VAR( debug_verify_analytic_jacobians, bool    , iniFile, section  );
 				MRPT_LOAD_CONFIG_VAR( debug_verify_analytic_jacobians_threshold, double, iniFile, section );
+				MRPT_LOAD_CONFIG_VAR( SEIF_max_active_landmarks, int, iniFile, section );
+				MRPT_LOAD_CONFIG_VAR( num_threads, uint64_t, iniFile, section );
 			}
 
 			/** This method must display clearly all the contents of the structure in textual form, sending it to a CStream. */
@@ -84,6 +95,8 @@ namespace mrpt
 				out.printf("verbosity_level                         = %s\n", mrpt::utils::TEnumType<mrpt::utils::VerbosityLevel>::value2name(verbosity_level).c_str());
 				out.printf("IKF_iterations                          = %i\n", IKF_iterations);
 				out.printf("enable_profiler                         = %c\n", enable_profiler ? 'Y':'N');
+				out.printf("SEIF_max_active_landmarks               = %i\n", SEIF_max_active_landmarks);
+				out.printf("num_threads                             = %u\n", num_threads);
 				out.printf("\n");
 			}
 
@@ -96,6 +109,12 @@ namespace mrpt
 			bool		use_analytic_observation_jacobian;	//!< (default=true) If true, OnObservationJacobians will be called; otherwise, the Jacobian will be estimated from a numeric approximation by calling several times to OnObservationModel.
 			bool		debug_verify_analytic_jacobians; //!< (default=false) If true, will compute all the Jacobians numerically and compare them to the analytical ones, throwing an exception on mismatch.
 			double		debug_verify_analytic_jacobians_threshold; //!< (default-1e-2) Sets the threshold for the difference between the analytic and the numerical jacobians
+			int 		SEIF_max_active_landmarks; //!< (default=10) Only for kfSEIF: the maximum number of "active" landmarks, i.e. those linked to the vehicle in the information matrix. Lower values mean sparser information matrices and faster updates, at the cost of a coarser approximation.
+			/** (default=1) Number of threads for predicting the observations and their Jacobians, building the innovation matrix "S" and
+			  *  updating the covariance matrix in large maps (0: one per core). With more than one thread, OnObservationModel() and
+			  *  OnObservationJacobians() are invoked concurrently for different landmarks, so they must be thread-safe.
+			  *  Results do not depend on the number of threads. */
+			unsigned int num_threads;
 		};
 
 		/** Auxiliary functions, for internal usage of MRPT classes */
@@ -208,18 +227,36 @@ namespace mrpt
 				::memcpy(&feat[0], &m_xkk[VEH_SIZE+idx*FEAT_SIZE], FEAT_SIZE*sizeof(m_xkk[0]));
 			}
 			/** Returns the covariance of the idx'th landmark (not applicable to non-SLAM problems).
+			  *  With kfSEIF, it is recovered from the information matrix of the landmark Markov blanket. This is an overconfident approximation:
+			  *  the rest of the map is considered as known, so the returned covariance is smaller than the true marginal one.
 			  * \exception std::exception On idx>= getNumberOfLandmarksInTheMap()
 			  */
 			inline void getLandmarkCov(size_t idx, KFMatrix_FxF &feat_cov ) const {
-				m_pkk.extractMatrix(VEH_SIZE+idx*FEAT_SIZE,VEH_SIZE+idx*FEAT_SIZE,feat_cov);
+				ASSERT_(idx<getNumberOfLandmarksInTheMap())
+				if (seif_isInformationFormUpToDate())
+					seif_getLandmarkCov(idx,feat_cov);
+				else
+					m_pkk.extractMatrix(VEH_SIZE+idx*FEAT_SIZE,VEH_SIZE+idx*FEAT_SIZE,feat_cov);
 			}
 
+			/** Returns the full covariance of the state vector.
+			  *  This is simply a copy of the internal covariance matrix, except for kfSEIF, where m_pkk only keeps the vehicle covariance
+			  *  and the full covariance must be obtained by inverting the information matrix: an O(N^3) operation to be called only on demand.
+			  */
+			void getStateCovariance(KFMatrix &cov) const;
+
+			/** Only for kfSEIF: recovers the exact mean of the state vector from the information matrix and vector, by means of a sparse Cholesky factorization.
+			  *  In each iteration, SEIF only recovers the mean of the vehicle and the active landmarks, so the rest of the map may be somewhat outdated until this method is called.
+			  *  It does nothing for the rest of methods.
+			  */
+			void recoverMean();
+
 		protected:
 			/** @name Kalman filter state
 				@{ */
 
 			KFVector  m_xkk;  //!< The system state vector.
-			KFMatrix  m_pkk;  //!< The system full covariance matrix.
+			KFMatrix  m_pkk;  //!< The system full covariance matrix. With kfSEIF, only the covariance of the vehicle (VEH_SIZE x VEH_SIZE).
 
 			/** @} */
 
@@ -454,6 +491,7 @@ namespace mrpt
 			CKalmanFilterCapable() : 
 				mrpt::utils::COutputLogger("CKalmanFilterCapable"),
 				KF_options(this->m_min_verbosity_level),
+				m_seif_valid(false),
 				m_user_didnt_implement_jacobian(true) 
 			{} //!< Default constructor
 			virtual ~CKalmanFilterCapable() {}  //!< Destructor
@@ -476,8 +514,23 @@ namespace mrpt
 			vector_KFArray_OBS 		Z;		// Each entry is one observation:
 			KFMatrix 				K; 		// Kalman gain
 			KFMatrix 				S_1; 	// Inverse of S
-			KFMatrix 				dh_dx_full_obs;
-			KFMatrix				aux_K_dh_dx;
+			KFMatrix 				P_Ht;	// P * H^t, built block by block from the non-zero blocks of H
+			vector_size_t			obs_pred_idxs; // For each observation used in the update, its index in predictLMidxs
+
+			/** @name Sparse Extended Information Filter (kfSEIF) state
+			    The information matrix is stored by blocks, keeping only the non-zero ones, and the information vector \f$ \xi = \Omega \mu \f$ as a dense vector. The mean is kept in m_xkk.
+				@{ */
+			typedef typename mrpt::aligned_containers<size_t,KFMatrix_VxF>::map_t  seif_links_VxF_t;
+			typedef typename mrpt::aligned_containers<size_t,KFMatrix_FxF>::map_t  seif_links_FxF_t;
+
+			bool              m_seif_valid;    //!< Whether the SEIF information form has been initialized
+			KFMatrix_VxV      m_seif_Oxx;      //!< Information of the vehicle
+			seif_links_VxF_t  m_seif_Oxy;      //!< Vehicle-landmark blocks: only for the "active" landmarks (at most TKF_options::SEIF_max_active_landmarks, plus those observed in the last iteration)
+			typename mrpt::aligned_containers<KFMatrix_FxF>::vector_t  m_seif_Oyy; //!< Diagonal blocks of each landmark
+			std::vector<seif_links_FxF_t>  m_seif_Oyy_links; //!< Non-zero landmark-landmark blocks: m_seif_Oyy_links[i][j] is \f$ \Omega_{y_i y_j} \f$ (stored for both i,j and j,i)
+			KFVector          m_seif_xi;       //!< The information vector
+			KFMatrix_VxV      m_seif_last_Pxx; //!< The value of m_pkk at the end of the last iteration, to detect a reset of the filter by the derived class
+			/** @} */
 
 		protected:
 
@@ -490,11 +543,54 @@ namespace mrpt
 		private:
 			mutable bool m_user_didnt_implement_jacobian;
 
+			/** @name Auxiliary methods for kfSEIF. Landmark lists are always sorted, and the vehicle is always implicitly the first block of the local matrices.
+				@{ */
+			bool seif_isInformationFormUpToDate() const; //!< False if m_xkk & m_pkk have been modified (e.g. reset) since the last iteration
+			void seif_initInformationForm(); //!< Builds the information form from m_xkk & m_pkk (which must be the full covariance)
+			void seif_getActiveLandmarks(vector_size_t &lms) const;
+			void seif_getMarkovBlanket(const vector_size_t &lms, vector_size_t &blanket) const; //!< The active landmarks, plus "lms" and their linked landmarks
+			void seif_getLocalInformation(const vector_size_t &lms, KFMatrix &Omega) const; //!< The dense information submatrix of the vehicle and "lms"
+			void seif_addToLocalInformation(const vector_size_t &lms, const KFMatrix &delta); //!< Adds a dense increment to the information submatrix of the vehicle and "lms"
+			void seif_getInformationTimesMean(const vector_size_t &lms, KFVector &Omega_mu) const; //!< The rows of \f$ \Omega \mu \f$ of the vehicle and "lms"
+			void seif_addToInformationVector(const vector_size_t &lms, const KFVector &delta); //!< Adds an increment to the rows of \f$ \xi \f$ of the vehicle and "lms"
+			void seif_getLandmarkCov(size_t idx, KFMatrix_FxF &feat_cov ) const;
+			void seif_predict(const KFMatrix_VxV &dfv_dxv, const KFMatrix_VxV &Q, const KFArray_VEH &xv);
+			void seif_buildInnovationCovariance(const KFMatrix_OxO &R); //!< Builds S for the landmarks in predictLMidxs
+			void seif_update(const vector_int &data_association, const KFMatrix_OxO &R);
+			void seif_recoverLocalMean(const vector_size_t &lms); //!< Exact mean of the vehicle and "lms", given the current mean of the rest of the map
+			void seif_normalizeStateVector(); //!< Calls OnNormalizeStateVector and updates \f$ \xi \f$ accordingly (only the vehicle part of the state may be normalized)
+			void seif_addNewLandmark(const KFMatrix_FxV &dyn_dxv, const KFMatrix_FxF &yn_cov); //!< The new landmark mean must be already appended to m_xkk
+			void seif_sparsify(const vector_int &data_association, const size_t first_new_landmark);
+			void seif_updateVehicleCovariance(); //!< Sets m_pkk to the vehicle covariance, recovered from its Markov blanket (overconfident, see getLandmarkCov())
+			/** @} */
+
 			/** Auxiliary functions for Jacobian numeric estimation */
 			static void KF_aux_estimate_trans_jacobian( const KFArray_VEH &x, const std::pair<KFCLASS*,KFArray_ACT> &dat, KFArray_VEH &out_x);
 			static void KF_aux_estimate_obs_Hx_jacobian(const KFArray_VEH &x, const std::pair<KFCLASS*,size_t> &dat, KFArray_OBS &out_x);
 			static void KF_aux_estimate_obs_Hy_jacobian(const KFArray_FEAT &x,const std::pair<KFCLASS*,size_t> &dat,KFArray_OBS &out_x);
 
+			/** @name Auxiliary methods for the block-wise (and optionally parallel) EKF update. Each one processes the items [first,last) and
+			    can be run from several threads at once for disjoint ranges. See TKF_options::num_threads
+				@{ */
+			/** Calls `(obj->*method)(offset+first,offset+last)`, for mrpt::system::parallelForBlocks() */
+			struct TAuxBlockRunner
+			{
+				KFCLASS *obj;
+				void (KFCLASS::*method)(size_t,size_t);
+				size_t offset;
+				TAuxBlockRunner(KFCLASS *obj_, void (KFCLASS::*method_)(size_t,size_t), size_t offset_) : obj(obj_), method(method_), offset(offset_) {}
+				void operator()(size_t first, size_t last, unsigned int) { (obj->*method)(offset+first,offset+last); }
+			};
+			/** Runs `method` for the items [first,last), split into blocks for several threads if there are at least `min_items_per_thread` items per thread */
+			void runInBlocks(const size_t first, const size_t last, void (KFCLASS::*method)(size_t,size_t), const size_t min_items_per_thread);
+			static const size_t KF_aux_cov_tile_size = 64; //!< Side of the square tiles in which the covariance matrix is updated
+			void aux_predictObservations(size_t first, size_t last); //!< all_predictions[first,last)
+			void aux_analyticObservationJacobians(size_t first, size_t last); //!< Hxs[i],Hys[i] for predictLMidxs[i], i in [first,last)
+			void aux_buildInnovationCovariance(size_t first, size_t last); //!< The rows [first,last) of blocks of S, and their transposed blocks (without R)
+			void aux_buildPHt(size_t first, size_t last); //!< The rows [first,last) of P_Ht
+			void aux_updateCovariance(size_t first, size_t last); //!< \f$ P \leftarrow P - K (P H^t)^t \f$ for the tiles [first,last) of the upper triangle of P (and their symmetric tiles)
+			/** @} */
+
 		template <size_t VEH_SIZEb, size_t OBS_SIZEb, size_t FEAT_SIZEb, size_t ACT_SIZEb, typename KFTYPEb>
 		friend 
 			void detail::addNewLandmarks(
@@ -519,6 +615,7 @@ namespace mrpt
 				m_map.insert(bayes::kfEKFAlaDavison,     "kfEKFAlaDavison");
 				m_map.insert(bayes::kfIKFFull,           "kfIKFFull");
 				m_map.insert(bayes::kfIKF,               "kfIKF");
+				m_map.insert(bayes::kfSEIF,              "kfSEIF");
 			}
 		};
 	} // End of namespace
@@ -27,7 +27,17 @@ namespace mrpt
 			m_timLogger.enable(KF_options.enable_profiler);
 			m_timLogger.enter("KF:complete_step");
 
-			ASSERT_(size_t(m_xkk.size())==m_pkk.getColCount())
+			if (KF_options.method==kfSEIF)
+			{
+				ASSERTMSG_(FEAT_SIZE>0, "kfSEIF can be only used in SLAM problems")
+				// (Re)build the information form if this is the first iteration or the filter has been reset:
+				if (!seif_isInformationFormUpToDate())
+					seif_initInformationForm();
+			}
+			else
+			{
+				ASSERT_(size_t(m_xkk.size())==m_pkk.getColCount())
+			}
 				ASSERT_(size_t(m_xkk.size())>=VEH_SIZE)
 
 				// =============================================================
@@ -101,25 +111,33 @@ namespace mrpt
 				KFMatrix_VxV  Q;
 				OnTransitionNoise(Q);
 
-				// ====================================
-				//  3.1:  Pxx submatrix
-				// ====================================
-				// Replace old covariance:
-				Eigen::Block<typename KFMatrix::Base,VEH_SIZE,VEH_SIZE>(m_pkk,0,0) =
-					Q +
-					dfv_dxv * Eigen::Block<typename KFMatrix::Base,VEH_SIZE,VEH_SIZE>(m_pkk,0,0) * dfv_dxv.transpose();
-
-				// ====================================
-				//  3.2:  All Pxy_i
-				// ====================================
-				// Now, update the cov. of landmarks, if any:
-				KFMatrix_VxF aux;
-				for (size_t i=0 ; i<N_map ; i++)
+				if (KF_options.method==kfSEIF)
 				{
-					aux = dfv_dxv * Eigen::Block<typename KFMatrix::Base,VEH_SIZE,FEAT_SIZE>(m_pkk,0,VEH_SIZE+i*FEAT_SIZE);
+					// Only the vehicle and the active landmarks are involved in the information form:
+					seif_predict(dfv_dxv,Q,xv);
+				}
+				else
+				{
+					// ====================================
+					//  3.1:  Pxx submatrix
+					// ====================================
+					// Replace old covariance:
+					Eigen::Block<typename KFMatrix::Base,VEH_SIZE,VEH_SIZE>(m_pkk,0,0) =
+						Q +
+						dfv_dxv * Eigen::Block<typename KFMatrix::Base,VEH_SIZE,VEH_SIZE>(m_pkk,0,0) * dfv_dxv.transpose();
+
+					// ====================================
+					//  3.2:  All Pxy_i
+					// ====================================
+					// Now, update the cov. of landmarks, if any:
+					KFMatrix_VxF aux;
+					for (size_t i=0 ; i<N_map ; i++)
+					{
+						aux = dfv_dxv * Eigen::Block<typename KFMatrix::Base,VEH_SIZE,FEAT_SIZE>(m_pkk,0,VEH_SIZE+i*FEAT_SIZE);
 
-					Eigen::Block<typename KFMatrix::Base,VEH_SIZE,FEAT_SIZE>(m_pkk, 0                    , VEH_SIZE+i*FEAT_SIZE) = aux;
-					Eigen::Block<typename KFMatrix::Base,FEAT_SIZE,VEH_SIZE>(m_pkk, VEH_SIZE+i*FEAT_SIZE , 0                   ) = aux.transpose();
+						Eigen::Block<typename KFMatrix::Base,VEH_SIZE,FEAT_SIZE>(m_pkk, 0                    , VEH_SIZE+i*FEAT_SIZE) = aux;
+						Eigen::Block<typename KFMatrix::Base,FEAT_SIZE,VEH_SIZE>(m_pkk, VEH_SIZE+i*FEAT_SIZE , 0                   ) = aux.transpose();
+					}
 				}
 
 				// =============================================================
@@ -129,7 +147,9 @@ namespace mrpt
 					m_xkk[i]=xv[i];
 
 				// Normalize, if neccesary.
-				OnNormalizeStateVector();
+				if (KF_options.method==kfSEIF)
+					seif_normalizeStateVector();
+				else OnNormalizeStateVector();
 
 			} // end if (!skipPrediction)
 
@@ -146,9 +166,12 @@ namespace mrpt
 			// Predict the observations for all the map LMs, so the user
 			//  can decide if their covariances (more costly) must be computed as well:
 			all_predictions.resize(N_map);
-			OnObservationModel(
-				mrpt::math::sequenceStdVec<size_t,1>(0,N_map),
-				all_predictions);
+			if (FEAT_SIZE==0)
+				OnObservationModel(
+					mrpt::math::sequenceStdVec<size_t,1>(0,N_map),
+					all_predictions);
+			else
+				runInBlocks(0,N_map, &KFCLASS::aux_predictObservations, 64);
 
 			const double tim_pred_obs = m_timLogger.leave("KF:3.predict all obs");
 
@@ -221,7 +244,20 @@ namespace mrpt
 				Hxs.resize(N_pred);  // Append new entries, if needed.
 				Hys.resize(N_pred);
 
-				for (size_t i=first_new_pred;i<N_pred;++i)
+				size_t first_pending_jacob = first_new_pred;
+				if (KF_options.use_analytic_observation_jacobian && !KF_options.debug_verify_analytic_jacobians && first_new_pred<N_pred)
+				{
+					// Analytic Jacobians, in parallel for large maps. The first one alone, to find out whether they are implemented:
+					m_user_didnt_implement_jacobian=false; // Set to true by the default method if not reimplemented in base class.
+					aux_analyticObservationJacobians(first_new_pred,first_new_pred+1);
+					if (!m_user_didnt_implement_jacobian)
+					{
+						runInBlocks(first_new_pred+1,N_pred, &KFCLASS::aux_analyticObservationJacobians, 32);
+						first_pending_jacob = N_pred;
+					}
+				}
+
+				for (size_t i=first_pending_jacob;i<N_pred;++i)
 				{
 					const size_t lm_idx = FEAT_SIZE==0 ? 0 : predictLMidxs[i];
 					KFMatrix_OxV &Hx = Hxs[i];
@@ -290,36 +326,17 @@ namespace mrpt
 				// ------------------------------------------
 				S.setSize(N_pred*OBS_SIZE,N_pred*OBS_SIZE);
 
-				if ( FEAT_SIZE>0 )
+				if (KF_options.method==kfSEIF)
+				{	// SEIF: the covariances are recovered from the Markov blanket of the predicted landmarks (overconfident, see getLandmarkCov()):
+					seif_buildInnovationCovariance(R);
+				}
+				else if ( FEAT_SIZE>0 )
 				{	// SLAM-like problem:
-					const Eigen::Block<const typename KFMatrix::Base,VEH_SIZE,VEH_SIZE>  Px(m_pkk,0,0);  // Covariance of the vehicle pose
+					runInBlocks(0,N_pred, &KFCLASS::aux_buildInnovationCovariance, 16);
 
+					// Sum the "R" term to the diagonal blocks:
 					for (size_t i=0;i<N_pred;++i)
 					{
-						const size_t lm_idx_i = predictLMidxs[i];
-						const Eigen::Block<const typename KFMatrix::Base,FEAT_SIZE,VEH_SIZE>   Pxyi_t(m_pkk,VEH_SIZE+lm_idx_i*FEAT_SIZE,0);  // Pxyi^t
-
-						// Only do j>=i (upper triangle), since S is symmetric:
-						for (size_t j=i;j<N_pred;++j)
-						{
-							const size_t lm_idx_j = predictLMidxs[j];
-							// Sij block:
-							Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE> Sij(S,OBS_SIZE*i,OBS_SIZE*j);
-
-							const Eigen::Block<const typename KFMatrix::Base,VEH_SIZE,FEAT_SIZE>   Pxyj(m_pkk,0, VEH_SIZE+lm_idx_j*FEAT_SIZE);
-							const Eigen::Block<const typename KFMatrix::Base,FEAT_SIZE,FEAT_SIZE>  Pyiyj(m_pkk,VEH_SIZE+lm_idx_i*FEAT_SIZE,VEH_SIZE+lm_idx_j*FEAT_SIZE);
-
-							Sij = Hxs[i] * Px * Hxs[j].transpose()
-								+ Hys[i] * Pxyi_t * Hxs[j].transpose()
-								+ Hxs[i] * Pxyj * Hys[j].transpose()
-								+ Hys[i] * Pyiyj * Hys[j].transpose();
-
-							// Copy transposed to the symmetric lower-triangular part:
-							if (i!=j)
-								Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE>(S,OBS_SIZE*j,OBS_SIZE*i) = Sij.transpose();
-						}
-
-						// Sum the "R" term to the diagonal blocks:
 						const size_t obs_idx_off = i*OBS_SIZE;
 						Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE>(S,obs_idx_off,obs_idx_off) += R;
 					}
@@ -384,159 +401,125 @@ namespace mrpt
 				case kfEKFNaive:
 				case kfIKFFull:
 					{
-						// Build the whole Jacobian dh_dx matrix
+						// The Jacobian dh_dx of the observations of known landmarks has only two non-zero blocks per observation
+						//  (vehicle & landmark), so it is never built as a whole: all the products are done block by block.
 						// ---------------------------------------------
-						// Keep only those whose DA is not -1
-						vector_int  mapIndicesForKFUpdate(data_association.size());
-						mapIndicesForKFUpdate.resize( std::distance(mapIndicesForKFUpdate.begin(),
-							std::remove_copy_if(
-							data_association.begin(),
-							data_association.end(),
-							mapIndicesForKFUpdate.begin(),
-							bind1st(equal_to<int>(),-1) ) ) );
-
-						const size_t N_upd = (FEAT_SIZE==0) ?
-							1 : 	// Non-SLAM problems: Just one observation for the entire system.
-						mapIndicesForKFUpdate.size(); // SLAM: # of observed known landmarks
-
-						// Just one, or several update iterations??
-						const size_t nKF_iterations = (KF_options.method==kfEKFNaive) ?  1 : KF_options.IKF_iterations;
-
-						const KFVector xkk_0 = m_xkk;
-
-						// For each IKF iteration (or 1 for EKF)
-						if (N_upd>0) // Do not update if we have no observations!
-						{
-							for (size_t IKF_iteration=0;IKF_iteration<nKF_iterations;IKF_iteration++)
+						// Keep only those whose DA is not -1, by their indices in predictLMidxs:
+						KFVector  ytilde;     // ytilde = OBS - PREDICTION
+						KFMatrix  S_observed; // The KF "S" matrix: A re-ordered, subset, version of the prediction S:
+						obs_pred_idxs.clear();
+
+						if (FEAT_SIZE!=0)
+						{	// SLAM problems:
+							vector_size_t S_idxs;
+							S_idxs.reserve(OBS_SIZE*data_association.size());
+							ytilde.resize(OBS_SIZE*data_association.size());
+
+							for (size_t i=0;i<data_association.size();++i)
 							{
-								// Compute ytilde = OBS - PREDICTION
-								KFVector  ytilde(OBS_SIZE*N_upd);
-								size_t    ytilde_idx = 0;
-
-								// TODO: Use a Matrix view of "dh_dx_full" instead of creating a copy into "dh_dx_full_obs"
-								dh_dx_full_obs.zeros(N_upd*OBS_SIZE, VEH_SIZE + FEAT_SIZE * N_map ); // Init to zeros.
-								KFMatrix S_observed;	// The KF "S" matrix: A re-ordered, subset, version of the prediction S:
+								if (data_association[i]<0) continue;
 
-								if (FEAT_SIZE!=0)
-								{	// SLAM problems:
-									vector_size_t S_idxs;
-									S_idxs.reserve(OBS_SIZE*N_upd);
+								const size_t assoc_idx_in_map = static_cast<size_t>(data_association[i]);
+								const size_t assoc_idx_in_pred = mrpt::utils::find_in_vector(assoc_idx_in_map, predictLMidxs);
+								ASSERTMSG_(assoc_idx_in_pred!=string::npos, "OnPreComputingPredictions() didn't recommend the prediction of a landmark which has been actually observed!")
 
-									//const size_t row_len = VEH_SIZE + FEAT_SIZE * N_map;
-
-									for (size_t i=0;i<data_association.size();++i)
-									{
-										if (data_association[i]<0) continue;
-
-										const size_t assoc_idx_in_map = static_cast<size_t>(data_association[i]);
-										const size_t assoc_idx_in_pred = mrpt::utils::find_in_vector(assoc_idx_in_map, predictLMidxs);
-										ASSERTMSG_(assoc_idx_in_pred!=string::npos, "OnPreComputingPredictions() didn't recommend the prediction of a landmark which has been actually observed!")
-											// TODO: In these cases, extend the prediction right now instead of launching an exception... or is this a bad idea??
-
-											// Build the subset dh_dx_full_obs:
-											//										dh_dx_full_obs.block(S_idxs.size()             ,0, OBS_SIZE, row_len)
-											//										=
-											//										dh_dx_full.block    (assoc_idx_in_pred*OBS_SIZE,0, OBS_SIZE, row_len);
-
-											Eigen::Block<typename KFMatrix::Base,OBS_SIZE,VEH_SIZE> (dh_dx_full_obs, S_idxs.size(),0) = Hxs[assoc_idx_in_pred];
-										Eigen::Block<typename KFMatrix::Base,OBS_SIZE,FEAT_SIZE>(dh_dx_full_obs, S_idxs.size(), VEH_SIZE+assoc_idx_in_map*FEAT_SIZE ) = Hys[assoc_idx_in_pred];
-
-										// S_idxs.size() is used as counter for "dh_dx_full_obs".
-										for (size_t k=0;k<OBS_SIZE;k++)
-											S_idxs.push_back(assoc_idx_in_pred*OBS_SIZE+k);
-
-										// ytilde_i = Z[i] - all_predictions[i]
-										KFArray_OBS ytilde_i = Z[i];
-										OnSubstractObservationVectors(ytilde_i,all_predictions[predictLMidxs[assoc_idx_in_pred]]);
-										for (size_t k=0;k<OBS_SIZE;k++)
-											ytilde[ytilde_idx++] = ytilde_i[k];
-									}
-									// Extract the subset that is involved in this observation:
-									S.extractSubmatrixSymmetrical(S_idxs,S_observed);
-								}
-								else
-								{	// Non-SLAM problems:
-									ASSERT_(Z.size()==1 && all_predictions.size()==1)
-										ASSERT_(dh_dx_full_obs.getRowCount()==OBS_SIZE && dh_dx_full_obs.getColCount()==VEH_SIZE)
-										ASSERT_(Hxs.size()==1)
-
-										dh_dx_full_obs = Hxs[0];  // Was: dh_dx_full
-									KFArray_OBS ytilde_i = Z[0];
-									OnSubstractObservationVectors(ytilde_i,all_predictions[0]);
-									for (size_t k=0;k<OBS_SIZE;k++)
-										ytilde[ytilde_idx++] = ytilde_i[k];
-									// Extract the subset that is involved in this observation:
-									S_observed = S;
+								// ytilde_i = Z[i] - all_predictions[i]
+								KFArray_OBS ytilde_i = Z[i];
+								OnSubstractObservationVectors(ytilde_i,all_predictions[assoc_idx_in_map]);
+								for (size_t k=0;k<OBS_SIZE;k++)
+								{
+									ytilde[S_idxs.size()] = ytilde_i[k];
+									S_idxs.push_back(assoc_idx_in_pred*OBS_SIZE+k);
 								}
+								obs_pred_idxs.push_back(assoc_idx_in_pred);
+							}
+							ytilde.conservativeResize(S_idxs.size());
+							// Extract the subset that is involved in this observation:
+							if (!S_idxs.empty())
+								S.extractSubmatrixSymmetrical(S_idxs,S_observed);
+						}
+						else
+						{	// Non-SLAM problems: Just one observation for the entire system.
+							ASSERT_(Z.size()==1 && all_predictions.size()==1)
+							ASSERT_(Hxs.size()==1)
+
+							KFArray_OBS ytilde_i = Z[0];
+							OnSubstractObservationVectors(ytilde_i,all_predictions[0]);
+							ytilde.resize(OBS_SIZE);
+							for (size_t k=0;k<OBS_SIZE;k++)
+								ytilde[k] = ytilde_i[k];
+							obs_pred_idxs.assign(1,0);
+							S_observed = S;
+						}
 
-								// Compute the full K matrix:
-								// ------------------------------
-								m_timLogger.enter("KF:8.update stage:1.FULLKF:build K");
+						const size_t N_upd = obs_pred_idxs.size(); // # of observed known landmarks
+						if (!N_upd) break;  // Do not update if we have no observations!
 
-								K.setSize(m_pkk.getRowCount(), S_observed.getColCount() );
+						// Compute the full K matrix:
+						// ------------------------------
+						m_timLogger.enter("KF:8.update stage:1.FULLKF:build K");
 
-								// K = m_pkk * (~dh_dx) * S.inv() );
-								K.multiply_ABt(m_pkk, dh_dx_full_obs);
+						// P_Ht = m_pkk * (~dh_dx), by blocks of rows:
+						const size_t stat_len = m_xkk.size();
+						P_Ht.setSize(stat_len, OBS_SIZE*N_upd);
+						runInBlocks(0,stat_len, &KFCLASS::aux_buildPHt, 256);
 
-								// Inverse of S_observed -> S_1
-								S_observed.inv(S_1);
-								K*=S_1;
+						// K = m_pkk * (~dh_dx) * S.inv() );
+						S_observed.inv(S_1);
+						K.setSize(stat_len, OBS_SIZE*N_upd);
+						K.noalias() = P_Ht * S_1;
 
-								m_timLogger.leave("KF:8.update stage:1.FULLKF:build K");
+						m_timLogger.leave("KF:8.update stage:1.FULLKF:build K");
 
-								// Use the full K matrix to update the mean:
-								if (nKF_iterations==1)
-								{
-									m_timLogger.enter("KF:8.update stage:2.FULLKF:update xkk");
-									m_xkk += K * ytilde;
-									m_timLogger.leave("KF:8.update stage:2.FULLKF:update xkk");
-								}
+						// Use the full K matrix to update the mean:
+						if (KF_options.method==kfEKFNaive)
+						{
+							m_timLogger.enter("KF:8.update stage:2.FULLKF:update xkk");
+							m_xkk.noalias() += K * ytilde;
+							m_timLogger.leave("KF:8.update stage:2.FULLKF:update xkk");
+						}
+						else
+						{
+							m_timLogger.enter("KF:8.update stage:2.FULLKF:iter.update xkk");
+
+							// (The linearization point is not updated, hence K is the same in all the iterations)
+							const KFVector xkk_0 = m_xkk;
+							for (int IKF_iteration=0;IKF_iteration<KF_options.IKF_iterations;IKF_iteration++)
+							{
+								// HAx_column = dh_dx * (m_xkk - xkk_0):
+								KFVector  HAx_column(OBS_SIZE*N_upd);
+								if (IKF_iteration==0)
+									HAx_column.setZero();
 								else
 								{
-									m_timLogger.enter("KF:8.update stage:2.FULLKF:iter.update xkk");
-
-									KFVector  HAx_column;
-									dh_dx_full_obs.multiply_Ab( m_xkk - xkk_0, HAx_column);
+									const KFVector Ax = m_xkk - xkk_0;
+									for (size_t k=0;k<N_upd;k++)
+									{
+										const size_t idx_in_pred = obs_pred_idxs[k];
+										KFArray_OBS HAx_k;
+										HAx_k.noalias() = Hxs[idx_in_pred] * Ax.template head<VEH_SIZE>();
+										if (FEAT_SIZE!=0)
+											HAx_k.noalias() += Hys[idx_in_pred] * Ax.template segment<FEAT_SIZE>(VEH_SIZE+predictLMidxs[idx_in_pred]*FEAT_SIZE);
+										HAx_column.template segment<OBS_SIZE>(k*OBS_SIZE) = HAx_k;
+									}
+								}
 
-									m_xkk = xkk_0;
-									K.multiply_Ab(
-										(ytilde-HAx_column),
-										m_xkk,
-										true /* Accumulate in output */
-										);
+								m_xkk = xkk_0;
+								m_xkk.noalias() += K * (ytilde-HAx_column);
+							}
 
-									m_timLogger.leave("KF:8.update stage:2.FULLKF:iter.update xkk");
-								}
+							m_timLogger.leave("KF:8.update stage:2.FULLKF:iter.update xkk");
+						}
 
-								// Update the covariance just at the end
-								//  of iterations if we are in IKF, always in normal EKF.
-								if (IKF_iteration == (nKF_iterations-1) )
-								{
-									m_timLogger.enter("KF:8.update stage:3.FULLKF:update Pkk");
-
-									// Use the full K matrix to update the covariance:
-									//m_pkk = (I - K*dh_dx ) * m_pkk;
-									// TODO: "Optimize this: sparsity!"
-
-									// K * dh_dx_full_obs
-									aux_K_dh_dx.multiply(K,dh_dx_full_obs);
-
-									// aux_K_dh_dx  <-- I-aux_K_dh_dx
-									const size_t stat_len = aux_K_dh_dx.getColCount();
-									for (size_t r=0;r<stat_len;r++) {
-										for (size_t c=0;c<stat_len;c++) {
-											if (r==c)
-												aux_K_dh_dx.get_unsafe(r,c)=-aux_K_dh_dx.get_unsafe(r,c) + kftype(1);
-											else aux_K_dh_dx.get_unsafe(r,c)=-aux_K_dh_dx.get_unsafe(r,c);
-										}
-									}
+						// Update the covariance:
+						//  m_pkk = (I - K*dh_dx ) * m_pkk = m_pkk - K * (~P_Ht)
+						//  by square tiles of the upper triangle (symmetric result), in parallel for large maps:
+						m_timLogger.enter("KF:8.update stage:3.FULLKF:update Pkk");
 
-									m_pkk.multiply_result_is_symmetric(aux_K_dh_dx, m_pkk );
+						const size_t nTiles = (stat_len+KF_aux_cov_tile_size-1)/KF_aux_cov_tile_size;
+						runInBlocks(0,nTiles*(nTiles+1)/2, &KFCLASS::aux_updateCovariance, 4);
 
-									m_timLogger.leave("KF:8.update stage:3.FULLKF:update Pkk");
-								}
-							} // end for each IKF iteration
-						}
+						m_timLogger.leave("KF:8.update stage:3.FULLKF:update Pkk");
 					}
 					break;
 
@@ -711,6 +694,15 @@ namespace mrpt
 					// --------------------------------------------------------------------
 					// - IKF method, processing each observation scalar secuentially:
 					// --------------------------------------------------------------------
+					// --------------------------------------------------------------------
+					// - SEIF: Update of the information form, constant time w.r.t. the map size
+					// --------------------------------------------------------------------
+				case kfSEIF:
+					{
+						seif_update(data_association,R);
+					}
+					break;
+
 				case kfIKF:  // TODO !!
 					{
 						THROW_EXCEPTION("IKF scalar by scalar not implemented yet.");
@@ -981,7 +973,9 @@ namespace mrpt
 			const double tim_update = m_timLogger.leave("KF:8.update stage");
 
 			m_timLogger.enter("KF:9.OnNormalizeStateVector");
-			OnNormalizeStateVector();
+			if (KF_options.method==kfSEIF)
+				seif_normalizeStateVector();
+			else OnNormalizeStateVector();
 			m_timLogger.leave("KF:9.OnNormalizeStateVector");
 
 			// =============================================================
@@ -994,6 +988,17 @@ namespace mrpt
 				m_timLogger.leave("KF:A.add new landmarks");
 			} // end if data_association!=empty
 
+			// =============================================================
+			//  9. SEIF: SPARSIFICATION & VEHICLE COVARIANCE
+			// =============================================================
+			if (KF_options.method==kfSEIF)
+			{
+				m_timLogger.enter("KF:A.SEIF sparsification");
+				seif_sparsify(data_association, N_map);
+				seif_updateVehicleCovariance();
+				m_timLogger.leave("KF:A.SEIF sparsification");
+			}
+
 			// Post iteration user code:
 			m_timLogger.enter("KF:B.OnPostIteration");
 			OnPostIteration();
@@ -1055,6 +1060,691 @@ namespace mrpt
 			out_x=prediction[0];
 		}
 
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::runInBlocks(
+			const size_t first,
+			const size_t last,
+			void (KFCLASS::*method)(size_t,size_t),
+			const size_t min_items_per_thread)
+		{
+			if (last<=first) return;
+			const size_t N = last-first;
+			const size_t max_threads = KF_options.num_threads ? KF_options.num_threads : mrpt::system::getNumberOfProcessors();
+			const unsigned int nThreads = static_cast<unsigned int>( std::min(max_threads, N/std::max<size_t>(1,min_items_per_thread)) );
+			if (nThreads<=1)
+			{
+				(this->*method)(first,last);
+				return;
+			}
+			TAuxBlockRunner runner(this,method,first);
+			mrpt::system::parallelForBlocks(N, runner, nThreads);
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::aux_predictObservations(size_t first, size_t last)
+		{
+			if (first==0 && last==all_predictions.size())
+			{
+				OnObservationModel(mrpt::math::sequenceStdVec<size_t,1>(0,last), all_predictions);
+				return;
+			}
+			vector_KFArray_OBS  predictions;
+			OnObservationModel(mrpt::math::sequenceStdVec<size_t,1>(first,last-first), predictions);
+			ASSERT_(predictions.size()==last-first)
+			std::copy(predictions.begin(),predictions.end(), all_predictions.begin()+first);
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::aux_analyticObservationJacobians(size_t first, size_t last)
+		{
+			for (size_t i=first;i<last;++i)
+				OnObservationJacobians(FEAT_SIZE==0 ? 0 : predictLMidxs[i], Hxs[i], Hys[i]);
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::aux_buildInnovationCovariance(size_t first, size_t last)
+		{
+			// Each block in S is:
+			//    Sij = Hxi Px Hxj^t + Hyi Pyix Hxj^t + Hxi Pxyj Hyj^t + Hyi Pyiyj Hyj^t
+			const size_t N_pred = predictLMidxs.size();
+			const Eigen::Block<const typename KFMatrix::Base,VEH_SIZE,VEH_SIZE>  Px(m_pkk,0,0);  // Covariance of the vehicle pose
+
+			for (size_t i=first;i<last;++i)
+			{
+				const size_t lm_idx_i = predictLMidxs[i];
+				const Eigen::Block<const typename KFMatrix::Base,FEAT_SIZE,VEH_SIZE>   Pxyi_t(m_pkk,VEH_SIZE+lm_idx_i*FEAT_SIZE,0);  // Pxyi^t
+
+				// Terms of Sij which only depend on "i":
+				const Eigen::Matrix<KFTYPE,OBS_SIZE,VEH_SIZE> Hi_Px = Hxs[i] * Px + Hys[i] * Pxyi_t;
+
+				// Only do j>=i (upper triangle), since S is symmetric. This writes the rows of blocks [first,last) and
+				// the columns of blocks [first,last) below the diagonal, so threads with disjoint ranges never write the same block.
+				for (size_t j=i;j<N_pred;++j)
+				{
+					const size_t lm_idx_j = predictLMidxs[j];
+					// Sij block:
+					Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE> Sij(S,OBS_SIZE*i,OBS_SIZE*j);
+
+					const Eigen::Block<const typename KFMatrix::Base,VEH_SIZE,FEAT_SIZE>   Pxyj(m_pkk,0, VEH_SIZE+lm_idx_j*FEAT_SIZE);
+					const Eigen::Block<const typename KFMatrix::Base,FEAT_SIZE,FEAT_SIZE>  Pyiyj(m_pkk,VEH_SIZE+lm_idx_i*FEAT_SIZE,VEH_SIZE+lm_idx_j*FEAT_SIZE);
+
+					Sij.noalias() = Hi_Px * Hxs[j].transpose();
+					Sij.noalias() += (Hxs[i] * Pxyj + Hys[i] * Pyiyj) * Hys[j].transpose();
+
+					// Copy transposed to the symmetric lower-triangular part:
+					if (i!=j)
+						Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE>(S,OBS_SIZE*j,OBS_SIZE*i) = Sij.transpose();
+				}
+			}
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::aux_buildPHt(size_t first, size_t last)
+		{
+			// Only the vehicle and the observed landmark columns of each block-row of dh_dx are non-zero:
+			const size_t nRows = last-first;
+			for (size_t k=0;k<obs_pred_idxs.size();k++)
+			{
+				const size_t idx_in_pred = obs_pred_idxs[k];
+				P_Ht.block(first,k*OBS_SIZE, nRows,OBS_SIZE).noalias() = m_pkk.block(first,0, nRows,VEH_SIZE) * Hxs[idx_in_pred].transpose();
+				if (FEAT_SIZE!=0)
+					P_Ht.block(first,k*OBS_SIZE, nRows,OBS_SIZE).noalias() += m_pkk.block(first,VEH_SIZE+predictLMidxs[idx_in_pred]*FEAT_SIZE, nRows,FEAT_SIZE) * Hys[idx_in_pred].transpose();
+			}
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::aux_updateCovariance(size_t first, size_t last)
+		{
+			const size_t n = m_pkk.getRowCount();
+			const size_t T = KF_aux_cov_tile_size;
+			const size_t nTiles = (n+T-1)/T;
+
+			// Tiles of the upper triangle are numbered row by row: find the (row,col) of the first one:
+			size_t r=0, c=first;
+			while (c>=nTiles-r) { c-=nTiles-r; r++; }
+			c+=r;
+
+			for (size_t t=first;t<last;t++)
+			{
+				const size_t r0 = r*T, c0 = c*T;
+				const size_t nr = std::min(T,n-r0), nc = std::min(T,n-c0);
+
+				m_pkk.block(r0,c0,nr,nc).noalias() -= K.block(r0,0,nr,K.getColCount()) * P_Ht.block(c0,0,nc,P_Ht.getColCount()).transpose();
+
+				// Keep the result exactly symmetric:
+				if (r!=c)
+					m_pkk.block(c0,r0,nc,nr) = m_pkk.block(r0,c0,nr,nc).transpose();
+				else
+					for (size_t i=0;i<nr;i++)
+						for (size_t j=i+1;j<nc;j++)
+							m_pkk.get_unsafe(r0+j,c0+i) = m_pkk.get_unsafe(r0+i,c0+j);
+
+				if (++c==nTiles) c=++r;
+			}
+		}
+
+
+		namespace detail
+		{
+			/** Auxiliary for kfSEIF: out = A(:,idxs) * A(idxs,idxs)^-1 * A(idxs,:), for a symmetric A. */
+			template <class MATRIX>
+			void seif_aux_schurTerm(const MATRIX &A, const vector_size_t &idxs, MATRIX &out)
+			{
+				const size_t n = A.getRowCount(), k = idxs.size();
+				MATRIX A_ci(n,k), A_ii(k,k);
+				for (size_t r=0;r<n;r++)
+					for (size_t c=0;c<k;c++)
+						A_ci.get_unsafe(r,c) = A.get_unsafe(r,idxs[c]);
+				for (size_t r=0;r<k;r++)
+					for (size_t c=0;c<k;c++)
+						A_ii.get_unsafe(r,c) = A.get_unsafe(idxs[r],idxs[c]);
+				out = A_ci * A_ii.inv() * A_ci.transpose();
+			}
+
+			/** Auxiliary for kfSEIF: removes the numerical asymmetries of A */
+			template <class MATRIX>
+			void seif_aux_symmetrize(MATRIX &A)
+			{
+				const MATRIX At = A.transpose();
+				A += At;
+				A *= 0.5;
+			}
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::getStateCovariance(KFMatrix &cov) const
+		{
+			MRPT_START
+			if (seif_isInformationFormUpToDate())
+			{
+				KFMatrix Omega;
+				seif_getLocalInformation(mrpt::math::sequenceStdVec<size_t,1>(0,getNumberOfLandmarksInTheMap()), Omega);
+				Omega.inv(cov);
+			}
+			else cov = m_pkk;
+			MRPT_END
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::recoverMean()
+		{
+			MRPT_START
+			if (!seif_isInformationFormUpToDate())
+				return;
+
+			const size_t N = getNumberOfLandmarksInTheMap();
+#if EIGEN_VERSION_AT_LEAST(3,1,0)
+			// Build the sparse information matrix from its non-zero blocks:
+			std::vector< Eigen::Triplet<KFTYPE> > triplets;
+			triplets.reserve(VEH_SIZE*VEH_SIZE + FEAT_SIZE*FEAT_SIZE*(N+2*m_seif_Oxy.size()));
+			for (size_t r=0;r<VEH_SIZE;r++)
+				for (size_t c=0;c<VEH_SIZE;c++)
+					triplets.push_back(Eigen::Triplet<KFTYPE>(r,c,m_seif_Oxx.get_unsafe(r,c)));
+			for (typename seif_links_VxF_t::const_iterator it=m_seif_Oxy.begin();it!=m_seif_Oxy.end();++it)
+			{
+				const size_t off = VEH_SIZE+FEAT_SIZE*it->first;
+				for (size_t r=0;r<VEH_SIZE;r++)
+					for (size_t c=0;c<FEAT_SIZE;c++)
+					{
+						triplets.push_back(Eigen::Triplet<KFTYPE>(r,off+c,it->second.get_unsafe(r,c)));
+						triplets.push_back(Eigen::Triplet<KFTYPE>(off+c,r,it->second.get_unsafe(r,c)));
+					}
+			}
+			for (size_t i=0;i<N;i++)
+			{
+				const size_t off_i = VEH_SIZE+FEAT_SIZE*i;
+				for (size_t r=0;r<FEAT_SIZE;r++)
+					for (size_t c=0;c<FEAT_SIZE;c++)
+						triplets.push_back(Eigen::Triplet<KFTYPE>(off_i+r,off_i+c,m_seif_Oyy[i].get_unsafe(r,c)));
+				for (typename seif_links_FxF_t::const_iterator it=m_seif_Oyy_links[i].begin();it!=m_seif_Oyy_links[i].end();++it)
+				{
+					const size_t off_j = VEH_SIZE+FEAT_SIZE*it->first;
+					for (size_t r=0;r<FEAT_SIZE;r++)
+						for (size_t c=0;c<FEAT_SIZE;c++)
+							triplets.push_back(Eigen::Triplet<KFTYPE>(off_i+r,off_j+c,it->second.get_unsafe(r,c)));
+				}
+			}
+			Eigen::SparseMatrix<KFTYPE> Omega(m_xkk.size(),m_xkk.size());
+			Omega.setFromTriplets(triplets.begin(),triplets.end());
+
+			// Solve Omega * mu = xi:
+			Eigen::SimplicialLLT< Eigen::SparseMatrix<KFTYPE> > solver;
+			solver.compute(Omega);
+			ASSERTMSG_(solver.info()==Eigen::Success, "kfSEIF: The information matrix is not positive definite")
+			m_xkk = solver.solve(m_seif_xi);
+#else
+			KFMatrix Omega;
+			seif_getLocalInformation(mrpt::math::sequenceStdVec<size_t,1>(0,N), Omega);
+			m_xkk = Omega.llt().solve(m_seif_xi);
+#endif
+			seif_normalizeStateVector();
+			MRPT_END
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		bool CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_isInformationFormUpToDate() const
+		{
+			return KF_options.method==kfSEIF && m_seif_valid &&
+				m_seif_Oyy.size()==getNumberOfLandmarksInTheMap() &&
+				m_pkk.getRowCount()==VEH_SIZE && m_pkk.getColCount()==VEH_SIZE &&
+				m_pkk==m_seif_last_Pxx;
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_initInformationForm()
+		{
+			MRPT_START
+			const size_t N = getNumberOfLandmarksInTheMap();
+			const size_t n = m_xkk.size();
+			ASSERTMSG_(m_pkk.getRowCount()==n && m_pkk.getColCount()==n, "kfSEIF: The information form can only be built from the full covariance of the state vector")
+
+			// Avoid a singular covariance for perfectly known variables (e.g. the initial robot pose):
+			KFMatrix P = m_pkk;
+			for (size_t i=0;i<n;i++)
+				P.get_unsafe(i,i) = std::max(P.get_unsafe(i,i), KFTYPE(1e-6));
+			KFMatrix Omega;
+			P.inv(Omega);
+
+			Omega.extractMatrix(0,0,m_seif_Oxx);
+			m_seif_Oxy.clear();
+			m_seif_Oyy.resize(N);
+			m_seif_Oyy_links.assign(N, seif_links_FxF_t());
+			for (size_t i=0;i<N;i++)
+			{
+				const size_t off_i = VEH_SIZE+FEAT_SIZE*i;
+				KFMatrix_VxF Oxy(mrpt::math::UNINITIALIZED_MATRIX);
+				Omega.extractMatrix(0,off_i,Oxy);
+				if ((Oxy.array()!=KFTYPE(0)).any())
+					m_seif_Oxy[i] = Oxy;
+				Omega.extractMatrix(off_i,off_i,m_seif_Oyy[i]);
+				for (size_t j=0;j<N;j++)
+				{
+					if (i==j) continue;
+					KFMatrix_FxF Oyy(mrpt::math::UNINITIALIZED_MATRIX);
+					Omega.extractMatrix(off_i,VEH_SIZE+FEAT_SIZE*j,Oyy);
+					if ((Oyy.array()!=KFTYPE(0)).any())
+						m_seif_Oyy_links[i][j] = Oyy;
+				}
+			}
+			m_seif_xi = Omega * m_xkk;
+
+			// From now on, m_pkk only holds the vehicle covariance:
+			m_pkk.extractMatrix(0,0,m_seif_last_Pxx);
+			m_pkk = m_seif_last_Pxx;
+			m_seif_valid = true;
+			MRPT_END
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_getActiveLandmarks(vector_size_t &lms) const
+		{
+			lms.clear();
+			lms.reserve(m_seif_Oxy.size());
+			for (typename seif_links_VxF_t::const_iterator it=m_seif_Oxy.begin();it!=m_seif_Oxy.end();++it)
+				lms.push_back(it->first);
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_getMarkovBlanket(const vector_size_t &lms, vector_size_t &blanket) const
+		{
+			seif_getActiveLandmarks(blanket);
+			for (size_t i=0;i<lms.size();i++)
+			{
+				blanket.push_back(lms[i]);
+				const seif_links_FxF_t &links = m_seif_Oyy_links[lms[i]];
+				for (typename seif_links_FxF_t::const_iterator it=links.begin();it!=links.end();++it)
+					blanket.push_back(it->first);
+			}
+			std::sort(blanket.begin(),blanket.end());
+			blanket.erase(std::unique(blanket.begin(),blanket.end()), blanket.end());
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_getLocalInformation(const vector_size_t &lms, KFMatrix &Omega) const
+		{
+			const size_t nL = lms.size();
+			Omega.zeros(VEH_SIZE+FEAT_SIZE*nL,VEH_SIZE+FEAT_SIZE*nL);
+			Omega.insertMatrix(0,0,m_seif_Oxx);
+			for (size_t a=0;a<nL;a++)
+			{
+				const size_t i = lms[a];
+				const size_t off_i = VEH_SIZE+FEAT_SIZE*a;
+				Omega.insertMatrix(off_i,off_i,m_seif_Oyy[i]);
+
+				const typename seif_links_VxF_t::const_iterator itX = m_seif_Oxy.find(i);
+				if (itX!=m_seif_Oxy.end())
+				{
+					Omega.insertMatrix(0,off_i,itX->second);
+					Omega.insertMatrixTranspose(off_i,0,itX->second);
+				}
+
+				// Links j>i, each one also fills its symmetric block:
+				const seif_links_FxF_t &links = m_seif_Oyy_links[i];
+				for (typename seif_links_FxF_t::const_iterator it=links.upper_bound(i);it!=links.end();++it)
+				{
+					const vector_size_t::const_iterator itB = std::lower_bound(lms.begin(),lms.end(),it->first);
+					if (itB==lms.end() || *itB!=it->first) continue;
+					const size_t off_j = VEH_SIZE+FEAT_SIZE*(itB-lms.begin());
+					Omega.insertMatrix(off_i,off_j,it->second);
+					Omega.insertMatrixTranspose(off_j,off_i,it->second);
+				}
+			}
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_addToLocalInformation(const vector_size_t &lms, const KFMatrix &delta)
+		{
+			const size_t nL = lms.size();
+			ASSERTDEB_(delta.getRowCount()==VEH_SIZE+FEAT_SIZE*nL && delta.getColCount()==VEH_SIZE+FEAT_SIZE*nL)
+
+			KFMatrix_VxV dxx(mrpt::math::UNINITIALIZED_MATRIX);
+			delta.extractMatrix(0,0,dxx);
+			m_seif_Oxx += dxx;
+			for (size_t a=0;a<nL;a++)
+			{
+				const size_t i = lms[a];
+				const size_t off_i = VEH_SIZE+FEAT_SIZE*a;
+
+				KFMatrix_VxF dxy(mrpt::math::UNINITIALIZED_MATRIX);
+				delta.extractMatrix(0,off_i,dxy);
+				if ((dxy.array()!=KFTYPE(0)).any())
+					m_seif_Oxy[i] += dxy;
+
+				KFMatrix_FxF dyy(mrpt::math::UNINITIALIZED_MATRIX);
+				delta.extractMatrix(off_i,off_i,dyy);
+				m_seif_Oyy[i] += dyy;
+
+				for (size_t b=a+1;b<nL;b++)
+				{
+					const size_t j = lms[b];
+					delta.extractMatrix(off_i,VEH_SIZE+FEAT_SIZE*b,dyy);
+					if (!(dyy.array()!=KFTYPE(0)).any()) continue;
+					m_seif_Oyy_links[i][j] += dyy;
+					m_seif_Oyy_links[j][i] += dyy.transpose();
+				}
+			}
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_getInformationTimesMean(const vector_size_t &lms, KFVector &Omega_mu) const
+		{
+			const size_t nL = lms.size();
+			Omega_mu.resize(VEH_SIZE+FEAT_SIZE*nL);
+
+			Omega_mu.template head<VEH_SIZE>() = m_seif_Oxx * m_xkk.template head<VEH_SIZE>();
+			for (typename seif_links_VxF_t::const_iterator it=m_seif_Oxy.begin();it!=m_seif_Oxy.end();++it)
+				Omega_mu.template head<VEH_SIZE>() += it->second * m_xkk.template segment<FEAT_SIZE>(VEH_SIZE+FEAT_SIZE*it->first);
+
+			for (size_t a=0;a<nL;a++)
+			{
+				const size_t i = lms[a];
+				Eigen::VectorBlock<KFVector,FEAT_SIZE> row_i = Omega_mu.template segment<FEAT_SIZE>(VEH_SIZE+FEAT_SIZE*a);
+				row_i = m_seif_Oyy[i] * m_xkk.template segment<FEAT_SIZE>(VEH_SIZE+FEAT_SIZE*i);
+
+				const typename seif_links_VxF_t::const_iterator itX = m_seif_Oxy.find(i);
+				if (itX!=m_seif_Oxy.end())
+					row_i += itX->second.transpose() * m_xkk.template head<VEH_SIZE>();
+
+				const seif_links_FxF_t &links = m_seif_Oyy_links[i];
+				for (typename seif_links_FxF_t::const_iterator it=links.begin();it!=links.end();++it)
+					row_i += it->second * m_xkk.template segment<FEAT_SIZE>(VEH_SIZE+FEAT_SIZE*it->first);
+			}
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_addToInformationVector(const vector_size_t &lms, const KFVector &delta)
+		{
+			ASSERTDEB_(size_t(delta.size())==VEH_SIZE+FEAT_SIZE*lms.size())
+			m_seif_xi.template head<VEH_SIZE>() += delta.template head<VEH_SIZE>();
+			for (size_t a=0;a<lms.size();a++)
+				m_seif_xi.template segment<FEAT_SIZE>(VEH_SIZE+FEAT_SIZE*lms[a]) += delta.template segment<FEAT_SIZE>(VEH_SIZE+FEAT_SIZE*a);
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_getLandmarkCov(size_t idx, KFMatrix_FxF &feat_cov) const
+		{
+			vector_size_t blanket;
+			seif_getMarkovBlanket(vector_size_t(1,idx), blanket);
+
+			KFMatrix Omega, Sigma;
+			seif_getLocalInformation(blanket,Omega);
+			Omega.inv(Sigma);
+
+			const size_t pos = std::lower_bound(blanket.begin(),blanket.end(),idx)-blanket.begin();
+			Sigma.extractMatrix(VEH_SIZE+FEAT_SIZE*pos,VEH_SIZE+FEAT_SIZE*pos,feat_cov);
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_predict(const KFMatrix_VxV &dfv_dxv, const KFMatrix_VxV &Q, const KFArray_VEH &xv)
+		{
+			// Only the vehicle and the active landmarks are affected by the prediction:
+			vector_size_t act;
+			seif_getActiveLandmarks(act);
+
+			KFMatrix Omega;
+			seif_getLocalInformation(act,Omega);
+			KFVector Omega_mu_old;
+			seif_getInformationTimesMean(act,Omega_mu_old);
+			const size_t n = Omega.getColCount();
+
+			// Linear transformation of the vehicle, x'=F*x:  Omega_A = F^-T * Omega * F^-1
+			KFMatrix_VxV F_inv(mrpt::math::UNINITIALIZED_MATRIX);
+			dfv_dxv.inv(F_inv);
+			KFMatrix Omega_new = Omega;
+			Omega_new.block(0,0,VEH_SIZE,n) = F_inv.transpose() * Omega_new.block(0,0,VEH_SIZE,n);
+			Omega_new.block(0,0,n,VEH_SIZE) = Omega_new.block(0,0,n,VEH_SIZE) * F_inv;
+
+			// Additive noise, by the matrix inversion lemma:
+			//  Omega' = Omega_A - Omega_A(:,x) * (I + Q * Omega_A(x,x))^-1 * Q * Omega_A(x,:)
+			KFMatrix_VxV Oxx(mrpt::math::UNINITIALIZED_MATRIX);
+			Omega_new.extractMatrix(0,0,Oxx);
+			KFMatrix_VxV I_QO = Q * Oxx;
+			for (size_t i=0;i<VEH_SIZE;i++)
+				I_QO.get_unsafe(i,i) += KFTYPE(1);
+			const KFMatrix_VxV M = I_QO.inv() * Q;
+			const KFMatrix C = Omega_new.block(0,0,n,VEH_SIZE);
+			Omega_new -= C * M * C.transpose();
+			detail::seif_aux_symmetrize(Omega_new);
+
+			Omega_new -= Omega;
+			seif_addToLocalInformation(act,Omega_new);
+
+			// New mean of the vehicle, and keep xi = Omega * mu:
+			for (size_t i=0;i<VEH_SIZE;i++)
+				m_xkk[i]=xv[i];
+			KFVector Omega_mu_new;
+			seif_getInformationTimesMean(act,Omega_mu_new);
+			seif_addToInformationVector(act,Omega_mu_new-Omega_mu_old);
+
+			seif_updateVehicleCovariance();
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_buildInnovationCovariance(const KFMatrix_OxO &R)
+		{
+			const size_t N_pred = predictLMidxs.size();
+			if (!N_pred) return;
+
+			// Covariance of the vehicle & predicted landmarks, from their Markov blanket (an overconfident approximation):
+			vector_size_t blanket;
+			seif_getMarkovBlanket(predictLMidxs, blanket);
+			KFMatrix Omega, Sigma;
+			seif_getLocalInformation(blanket,Omega);
+			Omega.inv(Sigma);
+
+			vector_size_t offs(N_pred);
+			for (size_t i=0;i<N_pred;++i)
+				offs[i] = VEH_SIZE+FEAT_SIZE*(std::lower_bound(blanket.begin(),blanket.end(),predictLMidxs[i])-blanket.begin());
+
+			// The same than the EKF, with the covariance blocks taken from Sigma:
+			const Eigen::Block<const typename KFMatrix::Base,VEH_SIZE,VEH_SIZE>  Px(Sigma,0,0);
+			for (size_t i=0;i<N_pred;++i)
+			{
+				const Eigen::Block<const typename KFMatrix::Base,FEAT_SIZE,VEH_SIZE>   Pxyi_t(Sigma,offs[i],0);
+				for (size_t j=i;j<N_pred;++j)
+				{
+					Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE> Sij(S,OBS_SIZE*i,OBS_SIZE*j);
+
+					const Eigen::Block<const typename KFMatrix::Base,VEH_SIZE,FEAT_SIZE>   Pxyj(Sigma,0,offs[j]);
+					const Eigen::Block<const typename KFMatrix::Base,FEAT_SIZE,FEAT_SIZE>  Pyiyj(Sigma,offs[i],offs[j]);
+
+					Sij = Hxs[i] * Px * Hxs[j].transpose()
+						+ Hys[i] * Pxyi_t * Hxs[j].transpose()
+						+ Hxs[i] * Pxyj * Hys[j].transpose()
+						+ Hys[i] * Pyiyj * Hys[j].transpose();
+
+					if (i!=j)
+						Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE>(S,OBS_SIZE*j,OBS_SIZE*i) = Sij.transpose();
+				}
+				Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE>(S,OBS_SIZE*i,OBS_SIZE*i) += R;
+			}
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_update(const vector_int &data_association, const KFMatrix_OxO &R)
+		{
+			KFMatrix_OxO R_inv(mrpt::math::UNINITIALIZED_MATRIX);
+			R.inv(R_inv);
+
+			bool any_update = false;
+			for (size_t i=0;i<data_association.size();++i)
+			{
+				if (data_association[i]<0) continue;
+				const size_t lm_idx = static_cast<size_t>(data_association[i]);
+				const size_t idx_in_pred = mrpt::utils::find_in_vector(lm_idx, predictLMidxs);
+				ASSERTMSG_(idx_in_pred!=std::string::npos, "OnPreComputingPredictions() didn't recommend the prediction of a landmark which has been actually observed!")
+				const KFMatrix_OxV &Hx = Hxs[idx_in_pred];
+				const KFMatrix_OxF &Hy = Hys[idx_in_pred];
+				const size_t off = VEH_SIZE+FEAT_SIZE*lm_idx;
+
+				// Linearized observation: z - h(mu) + H*mu
+				KFArray_OBS z_lin = Z[i];
+				OnSubstractObservationVectors(z_lin,all_predictions[lm_idx]);
+				z_lin += Hx * m_xkk.template head<VEH_SIZE>() + Hy * m_xkk.template segment<FEAT_SIZE>(off);
+
+				// Omega += H^t * R^-1 * H ,  xi += H^t * R^-1 * z_lin
+				const KFMatrix_VxO HxtRi = Hx.transpose() * R_inv;
+				const KFMatrix_FxO HytRi = Hy.transpose() * R_inv;
+				m_seif_Oxx += HxtRi * Hx;
+				m_seif_Oxy[lm_idx] += HxtRi * Hy;  // This makes the landmark active, if it wasn't.
+				m_seif_Oyy[lm_idx] += HytRi * Hy;
+				m_seif_xi.template head<VEH_SIZE>() += HxtRi * z_lin;
+				m_seif_xi.template segment<FEAT_SIZE>(off) += HytRi * z_lin;
+				any_update = true;
+			}
+
+			// Amortized mean recovery: only for the vehicle & active landmarks (which include all the observed ones):
+			if (any_update)
+			{
+				vector_size_t act;
+				seif_getActiveLandmarks(act);
+				seif_recoverLocalMean(act);
+			}
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_recoverLocalMean(const vector_size_t &lms)
+		{
+			// Solve Omega_BB * mu_B = xi_B - Omega_B,rest * mu_rest  <=>  Omega_BB * Delta_mu_B = xi_B - (Omega*mu)_B
+			KFVector residual;
+			seif_getInformationTimesMean(lms,residual);
+			residual = -residual;
+			residual.template head<VEH_SIZE>() += m_seif_xi.template head<VEH_SIZE>();
+			for (size_t a=0;a<lms.size();a++)
+				residual.template segment<FEAT_SIZE>(VEH_SIZE+FEAT_SIZE*a) += m_seif_xi.template segment<FEAT_SIZE>(VEH_SIZE+FEAT_SIZE*lms[a]);
+
+			KFMatrix Omega;
+			seif_getLocalInformation(lms,Omega);
+			const KFVector Delta_mu = Omega.llt().solve(residual);
+
+			m_xkk.template head<VEH_SIZE>() += Delta_mu.template head<VEH_SIZE>();
+			for (size_t a=0;a<lms.size();a++)
+				m_xkk.template segment<FEAT_SIZE>(VEH_SIZE+FEAT_SIZE*lms[a]) += Delta_mu.template segment<FEAT_SIZE>(VEH_SIZE+FEAT_SIZE*a);
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_normalizeStateVector()
+		{
+			const KFArray_VEH xv_old( &m_xkk[0] );
+			OnNormalizeStateVector();
+
+			KFArray_VEH dx;
+			for (size_t i=0;i<VEH_SIZE;i++)
+				dx[i] = m_xkk[i]-xv_old[i];
+			if (!(dx.array()!=KFTYPE(0)).any())
+				return;
+
+			// Keep xi = Omega * mu for the normalized mean:
+			m_seif_xi.template head<VEH_SIZE>() += m_seif_Oxx * dx;
+			for (typename seif_links_VxF_t::const_iterator it=m_seif_Oxy.begin();it!=m_seif_Oxy.end();++it)
+				m_seif_xi.template segment<FEAT_SIZE>(VEH_SIZE+FEAT_SIZE*it->first) += it->second.transpose() * dx;
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_addNewLandmark(const KFMatrix_FxV &dyn_dxv, const KFMatrix_FxF &yn_cov)
+		{
+			const size_t idx = m_seif_Oyy.size();
+			const size_t off = VEH_SIZE+FEAT_SIZE*idx;
+			ASSERT_(size_t(m_xkk.size())==off+FEAT_SIZE)
+
+			// y_n = y(x,z) is a new factor between the vehicle and the new landmark:
+			//  Omega_xx += G^t * C^-1 * G , Omega_xy = -G^t * C^-1 , Omega_yy = C^-1
+			KFMatrix_FxF yn_cov_inv(mrpt::math::UNINITIALIZED_MATRIX);
+			yn_cov.inv(yn_cov_inv);
+			const KFMatrix_VxF Gt_Cinv = dyn_dxv.transpose() * yn_cov_inv;
+
+			m_seif_Oxx += Gt_Cinv * dyn_dxv;
+			m_seif_Oxy[idx] = -Gt_Cinv;
+			m_seif_Oyy.push_back(yn_cov_inv);
+			m_seif_Oyy_links.push_back(seif_links_FxF_t());
+
+			// xi += Delta_Omega * mu:
+			KFArray_FEAT d;
+			d = m_xkk.template segment<FEAT_SIZE>(off) - dyn_dxv * m_xkk.template head<VEH_SIZE>();
+			m_seif_xi.conservativeResize(m_xkk.size());
+			m_seif_xi.template head<VEH_SIZE>() -= Gt_Cinv * d;
+			m_seif_xi.template segment<FEAT_SIZE>(off) = yn_cov_inv * d;
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_sparsify(const vector_int &data_association, const size_t first_new_landmark)
+		{
+			const size_t max_active = std::max(0,KF_options.SEIF_max_active_landmarks);
+			if (m_seif_Oxy.size()<=max_active)
+				return;
+
+			// Deactivate the landmarks with the weakest links to the vehicle, except those just observed:
+			std::vector< std::pair<KFTYPE,size_t> > candidates;
+			for (typename seif_links_VxF_t::const_iterator it=m_seif_Oxy.begin();it!=m_seif_Oxy.end();++it)
+			{
+				if (it->first>=first_new_landmark ||
+					std::find(data_association.begin(),data_association.end(),static_cast<int>(it->first))!=data_association.end())
+					continue;
+				candidates.push_back(std::make_pair(it->second.norm(),it->first));
+			}
+			const size_t nDeactivate = std::min(candidates.size(), m_seif_Oxy.size()-max_active);
+			if (!nDeactivate)
+				return;
+			std::sort(candidates.begin(),candidates.end());
+
+			vector_size_t m0(nDeactivate);
+			for (size_t k=0;k<nDeactivate;k++)
+				m0[k]=candidates[k].second;
+			std::sort(m0.begin(),m0.end());
+
+			vector_size_t act;
+			seif_getActiveLandmarks(act);
+			KFMatrix Omega;
+			seif_getLocalInformation(act,Omega);
+			KFVector Omega_mu_old;
+			seif_getInformationTimesMean(act,Omega_mu_old);
+
+			// Indices in Omega of: the vehicle (x), the landmarks to deactivate (m0), and both:
+			vector_size_t idx_x, idx_m0;
+			for (size_t k=0;k<VEH_SIZE;k++)
+				idx_x.push_back(k);
+			for (size_t a=0;a<m0.size();a++)
+			{
+				const size_t off = VEH_SIZE+FEAT_SIZE*(std::lower_bound(act.begin(),act.end(),m0[a])-act.begin());
+				for (size_t k=0;k<FEAT_SIZE;k++)
+					idx_m0.push_back(off+k);
+			}
+			vector_size_t idx_xm0 = idx_x;
+			idx_xm0.insert(idx_xm0.end(),idx_m0.begin(),idx_m0.end());
+
+			// SEIF sparsification (Thrun et al.), with all the terms restricted to the vehicle & active landmarks:
+			//  Omega' = Omega + Omega(:,xm0)Omega(xm0,xm0)^-1 Omega(xm0,:) - Omega(:,m0)Omega(m0,m0)^-1 Omega(m0,:) - Omega(:,x)Omega(x,x)^-1 Omega(x,:)
+			//  which makes zero the vehicle-m0 blocks.
+			KFMatrix delta, T;
+			detail::seif_aux_schurTerm(Omega,idx_xm0,delta);
+			detail::seif_aux_schurTerm(Omega,idx_m0,T);
+			delta -= T;
+			detail::seif_aux_schurTerm(Omega,idx_x,T);
+			delta -= T;
+			detail::seif_aux_symmetrize(delta);
+
+			seif_addToLocalInformation(act,delta);
+			for (size_t a=0;a<m0.size();a++)
+				m_seif_Oxy.erase(m0[a]);
+
+			KFVector Omega_mu_new;
+			seif_getInformationTimesMean(act,Omega_mu_new);
+			seif_addToInformationVector(act,Omega_mu_new-Omega_mu_old);
+		}
+
+		template <size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE, typename KFTYPE>
+		void CKalmanFilterCapable<VEH_SIZE,OBS_SIZE,FEAT_SIZE,ACT_SIZE,KFTYPE>::seif_updateVehicleCovariance()
+		{
+			vector_size_t act;
+			seif_getActiveLandmarks(act);
+			KFMatrix Omega, Sigma;
+			seif_getLocalInformation(act,Omega);
+			Omega.inv(Sigma);
+
+			Sigma.extractMatrix(0,0,m_seif_last_Pxx);
+			m_pkk = m_seif_last_Pxx;
+		}
+
 
 		namespace detail
 		{
@@ -1115,6 +1805,19 @@ namespace mrpt
 						for (q=0;q<FEAT_SIZE;q++)
 							obj.internal_getXkk()[idx+q] = yn[q];
 
+						if (obj.KF_options.method==kfSEIF)
+						{
+							// Only the new landmark uncertainty wrt the vehicle goes into the information matrix:
+							typename KF::KFMatrix_FxF yn_cov(mrpt::math::UNINITIALIZED_MATRIX);
+							if (use_dyn_dhn_jacobian)
+								dyn_dhn.multiply_HCHt(R, yn_cov);
+							else yn_cov = dyn_dhn_R_dyn_dhnT;
+
+							obj.seif_addNewLandmark(dyn_dxv, yn_cov);
+							obj.getProfiler().leave("KF:9.create new LMs");
+							continue;
+						}
+
 						// --------------------
 						// Append to Pkk:
 						// --------------------
@@ -12,6 +12,8 @@
 #include <mrpt/utils/utils_defs.h>
 #include <mrpt/bayes/CProbabilityParticle.h>
 #include <mrpt/random.h>
+#include <mrpt/system/threads.h>
+#include <algorithm>
 
 namespace mrpt
 {
@@ -50,22 +52,10 @@ namespace bayes
 		{
 			MRPT_START
 
-			TStateSpace							x;
 			typename std::vector<TParticle>::iterator	it;
 
 			// Set output size:
-			if ( outSamples.size() != desiredSamples )
-			{
-				// Free old memory:
-				for (it = outSamples.begin();it!=outSamples.end();++it)
-					delete (it->d);
-				outSamples.clear();
-
-				// Reserve new memory:
-				outSamples.resize( desiredSamples );
-				for (it = outSamples.begin();it!=outSamples.end();++it)
-					it->d = new TStateSpace;
-			}
+			RS_aux_resizeOutput(desiredSamples,outSamples);
 
 			// Rejection sampling loop:
 			double	acceptanceProb;
@@ -102,15 +92,199 @@ namespace bayes
 			MRPT_END
 		}
 
+		/** Generates a set of N independent samples via rejection sampling, drawing and evaluating the candidates in blocks, in parallel.
+		  *  Each thread draws its candidates from its own random generator (seeded from mrpt::random::randomGenerator), and
+		  *  stops as soon as it has accepted its share of the samples still needed, so few candidates are wasted once
+		  *  enough samples are accepted. The size of the blocks adapts to the acceptance rate observed so far.
+		  *
+		  *  The accepted samples are distributed as in rejectionSampling() and have a zero log-weight. The limit of trials is
+		  *  desiredSamples*timeoutTrials candidates in total: if it is reached, the remaining samples are the most likely
+		  *  rejected candidates, with their likelihood as importance weight. A "timeoutTrials" of 0 is taken as 1 (one candidate per sample).
+		  *  Each thread only keeps its accepted candidates and its most likely rejected ones, not all the candidates it draws.
+		  *
+		  *  Threads are only used if the derived class supports it (see RS_isThreadSafe()); otherwise, all the blocks are
+		  *  processed by the calling thread.
+		  * \param num_threads The maximum number of threads (0: one per core).
+		  * \sa rejectionSampling
+		  */
+		void rejectionSamplingParallel(
+			size_t							desiredSamples,
+			std::vector<TParticle>			&outSamples,
+			size_t							timeoutTrials = 1000,
+			unsigned int					num_threads = 0)
+		{
+			MRPT_START
+
+			RS_aux_resizeOutput(desiredSamples,outSamples);
+			if (!desiredSamples) return;
+
+			if (!RS_isThreadSafe()) num_threads=1;
+			else if (!num_threads) num_threads = mrpt::system::getNumberOfProcessors();
+
+			const size_t maxTrials = desiredSamples*std::max<size_t>(timeoutTrials,1);
+			size_t nAccepted = 0, nTrials = 0;
+			std::vector<std::pair<double,TStateSpace> > bestRejected; // Most likely rejected candidates, for timeouts
+
+			std::vector<TRSBlock> blocks(num_threads);
+			while (nAccepted<desiredSamples && nTrials<maxTrials)
+			{
+				// Number of candidates for this round: enough for the samples still needed with the acceptance rate so far:
+				const size_t nNeeded = desiredSamples-nAccepted;
+				const double acceptRate = nAccepted ? double(nAccepted)/nTrials : (nTrials ? 1.0/nTrials : 1.0);
+				size_t nCandidates = static_cast<size_t>( std::min<double>( 1.2*nNeeded/acceptRate + 16*num_threads, double(maxTrials-nTrials) ) );
+				nCandidates = std::max<size_t>(nCandidates,1);
+
+				const unsigned int nBlocks = static_cast<unsigned int>( std::min<size_t>(num_threads,nCandidates) );
+				for (unsigned int b=0;b<nBlocks;b++)
+				{
+					TRSBlock &blk = blocks[b];
+					blk.nCandidates = nCandidates/nBlocks + (b<nCandidates%nBlocks ? 1:0);
+					blk.maxAccepted = (nNeeded+nBlocks-1)/nBlocks;
+					blk.maxRejected = nNeeded;
+					blk.rng.randomize( mrpt::random::randomGenerator.drawUniform32bit() );
+				}
+
+				TRSBlockRunner runner(*this,blocks);
+				if (nBlocks>1)
+					mrpt::system::parallelForBlocks(nBlocks,runner,nBlocks);
+				else runner(0,1,0);
+
+				// Merge the blocks, in order:
+				for (unsigned int b=0;b<nBlocks;b++)
+				{
+					const TRSBlock &blk = blocks[b];
+					nTrials+=blk.nDrawn;
+					for (size_t k=0;k<blk.accepted.size() && nAccepted<desiredSamples;k++,nAccepted++)
+					{
+						*outSamples[nAccepted].d = blk.accepted[k];
+						outSamples[nAccepted].log_w = 0; // log(1.0);
+					}
+					bestRejected.insert(bestRejected.end(),blk.bestRejected.begin(),blk.bestRejected.end());
+				}
+
+				// Only keep as many rejected candidates as samples may be missing:
+				const size_t nKeep = desiredSamples-nAccepted;
+				if (bestRejected.size()>nKeep)
+				{
+					std::nth_element(bestRejected.begin(),bestRejected.begin()+nKeep,bestRejected.end(),TRSGreaterLik());
+					bestRejected.resize(nKeep);
+				}
+			}
+
+			// Timeout: use the most likely rejected candidates:
+			std::sort(bestRejected.begin(),bestRejected.end(),TRSGreaterLik());
+			for (size_t k=0;nAccepted<desiredSamples && k<bestRejected.size();k++,nAccepted++)
+			{
+				*outSamples[nAccepted].d = bestRejected[k].second;
+				outSamples[nAccepted].log_w = log(bestRejected[k].first);
+			}
+			ASSERT_(nAccepted==desiredSamples)
+
+			MRPT_END
+		}
+
 	protected:
 		/** Generates one sample, drawing from some proposal distribution.
 		  */
 		virtual void RS_drawFromProposal( TStateSpace &outSample ) = 0;
 
+		/** Generates one sample, drawing from some proposal distribution with the given random generator.
+		  *  Used by rejectionSamplingParallel(). By default, it ignores "rng" and calls RS_drawFromProposal(outSample).
+		  */
+		virtual void RS_drawFromProposal( TStateSpace &outSample, mrpt::random::CRandomGenerator &rng )
+		{
+			MRPT_UNUSED_PARAM(rng);
+			RS_drawFromProposal(outSample);
+		}
+
+		/** Return true if RS_drawFromProposal(TStateSpace&,CRandomGenerator&) and RS_observationLikelihood() can be called from
+		  *  several threads at once (default: false), so rejectionSamplingParallel() may use more than one thread.
+		  */
+		virtual bool RS_isThreadSafe() const
+		{
+			return false;
+		}
+
 		/** Returns the NORMALIZED observation likelihood (linear, not exponential!!!) at a given point of the state space (values in the range [0,1]).
 		  */
 		virtual double RS_observationLikelihood( const TStateSpace &x) = 0;
 
+	private:
+		/** Resizes the output list of samples, allocating the memory of new ones */
+		static void RS_aux_resizeOutput(size_t desiredSamples, std::vector<TParticle> &outSamples)
+		{
+			typename std::vector<TParticle>::iterator	it;
+			if ( outSamples.size() != desiredSamples )
+			{
+				// Free old memory:
+				for (it = outSamples.begin();it!=outSamples.end();++it)
+					delete (it->d);
+				outSamples.clear();
+
+				// Reserve new memory:
+				outSamples.resize( desiredSamples );
+				for (it = outSamples.begin();it!=outSamples.end();++it)
+					it->d = new TStateSpace;
+			}
+		}
+
+		/** The candidates drawn by one thread in rejectionSamplingParallel(): only the accepted ones, and the most likely rejected ones */
+		struct TRSBlock
+		{
+			size_t                               nCandidates;  //!< Maximum number of candidates to draw
+			size_t                               maxAccepted;  //!< Stop once this number of candidates have been accepted
+			size_t                               maxRejected;  //!< Maximum number of rejected candidates to keep
+			mrpt::random::CRandomGenerator       rng;
+			size_t                               nDrawn;       //!< Number of candidates drawn
+			std::vector<TStateSpace>             accepted;     //!< The accepted candidates, in the order they were drawn
+			std::vector<std::pair<double,TStateSpace> > bestRejected; //!< The (at most) maxRejected most likely rejected candidates, as a heap with the least likely at the front
+		};
+
+		/** Draws and evaluates the candidates of a set of blocks */
+		struct TRSBlockRunner
+		{
+			CRejectionSamplingCapable<TStateSpace> &obj;
+			std::vector<TRSBlock>                  &blocks;
+
+			TRSBlockRunner(CRejectionSamplingCapable<TStateSpace> &obj_, std::vector<TRSBlock> &blocks_) : obj(obj_), blocks(blocks_) { }
+
+			void operator()(size_t first, size_t last, unsigned int)
+			{
+				TStateSpace candidate;
+				for (size_t b=first;b<last;b++)
+				{
+					TRSBlock &blk = blocks[b];
+					blk.accepted.clear();
+					blk.bestRejected.clear();
+					for (blk.nDrawn=0;blk.nDrawn<blk.nCandidates && blk.accepted.size()<blk.maxAccepted;blk.nDrawn++)
+					{
+						obj.RS_drawFromProposal( candidate, blk.rng );
+						const double lik = obj.RS_observationLikelihood( candidate );
+						ASSERT_(lik>=0 && lik<=1);
+						if (lik >= blk.rng.drawUniform(0.0,0.999))
+							blk.accepted.push_back(candidate);
+						else if (blk.bestRejected.size()<blk.maxRejected)
+						{
+							blk.bestRejected.push_back( std::make_pair(lik,candidate) );
+							std::push_heap(blk.bestRejected.begin(),blk.bestRejected.end(),TRSGreaterLik());
+						}
+						else if (!blk.bestRejected.empty() && lik>blk.bestRejected.front().first)
+						{
+							// Replace the least likely one:
+							std::pop_heap(blk.bestRejected.begin(),blk.bestRejected.end(),TRSGreaterLik());
+							blk.bestRejected.back() = std::make_pair(lik,candidate);
+							std::push_heap(blk.bestRejected.begin(),blk.bestRejected.end(),TRSGreaterLik());
+						}
+					}
+				}
+			}
+		};
+
+		struct TRSGreaterLik
+		{
+			bool operator()(const std::pair<double,TStateSpace> &a, const std::pair<double,TStateSpace> &b) const { return a.first>b.first; }
+		};
+
 	}; // End of class def.
 
 } // End of namespace
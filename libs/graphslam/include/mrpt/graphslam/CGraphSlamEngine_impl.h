@@ -660,6 +660,14 @@ bool CGraphSlamEngine<GRAPH_t, NODE_REGISTRAR, EDGE_REGISTRAR, OPTIMIZER>::parse
 	} // WHILE CRAWLOG FILE
 	rawlog_file.close();
 
+	// fetch the results of an optimization that may still be running
+	{
+		mrpt::synch::CCriticalSectionLocker m_graph_lock(&m_graph_section);
+		m_time_logger.enter("optimizer_sync");
+		m_optimizer.syncOptimizedGraph();
+		m_time_logger.leave("optimizer_sync");
+	}
+
 	//
 	// exiting actions
 	//
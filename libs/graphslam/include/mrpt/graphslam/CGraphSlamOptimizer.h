@@ -58,6 +58,14 @@ class CGraphSlamOptimizer : public mrpt::graphslam::CRegistrationDeciderOrOptimi
 				mrpt::obs::CActionCollectionPtr action,
 				mrpt::obs::CSensoryFramePtr observations,
 				mrpt::obs::CObservationPtr observation ) = 0;
+		/**\brief Wait for any pending optimization and make sure that its
+		 * results are reflected in the underlying graph.
+		 *
+		 * Optimizers that run on a separate thread should override this. It is
+		 * called by CGraphSlamEngine after the last measurement has been
+		 * processed, with the graph CCriticalSection already locked.
+		 */
+		virtual void syncOptimizedGraph() { }
 
 	protected:
 		/**\brief method called for optimizing the underlying graph.
@@ -21,6 +21,7 @@
 #include <mrpt/utils/types_simple.h>
 #include <mrpt/utils/TColor.h>
 #include <mrpt/system/threads.h>
+#include <mrpt/synch/CThreadSafeVariable.h>
 #include <mrpt/opengl/graph_tools.h>
 #include <mrpt/opengl/CDisk.h>
 #include <mrpt/opengl/CRenderizable.h>
@@ -33,6 +34,7 @@
 #include <iostream>
 #include <string>
 #include <map>
+#include <set>
 #include <cmath> // fabs function
 
 namespace mrpt { namespace graphslam { namespace optimizers {
@@ -59,7 +61,11 @@ namespace mrpt { namespace graphslam { namespace optimizers {
  *   + \a Default value :  FALSE
  *   + \a Required      : FALSE
  *   + \a Description   : Specify whether to use a second thread to optimize
- *   the graph.
+ *   the graph. When set, the optimization runs on a snapshot of the graph so
+ *   that the node/edge registration deciders are never blocked by it. The
+ *   optimized poses are merged back into the graph on the first updateState
+ *   call after the optimization has finished; nodes that were registered in
+ *   the meantime are corrected by the displacement of the last optimized node.
  *
  * - \b LC_min_nodeid_diff
  *  + \a Section       : GeneralConfiguration
@@ -208,6 +214,12 @@ class CLevMarqGSO:
 
 		};
 		void getDescriptiveReport(std::string* report_str) const;
+		/**\brief Wait for any optimization running on the second thread to
+		 * finish and merge its results back into the graph.
+		 *
+		 * \note Caller should already hold the graph CCriticalSection.
+		 */
+		void syncOptimizedGraph();
 
 		// Public members
 		// ////////////////////////////
@@ -233,13 +245,34 @@ class CLevMarqGSO:
 		 * \sa optimize_spa_levmarq, optimizeGraph
 		 */
 		void _optimizeGraph();
-		/** \brief Wrapper around _optimizeGraph which first locks the section and then
-		 * calls the _optimizeGraph method.
+		/**\brief Fill in the set of nodes to be optimized in the current step.
+		 *
+		 * \return True if a full graph optimization is to be executed, in which
+		 * case the given set is left untouched.
+		 */
+		bool getNodesToOptimize(std::set<mrpt::utils::TNodeID>* nodes_to_optimize);
+		/**\brief Copy the current graph and the nodes to be optimized and launch
+		 * the optimization of the copy on a separate thread.
 		 *
 		 * Used in multithreaded optimization
-		 * \sa _optimizeGraph()
+		 * \sa optimizeGraph, mergeOptimizedGraph
+		 */
+		void launchOptimizationThread();
+		/**\brief Optimize the graph snapshot taken in launchOptimizationThread.
+		 *
+		 * Runs on the optimization thread and does not touch the graph under
+		 * construction, thus it doesn't need to lock the graph section.
+		 * Exceptions are caught and stored in m_snapshot_error.
 		 */
 		void optimizeGraph();
+		/**\brief Copy the optimized poses of the graph snapshot back into the
+		 * graph under construction.
+		 *
+		 * Nodes registered after the snapshot was taken are moved rigidly along
+		 * with the last node of the snapshot. If the optimization thread failed,
+		 * the error is logged and the graph is left untouched.
+		 */
+		void mergeOptimizedGraph();
 		/**\brief Checks if a loop closure edge was added in the graph.
 		 *
 		 * Match the previously registered edges in the graph with the current. If
@@ -305,6 +338,27 @@ class CLevMarqGSO:
 
 		// Use second thread for graph optimization
 		mrpt::system::TThreadHandle m_thread_optimize;
+		/**\brief Copy of the graph that the optimization thread works on */
+		GRAPH_t m_graph_snapshot;
+		/**\brief Nodes to optimize in m_graph_snapshot. Empty means full
+		 * optimization */
+		std::set<mrpt::utils::TNodeID> m_snapshot_nodes_to_optimize;
+		/**\brief Set by the optimization thread as soon as it is done with
+		 * m_graph_snapshot */
+		mrpt::synch::CThreadSafeVariable<bool> m_snapshot_optimized;
+		/**\brief Time (in seconds) that the last threaded optimization took.
+		 * Written by the optimization thread, read after m_snapshot_optimized */
+		double m_snapshot_optimization_time;
+		/**\brief Error message of an exception thrown by the last threaded
+		 * optimization, or empty if it succeeded. Written by the optimization
+		 * thread, read after m_snapshot_optimized */
+		std::string m_snapshot_error;
+		/**\brief True while an optimization has been launched and its results
+		 * have not been merged yet */
+		bool m_optimization_in_progress;
+		/**\brief True if a new node was registered while the optimization
+		 * thread was still busy, so that a new optimization is due */
+		bool m_optimization_pending;
 		mrpt::utils::CTimeLogger m_time_logger; /**<Time logger instance */
 };
 
@@ -28,6 +28,11 @@ template<class GRAPH_t>
 CLevMarqGSO<GRAPH_t>::~CLevMarqGSO() {
 	MRPT_START;
 
+	// don't leave the optimization thread working on a destroyed snapshot
+	if (!m_thread_optimize.isClear()) {
+		mrpt::system::joinThread(m_thread_optimize);
+	}
+
 	MRPT_END;
 }
 
@@ -49,6 +54,12 @@ void CLevMarqGSO<GRAPH_t>::initCLevMarqGSO() {
 	m_last_total_num_of_nodes = 5;
 	m_autozoom_active = true;
 
+	m_snapshot_optimized.set(false);
+	m_snapshot_optimization_time = 0;
+	m_snapshot_error.clear();
+	m_optimization_in_progress = false;
+	m_optimization_pending = false;
+
 	this->setLoggerName("CLevMarqGSO");
 	this->logging_enable_keep_record = true;
 
@@ -65,6 +76,12 @@ bool CLevMarqGSO<GRAPH_t>::updateState(
 	MRPT_START;
 	this->logStr(mrpt::utils::LVL_DEBUG, "In updateOptimizerState... ");
 
+	// fetch the results of a finished optimization thread - never wait for a
+	// running one
+	if (m_optimization_in_progress && m_snapshot_optimized.get()) {
+		this->mergeOptimizedGraph();
+	}
+
 	if (m_graph->nodeCount() > m_last_total_num_of_nodes) {
 		m_last_total_num_of_nodes = m_graph->nodeCount();
 		registered_new_node = true;
@@ -76,19 +93,16 @@ bool CLevMarqGSO<GRAPH_t>::updateState(
 
 
 		if (opt_params.optimization_on_second_thread) {
-			//join the previous optimization thread
-			mrpt::system::joinThread(m_thread_optimize);
-
-			// optimize the graph - run on a seperate thread
-			m_thread_optimize = mrpt::system::createThreadFromObjectMethod(
-					/*obj = */ this,
-					/* func = */ &CLevMarqGSO::optimizeGraph);
-
+			m_optimization_pending = true;
 		}
 		else { // single threaded implementation
 			this->_optimizeGraph();
 		}
+	}
 
+	// optimize the graph - run on a seperate thread
+	if (m_optimization_pending && !m_optimization_in_progress) {
+		this->launchOptimizationThread();
 	}
 
 	return true;
@@ -397,48 +411,158 @@ void CLevMarqGSO<GRAPH_t>::toggleOptDistanceVisualization() {
 
 
 template<class GRAPH_t>
-void CLevMarqGSO<GRAPH_t>::optimizeGraph() {
+void CLevMarqGSO<GRAPH_t>::launchOptimizationThread() {
 	MRPT_START;
+	m_time_logger.enter("CLevMarqGSO::launchOptimizationThread");
 
-	this->logStr(mrpt::utils::LVL_DEBUG, mrpt::format(
-				"In optimizeGraph\n\tThreadID: %lu\n\tTrying to grab lock... ",
-				mrpt::system::getCurrentThreadId()));
+	// caller already holds the graph section, so the copy is consistent
+	m_graph_snapshot = *m_graph;
+	m_snapshot_nodes_to_optimize.clear();
+	bool full_update = this->getNodesToOptimize(&m_snapshot_nodes_to_optimize);
+	if (full_update) {
+		m_snapshot_nodes_to_optimize.clear();
+	}
 
-	mrpt::synch::CCriticalSectionLocker m_graph_lock(m_graph_section);
-	this->_optimizeGraph();
+	m_optimization_pending = false;
+	m_optimization_in_progress = true;
+	m_snapshot_error.clear();
+	m_snapshot_optimized.set(false);
 
-	this->logStr(mrpt::utils::LVL_DEBUG, "2nd thread grabbed the lock..");
+	m_thread_optimize = mrpt::system::createThreadFromObjectMethod(
+			/*obj = */ this,
+			/* func = */ &CLevMarqGSO::optimizeGraph);
 
+	m_time_logger.leave("CLevMarqGSO::launchOptimizationThread");
 	MRPT_END;
 }
 
-// TODO - do something meaningful with these parameters
 template<class GRAPH_t>
-void CLevMarqGSO<GRAPH_t>::_optimizeGraph() {
-	MRPT_START;
-	m_time_logger.enter("CLevMarqGSO::_optimizeGraph");
-	this->logStr(mrpt::utils::LVL_DEBUG, "In _optimizeGraph");
+void CLevMarqGSO<GRAPH_t>::optimizeGraph() {
+	// No MRPT_START/MRPT_END here: an exception escaping the thread would
+	// terminate the program, and m_optimization_in_progress would never be
+	// reset. Errors are stored and reported by mergeOptimizedGraph instead.
+
+	// CTimeLogger is not thread-safe, time it locally and register the
+	// measurement on merging
+	mrpt::utils::CTicTac optimization_timer;
+	optimization_timer.Tic();
 
+	try {
+		graphslam::TResultInfoSpaLevMarq	levmarq_info;
+		mrpt::graphslam::optimize_graph_spa_levmarq(
+				m_graph_snapshot,
+				levmarq_info,
+				m_snapshot_nodes_to_optimize.empty() ?
+					NULL : &m_snapshot_nodes_to_optimize,
+				opt_params.cfg,
+				&CLevMarqGSO<GRAPH_t>::levMarqFeedback); // functor feedback
+	}
+	catch (std::exception& e) {
+		m_snapshot_error = e.what();
+	}
+	catch (...) {
+		m_snapshot_error = "Unknown exception";
+	}
+
+	m_snapshot_optimization_time = optimization_timer.Tac();
+	m_snapshot_optimized.set(true);
+}
+
+template<class GRAPH_t>
+void CLevMarqGSO<GRAPH_t>::mergeOptimizedGraph() {
+	MRPT_START;
 	using namespace mrpt::utils;
 
-	CTicTac optimization_timer;
-	optimization_timer.Tic();
+	ASSERT_(m_optimization_in_progress && m_snapshot_optimized.get());
+	m_time_logger.enter("CLevMarqGSO::mergeOptimizedGraph");
+
+	// thread has already signalled its end - this doesn't block
+	mrpt::system::joinThread(m_thread_optimize);
+	m_thread_optimize.clear();
+	m_time_logger.registerUserMeasure("CLevMarqGSO::optimizeGraph (thread)",
+			m_snapshot_optimization_time);
+
+	if (!m_snapshot_error.empty() || m_graph_snapshot.nodes.empty()) {
+		if (!m_snapshot_error.empty()) {
+			// keep the non-optimized poses - a new optimization is launched with
+			// the next registered node
+			this->logStr(LVL_ERROR, format(
+						"Graph optimization thread failed, discarding its results:\n%s",
+						m_snapshot_error.c_str()));
+			m_snapshot_error.clear();
+		}
+		m_optimization_in_progress = false;
+		m_snapshot_optimized.set(false);
+		m_time_logger.leave("CLevMarqGSO::mergeOptimizedGraph");
+		return;
+	}
 
+	// latest node of the snapshot - nodes registered after it are expressed
+	// relative to its non-optimized pose
+	const mrpt::utils::TNodeID last_snap_nodeID =
+		m_graph_snapshot.nodes.rbegin()->first;
+	const pose_t last_snap_pose = m_graph_snapshot.nodes.rbegin()->second;
+	const pose_t last_prev_pose = m_graph->nodes[last_snap_nodeID];
+
+	size_t nodes_registered_meanwhile = 0;
+	for (typename GRAPH_t::global_poses_t::iterator
+			graph_it = m_graph->nodes.begin();
+			graph_it != m_graph->nodes.end(); ++graph_it) {
+		typename GRAPH_t::global_poses_t::const_iterator snap_it =
+			m_graph_snapshot.nodes.find(graph_it->first);
+
+		if (snap_it != m_graph_snapshot.nodes.end()) {
+			graph_it->second = snap_it->second;
+		}
+		else { // node registered while the optimization was running
+			graph_it->second = last_snap_pose +
+				(pose_t(graph_it->second) - last_prev_pose);
+			nodes_registered_meanwhile++;
+		}
+	}
 
-	// set of nodes for which the optimization procedure will take place
-	std::set< mrpt::utils::TNodeID>* nodes_to_optimize;
+	m_time_logger.registerUserMeasure(
+			"CLevMarqGSO::nodes registered during optimization",
+			nodes_registered_meanwhile);
+	this->logStr(LVL_DEBUG, format(
+				"Merged optimized graph - took: %fs, nodes registered meanwhile: %lu",
+				m_snapshot_optimization_time,
+				static_cast<unsigned long>(nodes_registered_meanwhile)));
+
+	m_optimization_in_progress = false;
+	m_snapshot_optimized.set(false);
+
+	m_time_logger.leave("CLevMarqGSO::mergeOptimizedGraph");
+	MRPT_END;
+}
+
+template<class GRAPH_t>
+void CLevMarqGSO<GRAPH_t>::syncOptimizedGraph() {
+	MRPT_START;
+
+	if (m_optimization_in_progress) {
+		m_time_logger.enter("CLevMarqGSO::syncOptimizedGraph");
+		mrpt::system::joinThread(m_thread_optimize);
+		m_thread_optimize.clear();
+		this->mergeOptimizedGraph();
+		m_time_logger.leave("CLevMarqGSO::syncOptimizedGraph");
+	}
+
+	MRPT_END;
+}
+
+template<class GRAPH_t>
+bool CLevMarqGSO<GRAPH_t>::getNodesToOptimize(
+		std::set<mrpt::utils::TNodeID>* nodes_to_optimize) {
+	MRPT_START;
 
 	// fill in the nodes in certain distance to the current node, only if
 	// full_update is not instructed
-
 	bool full_update = opt_params.optimization_distance == -1 || this->checkForLoopClosures();
 	if (full_update) {
-		nodes_to_optimize = NULL;
 		this->logStr(mrpt::utils::LVL_DEBUG, "Commencing with FULL graph optimization... ");
 	}
 	else {
-		nodes_to_optimize = new std::set<mrpt::utils::TNodeID>;
-
 		// I am certain that this shall not be called when nodeCount = 0, since the
 		// optimization procedure starts only after certain number of nodes has
 		// been added
@@ -448,6 +572,32 @@ void CLevMarqGSO<GRAPH_t>::_optimizeGraph() {
 		nodes_to_optimize->insert(m_graph->nodeCount()-1);
 	}
 
+	return full_update;
+	MRPT_END;
+}
+
+// TODO - do something meaningful with these parameters
+template<class GRAPH_t>
+void CLevMarqGSO<GRAPH_t>::_optimizeGraph() {
+	MRPT_START;
+	m_time_logger.enter("CLevMarqGSO::_optimizeGraph");
+	this->logStr(mrpt::utils::LVL_DEBUG, "In _optimizeGraph");
+
+	using namespace mrpt::utils;
+
+	CTicTac optimization_timer;
+	optimization_timer.Tic();
+
+
+	// set of nodes for which the optimization procedure will take place
+	std::set< mrpt::utils::TNodeID>* nodes_to_optimize =
+		new std::set<mrpt::utils::TNodeID>;
+
+	if (this->getNodesToOptimize(nodes_to_optimize)) {
+		delete nodes_to_optimize;
+		nodes_to_optimize = NULL;
+	}
+
 	graphslam::TResultInfoSpaLevMarq	levmarq_info;
 
 	// Execute the optimization
@@ -32,6 +32,7 @@
 #include <mrpt/poses/CPose3D.h>
 #include <mrpt/slam/CIncrementalMapPartitioner.h>
 #include <mrpt/slam/CICP.h>
+#include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/system/os.h>
 #include <mrpt/system/threads.h>
 #include <mrpt/math/data_utils.h>
@@ -212,6 +213,24 @@ transformation is the identity matrix (i.e., T = [0 0 0])"
  *   + \a Description   : Boolean flag indicating whether to check for loop
  *   closures only in the current node's partition
  *
+ * - \b LC_max_candidate_distance
+ *   + \a Section       : EdgeRegistrationDeciderParameters
+ *   + \a Default value : -1
+ *   + \a Required      : FALSE
+ *   + \a Description   : Maximum distance between the current position
+ *   estimates of two nodes for them to be checked as a loop closure hypothesis.
+ *   Candidate pairs are fetched from a KD-tree of the node positions. Set to
+ *   -1 to evaluate all pairs between the groups of the partition.
+ *
+ * - \b LC_num_threads
+ *   + \a Section       : EdgeRegistrationDeciderParameters
+ *   + \a Default value : 0
+ *   + \a Required      : FALSE
+ *   + \a Description   : Number of threads used for evaluating the ICP
+ *   alignment of the loop closure hypotheses and for building their pairwise
+ *   consistency matrix. Set to 0 for using as many threads as processor
+ *   cores, or to 1 to evaluate everything in the calling thread.
+ *
  * - \b visualize_map_partitions
  *   + \a Section       : VisualizationParameters
  *   + \a Default value : TRUE
@@ -361,6 +380,14 @@ class CLoopCloserERD:
 				 * I consider the potential loop closure?
 				 */
 				int LC_min_remote_nodes; 
+				/**\brief Maximum distance between two nodes for them to form a
+				 * loop closure hypothesis. Negative values disable the check.
+				 */
+				double LC_max_candidate_distance;
+				/**\brief Number of threads for evaluating the hypotheses, 0 for
+				 * the number of processor cores.
+				 */
+				int LC_num_threads;
 				bool visualize_map_partitions;
 				std::string keystroke_map_partitions;
 
@@ -460,6 +487,81 @@ class CLoopCloserERD:
 			bool is_valid;
 
 		};
+		/**\brief Functor for running the ICP of a batch of hypotheses in
+		 * parallel - see mrpt::system::parallelForBlocks
+		 */
+		struct THypothesesICPEvaluator {
+			THypothesesICPEvaluator(decider_t* d, std::vector<THypothesis*>& h):
+				decider(d), hypots(h) { }
+			void operator()(size_t first, size_t last, unsigned int block_index) {
+				mrpt::slam::CICP::TReturnInfo icp_info;
+				for (size_t i = first; i != last; ++i) {
+					decider->computeICPEdge(hypots[i]->from, hypots[i]->to,
+							&(hypots[i]->edge), &icp_info);
+					hypots[i]->goodness = icp_info.goodness;
+				}
+			}
+			decider_t* decider;
+			std::vector<THypothesis*>& hypots;
+		};
+		/**\brief Functor for computing the optimal paths between pairs of nodes
+		 * in parallel - see mrpt::system::parallelForBlocks
+		 */
+		struct TOptimalPathsEvaluator {
+			TOptimalPathsEvaluator(const decider_t* d,
+					const std::vector<std::pair<mrpt::utils::TNodeID, mrpt::utils::TNodeID> >& p,
+					std::vector<TPath*>& out):
+				decider(d), pairs(p), paths(out) { }
+			void operator()(size_t first, size_t last, unsigned int block_index) {
+				for (size_t i = first; i != last; ++i) {
+					std::map<mrpt::utils::TNodeID, TPath*> node_optimal_paths;
+					decider->computeDijkstraProjection(&node_optimal_paths,
+							pairs[i].first, pairs[i].second);
+					typename std::map<mrpt::utils::TNodeID, TPath*>::iterator search =
+						node_optimal_paths.find(pairs[i].second);
+					if (search != node_optimal_paths.end()) {
+						paths[i] = search->second;
+						node_optimal_paths.erase(search);
+					}
+					decider_t::clearOptimalPaths(&node_optimal_paths);
+				}
+			}
+			const decider_t* decider;
+			const std::vector<std::pair<mrpt::utils::TNodeID, mrpt::utils::TNodeID> >& pairs;
+			std::vector<TPath*>& paths;
+		};
+		/**\brief Pair of hypotheses whose pairwise consistency is to be computed
+		 * along with the nodes and paths involved */
+		struct TConsistencyElement {
+			mrpt::utils::TNodeID a1, a2, b1, b2;
+			THypothesis* h_b2a1;
+			THypothesis* h_b1a2;
+			const TPath* path_a1a2;
+			const TPath* path_b1b2;
+			double consistency;
+		};
+		/**\brief Functor for computing the pairwise consistency elements in
+		 * parallel - see mrpt::system::parallelForBlocks
+		 */
+		struct TConsistencyEvaluator {
+			TConsistencyEvaluator(const decider_t* d,
+					const std::map<std::pair<mrpt::utils::TNodeID, mrpt::utils::TNodeID>,
+						THypothesis*>& h,
+					std::vector<TConsistencyElement>& e):
+				decider(d), hypots_map(h), elements(e) { }
+			void operator()(size_t first, size_t last, unsigned int block_index) {
+				for (size_t i = first; i != last; ++i) {
+					TConsistencyElement& e = elements[i];
+					e.consistency = decider->generatePWConsistencyElement(
+							e.a1, e.a2, e.b1, e.b2, hypots_map,
+							*e.path_a1a2, *e.path_b1b2);
+				}
+			}
+			const decider_t* decider;
+			const std::map<std::pair<mrpt::utils::TNodeID, mrpt::utils::TNodeID>,
+						THypothesis*>& hypots_map;
+			std::vector<TConsistencyElement>& elements;
+		};
 
 		/**brief Compare the suggested ICP edge against the initial node
 		 * difference.
@@ -569,6 +671,12 @@ class CLoopCloserERD:
 		 * pairwise consistency element would then be: 
  		 * <br><center> \f$ A_{i,j} = e^{-T \Sigma_T T^T} \f$ </center>
 		 *
+		 * \param[in] path_a1a2 Optimal path from a1 to a2, as computed by
+		 * computeDijkstraProjection
+		 * \param[in] path_b1b2 Optimal path from b1 to b2
+		 *
+		 * \note Method doesn't modify the class state, thus it is safe to call
+		 * it from several threads at once.
 		 */
 		double generatePWConsistencyElement(
 				const mrpt::utils::TNodeID& a1,
@@ -576,7 +684,9 @@ class CLoopCloserERD:
 				const mrpt::utils::TNodeID& b1,
 				const mrpt::utils::TNodeID& b2,
 				const std::map<std::pair<mrpt::utils::TNodeID, mrpt::utils::TNodeID>,
-					THypothesis*>& hypots_map);
+					THypothesis*>& hypots_map,
+				const TPath& path_a1a2,
+				const TPath& path_b1b2) const;
 		
 		/** Get the ICP Edge between the provided nodes.
 		 *
@@ -588,6 +698,16 @@ class CLoopCloserERD:
 				const mrpt::utils::TNodeID& to,
 				constraint_t* rel_edge,
 				mrpt::slam::CICP::TReturnInfo* icp_info=NULL);
+		/**\brief Implementation of getICPEdge, without any logging or timing.
+		 *
+		 * Can be called from several threads at once, as long as the graph and
+		 * the node to laser scans map are not modified meanwhile.
+		 */
+		void computeICPEdge(
+				const mrpt::utils::TNodeID& from,
+				const mrpt::utils::TNodeID& to,
+				constraint_t* rel_edge,
+				mrpt::slam::CICP::TReturnInfo* icp_info=NULL);
 
 		/**\brief compute the minimum uncertainty of each node position with
 		 * regards to the graph root.
@@ -601,6 +721,35 @@ class CLoopCloserERD:
 		void execDijkstraProjection(
 				mrpt::utils::TNodeID starting_node=0,
 				mrpt::utils::TNodeID ending_node=INVALID_NODEID);
+		/**\brief Implementation of the Dijkstra projection which fills the
+		 * given map instead of m_node_optimal_paths.
+		 *
+		 * The TPath instances inserted in \a node_optimal_paths are allocated
+		 * in the heap and have to be deleted by the caller. Method doesn't modify
+		 * the class state, thus it is safe to call it from several threads at
+		 * once.
+		 */
+		void computeDijkstraProjection(
+				std::map<mrpt::utils::TNodeID, TPath*>* node_optimal_paths,
+				mrpt::utils::TNodeID starting_node,
+				mrpt::utils::TNodeID ending_node=INVALID_NODEID) const;
+		/**\brief Delete the TPath instances of the given map and clear it. */
+		static void clearOptimalPaths(
+				std::map<mrpt::utils::TNodeID, TPath*>* node_optimal_paths);
+		/**\brief Fill in the pairs of nodes (b, a) of the given groups that are
+		 * close enough to be a loop closure hypothesis.
+		 *
+		 * If TLoopClosureParams::LC_max_candidate_distance is set, the nodes of
+		 * group A within that distance from each node of group B are fetched from
+		 * a KD-tree of the current node positions. Otherwise all pairs are
+		 * returned.
+		 */
+		void getCandidateHypothesesPairs(
+				const mrpt::vector_uint& groupA,
+				const mrpt::vector_uint& groupB,
+				std::set<std::pair<mrpt::utils::TNodeID, mrpt::utils::TNodeID> >* pairs);
+		/**\brief Update the positions of the nodes in m_node_positions. */
+		void updateNodePositionsIndex();
 		/**\brief Given two nodeIDs compute and return the path connecting them.
 		 *
 		 * Method takes care of multiple edges, as well as edges with 0 covariance
@@ -701,6 +850,10 @@ class CLoopCloserERD:
 		 * certanty of each node position
 		 */
 		std::map<mrpt::utils::TNodeID, TPath*> m_node_optimal_paths;
+		/**\brief Spatial index of the graph nodes' positions. Point i holds the
+		 * position of nodeID i. Used for generating the loop closure candidates.
+		 */
+		mrpt::maps::CSimplePointsMap m_node_positions;
 		mrpt::utils::CTimeLogger m_time_logger; /**<Time logger instance */
 
 		const std::string m_class_name;
@@ -61,12 +61,7 @@ CLoopCloserERD<GRAPH_t>::~CLoopCloserERD() {
 
 	// release memory of m_node_optimal_paths map.
 	this->logFmt(mrpt::utils::LVL_DEBUG, "Releasing memory of m_node_optimal_paths map...");
-	for (typename std::map<mrpt::utils::TNodeID, TPath*>::iterator it = 
-			m_node_optimal_paths.begin(); it != m_node_optimal_paths.end();
-			++it) {
-
-		delete it->second;
-	}
+	clearOptimalPaths(&m_node_optimal_paths);
 
 }
 
@@ -219,9 +214,23 @@ void CLoopCloserERD<GRAPH_t>::getICPEdge(
 		constraint_t* rel_edge,
 		mrpt::slam::CICP::TReturnInfo* icp_info) {
 	MRPT_START;
-	ASSERT_(rel_edge);
 	m_time_logger.enter("getICPEdge");
 
+	this->computeICPEdge(from, to, rel_edge, icp_info);
+
+	m_time_logger.leave("getICPEdge");
+	MRPT_END;
+}
+
+template<class GRAPH_t>
+void CLoopCloserERD<GRAPH_t>::computeICPEdge(
+		const mrpt::utils::TNodeID& from,
+		const mrpt::utils::TNodeID& to,
+		constraint_t* rel_edge,
+		mrpt::slam::CICP::TReturnInfo* icp_info) {
+	MRPT_START;
+	ASSERT_(rel_edge);
+
 	using namespace mrpt::obs;
 	using namespace mrpt::utils;
 
@@ -250,7 +259,6 @@ void CLoopCloserERD<GRAPH_t>::getICPEdge(
 			&initial_estim,
 			icp_info);
 
-	m_time_logger.leave("getICPEdge");
 	MRPT_END;
 }
 
@@ -354,10 +362,10 @@ void CLoopCloserERD<GRAPH_t>::evaluatePartitionsForLC(
 	using namespace mrpt::math;
 	using namespace mrpt::utils;
 	using namespace std;
-	m_time_logger.enter("LoopClosureEvaluation");
-
 	if (partitions.size() == 0) return;
 
+	m_time_logger.enter("LoopClosureEvaluation");
+
 	std::string header_sep(80, '-');
 	this->logFmt(mrpt::utils::LVL_DEBUG, "Evaluating partitions for loop closures...\n%s\n",
 			header_sep.c_str());
@@ -418,29 +426,41 @@ void CLoopCloserERD<GRAPH_t>::evaluatePartitionsForLC(
 		int invalid_hypotheses = 0;
 		std::map<std::pair<TNodeID, TNodeID>, THypothesis*> nodeIDs_to_hypots;
 		{
-			mrpt::slam::CICP::TReturnInfo icp_info;
-			for (vector_uint::const_iterator b_it = groupB.begin(); b_it != groupB.end();
-					++b_it) {
-				for (vector_uint::const_iterator a_it = groupA.begin(); a_it != groupA.end();
-						++a_it) {
-					// by default hypotheses will direct bi => ai; If the hypothesis is
-					// traversed the opposite way take the opposite of the constraint
-					THypothesis* hypot = new THypothesis;
-					hypot->from = *b_it;
-					hypot->to = *a_it;
-					hypot->id = hypothesis_counter++;
-					this->getICPEdge(*b_it, *a_it, &(hypot->edge), &icp_info);
-					hypot->goodness = icp_info.goodness; // goodness related to the edge
-					//cout << "Goodness: " << icp_info.goodness << endl;
-					//cout << hypot->getAsString() << endl;
-					// Mark as invalid, do not use it from now on...
-					if (hypot->goodness == 0) {
-						hypot->is_valid = false;
-						invalid_hypotheses++;
-					}
-					nodeIDs_to_hypots[make_pair(*b_it, *a_it)] = hypot;
-					this->logFmt(mrpt::utils::LVL_DEBUG, "%s", hypot->getAsString().c_str());
+			m_time_logger.enter("LoopClosureEvaluation.candidate_pairs");
+			std::set<std::pair<TNodeID, TNodeID> > candidate_pairs;
+			this->getCandidateHypothesesPairs(groupA, groupB, &candidate_pairs);
+			m_time_logger.leave("LoopClosureEvaluation.candidate_pairs");
+
+			// by default hypotheses will direct bi => ai; If the hypothesis is
+			// traversed the opposite way take the opposite of the constraint
+			std::vector<THypothesis*> hypots;
+			for (std::set<std::pair<TNodeID, TNodeID> >::const_iterator
+					pair_it = candidate_pairs.begin();
+					pair_it != candidate_pairs.end(); ++pair_it) {
+				THypothesis* hypot = new THypothesis;
+				hypot->from = pair_it->first;
+				hypot->to = pair_it->second;
+				hypot->id = hypothesis_counter++;
+				nodeIDs_to_hypots[*pair_it] = hypot;
+				hypots.push_back(hypot);
+			}
+
+			// run the ICP alignments in parallel - the graph is not modified
+			// until all of them are done
+			m_time_logger.enter("LoopClosureEvaluation.hypotheses_ICP");
+			THypothesesICPEvaluator icp_evaluator(this, hypots);
+			mrpt::system::parallelForBlocks(hypots.size(), icp_evaluator,
+					m_lc_params.LC_num_threads);
+			m_time_logger.leave("LoopClosureEvaluation.hypotheses_ICP");
+
+			for (typename std::vector<THypothesis*>::const_iterator
+					h_it = hypots.begin(); h_it != hypots.end(); ++h_it) {
+				// Mark as invalid, do not use it from now on...
+				if ((*h_it)->goodness == 0) {
+					(*h_it)->is_valid = false;
+					invalid_hypotheses++;
 				}
+				this->logFmt(mrpt::utils::LVL_DEBUG, "%s", (*h_it)->getAsString().c_str());
 			}
 			this->logFmt(mrpt::utils::LVL_DEBUG, 
 					"Generated pool of hypotheses...\tnodeIDs_to_hypots.size() = %lu\tinvalid hypotheses: %d",
@@ -448,9 +468,10 @@ void CLoopCloserERD<GRAPH_t>::evaluatePartitionsForLC(
 		}
 		//mrpt::system::pause();
 
-		// compute the pair-wise consistency for groups of hypotheses between
-		// groups A, B
-		std::map<std::pair<THypothesis*, THypothesis*>, double> hypots_to_consistencies;
+		// gather the pairs of hypotheses between groups A, B whose pair-wise
+		// consistency is to be computed
+		std::vector<TConsistencyElement> consistency_elems;
+		std::set<std::pair<TNodeID, TNodeID> > path_pairs_set;
 		for (vector_uint::const_iterator b_out_it = groupB.begin(); b_out_it != groupB.end();
 				++b_out_it) {
 			TNodeID b1 = *b_out_it;
@@ -460,55 +481,110 @@ void CLoopCloserERD<GRAPH_t>::evaluatePartitionsForLC(
 				for (vector_uint::const_iterator a_out_it = groupA.begin(); a_out_it != groupA.end();
 						++a_out_it) {
 					TNodeID a1 = *a_out_it;
-					THypothesis* h_b2a1 = nodeIDs_to_hypots.at(make_pair(b2, a1));
+					typename std::map<std::pair<TNodeID, TNodeID>, THypothesis*>::const_iterator
+						h_b2a1_it = nodeIDs_to_hypots.find(make_pair(b2, a1));
+					if (h_b2a1_it == nodeIDs_to_hypots.end()) continue;
 					for (vector_uint::const_iterator a_in_it = a_out_it+1; a_in_it != groupA.end();
 							++a_in_it) {
 						TNodeID a2 = *a_in_it;
-						THypothesis* h_b1a2 = nodeIDs_to_hypots.at(make_pair(b1, a2));
-
-						double consistency;
-						bool hypots_are_valid = (h_b2a1->is_valid && h_b1a2->is_valid &&
-								h_b2a1->goodness > 0.25 && h_b1a2->goodness > 0.25);
-
+						typename std::map<std::pair<TNodeID, TNodeID>, THypothesis*>::const_iterator
+							h_b1a2_it = nodeIDs_to_hypots.find(make_pair(b1, a2));
+						if (h_b1a2_it == nodeIDs_to_hypots.end()) continue;
+
+						TConsistencyElement elem;
+						elem.a1 = a1; elem.a2 = a2; elem.b1 = b1; elem.b2 = b2;
+						elem.h_b2a1 = h_b2a1_it->second;
+						elem.h_b1a2 = h_b1a2_it->second;
+						elem.path_a1a2 = elem.path_b1b2 = NULL;
+						elem.consistency = 0;
+						consistency_elems.push_back(elem);
+
+						bool hypots_are_valid = (elem.h_b2a1->is_valid && elem.h_b1a2->is_valid &&
+								elem.h_b2a1->goodness > 0.25 && elem.h_b1a2->goodness > 0.25);
 						if (hypots_are_valid) { //  skip the ones that don't look good
-							// keep the consistency element based on the hypotheses that it was
-							// generated by - direction of the hypothesis is by default bi=>ai.
-							// If the opposite is needed, it is handled by the calling function
-							consistency = this->generatePWConsistencyElement(a1,a2,b1,b2,nodeIDs_to_hypots);
-						}
-						else {
-							consistency = 0;
+							path_pairs_set.insert(make_pair(a1, a2));
+							path_pairs_set.insert(make_pair(b1, b2));
 						}
-						this->logFmt(mrpt::utils::LVL_DEBUG, "Adding hypotheses consistency for nodeIDs: "
-								"(%lu, %lu, %lu, %lu) => \t%f", b1, b2, a1, a2, consistency);
-						hypots_to_consistencies[make_pair(h_b2a1, h_b1a2)] = consistency;
 					}
 				}
 			}
 		}
-		this->logFmt(mrpt::utils::LVL_DEBUG, "Generated map of hypothesis pairs to corresponding consistency elements");
-		//mrpt::system::pause();
+
+		// compute the Dijkstra links a1=>a2, b1=>b2 once for each pair of
+		// nodes instead of once for every consistency element
+		m_time_logger.enter("LoopClosureEvaluation.dijkstra_paths");
+		std::vector<std::pair<TNodeID, TNodeID> > path_pairs(
+				path_pairs_set.begin(), path_pairs_set.end());
+		std::vector<TPath*> optimal_paths(path_pairs.size(), NULL);
+		{
+			TOptimalPathsEvaluator paths_evaluator(this, path_pairs, optimal_paths);
+			mrpt::system::parallelForBlocks(path_pairs.size(), paths_evaluator,
+					m_lc_params.LC_num_threads);
+		}
+		std::map<std::pair<TNodeID, TNodeID>, TPath*> pairs_to_paths;
+		for (size_t i = 0; i != path_pairs.size(); ++i) {
+			pairs_to_paths[path_pairs[i]] = optimal_paths[i];
+		}
+		m_time_logger.leave("LoopClosureEvaluation.dijkstra_paths");
+
+		// compute the pair-wise consistency for groups of hypotheses between
+		// groups A, B
+		m_time_logger.enter("LoopClosureEvaluation.consistency_matrix");
+		std::vector<TConsistencyElement> elems_to_evaluate;
+		for (typename std::vector<TConsistencyElement>::iterator
+				e_it = consistency_elems.begin();
+				e_it != consistency_elems.end(); ++e_it) {
+			bool hypots_are_valid = (e_it->h_b2a1->is_valid && e_it->h_b1a2->is_valid &&
+					e_it->h_b2a1->goodness > 0.25 && e_it->h_b1a2->goodness > 0.25);
+			if (!hypots_are_valid) continue;
+
+			e_it->path_a1a2 = pairs_to_paths[make_pair(e_it->a1, e_it->a2)];
+			e_it->path_b1b2 = pairs_to_paths[make_pair(e_it->b1, e_it->b2)];
+			// no path found between the nodes - keep a zero consistency
+			if (!e_it->path_a1a2 || !e_it->path_b1b2) continue;
+			elems_to_evaluate.push_back(*e_it);
+		}
+		{
+			// keep the consistency element based on the hypotheses that it was
+			// generated by - direction of the hypothesis is by default bi=>ai.
+			// If the opposite is needed, it is handled by the calling function
+			TConsistencyEvaluator consistency_evaluator(
+					this, nodeIDs_to_hypots, elems_to_evaluate);
+			mrpt::system::parallelForBlocks(elems_to_evaluate.size(),
+					consistency_evaluator, m_lc_params.LC_num_threads);
+		}
 
 		// generate the pair-wise consistency matrix of the relevant edges and find
 		// the submatrix of the most consistent hypotheses inside it.
 		CMatrixDouble consist_matrix(hypothesis_counter, hypothesis_counter);
-		for (typename std::map<std::pair<THypothesis*, THypothesis*>, double>::const_iterator it =
-				hypots_to_consistencies.begin(); it != hypots_to_consistencies.end(); ++it)  {
-			int id1 = it->first.first->id;
-			int id2 = it->first.second->id;
-			double consistency_elem = it->second;
-			consist_matrix(id1, id2) = consist_matrix(id2, id1) = consistency_elem;
-			this->logFmt(mrpt::utils::LVL_DEBUG, "id1 = %d\t| id2 = %d\t| consistency_element = %f",
-					id1, id2, consistency_elem);
+		for (typename std::vector<TConsistencyElement>::const_iterator
+				e_it = elems_to_evaluate.begin(); e_it != elems_to_evaluate.end();
+				++e_it)  {
+			int id1 = e_it->h_b2a1->id;
+			int id2 = e_it->h_b1a2->id;
+			consist_matrix(id1, id2) = consist_matrix(id2, id1) = e_it->consistency;
+			this->logFmt(mrpt::utils::LVL_DEBUG, "Adding hypotheses consistency for nodeIDs: "
+					"(%lu, %lu, %lu, %lu) => \t%f", e_it->b1, e_it->b2, e_it->a1, e_it->a2,
+					e_it->consistency);
 		}
 		this->logFmt(mrpt::utils::LVL_DEBUG, "Row count of consist_matrix: %lu", consist_matrix.getRowCount());
 
+		for (typename std::map<std::pair<TNodeID, TNodeID>, TPath*>::iterator
+				it = pairs_to_paths.begin(); it != pairs_to_paths.end(); ++it) {
+			delete it->second;
+		}
+		m_time_logger.leave("LoopClosureEvaluation.consistency_matrix");
+
 		// evaluate the pair-wise consistency matrix
 		// compute dominant eigenvector
 		dynamic_vector<double> u;
-		bool valid_lambda_ratio =
+		bool valid_lambda_ratio = hypothesis_counter > 1 &&
 			this->computeDominantEigenVector(consist_matrix, &u, /*use_power_method=*/ false);
-		if (!valid_lambda_ratio) continue;
+		if (!valid_lambda_ratio) {
+			// nothing to register - zero indicator vector, so that the hypotheses
+			// are still released below
+			u.setZero(hypothesis_counter);
+		}
 
 		//cout << "Dominant eigenvector: " << u.transpose() << endl;
 
@@ -642,32 +718,30 @@ double CLoopCloserERD<GRAPH_t>::generatePWConsistencyElement(
 		const mrpt::utils::TNodeID& b1,
 		const mrpt::utils::TNodeID& b2,
 		const typename std::map<std::pair<mrpt::utils::TNodeID, mrpt::utils::TNodeID>,
-			CLoopCloserERD<GRAPH_t>::THypothesis*>& nodeIDs_to_hypots) {
+			CLoopCloserERD<GRAPH_t>::THypothesis*>& nodeIDs_to_hypots,
+		const TPath& path_a1a2,
+		const TPath& path_b1b2) const {
 	MRPT_START;
 	using namespace std;
 	using namespace mrpt;
 	using namespace mrpt::math;
 	using namespace mrpt::utils;
 
-	// get the dijkstra links
+	// the dijkstra links
 	// a1=>a2
-	execDijkstraProjection(/*starting_node=*/ a1, /*ending_node=*/ a2);
-	TPath* path_a1a2 = this->queryOptimalPath(a2);
-	ASSERTMSG_(path_a1a2->getSource() == a1,
+	ASSERTMSG_(path_a1a2.getSource() == a1,
 			format("\nnodeID %lu is not the source of the optimal path\n%s\n\n",
-				a1, path_a1a2->getAsString().c_str()));
-	ASSERTMSG_(path_a1a2->getDestination() == a2,
+				a1, path_a1a2.getAsString().c_str()));
+	ASSERTMSG_(path_a1a2.getDestination() == a2,
 			format("\nnodeID %lu is not the destination of the optimal path\n%s\n\n",
-				a2, path_a1a2->getAsString().c_str()));
+				a2, path_a1a2.getAsString().c_str()));
 	// b1=>b2
-	execDijkstraProjection(/*starting_node=*/ b1, /*ending_node=*/ b2);
-	TPath* path_b1b2 = this->queryOptimalPath(b2);
-	ASSERTMSG_(path_b1b2->getSource() == b1,
+	ASSERTMSG_(path_b1b2.getSource() == b1,
 			format("\nnodeID %lu is not the source of the optimal path\n%s\n\n",
-				b1, path_b1b2->getAsString().c_str()));
-	ASSERTMSG_(path_b1b2->getDestination() == b2,
+				b1, path_b1b2.getAsString().c_str()));
+	ASSERTMSG_(path_b1b2.getDestination() == b2,
 			format("\nnodeID %lu is not the destination of the optimal path\n%s\n\n",
-				b2, path_b1b2->getAsString().c_str()));
+				b2, path_b1b2.getAsString().c_str()));
 
 	// get the edges of the hypotheses
 	// by default hypotheses are stored bi => ai
@@ -693,17 +767,15 @@ double CLoopCloserERD<GRAPH_t>::generatePWConsistencyElement(
 
 
 
-	constraint_t res(path_a1a2->curr_pose_pdf);
+	constraint_t res(path_a1a2.curr_pose_pdf);
 	//cout << "a1=>a2: " << endl << res;
 	res += edge_a2b1;
 	//cout << "a2=>b1: " << endl << edge_a2b1;
-	res += path_b1b2->curr_pose_pdf;
-	//cout << "b1=>b2: " << endl << path_b1b2->curr_pose_pdf;
+	res += path_b1b2.curr_pose_pdf;
+	//cout << "b1=>b2: " << endl << path_b1b2.curr_pose_pdf;
 	res += edge_b2a1;
 	//cout << "b2=>a1: " << endl << edge_b2a1;
 
-	cout << "Resulting Transformation: " << endl;
-	cout << res << endl;
 	
 	// get the vector of the corresponding transformation - [x, y, phi] form
 	dynamic_vector<double> T;
@@ -733,14 +805,36 @@ void CLoopCloserERD<GRAPH_t>::execDijkstraProjection(
 		mrpt::utils::TNodeID starting_node/*=0*/,
 		mrpt::utils::TNodeID ending_node/*=INVALID_NODEID*/) {
 	MRPT_START;
+	using namespace mrpt;
+	using namespace mrpt::utils;
+
+	m_time_logger.enter("Dijkstra Projection");
+
+	std::string to_node_str(ending_node == INVALID_NODEID? "": format(" => %lu", ending_node) );
+	this->logFmt(mrpt::utils::LVL_DEBUG, "Executing Dijkstra Projection: %lu%s",
+			starting_node, to_node_str.c_str());
+
+	clearOptimalPaths(&m_node_optimal_paths);
+	this->computeDijkstraProjection(&m_node_optimal_paths, starting_node, ending_node);
+
+	this->logFmt(mrpt::utils::LVL_DEBUG, "----------- Done with Dijkstra Projection... ----------");
+	m_time_logger.leave("Dijkstra Projection");
+	MRPT_END;
+}
+
+template<class GRAPH_t>
+void CLoopCloserERD<GRAPH_t>::computeDijkstraProjection(
+		std::map<mrpt::utils::TNodeID, TPath*>* node_optimal_paths,
+		mrpt::utils::TNodeID starting_node,
+		mrpt::utils::TNodeID ending_node/*=INVALID_NODEID*/) const {
+	MRPT_START;
 	using namespace std;
 	using namespace mrpt;
 	using namespace mrpt::utils;
 	// for the full algorithm see
 	// - Recognizing places using spectrally cllustered local matches - E.Olson,
 	// p.6
-	
-	m_time_logger.enter("Dijkstra Projection");
+	ASSERT_(node_optimal_paths);
 
 	// ending_node is either INVALID_NODEID or one of the already registered
 	// nodeIDs
@@ -750,13 +844,8 @@ void CLoopCloserERD<GRAPH_t>::execDijkstraProjection(
 	// if uncertainties already updated - do nothing
 	if (m_graph->nodeCount() < 5) return;
 
-	std::string to_node_str(ending_node == INVALID_NODEID? "": format(" => %lu", ending_node) );
-	this->logFmt(mrpt::utils::LVL_DEBUG, "Executing Dijkstra Projection: %lu%s",
-			starting_node, to_node_str.c_str());
-
 	// keep track of the nodes that I have visited
 	std::vector<bool> visited_nodes(m_graph->nodeCount(), false);
-	m_node_optimal_paths.clear();
 
 	// get the neighbors of each node
 	std::map<TNodeID, std::set<TNodeID>>  neighbors_of;
@@ -779,17 +868,6 @@ void CLoopCloserERD<GRAPH_t>::execDijkstraProjection(
 	// just visited the first node
 	visited_nodes.at(starting_node) = true;
 
-	//// TODO Remove these - >>>>>>>>>>>>>>>>>>>>
-	//// printing the pool for verification
-	//cout << "Pool of Paths: " << endl;
-	//for (typename std::set<TPath*>::const_iterator it = pool_of_paths.begin();
-			//it != pool_of_paths.end(); ++it) {
-		//printVector((*it)->nodes_traversed);
-	//}
-	//cout << "------ Done with the starting node ... ------" << endl;
-	//int iters = 0;
-	//// TODO Remove these - <<<<<<<<<<<<<<<<<<<<< vvvUNCOMMENT BELOW AS WELLvvv
-
 	// for all unvisited nodes
 	while ( std::any_of(visited_nodes.begin(), visited_nodes.end(),
 			[](bool b) {return !b;} ) ) { // if there is at least one false..
@@ -798,47 +876,110 @@ void CLoopCloserERD<GRAPH_t>::execDijkstraProjection(
 		// it is found.
 		if (ending_node != INVALID_NODEID) {
 			if (visited_nodes.at(ending_node)) {
-				this->logFmt(mrpt::utils::LVL_DEBUG, "----------- Done with Dijkstra Projection... ----------");
-				m_time_logger.leave("Dijkstra Projection");
-				return;
+				break;
 			}
 		}
 
 		TPath* optimal_path = this->popMinUncertaintyPath(&pool_of_paths);
 		TNodeID dest = optimal_path->getDestination();
 
-		//// TODO Remove these - >>>>>>>>>>>>>>>>>>>> ^^^UNCOMMENT ABOVE AS WELL^^^
-		//cout << iters << " " << std::string(40, '>') << endl;
-		//cout << "current path Destination: " << dest << endl;
-		//// printing the pool for verification
-		//cout << "Pool of Paths: " << endl;
-		//for (typename std::set<TPath*>::const_iterator it = pool_of_paths.begin();
-				//it != pool_of_paths.end(); ++it) {
-			//printVector((*it)->nodes_traversed);
-		//}
-		//cout << "Nodes visited: " << endl;
-		//std::vector<int> tmp_vec;
-		//for (int i = 0; i != visited_nodes.size(); ++i) {
-			//tmp_vec.push_back(i);
-		//}
-		//printVector(tmp_vec); cout << endl; // indices of numbers
-		//printVector(visited_nodes);         // actual flags
-		//cout << std::string(40, '<') << " " << iters++ << endl;
-		//mrpt::system::pause();
-		//// TODO Remove these - <<<<<<<<<<<<<<<<<<<<<
-
 		if (!visited_nodes.at(dest)) {
-			m_node_optimal_paths[dest] = optimal_path;
+			(*node_optimal_paths)[dest] = optimal_path;
 			visited_nodes.at(dest)= true;
 
 			// for all the edges leaving this node .. compose the transforms with the
 			// current pool of paths.
 			this->addToPaths(&pool_of_paths, *optimal_path, neighbors_of.at(dest) );
 		}
+		else {
+			delete optimal_path;
+		}
+	}
+
+	// release the paths that were not used
+	for (typename std::set<TPath*>::iterator it = pool_of_paths.begin();
+			it != pool_of_paths.end(); ++it) {
+		delete *it;
 	}
 
-	this->logFmt(mrpt::utils::LVL_DEBUG, "----------- Done with Dijkstra Projection... ----------");
-	m_time_logger.leave("Dijkstra Projection");
+	MRPT_END;
+}
+
+template<class GRAPH_t>
+void CLoopCloserERD<GRAPH_t>::clearOptimalPaths(
+		std::map<mrpt::utils::TNodeID, TPath*>* node_optimal_paths) {
+	for (typename std::map<mrpt::utils::TNodeID, TPath*>::iterator it =
+			node_optimal_paths->begin(); it != node_optimal_paths->end();
+			++it) {
+		delete it->second;
+	}
+	node_optimal_paths->clear();
+}
+
+template<class GRAPH_t>
+void CLoopCloserERD<GRAPH_t>::updateNodePositionsIndex() {
+	MRPT_START;
+
+	// nodes may have moved since the last call (optimization, loop closures)
+	// - refresh all of them. The KD-tree is rebuilt on the next query
+	const size_t n_nodes = m_graph->nodeCount();
+	m_node_positions.resize(n_nodes);
+	for (typename GRAPH_t::global_poses_t::const_iterator
+			n_it = m_graph->nodes.begin(); n_it != m_graph->nodes.end(); ++n_it) {
+		if (n_it->first >= n_nodes) continue;
+		m_node_positions.setPoint(n_it->first, n_it->second.x(), n_it->second.y(), 0);
+	}
+
+	MRPT_END;
+}
+
+template<class GRAPH_t>
+void CLoopCloserERD<GRAPH_t>::getCandidateHypothesesPairs(
+		const mrpt::vector_uint& groupA,
+		const mrpt::vector_uint& groupB,
+		std::set<std::pair<mrpt::utils::TNodeID, mrpt::utils::TNodeID> >* pairs) {
+	MRPT_START;
+	using namespace mrpt::utils;
+	using namespace std;
+	ASSERT_(pairs);
+	pairs->clear();
+
+	if (m_lc_params.LC_max_candidate_distance <= 0) {
+		for (vector_uint::const_iterator b_it = groupB.begin(); b_it != groupB.end();
+				++b_it) {
+			for (vector_uint::const_iterator a_it = groupA.begin(); a_it != groupA.end();
+					++a_it) {
+				pairs->insert(make_pair(*b_it, *a_it));
+			}
+		}
+		return;
+	}
+
+	this->updateNodePositionsIndex();
+
+	const std::set<TNodeID> groupA_set(groupA.begin(), groupA.end());
+	const float max_dist = static_cast<float>(m_lc_params.LC_max_candidate_distance);
+	std::vector<std::pair<size_t,float> > nodes_in_range;
+	for (vector_uint::const_iterator b_it = groupB.begin(); b_it != groupB.end();
+			++b_it) {
+		const pose_t& b_pose = m_graph->nodes.at(*b_it);
+		m_node_positions.kdTreeRadiusSearch2D(b_pose.x(), b_pose.y(),
+				max_dist*max_dist, nodes_in_range);
+
+		for (std::vector<std::pair<size_t,float> >::const_iterator
+				it = nodes_in_range.begin(); it != nodes_in_range.end(); ++it) {
+			if (groupA_set.count(it->first)) {
+				pairs->insert(make_pair(static_cast<TNodeID>(*b_it),
+							static_cast<TNodeID>(it->first)));
+			}
+		}
+	}
+
+	this->logFmt(LVL_DEBUG, "Candidate hypotheses within %.2fm: %lu out of %lu",
+			m_lc_params.LC_max_candidate_distance,
+			static_cast<unsigned long>(pairs->size()),
+			static_cast<unsigned long>(groupA.size()*groupB.size()));
+
 	MRPT_END;
 }
 
@@ -1906,6 +2047,10 @@ void CLoopCloserERD<GRAPH_t>::TLoopClosureParams::dumpToTextStream(
 			LC_eigenvalues_ratio_thresh);
 	out.printf("Check only current node's partition for loop closures = %s\n",
 			LC_check_curr_partition_only? "TRUE": "FALSE");
+	out.printf("Max. distance between loop closure candidate nodes    = %f\n",
+			LC_max_candidate_distance);
+	out.printf("Num. of threads for evaluating the hypotheses         = %d\n",
+			LC_num_threads);
 	out.printf("Visualize map partitions                              = %s\n",
 			visualize_map_partitions?  "TRUE": "FALSE");
 
@@ -1933,6 +2078,16 @@ void CLoopCloserERD<GRAPH_t>::TLoopClosureParams::loadFromConfigFile(
 			section,
 			"LC_check_curr_partition_only",
 			true, false);
+	LC_max_candidate_distance = source.read_double(
+			section,
+			"LC_max_candidate_distance",
+			-1, false);
+	LC_num_threads = source.read_int(
+			section,
+			"LC_num_threads",
+			0, false);
+	ASSERTMSG_(LC_num_threads >= 0,
+			mrpt::format("Invalid number of threads: %d", LC_num_threads));
 	visualize_map_partitions = source.read_bool(
 			"VisualizationParameters",
 			"visualize_map_partitions",
@@ -0,0 +1,136 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/poses/CPoint3D.h>  // Needed by graph_tools_impl.h
+#include <mrpt/graphslam/CLevMarqGSO.h>
+#include <mrpt/graphs/CNetworkOfPoses.h>
+#include <mrpt/system/threads.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::graphs;
+using namespace mrpt::graphslam::optimizers;
+using namespace mrpt::poses;
+using namespace mrpt::utils;
+using namespace std;
+
+typedef CNetworkOfPoses2DInf graph_t;
+
+namespace
+{
+	// 1m forward, with unit information matrix:
+	graph_t::edge_t path_edge()
+	{
+		return graph_t::edge_t(CPose2D(1,0,0), mrpt::math::CMatrixDouble33::Identity());
+	}
+
+	// A straight path with 1m between consecutive nodes, whose initial poses drift sideways:
+	void add_path_node(graph_t &graph, TNodeID id)
+	{
+		graph.nodes[id] = CPose2D(id, 0.05*id*id, 0);
+		if (id>0)
+			graph.insertEdge(id-1,id, path_edge());
+	}
+
+	void init_optimizer(CLevMarqGSO<graph_t> &opt, graph_t &graph)
+	{
+		opt.opt_params.optimization_on_second_thread = true;
+		opt.opt_params.optimization_distance = -1;  // Full optimization
+		opt.opt_params.LC_min_nodeid_diff = 30;
+		opt.opt_params.cfg["max_iterations"] = 100;
+		opt.setGraphPtr(&graph);
+	}
+
+	void update(CLevMarqGSO<graph_t> &opt)
+	{
+		opt.updateState(mrpt::obs::CActionCollectionPtr(), mrpt::obs::CSensoryFramePtr(), mrpt::obs::CObservationPtr());
+	}
+}
+
+TEST(CLevMarqGSO, AsyncLaunchAndMerge)
+{
+	graph_t graph;
+	graph.root = 0;
+	for (TNodeID i=0;i<10;i++) add_path_node(graph,i);
+
+	CLevMarqGSO<graph_t> opt;
+	init_optimizer(opt,graph);
+
+	for (int cycle=0;cycle<3;cycle++)
+	{
+		// Launches the optimization of a snapshot of the graph, without waiting for it:
+		update(opt);
+
+		// A node registered while the optimization runs:
+		const TNodeID last_snap = graph.nodes.rbegin()->first;
+		const TNodeID new_id = last_snap+1;
+		add_path_node(graph,new_id);
+		const CPose2D rel_new = CPose2D(graph.nodes[new_id]) - CPose2D(graph.nodes[last_snap]);
+
+		opt.syncOptimizedGraph();
+
+		// Optimized nodes lie on the straight line (initially, up to 0.05*i^2 meters away):
+		for (TNodeID i=0;i<=last_snap;i++)
+		{
+			EXPECT_NEAR(graph.nodes[i].x(), i, 0.05) << "cycle=" << cycle << " i=" << i;
+			EXPECT_NEAR(graph.nodes[i].y(), 0, 0.05) << "cycle=" << cycle << " i=" << i;
+		}
+		// ...and the new node moved rigidly along with the last one of the snapshot:
+		const CPose2D expected_new = CPose2D(graph.nodes[last_snap]) + rel_new;
+		EXPECT_NEAR(graph.nodes[new_id].x(), expected_new.x(), 1e-6) << "cycle=" << cycle;
+		EXPECT_NEAR(graph.nodes[new_id].y(), expected_new.y(), 1e-6) << "cycle=" << cycle;
+		EXPECT_NEAR(graph.nodes[new_id].phi(), expected_new.phi(), 1e-6) << "cycle=" << cycle;
+	}
+
+	// The results of a finished optimization are also merged by updateState(), without explicit sync:
+	const TNodeID new_id = graph.nodes.rbegin()->first+1;
+	add_path_node(graph,new_id);
+	const double y_before = graph.nodes[new_id].y();
+	update(opt);
+	bool merged = false;
+	for (int i=0;i<1000 && !merged;i++)
+	{
+		mrpt::system::sleep(5);
+		update(opt);
+		merged = graph.nodes[new_id].y() != y_before;
+	}
+	EXPECT_TRUE(merged);
+	EXPECT_NEAR(graph.nodes[new_id].y(), 0, 0.05);
+	opt.syncOptimizedGraph();
+}
+
+TEST(CLevMarqGSO, AsyncOptimizationFailure)
+{
+	// No edges: the optimization throws on the second thread
+	graph_t graph;
+	graph.root = 0;
+	for (TNodeID i=0;i<10;i++) graph.nodes[i] = CPose2D(i, 0.05*i*i, 0);
+	const graph_t::global_poses_t initial_poses = graph.nodes;
+
+	CLevMarqGSO<graph_t> opt;
+	init_optimizer(opt,graph);
+	opt.logging_enable_console_output = false;  // Don't clutter the test output with the expected error
+
+	update(opt);
+	EXPECT_NO_THROW(opt.syncOptimizedGraph());
+	for (TNodeID i=0;i<10;i++)
+	{
+		EXPECT_EQ(graph.nodes[i].x(), initial_poses.find(i)->second.x());
+		EXPECT_EQ(graph.nodes[i].y(), initial_poses.find(i)->second.y());
+	}
+
+	// The optimizer is not stuck: the next node launches a new optimization
+	for (TNodeID i=1;i<10;i++)
+		graph.insertEdge(i-1,i, path_edge());
+	add_path_node(graph,10);
+	update(opt);
+	opt.syncOptimizedGraph();
+	for (TNodeID i=0;i<=10;i++)
+		EXPECT_NEAR(graph.nodes[i].y(), 0, 0.05) << "i=" << i;
+}
@@ -19,6 +19,7 @@
 #include <mrpt/hmtslam/CHierarchicalMHMap.h>
 #include <mrpt/hmtslam/CTopLCDetector_GridMatching.h>
 #include <mrpt/hmtslam/CTopLCDetector_FabMap.h>
+#include <mrpt/hmtslam/CTopLCDetector_BoW.h>
 #include <mrpt/hmtslam/link_pragmas.h>
 #include <mrpt/slam/CICP.h>
 #include <mrpt/maps/CPointsMap.h>
@@ -62,6 +63,7 @@ namespace mrpt
 			friend class CLSLAM_RBPF_2DLASER;
 			friend class CTopLCDetector_GridMatching;
 			friend class CTopLCDetector_FabMap;
+			friend class CTopLCDetector_BoW;
 
 			// This must be added to any CSerializable derived class:
 			DEFINE_SERIALIZABLE( CHMTSLAM )
@@ -444,11 +446,13 @@ namespace mrpt
 				/** A list of topological loop-closure detectors to use: can be one or more from this list:
 				  *  'gridmaps': Occupancy Grid matching.
 				  *  'fabmap': Mark Cummins' image matching framework.
+				  *  'bow': Bag-of-binary-words (ORB) image matching, see CTopLCDetector_BoW.
 				  */
 				vector_string				TLC_detectors;
 
 				CTopLCDetector_GridMatching::TOptions	TLC_grid_options;	//!< Options passed to this TLC constructor
 				CTopLCDetector_FabMap::TOptions	TLC_fabmap_options;	//!< Options passed to this TLC constructor
+				CTopLCDetector_BoW::TOptions	TLC_bow_options;	//!< Options passed to this TLC constructor
 
 			} m_options;
 
@@ -56,6 +56,20 @@ namespace mrpt
 				double					&out_log_lik
 				 ) = 0;
 
+			/** If implemented, this method proposes areas to be tested for loop closure with "currentArea", in addition to those
+			  *  whose bounding boxes overlap it (e.g. areas where similar images were seen, for appearance-based detectors).
+			  *  The proposed areas are then evaluated with computeTopologicalObservationModel() as any other candidate.
+			  *  The default virtual method proposes nothing.
+			  */
+			virtual void proposeLoopClosureCandidates(
+				const THypothesisID		&hypID,
+				const CHMHMapNodePtr	&currentArea,
+				std::set<mrpt::utils::TNodeID> &out_candidate_areas
+				)
+			{
+				MRPT_UNUSED_PARAM(hypID); MRPT_UNUSED_PARAM(currentArea); MRPT_UNUSED_PARAM(out_candidate_areas);
+			}
+
 			/** If implemented, this method provides the evaluation of an additional term to be added to the SSO between each pair of observations.
 			  * \param out_SSO The output, in the range [0,1].
 			  * \return true if computed SSO is meaningful. The default virtual method returns false.
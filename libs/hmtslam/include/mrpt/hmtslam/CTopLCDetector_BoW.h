@@ -0,0 +1,110 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef _CTopLCDetector_BoW_H
+#define _CTopLCDetector_BoW_H
+
+#include <mrpt/hmtslam/CTopLCDetectorBase.h>
+#include <mrpt/vision/CBoWDatabase.h>
+#include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/synch/CCriticalSection.h>
+
+namespace mrpt
+{
+	namespace hmtslam
+	{
+		/** A topological loop-closure detector based on the appearance of the images of each pose,
+		  *  with bag-of-binary-words (ORB) place recognition (see mrpt::vision::CBinaryVocabulary and mrpt::vision::CBoWDatabase).
+		  *
+		  *  The images of each new pose are inserted into a database, which is queried with the images of the current area
+		  *  to propose loop-closure candidate areas. The observation model of a candidate is the log of the best similarity between
+		  *  images of both areas, without a pose PDF. Since closing a loop requires a relative pose between the areas, this detector
+		  *  must be used together with a metric one (e.g. TLC_detectors = gridmaps,bow): candidates for which no detector gives a pose PDF are discarded.
+		  *
+		  *  The vocabulary must be trained beforehand (see CBinaryVocabulary::train()) and saved to the file in TOptions::vocabulary_file.
+		  *  Images are taken from mrpt::obs::CObservationImage and the left camera of mrpt::obs::CObservationStereoImages.
+		  * \ingroup mrpt_hmtslam_grp
+		  */
+		class HMTSLAM_IMPEXP CTopLCDetector_BoW : public CTopLCDetectorBase
+		{
+		protected:
+			CTopLCDetector_BoW( CHMTSLAM *hmtslam );
+
+			mrpt::vision::CBinaryVocabulary	m_vocabulary;
+			mrpt::vision::CFeatureExtraction	m_feature_extractor;
+			mrpt::vision::CBoWDatabase		m_database;
+			std::vector<TPoseID>			m_image_poses;	//!< The pose of each image in m_database
+			std::map<TPoseID, std::vector<mrpt::vision::TBoWVector> > m_pose_bows; //!< BoW vectors of the images of each pose
+			mrpt::synch::CCriticalSection	m_cs; //!< OnNewPose() and the TBI methods are called from different threads
+
+			/** The poses of an area, from its NODE_ANNOTATION_POSES_GRAPH annotation */
+			void getAreaPoses(const THypothesisID &hypID, const CHMHMapNodePtr &area, TPoseIDSet &out_poses) const;
+
+		public:
+			/** A class factory, to be implemented in derived classes.
+			  */
+			static CTopLCDetectorBase* createNewInstance( CHMTSLAM *hmtslam )
+			{
+				return static_cast<CTopLCDetectorBase*>(new CTopLCDetector_BoW(hmtslam));
+			}
+
+			/** Destructor */
+			virtual ~CTopLCDetector_BoW();
+
+			/** Clears the database of images */
+			void reset() MRPT_OVERRIDE;
+
+			/** This method must compute the topological observation model.
+			  * \param out_log_lik The output, a log-likelihood.
+			  * \return Always NULL (empty smart pointer): this detector does not estimate the relative pose of the areas.
+			  */
+			mrpt::poses::CPose3DPDFPtr computeTopologicalObservationModel(
+				const THypothesisID		&hypID,
+				const CHMHMapNodePtr	&currentArea,
+				const CHMHMapNodePtr	&refArea,
+				double					&out_log_lik
+				 ) MRPT_OVERRIDE;
+
+			/** Proposes the areas with the images most similar to those of the current area. */
+			void proposeLoopClosureCandidates(
+				const THypothesisID		&hypID,
+				const CHMHMapNodePtr	&currentArea,
+				std::set<mrpt::utils::TNodeID> &out_candidate_areas
+				) MRPT_OVERRIDE;
+
+			/** Hook method for being warned about the insertion of a new poses into the maps.
+			  *  This should be independent of hypothesis IDs.
+			  */
+			void OnNewPose(
+				const TPoseID 			&poseID,
+				const mrpt::obs::CSensoryFrame		*SF ) MRPT_OVERRIDE;
+
+
+			/** Options for a TLC-detector of type BoW, used from CHMTSLAM
+			  */
+			struct TOptions : public utils::CLoadableOptions
+			{
+				/** Initialization of default params
+				  */
+				TOptions();
+
+				void loadFromConfigFile(const mrpt::utils::CConfigFileBase &source,const std::string &section) MRPT_OVERRIDE; // See base docs
+				void dumpToTextStream(mrpt::utils::CStream &out) const MRPT_OVERRIDE; // See base docs
+
+				std::string		vocabulary_file;	//!< A mrpt::vision::CBinaryVocabulary, serialized (may be gz-compressed)
+				unsigned int	num_features;		//!< Number of ORB features per image (Default: 500)
+				unsigned int	max_candidates;		//!< Max. number of similar images retrieved for each image of the current area (Default: 5)
+				double			min_score;			//!< Min. similarity [0,1] of images to propose their areas; also the lower bound of the similarity in the observation model (Default: 0.05)
+			};
+
+		}; // end class
+	} // end namespace
+} // end namespace
+
+
+#endif
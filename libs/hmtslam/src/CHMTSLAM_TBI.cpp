@@ -177,6 +177,29 @@ CHMTSLAM::TMessageLSLAMfromTBIPtr CHMTSLAM::TBI_main_method(
 		}
 	} // end for each node in the graph.
 
+	// Additional candidates proposed by the LC detectors (e.g. areas with similar images):
+	{
+		synch::CCriticalSectionLocker lock( &obj->m_topLCdets_cs );
+
+		std::set<CHMHMapNode::TNodeID> proposedAreas;
+		for ( deque<CTopLCDetectorBase*>::const_iterator it=obj->m_topLCdets.begin();it!=obj->m_topLCdets.end();++it)
+			(*it)->proposeLoopClosureCandidates( LMH_ID, currentArea, proposedAreas );
+
+		for (std::set<CHMHMapNode::TNodeID>::const_iterator a=proposedAreas.begin();a!=proposedAreas.end();++a)
+		{
+			if (*a==areaID || msg->loopClosureData.count(*a)) continue;
+
+			const CHMHMapNodePtr area = obj->m_map.getNodeByID( *a );
+			if (!area || !area->m_hypotheses.has(LMH_ID) || area->isNeighbor( areaID, LMH_ID) )
+				continue;
+
+			obj->logFmt(mrpt::utils::LVL_DEBUG, "[TBI] %i-%i -> proposed by a LC detector\n",(int)areaID,(int)*a);
+
+			TMessageLSLAMfromTBI::TBI_info	&tbi_info = msg->loopClosureData[ *a ];
+			tbi_info.log_lik = 0;
+			tbi_info.delta_new_cur.clear();
+		}
+	}
 
 	// ----------------------------------------------------
 	// 2) Use the TBI engines
@@ -225,6 +248,12 @@ CHMTSLAM::TMessageLSLAMfromTBIPtr CHMTSLAM::TBI_main_method(
 
 	} // end of m_topLCdets_cs lock
 
+	// LSLAM needs a pose PDF to close the loop: drop candidates for which no
+	//  metric detector gave one (e.g. if only image-based detectors are active).
+	for (map< CHMHMapNode::TNodeID, TMessageLSLAMfromTBI::TBI_info >::const_iterator candidate = msg->loopClosureData.begin();candidate != msg->loopClosureData.end();++candidate)
+		if (candidate->second.delta_new_cur.empty())
+			lstNodesToErase.insert(candidate->first);
+
 	// Delete candidates which had no PDF when they should.
 	for (set<CHMHMapNode::TNodeID>::const_iterator it=lstNodesToErase.begin();it!=lstNodesToErase.end();++it)
 		msg->loopClosureData.erase(*it);
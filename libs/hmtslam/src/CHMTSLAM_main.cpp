@@ -89,6 +89,7 @@ CHMTSLAM::CHMTSLAM( )
 	// --------------------------------
 	registerLoopClosureDetector("gridmaps", & CTopLCDetector_GridMatching::createNewInstance );
 	registerLoopClosureDetector("fabmap", & CTopLCDetector_FabMap::createNewInstance );
+	registerLoopClosureDetector("bow", & CTopLCDetector_BoW::createNewInstance );
 
 	// Prepare an empty map:
 	initializeEmptyMap();
@@ -255,6 +256,7 @@ void CHMTSLAM::loadOptions( const mrpt::utils::CConfigFileBase &cfg )
 	// Topological Loop Closure detector options:
 	m_options.TLC_grid_options.loadFromConfigFile(cfg,"TLC_GRIDMATCHING");
 	m_options.TLC_fabmap_options.loadFromConfigFile(cfg,"TLC_FABMAP");
+	m_options.TLC_bow_options.loadFromConfigFile(cfg,"TLC_BOW");
 
 	m_options.dumpToConsole();
 }
@@ -363,6 +365,7 @@ void  CHMTSLAM::TOptions::dumpToTextStream(mrpt::utils::CStream	&out) const
 	defaultMapsInitializers.dumpToTextStream(out);
 	TLC_grid_options.dumpToTextStream(out);
 	TLC_fabmap_options.dumpToTextStream(out);
+	TLC_bow_options.dumpToTextStream(out);
 }
 
 /*---------------------------------------------------------------
@@ -496,6 +499,7 @@ void  CHMTSLAM::initializeEmptyMap()
 		// Create new list:
 		//  1: Occupancy Grid matching.
 		//  2: Cummins' image matching.
+		//  3: Bag-of-binary-words image matching.
 		for (vector_string::const_iterator d=m_options.TLC_detectors.begin();d!=m_options.TLC_detectors.end();++d)
 			m_topLCdets.push_back( loopClosureDetector_factory(*d) );
 	}
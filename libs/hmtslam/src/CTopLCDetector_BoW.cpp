@@ -0,0 +1,258 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include "hmtslam-precomp.h" // Precomp header
+
+#include <mrpt/hmtslam/CTopLCDetector_BoW.h>
+#include <mrpt/hmtslam/CRobotPosesGraph.h>
+#include <mrpt/obs/CObservationImage.h>
+#include <mrpt/obs/CObservationStereoImages.h>
+#include <mrpt/utils/CFileGZInputStream.h>
+#include <mrpt/system/filesystem.h>
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::synch;
+using namespace mrpt::vision;
+using namespace mrpt::hmtslam;
+using namespace std;
+
+CTopLCDetector_BoW::CTopLCDetector_BoW(CHMTSLAM *hmtslam) :
+	CTopLCDetectorBase(hmtslam),
+	m_feature_extractor()
+{
+	// Use already loaded options:
+	const CTopLCDetector_BoW::TOptions &o = m_hmtslam->m_options.TLC_bow_options;
+
+	if (!mrpt::system::fileExists(o.vocabulary_file))
+		THROW_EXCEPTION_CUSTOM_MSG1("Vocabulary file not found: '%s'", o.vocabulary_file.c_str())
+
+	CFileGZInputStream f(o.vocabulary_file);
+	f >> m_vocabulary;
+	ASSERTMSG_(!m_vocabulary.empty(), "The vocabulary is empty")
+
+	m_feature_extractor.options.featsType = mrpt::vision::featORB;
+}
+
+CTopLCDetector_BoW::~CTopLCDetector_BoW()
+{
+}
+
+void CTopLCDetector_BoW::reset()
+{
+	CCriticalSectionLocker lock(&m_cs);
+	m_database.clear();
+	m_image_poses.clear();
+	m_pose_bows.clear();
+}
+
+void CTopLCDetector_BoW::getAreaPoses(const THypothesisID &hypID, const CHMHMapNodePtr &area, TPoseIDSet &out_poses) const
+{
+	out_poses.clear();
+	CRobotPosesGraphPtr posesGraph = area->m_annotations.getAs<CRobotPosesGraph>(NODE_ANNOTATION_POSES_GRAPH, hypID);
+	if (!posesGraph) return;
+	for (CRobotPosesGraph::const_iterator it=posesGraph->begin();it!=posesGraph->end();++it)
+		out_poses.insert(it->first);
+}
+
+/** This method must compute the topological observation model.
+  * \param out_log_lik The output, a log-likelihood.
+  * \return NULL, or a PDF of the estimated translation between the two areas (can be a multi-modal PDF).
+  */
+CPose3DPDFPtr CTopLCDetector_BoW::computeTopologicalObservationModel(
+	const THypothesisID		&hypID,
+	const CHMHMapNodePtr	&currentArea,
+	const CHMHMapNodePtr	&refArea,
+	double					&out_log_lik
+	)
+{
+	MRPT_START
+	const CTopLCDetector_BoW::TOptions &o = m_hmtslam->m_options.TLC_bow_options;
+
+	TPoseIDSet curPoses, refPoses;
+	getAreaPoses(hypID,currentArea,curPoses);
+	getAreaPoses(hypID,refArea,refPoses);
+
+	// The best similarity between any pair of images of both areas:
+	float best_score = 0;
+	{
+		CCriticalSectionLocker lock(&m_cs);
+		for (TPoseIDSet::const_iterator c=curPoses.begin();c!=curPoses.end();++c)
+		{
+			std::map<TPoseID, std::vector<TBoWVector> >::const_iterator itCur = m_pose_bows.find(*c);
+			if (itCur==m_pose_bows.end()) continue;
+
+			for (TPoseIDSet::const_iterator r=refPoses.begin();r!=refPoses.end();++r)
+			{
+				std::map<TPoseID, std::vector<TBoWVector> >::const_iterator itRef = m_pose_bows.find(*r);
+				if (itRef==m_pose_bows.end()) continue;
+
+				for (size_t i=0;i<itCur->second.size();i++)
+					for (size_t j=0;j<itRef->second.size();j++)
+						best_score = std::max(best_score, CBinaryVocabulary::score(itCur->second[i],itRef->second[j]));
+			}
+		}
+	}
+
+	out_log_lik = std::log( std::max(static_cast<double>(best_score), o.min_score) );
+
+	m_hmtslam->logFmt(mrpt::utils::LVL_DEBUG, "[TLCD_bow] Areas %i-%i: best image similarity=%f\n",(int)currentArea->getID(),(int)refArea->getID(),best_score);
+
+	return CPose3DPDFPtr();
+	MRPT_END
+}
+
+void CTopLCDetector_BoW::proposeLoopClosureCandidates(
+	const THypothesisID		&hypID,
+	const CHMHMapNodePtr	&currentArea,
+	std::set<mrpt::utils::TNodeID> &out_candidate_areas
+	)
+{
+	MRPT_START
+	const CTopLCDetector_BoW::TOptions &o = m_hmtslam->m_options.TLC_bow_options;
+
+	TPoseIDSet curPoses;
+	getAreaPoses(hypID,currentArea,curPoses);
+
+	// Poses outside of the current area with images similar to those of the current area:
+	TPoseIDSet similarPoses;
+	{
+		CCriticalSectionLocker lock(&m_cs);
+
+		size_t num_cur_images = 0;
+		for (TPoseIDSet::const_iterator c=curPoses.begin();c!=curPoses.end();++c)
+		{
+			std::map<TPoseID, std::vector<TBoWVector> >::const_iterator it = m_pose_bows.find(*c);
+			if (it!=m_pose_bows.end()) num_cur_images+=it->second.size();
+		}
+
+		std::vector<TBoWQueryResult> results;
+		for (TPoseIDSet::const_iterator c=curPoses.begin();c!=curPoses.end();++c)
+		{
+			std::map<TPoseID, std::vector<TBoWVector> >::const_iterator it = m_pose_bows.find(*c);
+			if (it==m_pose_bows.end()) continue;
+
+			for (size_t i=0;i<it->second.size();i++)
+			{
+				// Ask for more results, since images of the current area will be also found:
+				m_database.query(it->second[i], results, o.max_candidates+num_cur_images, static_cast<float>(o.min_score));
+
+				size_t n = 0;
+				for (size_t k=0;k<results.size() && n<o.max_candidates;k++)
+				{
+					const TPoseID poseID = m_image_poses[results[k].image_id];
+					if (curPoses.count(poseID)) continue;
+					similarPoses.insert(poseID);
+					n++;
+				}
+			}
+		}
+	}
+	if (similarPoses.empty()) return;
+
+	// Areas containing those poses:
+	for (CHierarchicalMapMHPartition::const_iterator a=m_hmtslam->m_map.begin();a!=m_hmtslam->m_map.end();++a)
+	{
+		if (a->first==currentArea->getID() || !a->second->m_hypotheses.has(hypID)) continue;
+
+		TPoseIDSet areaPoses;
+		getAreaPoses(hypID,a->second,areaPoses);
+		for (TPoseIDSet::const_iterator p=areaPoses.begin();p!=areaPoses.end();++p)
+		{
+			if (similarPoses.count(*p))
+			{
+				out_candidate_areas.insert(a->first);
+				break;
+			}
+		}
+	}
+	MRPT_END
+}
+
+/** Hook method for being warned about the insertion of a new poses into the maps.
+  *  This should be independent of hypothesis IDs.
+  */
+void CTopLCDetector_BoW::OnNewPose(
+	const TPoseID 			&poseID,
+	const CSensoryFrame		*SF )
+{
+	MRPT_START
+	const CTopLCDetector_BoW::TOptions &o = m_hmtslam->m_options.TLC_bow_options;
+
+	// Images of this pose (kept alive by the SF):
+	std::vector<const CImage*> images;
+	size_t n = 0;
+	CObservationImagePtr obsIm;
+	while ( (obsIm = SF->getObservationByClass<CObservationImage>(n)).present() )
+	{
+		images.push_back(&obsIm->image);
+		n++;
+	}
+	n = 0;
+	CObservationStereoImagesPtr obsStereo;
+	while ( (obsStereo = SF->getObservationByClass<CObservationStereoImages>(n)).present() )
+	{
+		images.push_back(&obsStereo->imageLeft);
+		n++;
+	}
+	if (images.empty())  return; // Not all poses must have images.
+
+	// Feature extraction and BoW vectors, out of the critical section:
+	std::vector<TBoWVector> bows(images.size());
+	for (size_t i=0;i<images.size();i++)
+	{
+		CFeatureList feats;
+		m_feature_extractor.detectFeatures(*images[i], feats, 0, o.num_features);
+		m_vocabulary.transform(feats, bows[i]);
+	}
+
+	CCriticalSectionLocker lock(&m_cs);
+	std::vector<TBoWVector> &poseBows = m_pose_bows[poseID];
+	for (size_t i=0;i<bows.size();i++)
+	{
+		m_database.add(bows[i]);
+		m_image_poses.push_back(poseID);
+		poseBows.push_back(TBoWVector());
+		poseBows.back().swap(bows[i]);
+	}
+	MRPT_END
+}
+
+
+// Initialization
+CTopLCDetector_BoW::TOptions::TOptions() :
+	vocabulary_file("./vocabulary.gz"),
+	num_features(500),
+	max_candidates(5),
+	min_score(0.05)
+{
+}
+
+//  Load parameters from configuration source
+void  CTopLCDetector_BoW::TOptions::loadFromConfigFile(
+	const mrpt::utils::CConfigFileBase	&iniFile,
+	const std::string		&section)
+{
+	MRPT_LOAD_CONFIG_VAR(vocabulary_file,string,  			iniFile, section );
+	MRPT_LOAD_CONFIG_VAR(num_features,int,  			iniFile, section );
+	MRPT_LOAD_CONFIG_VAR(max_candidates,int,  			iniFile, section );
+	MRPT_LOAD_CONFIG_VAR(min_score,double,  			iniFile, section );
+}
+
+//  This method must display clearly all the contents of the structure in textual form, sending it to a CStream.
+void CTopLCDetector_BoW::TOptions::dumpToTextStream(mrpt::utils::CStream &out) const	{
+	out.printf("\n----------- [CTopLCDetector_BoW::TOptions] ------------ \n\n");
+
+	LOADABLEOPTS_DUMP_VAR(vocabulary_file, string)
+	LOADABLEOPTS_DUMP_VAR(num_features, int)
+	LOADABLEOPTS_DUMP_VAR(max_candidates, int)
+	LOADABLEOPTS_DUMP_VAR(min_score, double)
+}
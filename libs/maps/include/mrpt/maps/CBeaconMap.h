@@ -58,6 +58,10 @@ namespace maps
 		virtual void  internal_clear() MRPT_OVERRIDE;
 		virtual bool  internal_insertObservation( const mrpt::obs::CObservation *obs, const mrpt::poses::CPose3D *robotPose = NULL ) MRPT_OVERRIDE;
 		double	 internal_computeObservationLikelihood( const mrpt::obs::CObservation *obs, const mrpt::poses::CPose3D &takenFrom ) MRPT_OVERRIDE;
+		/** Evaluates all the poses at once: the modes of each observed beacon (samples, Gaussian or SOG modes) are copied into flat arrays,
+		  *  then the sensor positions for all the poses are evaluated against each mode in loops over contiguous memory (two poses at once
+		  *  with SSE2, if available). Blocks of poses are processed in parallel if TLikelihoodOptions::num_threads!=1. */
+		void internal_computeObservationLikelihoodForPoses( const mrpt::obs::CObservation *obs, const std::vector<mrpt::math::TPose3D> &takenFrom, std::vector<double> &out_log_liks ) MRPT_OVERRIDE;
 
 	public:
 		/** Constructor */
@@ -113,6 +117,10 @@ namespace maps
 			 /** The standard deviation used for Beacon ranges likelihood (default=0.08m).
 			   */
 			 float			rangeStd;
+
+			 /** Number of threads for CMetricMap::computeObservationLikelihoodForPoses(), each one evaluating a block of poses (default=1, 0=one per core).
+			   */
+			 unsigned int	num_threads;
 		 } likelihoodOptions;
 
 		 /** This struct contains data for choosing the method by which new beacons are inserted in the map.
@@ -166,6 +174,11 @@ namespace maps
 			  */
 			float			SOG_separationConstant;
 
+			/** Number of threads for fusing the ranges to different Gaussian/SOG beacons of one observation, which are independent updates
+			  *  (default=1, 0=one per core). Monte Carlo beacons are always updated sequentially, since they draw random samples.
+			  */
+			unsigned int	num_threads;
+
 		 } insertionOptions;
 
 		/** Save to a MATLAB script which displays 3D error ellipses for the map.
@@ -14,6 +14,7 @@
 #include <mrpt/utils/CLoadableOptions.h>
 #include <mrpt/utils/CImage.h>
 #include <mrpt/utils/CDynamicGrid.h>
+#include <mrpt/utils/CCopyOnWriteTiledGrid.h>
 #include <mrpt/maps/CMetricMap.h>
 #include <mrpt/utils/TMatchingPair.h>
 #include <mrpt/maps/CLogOddsGridMap2D.h>
@@ -56,6 +57,9 @@ namespace maps
 	 *		- Laser scans simulation for the map contents
 	 *		- Entropy and information methods (See computeEntropy)
 	 *
+	 * Cells are stored in square tiles shared between copies of the map until one of them modifies a tile (see mrpt::utils::CCopyOnWriteTiledGrid),
+	 *  so copying a grid (e.g. when duplicating particles in RBPF-SLAM) is cheap and only the tiles modified afterwards take memory.
+	 *
 	 * \ingroup mrpt_maps_grp
 	 **/
 	class MAPS_IMPEXP COccupancyGridMap2D :
@@ -95,12 +99,12 @@ namespace maps
 		void freeMap(); //!< Frees the dynamic memory buffers of map.
 		static CLogOddsGridMapLUT<cellType>  m_logodd_lut; //!< Lookup tables for log-odds
 
-		std::vector<cellType>    map;  //!< Store of cell occupancy values. Order: row by row, from left to right
+		mrpt::utils::CCopyOnWriteTiledGrid<cellType> map;  //!< Store of cell occupancy values, as copy-on-write tiles. Write into it only through map.cellForWrite()
 		uint32_t  size_x,size_y; //!< The size of the grid in cells
 		float     x_min,x_max,y_min,y_max; //!< The limits of the grid in "units" (meters)
 		float     resolution; //!< Cell size, i.e. resolution of the grid map.
 
-		std::vector<double> precomputedLikelihood; //!< Auxiliary variables to speed up the computation of observation likelihood values for LF method among others, at a high cost in memory (see TLikelihoodOptions::enableLikelihoodCache).
+		mrpt::utils::CCopyOnWriteTiledGrid<double> precomputedLikelihood; //!< Auxiliary variables to speed up the computation of observation likelihood values for LF method among others, at a high cost in memory (see TLikelihoodOptions::enableLikelihoodCache).
 		bool precomputedLikelihoodToBeRecomputed;
 
 		/** Used for Voronoi calculation.Same struct as "map", but contains a "0" if not a basis point. */
@@ -121,18 +125,18 @@ namespace maps
 		static std::vector<float> entropyTable; //!< Internally used to speed-up entropy calculation
 
 		/** Change the contents [0,1] of a cell, given its index */
-		inline void   setCell_nocheck(int x,int y,float value) { 
-			map[x+y*size_x]=p2l(value);
+		inline void   setCell_nocheck(int x,int y,float value) {
+			map.cellForWrite(x,y)=p2l(value);
 		}
 
 		/** Read the real valued [0,1] contents of a cell, given its index */
 		inline float  getCell_nocheck(int x,int y) const {
-				return l2p(map[x+y*size_x]);
+				return l2p(map(x,y));
 		}
 		/** Changes a cell by its absolute index (Do not use it normally) */
 		inline void  setRawCell(unsigned int cellIndex, cellType b) {
 			if (cellIndex<size_x*size_y)
-				map[cellIndex] = b;
+				map.cellForWrite(cellIndex % size_x, cellIndex / size_x) = b;
 		}
 
 		/** One of the methods that can be selected for implementing "computeObservationLikelihood" (This method is the Range-Scan Likelihood Consensus for gridmaps, see the ICRA2007 paper by Blanco et al.)  */
@@ -165,7 +169,7 @@ namespace maps
 
 	public:
 		/** Read-only access to the raw cell contents (cells are in log-odd units) */
-		const std::vector<cellType> & getRawMap() const { return this->map; }
+		const mrpt::utils::CCopyOnWriteTiledGrid<cellType> & getRawMap() const { return this->map; }
 		/** Performs the Bayesian fusion of a new observation of a cell  \sa updateInfoChangeOnly, updateCell_fast_occupied, updateCell_fast_free */
 		void  updateCell(int x,int y, float v);
 
@@ -268,7 +272,7 @@ namespace maps
 			// The x> comparison implicitly holds if x<0
 			if (static_cast<unsigned int>(x)>=size_x ||	static_cast<unsigned int>(y)>=size_y)
 					return;
-			else	map[x+y*size_x]=p2l(value);
+			else	map.cellForWrite(x,y)=p2l(value);
 		}
 
 		/** Read the real valued [0,1] contents of a cell, given its index */
@@ -277,14 +281,14 @@ namespace maps
 			// The x> comparison implicitly holds if x<0
 			if (static_cast<unsigned int>(x)>=size_x ||	static_cast<unsigned int>(y)>=size_y)
 					return 0.5f;
-			else	return l2p(map[x+y*size_x]);
+			else	return l2p(map(x,y));
 		}
 
-		/** Access to a "row": mainly used for drawing grid as a bitmap efficiently, do not use it normally */
-		inline  cellType *getRow( int cy ) { if (cy<0 || static_cast<unsigned int>(cy)>=size_y) return NULL; else return &map[0+cy*size_x]; }
+		/** Copies a "row" of raw cells (in log-odd units) into a buffer of getSizeX() elements: mainly used for drawing grid as a bitmap efficiently, do not use it normally */
+		inline void getRow( int cy, cellType *out_row ) const { ASSERT_(cy>=0 && static_cast<unsigned int>(cy)<size_y) map.getRow(cy,out_row); }
 
-		/** Access to a "row": mainly used for drawing grid as a bitmap efficiently, do not use it normally */
-		inline  const cellType *getRow( int cy ) const { if (cy<0 || static_cast<unsigned int>(cy)>=size_y) return NULL; else return &map[0+cy*size_x]; }
+		/** Overwrites a "row" of raw cells (in log-odd units) from a buffer of getSizeX() elements, do not use it normally */
+		inline void setRow( int cy, const cellType *row ) { ASSERT_(cy>=0 && static_cast<unsigned int>(cy)<size_y) map.setRow(cy,row); }
 
 		/** Change the contents [0,1] of a cell, given its coordinates */
 		inline void   setPos(float x,float y,float value) { setCell(x2idx(x),y2idx(y),value); }
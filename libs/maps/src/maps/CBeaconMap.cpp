@@ -20,6 +20,7 @@
 #include <mrpt/bayes/CParticleFilter.h>
 #include <mrpt/math/data_utils.h> // averageLogLikelihood()
 #include <mrpt/system/os.h>
+#include <mrpt/system/threads.h>
 #include <mrpt/utils/CStream.h>
 
 #include <mrpt/opengl/COpenGLScene.h>
@@ -27,6 +28,13 @@
 #include <mrpt/opengl/CGridPlaneXY.h>
 #include <mrpt/opengl/stock_objects.h>
 
+#if MRPT_HAS_SSE2
+#	include <mrpt/utils/SSE_types.h>
+#endif
+
+#include <map>
+#include <algorithm>
+
 using namespace mrpt;
 using namespace mrpt::maps;
 using namespace mrpt::math;
@@ -340,6 +348,615 @@ double	 CBeaconMap::internal_computeObservationLikelihood(
 	MRPT_END
 }
 
+namespace
+{
+	/** The modes of the PDF of one beacon (the samples, a single Gaussian or the Gaussians of a SOG), flattened into contiguous arrays */
+	struct TBeaconFlatModes
+	{
+		std::vector<double> x,y,z;                    //!< Mean of each mode
+		std::vector<double> c00,c01,c02,c11,c12,c22;  //!< Covariance of each mode (zero for samples)
+		std::vector<double> log_w;                    //!< Log-weight of each mode
+		double              log_w_max;                //!< max(log_w)
+		double              log_sum_w;                //!< log( sum(exp(log_w-log_w_max)) )
+
+		size_t size() const { return x.size(); }
+
+		void loadFrom(const CBeacon &beac)
+		{
+			size_t n = 0;
+			switch (beac.m_typePDF)
+			{
+			case CBeacon::pdfMonteCarlo: n = beac.m_locationMC.m_particles.size(); break;
+			case CBeacon::pdfGauss: n = 1; break;
+			case CBeacon::pdfSOG: n = beac.m_locationSOG.size(); break;
+			default:
+				THROW_EXCEPTION("Invalid beac->m_typePDF!!!");
+			};
+			x.resize(n); y.resize(n); z.resize(n); log_w.resize(n);
+			c00.assign(n,0); c01.assign(n,0); c02.assign(n,0); c11.assign(n,0); c12.assign(n,0); c22.assign(n,0);
+
+			switch (beac.m_typePDF)
+			{
+			case CBeacon::pdfMonteCarlo:
+				for (size_t j=0;j<n;j++)
+				{
+					const CPointPDFParticles::CParticleList::value_type &p = beac.m_locationMC.m_particles[j];
+					x[j] = p.d->x; y[j] = p.d->y; z[j] = p.d->z;
+					log_w[j] = p.log_w;
+				}
+				break;
+			case CBeacon::pdfGauss:
+				loadGaussian(0, beac.m_locationGauss, 0);
+				break;
+			default: // pdfSOG
+				{
+					size_t j=0;
+					for (CPointPDFSOG::const_iterator it=beac.m_locationSOG.begin();it!=beac.m_locationSOG.end();++it,++j)
+						loadGaussian(j, it->val, it->log_w);
+				}
+				break;
+			};
+
+			log_w_max = n ? *std::max_element(log_w.begin(),log_w.end()) : 0;
+			double sum_w = 0;
+			for (size_t j=0;j<n;j++)
+				sum_w += std::exp(log_w[j]-log_w_max);
+			log_sum_w = std::log(sum_w);
+		}
+
+	private:
+		void loadGaussian(const size_t j, const CPointPDFGaussian &g, const double lw)
+		{
+			x[j] = g.mean.x(); y[j] = g.mean.y(); z[j] = g.mean.z();
+			c00[j] = g.cov(0,0); c01[j] = g.cov(0,1); c02[j] = g.cov(0,2);
+			c11[j] = g.cov(1,1); c12[j] = g.cov(1,2); c22[j] = g.cov(2,2);
+			log_w[j] = lw;
+		}
+	};
+
+	/** Robot poses as separate arrays of translations and rotation matrix entries */
+	struct TPosesSoA
+	{
+		std::vector<double> x,y,z, r00,r01,r02, r10,r11,r12, r20,r21,r22;
+
+		void loadFrom(const std::vector<TPose3D> &poses)
+		{
+			const size_t N = poses.size();
+			x.resize(N); y.resize(N); z.resize(N);
+			r00.resize(N); r01.resize(N); r02.resize(N);
+			r10.resize(N); r11.resize(N); r12.resize(N);
+			r20.resize(N); r21.resize(N); r22.resize(N);
+			for (size_t i=0;i<N;i++)
+			{
+				const TPose3D &p = poses[i];
+				const double cy = cos(p.yaw), sy = sin(p.yaw);
+				const double cp = cos(p.pitch), sp = sin(p.pitch);
+				const double cr = cos(p.roll), sr = sin(p.roll);
+				x[i] = p.x; y[i] = p.y; z[i] = p.z;
+				r00[i] = cy*cp;  r01[i] = cy*sp*sr-sy*cr;  r02[i] = cy*sp*cr+sy*sr;
+				r10[i] = sy*cp;  r11[i] = sy*sp*sr+cy*cr;  r12[i] = sy*sp*cr-cy*sr;
+				r20[i] = -sp;    r21[i] = cp*sr;           r22[i] = cp*cr;
+			}
+		}
+	};
+
+	/** A range to a beacon in the map, to be evaluated for all the poses */
+	struct TBeaconRangeToEvaluate
+	{
+		size_t  modes_idx;           //!< Index in the list of TBeaconFlatModes
+		double  lx,ly,lz;            //!< Sensor location on the robot
+		double  sensedRange;
+	};
+
+	/** Log-likelihood of a range from the sensor at (sx[i],sy[i],sz[i]), for i in [0,n), to the j'th mode of a beacon, with the variance
+	  *  of the range linearized at the mode mean, as in CBeaconMap::internal_computeObservationLikelihood() */
+	void beaconRangeLogLiks(
+		const TBeaconFlatModes &m, const size_t j,
+		const double *sx, const double *sy, const double *sz, const size_t n,
+		const double sensedRange, const double varR,
+		double *out_ll)
+	{
+		const double mx = m.x[j], my = m.y[j], mz = m.z[j];
+		const double c00 = m.c00[j], c01 = m.c01[j], c02 = m.c02[j], c11 = m.c11[j], c12 = m.c12[j], c22 = m.c22[j];
+		size_t i=0;
+#if MRPT_HAS_SSE2
+		// Two poses at once:
+		const __m128d mx_2 = _mm_set1_pd(mx), my_2 = _mm_set1_pd(my), mz_2 = _mm_set1_pd(mz);
+		const __m128d c00_2 = _mm_set1_pd(c00), c01_2 = _mm_set1_pd(2*c01), c02_2 = _mm_set1_pd(2*c02);
+		const __m128d c11_2 = _mm_set1_pd(c11), c12_2 = _mm_set1_pd(2*c12), c22_2 = _mm_set1_pd(c22);
+		const __m128d z_2 = _mm_set1_pd(sensedRange), varR_2 = _mm_set1_pd(varR), half_2 = _mm_set1_pd(-0.5);
+		for (;i+2<=n;i+=2)
+		{
+			const __m128d Ax = _mm_sub_pd(mx_2,_mm_loadu_pd(sx+i));
+			const __m128d Ay = _mm_sub_pd(my_2,_mm_loadu_pd(sy+i));
+			const __m128d Az = _mm_sub_pd(mz_2,_mm_loadu_pd(sz+i));
+			const __m128d r2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(Ax,Ax),_mm_mul_pd(Ay,Ay)),_mm_mul_pd(Az,Az));
+			const __m128d HCHt = _mm_add_pd(
+				_mm_add_pd( _mm_mul_pd(_mm_mul_pd(Ax,Ax),c00_2), _mm_add_pd(_mm_mul_pd(_mm_mul_pd(Ay,Ay),c11_2), _mm_mul_pd(_mm_mul_pd(Az,Az),c22_2)) ),
+				_mm_add_pd( _mm_mul_pd(_mm_mul_pd(Ax,Ay),c01_2), _mm_add_pd(_mm_mul_pd(_mm_mul_pd(Ax,Az),c02_2), _mm_mul_pd(_mm_mul_pd(Ay,Az),c12_2)) ) );
+			const __m128d varZ = _mm_add_pd(_mm_div_pd(HCHt,r2),varR_2);
+			const __m128d err = _mm_sub_pd(z_2,_mm_sqrt_pd(r2));
+			_mm_storeu_pd(out_ll+i, _mm_div_pd(_mm_mul_pd(half_2,_mm_mul_pd(err,err)),varZ) );
+		}
+#endif
+		for (;i<n;i++)
+		{
+			const double Ax = mx-sx[i], Ay = my-sy[i], Az = mz-sz[i];
+			const double r2 = Ax*Ax+Ay*Ay+Az*Az;
+			const double HCHt = (Ax*Ax*c00 + (Ay*Ay*c11 + Az*Az*c22)) + (Ax*Ay*(2*c01) + (Ax*Az*(2*c02) + Ay*Az*(2*c12)));
+			const double varZ = HCHt/r2 + varR;
+			const double err = sensedRange - std::sqrt(r2);
+			out_ll[i] = (-0.5*(err*err))/varZ;
+		}
+	}
+
+	/** Accumulates the log-likelihood of a set of beacon ranges for a block of robot poses */
+	struct TAuxBeaconRangesLikelihood
+	{
+		const TPosesSoA                            &poses;
+		const std::vector<TBeaconRangeToEvaluate>  &ranges;
+		const std::vector<TBeaconFlatModes>        &modes;
+		const double                               varR;
+		std::vector<double>                        &out_log_liks;
+
+		TAuxBeaconRangesLikelihood(const TPosesSoA &poses_, const std::vector<TBeaconRangeToEvaluate> &ranges_, const std::vector<TBeaconFlatModes> &modes_, double varR_, std::vector<double> &out_log_liks_) :
+			poses(poses_), ranges(ranges_), modes(modes_), varR(varR_), out_log_liks(out_log_liks_) { }
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			// Poses are processed in small tiles, so the sensor positions and the log-likelihoods of all
+			//  the modes of a beacon stay in the cache:
+			static const size_t TILE = 128;
+			double sx[TILE], sy[TILE], sz[TILE], ll_max[TILE], sum[TILE];
+			std::vector<double> ll_buf;
+
+			for (size_t i0=first;i0<last;i0+=TILE)
+			{
+				const size_t n = std::min(TILE,last-i0);
+				double *out = &out_log_liks[i0];
+
+				for (size_t k=0;k<ranges.size();k++)
+				{
+					const TBeaconRangeToEvaluate &rng = ranges[k];
+					const TBeaconFlatModes &m = modes[rng.modes_idx];
+					const size_t M = m.size();
+					if (!M) continue;
+
+					// Sensor position for each pose:
+					{
+						const double *x = &poses.x[i0], *y = &poses.y[i0], *z = &poses.z[i0];
+						const double *r00 = &poses.r00[i0], *r01 = &poses.r01[i0], *r02 = &poses.r02[i0];
+						const double *r10 = &poses.r10[i0], *r11 = &poses.r11[i0], *r12 = &poses.r12[i0];
+						const double *r20 = &poses.r20[i0], *r21 = &poses.r21[i0], *r22 = &poses.r22[i0];
+						for (size_t i=0;i<n;i++)
+						{
+							sx[i] = x[i] + r00[i]*rng.lx + r01[i]*rng.ly + r02[i]*rng.lz;
+							sy[i] = y[i] + r10[i]*rng.lx + r11[i]*rng.ly + r12[i]*rng.lz;
+							sz[i] = z[i] + r20[i]*rng.lx + r21[i]*rng.ly + r22[i]*rng.lz;
+						}
+					}
+
+					// Log-likelihood of each mode, for each pose:
+					ll_buf.resize(M*TILE);
+					for (size_t j=0;j<M;j++)
+						beaconRangeLogLiks(m,j,sx,sy,sz,n,rng.sensedRange,varR,&ll_buf[j*TILE]);
+
+					if (M==1)
+					{
+						// A single Gaussian:
+						for (size_t i=0;i<n;i++)
+							out[i] += ll_buf[i];
+						continue;
+					}
+
+					// Several modes: the same numerically-stable average as in math::averageLogLikelihood()
+					for (size_t i=0;i<n;i++)
+						ll_max[i] = ll_buf[i];
+					for (size_t j=1;j<M;j++)
+					{
+						const double *ll = &ll_buf[j*TILE];
+						for (size_t i=0;i<n;i++)
+							ll_max[i] = std::max(ll_max[i], ll[i]);
+					}
+
+					for (size_t i=0;i<n;i++)
+						sum[i] = 0;
+					for (size_t j=0;j<M;j++)
+					{
+						const double lw = m.log_w[j]-m.log_w_max;
+						const double *ll = &ll_buf[j*TILE];
+						for (size_t i=0;i<n;i++)
+							sum[i] += std::exp( lw + ll[i] - ll_max[i] );
+					}
+
+					for (size_t i=0;i<n;i++)
+						out[i] += std::log(sum[i]) - m.log_sum_w + ll_max[i];
+				}
+			}
+		}
+	};
+}
+
+/*---------------------------------------------------------------
+				computeObservationLikelihoodForPoses
+  ---------------------------------------------------------------*/
+void CBeaconMap::internal_computeObservationLikelihoodForPoses(
+	const CObservation	*obs,
+	const std::vector<TPose3D> &takenFrom,
+	std::vector<double> &out_log_liks )
+{
+	MRPT_START
+
+	const size_t N = takenFrom.size();
+	out_log_liks.assign(N, 0);
+
+	if ( CLASS_ID(CObservationBeaconRanges)!=obs->GetRuntimeClass() || !N )
+		return;
+
+	const CObservationBeaconRanges *o = static_cast<const CObservationBeaconRanges*>(obs);
+
+	// Flatten the modes of the observed beacons, which are the same for all the poses:
+	std::vector<TBeaconFlatModes>        modes;
+	std::vector<TBeaconRangeToEvaluate>  ranges;
+	std::map<const CBeacon*,size_t>      modes_idxs;
+	double log_lik_not_found = 0;
+
+	for (deque<CObservationBeaconRanges::TMeasurement>::const_iterator it_obs = o->sensedData.begin();it_obs!=o->sensedData.end();++it_obs)
+	{
+		const CBeacon *beac = getBeaconByID( it_obs->beaconID );
+		if (beac!=NULL &&
+			it_obs->sensedDistance > 0 &&
+			!isNaN(it_obs->sensedDistance))
+		{
+			std::map<const CBeacon*,size_t>::iterator itM = modes_idxs.find(beac);
+			if (itM==modes_idxs.end())
+			{
+				itM = modes_idxs.insert( std::make_pair(beac,modes.size()) ).first;
+				modes.resize(modes.size()+1);
+				modes.back().loadFrom(*beac);
+			}
+
+			TBeaconRangeToEvaluate rng;
+			rng.modes_idx = itM->second;
+			rng.lx = it_obs->sensorLocationOnRobot.x();
+			rng.ly = it_obs->sensorLocationOnRobot.y();
+			rng.lz = it_obs->sensorLocationOnRobot.z();
+			rng.sensedRange = it_obs->sensedDistance;
+			ranges.push_back(rng);
+		}
+		else
+		{
+			// If not found, a uniform distribution:
+			if ( o->maxSensorDistance != o->minSensorDistance )
+				log_lik_not_found += log(1.0/ (o->maxSensorDistance - o->minSensorDistance));
+		}
+	}
+
+	if (log_lik_not_found!=0)
+		for (size_t i=0;i<N;i++)
+			out_log_liks[i] = log_lik_not_found;
+
+	if (ranges.empty())
+		return;
+
+	TPosesSoA poses;
+	poses.loadFrom(takenFrom);
+
+	TAuxBeaconRangesLikelihood evaluator(poses,ranges,modes,square(likelihoodOptions.rangeStd),out_log_liks);
+	mrpt::system::parallelForBlocks(N, evaluator, likelihoodOptions.num_threads);
+
+	for (size_t i=0;i<N;i++)
+		MRPT_CHECK_NORMAL_NUMBER(out_log_liks[i]);
+
+	MRPT_END
+}
+
+namespace
+{
+	/** Fuses a range measurement into an existing beacon, of any PDF type */
+	void fuseBeaconRange(
+		CBeacon *beac,
+		const CPoint3D &sensorPnt,
+		const float sensedRange,
+		const CBeaconMap::TInsertionOptions &insertionOptions,
+		const CBeaconMap::TLikelihoodOptions &likelihoodOptions)
+	{
+		MRPT_START
+
+		switch(beac->m_typePDF)
+		{
+		// ------------------------------
+		// FUSE: PDF is MonteCarlo
+		// ------------------------------
+		case CBeacon::pdfMonteCarlo:
+			{
+				double		maxW = -1e308, sumW=0;
+				// Update weights:
+				// --------------------
+				for (CPointPDFParticles::CParticleList::iterator it=beac->m_locationMC.m_particles.begin();it!=beac->m_locationMC.m_particles.end();++it)
+				{
+					float	expectedRange = sensorPnt.distance3DTo( it->d->x,it->d->y,it->d->z );
+					// Add bias:
+					//expectedRange += float(0.1*(1-exp(-0.16*expectedRange)));
+					it->log_w += -0.5*square((sensedRange-expectedRange)/likelihoodOptions.rangeStd);
+					maxW=max(it->log_w,maxW);
+					sumW+=exp(it->log_w);
+				} // end for it
+
+				// Perform resampling (SIR filter) or not (simply accumulate weights)??
+				// ------------------------------------------------------------------------
+				if (insertionOptions.MC_performResampling)
+				{
+					// Yes, perform an auxiliary PF SIR here:
+					// ---------------------------------------------
+					if (beac->m_locationMC.ESS() < 0.5)
+					{
+						// We must resample:
+						// Make a list with the log weights:
+						vector<double> log_ws;
+						vector<size_t> indxs;
+						beac->m_locationMC.getWeights( log_ws );
+
+						// And compute the resampled indexes:
+						CParticleFilterCapable::computeResampling(
+							CParticleFilter::prSystematic,
+							log_ws,
+							indxs );
+
+						// Replace with the new samples:
+						beac->m_locationMC.performSubstitution( indxs );
+
+						// Determine if this is a 2D beacon map:
+						bool	is2D = (insertionOptions.minElevation_deg==insertionOptions.maxElevation_deg);
+						float	noiseStd = insertionOptions.MC_afterResamplingNoise;
+
+						// AND, add a small noise:
+						CPointPDFParticles::CParticleList::iterator		itSample;
+						for (itSample=beac->m_locationMC.m_particles.begin();itSample!=beac->m_locationMC.m_particles.end();++itSample)
+						{
+							itSample->d->x += randomGenerator.drawGaussian1D( 0,noiseStd );
+							itSample->d->y += randomGenerator.drawGaussian1D( 0,noiseStd );
+							if (!is2D)
+								itSample->d->z += randomGenerator.drawGaussian1D( 0,noiseStd );
+						}
+
+					}
+				} // end "do resample"
+				else
+				{
+					// Do not resample:
+					// ---------------------------------------------
+
+					// Remove very very very unlikely particles:
+					// -------------------------------------------
+					for (CPointPDFParticles::CParticleList::iterator it=beac->m_locationMC.m_particles.begin();it!=beac->m_locationMC.m_particles.end();  )
+					{
+						if ( it->log_w < (maxW-insertionOptions.MC_thresholdNegligible) )
+						{
+							delete it->d; it->d=NULL;
+							it = beac->m_locationMC.m_particles.erase( it );
+						}
+						else ++it;
+					}
+				} // end "do not resample"
+
+				// Normalize weights:
+				//  log_w = log( exp(log_w)/sumW ) ->
+				//  log_w -= log(sumW);
+				// -----------------------------------------
+				sumW=log(sumW);
+				for (CPointPDFParticles::CParticleList::iterator it=beac->m_locationMC.m_particles.begin();it!=beac->m_locationMC.m_particles.end();++it)
+					it->log_w -= sumW;
+
+				// Is the moment to turn into a Gaussian??
+				// -------------------------------------------
+				CPoint3D MEAN;
+				CMatrixDouble33	COV;
+				beac->m_locationMC.getCovarianceAndMean(COV,MEAN);
+
+				double D1 = sqrt(COV(0,0));
+				double D2 = sqrt(COV(1,1));
+				double D3 = sqrt(COV(2,2));
+
+				double mxVar = max3( D1, D2, D3 );
+
+				if (mxVar < insertionOptions.MC_maxStdToGauss )
+				{
+					// Collapse into Gaussian:
+					beac->m_locationMC.clear();		// Erase prev. samples
+
+					// Assure a non-null covariance!
+					CMatrixDouble	COV2 = CMatrixDouble(COV);
+					COV2.setSize(2,2);
+					if (COV2.det()==0)
+					{
+						COV.setIdentity();
+						COV*= square( 0.01f );
+						if (insertionOptions.minElevation_deg == insertionOptions.maxElevation_deg )
+							COV(2,2) = 0;	// We are in a 2D map:
+					}
+
+					beac->m_typePDF = CBeacon::pdfGauss; // Pass to gaussian.
+					beac->m_locationGauss.mean = MEAN;
+					beac->m_locationGauss.cov  = COV;
+				}
+			}
+			break;
+
+		// ------------------------------
+		// FUSE: PDF is Gaussian:
+		// ------------------------------
+		case CBeacon::pdfGauss:
+			{
+				// Compute the mean expected range:
+				float	expectedRange = sensorPnt.distanceTo( beac->m_locationGauss.mean );
+				float	varR = square( likelihoodOptions.rangeStd );
+				//bool	useEKF_or_KF = true;
+
+				//if (useEKF_or_KF)
+				{
+					// EKF method:
+					// ---------------------
+					// Add bias:
+					//expectedRange += float(0.1*(1-exp(-0.16*expectedRange)));
+
+					// An EKF for updating the Gaussian:
+					float	y = sensedRange - expectedRange;
+
+					// Compute the Jacobian H and varZ
+					CMatrixDouble13		H;
+					double varZ;
+					double Ax = (beac->m_locationGauss.mean.x() - sensorPnt.x());
+					double Ay = (beac->m_locationGauss.mean.y() - sensorPnt.y());
+					double Az = (beac->m_locationGauss.mean.z() - sensorPnt.z());
+					H(0,0) = Ax; H(0,1) = Ay; H(0,2) = Az;
+					H *= 1.0/expectedRange; //sqrt(Ax*Ax+Ay*Ay+Az*Az);
+					varZ =  H.multiply_HCHt_scalar(beac->m_locationGauss.cov);
+					varZ += varR;
+
+					CMatrixDouble31		K;
+					K.multiply_ABt( beac->m_locationGauss.cov, H );
+					K *= 1.0/varZ;
+
+					// Update stage of the EKF:
+					beac->m_locationGauss.mean.x_incr( K(0,0) * y );
+					beac->m_locationGauss.mean.y_incr(K(1,0) * y );
+					beac->m_locationGauss.mean.z_incr( K(2,0) * y );
+
+					beac->m_locationGauss.cov = (Eigen::Matrix<double,3,3>::Identity() - K*H) * beac->m_locationGauss.cov;
+					//beac->m_locationGauss.cov.force_symmetry();
+				}
+			}
+			break;
+		// ------------------------------
+		// FUSE: PDF is SOG
+		// ------------------------------
+		case CBeacon::pdfSOG:
+			{
+				// Compute the mean expected range for this mode:
+				float	varR = square( likelihoodOptions.rangeStd );
+
+				// For each Gaussian mode:
+				//  1) Update its weight (using the likelihood of the observation linearized at the mean)
+				//  2) Update its mean/cov (as in the simple EKF)
+				CPointPDFSOG::iterator it;
+				double max_w = -1e9;
+				for (it=beac->m_locationSOG.begin();it!=beac->m_locationSOG.end();++it)
+				{
+					double 	expectedRange = sensorPnt.distanceTo( it->val.mean );
+
+					// An EKF for updating the Gaussian:
+					double y = sensedRange - expectedRange;
+
+					// Compute the Jacobian H and varZ
+					CMatrixDouble13		H;
+					double varZ;
+					double Ax = ( it->val.mean.x() - sensorPnt.x());
+					double Ay = ( it->val.mean.y() - sensorPnt.y());
+					double Az = ( it->val.mean.z() - sensorPnt.z());
+					H(0,0) = Ax; H(0,1) = Ay; H(0,2) = Az;
+					H *= 1.0/expectedRange; //sqrt(Ax*Ax+Ay*Ay+Az*Az);
+					varZ =  H.multiply_HCHt_scalar( it->val.cov );
+					varZ += varR;
+					CMatrixDouble31		K;
+					K.multiply( it->val.cov, H.transpose());
+					K *= 1.0/varZ;
+
+					// Update stage of the EKF:
+					it->val.mean.x_incr( K(0,0) * y );
+					it->val.mean.y_incr( K(1,0) * y );
+					it->val.mean.z_incr( K(2,0) * y );
+
+					it->val.cov = (Eigen::Matrix<double,3,3>::Identity() - K*H) * it->val.cov;
+					//it->val.cov.force_symmetry();
+
+					// Update the weight of this mode:
+					// ----------------------------------
+					it->log_w += -0.5 * square( y ) / varZ;
+
+					max_w = max(max_w,it->log_w);	// keep the maximum mode weight
+				} // end for each mode
+
+				// Remove modes with negligible weights:
+				// -----------------------------------------------------------
+				for (it=beac->m_locationSOG.begin();it!=beac->m_locationSOG.end(); )
+				{
+					if (max_w - it->log_w > insertionOptions.SOG_thresholdNegligible )
+					{
+						// Remove the mode:
+						it = beac->m_locationSOG.erase( it );
+					}
+					else ++it;
+				}
+
+				//printf("ESS: %f\n",beac->m_locationSOG.ESS());
+
+				// Normalize the weights:
+				beac->m_locationSOG.normalizeWeights();
+
+				// Should we pass this beacon to a single Gaussian mode?
+				// -----------------------------------------------------------
+				CPoint3D  curMean;
+				CMatrixDouble33	curCov;
+				beac->m_locationSOG.getCovarianceAndMean(curCov,curMean);
+
+				double D1 = sqrt(curCov(0,0));
+				double D2 = sqrt(curCov(1,1));
+				double D3 = sqrt(curCov(2,2));
+				float maxDiag = max3(D1,D2,D3);
+
+				if (maxDiag<0.10f)
+				{
+					// Yes, transform:
+					beac->m_locationGauss.mean = curMean;
+					beac->m_locationGauss.cov = curCov;
+					beac->m_typePDF = CBeacon::pdfGauss;
+					// Done!
+				}
+			}
+			break;
+		default:
+			THROW_EXCEPTION("Invalid beac->m_typePDF!!!");
+		};
+
+		MRPT_END
+	}
+
+	/** A range measurement to be fused into an existing beacon */
+	struct TBeaconFuseJob
+	{
+		TBeaconFuseJob(CBeacon *beac_, const CPoint3D &sensorPnt_, float sensedRange_) :
+			beac(beac_), sensorPnt(sensorPnt_), sensedRange(sensedRange_) { }
+
+		CBeacon  *beac;
+		CPoint3D sensorPnt;
+		float    sensedRange;
+	};
+
+	/** Fuses the ranges of a block of beacons (the updates of different beacons are independent) */
+	struct TAuxBeaconFuser
+	{
+		const std::vector<TBeaconFuseJob>          &jobs;
+		const std::vector<std::vector<size_t> >    &jobs_per_beacon;
+		const CBeaconMap::TInsertionOptions        &insertionOptions;
+		const CBeaconMap::TLikelihoodOptions       &likelihoodOptions;
+
+		TAuxBeaconFuser(const std::vector<TBeaconFuseJob> &jobs_, const std::vector<std::vector<size_t> > &jobs_per_beacon_,
+			const CBeaconMap::TInsertionOptions &insertionOptions_, const CBeaconMap::TLikelihoodOptions &likelihoodOptions_) :
+			jobs(jobs_), jobs_per_beacon(jobs_per_beacon_), insertionOptions(insertionOptions_), likelihoodOptions(likelihoodOptions_) { }
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			for (size_t b=first;b<last;b++)
+				for (size_t k=0;k<jobs_per_beacon[b].size();k++)
+				{
+					const TBeaconFuseJob &job = jobs[ jobs_per_beacon[b][k] ];
+					fuseBeaconRange(job.beac,job.sensorPnt,job.sensedRange,insertionOptions,likelihoodOptions);
+				}
+		}
+	};
+}
+
 /*---------------------------------------------------------------
 						insertObservation
   ---------------------------------------------------------------*/
@@ -378,6 +995,7 @@ bool  CBeaconMap::internal_insertObservation( const mrpt::obs::CObservation *obs
 		// Here we fuse OR create the beacon position PDF:
 		// --------------------------------------------------------
 		const CObservationBeaconRanges	*o = static_cast<const CObservationBeaconRanges*>(obs);
+		std::vector<TBeaconFuseJob>	fuse_jobs;
 
 		for (deque<CObservationBeaconRanges::TMeasurement>::const_iterator it=o->sensedData.begin();it!=o->sensedData.end();++it)
 		{
@@ -436,271 +1054,43 @@ bool  CBeaconMap::internal_insertObservation( const mrpt::obs::CObservation *obs
 					m_beacons.push_back( newBeac );
 
 				} // end insert
-				else
+				else if (beac->m_typePDF==CBeacon::pdfMonteCarlo)
 				{
 					// ======================================
 					//					FUSE
 					// ======================================
-					switch(beac->m_typePDF)
-					{
-					// ------------------------------
-					// FUSE: PDF is MonteCarlo
-					// ------------------------------
-					case CBeacon::pdfMonteCarlo:
-						{
-							double		maxW = -1e308, sumW=0;
-							// Update weights:
-							// --------------------
-							for (CPointPDFParticles::CParticleList::iterator it=beac->m_locationMC.m_particles.begin();it!=beac->m_locationMC.m_particles.end();++it)
-							{
-								float	expectedRange = sensorPnt.distance3DTo( it->d->x,it->d->y,it->d->z );
-								// Add bias:
-								//expectedRange += float(0.1*(1-exp(-0.16*expectedRange)));
-								it->log_w += -0.5*square((sensedRange-expectedRange)/likelihoodOptions.rangeStd);
-								maxW=max(it->log_w,maxW);
-								sumW+=exp(it->log_w);
-							} // end for it
-
-							// Perform resampling (SIR filter) or not (simply accumulate weights)??
-							// ------------------------------------------------------------------------
-							if (insertionOptions.MC_performResampling)
-							{
-								// Yes, perform an auxiliary PF SIR here:
-								// ---------------------------------------------
-								if (beac->m_locationMC.ESS() < 0.5)
-								{
-									// We must resample:
-									// Make a list with the log weights:
-									vector<double> log_ws;
-									vector<size_t> indxs;
-									beac->m_locationMC.getWeights( log_ws );
-
-									// And compute the resampled indexes:
-									CParticleFilterCapable::computeResampling(
-										CParticleFilter::prSystematic,
-										log_ws,
-										indxs );
-
-									// Replace with the new samples:
-									beac->m_locationMC.performSubstitution( indxs );
-
-									// Determine if this is a 2D beacon map:
-									bool	is2D = (insertionOptions.minElevation_deg==insertionOptions.maxElevation_deg);
-									float	noiseStd = insertionOptions.MC_afterResamplingNoise;
-
-									// AND, add a small noise:
-									CPointPDFParticles::CParticleList::iterator		itSample;
-									for (itSample=beac->m_locationMC.m_particles.begin();itSample!=beac->m_locationMC.m_particles.end();++itSample)
-									{
-										itSample->d->x += randomGenerator.drawGaussian1D( 0,noiseStd );
-										itSample->d->y += randomGenerator.drawGaussian1D( 0,noiseStd );
-										if (!is2D)
-											itSample->d->z += randomGenerator.drawGaussian1D( 0,noiseStd );
-									}
-
-								}
-							} // end "do resample"
-							else
-							{
-								// Do not resample:
-								// ---------------------------------------------
-
-								// Remove very very very unlikely particles:
-								// -------------------------------------------
-								for (CPointPDFParticles::CParticleList::iterator it=beac->m_locationMC.m_particles.begin();it!=beac->m_locationMC.m_particles.end();  )
-								{
-									if ( it->log_w < (maxW-insertionOptions.MC_thresholdNegligible) )
-									{
-										delete it->d; it->d=NULL;
-										it = beac->m_locationMC.m_particles.erase( it );
-									}
-									else ++it;
-								}
-							} // end "do not resample"
-
-							// Normalize weights:
-							//  log_w = log( exp(log_w)/sumW ) ->
-							//  log_w -= log(sumW);
-							// -----------------------------------------
-							sumW=log(sumW);
-							for (CPointPDFParticles::CParticleList::iterator it=beac->m_locationMC.m_particles.begin();it!=beac->m_locationMC.m_particles.end();++it)
-								it->log_w -= sumW;
-
-							// Is the moment to turn into a Gaussian??
-							// -------------------------------------------
-							CPoint3D MEAN;
-							CMatrixDouble33	COV;
-							beac->m_locationMC.getCovarianceAndMean(COV,MEAN);
-
-							double D1 = sqrt(COV(0,0));
-							double D2 = sqrt(COV(1,1));
-							double D3 = sqrt(COV(2,2));
-
-							double mxVar = max3( D1, D2, D3 );
-
-							if (mxVar < insertionOptions.MC_maxStdToGauss )
-							{
-								// Collapse into Gaussian:
-								beac->m_locationMC.clear();		// Erase prev. samples
-
-								// Assure a non-null covariance!
-								CMatrixDouble	COV2 = CMatrixDouble(COV);
-								COV2.setSize(2,2);
-								if (COV2.det()==0)
-								{
-									COV.setIdentity();
-									COV*= square( 0.01f );
-									if (insertionOptions.minElevation_deg == insertionOptions.maxElevation_deg )
-										COV(2,2) = 0;	// We are in a 2D map:
-								}
-
-								beac->m_typePDF = CBeacon::pdfGauss; // Pass to gaussian.
-								beac->m_locationGauss.mean = MEAN;
-								beac->m_locationGauss.cov  = COV;
-							}
-						}
-						break;
-
-					// ------------------------------
-					// FUSE: PDF is Gaussian:
-					// ------------------------------
-					case CBeacon::pdfGauss:
-						{
-							// Compute the mean expected range:
-							float	expectedRange = sensorPnt.distanceTo( beac->m_locationGauss.mean );
-							float	varR = square( likelihoodOptions.rangeStd );
-							//bool	useEKF_or_KF = true;
-
-							//if (useEKF_or_KF)
-							{
-								// EKF method:
-								// ---------------------
-								// Add bias:
-								//expectedRange += float(0.1*(1-exp(-0.16*expectedRange)));
-
-								// An EKF for updating the Gaussian:
-								float	y = sensedRange - expectedRange;
-
-								// Compute the Jacobian H and varZ
-								CMatrixDouble13		H;
-								double varZ;
-								double Ax = (beac->m_locationGauss.mean.x() - sensorPnt.x());
-								double Ay = (beac->m_locationGauss.mean.y() - sensorPnt.y());
-								double Az = (beac->m_locationGauss.mean.z() - sensorPnt.z());
-								H(0,0) = Ax; H(0,1) = Ay; H(0,2) = Az;
-								H *= 1.0/expectedRange; //sqrt(Ax*Ax+Ay*Ay+Az*Az);
-								varZ =  H.multiply_HCHt_scalar(beac->m_locationGauss.cov);
-								varZ += varR;
-
-								CMatrixDouble31		K;
-								K.multiply_ABt( beac->m_locationGauss.cov, H );
-								K *= 1.0/varZ;
-
-								// Update stage of the EKF:
-								beac->m_locationGauss.mean.x_incr( K(0,0) * y );
-								beac->m_locationGauss.mean.y_incr(K(1,0) * y );
-								beac->m_locationGauss.mean.z_incr( K(2,0) * y );
-
-								beac->m_locationGauss.cov = (Eigen::Matrix<double,3,3>::Identity() - K*H) * beac->m_locationGauss.cov;
-								//beac->m_locationGauss.cov.force_symmetry();
-							}
-						}
-						break;
-					// ------------------------------
-					// FUSE: PDF is SOG
-					// ------------------------------
-					case CBeacon::pdfSOG:
-						{
-							// Compute the mean expected range for this mode:
-							float	varR = square( likelihoodOptions.rangeStd );
-
-							// For each Gaussian mode:
-							//  1) Update its weight (using the likelihood of the observation linearized at the mean)
-							//  2) Update its mean/cov (as in the simple EKF)
-							CPointPDFSOG::iterator it;
-							double max_w = -1e9;
-							for (it=beac->m_locationSOG.begin();it!=beac->m_locationSOG.end();++it)
-							{
-								double 	expectedRange = sensorPnt.distanceTo( it->val.mean );
-
-								// An EKF for updating the Gaussian:
-								double y = sensedRange - expectedRange;
-
-								// Compute the Jacobian H and varZ
-								CMatrixDouble13		H;
-								double varZ;
-								double Ax = ( it->val.mean.x() - sensorPnt.x());
-								double Ay = ( it->val.mean.y() - sensorPnt.y());
-								double Az = ( it->val.mean.z() - sensorPnt.z());
-								H(0,0) = Ax; H(0,1) = Ay; H(0,2) = Az;
-								H *= 1.0/expectedRange; //sqrt(Ax*Ax+Ay*Ay+Az*Az);
-								varZ =  H.multiply_HCHt_scalar( it->val.cov );
-								varZ += varR;
-								CMatrixDouble31		K;
-								K.multiply( it->val.cov, H.transpose());
-								K *= 1.0/varZ;
-
-								// Update stage of the EKF:
-								it->val.mean.x_incr( K(0,0) * y );
-								it->val.mean.y_incr( K(1,0) * y );
-								it->val.mean.z_incr( K(2,0) * y );
-
-								it->val.cov = (Eigen::Matrix<double,3,3>::Identity() - K*H) * it->val.cov;
-								//it->val.cov.force_symmetry();
-
-								// Update the weight of this mode:
-								// ----------------------------------
-								it->log_w += -0.5 * square( y ) / varZ;
-
-								max_w = max(max_w,it->log_w);	// keep the maximum mode weight
-							} // end for each mode
-
-							// Remove modes with negligible weights:
-							// -----------------------------------------------------------
-							for (it=beac->m_locationSOG.begin();it!=beac->m_locationSOG.end(); )
-							{
-								if (max_w - it->log_w > insertionOptions.SOG_thresholdNegligible )
-								{
-									// Remove the mode:
-									it = beac->m_locationSOG.erase( it );
-								}
-								else ++it;
-							}
-
-							//printf("ESS: %f\n",beac->m_locationSOG.ESS());
-
-							// Normalize the weights:
-							beac->m_locationSOG.normalizeWeights();
-
-							// Should we pass this beacon to a single Gaussian mode?
-							// -----------------------------------------------------------
-							CPoint3D  curMean;
-							CMatrixDouble33	curCov;
-							beac->m_locationSOG.getCovarianceAndMean(curCov,curMean);
-
-							double D1 = sqrt(curCov(0,0));
-							double D2 = sqrt(curCov(1,1));
-							double D3 = sqrt(curCov(2,2));
-							float maxDiag = max3(D1,D2,D3);
-
-							if (maxDiag<0.10f)
-							{
-								// Yes, transform:
-								beac->m_locationGauss.mean = curMean;
-								beac->m_locationGauss.cov = curCov;
-								beac->m_typePDF = CBeacon::pdfGauss;
-								// Done!
-							}
-						}
-						break;
-					default:
-						THROW_EXCEPTION("Invalid beac->m_typePDF!!!");
-					};
-
+					// Samples are drawn from the random generator: fuse right now, in order.
+					fuseBeaconRange(beac,sensorPnt,sensedRange,insertionOptions,likelihoodOptions);
+				}
+				else
+				{
+					// Gaussian & SOG beacons: fused below, in parallel for different beacons.
+					// (Pointers to the beacons remain valid, since push_back() in a deque does not move its elements)
+					fuse_jobs.push_back( TBeaconFuseJob(beac,sensorPnt,sensedRange) );
 				} // end fuse
 			} // end if range makes sense
 		} // end for each observation
 
+		// Fuse the deferred ranges, grouped by beacon (in the original order for each beacon):
+		if (!fuse_jobs.empty())
+		{
+			std::map<CBeacon*,size_t> beacon_idxs;
+			std::vector<std::vector<size_t> > jobs_per_beacon;
+			for (size_t i=0;i<fuse_jobs.size();i++)
+			{
+				std::map<CBeacon*,size_t>::iterator itB = beacon_idxs.find(fuse_jobs[i].beac);
+				if (itB==beacon_idxs.end())
+				{
+					itB = beacon_idxs.insert( std::make_pair(fuse_jobs[i].beac,jobs_per_beacon.size()) ).first;
+					jobs_per_beacon.resize(jobs_per_beacon.size()+1);
+				}
+				jobs_per_beacon[itB->second].push_back(i);
+			}
+
+			TAuxBeaconFuser fuser(fuse_jobs,jobs_per_beacon,insertionOptions,likelihoodOptions);
+			mrpt::system::parallelForBlocks(jobs_per_beacon.size(), fuser, insertionOptions.num_threads);
+		}
+
 		// DONE!!
 		// Observation was successfully inserted into the map
 		return true;
@@ -890,7 +1280,8 @@ bool  CBeaconMap::saveToMATLABScript3D(
 					TLikelihoodOptions
   ---------------------------------------------------------------*/
 CBeaconMap::TLikelihoodOptions::TLikelihoodOptions() :
-	rangeStd			(0.08f )
+	rangeStd			(0.08f ),
+	num_threads			(1)
 {
 }
 
@@ -902,6 +1293,7 @@ void  CBeaconMap::TLikelihoodOptions::dumpToTextStream(mrpt::utils::CStream	&out
 	out.printf("\n----------- [CBeaconMap::TLikelihoodOptions] ------------ \n\n");
 
 	out.printf("rangeStd                                = %f\n",rangeStd);
+	out.printf("num_threads                             = %u\n",num_threads);
 
 	out.printf("\n");
 }
@@ -914,6 +1306,7 @@ void  CBeaconMap::TLikelihoodOptions::loadFromConfigFile(
 	const string &section)
 {
 	rangeStd					= iniFile.read_float(section.c_str(),"rangeStd",rangeStd);
+	MRPT_LOAD_CONFIG_VAR(num_threads,uint64_t,	iniFile,section.c_str());
 }
 
 /*---------------------------------------------------------------
@@ -930,7 +1323,8 @@ CBeaconMap::TInsertionOptions::TInsertionOptions() :
 	MC_afterResamplingNoise ( 0.01f ),
 	SOG_thresholdNegligible ( 20.0f ),
 	SOG_maxDistBetweenGaussians ( 1.0f ),
-	SOG_separationConstant ( 3.0f )
+	SOG_separationConstant ( 3.0f ),
+	num_threads ( 1 )
 {
 }
 
@@ -952,6 +1346,7 @@ void  CBeaconMap::TInsertionOptions::dumpToTextStream(mrpt::utils::CStream	&out)
 	out.printf("SOG_thresholdNegligible                 = %.03f\n",SOG_thresholdNegligible);
 	out.printf("SOG_maxDistBetweenGaussians             = %.03f\n",SOG_maxDistBetweenGaussians);
 	out.printf("SOG_separationConstant                  = %.03f\n",SOG_separationConstant);
+	out.printf("num_threads                             = %u\n",num_threads);
 
 
 	out.printf("\n");
@@ -975,6 +1370,7 @@ void  CBeaconMap::TInsertionOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(SOG_thresholdNegligible,float,			iniFile,section.c_str());
 	MRPT_LOAD_CONFIG_VAR(SOG_maxDistBetweenGaussians,float,		iniFile,section.c_str());
 	MRPT_LOAD_CONFIG_VAR(SOG_separationConstant,float,			iniFile,section.c_str());
+	MRPT_LOAD_CONFIG_VAR(num_threads,uint64_t,					iniFile,section.c_str());
 
 }
 
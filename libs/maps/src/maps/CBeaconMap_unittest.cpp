@@ -0,0 +1,144 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/maps/CBeaconMap.h>
+#include <mrpt/obs/CObservationBeaconRanges.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::utils;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::random;
+using namespace std;
+
+namespace
+{
+	const size_t nBeacons = 6;
+	const double beacons_xyz[nBeacons][3] = { {2,3,0},{-4,1,0},{0,-5,0},{6,-2,0},{-3,-3,0},{5,5,0} };
+
+	// Ranges from a robot pose to all the beacons, plus a reading of an unknown beacon:
+	void simulate_ranges(const CPose3D &robotPose, const CPoint3D &sensorOnRobot, CObservationBeaconRanges &obs)
+	{
+		obs.sensedData.clear();
+		obs.minSensorDistance = 0;
+		obs.maxSensorDistance = 20;
+		const CPoint3D sensor = robotPose + sensorOnRobot;
+		for (size_t i=0;i<=nBeacons;i++)
+		{
+			CObservationBeaconRanges::TMeasurement m;
+			m.sensorLocationOnRobot = sensorOnRobot;
+			m.beaconID = i;
+			m.sensedDistance = i<nBeacons ?
+				sensor.distance3DTo(beacons_xyz[i][0],beacons_xyz[i][1],beacons_xyz[i][2]) + randomGenerator.drawGaussian1D(0,0.05)
+				: 3.0f;
+			obs.sensedData.push_back(m);
+		}
+	}
+
+	// Builds a map from a few observations: beacons are left in the MonteCarlo or SOG
+	// representations, and a Gaussian beacon is added at the end.
+	void build_map(CBeaconMap &map, bool insertAsMonteCarlo)
+	{
+		randomGenerator.randomize(123);
+		map.insertionOptions.insertAsMonteCarlo = insertAsMonteCarlo;
+		map.insertionOptions.MC_numSamplesPerMeter = 50;
+
+		const CPoint3D sensorOnRobot(0.1,0.05,0.3);
+		CObservationBeaconRanges obs;
+		simulate_ranges(CPose3D(0,0,0), sensorOnRobot, obs);
+		obs.sensedData.pop_back();  // Do not insert the unknown beacon
+		map.insertObservation(&obs);
+		simulate_ranges(CPose3D(1.0,0.5,0,DEG2RAD(20),0,0), sensorOnRobot, obs);
+		obs.sensedData.pop_back();
+		map.insertObservation(&obs);
+
+		CBeacon gauss;
+		gauss.m_ID = 100;
+		gauss.m_typePDF = CBeacon::pdfGauss;
+		gauss.m_locationGauss.mean = CPoint3D(1,-1,0.5);
+		gauss.m_locationGauss.cov.setIdentity();
+		gauss.m_locationGauss.cov *= 0.04;
+		gauss.m_locationGauss.cov(0,1) = gauss.m_locationGauss.cov(1,0) = 0.01;
+		map.push_back(gauss);
+	}
+
+	void test_likelihood_for_poses(bool insertAsMonteCarlo)
+	{
+		CBeaconMap map;
+		build_map(map, insertAsMonteCarlo);
+
+		CObservationBeaconRanges obs;
+		simulate_ranges(CPose3D(0.5,0.2,0), CPoint3D(0.1,0.05,0.3), obs);
+		CObservationBeaconRanges::TMeasurement m = obs.sensedData[0];
+		m.beaconID = 100;
+		m.sensedDistance = 1.5;
+		obs.sensedData.push_back(m);
+
+		vector<TPose3D> poses(300);
+		for (size_t i=0;i<poses.size();i++)
+			poses[i] = TPose3D(
+				randomGenerator.drawUniform(-1,2), randomGenerator.drawUniform(-1,1), randomGenerator.drawUniform(-0.1,0.1),
+				randomGenerator.drawUniform(-M_PI,M_PI), randomGenerator.drawUniform(-0.1,0.1), randomGenerator.drawUniform(-0.1,0.1) );
+
+		for (unsigned int num_threads=1;num_threads<=3;num_threads+=2)
+		{
+			map.likelihoodOptions.num_threads = num_threads;
+			vector<double> log_liks;
+			map.computeObservationLikelihoodForPoses(&obs, poses, log_liks);
+			ASSERT_EQ(log_liks.size(), poses.size());
+
+			for (size_t i=0;i<poses.size();i++)
+			{
+				const double log_lik = map.computeObservationLikelihood(&obs, CPose3D(poses[i]));
+				// (The one-by-one method uses single precision in some steps)
+				EXPECT_NEAR(log_liks[i], log_lik, 1e-4*(1+std::abs(log_lik))) << "i=" << i << " num_threads=" << num_threads;
+			}
+		}
+	}
+}
+
+TEST(CBeaconMap, LikelihoodForPosesMonteCarlo)
+{
+	test_likelihood_for_poses(true);
+}
+
+TEST(CBeaconMap, LikelihoodForPosesSOG)
+{
+	test_likelihood_for_poses(false);
+}
+
+TEST(CBeaconMap, InsertionWithThreads)
+{
+	for (int MC=0;MC<=1;MC++)
+	{
+		CBeaconMap map1, map4;
+		map4.insertionOptions.num_threads = 4;
+		build_map(map1, MC!=0);
+		build_map(map4, MC!=0);
+
+		ASSERT_EQ(map1.size(), nBeacons+1);
+		ASSERT_EQ(map4.size(), map1.size());
+		for (size_t i=0;i<map1.size();i++)
+		{
+			EXPECT_EQ(map1[i].m_ID, map4[i].m_ID);
+			EXPECT_EQ(map1[i].m_typePDF, map4[i].m_typePDF);
+			CPointPDFGaussian g1, g4;
+			map1[i].getCovarianceAndMean(g1.cov, g1.mean);
+			map4[i].getCovarianceAndMean(g4.cov, g4.mean);
+			EXPECT_EQ(g1.mean.x(), g4.mean.x());
+			EXPECT_EQ(g1.mean.y(), g4.mean.y());
+			EXPECT_EQ(g1.mean.z(), g4.mean.z());
+			EXPECT_EQ((g1.cov-g4.cov).array().abs().maxCoeff(), 0);
+		}
+	}
+}
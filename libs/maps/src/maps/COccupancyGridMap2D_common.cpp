@@ -195,7 +195,7 @@ void  COccupancyGridMap2D::setSize(
 #endif
 
     // Cells memory:
-    map.resize(size_x*size_y,p2l(default_value));
+    map.resize(size_x,size_y,p2l(default_value));
 
 	// Free these buffers also:
 	m_basis_map.clear();
@@ -212,7 +212,6 @@ void  COccupancyGridMap2D::setSize(
 void  COccupancyGridMap2D::resizeGrid(float new_x_min,float new_x_max,float new_y_min,float new_y_max,float new_cells_default_value, bool additionalMargin) MRPT_NO_THROWS
 {
 	unsigned int			extra_x_izq=0,extra_y_arr=0,new_size_x=0,new_size_y=0;
-	std::vector<cellType>	new_map;
 
 	if( new_x_min > new_x_max )
 	{
@@ -264,6 +263,21 @@ void  COccupancyGridMap2D::resizeGrid(float new_x_min,float new_x_max,float new_
 	extra_x_izq = round((x_min-new_x_min) / resolution);
 	extra_y_arr = round((y_min-new_y_min) / resolution);
 
+	// Grow left/top by whole tiles, so the existing tiles are kept as they are (see CCopyOnWriteTiledGrid):
+	const unsigned int TILE_MASK = static_cast<unsigned int>(mrpt::utils::CCopyOnWriteTiledGrid<cellType>::TILE_MASK);
+	if (extra_x_izq & TILE_MASK)
+	{
+		const unsigned int incr = TILE_MASK+1 - (extra_x_izq & TILE_MASK);
+		extra_x_izq += incr;
+		new_x_min -= incr*resolution;
+	}
+	if (extra_y_arr & TILE_MASK)
+	{
+		const unsigned int incr = TILE_MASK+1 - (extra_y_arr & TILE_MASK);
+		extra_y_arr += incr;
+		new_y_min -= incr*resolution;
+	}
+
 	new_size_x = round((new_x_max-new_x_min) / resolution);
 	new_size_y = round((new_y_max-new_y_min) / resolution);
 
@@ -282,26 +296,8 @@ void  COccupancyGridMap2D::resizeGrid(float new_x_min,float new_x_max,float new_
 	assert(0==(new_size_x % 16));
 #endif
 
-	// Reserve new mem block
-	new_map.resize(new_size_x*new_size_y, p2l(new_cells_default_value));
-
-	// Copy all the old map rows into the new map:
-	{
-		cellType  	*dest_ptr = &new_map[extra_x_izq + extra_y_arr*new_size_x];
-		cellType  	*src_ptr  = &map[0];
-		size_t 		row_size = size_x*sizeof(cellType);
-
-		for (size_t y = 0;y<size_y;y++)
-		{
-#if defined(_DEBUG) || (MRPT_ALWAYS_CHECKS_DEBUG)
-			assert( dest_ptr+row_size-1 <= &new_map[new_map.size()-1] );
-			assert( src_ptr+row_size-1 <= &map[map.size()-1] );
-#endif
-			memcpy( dest_ptr, src_ptr, row_size );
-			dest_ptr += new_size_x;
-			src_ptr  += size_x;
-		}
-	}
+	// Move the old cells into the new grid (this only copies the pointers to the tiles):
+	map.resize(new_size_x,new_size_y, extra_x_izq,extra_y_arr, p2l(new_cells_default_value));
 
 	// Move new values into the new map:
 	x_min = new_x_min;
@@ -312,9 +308,6 @@ void  COccupancyGridMap2D::resizeGrid(float new_x_min,float new_x_max,float new_
 	size_x = new_size_x;
 	size_y = new_size_y;
 
-	// Free old map, replace by new one:
-	map.swap( new_map );
-
 	// Free the other buffers:
 	m_basis_map.clear();
 	m_voronoi_diagram.clear();
@@ -388,15 +381,29 @@ void  COccupancyGridMap2D::computeEntropy( TEntropyInfo &info ) const
 
 	info.H = info.I = 0;
 	info.effectiveMappedCells = 0;
-	for ( std::vector<cellType>::const_iterator it=map.begin();it!=map.end();++it)
+	const size_t TILE_SIZE = mrpt::utils::CCopyOnWriteTiledGrid<cellType>::TILE_SIZE;
+	for (size_t ty=0;ty<map.getTilesCountY();ty++)
 	{
-		cellTypeUnsigned  i = static_cast<cellTypeUnsigned>(*it);
-		h = entropyTable[ i ];
-		info.H+= h;
-		if (h<(MAX_H-0.001f))
+		for (size_t tx=0;tx<map.getTilesCountX();tx++)
 		{
-			info.effectiveMappedCells++;
-			info.I-=h;
+			const cellType *tile = map.getTile(tx,ty);
+			const size_t nx = std::min<size_t>(TILE_SIZE, size_x-tx*TILE_SIZE);
+			const size_t ny = std::min<size_t>(TILE_SIZE, size_y-ty*TILE_SIZE);
+			for (size_t y=0;y<ny;y++)
+			{
+				const cellType *row = tile + y*TILE_SIZE;
+				for (size_t x=0;x<nx;x++)
+				{
+					cellTypeUnsigned  i = static_cast<cellTypeUnsigned>(row[x]);
+					h = entropyTable[ i ];
+					info.H+= h;
+					if (h<(MAX_H-0.001f))
+					{
+						info.effectiveMappedCells++;
+						info.I-=h;
+					}
+				}
+			}
 		}
 	}
 
@@ -445,9 +452,7 @@ void  COccupancyGridMap2D::internal_clear()
  ---------------------------------------------------------------*/
 void  COccupancyGridMap2D::fill(float default_value)
 {
-	cellType		defValue = p2l( default_value );
-	for (std::vector<cellType>::iterator	it=map.begin();it<map.end();++it)
-		*it = defValue;
+	map.fill( p2l( default_value ) );
 	// For the precomputed likelihood trick:
 	precomputedLikelihoodToBeRecomputed = true;
 	//resetFeaturesCache();
@@ -462,19 +467,19 @@ void  COccupancyGridMap2D::updateCell(int x,int y, float v)
 	if (static_cast<unsigned int>(x)>=size_x || static_cast<unsigned int>(y)>=size_y)
 		return;
 
-	// Get the current contents of the cell:
-	cellType	&theCell = map[x+y*size_x];
-
 	// Compute the new Bayesian-fused value of the cell:
 	if ( updateInfoChangeOnly.enabled )
 	{
-		float	old	= l2p(theCell);
+		float	old	= l2p(map(x,y));
 		float		new_v	= 1 / ( 1 + (1-v)*(1-old)/(old*v) );
 		updateInfoChangeOnly.cellsUpdated++;
 		updateInfoChangeOnly.I_change+= 1-(H(new_v)+H(1-new_v))/MAX_H;
 	}
 	else
 	{
+		// Get the current contents of the cell:
+		cellType	&theCell = map.cellForWrite(x,y);
+
 		cellType obs = p2l(v);  // The observation: will be >0 for free, <0 for occupied.
 		if (obs>0)
 		{
@@ -526,7 +531,9 @@ void  COccupancyGridMap2D::subSample( int downRatio )
 
 
 	setSize(x_min,x_max,y_min,y_max,resolution);
-	map = newMap;
+	ASSERT_(static_cast<int>(size_x)==newSizeX && static_cast<int>(size_y)==newSizeY)
+	for (int y=0;y<newSizeY;y++)
+		map.setRow(y,&newMap[y*newSizeX]);
 
 
 }
@@ -646,7 +653,7 @@ void COccupancyGridMap2D::determineMatching2D(
 			for (int cy=cy_min;cy<=cy_max;cy++)
 			{
 				// Is an occupied cell?
-				if ( map[cx+cy*size_x] < thresholdCellValue )//  getCell(cx,cy)<0.49)
+				if ( map(cx,cy) < thresholdCellValue )//  getCell(cx,cy)<0.49)
 				{
 					const float residual_x = idx2x(cx)- x_local;
 					const float residual_y = idx2y(cy)- y_local;
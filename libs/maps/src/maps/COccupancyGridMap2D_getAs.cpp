@@ -39,10 +39,12 @@ void  COccupancyGridMap2D::getAsImage(
 		if (!forceRGB)
 		{	// 8bit gray-scale
 			img.resize(size_x,size_y,1,true); //verticalFlip);
-			const cellType	*srcPtr = &map[0];
+			std::vector<cellType> row(size_x);
 			unsigned char	*destPtr;
 			for (unsigned int y=0;y<size_y;y++)
 			{
+				map.getRow(y,&row[0]);
+				const cellType *srcPtr = &row[0];
 				if (!verticalFlip)
 						destPtr = img(0,size_y-1-y);
 				else 	destPtr = img(0,y);
@@ -55,10 +57,12 @@ void  COccupancyGridMap2D::getAsImage(
 		else
 		{	// 24bit RGB:
 			img.resize(size_x,size_y,3,true); //verticalFlip);
-			const cellType	*srcPtr = &map[0];
+			std::vector<cellType> row(size_x);
 			unsigned char	*destPtr;
 			for (unsigned int y=0;y<size_y;y++)
 			{
+				map.getRow(y,&row[0]);
+				const cellType *srcPtr = &row[0];
 				if (!verticalFlip)
 						destPtr = img(0,size_y-1-y);
 				else 	destPtr = img(0,y);
@@ -78,10 +82,12 @@ void  COccupancyGridMap2D::getAsImage(
 		if (!forceRGB)
 		{	// 8bit gray-scale
 			img.resize(size_x,size_y,1,true); //verticalFlip);
-			const cellType	*srcPtr = &map[0];
+			std::vector<cellType> row(size_x);
 			unsigned char	*destPtr;
 			for (unsigned int y=0;y<size_y;y++)
 			{
+				map.getRow(y,&row[0]);
+				const cellType *srcPtr = &row[0];
 				if (!verticalFlip)
 						destPtr = img(0,size_y-1-y);
 				else 	destPtr = img(0,y);
@@ -100,10 +106,12 @@ void  COccupancyGridMap2D::getAsImage(
 		else
 		{	// 24bit RGB:
 			img.resize(size_x,size_y,3,true); //verticalFlip);
-			const cellType	*srcPtr = &map[0];
+			std::vector<cellType> row(size_x);
 			unsigned char	*destPtr;
 			for (unsigned int y=0;y<size_y;y++)
 			{
+				map.getRow(y,&row[0]);
+				const cellType *srcPtr = &row[0];
 				if (!verticalFlip)
 						destPtr = img(0,size_y-1-y);
 				else 	destPtr = img(0,y);
@@ -169,10 +177,12 @@ void  COccupancyGridMap2D::getAs3DObject(mrpt::opengl::CSetOfObjectsPtr	&outSetO
 	CImage			imgTrans(size_x,size_y,1);
 
 
-	const cellType		*srcPtr = &map[0];
+	std::vector<cellType> row(size_x);
 	
 	for (unsigned int y=0;y<size_y;y++)
 	{
+		map.getRow(y,&row[0]);
+		const cellType *srcPtr = &row[0];
 		unsigned char *destPtr_color = imgColor(0,y);
 		unsigned char *destPtr_trans = imgTrans(0,y);
 		for (unsigned int x=0;x<size_x;x++)
@@ -219,9 +219,8 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 				// -----------------------
 				resizeGrid(new_x_min,new_x_max, new_y_min,new_y_max,0.5);
 
-				// For updateCell_fast methods:
-				cellType  *theMapArray = &map[0];
-				unsigned  theMapSize_x = size_x;
+				// Write access to the cells, duplicating the tiles shared with other copies of this map as needed:
+				mrpt::utils::CCopyOnWriteTiledGrid<cellType>::TWriteCursor cells(map);
 
 				int  cx0 = x2idx(px);		// Remember: This must be after the resizeGrid!!
 				int  cy0 = y2idx(py);
@@ -268,7 +267,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 
 					for (int nStep = 0;nStep<nStepsRay;nStep++)
 					{
-						updateCell_fast_free(cx,cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+						updateCell_fast_free(&cells(cx,cy), logodd_observation, logodd_thres_free );
 
 						frCX += frAcx;
 						frCY += frAcy;
@@ -282,7 +281,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 					//  - It was a valid ray, and
 					//  - The ray was not truncated
 					if ( o->validRange[idx] && o->scan[idx]<maxDistanceInsertion )
-						updateCell_fast_occupied(trg_cx,trg_cy, logodd_observation_occupied, logodd_thres_occupied, theMapArray, theMapSize_x );
+						updateCell_fast_occupied(&cells(trg_cx,trg_cy), logodd_observation_occupied, logodd_thres_occupied );
 
 				}  // End of each range
 
@@ -371,9 +370,8 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 				// -----------------------
 				resizeGrid(new_x_min,new_x_max, new_y_min,new_y_max,0.5);
 
-				// For updateCell_fast methods:
-				cellType  *theMapArray = &map[0];
-				unsigned  theMapSize_x = size_x;
+				// Write access to the cells, duplicating the tiles shared with other copies of this map as needed:
+				mrpt::utils::CCopyOnWriteTiledGrid<cellType>::TWriteCursor cells(map);
 
 				//int  cx0 = x2idx(px);		// Remember: This must be after the resizeGrid!!
 				//int  cy0 = y2idx(py);
@@ -461,7 +459,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 						int max_cx = max3(P0.cx,P1.cx,P2.cx);
 
 						for (int ccx=min_cx;ccx<=max_cx;ccx++)
-							updateCell_fast_free(ccx,P0.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+							updateCell_fast_free(&cells(ccx,P0.cy), logodd_observation, logodd_thres_free );
 					}
 					else
 					{
@@ -533,7 +531,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 							//	last_insert_cx = R1.cx;
 
 								for (int ccx=R1.cx;ccx<=R2.cx;ccx++)
-									updateCell_fast_free(ccx,R1.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+									updateCell_fast_free(&cells(ccx,R1.cy), logodd_observation, logodd_thres_free );
 							}
 
 							R1.frX += frAx_R1;    R1.frY += frAy_R1;
@@ -604,7 +602,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 							//	last_insert_cx = R1.cx;
 								last_insert_cy = R1.cy;
 								for (int ccx=R1.cx;ccx<=R2.cx;ccx++)
-									updateCell_fast_free(ccx,R1.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+									updateCell_fast_free(&cells(ccx,R1.cy), logodd_observation, logodd_thres_free );
 							}
 
 							R1.frX += frAx_R1;    R1.frY += frAy_R1;
@@ -645,7 +643,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 						// Special case: Only one cell:
 						if (P2.cx==P1.cx && P2.cy==P1.cy)
 						{
-							updateCell_fast_occupied(P1.cx,P1.cy, logodd_observation_occupied, logodd_thres_occupied, theMapArray, theMapSize_x );
+							updateCell_fast_occupied(&cells(P1.cx,P1.cy), logodd_observation_occupied, logodd_thres_occupied );
 						}
 						else
 						{
@@ -667,7 +665,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 
 							for (int nStep=0;nStep<=nSteps;nStep++)
 							{
-								updateCell_fast_occupied(R1.cx,R1.cy, logodd_observation_occupied, logodd_thres_occupied, theMapArray, theMapSize_x );
+								updateCell_fast_occupied(&cells(R1.cx,R1.cy), logodd_observation_occupied, logodd_thres_occupied );
 
 								R1.frX += frAcxE;
 								R1.frY += frAcyE;
@@ -825,9 +823,8 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 			// -----------------------
 			resizeGrid(new_x_min,new_x_max, new_y_min,new_y_max,0.5);
 
-			// For updateCell_fast methods:
-			cellType  *theMapArray = &map[0];
-			unsigned  theMapSize_x = size_x;
+			// Write access to the cells, duplicating the tiles shared with other copies of this map as needed:
+			mrpt::utils::CCopyOnWriteTiledGrid<cellType>::TWriteCursor cells(map);
 
 			//int  cx0 = x2idx(px);		// Remember: This must be after the resizeGrid!!
 			//int  cy0 = y2idx(py);
@@ -907,7 +904,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 					int max_cx = max3(P0.cx,P1.cx,P2.cx);
 
 					for (int ccx=min_cx;ccx<=max_cx;ccx++)
-						updateCell_fast_free(ccx,P0.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+						updateCell_fast_free(&cells(ccx,P0.cy), logodd_observation, logodd_thres_free );
 				}
 				else
 				{
@@ -978,7 +975,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 						//	last_insert_cx = R1.cx;
 
 							for (int ccx=R1.cx;ccx<=R2.cx;ccx++)
-								updateCell_fast_free(ccx,R1.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+								updateCell_fast_free(&cells(ccx,R1.cy), logodd_observation, logodd_thres_free );
 						}
 
 						R1.frX += frAx_R1;    R1.frY += frAy_R1;
@@ -1048,7 +1045,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 						//	last_insert_cx = R1.cx;
 							last_insert_cy = R1.cy;
 							for (int ccx=R1.cx;ccx<=R2.cx;ccx++)
-								updateCell_fast_free(ccx,R1.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+								updateCell_fast_free(&cells(ccx,R1.cy), logodd_observation, logodd_thres_free );
 						}
 
 						R1.frX += frAx_R1;    R1.frY += frAy_R1;
@@ -1089,7 +1086,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 					// Special case: Only one cell:
 					if (P2.cx==P1.cx && P2.cy==P1.cy)
 					{
-						updateCell_fast_occupied(P1.cx,P1.cy, logodd_observation_occupied, logodd_thres_occupied, theMapArray, theMapSize_x );
+						updateCell_fast_occupied(&cells(P1.cx,P1.cy), logodd_observation_occupied, logodd_thres_occupied );
 					}
 					else
 					{
@@ -1111,7 +1108,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 
 						for (int nStep=0;nStep<=nSteps;nStep++)
 						{
-							updateCell_fast_occupied(R1.cx,R1.cy, logodd_observation_occupied, logodd_thres_occupied, theMapArray, theMapSize_x );
+							updateCell_fast_occupied(&cells(R1.cx,R1.cy), logodd_observation_occupied, logodd_thres_occupied );
 
 							R1.frX += frAcxE;
 							R1.frY += frAcyE;
@@ -69,11 +69,17 @@ void  COccupancyGridMap2D::writeToStream(mrpt::utils::CStream &out, int *version
 		out << size_x << size_y << x_min << x_max << y_min << y_max << resolution;
 		ASSERT_(size_x*size_y==map.size());
 
+		// Row by row, as a contiguous array:
+		std::vector<cellType> row(size_x);
+		for (uint32_t y=0;y<size_y;y++)
+		{
+			map.getRow(y,&row[0]);
 #ifdef OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS
-		out.WriteBuffer(&map[0], sizeof(map[0])*size_x*size_y);
+			out.WriteBuffer(&row[0], sizeof(row[0])*size_x);
 #else
-		out.WriteBufferFixEndianness(&map[0], size_x*size_y);
+			out.WriteBufferFixEndianness(&row[0], size_x);
 #endif
+		}
 
 		// insertionOptions:
 		out <<	insertionOptions.mapAltitude
@@ -158,14 +164,15 @@ void  COccupancyGridMap2D::readFromStream(mrpt::utils::CStream &in, int version)
 			setSize(new_x_min,new_x_max,new_y_min,new_y_max,new_resolution,0.5);
 
 			ASSERT_(size_x*size_y==map.size());
+			std::vector<cellType> cells(map.size()); // Row by row
 
 			if (bitsPerCellStream==MyBitsPerCell)
 			{
 				// Perfect:
 			#ifdef OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS
-				in.ReadBuffer(&map[0], sizeof(map[0])*map.size());
+				in.ReadBuffer(&cells[0], sizeof(cells[0])*cells.size());
 			#else
-				in.ReadBufferFixEndianness(&map[0], map.size());
+				in.ReadBufferFixEndianness(&cells[0], cells.size());
 			#endif
 			}
 			else
@@ -174,22 +181,22 @@ void  COccupancyGridMap2D::readFromStream(mrpt::utils::CStream &in, int version)
 #			ifdef OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS
 				// We are 8-bit, stream is 16-bit
 				ASSERT_(bitsPerCellStream==16);
-				std::vector<uint16_t>    auxMap( map.size() );
+				std::vector<uint16_t>    auxMap( cells.size() );
 				in.ReadBuffer(&auxMap[0], sizeof(auxMap[0])*auxMap.size());
 
-				size_t  i, N = map.size();
-				uint8_t         *ptrTrg = (uint8_t*)&map[0];
+				size_t  i, N = cells.size();
+				uint8_t         *ptrTrg = (uint8_t*)&cells[0];
 				const uint16_t  *ptrSrc = (const uint16_t*)&auxMap[0];
 				for (i=0;i<N;i++)
 					*ptrTrg++ = (*ptrSrc++) >> 8;
 #			else
 				// We are 16-bit, stream is 8-bit
 				ASSERT_(bitsPerCellStream==8);
-				std::vector<uint8_t>    auxMap( map.size() );
+				std::vector<uint8_t>    auxMap( cells.size() );
 				in.ReadBuffer(&auxMap[0], sizeof(auxMap[0])*auxMap.size());
 
-				size_t  i, N = map.size();
-				uint16_t       *ptrTrg = (uint16_t*)&map[0];
+				size_t  i, N = cells.size();
+				uint16_t       *ptrTrg = (uint16_t*)&cells[0];
 				const uint8_t  *ptrSrc = (const uint8_t*)&auxMap[0];
 				for (i=0;i<N;i++)
 					*ptrTrg++ = (*ptrSrc++) << 8;
@@ -199,8 +206,8 @@ void  COccupancyGridMap2D::readFromStream(mrpt::utils::CStream &in, int version)
 			// If we are converting an old dump, convert from probabilities to log-odds:
 			if (version<3)
 			{
-				size_t  i, N = map.size();
-				cellType  *ptr = &map[0];
+				size_t  i, N = cells.size();
+				cellType  *ptr = &cells[0];
 				for (i=0;i<N;i++)
 				{
 					double p = cellTypeUnsigned(*ptr) * (1.0f/0xFF);
@@ -212,6 +219,9 @@ void  COccupancyGridMap2D::readFromStream(mrpt::utils::CStream &in, int version)
 				}
 			}
 
+			for (uint32_t y=0;y<size_y;y++)
+				map.setRow(y,&cells[y*size_x]);
+
 			// For the precomputed likelihood trick:
 			precomputedLikelihoodToBeRecomputed = true;
 
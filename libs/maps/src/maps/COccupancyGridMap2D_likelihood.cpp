@@ -553,7 +553,7 @@ double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm,
         if (precomputedLikelihoodToBeRecomputed)
         {
 			if (!map.empty())
-					precomputedLikelihood.assign( map.size(),LIK_LF_CACHE_INVALID);
+					precomputedLikelihood.resize( size_x,size_y,LIK_LF_CACHE_INVALID);
 			else	precomputedLikelihood.clear();
 
 			precomputedLikelihoodToBeRecomputed = false;
@@ -613,7 +613,7 @@ double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm,
 			// We are into the map limits:
             if (likelihoodOptions.enableLikelihoodCache)
             {
-                thisLik = precomputedLikelihood[ cx+cy*size_x ];
+                thisLik = precomputedLikelihood(cx,cy);
             }
 
 			if (!likelihoodOptions.enableLikelihoodCache || thisLik==LIK_LF_CACHE_INVALID )
@@ -628,8 +628,7 @@ double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm,
 
 				// Optimized code: this part will be invoked a *lot* of times:
 				{
-					cellType  *mapPtr  = &map[xx1+yy1*size_x]; // Initial pointer position
-					unsigned   incrAfterRow = size_x - ((xx2-xx1)+1);
+					const int TILE_MASK = static_cast<int>(mrpt::utils::CCopyOnWriteTiledGrid<cellType>::TILE_MASK);
 
 					signed int Ax0 = 10*(xx1-cx);
 					signed int Ay  = 10*(yy1-cy);
@@ -642,17 +641,21 @@ double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm,
 						signed short Ax=Ax0;
 						cellType  cell;
 
-						for (int xx=xx1;xx<=xx2;xx++)
+						for (int xx=xx1;xx<=xx2;)
 						{
-							if ( (cell =*mapPtr++) < thresholdCellValue )
+							// Cells are contiguous up to the end of each tile:
+							const cellType *mapPtr = &map(xx,yy);
+							const int xx_end = std::min(xx2, xx | TILE_MASK);
+							for (;xx<=xx_end;xx++)
 							{
-								unsigned int d = square((unsigned int)(Ax)) + Ay2;
-								keep_min(occupiedMinDistInt, d);
+								if ( (cell =*mapPtr++) < thresholdCellValue )
+								{
+									unsigned int d = square((unsigned int)(Ax)) + Ay2;
+									keep_min(occupiedMinDistInt, d);
+								}
+								Ax += 10;
 							}
-							Ax += 10;
 						}
-						// Go to (xx1,yy++)
-						mapPtr += incrAfterRow;
 						Ay += 10;
 					}
 
@@ -666,7 +669,7 @@ double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm,
 
                 if (likelihoodOptions.enableLikelihoodCache)
                     // And save it into the table and into "thisLik":
-                    precomputedLikelihood[ cx+cy*size_x ] = thisLik;
+                    precomputedLikelihood.cellForWrite(cx,cy) = thisLik;
 			}
 		}
 
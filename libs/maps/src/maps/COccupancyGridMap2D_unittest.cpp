@@ -49,3 +49,38 @@ TEST(COccupancyGridMap2DTests, insert2DScan)
 
 }
 
+
+TEST(COccupancyGridMap2DTests, copiesAreIndependent)
+{
+	// A synthetic scan with all ranges at 3 meters:
+	mrpt::obs::CObservation2DRangeScan	scan;
+	scan.aperture = M_PIf;
+	scan.rightToLeft = true;
+	scan.scan.assign(181, 3.0f);
+	scan.validRange.assign(181, 1);
+
+	COccupancyGridMap2D  grid(-10,10, -10,10,  0.05);
+	grid.insertObservation( &scan );
+
+	// The copy shares the cells with "grid" until it is modified:
+	COccupancyGridMap2D  grid2(grid);
+	const CPose3D  pose2(1.0,0,0, 0,0,0);
+	grid2.insertObservation( &scan, &pose2 );
+	grid2.resizeGrid(-25,10, -25,10, 0.5f, false);
+
+	EXPECT_NEAR( grid.getPos(3.5,0), 0.5f, 1e-3f ); // Behind the obstacle: unknown
+	EXPECT_GT( grid2.getPos(3.5,0), 0.51f );       // Free, as seen from pose2
+
+	// "grid" must not have been affected at all:
+	COccupancyGridMap2D  grid3(-10,10, -10,10,  0.05);
+	grid3.insertObservation( &scan );
+	ASSERT_EQ( grid.getSizeX(), grid3.getSizeX() );
+	ASSERT_EQ( grid.getSizeY(), grid3.getSizeY() );
+	for (unsigned int cy=0;cy<grid.getSizeY();cy++)
+		for (unsigned int cx=0;cx<grid.getSizeX();cx++)
+			EXPECT_EQ( grid.getRawMap()(cx,cy), grid3.getRawMap()(cx,cy) );
+
+	// Resizing keeps the contents:
+	EXPECT_NEAR( grid2.getPos(-2.0,-25+0.01), 0.5f, 1e-3f );
+	EXPECT_NEAR( grid2.getPos(0.5,0), grid.getPos(0.5,0), 0.05f );
+}
@@ -254,7 +254,7 @@ int  COccupancyGridMap2D::computeClearance( int cx, int cy, int *basis_x, int *b
 	if ( static_cast<unsigned>(cx)>=size_x || static_cast<unsigned>(cy)>=size_y )
 		return 0;
 
-	if ( map[cx+cy*size_y]<thresholdCellValue )
+	if ( map(cx,cy)<thresholdCellValue )
 		return 0;
 
 	// Truco para acelerar MUCHO:
@@ -340,7 +340,7 @@ int  COccupancyGridMap2D::computeClearance( int cx, int cy, int *basis_x, int *b
 				   if (xx>=0 && xx<static_cast<int>(size_x) && yy>=0 && yy<static_cast<int>(size_y))
 				   {
 					//if ( getCell(xx,yy)<=voroni_free_threshold )
-					if ( map[xx+yy*size_y]<thresholdCellValue )
+					if ( map(xx,yy)<thresholdCellValue )
 					{
 							if (!dentro_obs)
 							{
@@ -542,7 +542,7 @@ float  COccupancyGridMap2D::computeClearance( float x, float y, float maxSearchD
 
 	for (xx=xx1;xx<=xx2;xx++)
 		for (yy=yy1;yy<=yy2;yy++)
-			if (map[xx+yy*size_x]<thresholdCellValue)
+			if (map(xx,yy)<thresholdCellValue)
 				clearance_sq = min( clearance_sq, square(resolution)*(square(xx-cx)+square(yy-cy)) );
 
 	return sqrt(clearance_sq);
@@ -11,8 +11,10 @@
 
 #include <mrpt/graphs/CDirectedTree.h>
 #include <mrpt/utils/traits_map.h>
+#include <mrpt/utils/CDynamicGrid.h>
 #include <mrpt/math/wrap2pi.h>
 #include <mrpt/poses/CPose2D.h>
+#include <set>
 
 #include <mrpt/nav/tpspace/CParameterizedTrajectoryGenerator.h>
 #include <mrpt/nav/link_pragmas.h>
@@ -39,6 +41,10 @@ namespace mrpt
 		*      - addEdge (from, to)
 		*      - add here more instructions
 		*
+		*  Nodes are indexed by their (x,y) coordinates in a grid of cells (see setSpatialIndexCellSize()),
+		*  used by getNearestNode() to only evaluate the distance metric for nodes in cells around the query point.
+		*  This requires node types having a `state` field with `x` and `y` coordinates, and metrics whose
+		*  `cannotBeNearerThan()` only depends on the absolute value of the (x,y) increments between nodes.
 		*
 		* <b>Changes history</b>
 		*      - 06/MAR/2014: Creation (MB)
@@ -70,6 +76,12 @@ namespace mrpt
 			typedef typename MAPS_IMPLEMENTATION::template map<mrpt::utils::TNodeID,NODE_TYPE>  node_map_t;  //!< Map: TNode_ID => Node info
 			typedef std::list<NODE_TYPE> path_t; //!< A topological path up-tree
 
+			TMoveTree() :
+				m_spatial_index_cell_size(1.0),
+				m_spatial_index(0,0,0,0, 1.0)
+			{
+			}
+
 			/** Finds the nearest node to a given pose, using the given metric */
 			template <class NODE_TYPE_FOR_METRIC>
 			mrpt::utils::TNodeID getNearestNode(
@@ -79,29 +91,68 @@ namespace mrpt
 				const std::set<mrpt::utils::TNodeID> *ignored_nodes = NULL
 				) const
 			{
-				MRPT_TODO("Optimize this query with KD-tree!")
 				ASSERT_(!m_nodes.empty())
 
 				double min_d = std::numeric_limits<double>::max();
 				mrpt::utils::TNodeID min_id=INVALID_NODEID;
-				for (typename node_map_t::const_iterator it=m_nodes.begin();it!=m_nodes.end();++it)
+				const NODE_TYPE_FOR_METRIC ptTo(query_pt.state);
+
+				if (m_spatial_index.getSizeX()==0)
 				{
-					if (ignored_nodes && ignored_nodes->find(it->first)!=ignored_nodes->end())
-						continue; // ignore it
-					const NODE_TYPE_FOR_METRIC ptTo(query_pt.state);
-					const NODE_TYPE_FOR_METRIC ptFrom(it->second.state);
-					if (distanceMetricEvaluator.cannotBeNearerThan(ptFrom,ptTo,min_d))
-						continue; // Skip the more expensive calculation of exact distance
-					double d = distanceMetricEvaluator.distance(ptFrom,ptTo);
-					if (d<min_d) {
-						min_d = d;
-						min_id = it->first;
+					// No spatial index: check all nodes
+					for (typename node_map_t::const_iterator it=m_nodes.begin();it!=m_nodes.end();++it)
+						evaluateNodeDistance(it->first, it->second, ptTo, distanceMetricEvaluator, ignored_nodes, min_d, min_id);
+				}
+				else
+				{
+					// Visit the cells of the spatial index in "rings" of increasing size around the query point,
+					// until all nodes in outer rings are known to be farther than the best one so far:
+					const int size_x = m_spatial_index.getSizeX(), size_y = m_spatial_index.getSizeY();
+					const int qcx = spatialIndexX2Idx(query_pt.state.x), qcy = spatialIndexY2Idx(query_pt.state.y);
+					const int max_ring = std::max( std::max(std::abs(qcx),std::abs(qcx-size_x+1)), std::max(std::abs(qcy),std::abs(qcy-size_y+1)) );
+					const double cell_size = m_spatial_index.getResolution();
+
+					for (int r=0;r<=max_ring;r++)
+					{
+						// All the nodes in ring #r are at least (r-1) cells away in either x or y:
+						if (r>=1 && min_d!=std::numeric_limits<double>::max())
+						{
+							NODE_TYPE_FOR_METRIC probe_x(query_pt.state), probe_y(query_pt.state);
+							probe_x.state.x += (r-1)*cell_size;
+							probe_y.state.y += (r-1)*cell_size;
+							if (distanceMetricEvaluator.cannotBeNearerThan(probe_x,ptTo,min_d) && distanceMetricEvaluator.cannotBeNearerThan(probe_y,ptTo,min_d))
+								break;
+						}
+
+						for (int i=-r;i<=r;i++)
+						{
+							// Top & bottom rows of the ring, then left & right columns (without corners):
+							evaluateSpatialIndexCell(qcx+i,qcy-r, ptTo, distanceMetricEvaluator, ignored_nodes, min_d, min_id);
+							if (r>0)
+								evaluateSpatialIndexCell(qcx+i,qcy+r, ptTo, distanceMetricEvaluator, ignored_nodes, min_d, min_id);
+							if (i!=-r && i!=r)
+							{
+								evaluateSpatialIndexCell(qcx-r,qcy+i, ptTo, distanceMetricEvaluator, ignored_nodes, min_d, min_id);
+								evaluateSpatialIndexCell(qcx+r,qcy+i, ptTo, distanceMetricEvaluator, ignored_nodes, min_d, min_id);
+							}
+						}
 					}
 				}
+
 				if (out_distance) *out_distance = min_d;
 				return min_id;
 			}
 
+			/** Changes the size of the cells (in meters, default=1.0) of the spatial index used in getNearestNode().
+			  * A value of 0 disables the index, so all nodes are evaluated in each query. */
+			void setSpatialIndexCellSize(const double cell_size)
+			{
+				ASSERT_(cell_size>=0)
+				m_spatial_index_cell_size = cell_size;
+				rebuildSpatialIndex();
+			}
+			double getSpatialIndexCellSize() const { return m_spatial_index_cell_size; }
+
 			void insertNodeAndEdge(
 				const mrpt::utils::TNodeID parent_id, 
 				const mrpt::utils::TNodeID new_child_id, 
@@ -112,13 +163,21 @@ namespace mrpt
 				typename base_t::TListEdges & edges_of_parent = base_t::edges_to_children[parent_id];
 				edges_of_parent.push_back( typename base_t::TEdgeInfo(new_child_id,false/*direction_child_to_parent*/, new_edge_data ) );
 				// node:
+				const bool is_new = m_nodes.find(new_child_id)==m_nodes.end();
 				m_nodes[new_child_id] = NODE_TYPE(new_child_id,parent_id, &edges_of_parent.back().data, new_child_node_data);
+				if (is_new)
+				     insertIntoSpatialIndex(new_child_id, new_child_node_data);
+				else rebuildSpatialIndex();
 			}
 
 			/** Insert a node without edges (should be used only for a tree root node) */
 			void insertNode(const mrpt::utils::TNodeID node_id, const NODE_TYPE_DATA &node_data) 
 			{
+				const bool is_new = m_nodes.find(node_id)==m_nodes.end();
 				m_nodes[node_id] = NODE_TYPE(node_id,INVALID_NODEID, NULL, node_data);
+				if (is_new)
+				     insertIntoSpatialIndex(node_id, node_data);
+				else rebuildSpatialIndex();
 			}
 
 			mrpt::utils::TNodeID getNextFreeNodeID() const { return m_nodes.size(); }
@@ -158,6 +217,73 @@ namespace mrpt
 		private:
 			node_map_t  m_nodes;  //!< Info per node
 
+			typedef std::vector<mrpt::utils::TNodeID> spatial_index_cell_t;
+			double m_spatial_index_cell_size;
+			mrpt::utils::CDynamicGrid<spatial_index_cell_t> m_spatial_index; //!< The IDs of the nodes in each (x,y) cell. Empty if the index is disabled.
+
+			// Like CDynamicGrid::x2idx(), but also valid out of the grid limits:
+			int spatialIndexX2Idx(const double x) const { return static_cast<int>( std::floor( (x-m_spatial_index.getXMin())/m_spatial_index.getResolution() ) ); }
+			int spatialIndexY2Idx(const double y) const { return static_cast<int>( std::floor( (y-m_spatial_index.getYMin())/m_spatial_index.getResolution() ) ); }
+
+			void insertIntoSpatialIndex(const mrpt::utils::TNodeID node_id, const NODE_TYPE_DATA &node_data)
+			{
+				if (m_spatial_index_cell_size<=0)
+					return;
+				const double x = node_data.state.x, y = node_data.state.y;
+				if (m_spatial_index.getSizeX()==0)
+				     m_spatial_index.setSize(x-10.0*m_spatial_index_cell_size,x+10.0*m_spatial_index_cell_size, y-10.0*m_spatial_index_cell_size,y+10.0*m_spatial_index_cell_size, m_spatial_index_cell_size);
+				else m_spatial_index.resize(x,x,y,y, spatial_index_cell_t(), 10.0*m_spatial_index_cell_size);
+				spatial_index_cell_t *cell = m_spatial_index.cellByIndex( spatialIndexX2Idx(x), spatialIndexY2Idx(y) );
+				ASSERT_(cell!=NULL)
+				cell->push_back(node_id);
+			}
+
+			void rebuildSpatialIndex()
+			{
+				m_spatial_index.setSize(0,0,0,0, 1.0);
+				for (typename node_map_t::const_iterator it=m_nodes.begin();it!=m_nodes.end();++it)
+					insertIntoSpatialIndex(it->first, it->second);
+			}
+
+			template <class NODE_TYPE_FOR_METRIC>
+			void evaluateSpatialIndexCell(
+				const int cx, const int cy,
+				const NODE_TYPE_FOR_METRIC &ptTo,
+				const PoseDistanceMetric<NODE_TYPE_FOR_METRIC> &distanceMetricEvaluator,
+				const std::set<mrpt::utils::TNodeID> *ignored_nodes,
+				double &min_d, mrpt::utils::TNodeID &min_id) const
+			{
+				if (cx<0 || cy<0) return;
+				const spatial_index_cell_t *cell = m_spatial_index.cellByIndex(cx,cy);
+				if (!cell) return;
+				for (typename spatial_index_cell_t::const_iterator itId=cell->begin();itId!=cell->end();++itId)
+				{
+					typename node_map_t::const_iterator it = m_nodes.find(*itId);
+					evaluateNodeDistance(it->first, it->second, ptTo, distanceMetricEvaluator, ignored_nodes, min_d, min_id);
+				}
+			}
+
+			template <class NODE_TYPE_FOR_METRIC>
+			static void evaluateNodeDistance(
+				const mrpt::utils::TNodeID node_id, const NODE_TYPE &node,
+				const NODE_TYPE_FOR_METRIC &ptTo,
+				const PoseDistanceMetric<NODE_TYPE_FOR_METRIC> &distanceMetricEvaluator,
+				const std::set<mrpt::utils::TNodeID> *ignored_nodes,
+				double &min_d, mrpt::utils::TNodeID &min_id)
+			{
+				if (ignored_nodes && ignored_nodes->find(node_id)!=ignored_nodes->end())
+					return; // ignore it
+				const NODE_TYPE_FOR_METRIC ptFrom(node.state);
+				if (distanceMetricEvaluator.cannotBeNearerThan(ptFrom,ptTo,min_d))
+					return; // Skip the more expensive calculation of exact distance
+				const double d = distanceMetricEvaluator.distance(ptFrom,ptTo);
+				// (Ties are resolved in favor of the lowest ID, so results do not depend on the order in which nodes are visited)
+				if (d<min_d || (d==min_d && min_id!=INVALID_NODEID && node_id<min_id)) {
+					min_d = d;
+					min_id = node_id;
+				}
+			}
+
 		}; // end TMoveTree
 
 		/** An edge for the move tree used for planning in SE2 and TP-space */
@@ -192,8 +318,9 @@ namespace mrpt
 		{
 			bool cannotBeNearerThan(const TNodeSE2 &a, const TNodeSE2& b,const double d) const
 			{
-				if (std::abs(a.state.x-b.state.x)>d) return true;
-				if (std::abs(a.state.y-b.state.y)>d) return true;
+				// Note: distance() returns squared distances
+				if (mrpt::math::square(a.state.x-b.state.x)>d) return true;
+				if (mrpt::math::square(a.state.y-b.state.y)>d) return true;
 				return false;
 			}
 
@@ -88,6 +88,7 @@ namespace mrpt
 			virtual void loggingGetWSObstaclesAndShape(CLogFileRecord &out_log);
 
 			mrpt::maps::CSimplePointsMap m_WS_Obstacles;  //!< The obstacle points, as seen from the local robot frame.
+			std::vector<float> m_TP_obs_xs, m_TP_obs_ys; //!< Temporary buffers with the obstacles passed to the PTGs in STEP3_WSpaceToTPSpace()
 
 		protected:
 			void internal_loadConfigFile(const mrpt::utils::CConfigFileBase &ini, const std::string &section_prefix="") MRPT_OVERRIDE;
@@ -38,7 +38,9 @@ namespace nav
 	/** Base class for all PTGs suitable to non-holonomic, differentially-driven (or Ackermann) vehicles
 	  * based on numerical integration of the trajectories and collision look-up-table.
 	  * Regarding `initialize()`: in this this family of PTGs, the method builds the collision grid or load it from a cache file.
-	  * Collision grids must be calculated before calling getTPObstacle(). Robot shape must be set before initializing with setRobotShape().
+	  * Cache files are flat binary files, identified by a hash of the simulated trajectories, the robot shape and the grid geometry,
+	  * so any change in the PTG parameters invalidates them and forces the grid to be recomputed.
+	  * Collision grids must be calculated before calling updateTPObstacle(). Robot shape must be set before initializing with setRobotShape().
 	  * The rest of PTG parameters should have been set at the constructor.
 	  */
 	class NAV_IMPEXP CPTG_DiffDrive_CollisionGridBased : public CPTG_RobotShape_Polygonal
@@ -71,6 +73,8 @@ namespace nav
 		bool getPathStepForDist(uint16_t k, double dist, uint16_t &out_step) const MRPT_OVERRIDE;
 
 		void updateTPObstacle(double ox, double oy, std::vector<double> &tp_obstacles) const MRPT_OVERRIDE;
+		/** Batch version of updateTPObstacle(), using the compact collision grid. Large point clouds are split in chunks processed in parallel threads. */
+		void updateTPObstacles(const size_t N, const float *xs, const float *ys, std::vector<double> &tp_obstacles) const MRPT_OVERRIDE;
 		/** This family of PTGs ignore the kinematic state of the robot */
 		void updateCurrentRobotVel(const mrpt::math::TTwist2D &curVelLocal)  MRPT_OVERRIDE 
 		{}
@@ -137,11 +141,8 @@ protected:
 			}
 			virtual ~CColisionGrid() { }
 
-			bool saveToFile( mrpt::utils::CStream* fil, const mrpt::math::CPolygon & computed_robotShape ) const;	//!< Save to file, true = OK
-			bool loadFromFile( mrpt::utils::CStream* fil, const mrpt::math::CPolygon & current_robotShape );	//!< Load from file,  true = OK
-
-			/** For an obstacle (x,y), returns a vector with all the pairs (a,d) such as the robot collides */
-			const TCollisionCell & getTPObstacle( const float obsX, const float obsY) const;
+			bool saveToFile( mrpt::utils::CStream* fil, const std::string & cache_key ) const;	//!< Save the compact grid to file, true = OK
+			bool loadFromFile( mrpt::utils::CStream* fil, const std::string & cache_key );	//!< Load the compact grid from file, true = OK. Fails if the stored key does not match `cache_key`
 
 			/** Updates the info into a cell: It updates the cell only if the distance d for the path k is lower than the previous value:
 				*	\param cellInfo The index of the cell
@@ -150,11 +151,39 @@ protected:
 				*/
 			void updateCellInfo( const unsigned int icx, const unsigned int icy, const uint16_t k, const float dist );
 
+			/** Builds the compact (flattened) grid used for look-ups in getTPObstacleCompact() from the cells filled with updateCellInfo().
+			  * The memory of those cells is released afterwards, since only the compact grid is used from then on. */
+			void buildCompactGrid();
+
+			/** For an obstacle (x,y), returns the number of (k,d) pairs such as the robot collides,
+			  * and pointers to their first elements in `out_ks` and `out_dists`. */
+			inline size_t getTPObstacleCompact( const float obsX, const float obsY, const uint16_t * &out_ks, const float * &out_dists) const
+			{
+				const int cx = x2idx(obsX), cy = y2idx(obsY);
+				if (cx<0 || cx>=static_cast<int>(m_size_x) || cy<0 || cy>=static_cast<int>(m_size_y) || m_compact_cell_start.empty())
+					return 0;
+				const size_t idx = cx + cy*m_size_x;
+				const uint32_t i0 = m_compact_cell_start[idx];
+				out_ks = &m_compact_k[0] + i0;
+				out_dists = &m_compact_dist[0] + i0;
+				return m_compact_cell_start[idx+1] - i0;
+			}
+
+		private:
+			/** Compact copy of the grid in CSR format: the (k,d) pairs of cell `i` are stored, contiguously,
+			  * at indices [m_compact_cell_start[i], m_compact_cell_start[i+1]) of m_compact_k and m_compact_dist */
+			std::vector<uint32_t> m_compact_cell_start;
+			std::vector<uint16_t> m_compact_k;
+			std::vector<float>    m_compact_dist;
 		}; // end of class CColisionGrid
 
 		// Save/Load from files.
-		bool saveColGridsToFile( const std::string &filename, const mrpt::math::CPolygon & computed_robotShape ) const;	// true = OK
-		bool loadColGridsFromFile( const std::string &filename, const mrpt::math::CPolygon & current_robotShape ); // true = OK
+		bool saveColGridsToFile( const std::string &filename, const std::string & cache_key ) const;	// true = OK
+		bool loadColGridsFromFile( const std::string &filename, const std::string & cache_key ); // true = OK
+
+		/** Returns a hash (md5) of everything the collision grid depends on: the simulated trajectories, the robot shape and the grid geometry.
+		  * Must be called after simulateTrajectories() and after setting the grid size. */
+		std::string computeColGridCacheKey() const;
 
 		CColisionGrid	m_collisionGrid; //!< The collision grid
 
@@ -136,6 +136,16 @@ namespace nav
 		  */
 		virtual void updateTPObstacle(double ox, double oy, std::vector<double> &tp_obstacles) const = 0;
 
+		/** Batch version of updateTPObstacle(): updates the radial map of closest TP-Obstacles given `N` obstacle points,
+		  * passed as separate arrays of coordinates (e.g. as returned by mrpt::maps::CPointsMap::getPointsBuffer()).
+		  * The default implementation just calls updateTPObstacle() for each point; derived classes may redefine it with faster implementations.
+		  * \param [in] N Number of obstacle points.
+		  * \param [in] xs Obstacle points (X), relative coordinates wrt origin of the PTG.
+		  * \param [in] ys Obstacle points (Y), relative coordinates wrt origin of the PTG.
+		  * \param [in,out] tp_obstacles A vector of length `getAlphaValuesCount()`, initialized with `initTPObstacles()`.
+		  */
+		virtual void updateTPObstacles(const size_t N, const float *xs, const float *ys, std::vector<double> &tp_obstacles) const;
+
 		/** Loads a set of default parameters into the PTG. Users normally will call `loadFromConfigFile()` instead, this method is provided 
 		  * exclusively for the PTG-configurator tool. */
 		virtual void loadDefaultParams();
@@ -494,6 +494,8 @@ void PlannerRRT_SE2_TPS::spaceTransformer(
 		// Init obs ranges: 
 		in_PTG->initTPObstacles(out_TPObstacles);
 
+		std::vector<float> xs, ys;
+		xs.reserve(nObs); ys.reserve(nObs);
 		for (size_t obs=0;obs<nObs;obs++)
 		{
 			const float ox = obs_xs[obs];
@@ -502,8 +504,11 @@ void PlannerRRT_SE2_TPS::spaceTransformer(
 			if (std::abs(ox)>MAX_DIST || std::abs(oy)>MAX_DIST)
 				continue;   // ignore this obstacle: anyway, I don't know how to map it to TP-Obs!
 
-			in_PTG->updateTPObstacle(ox, oy, out_TPObstacles);
+			xs.push_back(ox);
+			ys.push_back(oy);
 		}
+		if (!xs.empty())
+			in_PTG->updateTPObstacles(xs.size(), &xs[0], &ys[0], out_TPObstacles);
 
 		// Leave distances in out_TPObstacles un-normalized ([0,1]), so they just represent real distances in meters.
 	}
@@ -0,0 +1,55 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/nav/planners/TMoveTree.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt::nav;
+using namespace mrpt::random;
+
+// The spatial index must return exactly the same nodes than a linear search:
+TEST(NavTests, TMoveTree_getNearestNode)
+{
+	randomGenerator.randomize(1234);
+
+	TMoveTreeSE2_TP tree_idx, tree_linear;
+	tree_idx.setSpatialIndexCellSize(0.5);
+	tree_linear.setSpatialIndexCellSize(0);
+
+	const size_t N = 2000;
+	for (size_t i=0;i<N;i++)
+	{
+		const mrpt::math::TPose2D p(randomGenerator.drawUniform(-30.0,50.0),randomGenerator.drawUniform(-20.0,20.0),randomGenerator.drawUniform(-M_PI,M_PI));
+		if (i==0) {
+			tree_idx.insertNode(0, TNodeSE2_TP(p));
+			tree_linear.insertNode(0, TNodeSE2_TP(p));
+		}
+		else {
+			tree_idx.insertNodeAndEdge(0,i, TNodeSE2_TP(p), TMoveEdgeSE2_TP(0,p));
+			tree_linear.insertNodeAndEdge(0,i, TNodeSE2_TP(p), TMoveEdgeSE2_TP(0,p));
+		}
+	}
+
+	const PoseDistanceMetric<TNodeSE2> metric;
+	for (size_t i=0;i<500;i++)
+	{
+		// Some queries are far away from all nodes:
+		const TNodeSE2 query( mrpt::math::TPose2D(randomGenerator.drawUniform(-100.0,100.0),randomGenerator.drawUniform(-100.0,100.0),randomGenerator.drawUniform(-M_PI,M_PI)) );
+		std::set<mrpt::utils::TNodeID> ignored;
+		ignored.insert(i);
+
+		double d_idx, d_linear;
+		const mrpt::utils::TNodeID id_idx = tree_idx.getNearestNode(query,metric,&d_idx,&ignored);
+		const mrpt::utils::TNodeID id_linear = tree_linear.getNearestNode(query,metric,&d_linear,&ignored);
+
+		EXPECT_EQ(id_idx, id_linear);
+		EXPECT_DOUBLE_EQ(d_idx, d_linear);
+	}
+}
@@ -196,6 +196,9 @@ void CReactiveNavigationSystem::STEP3_WSpaceToTPSpace(const size_t ptg_idx,std::
 	const float *xs,*ys,*zs;
 	m_WS_Obstacles.getPointsBuffer(nObs,xs,ys,zs);
 
+	// Gather the relevant obstacles and pass them to the PTG in one batch:
+	m_TP_obs_xs.clear(); m_TP_obs_xs.reserve(nObs);
+	m_TP_obs_ys.clear(); m_TP_obs_ys.reserve(nObs);
 	for (size_t obs=0;obs<nObs;obs++)
 	{
 		const float ox=xs[obs], oy = ys[obs], oz=zs[obs];
@@ -204,9 +207,12 @@ void CReactiveNavigationSystem::STEP3_WSpaceToTPSpace(const size_t ptg_idx,std::
 			oy>-OBS_MAX_XY && oy<OBS_MAX_XY &&
 			oz>=minObstaclesHeight && oz<=maxObstaclesHeight)
 		{
-			ptg->updateTPObstacle(ox, oy, out_TPObstacles);
+			m_TP_obs_xs.push_back(ox);
+			m_TP_obs_ys.push_back(oy);
 		}
 	}
+	if (!m_TP_obs_xs.empty())
+		ptg->updateTPObstacles(m_TP_obs_xs.size(), &m_TP_obs_xs[0], &m_TP_obs_ys[0], out_TPObstacles);
 }
 
 
@@ -245,11 +245,7 @@ void CReactiveNavigationSystem3D::STEP3_WSpaceToTPSpace(
 		const float *xs,*ys,*zs;
 		m_WS_Obstacles_inlevels[j].getPointsBuffer(nObs,xs,ys,zs);
 
-		for (size_t obs=0;obs<nObs;obs++)
-		{
-			const float ox = xs[obs], oy = ys[obs];
-			m_ptgmultilevel[ptg_idx].PTGs[j]->updateTPObstacle(ox, oy, out_TPObstacles);
-		}
+		m_ptgmultilevel[ptg_idx].PTGs[j]->updateTPObstacles(nObs, xs, ys, out_TPObstacles);
 	}
 
 	// Distances in TP-Space are normalized to [0,1]
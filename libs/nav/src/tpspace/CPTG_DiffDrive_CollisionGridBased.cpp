@@ -11,11 +11,14 @@
 
 #include <mrpt/nav/tpspace/CPTG_DiffDrive_CollisionGridBased.h>
 
-#include <mrpt/utils/CFileGZInputStream.h>
-#include <mrpt/utils/CFileGZOutputStream.h>
+#include <mrpt/utils/CFileInputStream.h>
+#include <mrpt/utils/CFileOutputStream.h>
+#include <mrpt/utils/CMemoryStream.h>
+#include <mrpt/utils/md5.h>
 #include <mrpt/utils/CTicTac.h>
 #include <mrpt/math/geometry.h>
 #include <mrpt/utils/stl_serialization.h>
+#include <mrpt/system/threads.h>
 
 using namespace mrpt::nav;
 
@@ -255,17 +258,6 @@ void CPTG_DiffDrive_CollisionGridBased::directionToMotionCommand( uint16_t k, st
 	out_action_cmd[1] = w;
 }
 
-/*---------------------------------------------------------------
-					getTPObstacle
-  ---------------------------------------------------------------*/
-const CPTG_DiffDrive_CollisionGridBased::TCollisionCell & CPTG_DiffDrive_CollisionGridBased::CColisionGrid::getTPObstacle(
-	const float obsX, const float obsY) const
-{
-	static const TCollisionCell  emptyCell;
-	const TCollisionCell *cell = cellByPos(obsX,obsY);
-	return cell!=NULL ? *cell : emptyCell;
-}
-
 /*---------------------------------------------------------------
 	Updates the info into a cell: It updates the cell only
 	  if the distance d for the path k is lower than the previous value:
@@ -299,20 +291,48 @@ void CPTG_DiffDrive_CollisionGridBased::CColisionGrid::updateCellInfo(
 	}
 }
 
+/*---------------------------------------------------------------
+					buildCompactGrid
+  ---------------------------------------------------------------*/
+void CPTG_DiffDrive_CollisionGridBased::CColisionGrid::buildCompactGrid()
+{
+	const size_t nCells = m_map.size();
+	size_t nPairs = 0;
+	for (size_t i=0;i<nCells;i++)
+		nPairs+=m_map[i].size();
+
+	m_compact_cell_start.resize(nCells+1);
+	m_compact_k.resize(nPairs);
+	m_compact_dist.resize(nPairs);
+
+	uint32_t idx = 0;
+	for (size_t i=0;i<nCells;i++)
+	{
+		m_compact_cell_start[i] = idx;
+		for (TCollisionCell::const_iterator it=m_map[i].begin();it!=m_map[i].end();++it, ++idx)
+		{
+			m_compact_k[idx] = it->first;
+			m_compact_dist[idx] = it->second;
+		}
+	}
+	m_compact_cell_start[nCells] = idx;
+
+	// Release the memory of the cells, only the compact grid is used from now on:
+	for (size_t i=0;i<nCells;i++)
+		TCollisionCell().swap(m_map[i]);
+}
 
 /*---------------------------------------------------------------
 					Save to file
   ---------------------------------------------------------------*/
-bool CPTG_DiffDrive_CollisionGridBased::saveColGridsToFile( const std::string &filename, const mrpt::math::CPolygon & computed_robotShape ) const
+bool CPTG_DiffDrive_CollisionGridBased::saveColGridsToFile( const std::string &filename, const std::string & cache_key ) const
 {
 	try
 	{
-		mrpt::utils::CFileGZOutputStream   fo(filename);
+		mrpt::utils::CFileOutputStream   fo(filename);
 		if (!fo.fileOpenCorrectly()) return false;
 
-		const uint32_t n = 1; // for backwards compatibility...
-		fo << n;
-		return m_collisionGrid.saveToFile(&fo, computed_robotShape);
+		return m_collisionGrid.saveToFile(&fo, cache_key);
 	}
 	catch (...)
 	{
@@ -323,18 +343,14 @@ bool CPTG_DiffDrive_CollisionGridBased::saveColGridsToFile( const std::string &f
 /*---------------------------------------------------------------
 					Load from file
   ---------------------------------------------------------------*/
-bool CPTG_DiffDrive_CollisionGridBased::loadColGridsFromFile( const std::string &filename, const mrpt::math::CPolygon & current_robotShape  )
+bool CPTG_DiffDrive_CollisionGridBased::loadColGridsFromFile( const std::string &filename, const std::string & cache_key )
 {
 	try
 	{
-		mrpt::utils::CFileGZInputStream   fi(filename);
+		mrpt::utils::CFileInputStream   fi(filename);
 		if (!fi.fileOpenCorrectly()) return false;
 
-		uint32_t n;
-		fi >> n;
-		if (n!=1) return false; // Incompatible (old) format, just discard and recompute.
-
-		return m_collisionGrid.loadFromFile(&fi,current_robotShape);
+		return m_collisionGrid.loadFromFile(&fi, cache_key);
 	}
 	catch(...)
 	{
@@ -342,43 +358,51 @@ bool CPTG_DiffDrive_CollisionGridBased::loadColGridsFromFile( const std::string
 	}
 }
 
-const uint32_t COLGRID_FILE_MAGIC     = 0xC0C0C0C3;
+std::string CPTG_DiffDrive_CollisionGridBased::computeColGridCacheKey() const
+{
+	mrpt::utils::CMemoryStream buf;
+	buf << getDescription()
+		<< m_robotShape
+		<< m_trajectory
+		<< m_collisionGrid.getXMin() << m_collisionGrid.getXMax()
+		<< m_collisionGrid.getYMin() << m_collisionGrid.getYMax()
+		<< m_collisionGrid.getResolution();
+
+	return mrpt::utils::md5( static_cast<const unsigned char*>(buf.getRawBufferData()), static_cast<size_t>(buf.getTotalBytesCount()) );
+}
+
+const uint32_t COLGRID_FILE_MAGIC     = 0xC0C0C0C4;
 
 /*---------------------------------------------------------------
 					Save to file
   ---------------------------------------------------------------*/
-bool CPTG_DiffDrive_CollisionGridBased::CColisionGrid::saveToFile( mrpt::utils::CStream *f, const mrpt::math::CPolygon & computed_robotShape ) const
+bool CPTG_DiffDrive_CollisionGridBased::CColisionGrid::saveToFile( mrpt::utils::CStream *f, const std::string & cache_key ) const
 {
 	try
 	{
 		if (!f) return false;
 
-		const uint8_t serialize_version = 2; // v1: As of jun 2012, v2: As of dec-2013
+		const uint8_t serialize_version = 3; // v1: As of jun 2012, v2: As of dec-2013, v3: flat arrays + hash key (oct-2016)
 
 		// Save magic signature && serialization version:
 		*f << COLGRID_FILE_MAGIC << serialize_version;
 
-		// Robot shape:
-		*f << computed_robotShape;
+		// The hash of all the parameters this grid depends on:
+		*f << cache_key;
 
-		// and standard PTG data:
-		*f << m_parent->getDescription()
-			<< m_parent->getAlphaValuesCount()
-			<< static_cast<float>(m_parent->getMax_V())
-			<< static_cast<float>(m_parent->getMax_W());
+		if (m_compact_cell_start.size()!=m_map.size()+1)
+			return false; // The compact grid was not built yet.
 
-		*f << m_x_min << m_x_max << m_y_min << m_y_max;
-		*f << m_resolution;
+		const uint32_t nCells = m_map.size();
+		const uint32_t nPairs = m_compact_k.size();
+		*f << nCells << nPairs;
 
-		//v1 was:  *f << m_map;
-		uint32_t N = m_map.size();
-		*f << N;
-		for (uint32_t i=0;i<N;i++)
+		// The compact grid, as raw arrays:
+		f->WriteBufferFixEndianness(&m_compact_cell_start[0], nCells+1);
+		if (nPairs)
 		{
-			uint32_t M = m_map[i].size();
-			*f << M;
-			for (uint32_t k=0;k<M;k++)
-				*f << m_map[i][k].first << m_map[i][k].second;
+			f->WriteBufferFixEndianness(&m_compact_k[0], nPairs);
+			f->WriteBufferFixEndianness(&m_compact_dist[0], nPairs);
 		}
 
 		return true;
@@ -392,7 +416,7 @@ bool CPTG_DiffDrive_CollisionGridBased::CColisionGrid::saveToFile( mrpt::utils::
 /*---------------------------------------------------------------
 						loadFromFile
   ---------------------------------------------------------------*/
-bool CPTG_DiffDrive_CollisionGridBased::CColisionGrid::loadFromFile( mrpt::utils::CStream *f, const mrpt::math::CPolygon & current_robotShape  )
+bool CPTG_DiffDrive_CollisionGridBased::CColisionGrid::loadFromFile( mrpt::utils::CStream *f, const std::string & cache_key )
 {
 	try
 	{
@@ -408,64 +432,50 @@ bool CPTG_DiffDrive_CollisionGridBased::CColisionGrid::loadFromFile( mrpt::utils
 
 		uint8_t serialized_version;
 		*f >> serialized_version;
+		// Unknown version: Maybe we are loading a file from a more recent version of MRPT? Whatever, we can't read it: It's safer just to re-generate the PTG data
+		if (serialized_version!=3)
+			return false;
 
-		switch (serialized_version)
-		{
-		case 2:
-			{
-				mrpt::math::CPolygon stored_shape;
-				*f >> stored_shape;
-
-				const bool shapes_match =
-					( stored_shape.size()==current_robotShape.size() &&
-					  std::equal(stored_shape.begin(),stored_shape.end(), current_robotShape.begin() ) );
+		// Must recompute if any PTG parameter or the robot shape changed:
+		std::string stored_key;
+		*f >> stored_key;
+		if (stored_key!=cache_key)
+			return false;
 
-				if (!shapes_match) return false; // Must recompute if the robot shape changed.
-			}
-			break;
+		uint32_t nCells, nPairs;
+		*f >> nCells >> nPairs;
+		if (nCells!=m_map.size())
+			return false;
 
-		case 1:
-		default:
-			// Unknown version: Maybe we are loading a file from a more recent version of MRPT? Whatever, we can't read it: It's safer just to re-generate the PTG data
+		// Read the arrays in one go, straight into their final storage:
+		std::vector<uint32_t> cell_start(nCells+1);
+		std::vector<uint16_t> ks(nPairs);
+		std::vector<float>    dists(nPairs);
+		if (f->ReadBufferFixEndianness(&cell_start[0], nCells+1)!=sizeof(uint32_t)*(nCells+1))
 			return false;
-		};
-
-		// Standard PTG data:
-		const std::string expected_desc = m_parent->getDescription();
-		std::string desc;
-		*f >> desc;
-		if (desc!=expected_desc) return false;
-
-		// and standard PTG data:
-#define READ_UINT16_CHECK_IT_MATCHES_STORED(_VAR) { uint16_t ff; *f >> ff; if (ff!=_VAR) return false; }
-#define READ_FLOAT_CHECK_IT_MATCHES_STORED(_VAR) { float ff; *f >> ff; if (std::abs(ff-_VAR)>1e-4f) return false; }
-#define READ_DOUBLE_CHECK_IT_MATCHES_STORED(_VAR) { double ff; *f >> ff; if (std::abs(ff-_VAR)>1e-6) return false; }
-
-		READ_UINT16_CHECK_IT_MATCHES_STORED(m_parent->getAlphaValuesCount())
-		READ_FLOAT_CHECK_IT_MATCHES_STORED(m_parent->getMax_V())
-		READ_FLOAT_CHECK_IT_MATCHES_STORED(m_parent->getMax_W())
-
-		// Cell dimensions:
-		READ_DOUBLE_CHECK_IT_MATCHES_STORED(m_x_min)
-		READ_DOUBLE_CHECK_IT_MATCHES_STORED(m_x_max)
-		READ_DOUBLE_CHECK_IT_MATCHES_STORED(m_y_min)
-		READ_DOUBLE_CHECK_IT_MATCHES_STORED(m_y_max)
-		READ_DOUBLE_CHECK_IT_MATCHES_STORED(m_resolution)
-
-		// OK, all parameters seem to be exactly the same than when we precomputed the table: load it.
-		//v1 was:  *f >> m_map;
-		uint32_t N;
-		*f >> N;
-		 m_map.resize(N);
-		for (uint32_t i=0;i<N;i++)
+		if (nPairs)
 		{
-			uint32_t M;
-			*f >> M;
-			 m_map[i].resize(M);
-			for (uint32_t k=0;k<M;k++)
-				*f >> m_map[i][k].first >> m_map[i][k].second;
+			if (f->ReadBufferFixEndianness(&ks[0], nPairs)!=sizeof(uint16_t)*nPairs)
+				return false;
+			if (f->ReadBufferFixEndianness(&dists[0], nPairs)!=sizeof(float)*nPairs)
+				return false;
 		}
 
+		// Sanity checks, so a corrupted file never leads to out of bounds accesses:
+		if (cell_start[0]!=0 || cell_start[nCells]!=nPairs)
+			return false;
+		for (uint32_t i=0;i<nCells;i++)
+			if (cell_start[i]>cell_start[i+1])
+				return false;
+		const uint16_t nAlphas = m_parent->getAlphaValuesCount();
+		for (uint32_t i=0;i<nPairs;i++)
+			if (ks[i]>=nAlphas)
+				return false;
+
+		m_compact_cell_start.swap(cell_start);
+		m_compact_k.swap(ks);
+		m_compact_dist.swap(dists);
+
 		return true;
 	}
 	catch(std::exception &e)
@@ -479,6 +489,7 @@ bool CPTG_DiffDrive_CollisionGridBased::CColisionGrid::loadFromFile( mrpt::utils
 	}
 }
 
+
 bool CPTG_DiffDrive_CollisionGridBased::inverseMap_WS2TP(double x, double y, int &out_k, double &out_d, double tolerance_dist) const
 {
 	using mrpt::utils::square;
@@ -607,6 +618,112 @@ void CPTG_DiffDrive_CollisionGridBased::internal_deinitialize()
 	m_trajectory.clear(); // Free trajectories
 }
 
+namespace
+{
+	/** Pairs (cell index, min. distance) of the cells in collision with one path */
+	typedef std::vector<std::pair<uint32_t,float> > TCollidingCells;
+
+	/** Finds the cells in collision with each path in a range of paths, without modifying the grid */
+	template <class GRID>
+	struct TBuildCollisionGridBlock
+	{
+		const CParameterizedTrajectoryGenerator &ptg;
+		const GRID &grid;
+		const mrpt::math::CPolygon &robotShape;
+		std::vector<TCollidingCells> &collisions;
+
+		TBuildCollisionGridBlock(const CParameterizedTrajectoryGenerator &ptg_, const GRID &grid_, const mrpt::math::CPolygon &robotShape_, std::vector<TCollidingCells> &collisions_) :
+			ptg(ptg_), grid(grid_), robotShape(robotShape_), collisions(collisions_)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int block_index)
+		{
+			const int grid_cx = grid.getSizeX(), grid_cy = grid.getSizeY();
+			const int grid_cx_max = grid_cx-1;
+			const int grid_cy_max = grid_cy-1;
+			const double half_cell = grid.getResolution()*0.5;
+
+			const size_t nVerts = robotShape.verticesCount();
+			std::vector<mrpt::math::TPoint2D> transf_shape(nVerts); // The robot shape at each location
+
+			// Min. distance for each cell for the current path, and list of cells with some value:
+			std::vector<float> cell_dist(grid_cx*grid_cy, std::numeric_limits<float>::max());
+			std::vector<uint32_t> touched_cells;
+
+			for (size_t k=first;k<last;k++)
+			{
+				const size_t nPoints = ptg.getPathStepCount(k);
+				ASSERT_(nPoints>1)
+
+				for (size_t n=0;n<(nPoints-1);n++)
+				{
+					// Translate and rotate the robot shape at this C-Space pose:
+					mrpt::math::TPose2D p;
+					ptg.getPathPose(k, n, p);
+
+					mrpt::math::TPoint2D bb_min(std::numeric_limits<double>::max(),std::numeric_limits<double>::max());
+					mrpt::math::TPoint2D bb_max(-std::numeric_limits<double>::max(),-std::numeric_limits<double>::max());
+
+					for (size_t m = 0;m<nVerts;m++)
+					{
+						transf_shape[m].x = p.x + cos(p.phi)*robotShape.GetVertex_x(m)-sin(p.phi)*robotShape.GetVertex_y(m);
+						transf_shape[m].y = p.y + sin(p.phi)*robotShape.GetVertex_x(m)+cos(p.phi)*robotShape.GetVertex_y(m);
+						mrpt::utils::keep_max( bb_max.x, transf_shape[m].x); mrpt::utils::keep_max( bb_max.y, transf_shape[m].y);
+						mrpt::utils::keep_min( bb_min.x, transf_shape[m].x); mrpt::utils::keep_min( bb_min.y, transf_shape[m].y);
+					}
+
+					// Robot shape polygon:
+					const mrpt::math::TPolygon2D poly(transf_shape);
+
+					// Get the range of cells that may collide with this shape:
+					const int ix_min = std::max(0,grid.x2idx(bb_min.x)-1);
+					const int iy_min = std::max(0,grid.y2idx(bb_min.y)-1);
+					const int ix_max = std::min(grid.x2idx(bb_max.x)+1,grid_cx_max);
+					const int iy_max = std::min(grid.y2idx(bb_max.y)+1,grid_cy_max);
+
+					for (int ix=ix_min;ix<ix_max;ix++)
+					{
+						const double cx = grid.idx2x(ix) - half_cell;
+
+						for (int iy=iy_min;iy<iy_max;iy++)
+						{
+							const double cy = grid.idx2y(iy) - half_cell;
+
+							if ( poly.contains( mrpt::math::TPoint2D(cx,cy) ) )
+							{
+								// Colision!! Update cell info:
+								const float d = ptg.getPathDist(k, n);
+								for (int dx=-1;dx<=0;dx++)
+								{
+									for (int dy=-1;dy<=0;dy++)
+									{
+										if (ix+dx<0 || iy+dy<0) continue;
+										const uint32_t idx = (ix+dx) + (iy+dy)*grid_cx;
+										if (cell_dist[idx]==std::numeric_limits<float>::max())
+											touched_cells.push_back(idx);
+										mrpt::utils::keep_min(cell_dist[idx], d);
+									}
+								}
+							}
+						}	// for iy
+					}	// for ix
+				} // n
+
+				// Save results for this path and reset the aux. buffer:
+				TCollidingCells &cells_k = collisions[k];
+				cells_k.resize(touched_cells.size());
+				for (size_t i=0;i<touched_cells.size();i++)
+				{
+					const uint32_t idx = touched_cells[i];
+					cells_k[i] = std::make_pair(idx, cell_dist[idx]);
+					cell_dist[idx] = std::numeric_limits<float>::max();
+				}
+				touched_cells.clear();
+			} // k
+		}
+	};
+}
+
 void CPTG_DiffDrive_CollisionGridBased::internal_initialize(const std::string & cacheFilename, const bool verbose)
 {
 	using namespace std;
@@ -651,7 +768,8 @@ void CPTG_DiffDrive_CollisionGridBased::internal_initialize(const std::string &
 	ASSERTMSG_(Ki>0, "The PTG seems to be not initialized!");
 
 	// Load the cached version, if possible
-	if ( loadColGridsFromFile( cacheFilename, m_robotShape ) )
+	const std::string cache_key = computeColGridCacheKey();
+	if ( loadColGridsFromFile( cacheFilename, cache_key ) )
 	{
 		if (verbose)
 			cout << "loaded from file OK" << endl;
@@ -661,78 +779,27 @@ void CPTG_DiffDrive_CollisionGridBased::internal_initialize(const std::string &
 		// BUGFIX: In case we start reading the file and in the end detected an error,
 		//         we must make sure that there's space enough for the grid:
 		m_collisionGrid.setSize( -refDistance,refDistance,-refDistance,refDistance,m_collisionGrid.getResolution());
-
-		const int grid_cx_max = m_collisionGrid.getSizeX()-1;
-		const int grid_cy_max = m_collisionGrid.getSizeY()-1;
-		const double half_cell = m_collisionGrid.getResolution()*0.5;
-
-		const size_t nVerts = m_robotShape.verticesCount();
-		std::vector<mrpt::math::TPoint2D> transf_shape(nVerts); // The robot shape at each location
+		m_collisionGrid.clear();
 
 		// RECOMPUTE THE COLLISION GRIDS:
 		// ---------------------------------------
-		for (size_t k=0;k<Ki;k++)
-		{
-			const size_t nPoints = getPathStepCount(k);
-			ASSERT_(nPoints>1)
-
-			for (size_t n=0;n<(nPoints-1);n++)
-			{
-				// Translate and rotate the robot shape at this C-Space pose:
-				mrpt::math::TPose2D p;
-				getPathPose(k, n, p);
-
-				mrpt::math::TPoint2D bb_min(std::numeric_limits<double>::max(),std::numeric_limits<double>::max());
-				mrpt::math::TPoint2D bb_max(-std::numeric_limits<double>::max(),-std::numeric_limits<double>::max());
+		// Each path "k" is checked in parallel, then results are merged in order of increasing "k":
+		std::vector<TCollidingCells> collisions(Ki);
+		TBuildCollisionGridBlock<CColisionGrid> builder(*this, m_collisionGrid, m_robotShape, collisions);
+		mrpt::system::parallelForBlocks(Ki, builder);
 
-				for (size_t m = 0;m<nVerts;m++)
-				{
-					transf_shape[m].x = p.x + cos(p.phi)*m_robotShape.GetVertex_x(m)-sin(p.phi)*m_robotShape.GetVertex_y(m);
-					transf_shape[m].y = p.y + sin(p.phi)*m_robotShape.GetVertex_x(m)+cos(p.phi)*m_robotShape.GetVertex_y(m);
-					mrpt::utils::keep_max( bb_max.x, transf_shape[m].x); mrpt::utils::keep_max( bb_max.y, transf_shape[m].y);
-					mrpt::utils::keep_min( bb_min.x, transf_shape[m].x); mrpt::utils::keep_min( bb_min.y, transf_shape[m].y);
-				}
-
-				// Robot shape polygon:
-				const mrpt::math::TPolygon2D poly(transf_shape);
-
-				// Get the range of cells that may collide with this shape:
-				const int ix_min = std::max(0,m_collisionGrid.x2idx(bb_min.x)-1);
-				const int iy_min = std::max(0,m_collisionGrid.y2idx(bb_min.y)-1);
-				const int ix_max = std::min(m_collisionGrid.x2idx(bb_max.x)+1,grid_cx_max);
-				const int iy_max = std::min(m_collisionGrid.y2idx(bb_max.y)+1,grid_cy_max);
-
-				for (int ix=ix_min;ix<ix_max;ix++)
-				{
-					const double cx = m_collisionGrid.idx2x(ix) - half_cell;
-
-					for (int iy=iy_min;iy<iy_max;iy++)
-					{
-						const double cy = m_collisionGrid.idx2y(iy) - half_cell;
+		const size_t grid_cx = m_collisionGrid.getSizeX();
+		for (size_t k=0;k<Ki;k++)
+			for (TCollidingCells::const_iterator it=collisions[k].begin();it!=collisions[k].end();++it)
+				m_collisionGrid.updateCellInfo(it->first % grid_cx, it->first / grid_cx, k, it->second);
 
-						if ( poly.contains( mrpt::math::TPoint2D(cx,cy) ) )
-						{
-							// Colision!! Update cell info:
-							const float d = this->getPathDist(k, n);
-							m_collisionGrid.updateCellInfo(ix  ,iy  ,  k,d);
-							m_collisionGrid.updateCellInfo(ix-1,iy  ,  k,d);
-							m_collisionGrid.updateCellInfo(ix  ,iy-1,  k,d);
-							m_collisionGrid.updateCellInfo(ix-1,iy-1,  k,d);
-						}
-					}	// for iy
-				}	// for ix
-
-			} // n
-
-			if (verbose)
-				cout << k << "/" << Ki << ",";
-		} // k
+		m_collisionGrid.buildCompactGrid();
 
 		if (verbose)
 			cout << format("Done! [%.03f sec]\n",tictac.Tac() );
 
 		// save it to the cache file for the next run:
-		saveColGridsToFile( cacheFilename, m_robotShape );
+		saveColGridsToFile( cacheFilename, cache_key );
 
 	}	// "else" recompute all PTG
 
@@ -789,10 +856,76 @@ void CPTG_DiffDrive_CollisionGridBased::updateTPObstacle(
 	std::vector<double> &tp_obstacles) const
 {
 	ASSERTMSG_(!m_trajectory.empty(), "PTG has not been initialized!");
-	const TCollisionCell & cell = m_collisionGrid.getTPObstacle(ox, oy);
+	const uint16_t *ks;
+	const float *dists;
+	const size_t nPairs = m_collisionGrid.getTPObstacleCompact(ox, oy, ks, dists);
 	// Keep the minimum distance:
-	for (TCollisionCell::const_iterator i = cell.begin(); i != cell.end(); ++i)
-		mrpt::utils::keep_min(tp_obstacles[i->first], i->second);
+	for (size_t i=0;i<nPairs;i++)
+		mrpt::utils::keep_min(tp_obstacles[ks[i]], dists[i]);
+}
+
+namespace
+{
+	/** Minimum number of obstacle points per thread in updateTPObstacles() */
+	const size_t MIN_POINTS_PER_THREAD = 4096;
+
+	/** Each block of points writes into its own copy of the TP-Obstacles, merged afterwards */
+	template <class GRID>
+	struct TUpdateTPObstaclesBlock
+	{
+		const GRID &grid;
+		const float *xs, *ys;
+		std::vector<std::vector<double> > &block_tp_obstacles;
+
+		TUpdateTPObstaclesBlock(const GRID &grid_, const float *xs_, const float *ys_, std::vector<std::vector<double> > &block_tp_obstacles_) :
+			grid(grid_), xs(xs_), ys(ys_), block_tp_obstacles(block_tp_obstacles_)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int block_index)
+		{
+			std::vector<double> &tp_obstacles = block_tp_obstacles[block_index];
+			for (size_t p=first;p<last;p++)
+			{
+				const uint16_t *ks;
+				const float *dists;
+				const size_t nPairs = grid.getTPObstacleCompact(xs[p], ys[p], ks, dists);
+				for (size_t i=0;i<nPairs;i++)
+					mrpt::utils::keep_min(tp_obstacles[ks[i]], dists[i]);
+			}
+		}
+	};
+}
+
+void CPTG_DiffDrive_CollisionGridBased::updateTPObstacles(
+	const size_t N, const float *xs, const float *ys,
+	std::vector<double> &tp_obstacles) const
+{
+	ASSERTMSG_(!m_trajectory.empty(), "PTG has not been initialized!");
+
+	const unsigned int nThreads = static_cast<unsigned int>( std::max<size_t>(1, std::min<size_t>( mrpt::system::getNumberOfProcessors(), N/MIN_POINTS_PER_THREAD) ) );
+
+	// Block #0 works directly on the output vector, the rest on copies of it:
+	std::vector<std::vector<double> > block_tp_obstacles(nThreads);
+	block_tp_obstacles[0].swap(tp_obstacles);
+	for (unsigned int b=1;b<nThreads;b++)
+		block_tp_obstacles[b] = block_tp_obstacles[0];
+
+	TUpdateTPObstaclesBlock<CColisionGrid> functor(m_collisionGrid, xs, ys, block_tp_obstacles);
+	try
+	{
+		mrpt::system::parallelForBlocks(N, functor, nThreads);
+	}
+	catch (...)
+	{
+		block_tp_obstacles[0].swap(tp_obstacles);
+		throw;
+	}
+
+	tp_obstacles.swap(block_tp_obstacles[0]);
+	const size_t Ki = tp_obstacles.size();
+	for (unsigned int b=1;b<nThreads;b++)
+		for (size_t k=0;k<Ki;k++)
+			mrpt::utils::keep_min(tp_obstacles[k], block_tp_obstacles[b][k]);
 }
 
 void CPTG_DiffDrive_CollisionGridBased::internal_readFromStream(mrpt::utils::CStream &in)
@@ -138,6 +138,12 @@ void CParameterizedTrajectoryGenerator::initTPObstacles(std::vector<double> &TP_
 	}
 }
 
+void CParameterizedTrajectoryGenerator::updateTPObstacles(const size_t N, const float *xs, const float *ys, std::vector<double> &tp_obstacles) const
+{
+	for (size_t i=0;i<N;i++)
+		this->updateTPObstacle(xs[i],ys[i], tp_obstacles);
+}
+
 bool CParameterizedTrajectoryGenerator::debugDumpInFiles( const std::string &ptg_name ) const
 {
 	using namespace mrpt::system;
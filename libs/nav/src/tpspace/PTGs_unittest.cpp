@@ -150,6 +150,28 @@ TEST(NavTests, PTGs_tests)
 			EXPECT_TRUE(any_change_all);
 		}
 
+		// TEST: batch TP_obstacles must match the one-by-one version
+		{
+			std::vector<float> xs, ys;
+			for (double ox=-refDist*0.5;ox<refDist*0.5;ox+=0.03)
+				for (double oy=-refDist*0.5;oy<refDist*0.5;oy+=0.03)
+				{
+					xs.push_back(ox);
+					ys.push_back(oy);
+				}
+
+			std::vector<double> TP_obstacles_one, TP_obstacles_batch;
+			ptg->initTPObstacles(TP_obstacles_one);
+			TP_obstacles_batch = TP_obstacles_one;
+
+			for (size_t i=0;i<xs.size();i++)
+				ptg->updateTPObstacle(xs[i],ys[i], TP_obstacles_one);
+			ptg->updateTPObstacles(xs.size(),&xs[0],&ys[0], TP_obstacles_batch);
+
+			EXPECT_TRUE(TP_obstacles_one==TP_obstacles_batch) << "PTG: " << sPTGDesc << endl;
+			num_tests_run++;
+		}
+
 
 		printf("PTG `%50s` run %6u tests.\n", sPTGDesc.c_str(), (unsigned int)num_tests_run );
 
@@ -73,6 +73,9 @@ namespace mrpt
 				MRPT_UNUSED_PARAM(obs);
 				return true; // Unless implemented otherwise, assume we can always compute the likelihood.
 			}
+			/** Internal method called by computeObservationLikelihoodForPoses(). By default, it calls internal_computeObservationLikelihood() once per pose:
+			  *  derived classes may override it with a faster implementation that evaluates all the poses at once. */
+			virtual void internal_computeObservationLikelihoodForPoses( const mrpt::obs::CObservation *obs, const std::vector<mrpt::math::TPose3D> &takenFrom, std::vector<double> &out_log_liks );
 
 			/** Hook for each time a "internal_insertObservation" returns "true"
 			  * This is called automatically from insertObservation() when internal_insertObservation returns true. */
@@ -129,6 +132,16 @@ namespace mrpt
 			/** \overload */
 			double	 computeObservationLikelihood( const mrpt::obs::CObservation *obs, const mrpt::poses::CPose2D &takenFrom );
 
+			/** Computes the log-likelihood of a given observation for each one of a set of robot poses, with the same result
+			 *  than computeObservationLikelihood() for each pose, but possibly much faster for maps which evaluate all the poses
+			 *  at once (e.g. the likelihood of all the particles of a particle filter).
+			 * \param obs The observation.
+			 * \param takenFrom The robot's poses the observation is supposed to be taken from.
+			 * \param out_log_liks The log-likelihood for each pose (resized to the number of poses).
+			 * \sa computeObservationLikelihood
+			 */
+			void computeObservationLikelihoodForPoses( const mrpt::obs::CObservation *obs, const std::vector<mrpt::math::TPose3D> &takenFrom, std::vector<double> &out_log_liks );
+
 			/** Returns true if this map is able to compute a sensible likelihood function for this observation (i.e. an occupancy grid map cannot with an image).
 			 * \param obs The observation.
 			 * \sa computeObservationLikelihood, genericMapParams.enableObservationLikelihood
@@ -204,3 +204,18 @@ double CMetricMap::computeObservationLikelihood( const mrpt::obs::CObservation *
 			return internal_computeObservationLikelihood(obs,takenFrom); 
 	else return false;
 }
+
+void CMetricMap::computeObservationLikelihoodForPoses( const mrpt::obs::CObservation *obs, const std::vector<TPose3D> &takenFrom, std::vector<double> &out_log_liks )
+{
+	if (genericMapParams.enableObservationLikelihood)
+			internal_computeObservationLikelihoodForPoses(obs,takenFrom,out_log_liks);
+	else out_log_liks.assign(takenFrom.size(), 0);
+}
+
+void CMetricMap::internal_computeObservationLikelihoodForPoses( const mrpt::obs::CObservation *obs, const std::vector<TPose3D> &takenFrom, std::vector<double> &out_log_liks )
+{
+	const size_t N = takenFrom.size();
+	out_log_liks.resize(N);
+	for (size_t i=0;i<N;i++)
+		out_log_liks[i] = internal_computeObservationLikelihood(obs,CPose3D(takenFrom[i]));
+}
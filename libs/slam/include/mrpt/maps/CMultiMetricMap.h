@@ -135,6 +135,8 @@ namespace maps
 		bool internal_canComputeObservationLikelihood( const mrpt::obs::CObservation *obs );
 		// See docs in base class
 		double	 internal_computeObservationLikelihood( const mrpt::obs::CObservation *obs, const mrpt::poses::CPose3D &takenFrom );
+		// See docs in base class
+		void internal_computeObservationLikelihoodForPoses( const mrpt::obs::CObservation *obs, const std::vector<mrpt::math::TPose3D> &takenFrom, std::vector<double> &out_log_liks ) MRPT_OVERRIDE;
 
 	public:
 		/** @name Access to internal list of maps: direct list, iterators, utility methods and proxies
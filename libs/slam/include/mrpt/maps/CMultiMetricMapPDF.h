@@ -156,6 +156,11 @@ namespace maps
 
 			mrpt::slam::CICP::TConfigParams		icp_params; //!< ICP parameters, used only when "PF_algorithm=2" in the particle filter.
 
+			/** Number of threads for the per-particle proposals, weight updates and map updates (0: one per core). Each thread draws from
+			  *  its own random generator, seeded from mrpt::random::randomGenerator, so results are repeatable for a given number of threads.
+			  *  Particles with beacon maps are always processed serially. (Default=1) */
+			unsigned int	num_threads;
+
 		} options;
 
 		/** Constructor
@@ -257,6 +262,8 @@ namespace maps
 
 			bool PF_SLAM_implementation_skipRobotMovement() const;
 
+			unsigned int PF_SLAM_implementation_numThreads() const;
+
 			/** Evaluate the observation likelihood for one particle at a given location */
 			double PF_SLAM_computeObservationLikelihoodForParticle(
 				const mrpt::bayes::CParticleFilter::TParticleFilterOptions	&PF_options,
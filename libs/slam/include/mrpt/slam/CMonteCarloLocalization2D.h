@@ -136,8 +136,24 @@ namespace mrpt
 				const size_t			particleIndexForMap,
 				const mrpt::obs::CSensoryFrame		&observation,
 				const mrpt::poses::CPose3D &x ) const;
+
+			/** Evaluates the observation likelihood for all the particles at once with CMetricMap::computeObservationLikelihoodForPoses(),
+			  *  if there is only one map for all the particles (TMonteCarloLocalizationParams::metricMap) */
+			bool PF_SLAM_computeObservationLikelihoodForAllParticles(
+				const mrpt::bayes::CParticleFilter::TParticleFilterOptions	&PF_options,
+				const mrpt::obs::CSensoryFrame		&observation,
+				std::vector<double>		&out_log_liks ) const;
+
+			/** Moves all the particles at once through a structure-of-arrays copy of their poses, with the increments drawn by
+			  *  CPoseRandomSampler::drawSamples() and a 2D pose composition loop over contiguous memory. */
+			bool PF_SLAM_implementation_moveAllParticles();
 			/** @} */
 
+		protected:
+			/** Structure-of-arrays buffers of all the particle poses (x,y,phi) and their increments, kept between
+			  *  iterations to avoid reallocations. \sa PF_SLAM_implementation_moveAllParticles */
+			std::vector<double> m_soa_x, m_soa_y, m_soa_phi, m_soa_incr_x, m_soa_incr_y, m_soa_incr_phi;
+
 
 		}; // End of class def.
 
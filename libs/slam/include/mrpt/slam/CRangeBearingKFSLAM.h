@@ -76,6 +76,8 @@ namespace mrpt
 			  *  \param out_landmarkIDs Each element[index] (for indices of out_landmarksPositions) gives the corresponding landmark ID.
 			  *  \param out_fullState The complete state vector (7+3M).
 			  *  \param out_fullCovariance The full (7+3M)x(7+3M) covariance matrix of the filter.
+			  * \note With the kfSEIF method, the full covariance is obtained by inverting the whole information matrix,
+			  *  which is O(M^3). Use getCurrentRobotPose() or getLandmarkCov() instead when only some marginals are needed.
 			  * \sa getCurrentRobotPose
 			  */
 			void  getCurrentState(
@@ -92,6 +94,8 @@ namespace mrpt
 			  *  \param out_landmarkIDs Each element[index] (for indices of out_landmarksPositions) gives the corresponding landmark ID.
 			  *  \param out_fullState The complete state vector (7+3M).
 			  *  \param out_fullCovariance The full (7+3M)x(7+3M) covariance matrix of the filter.
+			  * \note With the kfSEIF method, the full covariance is obtained by inverting the whole information matrix,
+			  *  which is O(M^3). Use getCurrentRobotPose() or getLandmarkCov() instead when only some marginals are needed.
 			  * \sa getCurrentRobotPose
 			  */
 			inline void  getCurrentState(
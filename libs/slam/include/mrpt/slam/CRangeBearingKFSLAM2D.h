@@ -67,6 +67,8 @@ namespace mrpt
 			  *  \param out_landmarkIDs Each element[index] (for indices of out_landmarksPositions) gives the corresponding landmark ID.
 			  *  \param out_fullState The complete state vector (3+2M).
 			  *  \param out_fullCovariance The full (3+2M)x(3+2M) covariance matrix of the filter.
+			  * \note With the kfSEIF method, the full covariance is obtained by inverting the whole information matrix,
+			  *  which is O(M^3). Use getCurrentRobotPose() or getLandmarkCov() instead when only some marginals are needed.
 			  * \sa getCurrentRobotPose
 			  */
 			void  getCurrentState(
@@ -63,6 +63,14 @@ namespace mrpt
 			  */
 			void RS_drawFromProposal( mrpt::poses::CPose2D &outSample );
 
+			/** Generates one sample with the given random generator (used by rejectionSamplingParallel()).
+			  */
+			void RS_drawFromProposal( mrpt::poses::CPose2D &outSample, mrpt::random::CRandomGenerator &rng );
+
+			/** The proposal and the likelihood only read the data set by setParams(), so samples can be drawn from several threads at once.
+			  */
+			bool RS_isThreadSafe() const { return true; }
+
 			/** Returns the NORMALIZED observation likelihood (linear, not exponential!!!) at a given point of the state space (values in the range [0,1]).
 			  */
 			double RS_observationLikelihood( const mrpt::poses::CPose2D &x);
@@ -11,6 +11,7 @@
 
 #include <mrpt/utils/utils_defs.h>
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 
@@ -26,6 +27,12 @@ namespace mrpt
 			using namespace mrpt::math;
 			using namespace std;
 
+			/** Combines the hash of a bin index into seed (as in boost::hash_combine) */
+			inline void KLD_hash_combine(size_t &seed, const int v)
+			{
+				seed ^= static_cast<size_t>(static_cast<unsigned int>(v)) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+			}
+
 			/** Auxiliary structure used in KLD-sampling in particle filters \sa CPosePDFParticles, CMultiMetricMapPDF */
 			struct SLAM_IMPEXP TPoseBin2D
 			{
@@ -45,6 +52,17 @@ namespace mrpt
 						return s1.phi<s2.phi;
 					}
 				};
+				/** Hash of bins for usage in hash containers (e.g. TKLDBinsHashSet) */
+				struct SLAM_IMPEXP hash_operator
+				{
+					inline size_t operator()(const TPoseBin2D& s) const
+					{
+						size_t h = 0;
+						KLD_hash_combine(h,s.x); KLD_hash_combine(h,s.y); KLD_hash_combine(h,s.phi);
+						return h;
+					}
+				};
+				inline bool operator==(const TPoseBin2D &o) const { return x==o.x && y==o.y && phi==o.phi; }
 			};
 
 			/** Auxiliary structure   */
@@ -71,6 +89,18 @@ namespace mrpt
 						return false; // If they're exactly equal, s1 is NOT < s2.
 					}
 				};
+				/** Hash of bins for usage in hash containers (e.g. TKLDBinsHashSet) */
+				struct SLAM_IMPEXP hash_operator
+				{
+					size_t operator()(const TPathBin2D& s) const
+					{
+						size_t h = 0;
+						for (size_t i=0;i<s.bins.size();i++)
+							KLD_hash_combine(h, static_cast<int>(TPoseBin2D::hash_operator()(s.bins[i])) );
+						return h;
+					}
+				};
+				bool operator==(const TPathBin2D &o) const { return bins==o.bins; }
 			};
 
 			/** Auxiliary structure used in KLD-sampling in particle filters \sa CPosePDFParticles, CMultiMetricMapPDF */
@@ -98,6 +128,93 @@ namespace mrpt
 						return s1.roll<s2.roll;
 					}
 				};
+				/** Hash of bins for usage in hash containers (e.g. TKLDBinsHashSet) */
+				struct SLAM_IMPEXP hash_operator
+				{
+					inline size_t operator()(const TPoseBin3D& s) const
+					{
+						size_t h = 0;
+						KLD_hash_combine(h,s.x); KLD_hash_combine(h,s.y); KLD_hash_combine(h,s.z);
+						KLD_hash_combine(h,s.yaw); KLD_hash_combine(h,s.pitch); KLD_hash_combine(h,s.roll);
+						return h;
+					}
+				};
+				inline bool operator==(const TPoseBin3D &o) const {
+					return x==o.x && y==o.y && z==o.z && yaw==o.yaw && pitch==o.pitch && roll==o.roll;
+				}
+			};
+
+			/** A set of KLD-sampling bins (TPoseBin2D, TPoseBin3D, TPathBin2D, or any type with `operator==` and a nested `hash_operator`),
+			  *  implemented as a hash table with open addressing (linear probing) which keeps its memory after clear(), so it can be reused
+			  *  for each iteration of a particle filter without allocations.
+			  *  Bins are identified by their index in order of insertion. \sa PF_implementation
+			  */
+			template <class BINTYPE>
+			class TKLDBinsHashSet
+			{
+			public:
+				TKLDBinsHashSet() : m_bins(), m_slots(), m_count(0) { }
+
+				/** Removes all the bins, keeping the allocated memory */
+				void clear()
+				{
+					std::fill(m_slots.begin(),m_slots.end(),0);
+					m_count = 0;
+				}
+				inline size_t size() const { return m_count; }
+				inline bool empty() const { return !m_count; }
+				/** The i'th bin, in order of insertion */
+				inline const BINTYPE & operator[](size_t i) const { return m_bins[i]; }
+
+				/** Inserts a bin, if it is not already in the set.
+				  * \param[out] is_new If not NULL, set to true if the bin was not in the set.
+				  * \return The index of the bin, in order of insertion.
+				  */
+				size_t insert(const BINTYPE &b, bool *is_new = NULL)
+				{
+					if (2*(m_count+1)>m_slots.size()) rehash( std::max<size_t>(64, 2*m_slots.size()) );
+					const size_t mask = m_slots.size()-1;
+					for (size_t i = hash(b) & mask; ; i=(i+1) & mask)
+					{
+						const size_t slot = m_slots[i];
+						if (!slot)
+						{
+							if (m_count<m_bins.size()) m_bins[m_count]=b;
+							else m_bins.push_back(b);
+							m_slots[i] = ++m_count;
+							if (is_new) *is_new = true;
+							return m_count-1;
+						}
+						if (m_bins[slot-1]==b)
+						{
+							if (is_new) *is_new = false;
+							return slot-1;
+						}
+					}
+				}
+
+			private:
+				std::vector<BINTYPE> m_bins;  //!< Bins, in order of insertion (only the first m_count are valid)
+				std::vector<size_t>  m_slots; //!< The hash table (size is a power of 2): 1-based indices in m_bins, or 0 for empty slots.
+				size_t m_count;
+
+				static inline size_t hash(const BINTYPE &b)
+				{
+					// Fibonacci hashing, to spread the bits of the hash over the table index:
+					const uint64_t h = static_cast<uint64_t>(typename BINTYPE::hash_operator()(b)) * 0x9E3779B97F4A7C15ULL;
+					return static_cast<size_t>(h ^ (h>>32));
+				}
+				void rehash(const size_t new_size)
+				{
+					m_slots.assign(new_size,0);
+					const size_t mask = new_size-1;
+					for (size_t k=0;k<m_count;k++)
+					{
+						size_t i = hash(m_bins[k]) & mask;
+						while (m_slots[i]) i=(i+1) & mask;
+						m_slots[i] = k+1;
+					}
+				}
 			};
 
 
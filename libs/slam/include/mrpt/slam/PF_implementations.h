@@ -150,7 +150,6 @@ namespace mrpt
 			const TKLDParams &KLD_options)
 		{
 			MRPT_START
-			typedef std::set<BINTYPE,typename BINTYPE::lt_operator> 	TSetStateSpaceBins;
 
 			MYSELF *me = static_cast<MYSELF*>(this);
 
@@ -191,15 +190,18 @@ namespace mrpt
 					// -------------------------------------------------------------
 					// FIXED SAMPLE SIZE
 					// -------------------------------------------------------------
-					CPose3D incrPose;
-					for (size_t i=0;i<M;i++)
+					if (!PF_SLAM_implementation_moveAllParticles())
 					{
-						// Generate gaussian-distributed 2D-pose increments according to mean-cov:
-						m_movementDrawer.drawSample( incrPose );
-						CPose3D finalPose = CPose3D(*getLastPose(i)) + incrPose;
+						CPose3D incrPose;
+						for (size_t i=0;i<M;i++)
+						{
+							// Generate gaussian-distributed 2D-pose increments according to mean-cov:
+							m_movementDrawer.drawSample( incrPose );
+							CPose3D finalPose = CPose3D(*getLastPose(i)) + incrPose;
 
-						// Update the particle with the new pose: this part is caller-dependant and must be implemented there:
-						PF_SLAM_implementation_custom_update_particle_with_new_pose( me->m_particles[i].d, TPose3D(finalPose) );
+							// Update the particle with the new pose: this part is caller-dependant and must be implemented there:
+							PF_SLAM_implementation_custom_update_particle_with_new_pose( me->m_particles[i].d, TPose3D(finalPose) );
+						}
 					}
 				}
 				else
@@ -210,7 +212,8 @@ namespace mrpt
 					//  31-Oct-2006 (JLBC): First version
 					//  19-Jan-2009 (JLBC): Rewriten within a generic template
 					// -------------------------------------------------------------
-					TSetStateSpaceBins stateSpaceBins;
+					detail::TKLDBinsHashSet<BINTYPE> &stateSpaceBins = PF_SLAM_aux_getKLDBins(static_cast<BINTYPE*>(NULL))[0];
+					stateSpaceBins.clear();
 
 					size_t Nx = KLD_options.KLD_minSampleSize;
 					const double delta_1 = 1.0 - KLD_options.KLD_delta;
@@ -225,41 +228,49 @@ namespace mrpt
 					std::vector<size_t>   newParticlesDerivedFromIdx;
 
 					CPose3D	 increment_i;
-					size_t N = 1;
+					size_t N = 0;
+					std::vector<size_t> drawn_idxs;
 
 					do	// THE MAIN DRAW SAMPLING LOOP
 					{
-						// Draw a robot movement increment:
-						m_movementDrawer.drawSample( increment_i );
+						// The desired number of particles can only grow as new bins are found, so all the samples up to
+						//  the current desired number will be drawn anyway: draw their indices at once.
+						const size_t N_target = std::min<size_t>( max(Nx,(size_t)KLD_options.KLD_minSampleSize), KLD_options.KLD_maxSampleSize );
+						me->fastDrawSamples(PF_options, std::max<size_t>(1,N_target-N), drawn_idxs);
+
+						newParticles.reserve(N+drawn_idxs.size());
+						newParticlesWeight.resize(N+drawn_idxs.size(), 0);
+						newParticlesDerivedFromIdx.insert(newParticlesDerivedFromIdx.end(), drawn_idxs.begin(),drawn_idxs.end());
 
-						// generate the new particle:
-						const size_t drawn_idx = me->fastDrawSample(PF_options);
-						const mrpt::poses::CPose3D newPose = CPose3D(*getLastPose(drawn_idx)) + increment_i;
-						const TPose3D newPose_s = newPose;
+						for (size_t i=0;i<drawn_idxs.size();i++)
+						{
+							const size_t drawn_idx = drawn_idxs[i];
 
-						// Add to the new particles list:
-						newParticles.push_back( newPose_s );
-						newParticlesWeight.push_back(0);
-						newParticlesDerivedFromIdx.push_back(drawn_idx);
+							// Draw a robot movement increment and generate the new particle:
+							m_movementDrawer.drawSample( increment_i );
+							const mrpt::poses::CPose3D newPose = CPose3D(*getLastPose(drawn_idx)) + increment_i;
+							const TPose3D newPose_s = newPose;
 
-						// Now, look if the particle falls in a new bin or not:
-						// --------------------------------------------------------
-						BINTYPE	p;
-						KLF_loadBinFromParticle<PARTICLE_TYPE,BINTYPE>(p,KLD_options, me->m_particles[drawn_idx].d, &newPose_s);
+							// Add to the new particles list:
+							newParticles.push_back( newPose_s );
 
-						if (stateSpaceBins.find( p )==stateSpaceBins.end())
-						{
-							// It falls into a new bin:
-							// Add to the stateSpaceBins:
-							stateSpaceBins.insert( p );
+							// Now, look if the particle falls in a new bin or not:
+							// --------------------------------------------------------
+							BINTYPE	p;
+							KLF_loadBinFromParticle<PARTICLE_TYPE,BINTYPE>(p,KLD_options, me->m_particles[drawn_idx].d, &newPose_s);
 
-							// K = K + 1
-							size_t	K = stateSpaceBins.size();
-							if ( K>1) //&& newParticles.size() > options.KLD_minSampleSize )
+							bool is_new_bin;
+							stateSpaceBins.insert(p, &is_new_bin);
+							if (is_new_bin)
 							{
-								// Update the number of m_particles!!
-								Nx =  round(epsilon_1 * math::chi2inv(delta_1,K-1));
-								//printf("k=%u \tn=%u \tNx:%u\n", k, newParticles.size(), Nx);
+								// It falls into a new bin: K = K + 1
+								const size_t K = stateSpaceBins.size();
+								if ( K>1) //&& newParticles.size() > options.KLD_minSampleSize )
+								{
+									// Update the number of m_particles!!
+									Nx =  round(epsilon_1 * math::chi2inv(delta_1,K-1));
+									//printf("k=%u \tn=%u \tNx:%u\n", k, newParticles.size(), Nx);
+								}
 							}
 						}
 						N = newParticles.size();
@@ -280,17 +291,21 @@ namespace mrpt
 
 			if (sf)
 			{
-				const size_t M = me->m_particles.size();
 				//	UPDATE STAGE
 				// ----------------------------------------------------------------------
 				// Compute all the likelihood values & update particles weight:
-				for (size_t i=0;i<M;i++)
+				std::vector<double> obs_log_likelihoods;
+				if (PF_SLAM_computeObservationLikelihoodForAllParticles(PF_options,*sf,obs_log_likelihoods))
+				{
+					ASSERT_(obs_log_likelihoods.size()==me->m_particles.size())
+					for (size_t i=0;i<me->m_particles.size();i++)
+						me->m_particles[i].log_w += obs_log_likelihoods[i] * PF_options.powFactor;
+				}
+				else
 				{
-					const TPose3D  *partPose= getLastPose(i); // Take the particle data:
-					CPose3D  partPose2 = CPose3D(*partPose);
-					const double obs_log_likelihood = PF_SLAM_computeObservationLikelihoodForParticle(PF_options,i,*sf,partPose2);
-					me->m_particles[i].log_w += obs_log_likelihood * PF_options.powFactor;
-				} // for each particle "i"
+					TWeightsUpdater updater(*me,PF_options,*sf);
+					PF_SLAM_aux_parallelForParticles(me->m_particles.size(), updater);
+				}
 
 				// Normalization of weights is done outside of this method automatically.
 			}
@@ -332,60 +347,14 @@ namespace mrpt
 			const void				*action,
 			const void				*observation )
 		{
-			MRPT_UNUSED_PARAM(action);
 			MRPT_START
 
-			//const PF_implementation<PARTICLE_TYPE,MYSELF> *myObj = reinterpret_cast<const PF_implementation<PARTICLE_TYPE,MYSELF>*>( obj );
 			const MYSELF *me = static_cast<const MYSELF*>(obj);
-
-			// Compute the quantity:
-			//     w[i]*p(zt|z^{t-1},x^{[i],t-1})
-			// As the Monte-Carlo approximation of the integral over all posible $x_t$.
-			// --------------------------------------------
-			double  indivLik, maxLik= -1e300;
-			CPose3D maxLikDraw;
-			size_t  N = PF_options.pfAuxFilterOptimal_MaximumSearchSamples;
-			ASSERT_(N>1)
-
-			const mrpt::poses::CPose3D oldPose = *me->getLastPose(index);
-			CVectorDouble   vectLiks(N,0);		// The vector with the individual log-likelihoods.
-			CPose3D			drawnSample;
-			for (size_t q=0;q<N;q++)
-			{
-				me->m_movementDrawer.drawSample(drawnSample);
-				CPose3D	x_predict = oldPose + drawnSample;
-
-				// Estimate the mean...
-				indivLik = me->PF_SLAM_computeObservationLikelihoodForParticle(
-					PF_options,
-					index,
-					*static_cast<const mrpt::obs::CSensoryFrame*>(observation),
-					x_predict );
-
-				MRPT_CHECK_NORMAL_NUMBER(indivLik);
-				vectLiks[q] = indivLik;
-				if ( indivLik > maxLik )
-				{	// Keep the maximum value:
-					maxLikDraw	= drawnSample;
-					maxLik		= indivLik;
-				}
-			}
-
-			// This is done to avoid floating point overflow!!
-			//      average_lik    =      \sum(e^liks)   * e^maxLik  /     N
-			// log( average_lik  ) = log( \sum(e^liks) ) + maxLik   - log( N )
-			double avrgLogLik = math::averageLogLikelihood( vectLiks );
-
-			// Save into the object:
-			me->m_pfAuxiliaryPFOptimal_estimatedProb[index] = avrgLogLik; // log( accum / N );
-			me->m_pfAuxiliaryPFOptimal_maxLikelihood[index] = maxLik;
-
-			if (PF_options.pfAuxFilterOptimal_MLE)
-				me->m_pfAuxiliaryPFOptimal_maxLikDrawnMovement[index] = maxLikDraw;
-
-			// and compute the resulting probability of this particle:
-			// ------------------------------------------------------------
-			return me->m_particles[index].log_w + me->m_pfAuxiliaryPFOptimal_estimatedProb[index];
+			return me->template PF_SLAM_aux_evaluateParticle<BINTYPE>(
+				true, PF_options, index,
+				action ? *static_cast<const CPose3D*>(action) : CPose3D(), // Not used
+				*static_cast<const mrpt::obs::CSensoryFrame*>(observation),
+				mrpt::random::randomGenerator );
 
 			MRPT_END
 		} // end of PF_SLAM_particlesEvaluator_AuxPFOptimal
@@ -408,32 +377,48 @@ namespace mrpt
 		{
 			MRPT_START
 
-			//const PF_implementation<PARTICLE_TYPE,MYSELF> *myObj = reinterpret_cast<const PF_implementation<PARTICLE_TYPE,MYSELF>*>( obj );
 			const MYSELF *myObj = static_cast<const MYSELF*>(obj);
+			return myObj->template PF_SLAM_aux_evaluateParticle<BINTYPE>(
+				false, PF_options, index,
+				*static_cast<const CPose3D*>(action),
+				*static_cast<const mrpt::obs::CSensoryFrame*>(observation),
+				mrpt::random::randomGenerator );
+
+			MRPT_END
+		}
+
+		template <class PARTICLE_TYPE,class MYSELF>
+		template <class BINTYPE>
+		double PF_implementation<PARTICLE_TYPE,MYSELF>::PF_SLAM_aux_evaluateParticle(
+			const bool USE_OPTIMAL_SAMPLING,
+			const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options,
+			size_t index,
+			const mrpt::poses::CPose3D &meanRobotMovement,
+			const mrpt::obs::CSensoryFrame &observation,
+			mrpt::random::CRandomGenerator &rng ) const
+		{
+			MRPT_START
+
+			const MYSELF *me = static_cast<const MYSELF*>(this);
 
 			// Take the previous particle weight:
-			const double cur_logweight = myObj->m_particles[index].log_w;
-			const mrpt::poses::CPose3D oldPose = *myObj->getLastPose(index);
+			const double cur_logweight = me->m_particles[index].log_w;
+			const mrpt::poses::CPose3D oldPose = *me->getLastPose(index);
 
-			if (!PF_options.pfAuxFilterStandard_FirstStageWeightsMonteCarlo)
+			mrpt::math::CVectorDouble &estimatedProb = USE_OPTIMAL_SAMPLING ? m_pfAuxiliaryPFOptimal_estimatedProb : m_pfAuxiliaryPFStandard_estimatedProb;
+
+			if (!USE_OPTIMAL_SAMPLING && !PF_options.pfAuxFilterStandard_FirstStageWeightsMonteCarlo)
 			{
-				// Just use the mean:
-				// , take the mean of the posterior density:
+				// APF: Just use the mean of the posterior density:
 				CPose3D	 x_predict;
-				x_predict.composeFrom( oldPose, *static_cast<const CPose3D*>(action) );
+				x_predict.composeFrom( oldPose, meanRobotMovement );
 
 				// and compute the obs. likelihood:
 				// --------------------------------------------
-				myObj->m_pfAuxiliaryPFStandard_estimatedProb[index] = myObj->PF_SLAM_computeObservationLikelihoodForParticle(
-					PF_options, index,
-					*static_cast<const mrpt::obs::CSensoryFrame*>(observation), x_predict );
-
-				// Combined log_likelihood: Previous weight * obs_likelihood:
-				return cur_logweight + myObj->m_pfAuxiliaryPFStandard_estimatedProb[index];
+				estimatedProb[index] = me->PF_SLAM_computeObservationLikelihoodForParticle(PF_options, index, observation, x_predict );
 			}
 			else
 			{
-				// Do something similar to in Optimal sampling:
 				// Compute the quantity:
 				//     w[i]*p(zt|z^{t-1},x^{[i],t-1})
 				// As the Monte-Carlo approximation of the integral over all posible $x_t$.
@@ -444,18 +429,14 @@ namespace mrpt
 				ASSERT_(N>1)
 
 				CVectorDouble   vectLiks(N,0);		// The vector with the individual log-likelihoods.
-				CPose3D		drawnSample;
+				CPose3D			drawnSample;
 				for (size_t q=0;q<N;q++)
 				{
-					myObj->m_movementDrawer.drawSample(drawnSample);
+					m_movementDrawer.drawSample(drawnSample,rng);
 					CPose3D	x_predict = oldPose + drawnSample;
 
 					// Estimate the mean...
-					indivLik = myObj->PF_SLAM_computeObservationLikelihoodForParticle(
-						PF_options,
-						index,
-						*static_cast<const mrpt::obs::CSensoryFrame*>(observation),
-						x_predict );
+					indivLik = me->PF_SLAM_computeObservationLikelihoodForParticle(PF_options, index, observation, x_predict );
 
 					MRPT_CHECK_NORMAL_NUMBER(indivLik);
 					vectLiks[q] = indivLik;
@@ -469,22 +450,126 @@ namespace mrpt
 				// This is done to avoid floating point overflow!!
 				//      average_lik    =      \sum(e^liks)   * e^maxLik  /     N
 				// log( average_lik  ) = log( \sum(e^liks) ) + maxLik   - log( N )
-				double avrgLogLik = math::averageLogLikelihood( vectLiks );
+				estimatedProb[index] = math::averageLogLikelihood( vectLiks );
 
 				// Save into the object:
-				myObj->m_pfAuxiliaryPFStandard_estimatedProb[index] = avrgLogLik; // log( accum / N );
-
-				myObj->m_pfAuxiliaryPFOptimal_maxLikelihood[index] = maxLik;
+				m_pfAuxiliaryPFOptimal_maxLikelihood[index] = maxLik;
 				if (PF_options.pfAuxFilterOptimal_MLE)
-					myObj->m_pfAuxiliaryPFOptimal_maxLikDrawnMovement[index] = maxLikDraw;
-
-				// and compute the resulting probability of this particle:
-				// ------------------------------------------------------------
-				return cur_logweight + myObj->m_pfAuxiliaryPFOptimal_estimatedProb[index];
+					m_pfAuxiliaryPFOptimal_maxLikDrawnMovement[index] = maxLikDraw;
 			}
+
+			// and compute the resulting probability of this particle:
+			// ------------------------------------------------------------
+			return cur_logweight + estimatedProb[index];
+
 			MRPT_END
 		}
 
+		template <class PARTICLE_TYPE,class MYSELF>
+		double PF_implementation<PARTICLE_TYPE,MYSELF>::PF_SLAM_particlesEvaluator_precomputed(
+			const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options,
+			const mrpt::bayes::CParticleFilterCapable	*obj,
+			size_t					index,
+			const void				*action,
+			const void				*observation )
+		{
+			MRPT_UNUSED_PARAM(PF_options); MRPT_UNUSED_PARAM(obj); MRPT_UNUSED_PARAM(action);
+			return (*static_cast<const std::vector<double>*>(observation))[index];
+		}
+
+		/** Updates the weights of a block of particles with the likelihood of an observation */
+		template <class PARTICLE_TYPE,class MYSELF>
+		struct PF_implementation<PARTICLE_TYPE,MYSELF>::TWeightsUpdater
+		{
+			MYSELF &me;
+			const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options;
+			const mrpt::obs::CSensoryFrame &sf;
+
+			TWeightsUpdater(MYSELF &me_, const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options_, const mrpt::obs::CSensoryFrame &sf_) :
+				me(me_), PF_options(PF_options_), sf(sf_) { }
+
+			void operator()(size_t first, size_t last, mrpt::random::CRandomGenerator &)
+			{
+				for (size_t i=first;i<last;i++)
+				{
+					const CPose3D partPose = CPose3D(*me.getLastPose(i)); // Take the particle data:
+					const double obs_log_likelihood = me.PF_SLAM_computeObservationLikelihoodForParticle(PF_options,i,sf,partPose);
+					me.m_particles[i].log_w += obs_log_likelihood * PF_options.powFactor;
+				}
+			}
+		};
+
+		/** Evaluates a block of particles for the first stage of the APF and optimal-APF */
+		template <class PARTICLE_TYPE,class MYSELF>
+		template <class BINTYPE>
+		struct PF_implementation<PARTICLE_TYPE,MYSELF>::TAuxPFEvaluator
+		{
+			const PF_implementation<PARTICLE_TYPE,MYSELF> &pf;
+			const bool USE_OPTIMAL_SAMPLING;
+			const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options;
+			const mrpt::poses::CPose3D &meanRobotMovement;
+			const mrpt::obs::CSensoryFrame &sf;
+			std::vector<double> &out_values;
+
+			TAuxPFEvaluator(const PF_implementation<PARTICLE_TYPE,MYSELF> &pf_, const bool USE_OPTIMAL_SAMPLING_,
+				const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options_, const mrpt::poses::CPose3D &meanRobotMovement_,
+				const mrpt::obs::CSensoryFrame &sf_, std::vector<double> &out_values_) :
+				pf(pf_), USE_OPTIMAL_SAMPLING(USE_OPTIMAL_SAMPLING_), PF_options(PF_options_), meanRobotMovement(meanRobotMovement_), sf(sf_), out_values(out_values_) { }
+
+			void operator()(size_t first, size_t last, mrpt::random::CRandomGenerator &rng)
+			{
+				for (size_t i=first;i<last;i++)
+					out_values[i] = pf.template PF_SLAM_aux_evaluateParticle<BINTYPE>(USE_OPTIMAL_SAMPLING,PF_options,i,meanRobotMovement,sf,rng);
+			}
+		};
+
+		/** Draws the new particles of a block of groups, each group being the new particles coming from the same old particle
+		  *  (thus, from the same map, which is only used from one thread) */
+		template <class PARTICLE_TYPE,class MYSELF>
+		template <class BINTYPE>
+		struct PF_implementation<PARTICLE_TYPE,MYSELF>::TRejectionSampler
+		{
+			PF_implementation<PARTICLE_TYPE,MYSELF> &pf;
+			const bool USE_OPTIMAL_SAMPLING, doResample;
+			const double maxMeanLik;
+			const mrpt::obs::CSensoryFrame *sf;
+			const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options;
+			const std::vector<vector_size_t> &groups;    //!< Indices of the new particles of each group
+			const std::vector<size_t> &derivedFromIdx;   //!< The old particle of each new particle
+			std::vector<TPose3D> &out_newParticles;
+			std::vector<double> &out_newParticlesWeight;
+			std::vector<uint8_t> &out_timeout;
+
+			TRejectionSampler(PF_implementation<PARTICLE_TYPE,MYSELF> &pf_, const bool USE_OPTIMAL_SAMPLING_, const bool doResample_, const double maxMeanLik_,
+				const mrpt::obs::CSensoryFrame *sf_, const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options_,
+				const std::vector<vector_size_t> &groups_, const std::vector<size_t> &derivedFromIdx_,
+				std::vector<TPose3D> &out_newParticles_, std::vector<double> &out_newParticlesWeight_, std::vector<uint8_t> &out_timeout_) :
+				pf(pf_), USE_OPTIMAL_SAMPLING(USE_OPTIMAL_SAMPLING_), doResample(doResample_), maxMeanLik(maxMeanLik_), sf(sf_), PF_options(PF_options_),
+				groups(groups_), derivedFromIdx(derivedFromIdx_), out_newParticles(out_newParticles_), out_newParticlesWeight(out_newParticlesWeight_), out_timeout(out_timeout_) { }
+
+			void operator()(size_t first, size_t last, mrpt::random::CRandomGenerator &rng)
+			{
+				for (size_t g=first;g<last;g++)
+				{
+					for (size_t j=0;j<groups[g].size();j++)
+					{
+						const size_t i = groups[g][j];
+						CPose3D  newPose;
+						double   newParticleLogWeight;
+						if (!pf.template PF_SLAM_aux_perform_one_rejection_sampling_step<BINTYPE>(
+								USE_OPTIMAL_SAMPLING,doResample,maxMeanLik,
+								derivedFromIdx[i],
+								sf,PF_options,
+								newPose, newParticleLogWeight, rng))
+							out_timeout[i] = 1;
+
+						out_newParticles[i] = newPose;
+						out_newParticlesWeight[i] = newParticleLogWeight;
+					}
+				}
+			}
+		};
+
 		// USE_OPTIMAL_SAMPLING:
 		//   true -> PF_SLAM_implementation_pfAuxiliaryPFOptimal
 		//  false -> PF_SLAM_implementation_pfAuxiliaryPFStandard
@@ -498,7 +583,6 @@ namespace mrpt
 			const bool USE_OPTIMAL_SAMPLING  )
 		{
 			MRPT_START
-			typedef std::set<BINTYPE,typename BINTYPE::lt_operator> 	TSetStateSpaceBins;
 
 			MYSELF *me = static_cast<MYSELF*>(this);
 
@@ -532,16 +616,19 @@ namespace mrpt
 			CPose3D meanRobotMovement;
 			m_movementDrawer.getSamplingMean3D(meanRobotMovement);
 
-			// Prepare data for executing "fastDrawSample"
+			// Prepare data for executing "fastDrawSample", evaluating the particles in parallel
+			//  (as PF_SLAM_particlesEvaluator_AuxPFOptimal / PF_SLAM_particlesEvaluator_AuxPFStandard would do):
+			std::vector<double> particlesEvaluation(M);
+			{
+				TAuxPFEvaluator<BINTYPE> evaluator(*this,USE_OPTIMAL_SAMPLING,PF_options,meanRobotMovement,*sf,particlesEvaluation);
+				PF_SLAM_aux_parallelForParticles(M,evaluator);
+			}
 			typedef PF_implementation<PARTICLE_TYPE,MYSELF> TMyClass; // Use this longer declaration to avoid errors in old GCC.
-			CParticleFilterCapable::TParticleProbabilityEvaluator funcOpt = &TMyClass::template PF_SLAM_particlesEvaluator_AuxPFOptimal<BINTYPE>;
-			CParticleFilterCapable::TParticleProbabilityEvaluator funcStd = &TMyClass::template PF_SLAM_particlesEvaluator_AuxPFStandard<BINTYPE>;
-
 			me->prepareFastDrawSample(
 				PF_options,
-				USE_OPTIMAL_SAMPLING ? funcOpt : funcStd,
-				&meanRobotMovement,
-				sf );
+				&TMyClass::PF_SLAM_particlesEvaluator_precomputed,
+				NULL,
+				&particlesEvaluation );
 
 			// For USE_OPTIMAL_SAMPLING=1,  m_pfAuxiliaryPFOptimal_maxLikelihood is now computed.
 
@@ -593,33 +680,41 @@ namespace mrpt
 
 				const bool doResample = me->ESS() < PF_options.BETA;
 
-				for (size_t i=0;i<M;i++)
+				// Generate the new particles:
+				//   (a) Draw a "t-1" m_particles' index for each one:
+				// ----------------------------------------------------------------
+				std::vector<vector_size_t> groups; // The new particles coming from each old particle
 				{
-					size_t k;
-
-					// Generate a new particle:
-					//   (a) Draw a "t-1" m_particles' index:
-					// ----------------------------------------------------------------
-					if (doResample)
-							k = me->fastDrawSample(PF_options);		// Based on weights of last step only!
-					else	k = i;
-
-					// Do one rejection sampling step:
-					// ---------------------------------------------
-					CPose3D		newPose;
-					double		newParticleLogWeight;
-					PF_SLAM_aux_perform_one_rejection_sampling_step<BINTYPE>(
-						USE_OPTIMAL_SAMPLING,doResample,maxMeanLik,
-						k,
-						sf,PF_options,
-						newPose, newParticleLogWeight);
+					const size_t NO_GROUP = static_cast<size_t>(-1);
+					std::vector<size_t> groupOfOldParticle(M, NO_GROUP);
+					for (size_t i=0;i<M;i++)
+					{
+						size_t k;
+						if (doResample)
+								k = me->fastDrawSample(PF_options);		// Based on weights of last step only!
+						else	k = i;
+						k = PF_SLAM_aux_skipUnlikelyParticle(USE_OPTIMAL_SAMPLING,maxMeanLik,k,PF_options);
+						newParticlesDerivedFromIdx[i] = k;
+
+						if (groupOfOldParticle[k]==NO_GROUP)
+						{
+							groupOfOldParticle[k] = groups.size();
+							groups.push_back(vector_size_t());
+						}
+						groups[groupOfOldParticle[k]].push_back(i);
+					}
+				}
 
-					// Insert the new particle
-					newParticles[i] = newPose;
-					newParticlesDerivedFromIdx[i] = k;
-					newParticlesWeight[i] = newParticleLogWeight;
+				//   (b) Do one rejection sampling step for each one. The new particles coming from the same old one
+				//       are processed in sequence, since they share (and update) its map and max. likelihood:
+				// ----------------------------------------------------------------
+				std::vector<uint8_t> timeouts(M,0);
+				TRejectionSampler<BINTYPE> sampler(*this,USE_OPTIMAL_SAMPLING,doResample,maxMeanLik,sf,PF_options,groups,newParticlesDerivedFromIdx,newParticles,newParticlesWeight,timeouts);
+				PF_SLAM_aux_parallelForParticles(groups.size(),sampler);
 
-				} // for i
+				const size_t nTimeouts = std::count(timeouts.begin(),timeouts.end(),1);
+				if (nTimeouts)
+					me->logStr(mrpt::utils::LVL_WARN, mrpt::format("[PF_implementation] Warning: timeout in rejection sampling (%u particles).",static_cast<unsigned int>(nTimeouts)) );
 			} // end fixed sample size
 			else
 			{
@@ -641,7 +736,8 @@ namespace mrpt
 				//      //of corresponding m_particles (in the last timestep), in "stateSpaceBinsLastTimestepParticles"
 				//  - Added JLBC (01/DEC/2006)
 				// ------------------------------------------------------------------------------
-				TSetStateSpaceBins 			stateSpaceBinsLastTimestep;
+				detail::TKLDBinsHashSet<BINTYPE> &stateSpaceBinsLastTimestep = PF_SLAM_aux_getKLDBins(static_cast<BINTYPE*>(NULL))[1];
+				stateSpaceBinsLastTimestep.clear();
 				std::vector<vector_uint>	stateSpaceBinsLastTimestepParticles;
 				typename MYSELF::CParticleList::iterator		partIt;
 				unsigned int	partIndex;
@@ -654,15 +750,14 @@ namespace mrpt
 					KLF_loadBinFromParticle<PARTICLE_TYPE,BINTYPE>(p, KLD_options,partIt->d );
 
 					// Is it a new bin?
-					typename TSetStateSpaceBins::iterator posFound=stateSpaceBinsLastTimestep.find(p);
-					if ( posFound == stateSpaceBinsLastTimestep.end() )
+					bool is_new_bin;
+					const size_t idx = stateSpaceBinsLastTimestep.insert(p, &is_new_bin);
+					if ( is_new_bin )
 					{	// Yes, create a new pair <bin,index_list> in the list:
-						stateSpaceBinsLastTimestep.insert( p );
 						stateSpaceBinsLastTimestepParticles.push_back( vector_uint(1,partIndex) );
 					}
 					else
 					{ // No, add the particle's index to the existing entry:
-						const size_t idx = std::distance(stateSpaceBinsLastTimestep.begin(),posFound);
 						stateSpaceBinsLastTimestepParticles[idx].push_back( partIndex );
 					}
 				}
@@ -698,7 +793,8 @@ namespace mrpt
 				size_t k = 0;
 				size_t N = 0;
 
-				TSetStateSpaceBins		stateSpaceBins;
+				detail::TKLDBinsHashSet<BINTYPE> &stateSpaceBins = PF_SLAM_aux_getKLDBins(static_cast<BINTYPE*>(NULL))[0];
+				stateSpaceBins.clear();
 
 				do // "N" is the index of the current "new particle":
 				{
@@ -755,13 +851,15 @@ namespace mrpt
 
 					// Do one rejection sampling step:
 					// ---------------------------------------------
+					k = PF_SLAM_aux_skipUnlikelyParticle(USE_OPTIMAL_SAMPLING,maxMeanLik,k,PF_options);
 					CPose3D		newPose;
 					double		newParticleLogWeight;
-					PF_SLAM_aux_perform_one_rejection_sampling_step<BINTYPE>(
+					if (!PF_SLAM_aux_perform_one_rejection_sampling_step<BINTYPE>(
 						USE_OPTIMAL_SAMPLING,doResample,maxMeanLik,
 						k,
 						sf,PF_options,
-						newPose, newParticleLogWeight);
+						newPose, newParticleLogWeight, mrpt::random::randomGenerator))
+						me->logStr(mrpt::utils::LVL_WARN, "[PF_implementation] Warning: timeout in rejection sampling.");
 
 					// Insert the new particle
 					newParticles.push_back( newPose );
@@ -781,14 +879,13 @@ namespace mrpt
 					//  then we may increase the desired particle number:
 					// -----------------------------------------------------------------------------
 
-					// Found?
-					if ( stateSpaceBins.find(p)==stateSpaceBins.end() )
+					// Found? (otherwise, it is added to the stateSpaceBins)
+					bool is_new_bin;
+					stateSpaceBins.insert(p, &is_new_bin);
+					if ( is_new_bin )
 					{
-						// It falls into a new bin: add to the stateSpaceBins:
-						stateSpaceBins.insert( p );
-
-						// K = K + 1
-						int K = stateSpaceBins.size();
+						// It falls into a new bin: K = K + 1
+						const size_t K = stateSpaceBins.size();
 						if ( K>1 )
 						{
 							// Update the number of m_particles!!
@@ -825,21 +922,16 @@ namespace mrpt
 
 
 		/* ------------------------------------------------------------------------
-							PF_SLAM_aux_perform_one_rejection_sampling_step
+							PF_SLAM_aux_skipUnlikelyParticle
 		   ------------------------------------------------------------------------ */
 		template <class PARTICLE_TYPE,class MYSELF>
-		template <class BINTYPE>
-		void PF_implementation<PARTICLE_TYPE,MYSELF>::PF_SLAM_aux_perform_one_rejection_sampling_step(
+		size_t PF_implementation<PARTICLE_TYPE,MYSELF>::PF_SLAM_aux_skipUnlikelyParticle(
 			const bool		USE_OPTIMAL_SAMPLING,
-			const bool		doResample,
 			const double	maxMeanLik,
-			size_t    k, // The particle from the old set "m_particles[]"
-			const mrpt::obs::CSensoryFrame		* sf,
-			const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options,
-			mrpt::poses::CPose3D			& out_newPose,
-			double			& out_newParticleLogWeight)
+			size_t    k,
+			const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options) const
 		{
-			MYSELF *me = static_cast<MYSELF*>(this);
+			const MYSELF *me = static_cast<const MYSELF*>(this);
 
 			// ADD-ON: If the 'm_pfAuxiliaryPFOptimal_estimatedProb[k]' is **extremelly** low relative to the other m_particles,
 			//  resample only this particle with a copy of another one, uniformly:
@@ -848,8 +940,30 @@ namespace mrpt
 			{
 				// Select another 'k' uniformly:
 				k = mrpt::random::randomGenerator.drawUniform32bit() % me->m_particles.size();
-				me->logStr(mrpt::utils::LVL_DEBUG, "[PF_SLAM_aux_perform_one_rejection_sampling_step] Warning: Discarding very unlikely particle.");
+				me->logStr(mrpt::utils::LVL_DEBUG, "[PF_SLAM_aux_skipUnlikelyParticle] Warning: Discarding very unlikely particle.");
 			}
+			return k;
+		}
+
+		/* ------------------------------------------------------------------------
+							PF_SLAM_aux_perform_one_rejection_sampling_step
+		   ------------------------------------------------------------------------ */
+		template <class PARTICLE_TYPE,class MYSELF>
+		template <class BINTYPE>
+		bool PF_implementation<PARTICLE_TYPE,MYSELF>::PF_SLAM_aux_perform_one_rejection_sampling_step(
+			const bool		USE_OPTIMAL_SAMPLING,
+			const bool		doResample,
+			const double	maxMeanLik,
+			size_t    k, // The particle from the old set "m_particles[]"
+			const mrpt::obs::CSensoryFrame		* sf,
+			const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options,
+			mrpt::poses::CPose3D			& out_newPose,
+			double			& out_newParticleLogWeight,
+			mrpt::random::CRandomGenerator &rng)
+		{
+			MRPT_UNUSED_PARAM(maxMeanLik);
+			MYSELF *me = static_cast<MYSELF*>(this);
+			bool no_timeout = true;
 
 			const mrpt::poses::CPose3D oldPose = *getLastPose(k);	// Get the current pose of the k'th particle
 
@@ -869,7 +983,7 @@ namespace mrpt
 				CPose3D	movementDraw;
 				if (!USE_OPTIMAL_SAMPLING)
 				{	// APF:
-					m_movementDrawer.drawSample( movementDraw );
+					m_movementDrawer.drawSample( movementDraw, rng );
 					out_newPose.composeFrom(oldPose, movementDraw); // newPose = oldPose + movementDraw;
 					// Compute likelihood:
 					poseLogLik = PF_SLAM_computeObservationLikelihoodForParticle(PF_options, k,*sf,out_newPose);
@@ -893,7 +1007,7 @@ namespace mrpt
 						else
 						{
 							// Draw new robot pose:
-							m_movementDrawer.drawSample( movementDraw );
+							m_movementDrawer.drawSample( movementDraw, rng );
 						}
 
 						out_newPose.composeFrom(oldPose, movementDraw); // out_newPose = oldPose + movementDraw;
@@ -915,13 +1029,13 @@ namespace mrpt
 							m_pfAuxiliaryPFOptimal_maxLikelihood[k] = poseLogLik; //  :'-( !!!
 							//acceptanceProb = 0;		// Keep searching or keep this one?
 						}
-					} while ( ++timeout<maxTries && acceptanceProb < mrpt::random::randomGenerator.drawUniform(0.0,0.999) );
+					} while ( ++timeout<maxTries && acceptanceProb < rng.drawUniform(0.0,0.999) );
 
 					if (timeout>=maxTries)
 					{
 						out_newPose = bestTryByNow_pose;
 						poseLogLik = bestTryByNow_loglik;
-						me->logStr(mrpt::utils::LVL_WARN, "[PF_implementation] Warning: timeout in rejection sampling.");
+						no_timeout = false;
 					}
 				}
 
@@ -946,6 +1060,7 @@ namespace mrpt
 
 			}
 			// Done.
+			return no_timeout;
 		} // end PF_SLAM_aux_perform_one_rejection_sampling_step
 
 
@@ -16,8 +16,11 @@
 #include <mrpt/poses/CPose3D.h>
 #include <mrpt/poses/CPose3DPDFGaussian.h>
 #include <mrpt/poses/CPoseRandomSampler.h>
+#include <mrpt/random/RandomGenerators.h>
 #include <mrpt/slam/TKLDParams.h>
+#include <mrpt/slam/PF_aux_structs.h>
 #include <mrpt/utils/COutputLogger.h>
+#include <mrpt/system/threads.h>  // parallelForBlocks()
 
 #include <mrpt/slam/link_pragmas.h>
 
@@ -34,6 +37,25 @@ namespace mrpt
 			const mrpt::math::TPose3D		*newPoseToBeInserted = NULL );
 
 
+		namespace detail
+		{
+			/** Auxiliary for PF_implementation::PF_SLAM_aux_parallelForParticles(): runs each block of indices with the random generator of its thread */
+			template <class FUNCTOR>
+			struct TParticlesBlockRunner
+			{
+				FUNCTOR &functor;
+				std::vector<mrpt::random::CRandomGenerator> &rngs;
+				const size_t offset;
+
+				TParticlesBlockRunner(FUNCTOR &functor_, std::vector<mrpt::random::CRandomGenerator> &rngs_, size_t offset_) :
+					functor(functor_), rngs(rngs_), offset(offset_) { }
+
+				void operator()(size_t first, size_t last, unsigned int block_index) {
+					functor(first+offset,last+offset,rngs[block_index]);
+				}
+			};
+		}
+
 		/** A set of common data shared by PF implementations for both SLAM and localization
 		  *   \ingroup mrpt_slam_grp
 		  */
@@ -62,7 +84,13 @@ namespace mrpt
 			mutable mrpt::math::CVectorDouble			m_pfAuxiliaryPFStandard_estimatedProb;	//!< Auxiliary variable used in the "pfAuxiliaryPFStandard" algorithm.
 			mutable mrpt::math::CVectorDouble			m_pfAuxiliaryPFOptimal_maxLikelihood;						//!< Auxiliary variable used in the "pfAuxiliaryPFOptimal" algorithm.
 			mutable std::vector<mrpt::math::TPose3D>	m_pfAuxiliaryPFOptimal_maxLikDrawnMovement;		//!< Auxiliary variable used in the "pfAuxiliaryPFOptimal" algorithm.
-			std::vector<bool>				m_pfAuxiliaryPFOptimal_maxLikMovementDrawHasBeenUsed;
+			std::vector<uint8_t>			m_pfAuxiliaryPFOptimal_maxLikMovementDrawHasBeenUsed; //!< Not a vector<bool>, since different entries are written from different threads.
+
+			/** Sets of KLD-sampling bins of the new particles ([0]) and of the particles of the previous time step ([1]), kept between
+			  *  iterations to reuse their memory. \sa PF_SLAM_aux_getKLDBins */
+			detail::TKLDBinsHashSet<detail::TPoseBin2D>	m_KLD_bins2D[2];
+			detail::TKLDBinsHashSet<detail::TPoseBin3D>	m_KLD_bins3D[2];
+			detail::TKLDBinsHashSet<detail::TPathBin2D>	m_KLD_binsPath2D[2];
 
 			/**  Compute w[i]*p(z_t | mu_t^i), with mu_t^i being
 			  *    the mean of the new robot pose
@@ -86,6 +114,25 @@ namespace mrpt
 				const void				*action,
 				const void				*observation );
 
+			/** The common body of PF_SLAM_particlesEvaluator_AuxPFOptimal() and PF_SLAM_particlesEvaluator_AuxPFStandard(), drawing
+			  *  the random samples from the given generator. */
+			template <class BINTYPE> // Template arg. actually not used, just to allow giving the definition in another file later on
+			double PF_SLAM_aux_evaluateParticle(
+				const bool USE_OPTIMAL_SAMPLING,
+				const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options,
+				size_t index,
+				const mrpt::poses::CPose3D &meanRobotMovement,
+				const mrpt::obs::CSensoryFrame &observation,
+				mrpt::random::CRandomGenerator &rng ) const;
+
+			/** Calls `functor(first,last,rng)` for blocks of the indices [0,N) (typically, particles) from PF_SLAM_implementation_numThreads() threads,
+			  *  each one with its own random generator `rng`, seeded from mrpt::random::randomGenerator.
+			  *  The index 0 is processed alone before the rest, so any data lazily built and shared by all the particles (e.g. the points
+			  *  cached by range scans) is ready before going parallel. With one thread, `functor(0,N,mrpt::random::randomGenerator)` is called.
+			  */
+			template <class FUNCTOR>
+			void PF_SLAM_aux_parallelForParticles(const size_t N, FUNCTOR &functor) const;
+
 			/** @} */
 
 			/** \name The generic PF implementations for localization & SLAM.
@@ -240,6 +287,21 @@ namespace mrpt
 				return false; // By default, always allow the robot to move!
 			}
 
+			/** Make a specialization to move all the particles at once with increments drawn from m_movementDrawer (used in
+			  *  the standard proposal with a fixed sample size), e.g. with a faster implementation for a particular kind of particles.
+			  * \return false if not implemented (default), so each particle is moved with PF_SLAM_implementation_custom_update_particle_with_new_pose */
+			virtual bool PF_SLAM_implementation_moveAllParticles()
+			{
+				return false;
+			}
+
+			/** The number of threads for the loops over particles (default: 1). Return more than one only if the likelihood
+			  *  of different particles can be evaluated concurrently, e.g. when each particle has its own map (RBPF).  */
+			virtual unsigned int PF_SLAM_implementation_numThreads() const
+			{
+				return 1;
+			}
+
 			/** Evaluate the observation likelihood for one particle at a given location */
 			virtual double PF_SLAM_computeObservationLikelihoodForParticle(
 				const mrpt::bayes::CParticleFilter::TParticleFilterOptions	&PF_options,
@@ -247,6 +309,19 @@ namespace mrpt
 				const mrpt::obs::CSensoryFrame		&observation,
 				const mrpt::poses::CPose3D			&x )  const = 0;
 
+			/** Make a specialization to evaluate the observation likelihood for all the particles at once (used in the update stage
+			  *  of the standard proposal), e.g. with mrpt::maps::CMetricMap::computeObservationLikelihoodForPoses().
+			  * \param out_log_liks The log-likelihood for each particle, as PF_SLAM_computeObservationLikelihoodForParticle() would return.
+			  * \return false if not implemented (default), so PF_SLAM_computeObservationLikelihoodForParticle() is called for each particle */
+			virtual bool PF_SLAM_computeObservationLikelihoodForAllParticles(
+				const mrpt::bayes::CParticleFilter::TParticleFilterOptions	&PF_options,
+				const mrpt::obs::CSensoryFrame		&observation,
+				std::vector<double>		&out_log_liks ) const
+			{
+				MRPT_UNUSED_PARAM(PF_options); MRPT_UNUSED_PARAM(observation); MRPT_UNUSED_PARAM(out_log_liks);
+				return false;
+			}
+
 			/** @} */
 
 
@@ -270,8 +345,9 @@ namespace mrpt
 				const TKLDParams &KLD_options,
 				const bool USE_OPTIMAL_SAMPLING  );
 
+			/** \return false on timeout of the rejection sampling */
 			template <class BINTYPE>
-			void PF_SLAM_aux_perform_one_rejection_sampling_step(
+			bool PF_SLAM_aux_perform_one_rejection_sampling_step(
 				const bool		USE_OPTIMAL_SAMPLING,
 				const bool		doResample,
 				const double	maxMeanLik,
@@ -279,10 +355,59 @@ namespace mrpt
 				const mrpt::obs::CSensoryFrame		* sf,
 				const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options,
 				mrpt::poses::CPose3D			& out_newPose,
-				double			& out_newParticleLogWeight);
+				double			& out_newParticleLogWeight,
+				mrpt::random::CRandomGenerator &rng);
+
+			/** If the estimated likelihood of the k'th particle is extremely low relative to the others, returns another particle drawn uniformly instead. */
+			size_t PF_SLAM_aux_skipUnlikelyParticle(
+				const bool		USE_OPTIMAL_SAMPLING,
+				const double	maxMeanLik,
+				size_t    k,
+				const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options) const;
+
+			/** Evaluator for prepareFastDrawSample() returning the values precomputed in the `std::vector<double>` passed as "observation" */
+			static double PF_SLAM_particlesEvaluator_precomputed(
+				const mrpt::bayes::CParticleFilter::TParticleFilterOptions &PF_options,
+				const mrpt::bayes::CParticleFilterCapable	*obj,
+				size_t					index,
+				const void				*action,
+				const void				*observation );
+
+			/** The two sets of KLD-sampling bins for each BINTYPE, called as `PF_SLAM_aux_getKLDBins(static_cast<BINTYPE*>(NULL))` */
+			detail::TKLDBinsHashSet<detail::TPoseBin2D> * PF_SLAM_aux_getKLDBins(const detail::TPoseBin2D *) { return m_KLD_bins2D; }
+			detail::TKLDBinsHashSet<detail::TPoseBin3D> * PF_SLAM_aux_getKLDBins(const detail::TPoseBin3D *) { return m_KLD_bins3D; }
+			detail::TKLDBinsHashSet<detail::TPathBin2D> * PF_SLAM_aux_getKLDBins(const detail::TPathBin2D *) { return m_KLD_binsPath2D; }
+
+			// Functors for PF_SLAM_aux_parallelForParticles(), defined in PF_implementations.h
+			struct TWeightsUpdater;
+			template <class BINTYPE> struct TAuxPFEvaluator;
+			template <class BINTYPE> struct TRejectionSampler;
 
 
 		}; // end PF_implementation
+
+		template <class PARTICLE_TYPE,class MYSELF>
+		template <class FUNCTOR>
+		void PF_implementation<PARTICLE_TYPE,MYSELF>::PF_SLAM_aux_parallelForParticles(const size_t N, FUNCTOR &functor) const
+		{
+			const unsigned int nThreads = static_cast<unsigned int>( std::min<size_t>(N-1, PF_SLAM_implementation_numThreads()) );
+			if (N<2 || nThreads<=1)
+			{
+				if (N) functor(0,N,mrpt::random::randomGenerator);
+				return;
+			}
+
+			// The first particle alone, then the rest in parallel:
+			functor(0,1,mrpt::random::randomGenerator);
+
+			std::vector<mrpt::random::CRandomGenerator> rngs;
+			rngs.reserve(nThreads);
+			for (unsigned int i=0;i<nThreads;i++)
+				rngs.push_back( mrpt::random::CRandomGenerator(mrpt::random::randomGenerator.drawUniform32bit()) );
+
+			detail::TParticlesBlockRunner<FUNCTOR> runner(functor,rngs,1);
+			mrpt::system::parallelForBlocks(N-1, runner, nThreads);
+		}
 	}
 }
 
@@ -109,6 +109,12 @@ namespace mrpt
 		  * \param chi2quantile [IN, optional] The threshold for considering a match between two close Gaussians for two landmarks, in the range [0,1]. It is used to call mrpt::math::chi2inv
 		  * \param use_kd_tree [IN, optional] Build a KD-tree to speed-up the evaluation of individual compatibility (IC). It's perhaps more efficient to disable it for a small number of features. (default=true).
 		  * \param predictions_IDs [IN, optional] (default:none) An N-vector. If provided, the resulting associations in "results.associations" will not contain prediction indices "i", but "predictions_IDs[i]".
+		  * \param num_threads [IN, optional] (default:1) Number of threads for the individual compatibility tests and the JCBB search (0: one per core). The results do not depend on it.
+		  *
+		  * The Cholesky factorization of the covariance of each prediction is computed once and reused for all the observations. With the KD-tree,
+		  *  only the predictions within a conservative Euclidean gate (derived from the chi2 or matching likelihood threshold and the largest
+		  *  prediction covariance) of each observation are evaluated. JCBB extends the Cholesky factorization of the joint covariance incrementally,
+		  *  one pairing at a time.
 		  *
 		  * \sa data_association_independent_predictions, data_association_independent_2d_points, data_association_independent_3d_points
 		  */
@@ -123,7 +129,8 @@ namespace mrpt
 			const bool							DAT_ASOC_USE_KDTREE = true,
 			const std::vector<prediction_index_t>		&predictions_IDs = std::vector<prediction_index_t>(),
 			const TDataAssociationMetric		compatibilityTestMetric  = metricMaha,
-			const double						log_ML_compat_test_threshold = 0.0
+			const double						log_ML_compat_test_threshold = 0.0,
+			const unsigned int					num_threads = 1
 			);
 
 		/** Computes the data-association between the prediction of a set of landmarks and their observations, all of them with covariance matrices - Generic version with NO prediction cross-covariances.
@@ -142,6 +149,7 @@ namespace mrpt
 		  * \param chi2quantile [IN, optional] The threshold for considering a match between two close Gaussians for two landmarks, in the range [0,1]. It is used to call mrpt::math::chi2inv
 		  * \param use_kd_tree [IN, optional] Build a KD-tree to speed-up the evaluation of individual compatibility (IC). It's perhaps more efficient to disable it for a small number of features. (default=true).
 		  * \param predictions_IDs [IN, optional] (default:none) An N-vector. If provided, the resulting associations in "results.associations" will not contain prediction indices "i", but "predictions_IDs[i]".
+		  * \param num_threads [IN, optional] (default:1) Number of threads for the individual compatibility tests and the JCBB search (0: one per core).
 		  *
 		  * \sa data_association_full_covariance, data_association_independent_2d_points, data_association_independent_3d_points
 		  */
@@ -156,7 +164,8 @@ namespace mrpt
 			const bool							DAT_ASOC_USE_KDTREE = true,
 			const std::vector<prediction_index_t>	&predictions_IDs = std::vector<prediction_index_t>(),
 			const TDataAssociationMetric		compatibilityTestMetric = metricMaha,
-			const double						log_ML_compat_test_threshold = 0.0
+			const double						log_ML_compat_test_threshold = 0.0,
+			const unsigned int					num_threads = 1
 			);
 
 
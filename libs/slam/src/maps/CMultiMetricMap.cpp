@@ -20,6 +20,7 @@ using namespace mrpt::maps;
 using namespace mrpt::utils;
 using namespace mrpt::poses;
 using namespace mrpt::obs;
+using namespace mrpt::math;
 using namespace mrpt::utils::metaprogramming;
 
 IMPLEMENTS_SERIALIZABLE( CMultiMetricMap, CMetricMap, mrpt::maps )
@@ -84,6 +85,30 @@ struct MapComputeLikelihood
 
 }; // end of MapComputeLikelihood
 
+struct MapComputeLikelihoodForPoses
+{
+	const CObservation             * obs;
+	const std::vector<TPose3D>     & takenFrom;
+	std::vector<double>            & total_log_liks;
+	std::vector<double>            & map_log_liks;
+
+	MapComputeLikelihoodForPoses(const CMultiMetricMap &m,const CObservation * _obs, const std::vector<TPose3D> & _takenFrom, std::vector<double> & _total_log_liks, std::vector<double> & _map_log_liks) :
+		obs(_obs), takenFrom(_takenFrom),
+		total_log_liks(_total_log_liks),
+		map_log_liks(_map_log_liks)
+	{
+		total_log_liks.assign(takenFrom.size(),0);
+	}
+
+	template <typename PTR>
+	inline void operator()(PTR &ptr) {
+		ptr->computeObservationLikelihoodForPoses(obs,takenFrom,map_log_liks);
+		for (size_t i=0;i<total_log_liks.size();i++)
+			total_log_liks[i]+=map_log_liks[i];
+	}
+
+}; // end of MapComputeLikelihoodForPoses
+
 struct MapCanComputeLikelihood
 {
 	const CObservation    * obs;
@@ -353,6 +378,20 @@ double	 CMultiMetricMap::internal_computeObservationLikelihood(
 	return ret_log_lik;
 }
 
+void CMultiMetricMap::internal_computeObservationLikelihoodForPoses(
+			const CObservation		*obs,
+			const std::vector<TPose3D> &takenFrom,
+			std::vector<double>		&out_log_liks )
+{
+	std::vector<double> map_log_liks;
+	MapComputeLikelihoodForPoses op_likelihood(*this,obs,takenFrom,out_log_liks,map_log_liks);
+
+	MapExecutor::run(*this,op_likelihood);
+
+	for (size_t i=0;i<out_log_liks.size();i++)
+		MRPT_CHECK_NORMAL_NUMBER(out_log_liks[i]);
+}
+
 // Read docs in base class
 bool CMultiMetricMap::internal_canComputeObservationLikelihood( const CObservation *obs )
 {
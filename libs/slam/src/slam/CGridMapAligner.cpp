@@ -960,14 +960,15 @@ CPosePDFPtr CGridMapAligner::AlignPDF_correlation(
 		CPoint2D	v1,v3;
 		v2 = CPose2D(0,0,0) - v2;	// Inverse
 
+		std::vector<COccupancyGridMap2D::cellType> row(map2_lx);
 		for (unsigned int cy2=0;cy2<map2_ly;cy2++)
 		{
-			COccupancyGridMap2D::cellType	*row = map2_mod.getRow(cy2);
 			for (unsigned int cx2=0;cx2<map2_lx;cx2++)
 			{
 				v3 = v2 + CPoint2D( map2_mod.idx2x(cx2), map2_mod.idx2y(cy2) );
-				*row++ = m2->p2l( m2->getPos( v3.x(),v3.y() ) );
+				row[cx2] = m2->p2l( m2->getPos( v3.x(),v3.y() ) );
 			}
+			map2_mod.setRow(cy2,&row[0]);
 		}
 
 		map2_mod.getAsImage( map2_img );
@@ -0,0 +1,181 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/slam/CMetricMapBuilderRBPF.h>
+#include <mrpt/maps/CMultiMetricMap.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/obs/CRawlog.h>
+#include <mrpt/utils/CFileGZInputStream.h>
+#include <mrpt/system/filesystem.h>
+#include <mrpt/math/utils.h>
+#include <mrpt/math/wrap2pi.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::bayes;
+using namespace mrpt::slam;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::utils;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::random;
+using namespace std;
+
+// Defined in tests/test_main.cpp
+namespace mrpt { namespace utils {
+	extern std::string MRPT_GLOBAL_UNITTEST_SRC_DIR;
+  }
+}
+
+namespace
+{
+	const size_t NUM_STEPS = 60;  // Action-observation pairs taken from the dataset
+
+	struct TRBPFResult
+	{
+		CPose3D                 mean_pose;
+		std::vector<double>     log_ws;
+		COccupancyGridMap2D     grid;  // Of the most likely particle
+	};
+
+	// A short grid-mapping run of the first NUM_STEPS entries of the dataset, with the given number of threads.
+	// Returns false if the dataset is not available.
+	bool run_rbpf(CParticleFilter::TParticleFilterAlgorithm pf_algorithm, unsigned int num_threads, TRBPFResult &res)
+	{
+		const string rawlog_file = MRPT_GLOBAL_UNITTEST_SRC_DIR + string("/share/mrpt/datasets/2006-01ENE-21-SENA_Telecom Faculty_one_loop_only.rawlog");
+		if (!mrpt::system::fileExists(rawlog_file))
+		{
+			cerr << "WARNING: Skipping test due to missing file: " << rawlog_file << "\n";
+			return false;
+		}
+
+		randomGenerator.randomize(1234);
+
+		CMetricMapBuilderRBPF::TConstructionOptions  rbpfOptions;
+		{
+			COccupancyGridMap2D::TMapDefinition def;
+			def.resolution = 0.05f;
+			def.insertionOpts.maxOccupancyUpdateCertainty = 0.8f;
+			def.likelihoodOpts.likelihoodMethod = COccupancyGridMap2D::lmLikelihoodField_Thrun;
+			def.likelihoodOpts.LF_decimation = 5;
+			rbpfOptions.mapsInitializers.push_back( def );
+		}
+		rbpfOptions.insertionLinDistance = 0.5;
+		rbpfOptions.insertionAngDistance = DEG2RAD(30);
+		rbpfOptions.localizeLinDistance  = 0.5;
+		rbpfOptions.localizeAngDistance  = DEG2RAD(30);
+
+		rbpfOptions.PF_options.sampleSize = 20;
+		rbpfOptions.PF_options.PF_algorithm = pf_algorithm;
+		rbpfOptions.PF_options.pfAuxFilterOptimal_MaximumSearchSamples = 50;
+
+		rbpfOptions.predictionOptions.pfOptimalProposal_mapSelection = 0;
+		rbpfOptions.predictionOptions.num_threads = num_threads;
+
+		CMetricMapBuilderRBPF mapBuilder( rbpfOptions );
+		mapBuilder.setVerbosityLevel( mrpt::utils::LVL_ERROR );
+		mapBuilder.mapPDF.setVerbosityLevel( mrpt::utils::LVL_ERROR );
+		mapBuilder.initialize( CSimpleMap() );
+		mapBuilder.options.enableMapUpdating = true;
+
+		CFileGZInputStream rawlogFile( rawlog_file );
+		size_t rawlogEntry = 0;
+		CActionCollectionPtr action;
+		CSensoryFramePtr     observations;
+		for (size_t step=0;step<NUM_STEPS;step++)
+		{
+			if (!CRawlog::readActionObservationPair( rawlogFile, action, observations, rawlogEntry) )
+				break;
+			mapBuilder.processActionObservation( *action, *observations );
+		}
+
+		mapBuilder.getCurrentPoseEstimation()->getMean(res.mean_pose);
+		res.log_ws.clear();
+		for (size_t i=0;i<mapBuilder.mapPDF.particlesCount();i++)
+			res.log_ws.push_back( mapBuilder.mapPDF.getW(i) );
+
+		const CMultiMetricMap *mmap = mapBuilder.getCurrentlyBuiltMetricMap();
+		EXPECT_TRUE( mmap && mmap->m_gridMaps.size()==1 );
+		if (mmap && !mmap->m_gridMaps.empty())
+			res.grid = *mmap->m_gridMaps[0];
+		return true;
+	}
+
+	// Fraction of the occupied cells of "a" which are also occupied in "b", up to one cell away
+	double occupied_cells_in_common(const COccupancyGridMap2D &a, const COccupancyGridMap2D &b)
+	{
+		size_t nOcc = 0, nCommon = 0;
+		for (unsigned int cy=0;cy<a.getSizeY();cy++)
+			for (unsigned int cx=0;cx<a.getSizeX();cx++)
+			{
+				if (a.getCell(cx,cy)>0.3f) continue;  // Not occupied
+				nOcc++;
+				const int bx = b.x2idx(a.idx2x(cx)), by = b.y2idx(a.idx2y(cy));
+				bool found = false;
+				for (int dy=-1;dy<=1 && !found;dy++)
+					for (int dx=-1;dx<=1 && !found;dx++)
+					{
+						const int x = bx+dx, y = by+dy;
+						found = x>=0 && y>=0 && x<int(b.getSizeX()) && y<int(b.getSizeY()) && b.getCell(x,y)<=0.3f;
+					}
+				if (found) nCommon++;
+			}
+		return nOcc ? double(nCommon)/nOcc : 0;
+	}
+
+	void expect_valid_result(const TRBPFResult &r, const std::string &msg)
+	{
+		ASSERT_EQ(r.log_ws.size(), 20u) << msg;
+		for (size_t i=0;i<r.log_ws.size();i++)
+			EXPECT_TRUE( mrpt::math::isFinite(r.log_ws[i]) ) << msg << " particle=" << i;
+		for (int k=0;k<6;k++)
+			EXPECT_TRUE( mrpt::math::isFinite(r.mean_pose[k]) ) << msg;
+
+		size_t nOcc = 0;
+		for (unsigned int cy=0;cy<r.grid.getSizeY();cy++)
+			for (unsigned int cx=0;cx<r.grid.getSizeX();cx++)
+				if (r.grid.getCell(cx,cy)<=0.3f) nOcc++;
+		EXPECT_GT(nOcc, 500u) << msg << ": the map is (nearly) empty";
+	}
+
+	// Runs with 1 and 4 threads must give maps and poses as close as runs with 1 thread and different seeds:
+	//  "max_dist" and "min_common" are bounds of that spread, which is larger for the APF than for the ICP-based optimal proposal.
+	void test_rbpf_threads(CParticleFilter::TParticleFilterAlgorithm pf_algorithm, double max_dist, double min_common)
+	{
+		TRBPFResult r1, rN, rN_again;
+		if (!run_rbpf(pf_algorithm,1,r1)) return;
+		run_rbpf(pf_algorithm,4,rN);
+		run_rbpf(pf_algorithm,4,rN_again);
+
+		expect_valid_result(r1,"1 thread");
+		expect_valid_result(rN,"4 threads");
+
+		// Repeatable for a given number of threads:
+		EXPECT_EQ(rN.mean_pose, rN_again.mean_pose);
+		EXPECT_EQ(rN.log_ws, rN_again.log_ws);
+
+		// Each thread draws from its own generator, so the runs differ in their random samples only:
+		EXPECT_LT(r1.mean_pose.distanceTo(rN.mean_pose), max_dist) << "1 thread: " << r1.mean_pose << " 4 threads: " << rN.mean_pose;
+		EXPECT_LT(std::abs(mrpt::math::wrapToPi(r1.mean_pose.yaw()-rN.mean_pose.yaw())), DEG2RAD(5));
+		EXPECT_GT(occupied_cells_in_common(r1.grid,rN.grid), min_common);
+		EXPECT_GT(occupied_cells_in_common(rN.grid,r1.grid), min_common);
+	}
+}
+
+TEST(CMetricMapBuilderRBPF, OptimalProposalEquivalentResultsWithThreads)
+{
+	test_rbpf_threads(CParticleFilter::pfOptimalProposal, 0.2, 0.8);
+}
+
+TEST(CMetricMapBuilderRBPF, AuxiliaryPFOptimalEquivalentResultsWithThreads)
+{
+	test_rbpf_threads(CParticleFilter::pfAuxiliaryPFOptimal, 0.5, 0.4);
+}
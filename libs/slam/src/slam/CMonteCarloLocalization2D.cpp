@@ -17,6 +17,7 @@
 #include <mrpt/obs/CSensoryFrame.h>
 
 #include <mrpt/random.h>
+#include <mrpt/math/wrap2pi.h>
 
 #include <mrpt/slam/PF_aux_structs.h>
 
@@ -194,6 +195,35 @@ double CMonteCarloLocalization2D::PF_SLAM_computeObservationLikelihoodForParticl
 	return ret;
 }
 
+/*---------------------------------------------------------------
+			PF_SLAM_computeObservationLikelihoodForAllParticles
+ ---------------------------------------------------------------*/
+bool CMonteCarloLocalization2D::PF_SLAM_computeObservationLikelihoodForAllParticles(
+	const CParticleFilter::TParticleFilterOptions	&PF_options,
+	const CSensoryFrame		&observation,
+	std::vector<double>		&out_log_liks ) const
+{
+	MRPT_UNUSED_PARAM(PF_options);
+	if (!options.metricMap)
+		return false; // One map per particle: evaluate them one by one
+
+	const size_t M = m_particles.size();
+	std::vector<TPose3D> poses(M);
+	for (size_t i=0;i<M;i++)
+		poses[i] = TPose3D( TPose2D(*m_particles[i].d) );
+
+	// For each observation:
+	out_log_liks.assign(M, 1);
+	std::vector<double> obs_log_liks;
+	for (CSensoryFrame::const_iterator it=observation.begin();it!=observation.end();++it)
+	{
+		options.metricMap->computeObservationLikelihoodForPoses( it->pointer(), poses, obs_log_liks );
+		for (size_t i=0;i<M;i++)
+			out_log_liks[i] += obs_log_liks[i];
+	}
+	return true;
+}
+
 // Specialization for my kind of particles:
 void CMonteCarloLocalization2D::PF_SLAM_implementation_custom_update_particle_with_new_pose(
 	CPose2D *particleData,
@@ -202,6 +232,47 @@ void CMonteCarloLocalization2D::PF_SLAM_implementation_custom_update_particle_wi
 	*particleData = CPose2D( TPose2D(newPose) );
 }
 
+bool CMonteCarloLocalization2D::PF_SLAM_implementation_moveAllParticles()
+{
+	const size_t M = m_particles.size();
+	if (!M) return true;
+
+	// Gather the poses into contiguous arrays:
+	m_soa_x.resize(M);
+	m_soa_y.resize(M);
+	m_soa_phi.resize(M);
+	for (size_t i=0;i<M;i++)
+	{
+		const CPose2D &p = *m_particles[i].d;
+		m_soa_x[i] = p.x();
+		m_soa_y[i] = p.y();
+		m_soa_phi[i] = p.phi();
+	}
+
+	// Draw all the increments at once:
+	m_movementDrawer.drawSamples(M, m_soa_incr_x,m_soa_incr_y,m_soa_incr_phi, randomGenerator);
+
+	// Pose composition: p_i = p_i (+) incr_i
+	double *x = &m_soa_x[0], *y = &m_soa_y[0], *phi = &m_soa_phi[0];
+	const double *dx = &m_soa_incr_x[0], *dy = &m_soa_incr_y[0], *dphi = &m_soa_incr_phi[0];
+	for (size_t i=0;i<M;i++)
+	{
+		const double ccos = cos(phi[i]), ssin = sin(phi[i]);
+		x[i] += ccos*dx[i] - ssin*dy[i];
+		y[i] += ssin*dx[i] + ccos*dy[i];
+		phi[i] = mrpt::math::wrapToPi(phi[i]+dphi[i]);
+	}
+
+	// Scatter the new poses back into the particles:
+	for (size_t i=0;i<M;i++)
+	{
+		CPose2D &p = *m_particles[i].d;
+		p.x(x[i]);
+		p.y(y[i]);
+		p.phi(phi[i]);
+	}
+	return true;
+}
 
 void CMonteCarloLocalization2D::PF_SLAM_implementation_replaceByNewParticleSet(
 	CParticleList &old_particles,
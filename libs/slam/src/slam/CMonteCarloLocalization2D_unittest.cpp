@@ -14,6 +14,9 @@
 #include <mrpt/maps/CMultiMetricMap.h>
 #include <mrpt/maps/CSimpleMap.h>
 #include <mrpt/obs/CRawlog.h>
+#include <mrpt/obs/CActionCollection.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/math/wrap2pi.h>
 #include <mrpt/system/filesystem.h>
 #include <mrpt/system/os.h>
 #include <mrpt/random.h>
@@ -296,3 +299,84 @@ TEST(MonteCarlo2D, RunSampleDataset)
 	FAIL() << "Failed to converge after 3 opportunities!!" << endl;
 }
 
+
+namespace
+{
+	// Sample covariance of a set of particles (CPosePDFParticles::getCovarianceAndMean() would lose the sign of the phi cross terms)
+	void particles_covariance_and_mean(const CPosePDFParticles &pdf, CMatrixDouble33 &cov, CPose2D &mean)
+	{
+		pdf.getMean(mean);
+		double sum_w = 0;
+		for (size_t k=0;k<pdf.size();k++) sum_w += exp(pdf.m_particles[k].log_w);
+		cov.zeros();
+		for (size_t k=0;k<pdf.size();k++)
+		{
+			const CPose2D &p = *pdf.m_particles[k].d;
+			const double w = exp(pdf.m_particles[k].log_w)/sum_w;
+			const double err[3] = { p.x()-mean.x(), p.y()-mean.y(), mrpt::math::wrapToPi(p.phi()-mean.phi()) };
+			for (int i=0;i<3;i++)
+				for (int j=0;j<3;j++)
+					cov(i,j) += w*err[i]*err[j];
+		}
+	}
+
+	// The prediction of all the particles at once must follow the odometry motion model:
+	void run_test_pf_prediction(CActionRobotMovement2D::TDrawSampleMotionModel model)
+	{
+		const size_t M = 20000;
+		const CPose2D p0(1,2,DEG2RAD(90));
+		CMonteCarloLocalization2D pdf;
+		pdf.resetDeterministic(p0,M);
+
+		CActionRobotMovement2D::TMotionModelOptions motionOpts;
+		motionOpts.modelSelection = model;
+		CActionRobotMovement2D act;
+		act.computeFromOdometry(CPose2D(1,0.1,DEG2RAD(10)), motionOpts);
+		CActionCollection acts;
+		acts.insert(act);
+
+		CParticleFilter::TParticleFilterOptions pfOptions;
+		pfOptions.adaptiveSampleSize = false;
+
+		randomGenerator.randomize(1234);
+		pdf.prediction_and_update_pfStandardProposal(&acts, NULL, pfOptions);
+		ASSERT_EQ(pdf.size(),M);
+
+		CPose2D actMean;
+		CMatrixDouble33 actCov;
+		if (IS_CLASS(act.poseChange,CPosePDFParticles))
+			particles_covariance_and_mean(*CPosePDFParticlesPtr(act.poseChange),actCov,actMean);
+		else act.poseChange->getCovarianceAndMean(actCov,actMean);
+
+		CPose2D meanPose;
+		CMatrixDouble33 cov;
+		particles_covariance_and_mean(pdf,cov,meanPose);
+
+		const CPose2D expectedMean = p0 + actMean;
+		EXPECT_NEAR(meanPose.x(),expectedMean.x(),0.01);
+		EXPECT_NEAR(meanPose.y(),expectedMean.y(),0.01);
+		EXPECT_NEAR(meanPose.phi(),expectedMean.phi(),0.01);
+
+		// The covariance of the increment, rotated to the initial heading:
+		CMatrixDouble33 R;
+		R.unit(3,1.0);
+		R(0,0)=cos(p0.phi()); R(0,1)=-sin(p0.phi());
+		R(1,0)=sin(p0.phi()); R(1,1)= cos(p0.phi());
+		CMatrixDouble33 expectedCov;
+		R.multiply_HCHt(actCov,expectedCov);
+		for (int i=0;i<3;i++)
+			for (int j=0;j<3;j++)
+				EXPECT_NEAR(cov(i,j),expectedCov(i,j), 0.05*std::max(expectedCov(i,i),expectedCov(j,j))) << "i=" << i << " j=" << j;
+	}
+
+}
+
+TEST(MonteCarlo2D, PredictionGaussianModel)
+{
+	run_test_pf_prediction(CActionRobotMovement2D::mmGaussian);
+}
+
+TEST(MonteCarlo2D, PredictionThrunModel)
+{
+	run_test_pf_prediction(CActionRobotMovement2D::mmThrun);
+}
@@ -328,9 +328,14 @@ void  CMultiMetricMapPDF::rebuildAverageMap()
 		MRPT_START
 
 		// Reserve a float grid-map, add weight all maps
+		//  (all the grids have the same size, hence the same tiles: go tile by tile, including padding cells)
 		// -------------------------------------------------------------------------------------------
+		typedef mrpt::utils::CCopyOnWriteTiledGrid<COccupancyGridMap2D::cellType> cells_grid_t;
+		cells_grid_t &avgCells = averageMap.m_gridMaps[0]->map;
+		const size_t nTilesX = avgCells.getTilesCountX(), nTilesY = avgCells.getTilesCountY();
+
 		std::vector<float>	floatMap;
-		floatMap.resize(averageMap.m_gridMaps[0]->map.size(),0);
+		floatMap.resize(nTilesX*nTilesY*cells_grid_t::TILE_CELLS,0);
 
 		// For each particle in the RBPF:
 		double		sumW = 0;
@@ -341,31 +346,32 @@ void  CMultiMetricMapPDF::rebuildAverageMap()
 
 		for (part=m_particles.begin();part!=m_particles.end();++part)
 		{
-			// Variables:
-			std::vector<COccupancyGridMap2D::cellType>::iterator	srcCell;
-			std::vector<COccupancyGridMap2D::cellType>::iterator	firstSrcCell = part->d->mapTillNow.m_gridMaps[0]->map.begin();
-			std::vector<COccupancyGridMap2D::cellType>::iterator	lastSrcCell = part->d->mapTillNow.m_gridMaps[0]->map.end();
-			std::vector<float>::iterator							destCell;
+			const cells_grid_t &srcCells = part->d->mapTillNow.m_gridMaps[0]->map;
+			ASSERT_( srcCells.getTilesCountX()==nTilesX && srcCells.getTilesCountY()==nTilesY );
 
 			// The weight of particle:
 			float		w =  exp(part->log_w) / sumW;
 
-			ASSERT_( part->d->mapTillNow.m_gridMaps[0]->map.size() == floatMap.size() );
-
 			// For each cell in individual maps:
-			for (srcCell = firstSrcCell, destCell = floatMap.begin();srcCell!=lastSrcCell;srcCell++,destCell++)
-				(*destCell) += w * (*srcCell);
-
+			std::vector<float>::iterator	destCell = floatMap.begin();
+			for (size_t ty=0;ty<nTilesY;ty++)
+				for (size_t tx=0;tx<nTilesX;tx++)
+				{
+					const COccupancyGridMap2D::cellType *srcCell = srcCells.getTile(tx,ty);
+					for (size_t i=0;i<cells_grid_t::TILE_CELLS;i++)
+						(*destCell++) += w * (*srcCell++);
+				}
 		}
 
 		// Copy to fixed point map:
-		std::vector<float>::iterator							srcCell;
-		std::vector<COccupancyGridMap2D::cellType>::iterator	destCell = averageMap.m_gridMaps[0]->map.begin();
-
-		ASSERT_( averageMap.m_gridMaps[0]->map.size() == floatMap.size() );
-
-		for (srcCell=floatMap.begin();srcCell!=floatMap.end();srcCell++,destCell++)
-			*destCell = static_cast<COccupancyGridMap2D::cellType>( *srcCell );
+		std::vector<float>::const_iterator	srcCell = floatMap.begin();
+		for (size_t ty=0;ty<nTilesY;ty++)
+			for (size_t tx=0;tx<nTilesX;tx++)
+			{
+				COccupancyGridMap2D::cellType *destCell = avgCells.getTileForWrite(tx,ty);
+				for (size_t i=0;i<cells_grid_t::TILE_CELLS;i++)
+					*destCell++ = static_cast<COccupancyGridMap2D::cellType>( *srcCell++ );
+			}
 
 		MRPT_END
 	}	// End of SSE not supported
@@ -374,6 +380,29 @@ void  CMultiMetricMapPDF::rebuildAverageMap()
 	averageMapIsUpdated = true;
 }
 
+namespace
+{
+	/** Inserts an observation into the maps of a block of particles */
+	struct TObservationInserter
+	{
+		CMultiMetricMapPDF &pdf;
+		CSensoryFrame &sf;
+		std::vector<uint8_t> &map_modified;
+
+		TObservationInserter(CMultiMetricMapPDF &pdf_, CSensoryFrame &sf_, std::vector<uint8_t> &map_modified_) :
+			pdf(pdf_), sf(sf_), map_modified(map_modified_) { }
+
+		void operator()(size_t first, size_t last, CRandomGenerator &)
+		{
+			for (size_t i=first;i<last;i++)
+			{
+				const CPose3D robotPose(*pdf.getLastPose(i));
+				map_modified[i] = sf.insertObservationsInto( &pdf.m_particles[i].d->mapTillNow, &robotPose ) ? 1:0;
+			}
+		}
+	};
+}
+
 /*---------------------------------------------------------------
 						insertObservation
  ---------------------------------------------------------------*/
@@ -391,16 +420,12 @@ bool CMultiMetricMapPDF::insertObservation(CSensoryFrame	&sf)
 		CSensoryFramePtr( new CSensoryFrame(sf) ) );
 	SF2robotPath.push_back( m_particles[0].d->robotPath.size()-1 );
 
-	bool anymap = false;
-	for (size_t i=0;i<M;i++)
-	{
-		const CPose3D robotPose(*getLastPose(i));
-		const bool map_modified = sf.insertObservationsInto( &m_particles[i].d->mapTillNow, &robotPose );
-		anymap = anymap || map_modified;
-	}
+	std::vector<uint8_t> map_modified(M,0);
+	TObservationInserter inserter(*this,sf,map_modified);
+	PF_SLAM_aux_parallelForParticles(M,inserter);
 
 	averageMapIsUpdated = false;
-	return anymap;
+	return std::find(map_modified.begin(),map_modified.end(),1)!=map_modified.end();
 }
 
 /*---------------------------------------------------------------
@@ -588,7 +613,8 @@ CMultiMetricMapPDF::TPredictionParams::TPredictionParams() :
 	ICPGlobalAlign_MinQuality(0.70f),
 	update_gridMapLikelihoodOptions(),
 	KLD_params(),
-	icp_params()
+	icp_params(),
+	num_threads(1)
 {
 }
 
@@ -601,6 +627,7 @@ void  CMultiMetricMapPDF::TPredictionParams::dumpToTextStream(mrpt::utils::CStre
 
 	out.printf("pfOptimalProposal_mapSelection          = %i\n", pfOptimalProposal_mapSelection );
 	out.printf("ICPGlobalAlign_MinQuality               = %f\n", ICPGlobalAlign_MinQuality );
+	out.printf("num_threads                             = %u\n", num_threads );
 
 	KLD_params.dumpToTextStream(out);
 	icp_params.dumpToTextStream(out);
@@ -617,6 +644,7 @@ void  CMultiMetricMapPDF::TPredictionParams::loadFromConfigFile(
 	pfOptimalProposal_mapSelection = iniFile.read_int(section,"pfOptimalProposal_mapSelection",pfOptimalProposal_mapSelection, true);
 
 	MRPT_LOAD_CONFIG_VAR( ICPGlobalAlign_MinQuality, float,   iniFile,section );
+	MRPT_LOAD_CONFIG_VAR( num_threads, uint64_t, iniFile,section );
 
 	KLD_params.loadFromConfigFile(iniFile, section);
 	icp_params.loadFromConfigFile(iniFile, section);
@@ -164,103 +164,52 @@ void  CMultiMetricMapPDF::prediction_and_update_pfAuxiliaryPFStandard(
 }
 
 
-/*----------------------------------------------------------------------------------
-			prediction_and_update_pfOptimalProposal
-
-For grid-maps:
-==============
- Approximation by Grissetti et al:  Use scan matching to approximate
-   the observation model by a Gaussian:
-  See: "Improved Grid-based SLAM with Rao-Blackwellized PF by Adaptive Proposals
-	       and Selective Resampling" (G. Grisetti, C. Stachniss, W. Burgard)
-
-For beacon maps:
-===============
-  (JLBC: Method under development)
-
- ----------------------------------------------------------------------------------*/
-void  CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
-	const mrpt::obs::CActionCollection	* actions,
-	const mrpt::obs::CSensoryFrame		* sf,
-	const bayes::CParticleFilter::TParticleFilterOptions &PF_options )
+namespace
 {
-	MRPT_START
-
-	// ----------------------------------------------------------------------
-	//						PREDICTION STAGE
-	// ----------------------------------------------------------------------
-	CVectorDouble				rndSamples;
-	size_t						M = m_particles.size();
-	bool						updateStageAlreadyDone = false;
-	CPose3D						initialPose,incrPose, finalPose;
-
-	// ICP used if "pfOptimalProposal_mapSelection" = 0 or 1
-	CICP				icp (options.icp_params);  // Set our ICP params instead of default ones.
-	CICP::TReturnInfo	icpInfo;
-
-	CParticleList::iterator		partIt;
-
-	ASSERT_(sf!=NULL)
-
-	// Find a robot movement estimation:
-	CPose3D						motionModelMeanIncr;	// The mean motion increment:
-	CPoseRandomSampler			robotActionSampler;
+	/** The per-particle prediction and update stages of CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(), for a block of particles */
+	struct TOptimalProposalUpdater
 	{
-		CActionRobotMovement2DPtr	robotMovement2D = actions->getBestMovementEstimation();
-
-		// If there is no 2D action, look for a 3D action:
-		if (robotMovement2D.present())
-		{
-			robotActionSampler.setPosePDF( robotMovement2D->poseChange );
-			motionModelMeanIncr = robotMovement2D->poseChange->getMeanVal();
-		}
-		else
-		{
-			CActionRobotMovement3DPtr	robotMovement3D = actions->getActionByClass<CActionRobotMovement3D>();
-			if (robotMovement3D)
-			{
-				robotActionSampler.setPosePDF( robotMovement3D->poseChange );
-				robotMovement3D->poseChange.getMean( motionModelMeanIncr );
-			}
-			else
-			{
-				motionModelMeanIncr.setFromValues(0,0,0);
-			}
-		}
-	}
-
-	// Average map will need to be updated after this:
-	averageMapIsUpdated = false;
-
-	// --------------------------------------------------------------------------------------
-	//  Prediction:
-	//
-	//  Compute a new mean and covariance by sampling around the mean of the input "action"
-	// --------------------------------------------------------------------------------------
-	printf(" 1) Prediction...");
-	M = m_particles.size();
-
-	// To be computed as an average from all m_particles:
-	size_t particleWithHighestW = 0;
-	for (size_t i=0;i<M;i++)
-		if (getW(i)>getW(particleWithHighestW))
-			particleWithHighestW = i;
-
-
-	//   The paths MUST already contain the starting location for each particle:
-	ASSERT_( !m_particles[0].d->robotPath.empty() )
+		CMultiMetricMapPDF &pdf;
+		const CMultiMetricMapPDF::TPredictionParams &options;
+		const CParticleFilter::TParticleFilterOptions &PF_options;
+		const CSensoryFrame *sf;
+		const CPose3D &motionModelMeanIncr;
+		const CPoseRandomSampler &robotActionSampler;
+		const CSimplePointsMap &localMapPoints;
+		const size_t particleWithHighestW;
+		std::vector<uint8_t> &icpFallback;  //!< Set to 1 for the particles whose ICP was too poor and used odometry instead
+
+		TOptimalProposalUpdater(
+			CMultiMetricMapPDF &pdf_,
+			const CParticleFilter::TParticleFilterOptions &PF_options_,
+			const CSensoryFrame *sf_,
+			const CPose3D &motionModelMeanIncr_,
+			const CPoseRandomSampler &robotActionSampler_,
+			const CSimplePointsMap &localMapPoints_,
+			size_t particleWithHighestW_,
+			std::vector<uint8_t> &icpFallback_ ) :
+				pdf(pdf_), options(pdf_.options), PF_options(PF_options_), sf(sf_),
+				motionModelMeanIncr(motionModelMeanIncr_), robotActionSampler(robotActionSampler_),
+				localMapPoints(localMapPoints_), particleWithHighestW(particleWithHighestW_), icpFallback(icpFallback_)
+		{ }
+
+		void operator()(size_t first, size_t last, CRandomGenerator &rng);
+	};
+}
 
-	// Build the local map of points for ICP:
-	CSimplePointsMap	localMapPoints;
-	CLandmarksMap		localMapLandmarks;
-	bool built_map_points = false;
-	bool built_map_lms = false;
+void TOptimalProposalUpdater::operator()(size_t first, size_t last, CRandomGenerator &rng)
+{
+	// ICP used if "pfOptimalProposal_mapSelection" = 0, 1 or 3 (CICP::Align() is not const: one per thread)
+	CICP	icp (options.icp_params);  // Set our ICP params instead of default ones.
 
-	// Update particle poses:
-	size_t i;
-	for (i=0,partIt = m_particles.begin(); partIt!=m_particles.end(); partIt++,i++)
+	for (size_t i=first;i<last;i++)
 	{
+		const CMultiMetricMapPDF::CParticleList::iterator partIt = pdf.m_particles.begin()+i;
 		double extra_log_lik = 0; // Used for the optimal_PF with ICP
+		bool updateStageAlreadyDone = false;
+		CPose3D incrPose, finalPose;
+		CVectorDouble rndSamples;
+		CICP::TReturnInfo icpInfo;
 
 		// Set initial robot pose estimation for this particle:
 		const CPose3D ith_last_pose = CPose3D(*partIt->d->robotPath.rbegin()); // The last robot pose in the path
@@ -287,16 +236,6 @@ void  CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
 			{
 				ASSERT_( !partIt->d->mapTillNow.m_gridMaps.empty() );
 
-				// Build local map of points.
-				if (!built_map_points)
-				{
-					built_map_points=true;
-
-					localMapPoints.insertionOptions.minDistBetweenLaserPoints =  0.02f; //3.0f * m_particles[0].d->mapTillNow.m_gridMaps[0]->getResolution();;
-					localMapPoints.insertionOptions.isPlanarMap = true;
-					sf->insertObservationsInto( &localMapPoints );
-				}
-
 				map_to_align_to = partIt->d->mapTillNow.m_gridMaps[0].pointer();
 			}
 			else
@@ -304,29 +243,12 @@ void  CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
 			{
 				ASSERT_( !partIt->d->mapTillNow.m_pointsMaps.empty() );
 
-				// Build local map of points.
-				if (!built_map_points)
-				{
-					built_map_points=true;
-
-					localMapPoints.insertionOptions.minDistBetweenLaserPoints =  0.02f; //3.0f * m_particles[0].d->mapTillNow.m_gridMaps[0]->getResolution();;
-					localMapPoints.insertionOptions.isPlanarMap = true;
-					sf->insertObservationsInto( &localMapPoints );
-				}
-
 				map_to_align_to = partIt->d->mapTillNow.m_pointsMaps[0].pointer();
 			}
 			else
 			{
 				ASSERT_( partIt->d->mapTillNow.m_landmarksMap.present() );
 
-				// Build local map of LMs.
-				if (!built_map_lms)
-				{
-					built_map_lms=true;
-					sf->insertObservationsInto( &localMapLandmarks );
-				}
-
 				map_to_align_to = partIt->d->mapTillNow.m_landmarksMap.pointer();
 			}
 
@@ -347,16 +269,16 @@ void  CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
 
 			if (i==particleWithHighestW)
 			{
-				newInfoIndex = 1 - icpInfo.goodness; //newStaticPointsRatio; //* icpInfo.goodness;
+				pdf.newInfoIndex = 1 - icpInfo.goodness; //newStaticPointsRatio; //* icpInfo.goodness;
 			}
 
 			// Set the gaussian pose:
 			CPose3DPDFGaussian finalEstimatedPoseGauss( icpEstimation );
 
 			//printf("[rbpf-slam] gridICP[%u]: %.02f%%\n", i, 100*icpInfo.goodness);
-			if (icpInfo.goodness<options.ICPGlobalAlign_MinQuality && SFs.size())
+			if (icpInfo.goodness<options.ICPGlobalAlign_MinQuality && pdf.getNumberOfObservationsInSimplemap())
 			{
-				printf("[rbpf-slam] Warning: gridICP[%u]: %.02f%% -> Using odometry instead!\n", (unsigned int)i, 100*icpInfo.goodness);
+				icpFallback[i] = 1;  // Reported after all the threads end
 				icpEstimation.mean = CPose2D(initialPoseEstimation);
 			}
 
@@ -389,7 +311,7 @@ void  CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
 			// Generate gaussian-distributed 2D-pose increments according to "finalEstimatedPoseGauss":
 			// -------------------------------------------------------------------------------------------
 			finalPose = finalEstimatedPoseGauss.mean;					// Add to the new robot pose:
-			randomGenerator.drawGaussianMultivariate(rndSamples, finalEstimatedPoseGauss.cov );
+			rng.drawGaussianMultivariate(rndSamples, finalEstimatedPoseGauss.cov );
 			// Add noise:
 			finalPose.setFromValues(
 				finalPose.x() + rndSamples[0],
@@ -837,7 +759,7 @@ void  CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
 			if ( !robotActionSampler.isPrepared() )
 				THROW_EXCEPTION("Action list does not contain any CActionRobotMovement2D or CActionRobotMovement3D object!");
 
-			robotActionSampler.drawSample( incrPose );
+			robotActionSampler.drawSample( incrPose, rng );
 
 			finalPose = ith_last_pose + incrPose;
 		}
@@ -852,11 +774,108 @@ void  CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
 		{
 			partIt->log_w +=
 				PF_options.powFactor *
-				(PF_SLAM_computeObservationLikelihoodForParticle(PF_options,i,*sf,finalPose)
+				(pdf.PF_SLAM_computeObservationLikelihoodForParticle(PF_options,i,*sf,finalPose)
 				+ extra_log_lik);
 		} // if update not already done...
 
 	} // end of for each particle "i" & "partIt"
+}
+
+/*----------------------------------------------------------------------------------
+			prediction_and_update_pfOptimalProposal
+
+For grid-maps:
+==============
+ Approximation by Grissetti et al:  Use scan matching to approximate
+   the observation model by a Gaussian:
+  See: "Improved Grid-based SLAM with Rao-Blackwellized PF by Adaptive Proposals
+	       and Selective Resampling" (G. Grisetti, C. Stachniss, W. Burgard)
+
+For beacon maps:
+===============
+  (JLBC: Method under development)
+
+ ----------------------------------------------------------------------------------*/
+void  CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
+	const mrpt::obs::CActionCollection	* actions,
+	const mrpt::obs::CSensoryFrame		* sf,
+	const bayes::CParticleFilter::TParticleFilterOptions &PF_options )
+{
+	MRPT_START
+
+	// ----------------------------------------------------------------------
+	//						PREDICTION STAGE
+	// ----------------------------------------------------------------------
+	size_t						M = m_particles.size();
+
+	ASSERT_(sf!=NULL)
+
+	// Find a robot movement estimation:
+	CPose3D						motionModelMeanIncr;	// The mean motion increment:
+	CPoseRandomSampler			robotActionSampler;
+	{
+		CActionRobotMovement2DPtr	robotMovement2D = actions->getBestMovementEstimation();
+
+		// If there is no 2D action, look for a 3D action:
+		if (robotMovement2D.present())
+		{
+			robotActionSampler.setPosePDF( robotMovement2D->poseChange );
+			motionModelMeanIncr = robotMovement2D->poseChange->getMeanVal();
+		}
+		else
+		{
+			CActionRobotMovement3DPtr	robotMovement3D = actions->getActionByClass<CActionRobotMovement3D>();
+			if (robotMovement3D)
+			{
+				robotActionSampler.setPosePDF( robotMovement3D->poseChange );
+				robotMovement3D->poseChange.getMean( motionModelMeanIncr );
+			}
+			else
+			{
+				motionModelMeanIncr.setFromValues(0,0,0);
+			}
+		}
+	}
+
+	// Average map will need to be updated after this:
+	averageMapIsUpdated = false;
+
+	// --------------------------------------------------------------------------------------
+	//  Prediction:
+	//
+	//  Compute a new mean and covariance by sampling around the mean of the input "action"
+	// --------------------------------------------------------------------------------------
+	printf(" 1) Prediction...");
+	M = m_particles.size();
+
+	// To be computed as an average from all m_particles:
+	size_t particleWithHighestW = 0;
+	for (size_t i=0;i<M;i++)
+		if (getW(i)>getW(particleWithHighestW))
+			particleWithHighestW = i;
+
+
+	//   The paths MUST already contain the starting location for each particle:
+	ASSERT_( !m_particles[0].d->robotPath.empty() )
+
+	// Build the local map of points for ICP, shared by all the particles:
+	CSimplePointsMap	localMapPoints;
+	if ( options.pfOptimalProposal_mapSelection==0 ||
+		 options.pfOptimalProposal_mapSelection==3 )
+	{
+		localMapPoints.insertionOptions.minDistBetweenLaserPoints =  0.02f; //3.0f * m_particles[0].d->mapTillNow.m_gridMaps[0]->getResolution();;
+		localMapPoints.insertionOptions.isPlanarMap = true;
+		sf->insertObservationsInto( &localMapPoints );
+	}
+
+	// Update particle poses and weights:
+	std::vector<uint8_t> icpFallback(M,0);
+	TOptimalProposalUpdater updater(*this,PF_options,sf,motionModelMeanIncr,robotActionSampler,localMapPoints,particleWithHighestW,icpFallback);
+	PF_SLAM_aux_parallelForParticles(M,updater);
+
+	const size_t nFallbacks = std::count(icpFallback.begin(),icpFallback.end(),1);
+	if (nFallbacks)
+		logStr(mrpt::utils::LVL_WARN, mrpt::format("[rbpf-slam] Warning: gridICP quality below ICPGlobalAlign_MinQuality -> Using odometry instead (%u particles).",static_cast<unsigned int>(nFallbacks)) );
 
 	printf("Ok\n");
 
@@ -906,6 +925,14 @@ bool CMultiMetricMapPDF::PF_SLAM_implementation_skipRobotMovement() const
 	return 0==getNumberOfObservationsInSimplemap();
 }
 
+/** Beacon maps are updated serially: their insertion of observations draws samples from the global random generator */
+unsigned int CMultiMetricMapPDF::PF_SLAM_implementation_numThreads() const
+{
+	if (!m_particles.empty() && m_particles[0].d->mapTillNow.m_beaconMap.present())
+		return 1;
+	return options.num_threads ? options.num_threads : mrpt::system::getNumberOfProcessors();
+}
+
 
 
 /*---------------------------------------------------------------
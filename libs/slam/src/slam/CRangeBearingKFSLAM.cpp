@@ -180,7 +180,7 @@ void CRangeBearingKFSLAM::getCurrentState(
 		out_fullState[i] = m_xkk[i];
 
 	// Full cov:
-	out_fullCovariance = m_pkk;
+	this->getStateCovariance(out_fullCovariance);
 
 	MRPT_END
 }
@@ -199,7 +199,7 @@ void  CRangeBearingKFSLAM::processActionObservation(
 	m_SF = SF;
 
 	// Sanity check:
-	ASSERT_( m_IDs.size() == (m_pkk.getColCount() - get_vehicle_size() )/get_feature_size() );
+	ASSERT_( m_IDs.size() == this->getNumberOfLandmarksInTheMap() );
 
 	// ===================================================================================================================
 	// Here's the meat!: Call the main method for the KF algorithm, which will call all the callback methods as required:
@@ -670,7 +670,8 @@ void CRangeBearingKFSLAM::OnGetObservationsAndDataAssociation(
 				true,   // Use KD-tree
 				m_last_data_association.predictions_IDs,
 				options.data_assoc_IC_metric,
-				options.data_assoc_IC_ml_threshold
+				options.data_assoc_IC_ml_threshold,
+				KF_options.num_threads // The same threads than the KF
 				);
 
 			// Return pairings to the main KF algorithm:
@@ -956,13 +957,14 @@ void  CRangeBearingKFSLAM::getAs3DObject( mrpt::opengl::CSetOfObjectsPtr	&outObj
 
 	// 3D ellipsoids for landmarks:
 	const size_t nLMs = this->getNumberOfLandmarksInTheMap();
+	KFMatrix_FxF lm_cov(UNINITIALIZED_MATRIX);
 	for (size_t i=0;i<nLMs;i++)
 	{
         pointGauss.mean.x( m_xkk[get_vehicle_size()+get_feature_size()*i+0] );
         pointGauss.mean.y( m_xkk[get_vehicle_size()+get_feature_size()*i+1] );
         pointGauss.mean.z( m_xkk[get_vehicle_size()+get_feature_size()*i+2] );
-        m_pkk.extractMatrix(get_vehicle_size()+get_feature_size()*i,get_vehicle_size()+get_feature_size()*i,get_feature_size(),get_feature_size(), COV);
-        pointGauss.cov = COV;
+        this->getLandmarkCov(i, lm_cov);
+        pointGauss.cov = lm_cov;
 
 		opengl::CEllipsoidPtr ellip = opengl::CEllipsoid::Create();
 
@@ -1122,7 +1124,8 @@ double CRangeBearingKFSLAM::computeOffDiagonalBlocksApproximationError(
     MRPT_START
 
     // Compute the information matrix:
-    CMatrixTemplateNumeric<kftype> fullCov( m_pkk );
+    CMatrixTemplateNumeric<kftype> fullCov;
+    this->getStateCovariance(fullCov);
 	size_t i;
     for (i=0;i<get_vehicle_size();i++)
         fullCov(i,i) = max(fullCov(i,i), 1e-6);
@@ -1198,14 +1201,16 @@ void CRangeBearingKFSLAM::saveMapAndPath2DRepresentationAsMATLABFile(
 	os::fprintf(f,"hold on;\n\n");
 
 	const size_t nLMs = this->getNumberOfLandmarksInTheMap();
+	KFMatrix_FxF lm_cov(UNINITIALIZED_MATRIX);
 
 	for (size_t i=0;i<nLMs;i++)
 	{
 		size_t idx = get_vehicle_size()+i*get_feature_size();
 
-		cov(0,0) = m_pkk(idx+0,idx+0);
-		cov(1,1) = m_pkk(idx+1,idx+1);
-		cov(0,1) = cov(1,0) = m_pkk(idx+0,idx+1);
+		this->getLandmarkCov(i, lm_cov);
+		cov(0,0) = lm_cov(0,0);
+		cov(1,1) = lm_cov(1,1);
+		cov(0,1) = cov(1,0) = lm_cov(0,1);
 
 		mean[0] = m_xkk[idx+0];
 		mean[1] = m_xkk[idx+1];
@@ -137,7 +137,7 @@ void CRangeBearingKFSLAM2D::getCurrentState(
 		out_fullState[i] = m_xkk[i];
 
 	// Full cov:
-	out_fullCovariance = m_pkk;
+	this->getStateCovariance(out_fullCovariance);
 
 	MRPT_END
 }
@@ -654,7 +654,8 @@ void CRangeBearingKFSLAM2D::OnGetObservationsAndDataAssociation(
 				true,   // Use KD-tree
 				m_last_data_association.predictions_IDs,
 				options.data_assoc_IC_metric,
-				options.data_assoc_IC_ml_threshold
+				options.data_assoc_IC_ml_threshold,
+				KF_options.num_threads // The same threads than the KF
 				);
 
 			// Return pairings to the main KF algorithm:
@@ -904,12 +905,13 @@ void  CRangeBearingKFSLAM2D::getAs3DObject( mrpt::opengl::CSetOfObjectsPtr	&outO
 
 	// 2D ellipsoids for landmarks:
 	const size_t nLMs = (m_xkk.size()-3)/2;
+	KFMatrix_FxF lm_cov(UNINITIALIZED_MATRIX);
 	for (size_t i=0;i<nLMs;i++)
 	{
         pointGauss.mean.x( m_xkk[3+2*i+0] );
         pointGauss.mean.y( m_xkk[3+2*i+1] );
-        m_pkk.extractMatrix(3+2*i,3+2*i,2,2, COV);
-        pointGauss.cov = COV;
+        this->getLandmarkCov(i, lm_cov);
+        pointGauss.cov = lm_cov;
 
 		opengl::CEllipsoidPtr ellip = opengl::CEllipsoid::Create();
 
@@ -959,14 +961,16 @@ void CRangeBearingKFSLAM2D::saveMapAndPath2DRepresentationAsMATLABFile(
 	os::fprintf(f,"hold on;\n\n");
 
 	size_t i, nLMs = (m_xkk.size()-get_vehicle_size())/get_feature_size();
+	KFMatrix_FxF lm_cov(UNINITIALIZED_MATRIX);
 
 	for (i=0;i<nLMs;i++)
 	{
 		size_t idx = get_vehicle_size()+i*get_feature_size();
 
-		cov(0,0) = m_pkk(idx+0,idx+0);
-		cov(1,1) = m_pkk(idx+1,idx+1);
-		cov(0,1) = cov(1,0) = m_pkk(idx+0,idx+1);
+		this->getLandmarkCov(i, lm_cov);
+		cov(0,0) = lm_cov(0,0);
+		cov(1,1) = lm_cov(1,1);
+		cov(0,1) = cov(1,0) = lm_cov(0,1);
 
 		mean[0] = m_xkk[idx+0];
 		mean[1] = m_xkk[idx+1];
@@ -0,0 +1,169 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/slam/CRangeBearingKFSLAM2D.h>
+#include <mrpt/obs/CActionCollection.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/obs/CSensoryFrame.h>
+#include <mrpt/obs/CObservationBearingRange.h>
+#include <mrpt/math/wrap2pi.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::bayes;
+using namespace mrpt::slam;
+using namespace mrpt::maps;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::random;
+using namespace mrpt::obs;
+using namespace mrpt::utils;
+using namespace std;
+
+namespace
+{
+	// Robot driving two loops along a circle within a grid of landmarks, observed with known IDs.
+	void run_kf_slam_2d(CRangeBearingKFSLAM2D &slam, const vector<TPoint2D> &LMs, const CPose2D &init_pose, CPose2D &gt_pose)
+	{
+		randomGenerator.randomize(1234);
+
+		const size_t nSteps = 170;
+		const CPose2D odo_incr(0.6, 0, 0.6/8.0);
+		const double sensor_max_range = 5.0;
+
+		slam.options.std_sensor_range = 0.05f;
+		slam.options.std_sensor_yaw = DEG2RAD(0.5f);
+
+		CActionRobotMovement2D::TMotionModelOptions motionOpts;
+		motionOpts.modelSelection = CActionRobotMovement2D::mmGaussian;
+
+		gt_pose = init_pose;
+		for (size_t step=0;step<nSteps;step++)
+		{
+			if (step) gt_pose = gt_pose + odo_incr;
+
+			// Noisy odometry:
+			const CPose2D noisy_incr(
+				odo_incr.x()+randomGenerator.drawGaussian1D(0,0.01),
+				odo_incr.y()+randomGenerator.drawGaussian1D(0,0.01),
+				odo_incr.phi()+randomGenerator.drawGaussian1D(0,DEG2RAD(0.2)) );
+			CActionRobotMovement2D act;
+			act.computeFromOdometry(step ? noisy_incr : CPose2D(), motionOpts);
+			CActionCollectionPtr acts = CActionCollection::Create();
+			acts->insert(act);
+
+			// Observations:
+			CObservationBearingRangePtr obs = CObservationBearingRange::Create();
+			obs->maxSensorDistance = sensor_max_range;
+			obs->fieldOfView_yaw = DEG2RAD(360.0f);
+			for (size_t i=0;i<LMs.size();i++)
+			{
+				double range, yaw;
+				const CPoint2D lm_local = CPoint2D(LMs[i]) - gt_pose;
+				range = lm_local.norm();
+				if (range>sensor_max_range) continue;
+				yaw = atan2(lm_local.y(),lm_local.x());
+
+				CObservationBearingRange::TMeasurement m;
+				m.range = range + randomGenerator.drawGaussian1D(0,0.05);
+				m.yaw = wrapToPi(yaw + randomGenerator.drawGaussian1D(0,DEG2RAD(0.5)));
+				m.pitch = 0;
+				m.landmarkID = i;
+				obs->sensedData.push_back(m);
+			}
+			CSensoryFramePtr SF = CSensoryFrame::Create();
+			SF->insert(obs);
+
+			slam.processActionObservation(acts,SF);
+		}
+	}
+}
+
+TEST(CRangeBearingKFSLAM2D, SEIFvsEKF)
+{
+	vector<TPoint2D> LMs;
+	for (int ix=-3;ix<=3;ix++)
+		for (int iy=-3;iy<=3;iy++)
+			LMs.push_back(TPoint2D(ix*4.0+0.5*(iy&1), iy*4.0));
+	const CPose2D init_pose(8,0,DEG2RAD(90));
+
+	CRangeBearingKFSLAM2D ekf;
+	CPose2D gt_pose;
+	run_kf_slam_2d(ekf, LMs, init_pose, gt_pose);
+
+	CRangeBearingKFSLAM2D seif;
+	seif.KF_options.method = kfSEIF;
+	seif.KF_options.SEIF_max_active_landmarks = 4;
+	run_kf_slam_2d(seif, LMs, init_pose, gt_pose);
+	seif.recoverMean();
+
+	CPosePDFGaussian ekf_pose, seif_pose;
+	vector<TPoint2D> ekf_lms, seif_lms;
+	std::map<unsigned int,CLandmark::TLandmarkID> ekf_IDs, seif_IDs;
+	CVectorDouble ekf_x, seif_x;
+	CMatrixDouble ekf_P, seif_P;
+	ekf.getCurrentState(ekf_pose, ekf_lms, ekf_IDs, ekf_x, ekf_P);
+	seif.getCurrentState(seif_pose, seif_lms, seif_IDs, seif_x, seif_P);
+
+	ASSERT_EQ(ekf_lms.size(), seif_lms.size());
+	ASSERT_TRUE(ekf_IDs==seif_IDs);
+	ASSERT_EQ(seif_P.getColCount(), size_t(seif_x.size()));
+
+	// The map is built starting at the initial robot pose:
+	const CPose2D ekf_gt_pose = gt_pose - init_pose;
+	EXPECT_NEAR(ekf_pose.mean.x(), ekf_gt_pose.x(), 0.2);
+	EXPECT_NEAR(ekf_pose.mean.y(), ekf_gt_pose.y(), 0.2);
+
+	// SEIF must be close to the EKF, for both the mean and the covariances:
+	EXPECT_NEAR(seif_pose.mean.x(), ekf_pose.mean.x(), 0.05);
+	EXPECT_NEAR(seif_pose.mean.y(), ekf_pose.mean.y(), 0.05);
+	EXPECT_NEAR(wrapToPi(seif_pose.mean.phi()-ekf_pose.mean.phi()), 0, DEG2RAD(0.5));
+	for (size_t i=0;i<ekf_lms.size();i++)
+	{
+		EXPECT_NEAR(seif_lms[i].x, ekf_lms[i].x, 0.05) << "LM ID: " << ekf_IDs[i];
+		EXPECT_NEAR(seif_lms[i].y, ekf_lms[i].y, 0.05) << "LM ID: " << ekf_IDs[i];
+	}
+	for (size_t i=0;i<3;i++)
+		EXPECT_NEAR(std::sqrt(seif_pose.cov(i,i)), std::sqrt(ekf_pose.cov(i,i)), 0.5*std::sqrt(ekf_pose.cov(i,i))) << "i=" << i;
+	// (Landmark marginals are recovered from a Markov blanket only, which makes them overconfident: allow an absolute slack for
+	//  the almost-certain landmarks seen from the initial pose)
+	for (size_t i=0;i<size_t(ekf_x.size());i++)
+		EXPECT_NEAR(std::sqrt(seif_P(i,i)), std::sqrt(ekf_P(i,i)), 0.5*std::sqrt(ekf_P(i,i))+1e-3) << "i=" << i;
+}
+
+TEST(CRangeBearingKFSLAM2D, EKFMultiThreaded)
+{
+	// A map large enough for the covariance update to be split among threads:
+	vector<TPoint2D> LMs;
+	for (int ix=-7;ix<=7;ix++)
+		for (int iy=-7;iy<=7;iy++)
+			LMs.push_back(TPoint2D(ix*2.0+0.5*(iy&1), iy*2.0));
+	const CPose2D init_pose(8,0,DEG2RAD(90));
+
+	CPose2D gt_pose;
+	CRangeBearingKFSLAM2D ekf1, ekf4;
+	ekf1.KF_options.num_threads = 1;
+	ekf4.KF_options.num_threads = 4;
+	run_kf_slam_2d(ekf1, LMs, init_pose, gt_pose);
+	run_kf_slam_2d(ekf4, LMs, init_pose, gt_pose);
+
+	CPosePDFGaussian pose1, pose4;
+	vector<TPoint2D> lms1, lms4;
+	std::map<unsigned int,CLandmark::TLandmarkID> IDs1, IDs4;
+	CVectorDouble x1, x4;
+	CMatrixDouble P1, P4;
+	ekf1.getCurrentState(pose1, lms1, IDs1, x1, P1);
+	ekf4.getCurrentState(pose4, lms4, IDs4, x4, P4);
+
+	ASSERT_GT(lms1.size(), 100u);
+	ASSERT_EQ(x1.size(), x4.size());
+	EXPECT_NEAR((x1-x4).array().abs().maxCoeff(), 0, 1e-6);
+	EXPECT_NEAR((P1-P4).array().abs().maxCoeff(), 0, 1e-9);
+}
@@ -41,6 +41,11 @@ CRejectionSamplingRangeOnlyLocalization::CRejectionSamplingRangeOnlyLocalization
 					RS_drawFromProposal
 ---------------------------------------------------------------*/
 void CRejectionSamplingRangeOnlyLocalization::RS_drawFromProposal( CPose2D &outSample )
+{
+	RS_drawFromProposal(outSample, randomGenerator);
+}
+
+void CRejectionSamplingRangeOnlyLocalization::RS_drawFromProposal( CPose2D &outSample, CRandomGenerator &rng )
 {
 	MRPT_START
 
@@ -50,14 +55,14 @@ void CRejectionSamplingRangeOnlyLocalization::RS_drawFromProposal( CPose2D &outS
 
 	ASSERT_(m_drawIndex<m_dataPerBeacon.size());
 
-	float	ang = randomGenerator.drawUniform( m_dataPerBeacon[m_drawIndex].minAngle,m_dataPerBeacon[m_drawIndex].maxAngle);
-	float	R = randomGenerator.drawGaussian1D( m_dataPerBeacon[m_drawIndex].radiusAtRobotPlane, m_sigmaRanges);
+	float	ang = rng.drawUniform( m_dataPerBeacon[m_drawIndex].minAngle,m_dataPerBeacon[m_drawIndex].maxAngle);
+	float	R = rng.drawGaussian1D( m_dataPerBeacon[m_drawIndex].radiusAtRobotPlane, m_sigmaRanges);
 
 	// This is the point where the SENSOR is:
 	outSample.x( m_dataPerBeacon[m_drawIndex].beaconPosition.x + cos(ang) * R );
 	outSample.y( m_dataPerBeacon[m_drawIndex].beaconPosition.y + sin(ang) * R );
 
-	outSample.phi( randomGenerator.drawGaussian1D( m_oldPose.phi(), DEG2RAD(2) ) );
+	outSample.phi( rng.drawGaussian1D( m_oldPose.phi(), DEG2RAD(2) ) );
 
 	// Compute the robot pose P.
 	//	  P = SAMPLE - ROT · SENSOR_ON_ROBOT
@@ -0,0 +1,141 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/slam/CRejectionSamplingRangeOnlyLocalization.h>
+#include <mrpt/maps/CLandmarksMap.h>
+#include <mrpt/obs/CObservationBeaconRanges.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::random;
+using namespace mrpt::utils;
+using namespace std;
+
+namespace
+{
+	typedef CRejectionSamplingRangeOnlyLocalization::TParticle TParticle;
+
+	// A map of 4 beacons, and the ranges to them from "gt_pose" (the last one, inconsistent if "bad_range"):
+	void setup_range_only_localization(CRejectionSamplingRangeOnlyLocalization &RS, const CPose2D &gt_pose, bool bad_range)
+	{
+		const double beacons_xy[4][2] = { {0,0},{6,0},{0,6},{6,6} };
+
+		CLandmarksMap map;
+		CObservationBeaconRanges obs;
+		for (unsigned int i=0;i<4;i++)
+		{
+			CLandmark lm;
+			lm.ID = i;
+			lm.pose_mean = TPoint3D(beacons_xy[i][0],beacons_xy[i][1],0);
+			map.landmarks.push_back(lm);
+
+			CObservationBeaconRanges::TMeasurement m;
+			m.beaconID = i;
+			m.sensorLocationOnRobot = TPoint3D(0,0,0);
+			m.sensedDistance = gt_pose.distance2DTo(beacons_xy[i][0],beacons_xy[i][1]) + (bad_range && i==3 ? 2.0 : 0.0);
+			obs.sensedData.push_back(m);
+		}
+		RS.setParams(map, obs, 0.1f, CPose2D(0,0,gt_pose.phi()));
+	}
+
+	void free_samples(vector<TParticle> &samples)
+	{
+		for (size_t i=0;i<samples.size();i++)
+			delete samples[i].d;
+		samples.clear();
+	}
+}
+
+TEST(CRejectionSamplingRangeOnlyLocalization, ParallelSampling)
+{
+	const CPose2D gt_pose(2,1.5,DEG2RAD(30));
+	CRejectionSamplingRangeOnlyLocalization RS;
+	setup_range_only_localization(RS, gt_pose, false);
+
+	const size_t N = 500;
+	vector<TParticle> serial, par4, par4b;
+	randomGenerator.randomize(333);
+	RS.rejectionSampling(N, serial);
+	randomGenerator.randomize(333);
+	RS.rejectionSamplingParallel(N, par4, 1000, 4);
+	randomGenerator.randomize(333);
+	RS.rejectionSamplingParallel(N, par4b, 1000, 4);
+
+	ASSERT_EQ(serial.size(), N);
+	ASSERT_EQ(par4.size(), N);
+	ASSERT_EQ(par4b.size(), N);
+
+	CPose2D mean_serial(0,0,0), mean_par(0,0,0);
+	for (size_t i=0;i<N;i++)
+	{
+		EXPECT_EQ(par4[i].log_w, 0);
+		// Same seed, same number of threads: same samples.
+		EXPECT_EQ(par4[i].d->x(), par4b[i].d->x());
+		EXPECT_EQ(par4[i].d->y(), par4b[i].d->y());
+		EXPECT_NEAR(par4[i].d->distanceTo(gt_pose), 0, 0.6) << "i=" << i;
+		mean_serial.x_incr(serial[i].d->x()/N); mean_serial.y_incr(serial[i].d->y()/N);
+		mean_par.x_incr(par4[i].d->x()/N); mean_par.y_incr(par4[i].d->y()/N);
+	}
+	EXPECT_NEAR(mean_par.x(), gt_pose.x(), 0.05);
+	EXPECT_NEAR(mean_par.y(), gt_pose.y(), 0.05);
+	EXPECT_NEAR(mean_par.x(), mean_serial.x(), 0.05);
+	EXPECT_NEAR(mean_par.y(), mean_serial.y(), 0.05);
+
+	free_samples(serial);
+	free_samples(par4);
+	free_samples(par4b);
+}
+
+TEST(CRejectionSamplingRangeOnlyLocalization, ParallelSamplingTimeout)
+{
+	// An inconsistent range makes all the candidates very unlikely: the limit of trials
+	// must be respected, and the output completed with weighted candidates.
+	CRejectionSamplingRangeOnlyLocalization RS;
+	setup_range_only_localization(RS, CPose2D(2,1.5,0), true);
+
+	const size_t N = 50;
+	vector<TParticle> samples;
+	randomGenerator.randomize(333);
+	RS.rejectionSamplingParallel(N, samples, 20, 3);
+	ASSERT_EQ(samples.size(), N);
+
+	size_t nWeighted = 0;
+	for (size_t i=0;i<N;i++)
+		if (samples[i].log_w!=0)
+		{
+			nWeighted++;
+			EXPECT_LT(samples[i].log_w, 0);
+		}
+	EXPECT_GT(nWeighted, 0u);
+
+	free_samples(samples);
+}
+
+TEST(CRejectionSamplingRangeOnlyLocalization, ParallelSamplingNoTrials)
+{
+	// No trials allowed: like rejectionSampling(), one candidate per sample.
+	CRejectionSamplingRangeOnlyLocalization RS;
+	setup_range_only_localization(RS, CPose2D(2,1.5,0), true);
+
+	const size_t N = 20;
+	vector<TParticle> samples;
+	randomGenerator.randomize(333);
+	RS.rejectionSamplingParallel(N, samples, 0, 2);
+	ASSERT_EQ(samples.size(), N);
+	for (size_t i=0;i<N;i++)
+		EXPECT_LE(samples[i].log_w, 0);
+
+	free_samples(samples);
+}
@@ -0,0 +1,69 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/slam/PF_aux_structs.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+#include <set>
+
+using namespace mrpt;
+using namespace mrpt::slam::detail;
+using namespace std;
+
+TEST(TKLDBinsHashSet, InsertAndClear)
+{
+	TKLDBinsHashSet<TPoseBin2D> bins;
+	EXPECT_TRUE(bins.empty());
+
+	mrpt::random::randomGenerator.randomize(1234);
+	for (int iter=0;iter<3;iter++)
+	{
+		// Many repeated bins in a small volume, so both new and existing bins are inserted, and the table grows:
+		set<TPoseBin2D,TPoseBin2D::lt_operator> ref;
+		for (int k=0;k<5000;k++)
+		{
+			TPoseBin2D b;
+			b.x = static_cast<int>(mrpt::random::randomGenerator.drawUniform32bit()%20) - 10;
+			b.y = static_cast<int>(mrpt::random::randomGenerator.drawUniform32bit()%20) - 10;
+			b.phi = static_cast<int>(mrpt::random::randomGenerator.drawUniform32bit()%8);
+
+			const size_t old_size = bins.size();
+			bool is_new;
+			const size_t idx = bins.insert(b,&is_new);
+			EXPECT_EQ(is_new, ref.insert(b).second);
+			ASSERT_LT(idx, bins.size());
+			EXPECT_TRUE(bins[idx]==b);
+			if (is_new) { EXPECT_EQ(idx, old_size); }
+			else { EXPECT_EQ(bins.size(), old_size); }
+
+			// Inserting it again returns the same index:
+			EXPECT_EQ(bins.insert(b), idx);
+		}
+		EXPECT_EQ(bins.size(), ref.size());
+
+		bins.clear();
+		EXPECT_TRUE(bins.empty());
+	}
+}
+
+TEST(TKLDBinsHashSet, PathBins)
+{
+	TKLDBinsHashSet<TPathBin2D> bins;
+	TPathBin2D a, b;
+	a.bins.resize(3);
+	b.bins.resize(3);
+	for (int i=0;i<3;i++) { a.bins[i].x = b.bins[i].x = i; }
+	b.bins[2].phi = 1;
+
+	bool is_new;
+	EXPECT_EQ(bins.insert(a,&is_new), 0u); EXPECT_TRUE(is_new);
+	EXPECT_EQ(bins.insert(b,&is_new), 1u); EXPECT_TRUE(is_new);
+	EXPECT_EQ(bins.insert(a,&is_new), 0u); EXPECT_FALSE(is_new);
+	EXPECT_EQ(bins.size(), 2u);
+}
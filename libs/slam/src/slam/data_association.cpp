@@ -33,6 +33,7 @@
 
 #include <mrpt/otherlibs/nanoflann/nanoflann.hpp> // For kd-tree's
 #include <mrpt/math/KDTreeCapable.h>   // For kd-tree's
+#include <mrpt/system/threads.h>  // parallelForBlocks()
 
 using namespace std;
 using namespace mrpt;
@@ -46,75 +47,221 @@ namespace mrpt
 {
 namespace slam
 {
+	/** The Cholesky factorization of the covariance of each individual prediction, computed once and reused for all the observations */
+	struct TAuxPredictionsCholesky
+	{
+		std::vector<Eigen::MatrixXd>  L;       //!< Lower triangular factors (empty if the covariance is not positive definite)
+		std::vector<double>           log_det; //!< log(det(cov))
+		double  max_trace; //!< The largest trace, an upper bound of the largest eigenvalue of all the covariances
+		bool    all_ok;    //!< Whether all the covariances are positive definite
+
+		void compute(const CMatrixDouble &Y_predictions_cov, const size_t nPredictions, const size_t length_O)
+		{
+			L.resize(nPredictions);
+			log_det.assign(nPredictions,0);
+			max_trace = 0;
+			all_ok = true;
+			for (size_t i=0;i<nPredictions;i++)
+			{
+				const Eigen::MatrixXd cov = Y_predictions_cov.block(i*length_O,i*length_O,length_O,length_O);
+				max_trace = std::max(max_trace, cov.trace());
+				const Eigen::LLT<Eigen::MatrixXd> llt(cov);
+				if (llt.info()!=Eigen::Success)
+				{
+					L[i].resize(0,0);
+					all_ok = false;
+					continue;
+				}
+				L[i] = llt.matrixL();
+				log_det[i] = 2*L[i].diagonal().array().log().sum();
+			}
+		}
+
+		/** Like mrpt::math::mahalanobisDistance2AndLogPDF() for the prediction "i". "diff_mean" is overwritten. */
+		void evaluate(const CMatrixDouble &Y_predictions_cov, const size_t i, Eigen::VectorXd &diff_mean, double &d2, double &log_pdf) const
+		{
+			const size_t length_O = diff_mean.size();
+			if (!L[i].rows())
+			{	// Not positive definite: use the generic method
+				CMatrixDouble pred_i_cov(length_O,length_O);
+				Y_predictions_cov.extractMatrix(i*length_O,i*length_O,length_O,length_O, pred_i_cov);
+				mrpt::math::mahalanobisDistance2AndLogPDF(diff_mean,pred_i_cov, d2,log_pdf);
+				return;
+			}
+			L[i].triangularView<Eigen::Lower>().solveInPlace(diff_mean);
+			d2 = diff_mean.squaredNorm();
+			log_pdf = -0.5*( d2 + length_O*::log(M_2PI) + log_det[i] );
+		}
+	};
+
+	/** Evaluates the individual compatibility of the observations [first,last) with all the predictions, or with those within
+	  *  a Euclidean gate around each observation if a KD-tree is given. Only writes the columns of those observations in "results". */
+	struct TAuxIndividualCompatibility
+	{
+		const CMatrixDouble  &Z_observations_mean, &Y_predictions_mean, &Y_predictions_cov;
+		const TAuxPredictionsCholesky  &chol;
+		const nanoflann::KDTreeEigenMatrixAdaptor<CMatrixDouble>  *kd_tree; //!< NULL: evaluate all the predictions
+		double  kd_gate_sqr_radius;
+		TDataAssociationMetric  metric, compatibilityTestMetric;
+		double  chi2thres, log_ML_compat_test_threshold;
+		TDataAssociationResults  &results;
+
+		TAuxIndividualCompatibility(
+			const CMatrixDouble &Z_observations_mean_, const CMatrixDouble &Y_predictions_mean_, const CMatrixDouble &Y_predictions_cov_,
+			const TAuxPredictionsCholesky &chol_, TDataAssociationResults &results_) :
+			Z_observations_mean(Z_observations_mean_), Y_predictions_mean(Y_predictions_mean_), Y_predictions_cov(Y_predictions_cov_),
+			chol(chol_), kd_tree(NULL), kd_gate_sqr_radius(0), metric(metricMaha), compatibilityTestMetric(metricMaha),
+			chi2thres(0), log_ML_compat_test_threshold(0), results(results_)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			const size_t nPredictions = size(Y_predictions_mean,1);
+			const size_t length_O = size(Z_observations_mean,2);
+
+			Eigen::VectorXd  diff_means_i_j(length_O);
+			std::vector<double>  kd_queryPoint(length_O);
+			std::vector<std::pair<CMatrixDouble::Index,double> >  kd_matches;
+
+			for (size_t j=first;j<last;++j)
+			{
+				if (!kd_tree)
+				{
+					// Compute all the distances w/o a KD-tree
+					for (size_t i=0;i<nPredictions;++i)
+						evaluatePair(i,j,diff_means_i_j);
+				}
+				else
+				{
+					// Only the predictions within the gate:
+					for (size_t k=0;k<length_O;k++)
+						kd_queryPoint[k] = Z_observations_mean.get_unsafe(j,k);
+
+					kd_tree->index->radiusSearch(&kd_queryPoint[0], kd_gate_sqr_radius, kd_matches, nanoflann::SearchParams(32,0,false) );
+
+					for (size_t w=0;w<kd_matches.size();w++)
+						evaluatePair(kd_matches[w].first,j,diff_means_i_j);
+				}
+			}
+		}
+
+		void evaluatePair(const size_t i, const size_t j, Eigen::VectorXd &diff_means_i_j)
+		{
+			const size_t length_O = diff_means_i_j.size();
+			for (size_t k=0;k<length_O;k++)
+				diff_means_i_j[k] = Z_observations_mean.get_unsafe(j,k) - Y_predictions_mean.get_unsafe(i,k);
+
+			// Evaluate sqr. mahalanobis distance of obs_j -> pred_i:
+			double d2, ml;
+			chol.evaluate(Y_predictions_cov, i, diff_means_i_j, d2, ml);
+
+			// The distance according to the metric
+			results.indiv_distances(i,j) = (metric==metricMaha) ? d2 : ml;
+
+			// Individual compatibility
+			const bool IC =  (compatibilityTestMetric==metricML) ? (ml > log_ML_compat_test_threshold) : (d2 < chi2thres);
+			results.indiv_compatibility(i,j) = IC;
+			if (IC)
+				results.indiv_compatibility_counts[j]++;
+		}
+	};
+
 	struct TAuxDataRecursiveJCBB
 	{
 		size_t nPredictions, nObservations, length_O; //!< Just to avoid recomputing them all the time.
 		std::map<size_t,size_t>	currentAssociation;
+		Eigen::MatrixXd  L; //!< Cholesky factor of the joint covariance of the predictions in "currentAssociation" (in the order of the observations)
+		Eigen::VectorXd  v; //!< L^-1 times the joint innovation, so the joint squared Mahalanobis distance is v^t*v
+		bool  L_ok;         //!< False if the joint covariance is not positive definite
+	};
+
+	/** The best hypothesis found by JCBB so far */
+	struct TAuxBestJCBB
+	{
+		std::map<observation_index_t,prediction_index_t> associations;
+		double  distance;
+		size_t  nNodesExplored;
 	};
 
-/**  Computes the joint distance metric (mahalanobis or matching likelihood) between two  a set of associations
+/** Builds "new_info" from "info" plus the pairing obsIdx->predIdx, extending the Cholesky factor of the joint covariance with
+  *  one block row: if C = L*L^t and the new prediction has cross-covariances B and covariance D, then the new block row of L is
+  *  [ (L^-1*B)^t  chol(D-(L^-1*B)^t*(L^-1*B)) ]
+  */
+void JCBB_addPairing(
+	const CMatrixDouble		&Z_observations_mean,
+	const CMatrixDouble		&Y_predictions_mean,
+	const CMatrixDouble		&Y_predictions_cov,
+	const TAuxDataRecursiveJCBB		&info,
+	const observation_index_t		obsIdx,
+	const prediction_index_t		predIdx,
+	TAuxDataRecursiveJCBB			&new_info)
+{
+	const size_t O = info.length_O;
+	const size_t k = info.currentAssociation.size()*O;
+
+	new_info.nPredictions = info.nPredictions;
+	new_info.nObservations = info.nObservations;
+	new_info.length_O = O;
+	new_info.currentAssociation = info.currentAssociation;
+	new_info.currentAssociation[obsIdx] = predIdx;
+	new_info.L_ok = info.L_ok;
+	if (!info.L_ok) return;
+
+	// Cross-covariances with the predictions already paired, and the innovation of the new pairing:
+	Eigen::MatrixXd  B(k,O);
+	size_t r=0;
+	for (map<size_t,size_t>::const_iterator it=info.currentAssociation.begin();it!=info.currentAssociation.end();++it, r+=O)
+		B.middleRows(r,O) = Y_predictions_cov.block(it->second*O,predIdx*O,O,O);
+
+	Eigen::VectorXd  nu(O);
+	for (size_t q=0;q<O;q++)
+		nu[q] = Y_predictions_mean.get_unsafe(predIdx,q)-Z_observations_mean.get_unsafe(obsIdx,q);
+
+	Eigen::MatrixXd  D = Y_predictions_cov.block(predIdx*O,predIdx*O,O,O);
+	if (k)
+	{
+		info.L.triangularView<Eigen::Lower>().solveInPlace(B);
+		D.noalias() -= B.transpose()*B;
+		nu.noalias() -= B.transpose()*info.v;
+	}
+
+	const Eigen::LLT<Eigen::MatrixXd> llt(D);
+	if (llt.info()!=Eigen::Success)
+	{
+		new_info.L_ok = false;
+		return;
+	}
+
+	new_info.L.resize(k+O,k+O);
+	new_info.L.topLeftCorner(k,k) = info.L;
+	new_info.L.topRightCorner(k,O).setZero();
+	new_info.L.bottomLeftCorner(O,k) = B.transpose();
+	new_info.L.bottomRightCorner(O,O) = llt.matrixL();
+
+	llt.matrixL().solveInPlace(nu);
+	new_info.v.resize(k+O);
+	new_info.v.head(k) = info.v;
+	new_info.v.tail(O) = nu;
+}
+
+/**  Computes the joint distance metric (mahalanobis or matching likelihood) of the set of associations in "info.currentAssociation",
+  *   from the Cholesky factor of their joint covariance.
   *
   * On "currentAssociation":  maps "ID_obs" -> "ID_pred"
   *  For each landmark ID in the observations (ID_obs), its association
   *  in the predictions, that is: ID_pred = associations[ID_obs]
   *
   */
-template <typename T, TDataAssociationMetric METRIC>
-double joint_pdf_metric (
-	const CMatrixTemplateNumeric<T>		&Z_observations_mean,
-	const CMatrixTemplateNumeric<T>		&Y_predictions_mean,
-	const CMatrixTemplateNumeric<T>		&Y_predictions_cov,
-	const TAuxDataRecursiveJCBB			&info,
-	const TDataAssociationResults	&aux_data)
+template <TDataAssociationMetric METRIC>
+double joint_pdf_metric(const TAuxDataRecursiveJCBB &info)
 {
-	MRPT_UNUSED_PARAM(aux_data);
-	// Make a list of the indices of the predictions that appear in "currentAssociation":
-	const size_t  N = info.currentAssociation.size();
-	ASSERT_(N>0)
-
-	vector_size_t  indices_pred(N);  // Appearance order indices in the std::maps
-	vector_size_t  indices_obs(N);
-
-	{
-		size_t i=0;
-		for (map<size_t,size_t>::const_iterator it=info.currentAssociation.begin();it!=info.currentAssociation.end();++it)
-		{
-			indices_obs[i]  = it->first;
-			indices_pred[i] = it->second;
-			i++;
-		}
-	}
+	ASSERT_(!info.currentAssociation.empty())
 
-	// ----------------------------------------------------------------------
-	// Extract submatrix of the covariances involved here:
-	//  COV = PREDICTIONS_COV(INDX,INDX) + OBSERVATIONS_COV(INDX2,INDX2)
-	// ----------------------------------------------------------------------
-	Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic> COV;
-	Y_predictions_cov.extractSubmatrixSymmetricalBlocks(
-		info.length_O, // dims of cov. submatrices
-		indices_pred,
-		COV );
-
-	// ----------------------------------------------------------------------
-	// Mean:
-	// The same for the vector of "errors" or "innovation" between predictions and observations:
-	// ----------------------------------------------------------------------
-	Eigen::Matrix<T,Eigen::Dynamic,1>  innovations(N * info.length_O);
-	T *dst_ptr= &innovations[0];
-	for (map<size_t,size_t>::const_iterator it=info.currentAssociation.begin();it!=info.currentAssociation.end();++it)
-	{
-		const T *pred_i_mean = Y_predictions_mean.get_unsafe_row( it->second );
-		const T *obs_i_mean  = Z_observations_mean.get_unsafe_row( it->first );
-
-		for (unsigned int k=0;k<info.length_O;k++)
-			*dst_ptr++ = pred_i_mean[k]-obs_i_mean[k];
-	}
+	if (!info.L_ok)
+		return (METRIC==metricMaha) ? std::numeric_limits<double>::max() : 0;
 
 	// Compute mahalanobis distance squared:
-	CMatrixTemplateNumeric<T>	COV_inv;
-	COV.inv_fast(COV_inv);
-
-	const double d2 = mrpt::math::multiply_HCHt_scalar(innovations, COV_inv);
+	const double d2 = info.v.squaredNorm();
 
 	if (METRIC==metricMaha)
 		return d2;
@@ -122,8 +269,8 @@ double joint_pdf_metric (
 	ASSERT_(METRIC==metricML);
 
 	// Matching likelihood: The evaluation at 0 of the PDF of the difference between the two Gaussians:
-	const T cov_det = COV.det();
-	const double ml = exp(-0.5*d2) / ( std::pow(M_2PI, info.length_O * 0.5) * std::sqrt(cov_det) );
+	const double log_cov_det = 2*info.L.diagonal().array().log().sum();
+	const double ml = exp(-0.5*(d2+log_cov_det)) / std::pow(M_2PI, info.length_O * 0.5);
 	return ml;
 }
 
@@ -136,6 +283,14 @@ bool isCloser<metricMaha>(const double v1, const double v2) { return v1<v2; }
 template<>
 bool isCloser<metricML>(const double v1, const double v2) { return v1>v2; }
 
+/** Whether predIdx is already in "currentAssociation" */
+bool JCBB_isAlreadyAssigned(const TAuxDataRecursiveJCBB &info, const prediction_index_t predIdx)
+{
+	for (map<size_t,size_t>::const_iterator itS=info.currentAssociation.begin();itS!=info.currentAssociation.end();++itS)
+		if (itS->second==predIdx)
+			return true;
+	return false;
+}
 
 /* Based on MATLAB code by:
   University of Zaragoza
@@ -144,12 +299,13 @@ bool isCloser<metricML>(const double v1, const double v2) { return v1>v2; }
   Authors of the original MATLAB code:  J. Neira, J. Tardos
   C++ version: J.L. Blanco Claraco
 */
-template <typename T, TDataAssociationMetric METRIC>
+template <TDataAssociationMetric METRIC>
 void JCBB_recursive(
-	const mrpt::math::CMatrixTemplateNumeric<T>		&Z_observations_mean,
-	const mrpt::math::CMatrixTemplateNumeric<T>		&Y_predictions_mean,
-	const mrpt::math::CMatrixTemplateNumeric<T>		&Y_predictions_cov,
-	TDataAssociationResults			&results,
+	const mrpt::math::CMatrixDouble		&Z_observations_mean,
+	const mrpt::math::CMatrixDouble		&Y_predictions_mean,
+	const mrpt::math::CMatrixDouble		&Y_predictions_cov,
+	const TDataAssociationResults	&results,
+	TAuxBestJCBB					&best,
 	const TAuxDataRecursiveJCBB		&info,
 	const observation_index_t		curObsIdx
 	)
@@ -157,29 +313,21 @@ void JCBB_recursive(
 	// End of iteration?
 	if (curObsIdx>=info.nObservations)
 	{
-		if (info.currentAssociation.size()>results.associations.size())
+		if (info.currentAssociation.size()>best.associations.size())
 		{
 			// It's a better choice since more features are matched.
-			results.associations = info.currentAssociation;
-			results.distance = joint_pdf_metric<T,METRIC>(
-				Z_observations_mean,
-				Y_predictions_mean,  Y_predictions_cov,
-				info,
-				results);
+			best.associations = info.currentAssociation;
+			best.distance = joint_pdf_metric<METRIC>(info);
 		}
-		else if ( !info.currentAssociation.empty() && info.currentAssociation.size()==results.associations.size() )
+		else if ( !info.currentAssociation.empty() && info.currentAssociation.size()==best.associations.size() )
 		{
 			// The same # of features matched than the previous best one... decide by better distance:
-			const double d2 = joint_pdf_metric<T,METRIC>(
-				Z_observations_mean,
-				Y_predictions_mean,  Y_predictions_cov,
-				info,
-				results);
+			const double d2 = joint_pdf_metric<METRIC>(info);
 
-			if (isCloser<METRIC>(d2,results.distance))
+			if (isCloser<METRIC>(d2,best.distance))
 			{
-				results.associations = info.currentAssociation;
-				results.distance = d2;
+				best.associations = info.currentAssociation;
+				best.distance = d2;
 			}
 		}
 	}
@@ -190,60 +338,144 @@ void JCBB_recursive(
 
 		const size_t nPreds = results.indiv_compatibility.getRowCount();
 
-		// Can we do it better than the current "results.associations"?
+		// Can we do it better than the current "best.associations"?
 		// This can be checked by counting the potential new pairings+the so-far established ones.
 		//    Matlab: potentials  = pairings(compatibility.AL(i+1:end))
 		// Moved up by Kasra Khosoussi
 		const size_t potentials = std::accumulate( results.indiv_compatibility_counts.begin()+(obsIdx+1), results.indiv_compatibility_counts.end(),0 );
 		for (prediction_index_t predIdx=0;predIdx<nPreds;predIdx++)
 		{
-			if ((info.currentAssociation.size() + potentials) >= results.associations.size())
+			if ((info.currentAssociation.size() + potentials) >= best.associations.size())
 			{
 				// Only if predIdx is NOT already assigned:
-				if ( results.indiv_compatibility(predIdx,obsIdx) )
+				if ( results.indiv_compatibility(predIdx,obsIdx) && !JCBB_isAlreadyAssigned(info,predIdx) )
 				{
-					// Only if predIdx is NOT already assigned:
-					bool already_asigned = false;
-					for (map<size_t,size_t>::const_iterator itS=info.currentAssociation.begin();itS!=info.currentAssociation.end();++itS)
-					{
-						if (itS->second==predIdx)
-						{
-							already_asigned = true;
-							break;
-						}
-					}
-
-					if (!already_asigned)
-					{
-						// Launch a new recursive line for this hipothesis:
-						TAuxDataRecursiveJCBB new_info = info;
-						new_info.currentAssociation[ curObsIdx ] = predIdx;
+					// Launch a new recursive line for this hipothesis:
+					TAuxDataRecursiveJCBB new_info;
+					JCBB_addPairing(Z_observations_mean, Y_predictions_mean, Y_predictions_cov, info, curObsIdx, predIdx, new_info);
 
-						results.nNodesExploredInJCBB++;
+					best.nNodesExplored++;
 
-						JCBB_recursive<T,METRIC>(
-							Z_observations_mean, Y_predictions_mean, Y_predictions_cov,
-							results, new_info, curObsIdx+1);
-					}
+					JCBB_recursive<METRIC>(
+						Z_observations_mean, Y_predictions_mean, Y_predictions_cov,
+						results, best, new_info, curObsIdx+1);
 				}
 			}
 		}
 
-		// Can we do it better than the current "results.associations"?
-		if ((info.currentAssociation.size() + potentials) >= results.associations.size() )
+		// Can we do it better than the current "best.associations"?
+		if ((info.currentAssociation.size() + potentials) >= best.associations.size() )
 		{
 			// Yes we can </obama>
 
 			// star node: Ei not paired
-			results.nNodesExploredInJCBB++;
-			JCBB_recursive<T,METRIC>(
+			best.nNodesExplored++;
+			JCBB_recursive<METRIC>(
 				Z_observations_mean,  Y_predictions_mean, Y_predictions_cov,
-				results, info, curObsIdx+1);
+				results, best, info, curObsIdx+1);
 		}
 	}
 }
 
+/** Runs JCBB_recursive() for consecutive nodes of the first levels of the search tree, keeping one best hypothesis per block of nodes */
+template <TDataAssociationMetric METRIC>
+struct TAuxParallelJCBB
+{
+	const CMatrixDouble  &Z_observations_mean, &Y_predictions_mean, &Y_predictions_cov;
+	const TDataAssociationResults  &results;
+	const std::vector<std::pair<TAuxDataRecursiveJCBB,observation_index_t> >  &nodes;
+	std::vector<TAuxBestJCBB>  &bests; //!< One per block
+
+	TAuxParallelJCBB(
+		const CMatrixDouble &Z_observations_mean_, const CMatrixDouble &Y_predictions_mean_, const CMatrixDouble &Y_predictions_cov_,
+		const TDataAssociationResults &results_, const std::vector<std::pair<TAuxDataRecursiveJCBB,observation_index_t> > &nodes_,
+		std::vector<TAuxBestJCBB> &bests_) :
+		Z_observations_mean(Z_observations_mean_), Y_predictions_mean(Y_predictions_mean_), Y_predictions_cov(Y_predictions_cov_),
+		results(results_), nodes(nodes_), bests(bests_)
+	{}
+
+	void operator()(size_t first, size_t last, unsigned int block_index)
+	{
+		for (size_t n=first;n<last;n++)
+			JCBB_recursive<METRIC>(
+				Z_observations_mean,  Y_predictions_mean, Y_predictions_cov,
+				results, bests[block_index], nodes[n].first, nodes[n].second);
+	}
+};
 
+/** JCBB from several threads: the first levels of the search tree are expanded (in depth-first order) until there are enough
+  *  nodes for all the threads, then each thread explores the subtrees of a block of consecutive nodes. Merging the best hypotheses
+  *  of the blocks in order gives the same result than the sequential search, although with less pruning.
+  */
+template <TDataAssociationMetric METRIC>
+void JCBB_parallel(
+	const mrpt::math::CMatrixDouble		&Z_observations_mean,
+	const mrpt::math::CMatrixDouble		&Y_predictions_mean,
+	const mrpt::math::CMatrixDouble		&Y_predictions_cov,
+	const TDataAssociationResults	&results,
+	TAuxBestJCBB					&best,
+	const TAuxDataRecursiveJCBB		&info,
+	const unsigned int				nThreads
+	)
+{
+	typedef std::vector<std::pair<TAuxDataRecursiveJCBB,observation_index_t> > node_list_t;
+	const size_t nPreds = results.indiv_compatibility.getRowCount();
+
+	node_list_t  nodes(1, std::make_pair(info,observation_index_t(0)));
+	bool expanded = true;
+	while (expanded && nodes.size()<4*nThreads)
+	{
+		// (There is no best hypothesis yet, hence no pruning while expanding)
+		node_list_t  next_nodes;
+		expanded = false;
+		for (size_t n=0;n<nodes.size();n++)
+		{
+			const TAuxDataRecursiveJCBB &node = nodes[n].first;
+			const observation_index_t obsIdx = nodes[n].second;
+			if (obsIdx>=node.nObservations)
+			{	// A leaf:
+				next_nodes.push_back(nodes[n]);
+				continue;
+			}
+			expanded = true;
+			for (prediction_index_t predIdx=0;predIdx<nPreds;predIdx++)
+			{
+				if ( results.indiv_compatibility(predIdx,obsIdx) && !JCBB_isAlreadyAssigned(node,predIdx) )
+				{
+					next_nodes.push_back(std::make_pair(TAuxDataRecursiveJCBB(),obsIdx+1));
+					JCBB_addPairing(Z_observations_mean, Y_predictions_mean, Y_predictions_cov, node, obsIdx, predIdx, next_nodes.back().first);
+					best.nNodesExplored++;
+				}
+			}
+			// star node: Ei not paired
+			next_nodes.push_back(std::make_pair(node,obsIdx+1));
+			best.nNodesExplored++;
+		}
+		nodes.swap(next_nodes);
+	}
+
+	std::vector<TAuxBestJCBB>  bests(nThreads);
+	for (unsigned int b=0;b<nThreads;b++)
+	{
+		bests[b].distance = best.distance;
+		bests[b].nNodesExplored = 0;
+	}
+
+	TAuxParallelJCBB<METRIC> functor(Z_observations_mean,Y_predictions_mean,Y_predictions_cov, results, nodes, bests);
+	const unsigned int nBlocks = mrpt::system::parallelForBlocks(nodes.size(), functor, nThreads);
+
+	// Merge, with the same criterion than for the leaves in JCBB_recursive():
+	for (unsigned int b=0;b<nBlocks;b++)
+	{
+		best.nNodesExplored += bests[b].nNodesExplored;
+		if (bests[b].associations.size()>best.associations.size() ||
+			( !bests[b].associations.empty() && bests[b].associations.size()==best.associations.size() && isCloser<METRIC>(bests[b].distance,best.distance) ) )
+		{
+			best.associations.swap(bests[b].associations);
+			best.distance = bests[b].distance;
+		}
+	}
+}
 
 } // end namespace
 } // end namespace
@@ -268,6 +500,7 @@ Computes the data-association between the prediction of a set of landmarks and t
 * \param chi2quantile [IN, optional] The threshold for considering a match between two close Gaussians for two landmarks, in the range [0,1]. It is used to call mrpt::math::chi2inv
 * \param use_kd_tree [IN, optional] Build a KD-tree to speed-up the evaluation of individual compatibility (IC). It's perhaps more efficient to disable it for a small number of features. (default=true).
 * \param predictions_IDs [IN, optional] (default:none) An N-vector. If provided, the resulting associations in "results.associations" will not contain prediction indices "i", but "predictions_IDs[i]".
+* \param num_threads [IN, optional] (default:1) Number of threads for the individual compatibility tests and the JCBB search (0: one per core).
 *
  ==================================================================================================  */
 void mrpt::slam::data_association_full_covariance(
@@ -281,7 +514,8 @@ void mrpt::slam::data_association_full_covariance(
 	const bool							DAT_ASOC_USE_KDTREE,
 	const std::vector<prediction_index_t>		&predictions_IDs,
 	const TDataAssociationMetric		compatibilityTestMetric,
-	const double						log_ML_compat_test_threshold
+	const double						log_ML_compat_test_threshold,
+	const unsigned int					num_threads
 	)
 {
 	// For details on the theory, see the papers cited at the beginning of this file.
@@ -308,25 +542,11 @@ void mrpt::slam::data_association_full_covariance(
 
 	const double chi2thres = mrpt::math::chi2inv( chi2quantile, length_O );
 
-	// ------------------------------------------------------------
-	// Build a KD-tree of the predictions for quick look-up:
-	// ------------------------------------------------------------
-#if MRPT_HAS_CXX11
-	typedef std::unique_ptr<KDTreeEigenMatrixAdaptor<CMatrixDouble> > KDTreeMatrixPtr;
-#else
-	typedef std::auto_ptr<KDTreeEigenMatrixAdaptor<CMatrixDouble> > KDTreeMatrixPtr;
-#endif
-	KDTreeMatrixPtr  kd_tree;
-	const size_t N_KD_RESULTS = nPredictions;
-	std::vector<double>	kd_result_distances(DAT_ASOC_USE_KDTREE ? N_KD_RESULTS : 0);
-	std::vector<CMatrixDouble::Index> kd_result_indices(DAT_ASOC_USE_KDTREE ? N_KD_RESULTS : 0);
-	std::vector<double>	kd_queryPoint(DAT_ASOC_USE_KDTREE ? length_O : 0);
+	const unsigned int nThreads = num_threads ? num_threads : mrpt::system::getNumberOfProcessors();
 
-	if (DAT_ASOC_USE_KDTREE)
-	{
-		// Construct kd-tree for the predictions:
-		kd_tree = KDTreeMatrixPtr( new KDTreeEigenMatrixAdaptor<CMatrixDouble>(length_O, Y_predictions_mean) );
-	}
+	// Cholesky factorization of the covariance of each prediction, reused for all the observations:
+	TAuxPredictionsCholesky  pred_chol;
+	pred_chol.compute(Y_predictions_cov, nPredictions, length_O);
 
 	// Initialize with the worst possible distance:
 	results.distance = (metric==metricML) ? 0 : std::numeric_limits<double>::max();
@@ -344,79 +564,42 @@ void mrpt::slam::data_association_full_covariance(
 			-1000 /*A very small log-likelihoo   */ );
 	results.indiv_compatibility.fillAll(false);
 
-	CMatrixDouble pred_i_cov(length_O,length_O);
+	TAuxIndividualCompatibility  IC_evaluator(Z_observations_mean,Y_predictions_mean,Y_predictions_cov, pred_chol, results);
+	IC_evaluator.metric = metric;
+	IC_evaluator.compatibilityTestMetric = compatibilityTestMetric;
+	IC_evaluator.chi2thres = chi2thres;
+	IC_evaluator.log_ML_compat_test_threshold = log_ML_compat_test_threshold;
 
-	Eigen::VectorXd  diff_means_i_j(length_O);
+	// ------------------------------------------------------------
+	// Build a KD-tree of the predictions for gating:
+	//  An individually compatible prediction i of observation j has d2 = e^t * C_i^-1 * e < d2_max_i,
+	//  hence |e|^2 <= d2_max_i * lambda_max(C_i) <= d2_max_i * trace(C_i), so a radius search with
+	//  the largest of these bounds never misses a compatible prediction.
+	// ------------------------------------------------------------
+#if MRPT_HAS_CXX11
+	typedef std::unique_ptr<KDTreeEigenMatrixAdaptor<CMatrixDouble> > KDTreeMatrixPtr;
+#else
+	typedef std::auto_ptr<KDTreeEigenMatrixAdaptor<CMatrixDouble> > KDTreeMatrixPtr;
+#endif
+	KDTreeMatrixPtr  kd_tree;
 
-	for (size_t j=0;j<nObservations;++j)
+	if (DAT_ASOC_USE_KDTREE && pred_chol.all_ok)
 	{
-		if (!DAT_ASOC_USE_KDTREE)
-		{
-			// Compute all the distances w/o a KD-tree
-			for (size_t i=0;i<nPredictions;++i)
-			{
-				// Evaluate sqr. mahalanobis distance of obs_j -> pred_i:
-				const size_t pred_cov_idx = i*length_O;  // Extract the submatrix from the diagonal:
-				Y_predictions_cov.extractMatrix(pred_cov_idx,pred_cov_idx,length_O,length_O, pred_i_cov);
-
-				for (size_t k=0;k<length_O;k++)
-					diff_means_i_j[k] = Z_observations_mean.get_unsafe(j,k) - Y_predictions_mean.get_unsafe(i,k);
-
-				double d2, ml;
-				//mrpt::math::productIntegralAndMahalanobisTwoGaussians(diff_means_i_j,pred_i_cov,obs_j_cov, d2,ml);
-				mrpt::math::mahalanobisDistance2AndLogPDF(diff_means_i_j,pred_i_cov, d2,ml);
-
-				// The distance according to the metric
-				double val =  (metric==metricMaha) ? d2 : ml;
-
-				results.indiv_distances(i,j) = val;
-
-				// Individual compatibility
-				const bool IC =  (compatibilityTestMetric==metricML) ? (ml > log_ML_compat_test_threshold) : (d2 < chi2thres);
-				results.indiv_compatibility(i,j)=IC;
-				if (IC)
-					results.indiv_compatibility_counts[j]++;
-			}
+		double max_d2 = chi2thres;
+		if (compatibilityTestMetric==metricML)
+		{	// log_pdf = -0.5*(d2 + O*log(2*pi) + log(det(C_i))) > threshold:
+			max_d2 = 0;
+			for (size_t i=0;i<nPredictions;i++)
+				max_d2 = std::max(max_d2, -2*log_ML_compat_test_threshold - length_O*::log(M_2PI) - pred_chol.log_det[i] );
 		}
-		else
-		{
-			// Use a kd-tree and compute only the N closest ones:
-			for (size_t k=0;k<length_O;k++)
-				kd_queryPoint[k] = Z_observations_mean.get_unsafe(j,k);
 
-			kd_tree->query(&kd_queryPoint[0], N_KD_RESULTS, &kd_result_indices[0], &kd_result_distances[0] );
-
-			// Only compute the distances for these ones:
-			for (size_t w=0;w<N_KD_RESULTS;w++)
-			{
-				const size_t i = kd_result_indices[w];  // This is the index of the prediction in "predictions_mean"
-
-				// Build the PDF of the prediction:
-				const size_t pred_cov_idx = i*length_O;  // Extract the submatrix from the diagonal:
-				Y_predictions_cov.extractMatrix(pred_cov_idx,pred_cov_idx,length_O,length_O, pred_i_cov);
-
-				for (size_t k=0;k<length_O;k++)
-					diff_means_i_j[k] = Z_observations_mean.get_unsafe(j,k) - Y_predictions_mean.get_unsafe(i,k);
-
-				double d2, ml;
-//				mrpt::math::productIntegralAndMahalanobisTwoGaussians(diff_means_i_j,pred_i_cov,obs_j_cov, d2,ml);
-				mrpt::math::mahalanobisDistance2AndLogPDF(diff_means_i_j,pred_i_cov, d2,ml);
-
-				if (d2>6*chi2thres) break; // Since kd-tree returns the landmarks by distance order, we can skip the rest
-
-				// The distance according to the metric
-				double val =  (metric==metricMaha) ? d2 : ml;
-
-				results.indiv_distances(i,j) = val;
+		// Construct kd-tree for the predictions:
+		kd_tree = KDTreeMatrixPtr( new KDTreeEigenMatrixAdaptor<CMatrixDouble>(length_O, Y_predictions_mean) );
+		IC_evaluator.kd_tree = kd_tree.get();
+		IC_evaluator.kd_gate_sqr_radius = max_d2 * pred_chol.max_trace;
+	}
 
-				// Individual compatibility
-				const bool IC =  (compatibilityTestMetric==metricML) ? (ml > log_ML_compat_test_threshold) : (d2 < chi2thres);
-				results.indiv_compatibility(i,j) = IC;
-				if (IC)
-					results.indiv_compatibility_counts[j]++;
-			}
-		} // end use KD-Tree
-	} // end for
+	mrpt::system::parallelForBlocks(nObservations, IC_evaluator, nThreads);
 
 #if 0
 	cout << "Distances: " << endl << results.indiv_distances << endl;
@@ -496,11 +679,30 @@ void mrpt::slam::data_association_full_covariance(
 			info.nPredictions	= nPredictions;
 			info.nObservations	= nObservations;
 			info.length_O		= length_O;
+			info.L_ok			= true;
 
-			if (metric==metricMaha)
-				JCBB_recursive<CMatrixDouble::Scalar,metricMaha>(Z_observations_mean,  Y_predictions_mean, Y_predictions_cov,results, info, 0 );
+			TAuxBestJCBB  best;
+			best.distance = results.distance;
+			best.nNodesExplored = 0;
+
+			if (nThreads>1 && nObservations>1)
+			{
+				if (metric==metricMaha)
+					JCBB_parallel<metricMaha>(Z_observations_mean,  Y_predictions_mean, Y_predictions_cov,results, best, info, nThreads );
+				else
+					JCBB_parallel<metricML>(Z_observations_mean,  Y_predictions_mean, Y_predictions_cov,results, best, info, nThreads );
+			}
 			else
-				JCBB_recursive<CMatrixDouble::Scalar,metricML>(Z_observations_mean,  Y_predictions_mean, Y_predictions_cov,results, info, 0 );
+			{
+				if (metric==metricMaha)
+					JCBB_recursive<metricMaha>(Z_observations_mean,  Y_predictions_mean, Y_predictions_cov,results, best, info, 0 );
+				else
+					JCBB_recursive<metricML>(Z_observations_mean,  Y_predictions_mean, Y_predictions_cov,results, best, info, 0 );
+			}
+
+			results.associations.swap(best.associations);
+			results.distance = best.distance;
+			results.nNodesExploredInJCBB = best.nNodesExplored;
 		}
 		break;
 
@@ -536,7 +738,8 @@ void mrpt::slam::data_association_independent_predictions(
 	const bool							DAT_ASOC_USE_KDTREE,
 	const std::vector<prediction_index_t>		&predictions_IDs,
 	const TDataAssociationMetric		compatibilityTestMetric,
-	const double						log_ML_compat_test_threshold
+	const double						log_ML_compat_test_threshold,
+	const unsigned int					num_threads
 	)
 {
 	MRPT_START
@@ -573,7 +776,7 @@ void mrpt::slam::data_association_independent_predictions(
 		Y_predictions_mean,Y_predictions_cov_full,
 		results, method, metric, chi2quantile,
 		DAT_ASOC_USE_KDTREE, predictions_IDs,
-		compatibilityTestMetric, log_ML_compat_test_threshold );
+		compatibilityTestMetric, log_ML_compat_test_threshold, num_threads );
 
 	MRPT_END
 }
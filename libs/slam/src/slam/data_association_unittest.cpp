@@ -9,6 +9,8 @@
 
 
 #include <mrpt/slam/data_association.h>
+#include <mrpt/math/data_utils.h>
+#include <mrpt/random.h>
 #include <gtest/gtest.h>
 
 using namespace mrpt;
@@ -53,3 +55,77 @@ TEST(DataAssociation, TestNoICs)
 	}
 
 }
+
+// A larger problem, with cross-correlated predictions: the results must not depend on the KD-tree gating nor the number of threads.
+TEST(DataAssociation, KDTreeAndThreadsGiveSameResults)
+{
+	mrpt::random::CRandomGenerator rng(123);
+
+	const size_t nPreds = 300, nObs = 8, O = 2;
+	CMatrixDouble y(nPreds,O), y_cov(nPreds*O,nPreds*O), z(nObs,O);
+	CMatrixDouble J(nPreds*O,O);
+	for (size_t i=0;i<nPreds;i++)
+	{
+		y(i,0) = rng.drawUniform(0,50);
+		y(i,1) = rng.drawUniform(0,50);
+		J(i*O+0,0) = 1; J(i*O+0,1) = 0;
+		J(i*O+1,0) = 0; J(i*O+1,1) = 1;
+	}
+	// Common uncertainty (e.g. the vehicle pose) plus an independent one for each prediction:
+	y_cov = J * J.transpose() * 0.01;
+	for (size_t i=0;i<nPreds*O;i++)
+		y_cov(i,i) += 0.0025 * (1+i%3);
+
+	std::vector<size_t> gt_assoc(nObs);
+	for (size_t j=0;j<nObs;j++)
+	{
+		gt_assoc[j] = (j*37+11)%nPreds;
+		z(j,0) = y(gt_assoc[j],0) + 0.05 + rng.drawGaussian1D(0,0.02);
+		z(j,1) = y(gt_assoc[j],1) - 0.03 + rng.drawGaussian1D(0,0.02);
+	}
+
+	// All the combinations of association metric & individual compatibility test metric. With metricML, the KD-tree
+	// gate radius is derived from the log-likelihood threshold (0: densities above 1), instead of the chi2 quantile.
+	const TDataAssociationMetric damets[2] = { metricMaha, metricML };
+	for (unsigned int da_metric=0;da_metric<2;++da_metric)
+	for (unsigned int compat_metric=0;compat_metric<2;++compat_metric)
+	{
+		const TDataAssociationMetric compat = damets[compat_metric];
+		const double log_ML_thres = 0.0;
+		TDataAssociationResults res_ref, res_kd, res_threads;
+		data_association_full_covariance(z, y, y_cov, res_ref, assocJCBB, damets[da_metric], 0.99, false /*no KD-tree*/, std::vector<prediction_index_t>(), compat, log_ML_thres);
+		data_association_full_covariance(z, y, y_cov, res_kd, assocJCBB, damets[da_metric], 0.99, true, std::vector<prediction_index_t>(), compat, log_ML_thres);
+		data_association_full_covariance(z, y, y_cov, res_threads, assocJCBB, damets[da_metric], 0.99, true, std::vector<prediction_index_t>(), compat, log_ML_thres, 4);
+
+		ASSERT_EQ(nObs, res_ref.associations.size()) << "da_metric=" << da_metric << " compat_metric=" << compat_metric;
+		for (size_t j=0;j<nObs;j++)
+			EXPECT_EQ(gt_assoc[j], res_ref.associations[j]) << "da_metric=" << da_metric << " compat_metric=" << compat_metric;
+
+		EXPECT_TRUE(res_ref.associations==res_kd.associations) << "da_metric=" << da_metric << " compat_metric=" << compat_metric;
+		EXPECT_TRUE(res_ref.associations==res_threads.associations) << "da_metric=" << da_metric << " compat_metric=" << compat_metric;
+		EXPECT_NEAR(res_ref.distance, res_kd.distance, 1e-9*std::abs(res_ref.distance));
+		EXPECT_NEAR(res_ref.distance, res_threads.distance, 1e-9*std::abs(res_ref.distance));
+		EXPECT_TRUE(res_ref.indiv_compatibility_counts==res_kd.indiv_compatibility_counts) << "da_metric=" << da_metric << " compat_metric=" << compat_metric;
+		EXPECT_TRUE(res_ref.indiv_compatibility_counts==res_threads.indiv_compatibility_counts) << "da_metric=" << da_metric << " compat_metric=" << compat_metric;
+
+		// The KD-tree gate must not drop any individually compatible pair:
+		ASSERT_EQ(res_ref.indiv_compatibility.getRowCount(), res_kd.indiv_compatibility.getRowCount());
+		ASSERT_EQ(res_ref.indiv_compatibility.getColCount(), res_kd.indiv_compatibility.getColCount());
+		for (size_t i=0;i<res_ref.indiv_compatibility.getRowCount();i++)
+			for (size_t j=0;j<res_ref.indiv_compatibility.getColCount();j++)
+				EXPECT_EQ(res_ref.indiv_compatibility(i,j), res_kd.indiv_compatibility(i,j)) << "da_metric=" << da_metric << " compat_metric=" << compat_metric << " i=" << i << " j=" << j;
+
+		// Individual distances, compared to the generic method:
+		for (size_t j=0;j<nObs;j++)
+		{
+			const size_t i = gt_assoc[j];
+			CMatrixDouble pred_i_cov;
+			y_cov.extractMatrix(i*O,i*O,O,O, pred_i_cov);
+			CVectorDouble diff(O);
+			for (size_t k=0;k<O;k++) diff[k] = z(j,k)-y(i,k);
+			double d2, ml;
+			mrpt::math::mahalanobisDistance2AndLogPDF(diff,pred_i_cov, d2,ml);
+			EXPECT_NEAR(da_metric==0 ? d2 : ml, res_kd.indiv_distances(i,j), 1e-9);
+		}
+	}
+}
@@ -33,6 +33,8 @@ MRPT_WARNING("Including <mrpt/vision.h> makes compilation much slower, consider
 #include <mrpt/vision/CStereoRectifyMap.h>
 #include <mrpt/vision/CImagePyramid.h>
 #include <mrpt/vision/CDifodo.h>
+#include <mrpt/vision/CBinaryVocabulary.h>
+#include <mrpt/vision/CBoWDatabase.h>
 
 // Maps:
 #include <mrpt/maps/CLandmark.h>
@@ -0,0 +1,118 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#ifndef mrpt_vision_CBinaryVocabulary_H
+#define mrpt_vision_CBinaryVocabulary_H
+
+#include <mrpt/vision/CFeature.h>
+#include <mrpt/utils/CSerializable.h>
+#include <vector>
+#include <utility>
+
+namespace mrpt
+{
+	namespace vision
+	{
+		/** \addtogroup  mrptvision_features
+		    @{ */
+
+		/** A bag-of-words vector: pairs (word ID, weight) sorted by word ID, with L1-normalized tf-idf weights.
+		  * \sa CBinaryVocabulary::transform(), CBoWDatabase */
+		typedef std::vector<std::pair<uint32_t,float> > TBoWVector;
+
+		DEFINE_SERIALIZABLE_PRE_CUSTOM_BASE_LINKAGE( CBinaryVocabulary, mrpt::utils::CSerializable, VISION_IMPEXP )
+
+		/** A hierarchical vocabulary ("vocabulary tree") of binary visual words, for bag-of-words place recognition with ORB descriptors.
+		  *
+		  *  The tree is built by hierarchical k-majority clustering (k-medians in Hamming space, with k-means++ seeding) of the descriptors
+		  *  of a set of training images: each node has up to `branching` children and the leaves at level `depth` are the visual words.
+		  *  Words are weighted with their inverse document frequency in the training set.
+		  *  Converting an image into a bag-of-words vector costs `branching*depth` Hamming distances per descriptor.
+		  *
+		  * \code
+		  *  CFeatureExtraction fext;
+		  *  fext.options.featsType = featORB;
+		  *  std::vector<std::vector<uint8_t> > training_descs;  // One entry per training image
+		  *  // For each training image: fext.detectFeatures(img,feats,0,500); packDescriptorsORB(feats,descs,desc_len); ...
+		  *
+		  *  CBinaryVocabulary voc;
+		  *  voc.train(training_descs, 32);
+		  *  CFileGZOutputStream("voc.gz") << voc;
+		  *
+		  *  TBoWVector bow;
+		  *  voc.transform(feats, bow);
+		  * \endcode
+		  *
+		  *  Vocabularies are stored with the usual MRPT serialization (e.g. CFileGZOutputStream).
+		  * \sa CBoWDatabase
+		  */
+		class VISION_IMPEXP CBinaryVocabulary : public mrpt::utils::CSerializable
+		{
+			DEFINE_SERIALIZABLE( CBinaryVocabulary )
+
+		public:
+			/** Parameters of train() */
+			struct VISION_IMPEXP TTrainingParams
+			{
+				TTrainingParams();
+
+				unsigned int branching;		//!< Max. number of children of each node (Default: 10)
+				unsigned int depth;			//!< Levels of the tree below the root, i.e. up to branching^depth words (Default: 5)
+				unsigned int max_iterations;	//!< Max. number of k-majority iterations at each node (Default: 10)
+				unsigned int num_threads;	//!< Threads for assigning descriptors to clusters (0: as many as CPU cores) (Default: 0)
+				unsigned int random_seed;	//!< Seed for the k-means++ initialization (Default: 1234)
+			};
+
+			CBinaryVocabulary();
+
+			/** Builds the vocabulary from the binary descriptors of a set of training images.
+			  * \param descs_per_image One row-major buffer of descriptors per image, with `desc_len` bytes each (see packDescriptorsORB).
+			  * \param desc_len Length of descriptors in bytes (32 for ORB).
+			  * \exception std::exception On empty training data or invalid parameters.
+			  */
+			void train(const std::vector<std::vector<uint8_t> > &descs_per_image, const size_t desc_len, const TTrainingParams &params = TTrainingParams());
+
+			/** Converts a set of binary descriptors (a row-major buffer of `num_descs` x getDescriptorLength() bytes) into a bag-of-words vector.
+			  * \param out_word_ids If not NULL, the word ID of each descriptor is returned here.
+			  */
+			void transform(const uint8_t *descs, const size_t num_descs, TBoWVector &out_bow, std::vector<uint32_t> *out_word_ids = NULL) const;
+
+			/** Converts the ORB descriptors of a list of features into a bag-of-words vector. \sa packDescriptorsORB */
+			void transform(const CFeatureList &feats, TBoWVector &out_bow) const;
+
+			/** Returns the word ID of one descriptor of getDescriptorLength() bytes */
+			uint32_t getWordID(const uint8_t *desc) const;
+
+			/** Similarity score between two bag-of-words vectors, in the range [0,1] (1: identical): \f$ 1 - \frac{1}{2} \| v_1 - v_2 \|_1 \f$ */
+			static float score(const TBoWVector &v1, const TBoWVector &v2);
+
+			bool empty() const { return m_word_weights.empty(); }
+			size_t getWordsCount() const { return m_word_weights.size(); }
+			size_t getDescriptorLength() const { return m_desc_len; }
+			float getWordWeight(const uint32_t word_id) const { return m_word_weights[word_id]; }  //!< Inverse document frequency of a word
+
+			void clear();
+
+		protected:
+			size_t m_desc_len;
+			/** The tree: node #0 is the root. Children of each node are stored contiguously.
+			  *  The root has no descriptor, so the descriptor of node #i is at (i-1)*m_desc_len. */
+			std::vector<uint8_t>  m_node_descs;
+			vector_uint           m_node_first_child;  //!< Index of the first child of each node
+			vector_uint           m_node_num_children; //!< 0 for leaves (words)
+			vector_uint           m_node_word;         //!< Word ID of leaves
+			std::vector<float>    m_word_weights;      //!< idf weight of each word
+		};
+		DEFINE_SERIALIZABLE_POST_CUSTOM_BASE_LINKAGE( CBinaryVocabulary, mrpt::utils::CSerializable, VISION_IMPEXP )
+
+		/** @} */ // end of grouping
+	}
+}
+
+#endif
@@ -0,0 +1,92 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#ifndef mrpt_vision_CBoWDatabase_H
+#define mrpt_vision_CBoWDatabase_H
+
+#include <mrpt/vision/CBinaryVocabulary.h>
+#include <limits>
+
+namespace mrpt
+{
+	namespace vision
+	{
+		/** \addtogroup  mrptvision_features
+		    @{ */
+
+		/** One result of CBoWDatabase::query() */
+		struct VISION_IMPEXP TBoWQueryResult
+		{
+			size_t image_id;	//!< As returned by CBoWDatabase::add()
+			float  score;		//!< Similarity in the range [0,1], see CBinaryVocabulary::score()
+
+			TBoWQueryResult() : image_id(0), score(0) {}
+			TBoWQueryResult(size_t id, float s) : image_id(id), score(s) {}
+		};
+
+		/** A database of images described as bag-of-words vectors (see CBinaryVocabulary), for place recognition and loop-closure detection.
+		  *
+		  *  Images are inserted incrementally and indexed with an inverted index (for each word, the list of images where it appears and its weight),
+		  *  so a query only visits the images that share words with the query image: its cost is proportional to the number of such
+		  *  (word,image) entries, not to the size of the database.
+		  *
+		  * \code
+		  *  CBoWDatabase db;
+		  *  for (...each new image...)
+		  *  {
+		  *     TBoWVector bow;
+		  *     voc.transform(feats, bow);
+		  *     std::vector<TBoWQueryResult> candidates;
+		  *     db.query(bow, candidates, 5, 0.05f, db.size()>num_recent_frames ? db.size()-num_recent_frames : 0); // Skip the last frames
+		  *     db.add(bow);
+		  *  }
+		  * \endcode
+		  *  query() is const and can be called concurrently from several threads, but not concurrently with add() or clear().
+		  * \sa CBinaryVocabulary
+		  */
+		class VISION_IMPEXP CBoWDatabase
+		{
+		public:
+			CBoWDatabase();
+
+			void clear();
+
+			/** Inserts a new image. \return Its ID, consecutive from 0 */
+			size_t add(const TBoWVector &bow);
+
+			/** Number of images in the database */
+			size_t size() const { return m_num_images; }
+
+			/** Finds the images most similar to the given one.
+			  * \param out_results The best `max_results` images with a score of at least `min_score`, sorted by decreasing score.
+			  * \param max_image_id Only images with an ID below this one are considered (e.g. to skip the most recent ones).
+			  */
+			void query(
+				const TBoWVector &bow,
+				std::vector<TBoWQueryResult> &out_results,
+				const size_t max_results = 10,
+				const float min_score = 0,
+				const size_t max_image_id = std::numeric_limits<size_t>::max() ) const;
+
+		protected:
+			struct TPosting
+			{
+				uint32_t image_id;
+				float    weight;
+				TPosting(uint32_t id, float w) : image_id(id), weight(w) {}
+			};
+			std::vector<std::vector<TPosting> > m_inverted_index; //!< Indexed by word ID; postings sorted by image ID
+			size_t m_num_images;
+		};
+
+		/** @} */ // end of grouping
+	}
+}
+
+#endif
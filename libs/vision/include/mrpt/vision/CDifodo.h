@@ -47,6 +47,7 @@ namespace mrpt
 		  * - JUN/2013: First design.
 		  * - JAN/2014: Integrated into MRPT library.
 		  * - DIC/2014: Reformulated and improved. The class now needs Eigen version 3.1.0 or above.
+		  * - 2016: All the per-pixel stages run in parallel blocks of image columns. See \a num_threads and \a stage_times.
 		  *
 		  *  \sa CDifodoCamera, CDifodoDatasets
 		  *  \ingroup mrpt_vision_grp
@@ -182,6 +183,24 @@ namespace mrpt
 			/** Execution time (ms) */
 			float execution_time;
 
+			/** Execution time (ms) of each stage in the last call to odometryCalculation(), added up over all the coarse-to-fine levels */
+			struct VISION_IMPEXP TStageTimes
+			{
+				TStageTimes();
+				float pyramid;		//!< buildCoordinatesPyramid() or buildCoordinatesPyramidFast()
+				float warping;		//!< performWarping()
+				float coordinates;	//!< calculateCoord()
+				float derivatives;	//!< calculateDepthDerivatives()
+				float weights;		//!< computeWeights()
+				float solver;		//!< solveOneLevel()
+				float filter;		//!< filterLevelSolution() and poseUpdate()
+			};
+			TStageTimes stage_times;
+
+			/** Number of threads for the per-pixel stages and the reduction of the normal equations in the solver
+			  * (0: as many as CPU cores). Small images are processed with fewer threads. Default: 0 */
+			unsigned int num_threads;
+
 			/** Camera poses */
 			mrpt::poses::CPose3D cam_pose;		//!< Last camera pose
 			mrpt::poses::CPose3D cam_oldpose;	//!< Previous camera pose
@@ -203,6 +203,41 @@ namespace mrpt
 		DEFINE_SERIALIZABLE_POST_CUSTOM_BASE_LINKAGE( CFeature, mrpt::utils::CSerializable, VISION_IMPEXP )
 
 
+		class CFeatureList;
+
+		/** Contiguous, column-wise copy of the coordinates, responses and descriptors of all the features in a CFeatureList,
+		  *  which is much more cache-friendly than going through each individual CFeature object for bulk operations (matching, kd-trees,...).
+		  *  Descriptors of each type are stored as one row-major matrix (one row per feature) in a single buffer,
+		  *  which is left empty unless all the features have a descriptor of that type and all of them have the same length.
+		  *
+		  *  This is a snapshot: later changes to the list or its features are not reflected here until buildFrom() is called again.
+		  *  Taking it costs O(N*D) for N features with D-length descriptors, negligible against the O(N^2*D) of a brute-force matching
+		  *  (see the "feature_matching" benchmarks of mrpt-performance).
+		  * \sa matchFeatures()
+		  */
+		struct VISION_IMPEXP TFeatureListColumns
+		{
+			typedef mrpt::aligned_containers<float>::vector_t   float_vector_t;
+			typedef mrpt::aligned_containers<uint8_t>::vector_t uint8_vector_t;
+
+			float_vector_t  x, y, response; //!< One entry per feature
+			uint8_vector_t  SIFT;           //!< SIFT descriptors, with SIFT_len elements per feature
+			float_vector_t  SURF;           //!< SURF descriptors, with SURF_len elements per feature
+			uint8_vector_t  ORB;            //!< ORB descriptors, with ORB_len bytes per feature
+			size_t SIFT_len, SURF_len, ORB_len; //!< Length of each descriptor (0: not available for all the features)
+
+			TFeatureListColumns();
+			explicit TFeatureListColumns(const CFeatureList &feats); //!< Builds the columns from the given list of features
+			/** Rebuilds all the columns from the given list of features */
+			void buildFrom(const CFeatureList &feats);
+			void clear();
+
+			inline size_t size() const { return x.size(); }
+			inline const uint8_t * getSIFT(size_t i) const { return &SIFT[i*SIFT_len]; } //!< Pointer to the SIFT descriptor of the i'th feature (SIFT_len>0 is not checked!)
+			inline const float   * getSURF(size_t i) const { return &SURF[i*SURF_len]; } //!< Pointer to the SURF descriptor of the i'th feature (SURF_len>0 is not checked!)
+			inline const uint8_t * getORB(size_t i)  const { return &ORB[i*ORB_len]; }   //!< Pointer to the ORB descriptor of the i'th feature (ORB_len>0 is not checked!)
+		};
+
 		/****************************************************
 						Class CFEATURELIST
 		*****************************************************/
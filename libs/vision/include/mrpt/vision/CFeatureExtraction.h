@@ -14,6 +14,7 @@
 #include <mrpt/vision/utils.h>
 #include <mrpt/vision/CFeature.h>
 #include <mrpt/vision/TSimpleFeature.h>
+#include <mrpt/vision/CImagePyramid.h>
 
 namespace mrpt
 {
@@ -129,6 +130,16 @@ namespace mrpt
 					float	min_distance;	//!< (default=5) minimum distance between features (in pixels)
 					bool	nonmax_suppression;		//!< Default = true
 					bool    use_KLT_response; //!< (default=false) If true, use CImage::KLT_response to compute the response at each point instead of the FAST "standard response".
+
+					/** (default=false) Only for the FASTER detectors: split the image into square tiles which are processed in parallel,
+					  * with per-tile non-maximal suppression and adaptive thresholds. If a number of features is requested, the best corners of
+					  * all tiles are taken in turns. See CFeatureExtraction::detectFeatures_SSE2_FASTER_tiled() */
+					bool	tiled_detection;
+					unsigned int tile_size;            //!< (default=128) Width and height of each tile, in pixels (only if tiled_detection=true)
+					unsigned int max_features_per_tile; //!< (default=0) Keep at most these corners (the best ones) per tile, for an uniform spatial distribution. 0 means no limit, or `nDesiredFeatures/number_of_tiles` if a number of features was requested (only if tiled_detection=true)
+					unsigned int min_features_per_tile; //!< (default=0) Tiles with fewer corners are re-processed with a lower threshold (halved each time, down to min_threshold). 0 disables adaptive thresholds (only if tiled_detection=true)
+					int 	min_threshold;             //!< (default=5) See min_features_per_tile
+					unsigned int num_threads;          //!< (default=0) Maximum number of threads for tiled detection. 0 means one per processor
 				} FASTOptions;
 
 				/** ORB Options */
@@ -305,6 +316,36 @@ namespace mrpt
 				uint8_t octave = 0,
 				std::vector<size_t> * out_feats_index_by_row = NULL );
 
+			/** Tiled, multithreaded version of detectFeatures_SSE2_FASTER9() (or 10, 12, as given by \a N_fast).
+			  *  The image is split into square tiles of `opts.tile_size` pixels, which are processed in parallel (up to `opts.num_threads` threads). In each tile:
+			  *   - Corners are detected with `opts.threshold`. If less than `opts.min_features_per_tile` are found, the threshold is halved
+			  *     (down to `opts.min_threshold`) and the tile processed again.
+			  *   - The \a response of each corner is set to its CImage::KLT_response(), and a 3x3 non-maximal suppression is applied.
+			  *   - Only the best \a max_features_per_tile corners are kept (0 means no limit).
+			  *
+			  *  The output is the concatenation of the corners of all the tiles, in row-major tile order, so it does not depend on the number of threads.
+			  *  The other fields of \a opts (`tiled_detection`, `min_distance`,...) are ignored.
+			  *  \param[in] img A grayscale image.
+			  * \ingroup mrptvision_features */
+			static void detectFeatures_SSE2_FASTER_tiled(
+				const int N_fast,
+				const mrpt::utils::CImage &img,
+				TSimpleFeatureList & corners,
+				const TOptions::TFASTOptions &opts,
+				const unsigned int max_features_per_tile = 0,
+				bool append_to_list = false );
+
+			/** Like detectFeatures_SSE2_FASTER_tiled() for all the octaves of a grayscale image pyramid at once: the tiles of all the octaves are processed in the same parallel batch.
+			  *  The output is sorted by octave, and corners have their \a octave field set and their coordinates scaled to the first octave (i.e. `x<<octave`), as in detectFeatures_SSE2_FASTER9().
+			  * \ingroup mrptvision_features */
+			static void detectFeatures_SSE2_FASTER_tiled(
+				const int N_fast,
+				const CImagePyramid &pyramid,
+				TSimpleFeatureList & corners,
+				const TOptions::TFASTOptions &opts,
+				const unsigned int max_features_per_tile = 0,
+				bool append_to_list = false );
+
 			/** @} */
 
 		private:
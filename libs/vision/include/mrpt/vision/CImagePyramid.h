@@ -46,6 +46,8 @@ namespace mrpt
 		  * \endcode
 		  *
 		  *  \note Both converting to grayscale and building the octave images have SSE2-optimized implementations (if available).
+		  *  \note Reuse the same CImagePyramid object for consecutive frames: if the input image size and format do not change, the buffers of all
+		  *   the octaves are reused and building the pyramid does not allocate any memory.
 		  *
 		  * \sa mrpt::utils::CImage
 		  * \ingroup mrpt_vision_grp 
@@ -133,6 +133,12 @@ namespace mrpt
 			/** Get the currently selected interpolation method \sa setInterpolationMethod */
 			mrpt::utils::TInterpolationMethod getInterpolationMethod() const { return m_interpolation_method; }
 
+			/** Number of threads among which the rows of both images are split in rectify() (default=0: as many as CPU cores). This parameter can be safely changed at any instant. */
+			void setNumThreads(unsigned int num_threads) { m_num_threads = num_threads; }
+
+			/** \sa setNumThreads */
+			unsigned int getNumThreads() const { return m_num_threads; }
+
 			/** If enabled (default=false), the principal points in both output images will coincide.
 			  * \note Call this method before building the rectification maps, otherwise they'll be marked as invalid.
 			  */
@@ -176,6 +182,8 @@ namespace mrpt
 			  * If \a use_internal_mem_cache is set to \a true (recommended), will reuse over and over again the same
 			  * auxiliary images (kept internally to this object) needed for in-place rectification.
 			  * The only reason not to enable this cache is when multiple threads can invoke this method simultaneously.
+			  * Without the cache, the rectified images take their buffers from the pool of image buffers (see mrpt::utils::CImage::setImageBuffersPoolMaxSize())
+			  * and the former ones are given back to it, so there are no memory allocations either once the pool is warmed up.
 			  */
 			void rectify(
 				mrpt::utils::CImage &left_image,
@@ -196,7 +204,9 @@ namespace mrpt
 				const bool use_internal_mem_cache = true ) const;
 
 			/** Just like rectify() but directly works with OpenCV's "IplImage*", which must be passed as "void*" to avoid header dependencies
-			  *  Output images CANNOT coincide with the input images. */
+			  *  Output images CANNOT coincide with the input images, and must already have the size of the rectified images.
+			  *  8-bit images with nearest-neighbor or bilinear interpolation are remapped by MRPT's own fixed-point SSE2 implementation,
+			  *  processing both images concurrently (see setNumThreads()); other cases are handled by OpenCV's cv::remap(). */
 			void rectify_IPL(
 				const void* in_left_image,
 				const void* in_right_image,
@@ -211,6 +221,7 @@ namespace mrpt
 			bool     m_enable_both_centers_coincide;
 			mrpt::utils::TImageSize m_resize_output_value;
 			mrpt::utils::TInterpolationMethod m_interpolation_method;
+			unsigned int m_num_threads;
 
 			mutable mrpt::utils::CImage  m_cache1, m_cache2; //!< Memory caches for in-place rectification speed-up.
 
@@ -22,7 +22,7 @@ namespace mrpt
 		  *  Using this class is much more efficient that calling mrpt::utils::CImage::rectifyImage or OpenCV's cvUndistort2(), since
 		  *  the remapping data is computed only once for the camera parameters (typical times: 640x480 image -> 70% build map / 30% actual undistort).
 		  *
-		  *  Works with grayscale or color images.
+		  *  Works with grayscale or color images. 8-bit images are remapped by MRPT's own fixed-point implementation (SSE2-optimized, multithreaded: see setNumThreads()).
 		  *
 		  * Example of usage:
 		  * \code
@@ -69,12 +69,21 @@ namespace mrpt
 			  */
 			inline bool isSet() const { return !m_dat_mapx.empty(); }
 
+			/** Number of threads among which image rows are split in undistort() (default=0: as many as CPU cores) */
+			inline void setNumThreads(unsigned int num_threads) { m_num_threads = num_threads; }
+			/** \sa setNumThreads */
+			inline unsigned int getNumThreads() const { return m_num_threads; }
+
 		private:
 			std::vector<int16_t>  m_dat_mapx;
 			std::vector<uint16_t> m_dat_mapy;
+			unsigned int          m_num_threads;
 
 			mrpt::utils::TCamera  m_camera_params; //!< A copy of the data provided by the user
 
+			/** Remaps IplImage's with the CvMat's of the maps (passed as void* to avoid depending on OpenCV headers) */
+			void internal_remap(const void *src, void *dst, const void *mapx, const void *mapy) const;
+
 		}; // end class
 	} // end namespace
 } // end namespace
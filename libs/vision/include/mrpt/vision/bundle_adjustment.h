@@ -57,6 +57,12 @@ namespace mrpt
 		  *		- "num_fix_frames": Number of first frame poses to don't optimize (keep unmodified as they come in)  (default=1: the first pose is the reference and is not modified)
 		  *		- "num_fix_points": Idem, for the landmarks positions (default=0: optimize all)
 		  *		- "profiler": If !=0, displays profiling information to the console at return.
+		  *		- "num_threads": Number of threads for evaluating residuals and Jacobians, and for PCG products (default=0: as many as CPU cores).
+		  *		- "use_pcg": If !=0, the reduced camera system (the Schur complement on points) is solved with block-Jacobi preconditioned conjugate gradient instead of a sparse Cholesky factorization. Recommended for problems with many frames (default=0)
+		  *		- "pcg_max_iterations": Max. number of PCG iterations for each linear system (default=500). If PCG has not converged by then, that system is solved with the sparse Cholesky factorization instead.
+		  *		- "pcg_tolerance": PCG stops when the residual norm is below this fraction of the norm of the right hand side (default=1e-8)
+		  *
+		  *  With "verbose"!=0, the time taken by each iteration is also reported.
 		  *
 		  * \note In this function, all coordinates are absolute. Camera frames are such that +Z points forward from the focal point (see the figure in mrpt::obs::CObservationImage).
 		  * \note The first frame pose will be not updated since at least one frame must remain fixed.
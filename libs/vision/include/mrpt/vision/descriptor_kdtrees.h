@@ -64,8 +64,9 @@ namespace mrpt
 			{		
 				if (m_kdtree) delete m_kdtree;
 
+				m_adaptor.update(); // Snapshot of the contiguous descriptors
 				nanoflann::KDTreeSingleIndexAdaptorParams params;
-				m_kdtree = new kdtree_t( m_feats[0]->descriptors.SIFT.size() /* DIM */ , m_adaptor, params );
+				m_kdtree = new kdtree_t( m_adaptor.m_dim /* DIM */ , m_adaptor, params );
 				m_kdtree->buildIndex();
 			}
 
@@ -104,7 +105,7 @@ namespace mrpt
 		public:
 			typedef typename nanoflann::KDTreeSingleIndexAdaptor<metric_t,detail::TSURFDesc2KDTree_Adaptor<distance_t> > kdtree_t;
 
-			/** Constructor from a list of SIFT features. 
+			/** Constructor from a list of SURF features. 
 			  *  Automatically build the KD-tree index. The list of features must NOT be empty or an exception will be raised.
 			  */
 			TSURFDescriptorsKDTreeIndex(const CFeatureList &feats) : 
@@ -112,7 +113,7 @@ namespace mrpt
 				m_kdtree(NULL),
 				m_feats(feats) 
 			{
-				ASSERT_(!feats.empty() && feats[0]->descriptors.hasDescriptorSIFT())
+				ASSERT_(!feats.empty() && feats[0]->descriptors.hasDescriptorSURF())
 				this->regenerate_kdtreee();
 			}
 
@@ -121,8 +122,9 @@ namespace mrpt
 			{		
 				if (m_kdtree) delete m_kdtree;
 
+				m_adaptor.update(); // Snapshot of the contiguous descriptors
 				nanoflann::KDTreeSingleIndexAdaptorParams params;
-				m_kdtree = new kdtree_t( m_feats[0]->descriptors.SIFT.size() /* DIM */ , m_adaptor, params );
+				m_kdtree = new kdtree_t( m_adaptor.m_dim /* DIM */ , m_adaptor, params );
 				m_kdtree->buildIndex();
 			}
 
@@ -151,16 +153,26 @@ namespace mrpt
 			struct TSIFTDesc2KDTree_Adaptor
 			{
 				const CFeatureList & m_feats;
-				TSIFTDesc2KDTree_Adaptor(const CFeatureList &feats) : m_feats(feats) { }
+				TFeatureListColumns m_cols; //!< Snapshot of the list, taken by update()
+				const element_t *m_descs; //!< Contiguous, row-major descriptors, in m_cols
+				size_t m_dim;
+				TSIFTDesc2KDTree_Adaptor(const CFeatureList &feats) : m_feats(feats), m_descs(NULL), m_dim(0) { }
+				// Takes a new snapshot of the contiguous descriptors of the list:
+				void update()
+				{
+					m_cols.buildFrom(m_feats);
+					ASSERTMSG_(m_cols.SIFT_len>0, "All features must have SIFT descriptors of the same length")
+					m_dim   = m_cols.SIFT_len;
+					m_descs = &m_cols.SIFT[0];
+				}
 				// Must return the number of data points
 				inline size_t kdtree_get_point_count() const { return m_feats.size(); }
 				// Must return the Euclidean (L2) distance between the vector "p1[0:size-1]" and the data point with index "idx_p2" stored in the class:
 				inline distance_t kdtree_distance(const element_t *p1, const size_t idx_p2,size_t size) const 
 				{ 
-					const size_t dim=m_feats[idx_p2]->descriptors.SIFT.size();
-					const element_t *p2 = &m_feats[idx_p2]->descriptors.SIFT[0];
+					const element_t *p2 = m_descs + idx_p2*m_dim;
 					distance_t  d=0;
-					for (size_t i=0;i<dim;i++) 
+					for (size_t i=0;i<m_dim;i++) 
 					{
 						d+=(*p1-*p2)*(*p1-*p2);
 						p1++;
@@ -169,7 +181,7 @@ namespace mrpt
 					return d;
 				}
 				// Must return the dim'th component of the idx'th point in the class:
-				inline element_t kdtree_get_pt(const size_t idx, int dim) const { return m_feats[idx]->descriptors.SIFT[dim]; }
+				inline element_t kdtree_get_pt(const size_t idx, int dim) const { return m_descs[idx*m_dim+dim]; }
 				template <class BBOX> bool kdtree_get_bbox(BBOX &bb) const { return false; }
 			};
 
@@ -177,16 +189,26 @@ namespace mrpt
 			struct TSURFDesc2KDTree_Adaptor
 			{
 				const CFeatureList & m_feats;
-				TSURFDesc2KDTree_Adaptor(const CFeatureList &feats) : m_feats(feats) { }
+				TFeatureListColumns m_cols; //!< Snapshot of the list, taken by update()
+				const element_t *m_descs; //!< Contiguous, row-major descriptors, in m_cols
+				size_t m_dim;
+				TSURFDesc2KDTree_Adaptor(const CFeatureList &feats) : m_feats(feats), m_descs(NULL), m_dim(0) { }
+				// Takes a new snapshot of the contiguous descriptors of the list:
+				void update()
+				{
+					m_cols.buildFrom(m_feats);
+					ASSERTMSG_(m_cols.SURF_len>0, "All features must have SURF descriptors of the same length")
+					m_dim   = m_cols.SURF_len;
+					m_descs = &m_cols.SURF[0];
+				}
 				// Must return the number of data points
 				inline size_t kdtree_get_point_count() const { return m_feats.size(); }
 				// Must return the Euclidean (L2) distance between the vector "p1[0:size-1]" and the data point with index "idx_p2" stored in the class:
 				inline distance_t kdtree_distance(const element_t *p1, const size_t idx_p2,size_t size) const 
 				{ 
-					const size_t dim=m_feats[idx_p2]->descriptors.SURF.size();
-					const element_t *p2 = &m_feats[idx_p2]->descriptors.SURF[0];
+					const element_t *p2 = m_descs + idx_p2*m_dim;
 					distance_t  d=0;
-					for (size_t i=0;i<dim;i++) 
+					for (size_t i=0;i<m_dim;i++) 
 					{
 						d+=(*p1-*p2)*(*p1-*p2);
 						p1++;
@@ -195,7 +217,7 @@ namespace mrpt
 					return d;
 				}
 				// Must return the dim'th component of the idx'th point in the class:
-				inline element_t kdtree_get_pt(const size_t idx, int dim) const { return m_feats[idx]->descriptors.SURF[dim]; }
+				inline element_t kdtree_get_pt(const size_t idx, int dim) const { return m_descs[idx*m_dim+dim]; }
 				template <class BBOX> bool kdtree_get_bbox(BBOX &bb) const { return false; }
 			};
 		} // end detail
@@ -11,6 +11,8 @@
 #define mrpt_vision_descriptor_pairing_H
 
 #include <mrpt/vision/types.h>
+#include <mrpt/vision/CFeature.h>
+#include <limits>
 
 namespace mrpt
 {
@@ -115,6 +117,62 @@ namespace mrpt
 			MRPT_END
 		}
 
+		/** The best and second-best neighbors of one query descriptor, as found by the brute-force matching engine.
+		  * \sa findDescriptorMatchesHamming, findDescriptorMatchesL2, filterDescriptorMatches
+		  */
+		struct VISION_IMPEXP TDescriptorMatchCandidate
+		{
+			int   idx;   //!< Index of the nearest descriptor in the second set, or -1 if there was no candidate at all.
+			float dist1; //!< Distance to the nearest descriptor (std::numeric_limits<float>::max() if idx==-1)
+			float dist2; //!< Distance to the second nearest descriptor (std::numeric_limits<float>::max() if there was only one candidate)
+
+			TDescriptorMatchCandidate() : idx(-1), dist1(std::numeric_limits<float>::max()), dist2(std::numeric_limits<float>::max()) {}
+		};
+
+		/** Copies the ORB descriptors of all the features in a list into one contiguous, row-major buffer of `list.size()` rows of `desc_len` bytes each.
+		  * \exception std::exception If any feature lacks an ORB descriptor or their lengths differ.
+		  */
+		void VISION_IMPEXP packDescriptorsORB(const CFeatureList &list, std::vector<uint8_t> &out_descs, size_t &out_desc_len);
+		/** Copies the SIFT descriptors of all the features in a list into one contiguous, row-major buffer of floats. \sa packDescriptorsORB */
+		void VISION_IMPEXP packDescriptorsSIFT(const CFeatureList &list, std::vector<float> &out_descs, size_t &out_desc_len);
+		/** Copies the SURF descriptors of all the features in a list into one contiguous, row-major buffer of floats. \sa packDescriptorsORB */
+		void VISION_IMPEXP packDescriptorsSURF(const CFeatureList &list, std::vector<float> &out_descs, size_t &out_desc_len);
+
+		/** For each one of the `n1` binary descriptors in `descs1`, finds its two nearest neighbors (in Hamming distance) among the `n2` descriptors in `descs2`.
+		  *  Both buffers are row-major, with `desc_len` bytes per descriptor (see packDescriptorsORB).
+		  *  Distances are evaluated 64 bits at a time with the CPU `popcnt` instruction if MRPT was built with SSE4.2 support, and
+		  *  blocks of query descriptors are processed in parallel if the workload is large enough.
+		  * \param[out] out_matches One entry per query descriptor. Ties are resolved in favor of the lowest index in `descs2`.
+		  * \param[in] num_threads Maximum number of threads to use. 0 means one per processor.
+		  * \sa findDescriptorMatchesL2, filterDescriptorMatches
+		  */
+		void VISION_IMPEXP findDescriptorMatchesHamming(
+			const uint8_t *descs1, const size_t n1,
+			const uint8_t *descs2, const size_t n2,
+			const size_t desc_len,
+			std::vector<TDescriptorMatchCandidate> &out_matches,
+			const unsigned int num_threads = 0 );
+
+		/** Like findDescriptorMatchesHamming() but for float descriptors (e.g. SIFT, SURF), using the (non-squared) Euclidean distance. */
+		void VISION_IMPEXP findDescriptorMatchesL2(
+			const float *descs1, const size_t n1,
+			const float *descs2, const size_t n2,
+			const size_t desc_len,
+			std::vector<TDescriptorMatchCandidate> &out_matches,
+			const unsigned int num_threads = 0 );
+
+		/** Turns the output of findDescriptorMatchesHamming() or findDescriptorMatchesL2() into a list of pairings `(index in set #1, index in set #2)`.
+		  *  A pairing is accepted if its distance is below `max_distance`, the ratio between the best and second best distances is below `max_ratio`
+		  *  (Lowe's ratio test, use 1 or larger to disable it) and, if `matches_2_to_1` is provided, the best neighbor of `idx` in the opposite direction is the query itself (cross-check).
+		  * \return The number of accepted pairings.
+		  */
+		size_t VISION_IMPEXP filterDescriptorMatches(
+			const std::vector<TDescriptorMatchCandidate> &matches_1_to_2,
+			const std::vector<TDescriptorMatchCandidate> *matches_2_to_1,
+			const float max_distance,
+			const float max_ratio,
+			std::vector<std::pair<size_t,size_t> > &out_pairings );
+
 		/** @} */
 
 	}
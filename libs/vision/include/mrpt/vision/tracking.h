@@ -222,8 +222,12 @@ namespace mrpt
 		  *		- "LK_max_iters" (Default=10) Max. number of iterations in LK tracking.
 		  *		- "LK_epsilon" (Default=0.1) Minimum epsilon step in interations of LK_tracking.
 		  *		- "LK_max_tracking_error" (Default=150.0) The maximum "tracking error" of LK tracking such as a feature is marked as "lost".
+		  *		- "LK_cache_pyramids" (Default=1) If "1", the pyramid of "new_img" is kept after each call and reused in the next one if its "old_img" has the same contents, which is the typical case in video sequences.
+		  *		- "LK_num_threads" (Default=0) Number of threads among which features are split for tracking (0=as many as CPU cores). Each pyramid is built once with cv::buildOpticalFlowPyramid() and shared by all threads.
 		  *
-		  *  \sa OpenCV's method cvCalcOpticalFlowPyrLK
+		  *  Pyramid caching and multi-threaded tracking require OpenCV 2.4 or newer; these parameters are ignored with older versions.
+		  *
+		  *  \sa OpenCV's methods cv::buildOpticalFlowPyramid, cv::calcOpticalFlowPyrLK
 		  */
 		struct VISION_IMPEXP CFeatureTracker_KL : public CGenericFeatureTracker
 		{
@@ -244,6 +248,20 @@ namespace mrpt
 				const mrpt::utils::CImage &new_img,
 				FEATLIST  &inout_featureList );
 
+			/** The LK pyramid of the last "new_img", to be reused if it becomes the next "old_img". Copies of a tracker start with an empty cache. */
+			struct VISION_IMPEXP TPyramidCache
+			{
+				TPyramidCache();
+				TPyramidCache(const TPyramidCache &o);
+				TPyramidCache & operator =(const TPyramidCache &o);
+				~TPyramidCache();
+				void clear(); //!< Frees the pyramid buffer
+
+				void *pyramid; //!< A std::vector<cv::Mat> built by cv::buildOpticalFlowPyramid(), or NULL if empty
+				int   levels, win_width, win_height; //!< The parameters with which `pyramid` was built
+				mrpt::utils::CImage gray; //!< The grayscale image from which `pyramid` was built
+			};
+			TPyramidCache m_pyramid_cache;
 		};
 
 
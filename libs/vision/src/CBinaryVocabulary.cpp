@@ -0,0 +1,413 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"   // Precompiled headers
+#include <mrpt/vision/CBinaryVocabulary.h>
+#include <mrpt/vision/descriptor_pairing.h>
+#include <mrpt/random/RandomGenerators.h>
+#include <mrpt/utils/CStream.h>
+#include <deque>
+#include "descriptor_matching_internals.h"
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace std;
+
+IMPLEMENTS_SERIALIZABLE(CBinaryVocabulary, CSerializable, mrpt::vision)
+
+namespace
+{
+	/** Minimum number of descriptors per thread worth spawning a new thread for */
+	const size_t MIN_VOC_DESCS_PER_THREAD = 4096;
+
+	/** Assigns each descriptor of a node to its closest cluster center */
+	struct TAssignClustersBlock
+	{
+		const std::vector<const uint8_t*> &descs;
+		const vector_uint &members;
+		const std::vector<uint8_t> &centers;
+		const size_t num_centers, desc_len;
+		vector_uint &assignments;
+		std::vector<int> block_changed;
+
+		TAssignClustersBlock(const std::vector<const uint8_t*> &descs_, const vector_uint &members_, const std::vector<uint8_t> &centers_,
+			size_t num_centers_, size_t desc_len_, vector_uint &assignments_, unsigned int num_blocks) :
+			descs(descs_), members(members_), centers(centers_), num_centers(num_centers_), desc_len(desc_len_),
+			assignments(assignments_), block_changed(num_blocks,0)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int block)
+		{
+			int changed = 0;
+			for (size_t i=first;i<last;i++)
+			{
+				const uint8_t *d = descs[members[i]];
+				uint32_t best = 0;
+				unsigned int best_dist = std::numeric_limits<unsigned int>::max();
+				for (size_t c=0;c<num_centers;c++)
+				{
+					const unsigned int dist = detail::hammingDistance(d,&centers[c*desc_len],desc_len);
+					if (dist<best_dist) { best_dist=dist; best=static_cast<uint32_t>(c); }
+				}
+				if (assignments[i]!=best) { assignments[i]=best; changed=1; }
+			}
+			block_changed[block] = changed;
+		}
+	};
+
+	/** k-majority clustering of the descriptors "members" into (up to) k clusters, with k-means++ seeding.
+	  *  Empty clusters are dropped. */
+	void kMajorityClustering(
+		const std::vector<const uint8_t*> &descs, const vector_uint &members, const size_t desc_len,
+		const CBinaryVocabulary::TTrainingParams &params, mrpt::random::CRandomGenerator &rng,
+		std::vector<uint8_t> &out_centers, std::vector<vector_uint> &out_clusters)
+	{
+		const size_t N = members.size();
+		const size_t k = params.branching;
+		out_centers.clear();
+		out_clusters.clear();
+
+		// Few descriptors: one cluster each
+		if (N<=k)
+		{
+			for (size_t i=0;i<N;i++)
+			{
+				out_centers.insert(out_centers.end(), descs[members[i]], descs[members[i]]+desc_len);
+				out_clusters.push_back(vector_uint(1,members[i]));
+			}
+			return;
+		}
+
+		// k-means++ seeding:
+		std::vector<uint8_t> centers;
+		centers.reserve(k*desc_len);
+		const uint8_t *first = descs[members[rng.drawUniform32bit() % N]];
+		centers.insert(centers.end(), first, first+desc_len);
+
+		std::vector<double> min_sq_dist(N);
+		for (size_t i=0;i<N;i++)
+			min_sq_dist[i] = mrpt::utils::square(static_cast<double>(detail::hammingDistance(descs[members[i]],first,desc_len)));
+
+		while (centers.size()<k*desc_len)
+		{
+			double total = 0;
+			for (size_t i=0;i<N;i++) total+=min_sq_dist[i];
+			if (total<=0) break; // All the remaining descriptors are equal to some center
+
+			const double r = rng.drawUniform(0,total);
+			size_t sel = 0;
+			double acc = min_sq_dist[0];
+			while (acc<r && sel+1<N) acc+=min_sq_dist[++sel];
+
+			const uint8_t *c = descs[members[sel]];
+			centers.insert(centers.end(), c, c+desc_len);
+			for (size_t i=0;i<N;i++)
+			{
+				const double d2 = mrpt::utils::square(static_cast<double>(detail::hammingDistance(descs[members[i]],c,desc_len)));
+				if (d2<min_sq_dist[i]) min_sq_dist[i]=d2;
+			}
+		}
+		size_t num_centers = centers.size()/desc_len;
+
+		// k-majority iterations:
+		unsigned int nThreads = params.num_threads ? params.num_threads : mrpt::system::getNumberOfProcessors();
+		nThreads = static_cast<unsigned int>( std::max<size_t>(1, std::min<size_t>(nThreads, N/MIN_VOC_DESCS_PER_THREAD)) );
+
+		vector_uint assignments(N, std::numeric_limits<uint32_t>::max());
+		std::vector<uint32_t> bit_counts;
+		vector_uint cluster_sizes;
+		for (unsigned int iter=0;iter<params.max_iterations;iter++)
+		{
+			TAssignClustersBlock functor(descs,members,centers,num_centers,desc_len,assignments,nThreads);
+			const unsigned int nBlocks = mrpt::system::parallelForBlocks(N,functor,nThreads);
+			bool changed = false;
+			for (unsigned int b=0;b<nBlocks;b++)
+				changed = changed || functor.block_changed[b]!=0;
+			if (!changed) break;
+
+			// Update centers with the bitwise majority of their descriptors:
+			bit_counts.assign(num_centers*desc_len*8, 0);
+			cluster_sizes.assign(num_centers, 0);
+			for (size_t i=0;i<N;i++)
+			{
+				const uint8_t *d = descs[members[i]];
+				uint32_t *counts = &bit_counts[assignments[i]*desc_len*8];
+				for (size_t byte=0;byte<desc_len;byte++)
+					for (int bit=0;bit<8;bit++)
+						if (d[byte] & (1<<bit)) counts[byte*8+bit]++;
+				cluster_sizes[assignments[i]]++;
+			}
+			for (size_t c=0;c<num_centers;c++)
+			{
+				if (!cluster_sizes[c]) continue; // Keep the old center; dropped below if still empty
+				uint8_t *center = &centers[c*desc_len];
+				const uint32_t *counts = &bit_counts[c*desc_len*8];
+				for (size_t byte=0;byte<desc_len;byte++)
+				{
+					uint8_t v = 0;
+					for (int bit=0;bit<8;bit++)
+						if (2*counts[byte*8+bit] > cluster_sizes[c]) v |= (1<<bit);
+					center[byte] = v;
+				}
+			}
+		}
+
+		// Build the output, dropping empty clusters:
+		std::vector<vector_uint> clusters(num_centers);
+		for (size_t i=0;i<N;i++)
+			clusters[assignments[i]].push_back(members[i]);
+		for (size_t c=0;c<num_centers;c++)
+		{
+			if (clusters[c].empty()) continue;
+			out_centers.insert(out_centers.end(), centers.begin()+c*desc_len, centers.begin()+(c+1)*desc_len);
+			out_clusters.push_back(vector_uint());
+			out_clusters.back().swap(clusters[c]);
+		}
+	}
+}
+
+CBinaryVocabulary::TTrainingParams::TTrainingParams() :
+	branching(10),
+	depth(5),
+	max_iterations(10),
+	num_threads(0),
+	random_seed(1234)
+{
+}
+
+CBinaryVocabulary::CBinaryVocabulary() : m_desc_len(0)
+{
+}
+
+void CBinaryVocabulary::clear()
+{
+	m_desc_len = 0;
+	m_node_descs.clear();
+	m_node_first_child.clear();
+	m_node_num_children.clear();
+	m_node_word.clear();
+	m_word_weights.clear();
+}
+
+void CBinaryVocabulary::train(const std::vector<std::vector<uint8_t> > &descs_per_image, const size_t desc_len, const TTrainingParams &params)
+{
+	MRPT_START
+	ASSERT_(desc_len>0)
+	ASSERT_ABOVEEQ_(params.branching,2)
+	ASSERT_ABOVEEQ_(params.depth,1)
+
+	std::vector<const uint8_t*> descs;
+	for (size_t i=0;i<descs_per_image.size();i++)
+	{
+		ASSERTMSG_(descs_per_image[i].size() % desc_len == 0, "Descriptor buffers must contain an integer number of descriptors")
+		for (size_t k=0;k<descs_per_image[i].size();k+=desc_len)
+			descs.push_back(&descs_per_image[i][k]);
+	}
+	ASSERTMSG_(!descs.empty(), "No training descriptors")
+
+	clear();
+	m_desc_len = desc_len;
+
+	// Root:
+	m_node_first_child.push_back(0);
+	m_node_num_children.push_back(0);
+	m_node_word.push_back(0);
+
+	struct TPendingNode
+	{
+		uint32_t node;
+		unsigned int level;
+		vector_uint members;
+	};
+	std::deque<TPendingNode> pending(1);
+	pending.front().node = 0;
+	pending.front().level = 0;
+	pending.front().members.resize(descs.size());
+	for (size_t i=0;i<descs.size();i++) pending.front().members[i] = static_cast<uint32_t>(i);
+
+	mrpt::random::CRandomGenerator rng(params.random_seed);
+	uint32_t num_words = 0;
+	std::vector<uint8_t> centers;
+	std::vector<vector_uint> clusters;
+
+	while (!pending.empty())
+	{
+		TPendingNode &p = pending.front();
+		if (p.level<params.depth && p.members.size()>1)
+			kMajorityClustering(descs,p.members,desc_len,params,rng,centers,clusters);
+		else clusters.clear();
+
+		if (clusters.size()<=1)
+		{
+			// Leaf = a word:
+			m_node_word[p.node] = num_words++;
+		}
+		else
+		{
+			const uint32_t first_child = static_cast<uint32_t>(m_node_first_child.size());
+			m_node_first_child[p.node] = first_child;
+			m_node_num_children[p.node] = static_cast<uint32_t>(clusters.size());
+			m_node_descs.insert(m_node_descs.end(), centers.begin(), centers.end());
+			for (size_t c=0;c<clusters.size();c++)
+			{
+				m_node_first_child.push_back(0);
+				m_node_num_children.push_back(0);
+				m_node_word.push_back(0);
+
+				pending.push_back(TPendingNode());
+				TPendingNode &child = pending.back();
+				child.node = first_child+static_cast<uint32_t>(c);
+				child.level = p.level+1;
+				child.members.swap(clusters[c]);
+			}
+		}
+		pending.pop_front();
+	}
+
+	// idf weights: log(N/n_i), with n_i the number of training images where word #i appears
+	m_word_weights.assign(num_words, 1.0f); // Needed by transform() below
+	vector_uint word_image_count(num_words,0);
+	std::vector<uint32_t> words;
+	for (size_t i=0;i<descs_per_image.size();i++)
+	{
+		words.clear();
+		const size_t n = descs_per_image[i].size()/desc_len;
+		for (size_t k=0;k<n;k++)
+			words.push_back(getWordID(&descs_per_image[i][k*desc_len]));
+		std::sort(words.begin(),words.end());
+		words.erase(std::unique(words.begin(),words.end()),words.end());
+		for (size_t k=0;k<words.size();k++)
+			word_image_count[words[k]]++;
+	}
+	const float num_images = static_cast<float>(descs_per_image.size());
+	for (size_t w=0;w<num_words;w++)
+		m_word_weights[w] = word_image_count[w] ? std::log(num_images/word_image_count[w]) : 0.0f;
+	MRPT_END
+}
+
+uint32_t CBinaryVocabulary::getWordID(const uint8_t *desc) const
+{
+	uint32_t node = 0;
+	while (m_node_num_children[node])
+	{
+		const uint32_t first = m_node_first_child[node];
+		uint32_t best = first;
+		unsigned int best_dist = std::numeric_limits<unsigned int>::max();
+		for (uint32_t c=first;c<first+m_node_num_children[node];c++)
+		{
+			const unsigned int dist = detail::hammingDistance(desc,&m_node_descs[(c-1)*m_desc_len],m_desc_len);
+			if (dist<best_dist) { best_dist=dist; best=c; }
+		}
+		node = best;
+	}
+	return m_node_word[node];
+}
+
+void CBinaryVocabulary::transform(const uint8_t *descs, const size_t num_descs, TBoWVector &out_bow, std::vector<uint32_t> *out_word_ids) const
+{
+	MRPT_START
+	ASSERTMSG_(!empty(), "The vocabulary is empty")
+	ASSERT_(descs!=NULL || num_descs==0)
+
+	std::vector<uint32_t> words(num_descs);
+	for (size_t i=0;i<num_descs;i++)
+		words[i] = getWordID(descs+i*m_desc_len);
+	if (out_word_ids) *out_word_ids = words;
+
+	// Term frequency x idf, L1-normalized:
+	std::sort(words.begin(),words.end());
+	out_bow.clear();
+	double sum = 0;
+	for (size_t i=0;i<words.size();)
+	{
+		size_t j = i+1;
+		while (j<words.size() && words[j]==words[i]) j++;
+		const float w = (j-i)*m_word_weights[words[i]];
+		if (w>0)
+		{
+			out_bow.push_back(std::make_pair(words[i],w));
+			sum += w;
+		}
+		i = j;
+	}
+	if (sum>0)
+	{
+		const float k = static_cast<float>(1.0/sum);
+		for (size_t i=0;i<out_bow.size();i++)
+			out_bow[i].second *= k;
+	}
+	MRPT_END
+}
+
+void CBinaryVocabulary::transform(const CFeatureList &feats, TBoWVector &out_bow) const
+{
+	MRPT_START
+	std::vector<uint8_t> descs;
+	size_t desc_len;
+	packDescriptorsORB(feats,descs,desc_len);
+	if (!feats.empty())
+		ASSERTMSG_(desc_len==m_desc_len, "Length of ORB descriptors does not match the vocabulary")
+	transform(descs.empty() ? NULL : &descs[0], feats.size(), out_bow);
+	MRPT_END
+}
+
+float CBinaryVocabulary::score(const TBoWVector &v1, const TBoWVector &v2)
+{
+	// For L1-normalized vectors: 1 - 0.5*|v1-v2| = 0.5 * sum_{common words} (|a|+|b|-|a-b|)
+	float s = 0;
+	TBoWVector::const_iterator it1=v1.begin(), it2=v2.begin();
+	while (it1!=v1.end() && it2!=v2.end())
+	{
+		if (it1->first<it2->first) ++it1;
+		else if (it2->first<it1->first) ++it2;
+		else
+		{
+			const float a = it1->second, b = it2->second;
+			s += std::abs(a) + std::abs(b) - std::abs(a-b);
+			++it1; ++it2;
+		}
+	}
+	return 0.5f*s;
+}
+
+void CBinaryVocabulary::writeToStream(mrpt::utils::CStream &out,int *version) const
+{
+	if (version)
+		*version = 0;
+	else
+	{
+		out << static_cast<uint64_t>(m_desc_len)
+			<< m_node_descs
+			<< m_node_first_child
+			<< m_node_num_children
+			<< m_node_word
+			<< m_word_weights;
+	}
+}
+
+void CBinaryVocabulary::readFromStream(mrpt::utils::CStream &in,int version)
+{
+	switch(version)
+	{
+	case 0:
+		{
+			uint64_t desc_len;
+			in  >> desc_len
+				>> m_node_descs
+				>> m_node_first_child
+				>> m_node_num_children
+				>> m_node_word
+				>> m_word_weights;
+			m_desc_len = static_cast<size_t>(desc_len);
+		} break;
+	default:
+		MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
+	};
+}
@@ -0,0 +1,179 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/CBinaryVocabulary.h>
+#include <mrpt/random/RandomGenerators.h>
+#include <mrpt/utils/CFileGZOutputStream.h>
+#include <mrpt/utils/CFileGZInputStream.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace std;
+
+namespace
+{
+	const size_t DESC_LEN = 32; // As ORB
+
+	// Synthetic "images": each one has the descriptors of some random prototypes, with a few bits flipped.
+	struct TSyntheticData
+	{
+		std::vector<uint8_t> prototypes;
+		std::vector<std::vector<uint8_t> > images;
+		mrpt::random::CRandomGenerator rng;
+
+		TSyntheticData(size_t num_prototypes, size_t num_images, size_t descs_per_image) : rng(4321)
+		{
+			prototypes.resize(num_prototypes*DESC_LEN);
+			for (size_t i=0;i<prototypes.size();i++)
+				prototypes[i] = static_cast<uint8_t>(rng.drawUniform32bit());
+			images.resize(num_images);
+			for (size_t i=0;i<num_images;i++)
+				for (size_t k=0;k<descs_per_image;k++)
+					addNoisyDescriptor(images[i], rng.drawUniform32bit() % num_prototypes);
+		}
+
+		void addNoisyDescriptor(std::vector<uint8_t> &img, size_t prototype, unsigned int flipped_bits = 3)
+		{
+			const size_t off = img.size();
+			img.insert(img.end(), prototypes.begin()+prototype*DESC_LEN, prototypes.begin()+(prototype+1)*DESC_LEN);
+			for (unsigned int b=0;b<flipped_bits;b++)
+			{
+				const uint32_t bit = rng.drawUniform32bit() % (DESC_LEN*8);
+				img[off+bit/8] ^= static_cast<uint8_t>(1<<(bit%8));
+			}
+		}
+
+		// The same image, with other noise:
+		std::vector<uint8_t> noisyCopy(const std::vector<uint8_t> &img)
+		{
+			std::vector<uint8_t> ret = img;
+			for (size_t k=0;k<ret.size();k+=DESC_LEN)
+			{
+				const uint32_t bit = rng.drawUniform32bit() % (DESC_LEN*8);
+				ret[k+bit/8] ^= static_cast<uint8_t>(1<<(bit%8));
+			}
+			return ret;
+		}
+	};
+
+	void train_vocabulary(const TSyntheticData &data, CBinaryVocabulary &voc)
+	{
+		CBinaryVocabulary::TTrainingParams params;
+		params.branching = 6;
+		params.depth = 3;
+		voc.train(data.images, DESC_LEN, params);
+	}
+}
+
+TEST(CBinaryVocabulary, Transform)
+{
+	TSyntheticData data(150, 40, 30);
+	CBinaryVocabulary voc;
+	train_vocabulary(data, voc);
+
+	EXPECT_EQ(voc.getDescriptorLength(), DESC_LEN);
+	EXPECT_GT(voc.getWordsCount(), 50u);
+	EXPECT_LE(voc.getWordsCount(), 6u*6u*6u);
+
+	const std::vector<uint8_t> &img = data.images[0];
+	const size_t N = img.size()/DESC_LEN;
+	TBoWVector bow;
+	std::vector<uint32_t> word_ids;
+	voc.transform(&img[0], N, bow, &word_ids);
+
+	ASSERT_EQ(word_ids.size(), N);
+	for (size_t i=0;i<N;i++)
+	{
+		EXPECT_EQ(word_ids[i], voc.getWordID(&img[i*DESC_LEN]));
+		EXPECT_LT(word_ids[i], voc.getWordsCount());
+	}
+
+	// Sorted by word ID, L1-normalized:
+	ASSERT_FALSE(bow.empty());
+	double sum = 0;
+	for (size_t i=0;i<bow.size();i++)
+	{
+		if (i>0) EXPECT_LT(bow[i-1].first, bow[i].first);
+		EXPECT_GT(bow[i].second, 0);
+		sum += bow[i].second;
+	}
+	EXPECT_NEAR(sum, 1.0, 1e-5);
+
+	// Most prototypes and their noisy versions fall into the same word (a prototype may be split
+	//  into several words if its training copies ended up in different clusters):
+	size_t num_same = 0;
+	for (size_t p=0;p<150;p++)
+	{
+		std::vector<uint8_t> noisy;
+		data.addNoisyDescriptor(noisy, p, 5);
+		if (voc.getWordID(&data.prototypes[p*DESC_LEN])==voc.getWordID(&noisy[0]))
+			num_same++;
+	}
+	EXPECT_GT(num_same, 135u);
+}
+
+TEST(CBinaryVocabulary, Score)
+{
+	TSyntheticData data(150, 40, 30);
+	CBinaryVocabulary voc;
+	train_vocabulary(data, voc);
+
+	TBoWVector bow0, bow0b, bow1;
+	const std::vector<uint8_t> img0b = data.noisyCopy(data.images[0]);
+	voc.transform(&data.images[0][0], data.images[0].size()/DESC_LEN, bow0);
+	voc.transform(&img0b[0], img0b.size()/DESC_LEN, bow0b);
+	voc.transform(&data.images[1][0], data.images[1].size()/DESC_LEN, bow1);
+
+	EXPECT_NEAR(CBinaryVocabulary::score(bow0,bow0), 1.0f, 1e-5f);
+	EXPECT_NEAR(CBinaryVocabulary::score(bow0,TBoWVector()), 0.0f, 1e-6f);
+	EXPECT_NEAR(CBinaryVocabulary::score(bow0,bow1), CBinaryVocabulary::score(bow1,bow0), 1e-6f);
+
+	// The same place seen again scores much higher than a different one:
+	const float s_same = CBinaryVocabulary::score(bow0,bow0b);
+	const float s_other = CBinaryVocabulary::score(bow0,bow1);
+	EXPECT_GT(s_same, 0.9f);
+	EXPECT_LT(s_other, 0.5f);
+	EXPECT_GE(s_other, 0.0f);
+}
+
+TEST(CBinaryVocabulary, FileRoundTrip)
+{
+	TSyntheticData data(150, 40, 30);
+	CBinaryVocabulary voc;
+	train_vocabulary(data, voc);
+
+	const std::string fil = mrpt::system::getTempFileName();
+	{
+		CFileGZOutputStream f(fil);
+		f << voc;
+	}
+	CBinaryVocabulary voc2;
+	{
+		CFileGZInputStream f(fil);
+		f >> voc2;
+	}
+	mrpt::system::deleteFile(fil);
+
+	EXPECT_EQ(voc2.getDescriptorLength(), voc.getDescriptorLength());
+	ASSERT_EQ(voc2.getWordsCount(), voc.getWordsCount());
+	for (uint32_t w=0;w<voc.getWordsCount();w++)
+		EXPECT_EQ(voc2.getWordWeight(w), voc.getWordWeight(w));
+
+	for (size_t i=0;i<data.images.size();i++)
+	{
+		const std::vector<uint8_t> &img = data.images[i];
+		TBoWVector bow, bow2;
+		voc.transform(&img[0], img.size()/DESC_LEN, bow);
+		voc2.transform(&img[0], img.size()/DESC_LEN, bow2);
+		EXPECT_TRUE(bow==bow2) << "image #" << i;
+	}
+}
@@ -0,0 +1,104 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"   // Precompiled headers
+#include <mrpt/vision/CBoWDatabase.h>
+#include <algorithm>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace std;
+
+namespace
+{
+	struct TQueryResultBetterThan
+	{
+		bool operator()(const TBoWQueryResult &a, const TBoWQueryResult &b) const {
+			return a.score>b.score || (a.score==b.score && a.image_id<b.image_id);
+		}
+	};
+
+	struct TTermImageLessThan
+	{
+		bool operator()(const std::pair<uint32_t,float> &a, const std::pair<uint32_t,float> &b) const {
+			return a.first<b.first;
+		}
+	};
+}
+
+CBoWDatabase::CBoWDatabase() : m_num_images(0)
+{
+}
+
+void CBoWDatabase::clear()
+{
+	m_inverted_index.clear();
+	m_num_images = 0;
+}
+
+size_t CBoWDatabase::add(const TBoWVector &bow)
+{
+	ASSERT_BELOW_(m_num_images,static_cast<size_t>(std::numeric_limits<uint32_t>::max()))
+	const uint32_t id = static_cast<uint32_t>(m_num_images++);
+	for (size_t i=0;i<bow.size();i++)
+	{
+		const uint32_t word = bow[i].first;
+		if (word>=m_inverted_index.size())
+			m_inverted_index.resize(word+1);
+		m_inverted_index[word].push_back(TPosting(id,bow[i].second));
+	}
+	return id;
+}
+
+void CBoWDatabase::query(
+	const TBoWVector &bow,
+	std::vector<TBoWQueryResult> &out_results,
+	const size_t max_results,
+	const float min_score,
+	const size_t max_image_id ) const
+{
+	out_results.clear();
+	const size_t num_images = std::min(m_num_images,max_image_id);
+	if (!num_images || !max_results) return;
+
+	// The terms of the L1 score (see CBinaryVocabulary::score()) of the images sharing words with the query. They are
+	//  added up after sorting them by image, so the cost and memory only depend on the number of such terms,
+	//  not on the size of the database:
+	std::vector<std::pair<uint32_t,float> > terms;
+	for (size_t i=0;i<bow.size();i++)
+	{
+		if (bow[i].first>=m_inverted_index.size()) continue;
+		const std::vector<TPosting> &postings = m_inverted_index[bow[i].first];
+		const float q = bow[i].second;
+		for (size_t k=0;k<postings.size();k++)
+		{
+			const TPosting &p = postings[k];
+			if (p.image_id>=num_images) break; // Postings are sorted by image ID
+			const float inc = std::abs(q) + std::abs(p.weight) - std::abs(q-p.weight);
+			if (inc>0) terms.push_back(std::make_pair(p.image_id,inc));
+		}
+	}
+
+	// Stable, so the terms of each image are added up in the order of the query words:
+	std::stable_sort(terms.begin(),terms.end(),TTermImageLessThan());
+	for (size_t i=0;i<terms.size();)
+	{
+		const uint32_t id = terms[i].first;
+		float acc = 0;
+		for (;i<terms.size() && terms[i].first==id;i++)
+			acc += terms[i].second;
+		const float score = 0.5f*acc;
+		if (score>=min_score)
+			out_results.push_back(TBoWQueryResult(id,score));
+	}
+
+	const size_t n = std::min(max_results,out_results.size());
+	std::partial_sort(out_results.begin(),out_results.begin()+n,out_results.end(),TQueryResultBetterThan());
+	out_results.resize(n);
+}
@@ -0,0 +1,115 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/CBoWDatabase.h>
+#include <mrpt/random/RandomGenerators.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace std;
+
+namespace
+{
+	// Random BoW vectors (as returned by CBinaryVocabulary::transform()): sorted word IDs, L1-normalized weights.
+	void random_bow(mrpt::random::CRandomGenerator &rng, size_t num_words, size_t voc_size, TBoWVector &bow)
+	{
+		std::vector<uint32_t> words;
+		while (words.size()<num_words)
+		{
+			const uint32_t w = rng.drawUniform32bit() % voc_size;
+			if (std::find(words.begin(),words.end(),w)==words.end()) words.push_back(w);
+		}
+		std::sort(words.begin(),words.end());
+		bow.clear();
+		double sum = 0;
+		for (size_t i=0;i<words.size();i++)
+		{
+			bow.push_back(std::make_pair(words[i], static_cast<float>(rng.drawUniform(0.1,1.0))));
+			sum += bow.back().second;
+		}
+		for (size_t i=0;i<bow.size();i++)
+			bow[i].second /= sum;
+	}
+}
+
+TEST(CBoWDatabase, QueryMatchesScore)
+{
+	mrpt::random::CRandomGenerator rng(1234);
+	const size_t N = 200;
+	std::vector<TBoWVector> bows(N);
+	CBoWDatabase db;
+	for (size_t i=0;i<N;i++)
+	{
+		random_bow(rng, 40, 1000, bows[i]);
+		EXPECT_EQ(db.add(bows[i]), i);
+	}
+	EXPECT_EQ(db.size(), N);
+
+	for (size_t q=0;q<N;q+=17)
+	{
+		std::vector<TBoWQueryResult> res;
+		db.query(bows[q], res, N);
+		ASSERT_FALSE(res.empty());
+
+		// The image itself is the best one:
+		EXPECT_EQ(res[0].image_id, q);
+		EXPECT_NEAR(res[0].score, 1.0f, 1e-5f);
+
+		// Scores are those of CBinaryVocabulary::score(), sorted:
+		for (size_t i=0;i<res.size();i++)
+		{
+			EXPECT_NEAR(res[i].score, CBinaryVocabulary::score(bows[q],bows[res[i].image_id]), 1e-5f);
+			if (i>0) EXPECT_LE(res[i].score, res[i-1].score);
+		}
+
+		// Images not returned share no word with the query:
+		std::vector<bool> returned(N,false);
+		for (size_t i=0;i<res.size();i++) returned[res[i].image_id] = true;
+		for (size_t i=0;i<N;i++)
+			if (!returned[i]) EXPECT_EQ(CBinaryVocabulary::score(bows[q],bows[i]), 0.0f);
+	}
+}
+
+TEST(CBoWDatabase, QueryLimits)
+{
+	mrpt::random::CRandomGenerator rng(1234);
+	const size_t N = 50;
+	std::vector<TBoWVector> bows(N);
+	CBoWDatabase db;
+	for (size_t i=0;i<N;i++)
+	{
+		random_bow(rng, 40, 200, bows[i]);
+		db.add(bows[i]);
+	}
+
+	std::vector<TBoWQueryResult> res;
+	db.query(bows[N-1], res, 3);
+	ASSERT_EQ(res.size(), 3u);
+	EXPECT_EQ(res[0].image_id, N-1);
+
+	// Skip the most recent images:
+	db.query(bows[N-1], res, N, 0, N-10);
+	ASSERT_FALSE(res.empty());
+	for (size_t i=0;i<res.size();i++)
+		EXPECT_LT(res[i].image_id, N-10);
+
+	db.query(bows[N-1], res, N, 0, 0);
+	EXPECT_TRUE(res.empty());
+
+	db.query(bows[N-1], res, N, 0.5f);
+	for (size_t i=0;i<res.size();i++)
+		EXPECT_GE(res[i].score, 0.5f);
+
+	db.clear();
+	EXPECT_EQ(db.size(), 0u);
+	db.query(bows[0], res);
+	EXPECT_TRUE(res.empty());
+}
@@ -13,6 +13,7 @@
 #include <mrpt/utils/utils_defs.h>
 #include <mrpt/utils/CTicTac.h>
 #include <mrpt/utils/round.h>
+#include <mrpt/system/threads.h>
 
 using namespace mrpt;
 using namespace mrpt::vision;
@@ -22,6 +23,620 @@ using namespace Eigen;
 using mrpt::utils::round;
 using mrpt::utils::square;
 
+namespace
+{
+	/** Minimum number of pixels per thread worth spawning a new thread for */
+	const size_t MIN_DIFODO_PIXELS_PER_THREAD = 8192;
+
+	/** Number of threads (and blocks of columns) to process an image of the given size */
+	unsigned int difodoNumThreads(const unsigned int num_threads, const size_t rows, const size_t cols)
+	{
+		const size_t n = num_threads ? num_threads : mrpt::system::getNumberOfProcessors();
+		return static_cast<unsigned int>( std::max<size_t>(1, std::min(n, std::min(cols, rows*cols/MIN_DIFODO_PIXELS_PER_THREAD))) );
+	}
+
+	/** Downsampling of one level of the pyramid with the 5x5 gaussian mask (CDifodo::buildCoordinatesPyramid) */
+	struct TPyramidLevelBlock
+	{
+		const MatrixXf &prev;
+		MatrixXf &out;
+		const float (*g_mask)[5];
+		const unsigned int rows_i, cols_i;
+
+		TPyramidLevelBlock(const MatrixXf &prev_, MatrixXf &out_, const float (*g_mask_)[5], unsigned int rows_i_, unsigned int cols_i_) :
+			prev(prev_), out(out_), g_mask(g_mask_), rows_i(rows_i_), cols_i(cols_i_)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			const float max_depth_dif = 0.1f;
+			const int rows_i2 = 2*rows_i;
+			const int cols_i2 = 2*cols_i;
+
+			for (unsigned int u = first; u < last; u++)
+			for (unsigned int v = 0; v < rows_i; v++)
+			{
+				const int u2 = 2*u;
+				const int v2 = 2*v;
+				const float dcenter = prev(v2,u2);
+
+				//Inner pixels
+				if ((v>0)&&(v<rows_i-1)&&(u>0)&&(u<cols_i-1))
+				{
+					if (dcenter > 0.f)
+					{
+						float sum = 0.f;
+						float weight = 0.f;
+
+						for (int l = -2; l<3; l++)
+						for (int k = -2; k<3; k++)
+						{
+							const float abs_dif = abs(prev(v2+k,u2+l)-dcenter);
+							if (abs_dif < max_depth_dif)
+							{
+								const float aux_w = g_mask[2+k][2+l]*(max_depth_dif - abs_dif);
+								weight += aux_w;
+								sum += aux_w*prev(v2+k,u2+l);
+							}
+						}
+						out(v,u) = sum/weight;
+					}
+					else
+					{
+						float min_depth = 10.f;
+						for (int l = -2; l<3; l++)
+						for (int k = -2; k<3; k++)
+						{
+							const float d = prev(v2+k,u2+l);
+							if ((d > 0.f)&&(d < min_depth))
+								min_depth = d;
+						}
+
+						if (min_depth < 10.f)
+							out(v,u) = min_depth;
+						else
+							out(v,u) = 0.f;
+					}
+				}
+
+				//Boundary
+				else
+				{
+					if (dcenter > 0.f)
+					{
+						float sum = 0.f;
+						float weight = 0.f;
+
+						for (int l = -2; l<3; l++)
+						for (int k = -2; k<3; k++)
+						{
+							const int indv = v2+k,indu = u2+l;
+							if ((indv>=0)&&(indv<rows_i2)&&(indu>=0)&&(indu<cols_i2))
+							{
+								const float abs_dif = abs(prev(indv,indu)-dcenter);
+								if (abs_dif < max_depth_dif)
+								{
+									const float aux_w = g_mask[2+k][2+l]*(max_depth_dif - abs_dif);
+									weight += aux_w;
+									sum += aux_w*prev(indv,indu);
+								}
+							}
+						}
+						out(v,u) = sum/weight;
+					}
+					else
+					{
+						float min_depth = 10.f;
+						for (int l = -2; l<3; l++)
+						for (int k = -2; k<3; k++)
+						{
+							const int indv = v2+k,indu = u2+l;
+							if ((indv>=0)&&(indv<rows_i2)&&(indu>=0)&&(indu<cols_i2))
+							{
+								const float d = prev(indv,indu);
+								if ((d > 0.f)&&(d < min_depth))
+									min_depth = d;
+							}
+						}
+
+						if (min_depth < 10.f)
+							out(v,u) = min_depth;
+						else
+							out(v,u) = 0.f;
+					}
+				}
+			}
+		}
+	};
+
+	/** Downsampling of one level of the pyramid with the 4x4 mask (CDifodo::buildCoordinatesPyramidFast) */
+	struct TPyramidLevelFastBlock
+	{
+		const MatrixXf &prev;
+		MatrixXf &out;
+		const Matrix4f &f_mask;
+		const unsigned int rows_i, cols_i;
+
+		TPyramidLevelFastBlock(const MatrixXf &prev_, MatrixXf &out_, const Matrix4f &f_mask_, unsigned int rows_i_, unsigned int cols_i_) :
+			prev(prev_), out(out_), f_mask(f_mask_), rows_i(rows_i_), cols_i(cols_i_)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			const float max_depth_dif = 0.1f;
+
+			for (unsigned int u = first; u < last; u++)
+				for (unsigned int v = 0; v < rows_i; v++)
+				{
+					const int u2 = 2*u;
+					const int v2 = 2*v;
+
+					//Inner pixels
+					if ((v>0)&&(v<rows_i-1)&&(u>0)&&(u<cols_i-1))
+					{
+						const Matrix4f d_block = prev.block<4,4>(v2-1,u2-1);
+						float depths[4] = {d_block(5),d_block(6),d_block(9),d_block(10)};
+						float dcenter;
+
+						//Sort the array (try to find a good/representative value)
+						for (signed char k = 2; k>=0; k--)
+						if (depths[k+1] < depths[k])
+							std::swap(depths[k+1],depths[k]);
+						for (unsigned char k = 1; k<3; k++)
+						if (depths[k] > depths[k+1])
+							std::swap(depths[k+1],depths[k]);
+						if (depths[2] < depths[1])
+							dcenter = depths[1];
+						else
+							dcenter = depths[2];
+
+						if (dcenter > 0.f)
+						{
+							float sum = 0.f;
+							float weight = 0.f;
+
+							for (unsigned char k = 0; k<16; k++)
+							{
+								const float abs_dif = abs(d_block(k) - dcenter);
+								if (abs_dif < max_depth_dif)
+								{
+									const float aux_w = f_mask(k)*(max_depth_dif - abs_dif);
+									weight += aux_w;
+									sum += aux_w*d_block(k);
+								}
+							}
+							out(v,u) = sum/weight;
+						}
+						else
+							out(v,u) = 0.f;
+					}
+
+					//Boundary
+					else
+					{
+						const Matrix2f d_block = prev.block<2,2>(v2,u2);
+						const float new_d = 0.25f*d_block.sumAll();
+						if (new_d < 0.4f)
+							out(v,u) = 0.f;
+						else
+							out(v,u) = new_d;
+					}
+				}
+		}
+	};
+
+	/** Coordinates "xy" of the points of a depth image, column by column (vectorized with Eigen) */
+	struct TPointCoordsBlock
+	{
+		const MatrixXf &depth;
+		MatrixXf &xx, &yy;
+		const float inv_f_i, disp_u_i;
+		VectorXf v_disp; //!< (v - disp_v_i) for each row
+
+		TPointCoordsBlock(const MatrixXf &depth_, MatrixXf &xx_, MatrixXf &yy_, float inv_f_i_, float disp_u_i_, float disp_v_i_) :
+			depth(depth_), xx(xx_), yy(yy_), inv_f_i(inv_f_i_), disp_u_i(disp_u_i_),
+			v_disp( VectorXf::LinSpaced(depth_.rows(),0.f,float(depth_.rows()-1)).array() - disp_v_i_ )
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			for (size_t u = first; u < last; u++)
+			{
+				const float u_disp = float(u) - disp_u_i;
+				xx.col(u) = (depth.col(u).array() > 0.f).select( (u_disp*depth.col(u).array())*inv_f_i, 0.f );
+				yy.col(u) = (depth.col(u).array() > 0.f).select( (v_disp.array()*depth.col(u).array())*inv_f_i, 0.f );
+			}
+		}
+	};
+
+	/** Splatting of the warped points. Each block accumulates into its own buffers, added up afterwards
+	  *  (block #0 directly writes into the output matrices). */
+	struct TWarpingBlock
+	{
+		const MatrixXf &depth, &xx, &yy;
+		const Matrix4f &acu_trans;
+		const float f, disp_u_i, disp_v_i;
+		MatrixXf &depth_warped, &wacu;
+		std::vector<MatrixXf> block_depth, block_wacu;
+
+		TWarpingBlock(const MatrixXf &depth_, const MatrixXf &xx_, const MatrixXf &yy_, const Matrix4f &acu_trans_,
+			float f_, float disp_u_i_, float disp_v_i_, MatrixXf &depth_warped_, MatrixXf &wacu_, unsigned int num_blocks) :
+			depth(depth_), xx(xx_), yy(yy_), acu_trans(acu_trans_), f(f_), disp_u_i(disp_u_i_), disp_v_i(disp_v_i_),
+			depth_warped(depth_warped_), wacu(wacu_), block_depth(num_blocks), block_wacu(num_blocks)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int block)
+		{
+			const unsigned int rows_i = depth.rows(), cols_i = depth.cols();
+			MatrixXf *acu_depth = &depth_warped, *acu_w = &wacu;
+			if (block>0)
+			{
+				block_depth[block].setZero(rows_i,cols_i);
+				block_wacu[block].setZero(rows_i,cols_i);
+				acu_depth = &block_depth[block];
+				acu_w = &block_wacu[block];
+			}
+
+			const float cols_lim = float(cols_i-1);
+			const float rows_lim = float(rows_i-1);
+
+			for (unsigned int j = first; j<last; j++)
+				for (unsigned int i = 0; i<rows_i; i++)
+				{
+					const float z = depth(i,j);
+
+					if (z > 0.f)
+					{
+						//Transform point to the warped reference frame
+						const float depth_w = acu_trans(0,0)*z + acu_trans(0,1)*xx(i,j) + acu_trans(0,2)*yy(i,j) + acu_trans(0,3);
+						const float x_w = acu_trans(1,0)*z + acu_trans(1,1)*xx(i,j) + acu_trans(1,2)*yy(i,j) + acu_trans(1,3);
+						const float y_w = acu_trans(2,0)*z + acu_trans(2,1)*xx(i,j) + acu_trans(2,2)*yy(i,j) + acu_trans(2,3);
+
+						//Calculate warping
+						const float uwarp = f*x_w/depth_w + disp_u_i;
+						const float vwarp = f*y_w/depth_w + disp_v_i;
+
+						//The warped pixel (which is not integer in general) contributes to all the surrounding ones
+						if (( uwarp >= 0.f)&&( uwarp < cols_lim)&&( vwarp >= 0.f)&&( vwarp < rows_lim))
+						{
+							const int uwarp_l = uwarp;
+							const int uwarp_r = uwarp_l + 1;
+							const int vwarp_d = vwarp;
+							const int vwarp_u = vwarp_d + 1;
+							const float delta_r = float(uwarp_r) - uwarp;
+							const float delta_l = uwarp - float(uwarp_l);
+							const float delta_u = float(vwarp_u) - vwarp;
+							const float delta_d = vwarp - float(vwarp_d);
+
+							//Warped pixel very close to an integer value
+							const int uwarp_round = round(uwarp), vwarp_round = round(vwarp);
+							if (abs(uwarp_round - uwarp) + abs(vwarp_round - vwarp) < 0.05f)
+							{
+								(*acu_depth)(vwarp_round, uwarp_round) += depth_w;
+								(*acu_w)(vwarp_round, uwarp_round) += 1.f;
+							}
+							else
+							{
+								const float w_ur = square(delta_l) + square(delta_d);
+								(*acu_depth)(vwarp_u,uwarp_r) += w_ur*depth_w;
+								(*acu_w)(vwarp_u,uwarp_r) += w_ur;
+
+								const float w_ul = square(delta_r) + square(delta_d);
+								(*acu_depth)(vwarp_u,uwarp_l) += w_ul*depth_w;
+								(*acu_w)(vwarp_u,uwarp_l) += w_ul;
+
+								const float w_dr = square(delta_l) + square(delta_u);
+								(*acu_depth)(vwarp_d,uwarp_r) += w_dr*depth_w;
+								(*acu_w)(vwarp_d,uwarp_r) += w_dr;
+
+								const float w_dl = square(delta_r) + square(delta_u);
+								(*acu_depth)(vwarp_d,uwarp_l) += w_dl*depth_w;
+								(*acu_w)(vwarp_d,uwarp_l) += w_dl;
+							}
+						}
+					}
+				}
+		}
+	};
+
+	/** Scales the accumulated warped depth and computes its spatial coordinates */
+	struct TWarpedCoordsBlock
+	{
+		MatrixXf &depth_warped, &xx_warped, &yy_warped;
+		const MatrixXf &wacu;
+		const float inv_f_i, disp_u_i, disp_v_i;
+
+		TWarpedCoordsBlock(MatrixXf &depth_warped_, MatrixXf &xx_warped_, MatrixXf &yy_warped_, const MatrixXf &wacu_, float inv_f_i_, float disp_u_i_, float disp_v_i_) :
+			depth_warped(depth_warped_), xx_warped(xx_warped_), yy_warped(yy_warped_), wacu(wacu_), inv_f_i(inv_f_i_), disp_u_i(disp_u_i_), disp_v_i(disp_v_i_)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			const unsigned int rows_i = depth_warped.rows();
+			for (unsigned int u = first; u<last; u++)
+				for (unsigned int v = 0; v<rows_i; v++)
+				{
+					if (wacu(v,u) > 0.f)
+					{
+						depth_warped(v,u) /= wacu(v,u);
+						xx_warped(v,u) = (u - disp_u_i)*depth_warped(v,u)*inv_f_i;
+						yy_warped(v,u) = (v - disp_v_i)*depth_warped(v,u)*inv_f_i;
+					}
+					else
+					{
+						depth_warped(v,u) = 0.f;
+						xx_warped(v,u) = 0.f;
+						yy_warped(v,u) = 0.f;
+					}
+				}
+		}
+	};
+
+	/** "Average" coordinates of the two frames and null measurements (CDifodo::calculateCoord) */
+	struct TInterCoordsBlock
+	{
+		const MatrixXf &depth_old, &xx_old, &yy_old, &depth_warped, &xx_warped, &yy_warped;
+		MatrixXf &depth_inter, &xx_inter, &yy_inter;
+		Matrix<bool, Dynamic, Dynamic> &null;
+		std::vector<unsigned int> block_num_valid;
+
+		TInterCoordsBlock(const MatrixXf &depth_old_, const MatrixXf &xx_old_, const MatrixXf &yy_old_,
+			const MatrixXf &depth_warped_, const MatrixXf &xx_warped_, const MatrixXf &yy_warped_,
+			MatrixXf &depth_inter_, MatrixXf &xx_inter_, MatrixXf &yy_inter_, Matrix<bool, Dynamic, Dynamic> &null_, unsigned int num_blocks) :
+			depth_old(depth_old_), xx_old(xx_old_), yy_old(yy_old_), depth_warped(depth_warped_), xx_warped(xx_warped_), yy_warped(yy_warped_),
+			depth_inter(depth_inter_), xx_inter(xx_inter_), yy_inter(yy_inter_), null(null_), block_num_valid(num_blocks,0)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int block)
+		{
+			const unsigned int rows_i = null.rows(), cols_i = null.cols();
+			unsigned int num_valid = 0;
+			for (unsigned int u = first; u < last; u++)
+				for (unsigned int v = 0; v < rows_i; v++)
+				{
+					if ((depth_old(v,u)) == 0.f || (depth_warped(v,u) == 0.f))
+					{
+						depth_inter(v,u) = 0.f;
+						xx_inter(v,u) = 0.f;
+						yy_inter(v,u) = 0.f;
+						null(v, u) = true;
+					}
+					else
+					{
+						depth_inter(v,u) = 0.5f*(depth_old(v,u) + depth_warped(v,u));
+						xx_inter(v,u) = 0.5f*(xx_old(v,u) + xx_warped(v,u));
+						yy_inter(v,u) = 0.5f*(yy_old(v,u) + yy_warped(v,u));
+						null(v, u) = false;
+						if ((u>0)&&(v>0)&&(u<cols_i-1)&&(v<rows_i-1))
+							num_valid++;
+					}
+				}
+			block_num_valid[block] = num_valid;
+		}
+	};
+
+	/** Connectivity of each pixel with its right and lower neighbors (CDifodo::calculateDepthDerivatives) */
+	struct TConnectivityBlock
+	{
+		const MatrixXf &depth_inter, &xx_inter, &yy_inter;
+		const Matrix<bool, Dynamic, Dynamic> &null;
+		MatrixXf &rx_ninv, &ry_ninv;
+
+		TConnectivityBlock(const MatrixXf &depth_inter_, const MatrixXf &xx_inter_, const MatrixXf &yy_inter_, const Matrix<bool, Dynamic, Dynamic> &null_, MatrixXf &rx_ninv_, MatrixXf &ry_ninv_) :
+			depth_inter(depth_inter_), xx_inter(xx_inter_), yy_inter(yy_inter_), null(null_), rx_ninv(rx_ninv_), ry_ninv(ry_ninv_)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			const unsigned int rows_i = null.rows(), cols_i = null.cols();
+			for (unsigned int u = first; u < last; u++)
+			{
+				if (u < cols_i-1)
+					for (unsigned int v = 0; v < rows_i; v++)
+						if (null(v,u) == false)
+						{
+							rx_ninv(v,u) = sqrtf(square(xx_inter(v,u+1) - xx_inter(v,u))
+												+ square(depth_inter(v,u+1) - depth_inter(v,u)));
+						}
+
+				for (unsigned int v = 0; v < rows_i-1; v++)
+					if (null(v,u) == false)
+					{
+						ry_ninv(v,u) = sqrtf(square(yy_inter(v+1,u) - yy_inter(v,u))
+											+ square(depth_inter(v+1,u) - depth_inter(v,u)));
+					}
+			}
+		}
+	};
+
+	/** Spatial and temporal depth derivatives (CDifodo::calculateDepthDerivatives).
+	  *  The first and last columns of "du" are filled afterwards. */
+	struct TDerivativesBlock
+	{
+		const MatrixXf &depth_inter, &depth_warped, &depth_old;
+		const Matrix<bool, Dynamic, Dynamic> &null;
+		const MatrixXf &rx_ninv, &ry_ninv;
+		MatrixXf &du, &dv, &dt;
+		const float fps;
+
+		TDerivativesBlock(const MatrixXf &depth_inter_, const MatrixXf &depth_warped_, const MatrixXf &depth_old_, const Matrix<bool, Dynamic, Dynamic> &null_,
+			const MatrixXf &rx_ninv_, const MatrixXf &ry_ninv_, MatrixXf &du_, MatrixXf &dv_, MatrixXf &dt_, float fps_) :
+			depth_inter(depth_inter_), depth_warped(depth_warped_), depth_old(depth_old_), null(null_),
+			rx_ninv(rx_ninv_), ry_ninv(ry_ninv_), du(du_), dv(dv_), dt(dt_), fps(fps_)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			const unsigned int rows_i = null.rows(), cols_i = null.cols();
+			for (unsigned int u = first; u < last; u++)
+			{
+				if ((u>0)&&(u<cols_i-1))
+					for (unsigned int v = 0; v < rows_i; v++)
+						if (null(v,u) == false)
+							du(v,u) = (rx_ninv(v,u-1)*(depth_inter(v,u+1)-depth_inter(v,u)) + rx_ninv(v,u)*(depth_inter(v,u) - depth_inter(v,u-1)))/(rx_ninv(v,u)+rx_ninv(v,u-1));
+
+				for (unsigned int v = 1; v < rows_i-1; v++)
+					if (null(v,u) == false)
+						dv(v,u) = (ry_ninv(v-1,u)*(depth_inter(v+1,u)-depth_inter(v,u)) + ry_ninv(v,u)*(depth_inter(v,u) - depth_inter(v-1,u)))/(ry_ninv(v,u)+ry_ninv(v-1,u));
+
+				dv(0,u) = dv(1,u);
+				dv(rows_i-1,u) = dv(rows_i-2,u);
+
+				//Temporal derivative
+				for (unsigned int v = 0; v < rows_i; v++)
+					if (null(v,u) == false)
+						dt(v,u) = fps*(depth_warped(v,u) - depth_old(v,u));
+			}
+		}
+	};
+
+	/** Weights of the range flow constraint equations (CDifodo::computeWeights).
+	  *  Blocks index the inner columns only (block index "u" is the image column u+1). */
+	struct TWeightsBlock
+	{
+		const MatrixXf &depth_inter, &xx_inter, &yy_inter, &depth_old, &depth_warped, &du, &dv, &dt;
+		const Matrix<bool, Dynamic, Dynamic> &null;
+		const Matrix<float,6,1> &kai_level;
+		const float f_inv, fps;
+		MatrixXf &weights;
+
+		TWeightsBlock(const MatrixXf &depth_inter_, const MatrixXf &xx_inter_, const MatrixXf &yy_inter_, const MatrixXf &depth_old_, const MatrixXf &depth_warped_,
+			const MatrixXf &du_, const MatrixXf &dv_, const MatrixXf &dt_, const Matrix<bool, Dynamic, Dynamic> &null_,
+			const Matrix<float,6,1> &kai_level_, float f_inv_, float fps_, MatrixXf &weights_) :
+			depth_inter(depth_inter_), xx_inter(xx_inter_), yy_inter(yy_inter_), depth_old(depth_old_), depth_warped(depth_warped_),
+			du(du_), dv(dv_), dt(dt_), null(null_), kai_level(kai_level_), f_inv(f_inv_), fps(fps_), weights(weights_)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			const unsigned int rows_i = null.rows();
+
+			//Parameters for the measurement error
+			const float kz2 = 8.122e-12f;  //square(1.425e-5) / 25
+
+			//Parameters for linearization error
+			const float kduv = 20e-5f;
+			const float kdt = kduv/square(fps);
+			const float k2dt = 5e-6f;
+			const float k2duv = 5e-6f;
+
+			for (unsigned int u = first+1; u < last+1; u++)
+				for (unsigned int v = 1; v < rows_i-1; v++)
+					if (null(v,u) == false)
+					{
+						//					Compute measurment error (simplified)
+						//-----------------------------------------------------------------------
+						const float z = depth_inter(v,u);
+						const float inv_d = 1.f/z;
+						const float z2 = z*z;
+						const float z4 = z2*z2;
+
+						const float var44 = kz2*z4*square(fps);
+						const float var55 = kz2*z4*0.25f;
+						const float var66 = var55;
+
+						const float j4 = 1.f;
+						const float j5 =  xx_inter(v,u)*inv_d*inv_d*f_inv*(kai_level[0] + yy_inter(v,u)*kai_level[4] - xx_inter(v,u)*kai_level[5])
+									   + inv_d*f_inv*(-kai_level[1] - z*kai_level[5] + yy_inter(v,u)*kai_level[3]);
+						const float j6 = yy_inter(v,u)*inv_d*inv_d*f_inv*(kai_level[0] + yy_inter(v,u)*kai_level[4] - xx_inter(v,u)*kai_level[5])
+									   + inv_d*f_inv*(-kai_level[2] + z*kai_level[4] - xx_inter(v,u)*kai_level[3]);
+
+						const float error_m = j4*j4*var44 + j5*j5*var55 + j6*j6*var66;
+
+						//					Compute linearization error
+						//-----------------------------------------------------------------------
+						const float ini_du = depth_old(v,u+1) - depth_old(v,u-1);
+						const float ini_dv = depth_old(v+1,u) - depth_old(v-1,u);
+						const float final_du = depth_warped(v,u+1) - depth_warped(v,u-1);
+						const float final_dv = depth_warped(v+1,u) - depth_warped(v-1,u);
+
+						const float dut = ini_du - final_du;
+						const float dvt = ini_dv - final_dv;
+						const float duu = du(v,u+1) - du(v,u-1);
+						const float dvv = dv(v+1,u) - dv(v-1,u);
+						const float dvu = dv(v,u+1) - dv(v,u-1); //Completely equivalent to compute duv
+
+						const float error_l = kdt*square(dt(v,u)) + kduv*(square(du(v,u)) + square(dv(v,u))) + k2dt*(square(dut) + square(dvt))
+													+ k2duv*(square(duu) + square(dvv) + square(dvu));
+
+						//Weight
+						weights(v,u) = sqrt(1.f/(error_m + error_l));
+					}
+		}
+	};
+
+	/** Reduction of the weighted least squares normal equations (A^t*A, A^t*B) of CDifodo::solveOneLevel(), without building A,
+	  *  and of the squared residuals once the solution is known. Each block sums up the rows of its columns.
+	  *  Blocks index the inner columns only, as in TWeightsBlock. */
+	struct TNormalEquationsBlock
+	{
+		const MatrixXf &depth_inter, &xx_inter, &yy_inter, &du, &dv, &dt, &weights;
+		const Matrix<bool, Dynamic, Dynamic> &null;
+		const float f_inv;
+		const Matrix<float,6,1> *solution; //!< If not NULL, compute the squared residuals instead of the normal equations
+		std::vector<Matrix<double,6,6>, Eigen::aligned_allocator<Matrix<double,6,6> > > block_AtA;
+		std::vector<Matrix<double,6,1>, Eigen::aligned_allocator<Matrix<double,6,1> > > block_AtB;
+		std::vector<double> block_res2;
+
+		TNormalEquationsBlock(const MatrixXf &depth_inter_, const MatrixXf &xx_inter_, const MatrixXf &yy_inter_, const MatrixXf &du_, const MatrixXf &dv_,
+			const MatrixXf &dt_, const MatrixXf &weights_, const Matrix<bool, Dynamic, Dynamic> &null_, float f_inv_, unsigned int num_blocks) :
+			depth_inter(depth_inter_), xx_inter(xx_inter_), yy_inter(yy_inter_), du(du_), dv(dv_), dt(dt_), weights(weights_), null(null_), f_inv(f_inv_),
+			solution(NULL), block_AtA(num_blocks, Matrix<double,6,6>::Zero()), block_AtB(num_blocks, Matrix<double,6,1>::Zero()), block_res2(num_blocks,0.0)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int block)
+		{
+			const unsigned int rows_i = null.rows();
+			Matrix<double,6,6> AtA = Matrix<double,6,6>::Zero();
+			Matrix<double,6,1> AtB = Matrix<double,6,1>::Zero();
+			double res2 = 0;
+			Matrix<float,6,1> a;
+
+			//The order of the unknowns is (vz, vx, vy, wz, wx, wy)
+			for (unsigned int u = first+1; u < last+1; u++)
+				for (unsigned int v = 1; v < rows_i-1; v++)
+					if (null(v,u) == false)
+					{
+						// Precomputed expressions
+						const float d = depth_inter(v,u);
+						const float inv_d = 1.f/d;
+						const float x = xx_inter(v,u);
+						const float y = yy_inter(v,u);
+						const float dycomp = du(v,u)*f_inv*inv_d;
+						const float dzcomp = dv(v,u)*f_inv*inv_d;
+						const float tw = weights(v,u);
+
+						//Row of the matrix A
+						a[0] = tw*(1.f + dycomp*x*inv_d + dzcomp*y*inv_d);
+						a[1] = tw*(-dycomp);
+						a[2] = tw*(-dzcomp);
+						a[3] = tw*(dycomp*y - dzcomp*x);
+						a[4] = tw*(y + dycomp*inv_d*y*x + dzcomp*(y*y*inv_d + d));
+						a[5] = tw*(-x - dycomp*(x*x*inv_d + d) - dzcomp*inv_d*y*x);
+						const float b = tw*(-dt(v,u));
+
+						if (solution)
+							res2 += square(a.dot(*solution) - b);
+						else
+						{
+							const Matrix<double,6,1> ad = a.cast<double>();
+							AtA.selfadjointView<Lower>().rankUpdate(ad);
+							AtB += double(b)*ad;
+						}
+					}
+
+			block_AtA[block] = AtA;
+			block_AtB[block] = AtB;
+			block_res2[block] = res2;
+		}
+	};
+}
+
+CDifodo::TStageTimes::TStageTimes() :
+	pyramid(0), warping(0), coordinates(0), derivatives(0), weights(0), solver(0), filter(0)
+{
+}
+
 CDifodo::CDifodo()
 {
 	rows = 60;
@@ -88,6 +703,8 @@ CDifodo::CDifodo()
 	previous_speed_eig_weight = 0.5f;
 	kai_loc_old.assign(0.f);
 	num_valid_points = 0;
+	execution_time = 0.f;
+	num_threads = 0;
 
 	//Compute gaussian mask
 	VectorXf v_mask(4);
@@ -105,8 +722,6 @@ CDifodo::CDifodo()
 
 void CDifodo::buildCoordinatesPyramid()
 {
-	const float max_depth_dif = 0.1f;
-
 	//Push coordinates back
 	depth_old.swap(depth);
 	xx_old.swap(xx);
@@ -123,9 +738,7 @@ void CDifodo::buildCoordinatesPyramid()
 		unsigned int s = pow(2.f,int(i));
 		cols_i = width/s;
 		rows_i = height/s;
-		const int rows_i2 = 2*rows_i;
-		const int cols_i2 = 2*cols_i;
-		const int i_1 = i-1;
+		const unsigned int nThreads = difodoNumThreads(num_threads,rows_i,cols_i);
 
 		if (i == 0)
 			depth[i].swap(depth_wf);
@@ -134,99 +747,8 @@ void CDifodo::buildCoordinatesPyramid()
 		//-----------------------------------------------------------------------------
 		else
 		{
-			for (unsigned int u = 0; u < cols_i; u++)
-			for (unsigned int v = 0; v < rows_i; v++)
-			{
-				const int u2 = 2*u;
-				const int v2 = 2*v;
-				const float dcenter = depth[i_1](v2,u2);
-
-				//Inner pixels
-				if ((v>0)&&(v<rows_i-1)&&(u>0)&&(u<cols_i-1))
-				{
-					if (dcenter > 0.f)
-					{
-						float sum = 0.f;
-						float weight = 0.f;
-
-						for (int l = -2; l<3; l++)
-						for (int k = -2; k<3; k++)
-						{
-							const float abs_dif = abs(depth[i_1](v2+k,u2+l)-dcenter);
-							if (abs_dif < max_depth_dif)
-							{
-								const float aux_w = g_mask[2+k][2+l]*(max_depth_dif - abs_dif);
-								weight += aux_w;
-								sum += aux_w*depth[i_1](v2+k,u2+l);
-							}
-						}
-						depth[i](v,u) = sum/weight;
-					}
-					else
-					{
-						float min_depth = 10.f;
-						for (int l = -2; l<3; l++)
-						for (int k = -2; k<3; k++)
-						{
-							const float d = depth[i_1](v2+k,u2+l);
-							if ((d > 0.f)&&(d < min_depth))
-								min_depth = d;
-						}
-
-						if (min_depth < 10.f)
-							depth[i](v,u) = min_depth;
-						else
-							depth[i](v,u) = 0.f;
-					}
-				}
-
-				//Boundary
-				else
-				{
-					if (dcenter > 0.f)
-					{
-						float sum = 0.f;
-						float weight = 0.f;
-
-						for (int l = -2; l<3; l++)
-						for (int k = -2; k<3; k++)
-						{
-							const int indv = v2+k,indu = u2+l;
-							if ((indv>=0)&&(indv<rows_i2)&&(indu>=0)&&(indu<cols_i2))
-							{
-								const float abs_dif = abs(depth[i_1](indv,indu)-dcenter);
-								if (abs_dif < max_depth_dif)
-								{
-									const float aux_w = g_mask[2+k][2+l]*(max_depth_dif - abs_dif);
-									weight += aux_w;
-									sum += aux_w*depth[i_1](indv,indu);
-								}
-							}
-						}
-						depth[i](v,u) = sum/weight;
-					}
-					else
-					{
-						float min_depth = 10.f;
-						for (int l = -2; l<3; l++)
-						for (int k = -2; k<3; k++)
-						{
-							const int indv = v2+k,indu = u2+l;
-							if ((indv>=0)&&(indv<rows_i2)&&(indu>=0)&&(indu<cols_i2))
-							{
-								const float d = depth[i_1](indv,indu);
-								if ((d > 0.f)&&(d < min_depth))
-									min_depth = d;
-							}
-						}
-
-						if (min_depth < 10.f)
-							depth[i](v,u) = min_depth;
-						else
-							depth[i](v,u) = 0.f;
-					}
-				}
-			}
+			TPyramidLevelBlock functor(depth[i-1],depth[i],g_mask,rows_i,cols_i);
+			mrpt::system::parallelForBlocks(cols_i,functor,nThreads);
 		}
 
 		//Calculate coordinates "xy" of the points
@@ -234,25 +756,13 @@ void CDifodo::buildCoordinatesPyramid()
 		const float disp_u_i = 0.5f*(cols_i-1);
 		const float disp_v_i = 0.5f*(rows_i-1);
 
-		for (unsigned int u = 0; u < cols_i; u++)
-		for (unsigned int v = 0; v < rows_i; v++)
-		if (depth[i](v,u) > 0.f)
-		{
-			xx[i](v,u) = (u - disp_u_i)*depth[i](v,u)*inv_f_i;
-			yy[i](v,u) = (v - disp_v_i)*depth[i](v,u)*inv_f_i;
-		}
-		else
-		{
-			xx[i](v,u) = 0.f;
-			yy[i](v,u) = 0.f;
-		}
+		TPointCoordsBlock coords(depth[i],xx[i],yy[i],inv_f_i,disp_u_i,disp_v_i);
+		mrpt::system::parallelForBlocks(cols_i,coords,nThreads);
 	}
 }
 
 void CDifodo::buildCoordinatesPyramidFast()
 {
-	const float max_depth_dif = 0.1f;
-	
 	//Push coordinates back
 	depth_old.swap(depth);
 	xx_old.swap(xx);
@@ -269,9 +779,7 @@ void CDifodo::buildCoordinatesPyramidFast()
 		unsigned int s = pow(2.f,int(i));
 		cols_i = width/s;
 		rows_i = height/s;
-		//const int rows_i2 = 2*rows_i;
-		//const int cols_i2 = 2*cols_i;
-		const int i_1 = i-1;
+		const unsigned int nThreads = difodoNumThreads(num_threads,rows_i,cols_i);
 
 		if (i == 0)
 			depth[i].swap(depth_wf);
@@ -280,84 +788,18 @@ void CDifodo::buildCoordinatesPyramidFast()
 		//-----------------------------------------------------------------------------
 		else
 		{
-			for (unsigned int u = 0; u < cols_i; u++)
-				for (unsigned int v = 0; v < rows_i; v++)
-				{
-					const int u2 = 2*u;
-					const int v2 = 2*v;
-					
-					//Inner pixels
-					if ((v>0)&&(v<rows_i-1)&&(u>0)&&(u<cols_i-1))
-					{
-						const Matrix4f d_block = depth[i_1].block<4,4>(v2-1,u2-1);
-						float depths[4] = {d_block(5),d_block(6),d_block(9),d_block(10)};
-						float dcenter;
-
-						//Sort the array (try to find a good/representative value)
-						for (signed char k = 2; k>=0; k--)
-						if (depths[k+1] < depths[k])
-							std::swap(depths[k+1],depths[k]);
-						for (unsigned char k = 1; k<3; k++)
-						if (depths[k] > depths[k+1])
-							std::swap(depths[k+1],depths[k]);
-						if (depths[2] < depths[1])
-							dcenter = depths[1];
-						else
-							dcenter = depths[2];
-						
-						if (dcenter > 0.f)
-						{	
-							float sum = 0.f;
-							float weight = 0.f;
-
-							for (unsigned char k = 0; k<16; k++)
-							{
-								const float abs_dif = abs(d_block(k) - dcenter);
-								if (abs_dif < max_depth_dif)
-								{
-									const float aux_w = f_mask(k)*(max_depth_dif - abs_dif);
-									weight += aux_w;
-									sum += aux_w*d_block(k);
-								}
-							}
-							depth[i](v,u) = sum/weight;
-						}
-						else
-							depth[i](v,u) = 0.f;
-
-                    }
-
-                    //Boundary
-					else
-					{
-						const Matrix2f d_block = depth[i_1].block<2,2>(v2,u2);
-						const float new_d = 0.25f*d_block.sumAll();
-						if (new_d < 0.4f)
-							depth[i](v,u) = 0.f;
-						else
-							depth[i](v,u) = new_d;
-					}
-				}
-        }
+			TPyramidLevelFastBlock functor(depth[i-1],depth[i],f_mask,rows_i,cols_i);
+			mrpt::system::parallelForBlocks(cols_i,functor,nThreads);
+		}
 
-        //Calculate coordinates "xy" of the points
+		//Calculate coordinates "xy" of the points
 		const float inv_f_i = 2.f*tan(0.5f*fovh)/float(cols_i);
-        const float disp_u_i = 0.5f*(cols_i-1);
-        const float disp_v_i = 0.5f*(rows_i-1);
+		const float disp_u_i = 0.5f*(cols_i-1);
+		const float disp_v_i = 0.5f*(rows_i-1);
 
-        for (unsigned int u = 0; u < cols_i; u++) 
-			for (unsigned int v = 0; v < rows_i; v++)
-                if (depth[i](v,u) > 0.f)
-				{
-					xx[i](v,u) = (u - disp_u_i)*depth[i](v,u)*inv_f_i;
-					yy[i](v,u) = (v - disp_v_i)*depth[i](v,u)*inv_f_i;
-				}
-				else
-				{
-					xx[i](v,u) = 0.f;
-					yy[i](v,u) = 0.f;
-				}
-    }
+		TPointCoordsBlock coords(depth[i],xx[i],yy[i],inv_f_i,disp_u_i,disp_v_i);
+		mrpt::system::parallelForBlocks(cols_i,coords,nThreads);
+	}
 }
 
 void CDifodo::performWarping()
@@ -365,10 +807,10 @@ void CDifodo::performWarping()
 	//Camera parameters (which also depend on the level resolution)
 	const float f = float(cols_i)/(2.f*tan(0.5f*fovh));
 	const float disp_u_i = 0.5f*float(cols_i-1);
-    const float disp_v_i = 0.5f*float(rows_i-1);
+	const float disp_v_i = 0.5f*float(rows_i-1);
 
 	//Rigid transformation estimated up to the present level
-	Matrix4f acu_trans; 
+	Matrix4f acu_trans;
 	acu_trans.setIdentity();
 	for (unsigned int i=1; i<=level; i++)
 		acu_trans = transformations[i-1]*acu_trans;
@@ -377,113 +819,35 @@ void CDifodo::performWarping()
 	wacu.assign(0.f);
 	depth_warped[image_level].assign(0.f);
 
-	const float cols_lim = float(cols_i-1);
-	const float rows_lim = float(rows_i-1);
+	const unsigned int nThreads = difodoNumThreads(num_threads,rows_i,cols_i);
 
 	//						Warping loop
 	//---------------------------------------------------------
-	for (unsigned int j = 0; j<cols_i; j++)
-		for (unsigned int i = 0; i<rows_i; i++)
-		{		
-			const float z = depth[image_level](i,j);
-			
-			if (z > 0.f)
-			{
-				//Transform point to the warped reference frame
-				const float depth_w = acu_trans(0,0)*z + acu_trans(0,1)*xx[image_level](i,j) + acu_trans(0,2)*yy[image_level](i,j) + acu_trans(0,3);
-				const float x_w = acu_trans(1,0)*z + acu_trans(1,1)*xx[image_level](i,j) + acu_trans(1,2)*yy[image_level](i,j) + acu_trans(1,3);
-				const float y_w = acu_trans(2,0)*z + acu_trans(2,1)*xx[image_level](i,j) + acu_trans(2,2)*yy[image_level](i,j) + acu_trans(2,3);
-
-				//Calculate warping
-				const float uwarp = f*x_w/depth_w + disp_u_i;
-				const float vwarp = f*y_w/depth_w + disp_v_i;
-
-				//The warped pixel (which is not integer in general) contributes to all the surrounding ones
-				if (( uwarp >= 0.f)&&( uwarp < cols_lim)&&( vwarp >= 0.f)&&( vwarp < rows_lim))
-				{
-					const int uwarp_l = uwarp;
-					const int uwarp_r = uwarp_l + 1;
-					const int vwarp_d = vwarp;
-					const int vwarp_u = vwarp_d + 1;
-					const float delta_r = float(uwarp_r) - uwarp;
-					const float delta_l = uwarp - float(uwarp_l);
-					const float delta_u = float(vwarp_u) - vwarp;
-					const float delta_d = vwarp - float(vwarp_d);
-
-					//Warped pixel very close to an integer value
-					if (abs(round(uwarp) - uwarp) + abs(round(vwarp) - vwarp) < 0.05f)
-					{
-						depth_warped[image_level](round(vwarp), round(uwarp)) += depth_w;
-						wacu(round(vwarp), round(uwarp)) += 1.f;
-					}
-					else
-					{
-						const float w_ur = square(delta_l) + square(delta_d);
-						depth_warped[image_level](vwarp_u,uwarp_r) += w_ur*depth_w;
-						wacu(vwarp_u,uwarp_r) += w_ur;
-
-						const float w_ul = square(delta_r) + square(delta_d);
-						depth_warped[image_level](vwarp_u,uwarp_l) += w_ul*depth_w;
-						wacu(vwarp_u,uwarp_l) += w_ul;
-
-						const float w_dr = square(delta_l) + square(delta_u);
-						depth_warped[image_level](vwarp_d,uwarp_r) += w_dr*depth_w;
-						wacu(vwarp_d,uwarp_r) += w_dr;
-
-						const float w_dl = square(delta_r) + square(delta_u);
-						depth_warped[image_level](vwarp_d,uwarp_l) += w_dl*depth_w;
-						wacu(vwarp_d,uwarp_l) += w_dl;
-					}
-				}
-			}
-		}
+	TWarpingBlock warping(depth[image_level],xx[image_level],yy[image_level],acu_trans,f,disp_u_i,disp_v_i,depth_warped[image_level],wacu,nThreads);
+	const unsigned int nBlocks = mrpt::system::parallelForBlocks(cols_i,warping,nThreads);
+	for (unsigned int b=1; b<nBlocks; b++)
+	{
+		depth_warped[image_level] += warping.block_depth[b];
+		wacu += warping.block_wacu[b];
+	}
 
 	//Scale the averaged depth and compute spatial coordinates
-    const float inv_f_i = 1.f/f;
-	for (unsigned int u = 0; u<cols_i; u++)
-		for (unsigned int v = 0; v<rows_i; v++)
-		{	
-			if (wacu(v,u) > 0.f)
-			{
-				depth_warped[image_level](v,u) /= wacu(v,u);
-				xx_warped[image_level](v,u) = (u - disp_u_i)*depth_warped[image_level](v,u)*inv_f_i;
-				yy_warped[image_level](v,u) = (v - disp_v_i)*depth_warped[image_level](v,u)*inv_f_i;
-			}
-			else
-			{
-				depth_warped[image_level](v,u) = 0.f;
-				xx_warped[image_level](v,u) = 0.f;
-				yy_warped[image_level](v,u) = 0.f;
-			}
-		}
+	TWarpedCoordsBlock coords(depth_warped[image_level],xx_warped[image_level],yy_warped[image_level],wacu,1.f/f,disp_u_i,disp_v_i);
+	mrpt::system::parallelForBlocks(cols_i,coords,nThreads);
 }
 
 void CDifodo::calculateCoord()
-{	
+{
 	null.resize(rows_i, cols_i);
-	null.assign(false);
 	num_valid_points = 0;
-	
-	for (unsigned int u = 0; u < cols_i; u++)
-		for (unsigned int v = 0; v < rows_i; v++)
-		{
-			if ((depth_old[image_level](v,u)) == 0.f || (depth_warped[image_level](v,u) == 0.f))
-			{
-				depth_inter[image_level](v,u) = 0.f;
-				xx_inter[image_level](v,u) = 0.f;
-				yy_inter[image_level](v,u) = 0.f;
-				null(v, u) = true;
-			}
-			else
-			{
-				depth_inter[image_level](v,u) = 0.5f*(depth_old[image_level](v,u) + depth_warped[image_level](v,u));
-				xx_inter[image_level](v,u) = 0.5f*(xx_old[image_level](v,u) + xx_warped[image_level](v,u));
-				yy_inter[image_level](v,u) = 0.5f*(yy_old[image_level](v,u) + yy_warped[image_level](v,u));
-				null(v, u) = false;
-				if ((u>0)&&(v>0)&&(u<cols_i-1)&&(v<rows_i-1))
-					num_valid_points++;
-			}
-		}
+
+	const unsigned int nThreads = difodoNumThreads(num_threads,rows_i,cols_i);
+	TInterCoordsBlock functor(depth_old[image_level],xx_old[image_level],yy_old[image_level],
+		depth_warped[image_level],xx_warped[image_level],yy_warped[image_level],
+		depth_inter[image_level],xx_inter[image_level],yy_inter[image_level],null,nThreads);
+	const unsigned int nBlocks = mrpt::system::parallelForBlocks(cols_i,functor,nThreads);
+	for (unsigned int b=0; b<nBlocks; b++)
+		num_valid_points += functor.block_num_valid[b];
 }
 
 void CDifodo::calculateDepthDerivatives()
@@ -492,54 +856,22 @@ void CDifodo::calculateDepthDerivatives()
 	du.resize(rows_i,cols_i); du.assign(0.f);
 	dv.resize(rows_i,cols_i); dv.assign(0.f);
 
-    //Compute connectivity
+	const unsigned int nThreads = difodoNumThreads(num_threads,rows_i,cols_i);
+
+	//Compute connectivity
 	MatrixXf rx_ninv(rows_i,cols_i);
 	MatrixXf ry_ninv(rows_i,cols_i);
-    rx_ninv.assign(1.f); ry_ninv.assign(1.f);
+	rx_ninv.assign(1.f); ry_ninv.assign(1.f);
 
-	for (unsigned int u = 0; u < cols_i-1; u++)
-        for (unsigned int v = 0; v < rows_i; v++)
-			if (null(v,u) == false)
-			{
-				rx_ninv(v,u) = sqrtf(square(xx_inter[image_level](v,u+1) - xx_inter[image_level](v,u))
-									+ square(depth_inter[image_level](v,u+1) - depth_inter[image_level](v,u)));
-			}
+	TConnectivityBlock connectivity(depth_inter[image_level],xx_inter[image_level],yy_inter[image_level],null,rx_ninv,ry_ninv);
+	mrpt::system::parallelForBlocks(cols_i,connectivity,nThreads);
 
-	for (unsigned int u = 0; u < cols_i; u++)
-        for (unsigned int v = 0; v < rows_i-1; v++)
-			if (null(v,u) == false)
-			{
-				ry_ninv(v,u) = sqrtf(square(yy_inter[image_level](v+1,u) - yy_inter[image_level](v,u))
-									+ square(depth_inter[image_level](v+1,u) - depth_inter[image_level](v,u)));
-			}
-
-
-    //Spatial derivatives
-    for (unsigned int v = 0; v < rows_i; v++)
-    {
-        for (unsigned int u = 1; u < cols_i-1; u++)
-			if (null(v,u) == false)
-				du(v,u) = (rx_ninv(v,u-1)*(depth_inter[image_level](v,u+1)-depth_inter[image_level](v,u)) + rx_ninv(v,u)*(depth_inter[image_level](v,u) - depth_inter[image_level](v,u-1)))/(rx_ninv(v,u)+rx_ninv(v,u-1));
-
-		du(v,0) = du(v,1);
-		du(v,cols_i-1) = du(v,cols_i-2);
-    }
+	//Spatial and temporal derivatives
+	TDerivativesBlock derivatives(depth_inter[image_level],depth_warped[image_level],depth_old[image_level],null,rx_ninv,ry_ninv,du,dv,dt,fps);
+	mrpt::system::parallelForBlocks(cols_i,derivatives,nThreads);
 
-    for (unsigned int u = 0; u < cols_i; u++)
-    {
-        for (unsigned int v = 1; v < rows_i-1; v++)
-			if (null(v,u) == false)
-				dv(v,u) = (ry_ninv(v-1,u)*(depth_inter[image_level](v+1,u)-depth_inter[image_level](v,u)) + ry_ninv(v,u)*(depth_inter[image_level](v,u) - depth_inter[image_level](v-1,u)))/(ry_ninv(v,u)+ry_ninv(v-1,u));
-
-		dv(0,u) = dv(1,u);
-		dv(rows_i-1,u) = dv(rows_i-2,u);
-    }
-
-	//Temporal derivative
-	for (unsigned int u = 0; u < cols_i; u++)
-		for (unsigned int v = 0; v < rows_i; v++)
-			if (null(v,u) == false)
-				dt(v,u) = fps*(depth_warped[image_level](v,u) - depth_old[image_level](v,u));
+	du.col(0) = du.col(1);
+	du.col(cols_i-1) = du.col(cols_i-2);
 }
 
 void CDifodo::computeWeights()
@@ -561,75 +893,12 @@ void CDifodo::computeWeights()
 	CArrayDouble<6> kai_level_acu = aux.ln()*fps;
 	kai_level -= kai_level_acu.cast<float>();
 
-	//Parameters for the measurement error
 	const float f_inv = float(cols_i)/(2.f*tan(0.5f*fovh));
-	const float kz2 = 8.122e-12f;  //square(1.425e-5) / 25
-	
-	//Parameters for linearization error
-	const float kduv = 20e-5f;
-	const float kdt = kduv/square(fps);
-	const float k2dt = 5e-6f;
-	const float k2duv = 5e-6f;
-	
-	for (unsigned int u = 1; u < cols_i-1; u++)
-		for (unsigned int v = 1; v < rows_i-1; v++)
-			if (null(v,u) == false)
-			{
-				//					Compute measurment error (simplified)
-				//-----------------------------------------------------------------------
-				const float z = depth_inter[image_level](v,u);
-				const float inv_d = 1.f/z;
-				//const float dycomp = du2(v,u)*f_inv_y*inv_d;
-				//const float dzcomp = dv2(v,u)*f_inv_z*inv_d;
-				const float z2 = z*z;
-				const float z4 = z2*z2;
-
-				//const float var11 = kz2*z4;
-				//const float var12 = kz2*xx_inter[image_level](v,u)*z2*depth_inter[image_level](v,u);
-				//const float var13 = kz2*yy_inter[image_level](v,u)*z2*depth_inter[image_level](v,u);
-				//const float var22 = kz2*square(xx_inter[image_level](v,u))*z2;
-				//const float var23 = kz2*xx_inter[image_level](v,u)*yy_inter[image_level](v,u)*z2;
-				//const float var33 = kz2*square(yy_inter[image_level](v,u))*z2;
-				const float var44 = kz2*z4*square(fps);
-				const float var55 = kz2*z4*0.25f;
-				const float var66 = var55;
-
-				//const float j1 = -2.f*inv_d*inv_d*(xx_inter[image_level](v,u)*dycomp + yy_inter[image_level](v,u)*dzcomp)*(kai_level[0] + yy_inter[image_level](v,u)*kai_level[4] - xx_inter[image_level](v,u)*kai_level[5])
-				//				+ inv_d*dycomp*(kai_level[1] - yy_inter[image_level](v,u)*kai_level[3]) + inv_d*dzcomp*(kai_level[2] + xx_inter[image_level](v,u)*kai_level[3]);
-				//const float j2 = inv_d*dycomp*(kai_level[0] + yy_inter[image_level](v,u)*kai_level[4] - 2.f*xx_inter[image_level](v,u)*kai_level[5]) - dzcomp*kai_level[3];
-				//const float j3 = inv_d*dzcomp*(kai_level[0] + 2.f*yy_inter[image_level](v,u)*kai_level[4] - xx_inter[image_level](v,u)*kai_level[5]) + dycomp*kai_level[3];
-
-				const float j4 = 1.f;
-				const float j5 =  xx_inter[image_level](v,u)*inv_d*inv_d*f_inv*(kai_level[0] + yy_inter[image_level](v,u)*kai_level[4] - xx_inter[image_level](v,u)*kai_level[5]) 
-							   + inv_d*f_inv*(-kai_level[1] - z*kai_level[5] + yy_inter[image_level](v,u)*kai_level[3]);
-				const float j6 = yy_inter[image_level](v,u)*inv_d*inv_d*f_inv*(kai_level[0] + yy_inter[image_level](v,u)*kai_level[4] - xx_inter[image_level](v,u)*kai_level[5])
-							   + inv_d*f_inv*(-kai_level[2] + z*kai_level[4] - xx_inter[image_level](v,u)*kai_level[3]);
-
-				//error_measurement(v,u) = j1*(j1*var11+j2*var12+j3*var13) + j2*(j1*var12+j2*var22+j3*var23)
-				//						+j3*(j1*var13+j2*var23+j3*var33) + j4*j4*var44 + j5*j5*var55 + j6*j6*var66;
-
-				const float error_m = j4*j4*var44 + j5*j5*var55 + j6*j6*var66;
-
-				
-				//					Compute linearization error
-				//-----------------------------------------------------------------------
-				const float ini_du = depth_old[image_level](v,u+1) - depth_old[image_level](v,u-1);
-				const float ini_dv = depth_old[image_level](v+1,u) - depth_old[image_level](v-1,u);
-				const float final_du = depth_warped[image_level](v,u+1) - depth_warped[image_level](v,u-1);
-				const float final_dv = depth_warped[image_level](v+1,u) - depth_warped[image_level](v-1,u);
-
-				const float dut = ini_du - final_du;
-				const float dvt = ini_dv - final_dv;
-				const float duu = du(v,u+1) - du(v,u-1);
-				const float dvv = dv(v+1,u) - dv(v-1,u);
-				const float dvu = dv(v,u+1) - dv(v,u-1); //Completely equivalent to compute duv
-
-				const float error_l = kdt*square(dt(v,u)) + kduv*(square(du(v,u)) + square(dv(v,u))) + k2dt*(square(dut) + square(dvt))
-											+ k2duv*(square(duu) + square(dvv) + square(dvu));
-
-				//Weight
-				weights(v,u) = sqrt(1.f/(error_m + error_l));
-			}
+
+	TWeightsBlock functor(depth_inter[image_level],xx_inter[image_level],yy_inter[image_level],depth_old[image_level],depth_warped[image_level],
+		du,dv,dt,null,kai_level,f_inv,fps,weights);
+	const unsigned int nThreads = difodoNumThreads(num_threads,rows_i,cols_i);
+	mrpt::system::parallelForBlocks(cols_i-2,functor,nThreads);
 
 	//Normalize weights in the range [0,1]
 	const float inv_max = 1.f/weights.maximum();
@@ -638,80 +907,64 @@ void CDifodo::computeWeights()
 
 void CDifodo::solveOneLevel()
 {
-	MatrixXf A(num_valid_points,6);
-	MatrixXf B(num_valid_points,1);
-	unsigned int cont = 0;
-
-	//Fill the matrix A and the vector B
+	//Build the normal equations of the weighted least squares problem, without building the matrix A explicitly.
 	//The order of the unknowns is (vz, vx, vy, wz, wx, wy)
-	//The points order will be (1,1), (1,2)...(1,cols-1), (2,1), (2,2)...(row-1,cols-1).
-
 	const float f_inv = float(cols_i)/(2.f*tan(0.5f*fovh));
+	const unsigned int nThreads = difodoNumThreads(num_threads,rows_i,cols_i);
 
-	for (unsigned int u = 1; u < cols_i-1; u++)
-		for (unsigned int v = 1; v < rows_i-1; v++)
-			if (null(v,u) == false)
-			{
-				// Precomputed expressions
-				const float d = depth_inter[image_level](v,u);
-				const float inv_d = 1.f/d;
-				const float x = xx_inter[image_level](v,u);
-				const float y = yy_inter[image_level](v,u);
-				const float dycomp = du(v,u)*f_inv*inv_d;
-				const float dzcomp = dv(v,u)*f_inv*inv_d;
-				const float tw = weights(v,u);
-
-				//Fill the matrix A
-				A(cont, 0) = tw*(1.f + dycomp*x*inv_d + dzcomp*y*inv_d);
-				A(cont, 1) = tw*(-dycomp);
-				A(cont, 2) = tw*(-dzcomp);
-				A(cont, 3) = tw*(dycomp*y - dzcomp*x);
-				A(cont, 4) = tw*(y + dycomp*inv_d*y*x + dzcomp*(y*y*inv_d + d));
-				A(cont, 5) = tw*(-x - dycomp*(x*x*inv_d + d) - dzcomp*inv_d*y*x);
-				B(cont,0) = tw*(-dt(v,u));
-
-				cont++;
-			}
-	
-	//Solve the linear system of equations using weighted least squares
-	MatrixXf AtA, AtB;
-	AtA.multiply_AtA(A);
-	AtB.multiply_AtB(A,B);
-	MatrixXf Var = AtA.ldlt().solve(AtB);
-
-	//Covariance matrix calculation 
-	MatrixXf res = -B;
-	for (unsigned int k = 0; k<6; k++)
-		res += Var(k)*A.col(k);
+	TNormalEquationsBlock functor(depth_inter[image_level],xx_inter[image_level],yy_inter[image_level],du,dv,dt,weights,null,f_inv,nThreads);
+	const unsigned int nBlocks = mrpt::system::parallelForBlocks(cols_i-2,functor,nThreads);
 
-	est_cov = (1.f/float(num_valid_points-6))*AtA.inverse()*res.squaredNorm();
+	Matrix<double,6,6> AtA_d = Matrix<double,6,6>::Zero();
+	Matrix<double,6,1> AtB_d = Matrix<double,6,1>::Zero();
+	for (unsigned int b=0; b<nBlocks; b++)
+	{
+		AtA_d += functor.block_AtA[b];
+		AtB_d += functor.block_AtB[b];
+	}
+	AtA_d.triangularView<StrictlyUpper>() = AtA_d.transpose();
 
-	//Update last velocity in local coordinates
-	kai_loc_level = Var;
+	//Solve the linear system of equations using weighted least squares
+	const Matrix<float,6,6> AtA = AtA_d.cast<float>();
+	const Matrix<float,6,1> AtB = AtB_d.cast<float>();
+	kai_loc_level = AtA.ldlt().solve(AtB);
+
+	//Covariance matrix calculation
+	functor.solution = &kai_loc_level;
+	mrpt::system::parallelForBlocks(cols_i-2,functor,nThreads);
+	double res2 = 0;
+	for (unsigned int b=0; b<nBlocks; b++)
+		res2 += functor.block_res2[b];
+
+	est_cov = (1.f/float(num_valid_points-6))*AtA.inverse()*float(res2);
 }
 
 void CDifodo::odometryCalculation()
 {
 	//Clock to measure the runtime
-	utils::CTicTac clock;
+	utils::CTicTac clock, stage_clock;
 	clock.Tic();
+	stage_times = TStageTimes();
 
 	//Build the gaussian pyramid
+	stage_clock.Tic();
 	if (fast_pyramid)	buildCoordinatesPyramidFast();
 	else				buildCoordinatesPyramid();
+	stage_times.pyramid = 1000.f*stage_clock.Tac();
 
 	//Coarse-to-fines scheme
-    for (unsigned int i=0; i<ctf_levels; i++)
-    {
+	for (unsigned int i=0; i<ctf_levels; i++)
+	{
 		//Previous computations
 		transformations[i].setIdentity();
 
 		level = i;
 		unsigned int s = pow(2.f,int(ctf_levels-(i+1)));
-        cols_i = cols/s; rows_i = rows/s;
-        image_level = ctf_levels - i + round(log(float(width/cols))/log(2.f)) - 1;
+		cols_i = cols/s; rows_i = rows/s;
+		image_level = ctf_levels - i + round(log(float(width/cols))/log(2.f)) - 1;
 
 		//1. Perform warping
+		stage_clock.Tic();
 		if (i == 0)
 		{
 			depth_warped[image_level] = depth[image_level];
@@ -720,29 +973,42 @@ void CDifodo::odometryCalculation()
 		}
 		else
 			performWarping();
+		stage_times.warping += 1000.f*stage_clock.Tac();
 
 		//2. Calculate inter coords and find null measurements
+		stage_clock.Tic();
 		calculateCoord();
+		stage_times.coordinates += 1000.f*stage_clock.Tac();
 
 		//3. Compute derivatives
+		stage_clock.Tic();
 		calculateDepthDerivatives();
+		stage_times.derivatives += 1000.f*stage_clock.Tac();
 
 		//4. Compute weights
+		stage_clock.Tic();
 		computeWeights();
+		stage_times.weights += 1000.f*stage_clock.Tac();
 
 		//5. Solve odometry
+		stage_clock.Tic();
 		if (num_valid_points > 6)
 			solveOneLevel();
+		stage_times.solver += 1000.f*stage_clock.Tac();
 
 		//6. Filter solution
+		stage_clock.Tic();
 		filterLevelSolution();
+		stage_times.filter += 1000.f*stage_clock.Tac();
 	}
 
 	//Update poses
+	stage_clock.Tic();
 	poseUpdate();
+	stage_times.filter += 1000.f*stage_clock.Tac();
 
 	//Save runtime
-	execution_time = 1000.f*clock.Tac();   
+	execution_time = 1000.f*clock.Tac();
 }
 
 void CDifodo::filterLevelSolution()
@@ -0,0 +1,221 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/CDifodo.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/utils/round.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::utils;
+using namespace std;
+
+namespace
+{
+	// An axis-aligned box, given by its two opposite corners
+	struct TBox
+	{
+		double min[3], max[3];
+	};
+
+	// Distance along the ray "p + t*d" to the box, or 0 if it is not hit
+	double ray_box_distance(const double p[3], const double d[3], const TBox &b)
+	{
+		double t_in = 0, t_out = 1e10;
+		for (int k=0;k<3;k++)
+		{
+			if (std::abs(d[k])<1e-12)
+			{
+				if (p[k]<b.min[k] || p[k]>b.max[k]) return 0;
+				continue;
+			}
+			double t1 = (b.min[k]-p[k])/d[k], t2 = (b.max[k]-p[k])/d[k];
+			if (t1>t2) std::swap(t1,t2);
+			t_in = std::max(t_in,t1);
+			t_out = std::min(t_out,t2);
+		}
+		return t_in>0 && t_in<t_out ? t_in : 0;
+	}
+
+	// Range flow odometry on depth images ray-casted from a synthetic scene: a room with two boxes on the floor.
+	class CDifodoSynthetic : public CDifodo
+	{
+	public:
+		CDifodoSynthetic(unsigned int nThreads, bool fast)
+		{
+			num_threads = nThreads;
+			fast_pyramid = fast;
+			cam_mode = 1;
+			downsample = 2;
+			rows = 120;
+			cols = 160;
+			ctf_levels = 3;
+			width = 640/(cam_mode*downsample);
+			height = 480/(cam_mode*downsample);
+
+			// Resize the pyramid for this resolution, as CDifodoDatasets::loadConfiguration() does:
+			const unsigned int pyr_levels = mrpt::utils::round(log(float(width/cols))/log(2.f)) + ctf_levels;
+			depth.resize(pyr_levels);
+			depth_old.resize(pyr_levels);
+			depth_inter.resize(pyr_levels);
+			depth_warped.resize(pyr_levels);
+			xx.resize(pyr_levels);
+			xx_inter.resize(pyr_levels);
+			xx_old.resize(pyr_levels);
+			xx_warped.resize(pyr_levels);
+			yy.resize(pyr_levels);
+			yy_inter.resize(pyr_levels);
+			yy_old.resize(pyr_levels);
+			yy_warped.resize(pyr_levels);
+			transformations.resize(pyr_levels);
+			for (unsigned int i = 0; i<pyr_levels; i++)
+			{
+				const unsigned int s = 1<<i;
+				cols_i = width/s; rows_i = height/s;
+				depth[i].setZero(rows_i, cols_i);
+				depth_inter[i].resize(rows_i, cols_i);
+				depth_old[i].setZero(rows_i, cols_i);
+				xx[i].setZero(rows_i, cols_i);
+				xx_inter[i].resize(rows_i, cols_i);
+				xx_old[i].setZero(rows_i, cols_i);
+				yy[i].setZero(rows_i, cols_i);
+				yy_inter[i].resize(rows_i, cols_i);
+				yy_old[i].setZero(rows_i, cols_i);
+				transformations[i].resize(4,4);
+				if (cols_i <= cols)
+				{
+					depth_warped[i].resize(rows_i,cols_i);
+					xx_warped[i].resize(rows_i,cols_i);
+					yy_warped[i].resize(rows_i,cols_i);
+				}
+			}
+			depth_wf.setSize(height,width);
+		}
+
+		// Renders the depth image seen from "camera_pose" (+X forward, with the same projection as CDifodo)
+		void renderFrom(const CPose3D &camera_pose)
+		{
+			TBox room  = { {-1.0,-2.0,-1.0}, {4.0,2.0,1.5} };
+			TBox boxes[2] = { { {1.5,-0.8,-1.0}, {2.0,-0.2,-0.4} }, { {2.2,0.3,-1.0}, {2.6,0.9,0.2} } };
+
+			const float inv_f = 2.f*tan(0.5f*fovh)/float(width);
+			const float disp_u = 0.5f*(width-1), disp_v = 0.5f*(height-1);
+			CMatrixDouble33 R;
+			camera_pose.getRotationMatrix(R);
+			const double p[3] = { camera_pose.x(), camera_pose.y(), camera_pose.z() };
+			for (unsigned int u=0;u<width;u++)
+				for (unsigned int v=0;v<height;v++)
+				{
+					const double d_cam[3] = { 1.0, (u-disp_u)*inv_f, (v-disp_v)*inv_f };
+					double d[3];
+					for (int k=0;k<3;k++) d[k] = R(k,0)*d_cam[0]+R(k,1)*d_cam[1]+R(k,2)*d_cam[2];
+
+					// The walls of the room are hit from the inside:
+					double t = 1e10;
+					for (int k=0;k<3;k++)
+					{
+						if (d[k]>0) t = std::min(t,(room.max[k]-p[k])/d[k]);
+						if (d[k]<0) t = std::min(t,(room.min[k]-p[k])/d[k]);
+					}
+					for (int b=0;b<2;b++)
+					{
+						const double tb = ray_box_distance(p,d,boxes[b]);
+						if (tb>0) t = std::min(t,tb);
+					}
+					depth_wf(v,u) = t<4.5 ? float(t) : 0.f;  // "t" is also the depth, since d_cam[0]=1
+				}
+		}
+
+		void loadFrame() {}  // Frames are given with renderFrom()
+
+		// Builds the pyramid of the first frame, as CDifodoDatasets::reset() does:
+		void reset(const CPose3D &camera_pose)
+		{
+			renderFrom(camera_pose);
+			if (fast_pyramid)	buildCoordinatesPyramidFast();
+			else				buildCoordinatesPyramid();
+			cam_pose = CPose3D();
+			cam_oldpose = cam_pose;
+		}
+
+		void processFrame(const CPose3D &camera_pose)
+		{
+			renderFrom(camera_pose);
+			odometryCalculation();
+		}
+	};
+
+	const size_t NUM_FRAMES = 4;
+
+	// The camera moves forward and to the left while turning (the true pose of each frame w.r.t. the first one):
+	CPose3D true_pose(size_t i)
+	{
+		return CPose3D(0.02*i,0.01*i,-0.005*i, DEG2RAD(0.8)*i,DEG2RAD(0.3)*i,DEG2RAD(-0.2)*i);
+	}
+
+	// Poses estimated by the former single-threaded implementation (which filled the full N x 6 matrix
+	//  of the solver), for both pyramids: (x,y,z,yaw,pitch,roll)
+	const double OLD_POSES[2][NUM_FRAMES][6] = {
+		{	// buildCoordinatesPyramid()
+			{0.0197409596,0.00880714506,-0.00143265922, 0.016509432,0.00610426557,-0.00252149098},
+			{0.0401736891,0.0180811599,-0.00414100889, 0.0300020026,0.0123418533,-0.00589784285},
+			{0.0602871928,0.0283595397,-0.00738909266, 0.0439028407,0.0180027924,-0.00895059493},
+			{0.0805356,0.0384264034,-0.00984674502, 0.0575174814,0.0237832711,-0.0104764794} },
+		{	// buildCoordinatesPyramidFast()
+			{0.0204198528,0.0084125679,-0.0008937784, 0.0137128201,0.00687215592,-0.00190073157},
+			{0.0404603092,0.0181841077,-0.00414909843, 0.0280000932,0.0125306032,-0.00443598283},
+			{0.0607147556,0.0286453752,-0.00782446426, 0.0413412576,0.0181372583,-0.0076313221},
+			{0.0809696906,0.0376802521,-0.0100199796, 0.055412637,0.0242313245,-0.00969339245} }
+	};
+
+	void run_difodo(unsigned int num_threads, bool fast_pyramid, std::vector<CPose3D> &poses)
+	{
+		CDifodoSynthetic odo(num_threads,fast_pyramid);
+		odo.reset(true_pose(0));
+		poses.clear();
+		for (size_t i=1;i<=NUM_FRAMES;i++)
+		{
+			odo.processFrame(true_pose(i));
+			poses.push_back(odo.cam_pose);
+		}
+	}
+
+	void test_same_as_old_estimate(bool fast_pyramid)
+	{
+		const unsigned int nThreads[2] = {1,4};
+		for (int t=0;t<2;t++)
+		{
+			std::vector<CPose3D> poses;
+			run_difodo(nThreads[t],fast_pyramid,poses);
+			ASSERT_EQ(poses.size(),NUM_FRAMES);
+			for (size_t i=0;i<NUM_FRAMES;i++)
+			{
+				// Only the order of the floating point additions changed:
+				for (int k=0;k<6;k++)
+					EXPECT_NEAR(poses[i][k], OLD_POSES[fast_pyramid ? 1:0][i][k], 1e-5) << "num_threads=" << nThreads[t] << " frame=" << i+1 << " k=" << k;
+
+				// And the estimate follows the true motion:
+				EXPECT_LT(poses[i].distanceTo(true_pose(i+1)), 0.02) << "num_threads=" << nThreads[t] << " frame=" << i+1;
+			}
+		}
+	}
+}
+
+TEST(CDifodo, SameAsOldEstimate)
+{
+	test_same_as_old_estimate(false);
+}
+
+TEST(CDifodo, SameAsOldEstimateFastPyramid)
+{
+	test_same_as_old_estimate(true);
+}
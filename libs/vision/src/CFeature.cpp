@@ -846,6 +846,70 @@ void CFeature::saveToTextFile( const std::string &filename, bool APPEND )
 	MRPT_END
 } // end saveToTextFile
 
+/****************************************************
+			   Struct TFeatureListColumns
+*****************************************************/
+TFeatureListColumns::TFeatureListColumns() : SIFT_len(0), SURF_len(0), ORB_len(0)
+{
+}
+
+TFeatureListColumns::TFeatureListColumns(const CFeatureList &feats) : SIFT_len(0), SURF_len(0), ORB_len(0)
+{
+	buildFrom(feats);
+}
+
+void TFeatureListColumns::clear()
+{
+	x.clear(); y.clear(); response.clear();
+	SIFT.clear(); SURF.clear(); ORB.clear();
+	SIFT_len = SURF_len = ORB_len = 0;
+}
+
+namespace
+{
+	// Returns the common length of one kind of descriptor in all the features, or 0 if any feature lacks it or lengths differ.
+	template <class DESCRIPTOR_GETTER>
+	size_t commonDescriptorLength(const CFeatureList &feats, const DESCRIPTOR_GETTER &getter)
+	{
+		if (feats.empty()) return 0;
+		const size_t len = getter(*feats[0]).size();
+		for (size_t i=1;i<feats.size() && len;i++)
+			if (getter(*feats[i]).size()!=len)
+				return 0;
+		return len;
+	}
+
+	template <class COLUMN, class DESCRIPTOR_GETTER>
+	void buildDescriptorColumn(const CFeatureList &feats, const DESCRIPTOR_GETTER &getter, COLUMN &col, size_t &len)
+	{
+		len = commonDescriptorLength(feats,getter);
+		col.resize(feats.size()*len);
+		if (!len) return;
+		for (size_t i=0;i<feats.size();i++)
+			std::copy(getter(*feats[i]).begin(), getter(*feats[i]).end(), col.begin()+i*len);
+	}
+
+	struct TGetSIFT { const std::vector<uint8_t> & operator()(const CFeature &f) const { return f.descriptors.SIFT; } };
+	struct TGetSURF { const std::vector<float>   & operator()(const CFeature &f) const { return f.descriptors.SURF; } };
+	struct TGetORB  { const std::vector<uint8_t> & operator()(const CFeature &f) const { return f.descriptors.ORB; } };
+}
+
+void TFeatureListColumns::buildFrom(const CFeatureList &feats)
+{
+	const size_t N = feats.size();
+	x.resize(N); y.resize(N); response.resize(N);
+	for (size_t i=0;i<N;i++)
+	{
+		const CFeature &f = *feats[i];
+		x[i] = f.x;
+		y[i] = f.y;
+		response[i] = f.response;
+	}
+	buildDescriptorColumn(feats,TGetSIFT(),SIFT,SIFT_len);
+	buildDescriptorColumn(feats,TGetSURF(),SURF,SURF_len);
+	buildDescriptorColumn(feats,TGetORB(),ORB,ORB_len);
+}
+
 /****************************************************
 			   Class CFEATURELIST
 *****************************************************/
@@ -10,6 +10,7 @@
 #include "vision-precomp.h"   // Precompiled headers
 
 #include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/system/threads.h>
 
 // Universal include for all versions of OpenCV
 #include <mrpt/otherlibs/do_opencv_includes.h> 
@@ -64,6 +65,216 @@ void CFeatureExtraction::detectFeatures_SSE2_FASTER12(const CImage &img, TSimple
 #endif
 }
 
+// ------------  Tiled, multithreaded FASTER -------------
+#if MRPT_HAS_OPENCV
+namespace
+{
+	/** One tile of one octave, and the corners found in it */
+	struct TDetectionTile
+	{
+		const CImage *img;
+		uint8_t octave;
+		int x0,y0,x1,y1; //!< The tile covers [x0,x1)x[y0,y1), in the coordinates of its octave
+		TSimpleFeatureList corners;
+	};
+
+	void fast_corner_detect_N(const int N_fast, const IplImage *I, TSimpleFeatureList &corners, int threshold)
+	{
+		switch (N_fast)
+		{
+		case 9:  fast_corner_detect_9 (I,corners,threshold,0,NULL); break;
+		case 10: fast_corner_detect_10(I,corners,threshold,0,NULL); break;
+		case 12: fast_corner_detect_12(I,corners,threshold,0,NULL); break;
+		default:
+			THROW_EXCEPTION("Only the 9,10,12 FASTER detectors are implemented.")
+		};
+	}
+
+	/** Detection, scoring, non-maximal suppression and selection of the best corners in each tile */
+	struct TDetectTilesBlock
+	{
+		const int N_fast;
+		const CFeatureExtraction::TOptions::TFASTOptions &opts;
+		const unsigned int max_features_per_tile;
+		std::vector<TDetectionTile> &tiles;
+
+		TDetectTilesBlock(int N, const CFeatureExtraction::TOptions::TFASTOptions &o, unsigned int max_per_tile, std::vector<TDetectionTile> &t) :
+			N_fast(N), opts(o), max_features_per_tile(max_per_tile), tiles(t)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			for (size_t i=first;i<last;i++)
+				processTile(tiles[i]);
+		}
+
+		void processTile(TDetectionTile &tile) const
+		{
+			// FAST needs a border of 3 pixels around each tested pixel, so the detector is run on a
+			// view of the tile enlarged with (up to) 3 pixels at each side, without copying the pixels:
+			const IplImage *IPL = tile.img->getAs<IplImage>();
+			const int BORDER = 3;
+			const int vx0 = std::max(0,tile.x0-BORDER), vy0 = std::max(0,tile.y0-BORDER);
+			const int vx1 = std::min(IPL->width,tile.x1+BORDER), vy1 = std::min(IPL->height,tile.y1+BORDER);
+
+			IplImage view = *IPL;
+			view.roi = NULL;
+			view.width = vx1-vx0;
+			view.height = vy1-vy0;
+			view.imageData = IPL->imageData + vy0*IPL->widthStep + vx0;
+			view.imageSize = view.height*view.widthStep;
+
+			// Detect, with adaptive threshold:
+			TSimpleFeatureList raw;
+			int threshold = opts.threshold;
+			for (;;)
+			{
+				raw.clear();
+				fast_corner_detect_N(N_fast,&view,raw,threshold);
+				if (raw.size()>=opts.min_features_per_tile || threshold<=opts.min_threshold)
+					break;
+				threshold = std::max(opts.min_threshold, threshold/2);
+			}
+
+			// Keep the corners inside the tile itself (not in the borders), and compute their response:
+			const int KLT_half_win = 4;
+			const int max_x = IPL->width - 1 - KLT_half_win;
+			const int max_y = IPL->height - 1 - KLT_half_win;
+
+			std::vector<TSimpleFeature> cands;
+			cands.reserve(raw.size());
+			for (size_t k=0;k<raw.size();k++)
+			{
+				TSimpleFeature f = raw[k];
+				f.pt.x += vx0;
+				f.pt.y += vy0;
+				if (f.pt.x<tile.x0 || f.pt.x>=tile.x1 || f.pt.y<tile.y0 || f.pt.y>=tile.y1)
+					continue;
+				if (f.pt.x>KLT_half_win && f.pt.y>KLT_half_win && f.pt.x<=max_x && f.pt.y<=max_y)
+					f.response = tile.img->KLT_response(f.pt.x,f.pt.y,KLT_half_win);
+				else f.response = -100;
+				cands.push_back(f);
+			}
+
+			// Sort by decreasing response. stable_sort() keeps ties in raster order, so the output is deterministic:
+			std::vector<size_t> sorted_indices(cands.size());
+			for (size_t k=0;k<cands.size();k++) sorted_indices[k]=k;
+			std::stable_sort(sorted_indices.begin(), sorted_indices.end(), KeypointResponseSorter<std::vector<TSimpleFeature> >(cands) );
+
+			// 3x3 non-maximal suppression + limit of features per tile:
+			const int tw = tile.x1-tile.x0, th = tile.y1-tile.y0;
+			std::vector<uint8_t> occupied(tw*th,0);
+			tile.corners.clear();
+			for (size_t k=0;k<sorted_indices.size();k++)
+			{
+				if (max_features_per_tile && tile.corners.size()>=max_features_per_tile)
+					break;
+				TSimpleFeature f = cands[sorted_indices[k]];
+				const int lx = f.pt.x-tile.x0, ly = f.pt.y-tile.y0;
+				if (occupied[ly*tw+lx])
+					continue; // A better corner is adjacent to this one
+				for (int dy=std::max(0,ly-1);dy<=std::min(th-1,ly+1);dy++)
+					for (int dx=std::max(0,lx-1);dx<=std::min(tw-1,lx+1);dx++)
+						occupied[dy*tw+dx]=1;
+
+				f.octave = tile.octave;
+				f.pt.x <<= tile.octave;
+				f.pt.y <<= tile.octave;
+				f.ID = 0;
+				f.track_status = status_IDLE;
+				f.user_flags = 0;
+				tile.corners.push_back_fast(f);
+			}
+		}
+	};
+
+	/** Sorts indices by increasing rank (used to interleave the corners of all tiles) */
+	struct TRankSorter
+	{
+		const std::vector<size_t> &rank;
+		TRankSorter(const std::vector<size_t> &r) : rank(r) { }
+		bool operator()(size_t k1, size_t k2) const { return rank[k1]<rank[k2]; }
+	};
+
+	void detectFeatures_FASTER_tiled_impl(
+		const int N_fast,
+		const std::vector<const CImage*> &octaves,
+		TSimpleFeatureList & corners,
+		const CFeatureExtraction::TOptions::TFASTOptions &opts,
+		const unsigned int max_features_per_tile,
+		bool append_to_list )
+	{
+		ASSERT_ABOVE_(opts.tile_size,0)
+		if (!append_to_list) corners.clear();
+
+		// Build the list of tiles of all the octaves:
+		std::vector<TDetectionTile> tiles;
+		for (size_t o=0;o<octaves.size();o++)
+		{
+			const CImage &img = *octaves[o];
+			ASSERTMSG_(!img.isColor(), "Tiled detection requires grayscale images")
+			const int w = img.getWidth(), h = img.getHeight();
+			const int ts = opts.tile_size;
+			for (int y=0;y<h;y+=ts)
+				for (int x=0;x<w;x+=ts)
+				{
+					TDetectionTile t;
+					t.img = &img;
+					t.octave = static_cast<uint8_t>(o);
+					t.x0 = x; t.x1 = std::min(w,x+ts);
+					t.y0 = y; t.y1 = std::min(h,y+ts);
+					tiles.push_back(t);
+				}
+		}
+
+		TDetectTilesBlock functor(N_fast,opts,max_features_per_tile,tiles);
+		mrpt::system::parallelForBlocks(tiles.size(),functor,opts.num_threads);
+
+		// Merge, in the (deterministic) order of tiles:
+		size_t N = corners.size();
+		for (size_t i=0;i<tiles.size();i++) N+=tiles[i].corners.size();
+		corners.reserve(N);
+		for (size_t i=0;i<tiles.size();i++)
+			for (size_t k=0;k<tiles[i].corners.size();k++)
+				corners.push_back_fast(tiles[i].corners[k]);
+	}
+}
+#endif
+
+void CFeatureExtraction::detectFeatures_SSE2_FASTER_tiled(
+	const int N_fast,
+	const CImage &img,
+	TSimpleFeatureList & corners,
+	const TOptions::TFASTOptions &opts,
+	const unsigned int max_features_per_tile,
+	bool append_to_list )
+{
+#if MRPT_HAS_OPENCV
+	std::vector<const CImage*> octaves(1, &img);
+	detectFeatures_FASTER_tiled_impl(N_fast,octaves,corners,opts,max_features_per_tile,append_to_list);
+#else
+	THROW_EXCEPTION("MRPT built without OpenCV support!")
+#endif
+}
+
+void CFeatureExtraction::detectFeatures_SSE2_FASTER_tiled(
+	const int N_fast,
+	const CImagePyramid &pyramid,
+	TSimpleFeatureList & corners,
+	const TOptions::TFASTOptions &opts,
+	const unsigned int max_features_per_tile,
+	bool append_to_list )
+{
+#if MRPT_HAS_OPENCV
+	std::vector<const CImage*> octaves(pyramid.images.size());
+	for (size_t o=0;o<octaves.size();o++)
+		octaves[o] = &pyramid.images[o];
+	detectFeatures_FASTER_tiled_impl(N_fast,octaves,corners,opts,max_features_per_tile,append_to_list);
+#else
+	THROW_EXCEPTION("MRPT built without OpenCV support!")
+#endif
+}
+
 /************************************************************************************************
 *								extractFeaturesFASTER											*
 ************************************************************************************************/
@@ -90,14 +301,37 @@ void  CFeatureExtraction::extractFeaturesFASTER_N(
 
 	switch (N_fast)
 	{
-	case 9:  fast_corner_detect_9 (IPL,corners, options.FASTOptions.threshold, 0, NULL); type_of_this_feature=featFASTER9; break;
-	case 10: fast_corner_detect_10(IPL,corners, options.FASTOptions.threshold, 0, NULL); type_of_this_feature=featFASTER10; break;
-	case 12: fast_corner_detect_12(IPL,corners, options.FASTOptions.threshold, 0, NULL); type_of_this_feature=featFASTER12; break;
+	case 9:  type_of_this_feature=featFASTER9; break;
+	case 10: type_of_this_feature=featFASTER10; break;
+	case 12: type_of_this_feature=featFASTER12; break;
 	default:
 		THROW_EXCEPTION("Only the 9,10,12 FASTER detectors are implemented.")
 		break;
 	};
 
+	const bool tiled = options.FASTOptions.tiled_detection;
+	if (tiled)
+	{
+		// Tiles already come with their KLT response and per-tile limits:
+		unsigned int max_per_tile = options.FASTOptions.max_features_per_tile;
+		if (!max_per_tile && nDesiredFeatures!=0)
+		{
+			const unsigned int ts = options.FASTOptions.tile_size;
+			const size_t nTiles = ((inImg_gray.getWidth()+ts-1)/ts) * ((inImg_gray.getHeight()+ts-1)/ts);
+			max_per_tile = static_cast<unsigned int>( (nDesiredFeatures+nTiles-1)/nTiles );
+		}
+		detectFeatures_SSE2_FASTER_tiled(N_fast,inImg_gray,corners,options.FASTOptions,max_per_tile);
+	}
+	else
+	{
+		switch (N_fast)
+		{
+		case 9:  fast_corner_detect_9 (IPL,corners, options.FASTOptions.threshold, 0, NULL); break;
+		case 10: fast_corner_detect_10(IPL,corners, options.FASTOptions.threshold, 0, NULL); break;
+		case 12: fast_corner_detect_12(IPL,corners, options.FASTOptions.threshold, 0, NULL); break;
+		};
+	}
+
 	// *All* the features have been extracted.
 	const size_t N = corners.size();
 
@@ -107,8 +341,22 @@ void  CFeatureExtraction::extractFeaturesFASTER_N(
 	std::vector<size_t> sorted_indices(N);
 	for (size_t i=0;i<N;i++)  sorted_indices[i]=i;
 
+	if (tiled)
+	{
+		// Round-robin across tiles: the best corner of each tile, then the second best of each one, and so on.
+		// Corners come grouped by tile, in tile order, and sorted by decreasing response within each tile, so
+		// a stable sort by their rank within their tile does it. This way, the limit of nDesiredFeatures below
+		// doesn't favor the tiles with the strongest corners.
+		const unsigned int ts = options.FASTOptions.tile_size;
+		const size_t nTilesX = (inImg_gray.getWidth()+ts-1)/ts;
+		const size_t nTilesY = (inImg_gray.getHeight()+ts-1)/ts;
+		std::vector<size_t> tile_counts(nTilesX*nTilesY,0), rank(N);
+		for (size_t i=0;i<N;i++)
+			rank[i] = tile_counts[ (corners[i].pt.y/ts)*nTilesX + corners[i].pt.x/ts ]++;
+		std::stable_sort( sorted_indices.begin(), sorted_indices.end(), TRankSorter(rank) );
+	}
 	// Use KLT response
-	if (options.FASTOptions.use_KLT_response ||
+	else if (options.FASTOptions.use_KLT_response ||
 		nDesiredFeatures!=0 // If the user wants us to limit the number of features, we need to do it according to some quality measure
 		)
 	{
@@ -310,6 +310,12 @@ CFeatureExtraction::TOptions::TOptions(const TFeatureType _featsType) :
 	FASTOptions.nonmax_suppression 		= true;
 	FASTOptions.use_KLT_response		= false;
 	FASTOptions.min_distance 			= 5;
+	FASTOptions.tiled_detection			= false;
+	FASTOptions.tile_size				= 128;
+	FASTOptions.max_features_per_tile	= 0;
+	FASTOptions.min_features_per_tile	= 0;
+	FASTOptions.min_threshold			= 5;
+	FASTOptions.num_threads				= 0;
 
 	// ORB:
 	ORBOptions.extract_patch			= false;
@@ -370,6 +376,12 @@ void CFeatureExtraction::TOptions::dumpToTextStream(mrpt::utils::CStream	&out) c
 	LOADABLEOPTS_DUMP_VAR(FASTOptions.nonmax_suppression,bool)
 	LOADABLEOPTS_DUMP_VAR(FASTOptions.min_distance,float)
 	LOADABLEOPTS_DUMP_VAR(FASTOptions.use_KLT_response,bool)
+	LOADABLEOPTS_DUMP_VAR(FASTOptions.tiled_detection,bool)
+	LOADABLEOPTS_DUMP_VAR(FASTOptions.tile_size,int)
+	LOADABLEOPTS_DUMP_VAR(FASTOptions.max_features_per_tile,int)
+	LOADABLEOPTS_DUMP_VAR(FASTOptions.min_features_per_tile,int)
+	LOADABLEOPTS_DUMP_VAR(FASTOptions.min_threshold,int)
+	LOADABLEOPTS_DUMP_VAR(FASTOptions.num_threads,int)
 
 	LOADABLEOPTS_DUMP_VAR(ORBOptions.scale_factor,float)
 	LOADABLEOPTS_DUMP_VAR(ORBOptions.min_distance,int)
@@ -430,6 +442,12 @@ void CFeatureExtraction::TOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(FASTOptions.nonmax_suppression,bool,  iniFile,section)
 	MRPT_LOAD_CONFIG_VAR(FASTOptions.min_distance,float,  iniFile,section)
 	MRPT_LOAD_CONFIG_VAR(FASTOptions.use_KLT_response,bool,  iniFile,section)
+	MRPT_LOAD_CONFIG_VAR(FASTOptions.tiled_detection,bool,  iniFile,section)
+	MRPT_LOAD_CONFIG_VAR(FASTOptions.tile_size,int,  iniFile,section)
+	MRPT_LOAD_CONFIG_VAR(FASTOptions.max_features_per_tile,int,  iniFile,section)
+	MRPT_LOAD_CONFIG_VAR(FASTOptions.min_features_per_tile,int,  iniFile,section)
+	MRPT_LOAD_CONFIG_VAR(FASTOptions.min_threshold,int,  iniFile,section)
+	MRPT_LOAD_CONFIG_VAR(FASTOptions.num_threads,int,  iniFile,section)
 
 	MRPT_LOAD_CONFIG_VAR(ORBOptions.extract_patch,bool,  iniFile,section)
 	MRPT_LOAD_CONFIG_VAR(ORBOptions.min_distance,int,  iniFile,section)
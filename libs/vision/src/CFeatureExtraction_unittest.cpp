@@ -0,0 +1,60 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/CFeatureExtraction.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace std;
+
+#if MRPT_HAS_OPENCV
+
+TEST(CFeatureExtraction, FASTER_TiledRoundRobin)
+{
+	// 2x2 tiles of 128x128 pixels, all full of squares (4 corners each), but those in the
+	// first tile with a much higher contrast, i.e. with stronger corners:
+	const unsigned int TILE = 128;
+	CImage img(2*TILE,2*TILE,CH_GRAY);
+	img.filledRectangle(0,0,2*TILE-1,2*TILE-1, TColor(100,100,100));
+	for (unsigned int y=8;y+8<2*TILE;y+=16)
+		for (unsigned int x=8;x+8<2*TILE;x+=16)
+		{
+			const uint8_t v = (x<TILE && y<TILE) ? 255 : 150;
+			img.filledRectangle(x,y,x+5,y+5, TColor(v,v,v));
+		}
+
+	CFeatureExtraction fExt;
+	fExt.options.featsType = featFASTER9;
+	fExt.options.patchSize = 0;
+	fExt.options.FASTOptions.threshold = 20;
+	fExt.options.FASTOptions.min_distance = 5;
+	fExt.options.FASTOptions.tiled_detection = true;
+	fExt.options.FASTOptions.tile_size = TILE;
+	fExt.options.FASTOptions.max_features_per_tile = 30;  // More than the desired total per tile
+
+	const size_t nDesired = 40;
+	CFeatureList feats;
+	fExt.detectFeatures(img, feats, 0, nDesired);
+	ASSERT_EQ(feats.size(), nDesired);
+
+	// The best corners of each tile are taken in turns, so the strong tile doesn't take them all:
+	size_t counts[2][2] = { {0,0}, {0,0} };
+	for (CFeatureList::const_iterator it=feats.begin();it!=feats.end();++it)
+		counts[ (*it)->y<TILE ? 0:1 ][ (*it)->x<TILE ? 0:1 ]++;
+	for (int ty=0;ty<2;ty++)
+		for (int tx=0;tx<2;tx++)
+		{
+			EXPECT_GE(counts[ty][tx], nDesired/4-2) << "tile=" << tx << "," << ty;
+			EXPECT_LE(counts[ty][tx], nDesired/4+2) << "tile=" << tx << "," << ty;
+		}
+}
+
+#endif
@@ -13,6 +13,8 @@
 // Universal include for all versions of OpenCV
 #include <mrpt/otherlibs/do_opencv_includes.h> 
 
+#include "remap_internals.h"
+
 using namespace mrpt;
 using namespace mrpt::poses;
 using namespace mrpt::vision;
@@ -26,7 +28,8 @@ CStereoRectifyMap::CStereoRectifyMap() :
 	m_resize_output(false),
 	m_enable_both_centers_coincide(false),
 	m_resize_output_value(0,0),
-	m_interpolation_method(mrpt::utils::IMG_INTERP_LINEAR)
+	m_interpolation_method(mrpt::utils::IMG_INTERP_LINEAR),
+	m_num_threads(0)
 {
 }
 
@@ -316,6 +319,7 @@ void CStereoRectifyMap::rectify(
 	const IplImage * in_right = right_image.getAs<IplImage>();
 
 	IplImage * out_left_image, *out_right_image;
+	CImage out_left(UNINITIALIZED_IMAGE), out_right(UNINITIALIZED_IMAGE);
 	if (use_internal_mem_cache)
 	{
 		m_cache1.resize( trg_size.width, trg_size.height, left_image.isColor() ? 3:1, left_image.isOriginTopLeft() );
@@ -326,8 +330,16 @@ void CStereoRectifyMap::rectify(
 	}
 	else
 	{
-		out_left_image  = cvCreateImage( trg_size, in_left->depth, in_left->nChannels );
-		out_right_image = cvCreateImage( trg_size, in_right->depth, in_right->nChannels );
+		// Output buffers from the pool of image buffers, if possible:
+		if (in_left->depth==IPL_DEPTH_8U)
+		     out_left.resize( trg_size.width, trg_size.height, in_left->nChannels, left_image.isOriginTopLeft() );
+		else out_left.setFromIplImage( cvCreateImage( trg_size, in_left->depth, in_left->nChannels ) );
+		if (in_right->depth==IPL_DEPTH_8U)
+		     out_right.resize( trg_size.width, trg_size.height, in_right->nChannels, right_image.isOriginTopLeft() );
+		else out_right.setFromIplImage( cvCreateImage( trg_size, in_right->depth, in_right->nChannels ) );
+
+		out_left_image  = out_left.getAs<IplImage>();
+		out_right_image = out_right.getAs<IplImage>();
 	}
 
 	this->rectify_IPL(
@@ -346,9 +358,9 @@ void CStereoRectifyMap::rectify(
 	}
 	else
 	{
-		// Move the internal pointers: but we deallocate the old contents and needed to allocate this one
-		left_image.setFromIplImage(out_left_image);
-		right_image.setFromIplImage(out_right_image);
+		// Move the internal pointers: the old contents go back to the pool of image buffers
+		left_image.swap(out_left);
+		right_image.swap(out_right);
 	}
 
 #endif
@@ -401,6 +413,18 @@ void CStereoRectifyMap::rectify_IPL(
 	const uint32_t ncols_out = m_resize_output ? m_resize_output_value.x : ncols;
 	const uint32_t nrows_out = m_resize_output ? m_resize_output_value.y : nrows;
 
+	const bool native_interp = (m_interpolation_method==mrpt::utils::IMG_INTERP_NN || m_interpolation_method==mrpt::utils::IMG_INTERP_LINEAR);
+
+	detail::TRemapJob jobs[2];
+	if (native_interp &&
+		detail::fillRemapJob(static_cast<const IplImage*>(srcImg_left), static_cast<IplImage*>(outImg_left), m_dat_mapx_left, m_dat_mapy_left, ncols_out,nrows_out, jobs[0]) &&
+		detail::fillRemapJob(static_cast<const IplImage*>(srcImg_right), static_cast<IplImage*>(outImg_right), m_dat_mapx_right, m_dat_mapy_right, ncols_out,nrows_out, jobs[1]) )
+	{
+		// Both images at once:
+		detail::remapFixedPoint(jobs, 2, m_interpolation_method==mrpt::utils::IMG_INTERP_LINEAR, m_num_threads);
+		return;
+	}
+
 	const CvMat mapx_left = cvMat(nrows_out,ncols_out,  CV_16SC2, const_cast<int16_t*>(&m_dat_mapx_left[0]) );
 	const CvMat mapy_left = cvMat(nrows_out,ncols_out,  CV_16UC1, const_cast<uint16_t*>(&m_dat_mapy_left[0]) );
 	const CvMat mapx_right = cvMat(nrows_out,ncols_out,  CV_16SC2, const_cast<int16_t*>(&m_dat_mapx_right[0]) );
@@ -416,8 +440,10 @@ void CStereoRectifyMap::rectify_IPL(
 	cv::Mat dst1 = cv::cvarrToMat(outImg_left);
 	cv::Mat dst2 = cv::cvarrToMat(outImg_right);
 
-    cv::remap( src1, dst1, mapx1, mapy1,static_cast<int>(m_interpolation_method),cv::BORDER_CONSTANT, cvScalarAll(0) );
-    cv::remap( src2, dst2, mapx2, mapy2,static_cast<int>(m_interpolation_method),cv::BORDER_CONSTANT, cvScalarAll(0) );
+	// Nearest-neighbor uses the integer part of the maps only, as detail::remapFixedPoint() does:
+	const bool nn = m_interpolation_method==mrpt::utils::IMG_INTERP_NN;
+    cv::remap( src1, dst1, mapx1, nn ? cv::Mat() : mapy1,static_cast<int>(m_interpolation_method),cv::BORDER_CONSTANT, cvScalarAll(0) );
+    cv::remap( src2, dst2, mapx2, nn ? cv::Mat() : mapy2,static_cast<int>(m_interpolation_method),cv::BORDER_CONSTANT, cvScalarAll(0) );
 #endif
 	MRPT_END
 }
@@ -0,0 +1,119 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/CStereoRectifyMap.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+// Universal include for all versions of OpenCV
+#include <mrpt/otherlibs/do_opencv_includes.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace std;
+
+#if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM>=0x200
+
+namespace
+{
+	const unsigned int NCOLS = 160, NROWS = 120;
+
+	void generate_image(CImage &img, bool color)
+	{
+		img.resize(NCOLS,NROWS, color ? 3:1, true);
+		IplImage *ipl = img.getAs<IplImage>();
+		for (int r=0;r<ipl->height;r++)
+			for (int c=0;c<ipl->width*ipl->nChannels;c++)
+				ipl->imageData[r*ipl->widthStep+c] = static_cast<char>( mrpt::random::randomGenerator.drawUniform32bit() );
+	}
+
+	// Fixed-point maps (CV_16SC2 + CV_16UC1) whose source coordinates also fall out of the image, at both sides:
+	void generate_maps(double shift, std::vector<int16_t> &map_xy, std::vector<uint16_t> &map_frac)
+	{
+		cv::Mat fx(NROWS,NCOLS,CV_32FC1), fy(NROWS,NCOLS,CV_32FC1);
+		for (unsigned int r=0;r<NROWS;r++)
+			for (unsigned int c=0;c<NCOLS;c++)
+			{
+				fx.at<float>(r,c) = static_cast<float>( -10.3 + shift + 1.15*c + 3*sin(r/7.0) );
+				fy.at<float>(r,c) = static_cast<float>( -8.6 - shift + 1.2*r + 2*cos(c/5.0) );
+			}
+		map_xy.resize(2*NCOLS*NROWS);
+		map_frac.resize(NCOLS*NROWS);
+		cv::Mat m1(NROWS,NCOLS,CV_16SC2,&map_xy[0]), m2(NROWS,NCOLS,CV_16UC1,&map_frac[0]);
+		cv::convertMaps(fx,fy,m1,m2,CV_16SC2);
+	}
+
+	cv::Mat cv_remap(const CImage &in, std::vector<int16_t> &map_xy, std::vector<uint16_t> &map_frac, TInterpolationMethod interp)
+	{
+		// INTER_NEAREST with the integer part of the maps only:
+		const cv::Mat m1(NROWS,NCOLS,CV_16SC2,&map_xy[0]), m2(NROWS,NCOLS,CV_16UC1,&map_frac[0]);
+		cv::Mat dst;
+		cv::remap(cv::cvarrToMat(in.getAs<IplImage>()), dst, m1, interp==IMG_INTERP_NN ? cv::Mat() : m2, static_cast<int>(interp), cv::BORDER_CONSTANT, cv::Scalar::all(0));
+		return dst;
+	}
+
+	void expect_same_image(const CImage &img, const cv::Mat &expected, const std::string &msg)
+	{
+		const cv::Mat m = cv::cvarrToMat(img.getAs<IplImage>());
+		ASSERT_EQ(m.size(), expected.size()) << msg;
+		ASSERT_EQ(m.type(), expected.type()) << msg;
+		EXPECT_EQ(cv::norm(m, expected, cv::NORM_INF), 0) << msg;
+	}
+}
+
+TEST(CStereoRectifyMap, SameAsOpenCVRemap)
+{
+	mrpt::random::randomGenerator.randomize(123);
+
+	TStereoCamera cam;
+	cam.leftCamera.ncols = NCOLS;
+	cam.leftCamera.nrows = NROWS;
+	cam.leftCamera.setIntrinsicParamsFromValues(150,150, NCOLS/2,NROWS/2);
+	cam.rightCamera = cam.leftCamera;
+	cam.rightCameraPose = mrpt::poses::CPose3DQuat(0.1,0,0, mrpt::math::CQuaternionDouble());
+
+	// Our own maps, with non-integer and out-of-image source coordinates:
+	std::vector<int16_t> lxy, rxy;
+	std::vector<uint16_t> lfr, rfr;
+	generate_maps(0, lxy,lfr);
+	generate_maps(0.4, rxy,rfr);
+
+	CStereoRectifyMap rmap;
+	rmap.setFromCamParams(cam);
+	rmap.setRectifyMaps(lxy,lfr, rxy,rfr);
+
+	for (int color=0;color<2;color++)
+	{
+		CImage left, right;
+		generate_image(left, color!=0);
+		generate_image(right, color!=0);
+
+		for (int interp=0;interp<2;interp++)
+		{
+			const TInterpolationMethod method = interp==0 ? IMG_INTERP_NN : IMG_INTERP_LINEAR;
+			const cv::Mat cv_left  = cv_remap(left, lxy,lfr, method);
+			const cv::Mat cv_right = cv_remap(right, rxy,rfr, method);
+
+			for (unsigned int nThreads=1;nThreads<=3;nThreads+=2)
+			{
+				rmap.setInterpolationMethod(method);
+				rmap.setNumThreads(nThreads);
+				CImage out_left, out_right;
+				rmap.rectify(left,right, out_left,out_right);
+
+				const std::string msg = mrpt::format("color=%i interp=%i threads=%u",color,interp,nThreads);
+				expect_same_image(out_left, cv_left, msg+" left");
+				expect_same_image(out_right, cv_right, msg+" right");
+			}
+		}
+	}
+}
+
+#endif
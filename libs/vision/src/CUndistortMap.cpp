@@ -13,12 +13,14 @@
 // Universal include for all versions of OpenCV
 #include <mrpt/otherlibs/do_opencv_includes.h> 
 
+#include "remap_internals.h"
+
 using namespace mrpt;
 using namespace mrpt::vision;
 
 
 // Ctor: Leave all vectors empty
-CUndistortMap::CUndistortMap()
+CUndistortMap::CUndistortMap() : m_num_threads(0)
 {
 }
 
@@ -59,6 +61,22 @@ void CUndistortMap::setFromCamParams(const mrpt::utils::TCamera &campar)
 	MRPT_END
 }
 
+/** Bilinear remap with MRPT's own implementation for 8-bit images, or with cvRemap() otherwise */
+void CUndistortMap::internal_remap(const void *src, void *dst, const void *mapx, const void *mapy) const
+{
+#if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM>=0x200
+	const IplImage *srcImg = static_cast<const IplImage*>(src);
+	IplImage *outImg = static_cast<IplImage*>(dst);
+
+	detail::TRemapJob job;
+	if (detail::fillRemapJob(srcImg, outImg, m_dat_mapx, m_dat_mapy, m_camera_params.ncols, m_camera_params.nrows, job))
+		detail::remapFixedPoint(&job, 1, true /* bilinear */, m_num_threads);
+	else cvRemap(srcImg, outImg, static_cast<const CvMat*>(mapx), static_cast<const CvMat*>(mapy));	//cv::remap(src, dst_part, map1_part, map2_part, INTER_LINEAR, BORDER_CONSTANT );
+#else
+	MRPT_UNUSED_PARAM(src); MRPT_UNUSED_PARAM(dst); MRPT_UNUSED_PARAM(mapx); MRPT_UNUSED_PARAM(mapy);
+#endif
+}
+
 /** Undistort the input image and saves the result in-place- \a setFromCamParams() must have been set prior to calling this.
   */
 void CUndistortMap::undistort(const mrpt::utils::CImage &in_img, mrpt::utils::CImage &out_img) const
@@ -72,9 +90,13 @@ void CUndistortMap::undistort(const mrpt::utils::CImage &in_img, mrpt::utils::CI
 	CvMat mapy = cvMat(m_camera_params.nrows,m_camera_params.ncols,  CV_16UC1, const_cast<uint16_t*>(&m_dat_mapy[0]) );
 
 	const IplImage *srcImg = in_img.getAs<IplImage>();	// Source Image
-	IplImage *outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
-	cvRemap(srcImg, outImg, &mapx, &mapy);	//cv::remap(src, dst_part, map1_part, map2_part, INTER_LINEAR, BORDER_CONSTANT );
-	out_img.setFromIplImage(outImg);
+	// The output buffer comes from the pool of image buffers, if possible, and the former buffer of "out_img" goes back to it:
+	mrpt::utils::CImage out(mrpt::utils::UNINITIALIZED_IMAGE);
+	if (srcImg->depth==IPL_DEPTH_8U)
+	     out.resize(srcImg->width,srcImg->height,srcImg->nChannels,in_img.isOriginTopLeft());
+	else out.setFromIplImage(cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels ));
+	internal_remap(srcImg, out.getAs<IplImage>(), &mapx, &mapy);
+	out_img.swap(out);
 #endif
 	MRPT_END
 }
@@ -92,9 +114,13 @@ void CUndistortMap::undistort(mrpt::utils::CImage &in_out_img) const
 	CvMat mapy = cvMat(m_camera_params.nrows,m_camera_params.ncols,  CV_16UC1, const_cast<uint16_t*>(&m_dat_mapy[0]) );
 
 	const IplImage *srcImg = in_out_img.getAs<IplImage>();	// Source Image
-	IplImage *outImg = cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels );
-	cvRemap(srcImg, outImg, &mapx, &mapy);	//cv::remap(src, dst_part, map1_part, map2_part, INTER_LINEAR, BORDER_CONSTANT );
-	in_out_img.setFromIplImage(outImg);
+	// The output buffer comes from the pool of image buffers, if possible, and the former buffer of "in_out_img" goes back to it:
+	mrpt::utils::CImage out(mrpt::utils::UNINITIALIZED_IMAGE);
+	if (srcImg->depth==IPL_DEPTH_8U)
+	     out.resize(srcImg->width,srcImg->height,srcImg->nChannels,in_out_img.isOriginTopLeft());
+	else out.setFromIplImage(cvCreateImage( cvGetSize( srcImg ), srcImg->depth, srcImg->nChannels ));
+	internal_remap(srcImg, out.getAs<IplImage>(), &mapx, &mapy);
+	in_out_img.swap(out);
 #endif
 	MRPT_END
 }
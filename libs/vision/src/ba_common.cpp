@@ -185,6 +185,55 @@ double mrpt::vision::reprojectionResiduals(
 	MRPT_END
 }
 
+namespace
+{
+	struct TReprojectionResidualsBlock
+	{
+		const TSequenceFeatureObservations   & observations;
+		const TCamera                        & camera_params;
+		const TFramePosesVec                 & frame_poses;
+		const TLandmarkLocationsVec          & landmark_points;
+		std::vector<CArray<double,2> >       & out_residuals;
+		const bool   frame_poses_are_inverse;
+		const bool   use_robust_kernel;
+		const double kernel_param;
+		std::vector<double> * out_kernel_1st_deriv;
+		std::vector<double> & block_sums;
+
+		TReprojectionResidualsBlock(const TSequenceFeatureObservations &obs, const TCamera &cam, const TFramePosesVec &fp, const TLandmarkLocationsVec &lp,
+			std::vector<CArray<double,2> > &res, bool inv, bool robust, double kparam, std::vector<double> *kderiv, std::vector<double> &sums) :
+			observations(obs), camera_params(cam), frame_poses(fp), landmark_points(lp), out_residuals(res),
+			frame_poses_are_inverse(inv), use_robust_kernel(robust), kernel_param(kparam), out_kernel_1st_deriv(kderiv), block_sums(sums)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int block)
+		{
+			double sum = 0;
+			for (size_t i=first;i<last;i++)
+			{
+				const TFeatureObservation & OBS = observations[i];
+
+				const TFeatureID     i_p  = OBS.id_feature;
+				const TCameraPoseID  i_f  = OBS.id_frame;
+
+				ASSERT_BELOW_(i_p,landmark_points.size())
+				ASSERT_BELOW_(i_f,frame_poses.size())
+
+				const TFramePosesVec::value_type        & frame = frame_poses[i_f];
+				const TLandmarkLocationsVec::value_type & point = landmark_points[i_p];
+
+				double *ptr_1st_deriv = out_kernel_1st_deriv ? &((*out_kernel_1st_deriv)[i]) : NULL;
+
+				if (frame_poses_are_inverse)
+					reprojectionResidualsElement<true>(camera_params, OBS, out_residuals[i], frame, point, sum, use_robust_kernel,kernel_param,ptr_1st_deriv);
+				else
+					reprojectionResidualsElement<false>(camera_params, OBS, out_residuals[i], frame, point, sum, use_robust_kernel,kernel_param,ptr_1st_deriv);
+			}
+			block_sums[block] = sum;
+		}
+	};
+}
+
 double mrpt::vision::reprojectionResiduals(
 	const TSequenceFeatureObservations   & observations,
 	const TCamera                        & camera_params,
@@ -197,35 +246,39 @@ double mrpt::vision::reprojectionResiduals(
 	std::vector<double> * out_kernel_1st_deriv
 	)
 {
-	MRPT_START
+	return ba_reprojection_residuals(observations,camera_params,frame_poses,landmark_points,out_residuals,
+		frame_poses_are_inverse,use_robust_kernel,kernel_param,out_kernel_1st_deriv, 1 /* threads */);
+}
 
-	double sum = 0;
+double mrpt::vision::ba_reprojection_residuals(
+	const TSequenceFeatureObservations   & observations,
+	const TCamera                        & camera_params,
+	const TFramePosesVec                 & frame_poses,
+	const TLandmarkLocationsVec          & landmark_points,
+	std::vector<CArray<double,2> > & out_residuals,
+	const bool  frame_poses_are_inverse,
+	const bool  use_robust_kernel,
+	const double kernel_param,
+	std::vector<double> * out_kernel_1st_deriv,
+	const unsigned int num_threads
+	)
+{
+	MRPT_START
 
 	const size_t N = observations.size();
 	out_residuals.resize(N);
 	if (out_kernel_1st_deriv) out_kernel_1st_deriv->resize(N);
 
-	for (size_t i=0;i<N;i++)
-	{
-		const TFeatureObservation & OBS = observations[i];
-
-		const TFeatureID     i_p  = OBS.id_feature;
-		const TCameraPoseID  i_f  = OBS.id_frame;
+	const unsigned int nThreads = ba_num_threads(num_threads,N);
+	std::vector<double> block_sums(nThreads, 0.0);
 
-		ASSERT_BELOW_(i_p,landmark_points.size())
-		ASSERT_BELOW_(i_f,frame_poses.size())
-
-		const TFramePosesVec::value_type        & frame = frame_poses[i_f];
-		const TLandmarkLocationsVec::value_type & point = landmark_points[i_p];
-
-		double *ptr_1st_deriv = out_kernel_1st_deriv ? &((*out_kernel_1st_deriv)[i]) : NULL;
-
-		if (frame_poses_are_inverse)
-			reprojectionResidualsElement<true>(camera_params, OBS, out_residuals[i], frame, point, sum, use_robust_kernel,kernel_param,ptr_1st_deriv);
-		else
-			reprojectionResidualsElement<false>(camera_params, OBS, out_residuals[i], frame, point, sum, use_robust_kernel,kernel_param,ptr_1st_deriv);
-	}
+	TReprojectionResidualsBlock functor(observations,camera_params,frame_poses,landmark_points,out_residuals,
+		frame_poses_are_inverse,use_robust_kernel,kernel_param,out_kernel_1st_deriv,block_sums);
+	mrpt::system::parallelForBlocks(N, functor, nThreads);
 
+	double sum = 0;
+	for (size_t i=0;i<block_sums.size();i++)
+		sum+=block_sums[i];
 	return sum;
 	MRPT_END
 }
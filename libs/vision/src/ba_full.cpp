@@ -11,6 +11,7 @@
 
 #include <mrpt/vision/bundle_adjustment.h>
 #include <mrpt/utils/CTimeLogger.h>
+#include <mrpt/utils/CTicTac.h>
 #include <mrpt/math/CSparseMatrix.h>
 #include <mrpt/math/ops_containers.h>
 
@@ -35,6 +36,109 @@ using mrpt::aligned_containers;
 #	define INV_POSES_BOOL  false
 #endif
 
+namespace
+{
+	typedef aligned_containers<pair<TCameraPoseID,TLandmarkID>,CMatrixDouble66>::map_t  TReducedCameraSystem;
+
+	/** Block-row view of the (symmetric) reduced camera system, for matrix-vector products */
+	struct TReducedCameraSystemRows
+	{
+		vector<vector<pair<size_t,const CMatrixDouble66*> > > rows;
+
+		explicit TReducedCameraSystemRows(const TReducedCameraSystem &S, const size_t num_blocks) : rows(num_blocks)
+		{
+			for (TReducedCameraSystem::const_iterator it=S.begin();it!=S.end();++it)
+				rows[it->first.first].push_back( make_pair(static_cast<size_t>(it->first.second), &it->second) );
+		}
+	};
+
+	/** out = S * x, in parallel blocks of rows */
+	struct TReducedSystemProductBlock
+	{
+		const TReducedCameraSystemRows &S;
+		const Eigen::VectorXd &x;
+		Eigen::VectorXd &out;
+
+		TReducedSystemProductBlock(const TReducedCameraSystemRows &S_, const Eigen::VectorXd &x_, Eigen::VectorXd &out_) : S(S_), x(x_), out(out_) {}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			for (size_t j=first;j<last;j++)
+			{
+				Eigen::Matrix<double,6,1> acc = Eigen::Matrix<double,6,1>::Zero();
+				const vector<pair<size_t,const CMatrixDouble66*> > &row = S.rows[j];
+				for (size_t k=0;k<row.size();k++)
+					acc.noalias() += (*row[k].second) * x.segment<6>(6*row[k].first);
+				out.segment<6>(6*j) = acc;
+			}
+		}
+	};
+
+	/** Solves S*x=b for the reduced camera system with conjugate gradient and a block-Jacobi preconditioner.
+	  * \return false if S is found not to be positive definite, or if the residual is still above the tolerance after max_iters iterations */
+	bool solveReducedSystemPCG(
+		const TReducedCameraSystem &S, const size_t num_blocks,
+		const CVectorDouble &b, CVectorDouble &x,
+		const size_t max_iters, const double tolerance, const unsigned int num_threads,
+		size_t &out_iters )
+	{
+		const size_t n = 6*num_blocks;
+		ASSERT_EQUAL_(static_cast<size_t>(b.size()),n)
+
+		const TReducedCameraSystemRows rows(S,num_blocks);
+		const unsigned int nThreads = std::max(1u, std::min(num_threads ? num_threads : mrpt::system::getNumberOfProcessors(), static_cast<unsigned int>(num_blocks/64)) );
+
+		// Block-Jacobi preconditioner: inverses of the 6x6 diagonal blocks:
+		aligned_containers<CMatrixDouble66>::vector_t M_inv(num_blocks);
+		for (size_t j=0;j<num_blocks;j++)
+		{
+			TReducedCameraSystem::const_iterator it = S.find(pair<TCameraPoseID,TLandmarkID>(j,j));
+			ASSERT_(it!=S.end())
+			const Eigen::LLT<Eigen::Matrix<double,6,6> > llt(it->second);
+			if (llt.info()!=Eigen::Success)
+				return false;
+			M_inv[j] = llt.solve(Eigen::Matrix<double,6,6>::Identity());
+		}
+
+		Eigen::VectorXd X = Eigen::VectorXd::Zero(n), R = b, Z(n), P(n), Q(n);
+		for (size_t j=0;j<num_blocks;j++) Z.segment<6>(6*j) = M_inv[j]*R.segment<6>(6*j);
+		P = Z;
+		double rz = R.dot(Z);
+		const double b_norm = R.norm();
+
+		out_iters = 0;
+		bool converged = !(b_norm>0);
+		if (b_norm>0)
+		{
+			for (;out_iters<max_iters;out_iters++)
+			{
+				TReducedSystemProductBlock functor(rows,P,Q);
+				mrpt::system::parallelForBlocks(num_blocks,functor,nThreads);
+
+				const double pQ = P.dot(Q);
+				if (!(pQ>0))
+					return false; // Not positive definite (or numerical breakdown)
+
+				const double alpha = rz/pQ;
+				X += alpha*P;
+				R -= alpha*Q;
+				if (R.norm()<=tolerance*b_norm)
+				{
+					out_iters++;
+					converged = true;
+					break;
+				}
+				for (size_t j=0;j<num_blocks;j++) Z.segment<6>(6*j) = M_inv[j]*R.segment<6>(6*j);
+				const double rz_new = R.dot(Z);
+				P = Z + (rz_new/rz)*P;
+				rz = rz_new;
+			}
+		}
+		x = X;
+		return converged;
+	}
+}
+
 /* ----------------------------------------------------------
                     bundle_adj_full
 
@@ -82,6 +186,10 @@ double mrpt::vision::bundle_adj_full(
 	const size_t num_fix_frames   = extra_params.getWithDefaultVal("num_fix_frames",1);
 	const size_t num_fix_points   = extra_params.getWithDefaultVal("num_fix_points",0);
 	const double kernel_param     = extra_params.getWithDefaultVal("kernel_param",3.0);
+	const unsigned int num_threads= extra_params.getWithDefaultVal("num_threads",0);
+	const bool   use_pcg          = 0!=extra_params.getWithDefaultVal("use_pcg",0);
+	const size_t pcg_max_iters    = extra_params.getWithDefaultVal("pcg_max_iterations",500);
+	const double pcg_tolerance    = extra_params.getWithDefaultVal("pcg_tolerance",1e-8);
 
 	const bool   enable_profiler  = 0!=extra_params.getWithDefaultVal("profiler",0);
 
@@ -123,18 +231,19 @@ double mrpt::vision::bundle_adj_full(
 
 	// Compute sparse Jacobians:
 	profiler.enter("compute_Jacobians");
-	ba_compute_Jacobians<INV_POSES_BOOL>(frame_poses, landmark_points, camera_params, jac_data_vec, num_fix_frames, num_fix_points);
+	ba_compute_Jacobians<INV_POSES_BOOL>(frame_poses, landmark_points, camera_params, jac_data_vec, num_fix_frames, num_fix_points, num_threads);
 	profiler.leave("compute_Jacobians");
 
 
 	profiler.enter("reprojectionResiduals");
-	double res = mrpt::vision::reprojectionResiduals(
+	double res = ba_reprojection_residuals(
 					 observations, camera_params, frame_poses, landmark_points,
 					 residual_vec,
 					 INV_POSES_BOOL, // are poses inverse?
 					 use_robust_kernel,
 					 kernel_param,
-					 use_robust_kernel ? &kernel_1st_deriv : NULL );
+					 use_robust_kernel ? &kernel_1st_deriv : NULL,
+					 num_threads );
 	profiler.leave("reprojectionResiduals");
 
 	MRPT_CHECK_NORMAL_NUMBER(res)
@@ -201,6 +310,7 @@ double mrpt::vision::bundle_adj_full(
 			(*user_feedback)(iter, res, max_iters, observations, frame_poses, landmark_points );
 
 		bool has_improved = false;
+		CTicTac iter_timer;
 		do
 		{
 			profiler.enter("COMPLETE_ITER");
@@ -300,44 +410,73 @@ double mrpt::vision::bundle_adj_full(
 			profiler.leave("Schur.build.reduced.frames");
 
 
-			profiler.enter("sS:ALL");
-			profiler.enter("sS:fill");
+			bool solved = true;
+			bool use_cholesky = !use_pcg;
+			if (use_pcg)
+			{
+				profiler.enter("sS:pcg");
+				size_t pcg_iters = 0;
+				CVectorDouble  pcg_res;
+				if (solveReducedSystemPCG(YW_map, num_free_frames, e, pcg_res, pcg_max_iters, pcg_tolerance, num_threads, pcg_iters))
+				{
+					::memcpy(&delta[0],&pcg_res[0],pcg_res.size()*sizeof(pcg_res[0]));
+					VERBOSE_COUT << "PCG iterations: " << pcg_iters << endl;
+				}
+				else
+				{
+					// Not converged (or not positive definite): the Cholesky solver decides
+					VERBOSE_COUT << "PCG did not converge after " << pcg_iters << " iterations: using the Cholesky solver instead.\n";
+					use_cholesky = true;
+				}
+				profiler.leave("sS:pcg");
+			}
+			if (use_cholesky)
+			{
+				profiler.enter("sS:ALL");
+				profiler.enter("sS:fill");
 
-			VERBOSE_COUT << "Entries in YW_map:" << YW_map.size() << endl;
+				VERBOSE_COUT << "Entries in YW_map:" << YW_map.size() << endl;
 
-			CSparseMatrix sS(len_free_frames, len_free_frames);
+				CSparseMatrix sS(len_free_frames, len_free_frames);
 
-			for (aligned_containers<pair<TCameraPoseID,TLandmarkID>,Matrix_FxF>::map_t::const_iterator it= YW_map.begin(); it!=YW_map.end(); ++it)
-			{
-				const pair<TCameraPoseID,TLandmarkID> & ids = it->first;
-				const Matrix_FxF & YW = it->second;
-				sS.insert_submatrix(ids.first*FrameDof,ids.second*FrameDof, YW);
-			}
-			profiler.leave("sS:fill");
+				for (aligned_containers<pair<TCameraPoseID,TLandmarkID>,Matrix_FxF>::map_t::const_iterator it= YW_map.begin(); it!=YW_map.end(); ++it)
+				{
+					const pair<TCameraPoseID,TLandmarkID> & ids = it->first;
+					const Matrix_FxF & YW = it->second;
+					sS.insert_submatrix(ids.first*FrameDof,ids.second*FrameDof, YW);
+				}
+				profiler.leave("sS:fill");
 
-			// Compress the sparse matrix:
-			profiler.enter("sS:compress");
-			sS.compressFromTriplet();
-			profiler.leave("sS:compress");
+				// Compress the sparse matrix:
+				profiler.enter("sS:compress");
+				sS.compressFromTriplet();
+				profiler.leave("sS:compress");
 
-			try
-			{
-				profiler.enter("sS:chol");
-				if (!ptrCh.get())
-						ptrCh = SparseCholDecompPtr(new CSparseMatrix::CholeskyDecomp(sS) );
-				else ptrCh.get()->update(sS);
-				profiler.leave("sS:chol");
-
-				profiler.enter("sS:backsub");
-				CVectorDouble  bck_res;
-				ptrCh->backsub(e, bck_res);  // Ax = b -->  delta= x*
-				::memcpy(&delta[0],&bck_res[0],bck_res.size()*sizeof(bck_res[0]));	// delta.slice(0,...) = Ch.backsub(e);
-				profiler.leave("sS:backsub");
-				profiler.leave("sS:ALL");
+				try
+				{
+					profiler.enter("sS:chol");
+					if (!ptrCh.get())
+							ptrCh = SparseCholDecompPtr(new CSparseMatrix::CholeskyDecomp(sS) );
+					else ptrCh.get()->update(sS);
+					profiler.leave("sS:chol");
+
+					profiler.enter("sS:backsub");
+					CVectorDouble  bck_res;
+					ptrCh->backsub(e, bck_res);  // Ax = b -->  delta= x*
+					::memcpy(&delta[0],&bck_res[0],bck_res.size()*sizeof(bck_res[0]));	// delta.slice(0,...) = Ch.backsub(e);
+					profiler.leave("sS:backsub");
+					profiler.leave("sS:ALL");
+				}
+				catch (CExceptionNotDefPos &)
+				{
+					profiler.leave("sS:ALL");
+					solved = false;
+				}
 			}
-			catch (CExceptionNotDefPos &)
+
+			if (!solved)
 			{
-				profiler.leave("sS:ALL");
+				profiler.leave("COMPLETE_ITER");
 				// not positive definite so increase mu and try again
 				mu *= nu;
 				nu *= 2.;
@@ -354,19 +493,18 @@ double mrpt::vision::bundle_adj_full(
 			{
 				Array_P tmp = eps_point[i]; // eps_point.slice(PointDof*i,PointDof);
 
-				for (size_t j=0; j<num_free_frames; ++j)
+				// Only the frames observing this point have W_ij!=0:
+				const vector<WMap::iterator> &iters = W_entries[i+num_fix_points];
+				for (size_t itIdx=0; itIdx<iters.size(); itIdx++)
 				{
-					WMap::iterator W_ij;
-					W_ij = W.find(make_pair<TCameraPoseID,TLandmarkID>(j+num_fix_frames,i+num_fix_points));
-
-					if (W_ij!=W.end())
-					{
-						//tmp -= W_ij->second.T() * delta.slice(j*FrameDof,FrameDof);
-						const Array_F  v( &delta[j*FrameDof] );
-						Array_P  r;
-						W_ij->second.multiply_Atb(v, r); // r= A^t * v
-						tmp-=r;
-					}
+					const WMap::iterator &W_ij = iters[itIdx];
+					const size_t j = W_ij->first.first - num_fix_frames;
+
+					//tmp -= W_ij->second.T() * delta.slice(j*FrameDof,FrameDof);
+					const Array_F  v( &delta[j*FrameDof] );
+					Array_P  r;
+					W_ij->second.multiply_Atb(v, r); // r= A^t * v
+					tmp-=r;
 				}
 				Array_P Vi_tmp;
 				V_inv[i].multiply_Ab(tmp, Vi_tmp); // Vi_tmp = V_inv[i] * tmp
@@ -399,14 +537,15 @@ double mrpt::vision::bundle_adj_full(
 			vector<double>   new_kernel_1st_deriv(num_obs);
 
 			profiler.enter("reprojectionResiduals");
-			double res_new = mrpt::vision::reprojectionResiduals(
+			double res_new = ba_reprojection_residuals(
 								 observations, camera_params,
 								 new_frame_poses, new_landmark_points,
 								 new_residual_vec,
 								 INV_POSES_BOOL, // are poses inverse?
 								 use_robust_kernel,
 								 kernel_param,
-								 use_robust_kernel ? &new_kernel_1st_deriv : NULL );
+								 use_robust_kernel ? &new_kernel_1st_deriv : NULL,
+								 num_threads );
 			profiler.leave("reprojectionResiduals");
 
 			MRPT_CHECK_NORMAL_NUMBER(res_new)
@@ -428,7 +567,7 @@ double mrpt::vision::bundle_adj_full(
 				res = res_new;
 
 				profiler.enter("compute_Jacobians");
-				ba_compute_Jacobians<INV_POSES_BOOL>(frame_poses, landmark_points, camera_params, jac_data_vec, num_fix_frames, num_fix_points);
+				ba_compute_Jacobians<INV_POSES_BOOL>(frame_poses, landmark_points, camera_params, jac_data_vec, num_fix_frames, num_fix_points, num_threads);
 				profiler.leave("compute_Jacobians");
 
 
@@ -464,6 +603,8 @@ double mrpt::vision::bundle_adj_full(
 		}
 		while(!has_improved && !stop);
 
+		VERBOSE_COUT << "iteration " << iter << " took " << 1e3*iter_timer.Tac() << " ms" << endl;
+
 		if (stop)
 			break;
 
@@ -15,6 +15,7 @@
 #include <mrpt/poses/CPose3D.h>
 #include <mrpt/utils/aligned_containers.h>
 #include <mrpt/vision/types.h>
+#include <mrpt/system/threads.h>
 
 // Declarations shared between ba_*.cpp files, but which are private to MRPT
 //  not to be seen by an MRPT API user.
@@ -158,10 +159,62 @@ namespace mrpt
 			out_J.multiply_AB(tmp, dp_point);
 		}
 
+		/** Minimum number of observations per thread worth spawning a new thread for */
+		const size_t BA_MIN_OBS_PER_THREAD = 2048;
+
+		/** Number of threads to use for N elements, given the user-requested number (0=as many as CPU cores) */
+		inline unsigned int ba_num_threads(unsigned int requested, const size_t N)
+		{
+			if (!requested) requested = mrpt::system::getNumberOfProcessors();
+			return static_cast<unsigned int>( std::max<size_t>(1, std::min<size_t>(requested, N/BA_MIN_OBS_PER_THREAD)) );
+		}
+
+		template <bool POSES_ARE_INVERSE>
+		struct TComputeJacobiansBlock
+		{
+			const TFramePosesVec         & frame_poses;
+			const TLandmarkLocationsVec  & landmark_points;
+			const mrpt::utils::TCamera   & camera_params;
+			mrpt::aligned_containers<JacData<6,3,2> >::vector_t & jac_data_vec;
+			const size_t num_fix_frames, num_fix_points;
+
+			TComputeJacobiansBlock(const TFramePosesVec &fp, const TLandmarkLocationsVec &lp, const mrpt::utils::TCamera &cp,
+				mrpt::aligned_containers<JacData<6,3,2> >::vector_t &jd, size_t nff, size_t nfp) :
+				frame_poses(fp), landmark_points(lp), camera_params(cp), jac_data_vec(jd), num_fix_frames(nff), num_fix_points(nfp)
+			{}
+
+			void operator()(size_t first, size_t last, unsigned int)
+			{
+				for (size_t i=first;i<last;i++)
+				{
+					JacData<6,3,2> &D = jac_data_vec[i];
+
+					const TCameraPoseID  i_f = D.frame_id;
+					const TLandmarkID    i_p = D.point_id;
+
+					ASSERTDEB_(i_f<frame_poses.size())
+					ASSERTDEB_(i_p<landmark_points.size())
+
+					if (i_f>=num_fix_frames)
+					{
+						frameJac<POSES_ARE_INVERSE>(camera_params, frame_poses[i_f], landmark_points[i_p], D.J_frame);
+						D.J_frame_valid = true;
+					}
+
+					if (i_p>=num_fix_points)
+					{
+						pointJac<POSES_ARE_INVERSE>(camera_params, frame_poses[i_f], landmark_points[i_p], D.J_point);
+						D.J_point_valid = true;
+					}
+				}
+			}
+		};
+
 		// === Compute sparse Jacobians ====
 		// Case: 6D poses + 3D points + 2D (x,y) observations
 		// For the case of *inverse* or *normal* frame poses being estimated.
 		// Made inline so immediate values in "poses_are_inverses" are propragated by the compiler
+		// Observations are independent, so they are split among `num_threads` threads (0=as many as CPU cores).
 		template <bool POSES_ARE_INVERSE>
 		void ba_compute_Jacobians(
 			const TFramePosesVec         & frame_poses,
@@ -169,7 +222,8 @@ namespace mrpt
 			const mrpt::utils::TCamera   & camera_params,
 			mrpt::aligned_containers<JacData<6,3,2> >::vector_t & jac_data_vec,
 			const size_t                   num_fix_frames,
-			const size_t                   num_fix_points)
+			const size_t                   num_fix_points,
+			const unsigned int             num_threads = 1)
 		{
 			MRPT_START
 
@@ -178,31 +232,25 @@ namespace mrpt
 
 			const size_t N = jac_data_vec.size();
 
-			for (size_t i=0;i<N;i++)
-			{
-				JacData<6,3,2> &D = jac_data_vec[i];
-
-				const TCameraPoseID  i_f = D.frame_id;
-				const TLandmarkID    i_p = D.point_id;
-
-				ASSERTDEB_(i_f<frame_poses.size())
-				ASSERTDEB_(i_p<landmark_points.size())
-
-				if (i_f>=num_fix_frames)
-				{
-					frameJac<POSES_ARE_INVERSE>(camera_params, frame_poses[i_f], landmark_points[i_p], D.J_frame);
-					D.J_frame_valid = true;
-				}
-
-				if (i_p>=num_fix_points)
-				{
-					pointJac<POSES_ARE_INVERSE>(camera_params, frame_poses[i_f], landmark_points[i_p], D.J_point);
-					D.J_point_valid = true;
-				}
-			}
+			TComputeJacobiansBlock<POSES_ARE_INVERSE> functor(frame_poses, landmark_points, camera_params, jac_data_vec, num_fix_frames, num_fix_points);
+			mrpt::system::parallelForBlocks(N, functor, ba_num_threads(num_threads,N));
 			MRPT_END
 		}
 
+		/** Like mrpt::vision::reprojectionResiduals(), with observations split among `num_threads` threads (0=as many as CPU cores).
+		  *  The partial sums of each thread are added up in order. */
+		double ba_reprojection_residuals(
+			const TSequenceFeatureObservations   & observations,
+			const mrpt::utils::TCamera           & camera_params,
+			const TFramePosesVec                 & frame_poses,
+			const TLandmarkLocationsVec          & landmark_points,
+			std::vector<mrpt::math::CArray<double,2> > & out_residuals,
+			const bool  frame_poses_are_inverse,
+			const bool  use_robust_kernel,
+			const double kernel_param,
+			std::vector<double> * out_kernel_1st_deriv,
+			const unsigned int num_threads );
+
 		/** Construct the BA linear system.
 		  *  Set kernel_1st_deriv!=NULL if using robust kernel.
 		  */
@@ -0,0 +1,139 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/bundle_adjustment.h>
+#include <mrpt/vision/pinhole.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::math;
+using namespace mrpt::poses;
+using namespace std;
+
+namespace
+{
+	// A small synthetic problem, as in the sample "bundle_adj_full_demo": cameras along a line looking at a box of points
+	struct TBAProblem
+	{
+		TCamera                       camera_params;
+		TSequenceFeatureObservations  obs;
+		TFramePosesVec                frame_poses, frame_poses_real;
+		TLandmarkLocationsVec         landmark_points, landmark_points_real;
+
+		TBAProblem()
+		{
+			mrpt::random::CRandomGenerator rg(1234);
+
+			camera_params.ncols = 800;
+			camera_params.nrows = 600;
+			camera_params.fx(400); camera_params.fy(400);
+			camera_params.cx(400); camera_params.cy(300);
+
+			const size_t nPts = 60;
+			const double L1 = 30, L2 = 5, L3 = 5;
+			landmark_points_real.resize(nPts);
+			for (size_t i=0;i<nPts;i++)
+				landmark_points_real[i] = TPoint3D( rg.drawUniform(-L1,L1), rg.drawUniform(-L2,L2), rg.drawUniform(-L3,L3) );
+
+			const double cameraPathLen = L1*1.2;
+			for (double x=-cameraPathLen;x<cameraPathLen;x+=2*cameraPathLen/10)
+			{
+				const TPose3D p(x,4*L2,0, DEG2RAD(-90) - DEG2RAD(30)*x/cameraPathLen,0,0);
+				frame_poses_real.push_back( CPose3D(p) + CPose3D(0,0,0,DEG2RAD(-90), 0, DEG2RAD(-90)) );
+			}
+
+			for (size_t i=0;i<frame_poses_real.size();i++)
+				for (size_t j=0;j<nPts;j++)
+				{
+					TPixelCoordf px = mrpt::vision::pinhole::projectPoint_no_distortion<false>(camera_params, frame_poses_real[i], landmark_points_real[j]);
+					px.x += rg.drawGaussian1D(0,0.1);
+					px.y += rg.drawGaussian1D(0,0.1);
+					if (px.x<0 || px.y<0 || px.x>camera_params.ncols || px.y>camera_params.nrows)
+						continue;
+					obs.push_back( TFeatureObservation(j,i, px) );
+				}
+
+			// Noisy initial guess (the first two frames are the fixed reference):
+			frame_poses = frame_poses_real;
+			landmark_points = landmark_points_real;
+			for (size_t i=0;i<nPts;i++)
+				landmark_points[i] += TPoint3D( rg.drawGaussian1D(0,0.1),rg.drawGaussian1D(0,0.1),rg.drawGaussian1D(0,0.1) );
+			for (size_t i=2;i<frame_poses.size();i++)
+				frame_poses[i].setFromValues(
+					frame_poses[i].x() + rg.drawGaussian1D(0,0.05),
+					frame_poses[i].y() + rg.drawGaussian1D(0,0.05),
+					frame_poses[i].z() + rg.drawGaussian1D(0,0.05),
+					frame_poses[i].yaw()   + rg.drawGaussian1D(0,DEG2RAD(2)),
+					frame_poses[i].pitch() + rg.drawGaussian1D(0,DEG2RAD(2)),
+					frame_poses[i].roll()  + rg.drawGaussian1D(0,DEG2RAD(2)) );
+		}
+	};
+
+	double run_ba(TBAProblem &pb, bool use_pcg, unsigned int num_threads, size_t pcg_max_iterations = 500)
+	{
+		TParametersDouble extra_params;
+		extra_params["max_iterations"] = 50;
+		extra_params["num_fix_frames"] = 2;  // Also fixes the scale, so the solution is unique
+		extra_params["num_threads"] = num_threads;
+		extra_params["use_pcg"] = use_pcg ? 1 : 0;
+		extra_params["pcg_max_iterations"] = pcg_max_iterations;
+		return mrpt::vision::bundle_adj_full(pb.obs, pb.camera_params, pb.frame_poses, pb.landmark_points, extra_params);
+	}
+
+	void expect_same_solution(const TBAProblem &a, const TBAProblem &b, double tol, const std::string &msg)
+	{
+		ASSERT_EQ(a.frame_poses.size(), b.frame_poses.size());
+		ASSERT_EQ(a.landmark_points.size(), b.landmark_points.size());
+		for (size_t i=0;i<a.frame_poses.size();i++)
+		{
+			CArrayDouble<12> pa, pb;
+			a.frame_poses[i].getAs12Vector(pa);
+			b.frame_poses[i].getAs12Vector(pb);
+			for (int k=0;k<12;k++)
+				EXPECT_NEAR(pa[k],pb[k],tol) << msg << " frame=" << i;
+		}
+		for (size_t i=0;i<a.landmark_points.size();i++)
+			EXPECT_NEAR(a.landmark_points[i].distanceTo(b.landmark_points[i]),0,tol) << msg << " point=" << i;
+	}
+}
+
+TEST(bundle_adj_full, CholeskyConverges)
+{
+	TBAProblem pb;
+	const double sq_err = run_ba(pb,false,1);
+	// Final error consistent with the 0.1 px noise:
+	EXPECT_LT(std::sqrt(sq_err/pb.obs.size()), 0.5);
+	for (size_t i=0;i<pb.landmark_points.size();i++)
+		EXPECT_LT(pb.landmark_points[i].distanceTo(pb.landmark_points_real[i]), 0.5) << "point=" << i;
+}
+
+TEST(bundle_adj_full, ThreadsAndPCGGiveSameResults)
+{
+	TBAProblem chol1, cholN, pcg1, pcgN;
+	run_ba(chol1,false,1);
+	run_ba(cholN,false,4);
+	run_ba(pcg1, true, 1);
+	run_ba(pcgN, true, 4);
+
+	expect_same_solution(chol1,cholN,1e-6,"Cholesky, 4 threads");
+	expect_same_solution(chol1,pcg1, 1e-4,"PCG, 1 thread");
+	expect_same_solution(chol1,pcgN, 1e-4,"PCG, 4 threads");
+}
+
+TEST(bundle_adj_full, PCGFallsBackToCholeskyIfNotConverged)
+{
+	// A single PCG iteration is not enough: each system must then be solved by Cholesky
+	TBAProblem chol, pcg;
+	run_ba(chol,false,1);
+	run_ba(pcg,true,1, 1 /* pcg_max_iterations */);
+	expect_same_solution(chol,pcg,1e-6,"PCG with 1 iteration");
+}
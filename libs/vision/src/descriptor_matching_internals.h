@@ -0,0 +1,165 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#ifndef descriptor_matching_internals_H
+#define descriptor_matching_internals_H
+
+#include <mrpt/vision/descriptor_pairing.h>
+#include <mrpt/system/threads.h>
+#include <mrpt/utils/types_math.h>
+#include <mrpt/config.h>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+// popcnt comes with SSE4.2 (-msse4.2 in GCC/clang, which defines __POPCNT__):
+#if (defined(__POPCNT__) && defined(__x86_64__)) || (MRPT_HAS_SSE4_2 && defined(_M_X64))
+#	include <nmmintrin.h>
+#	define MRPT_DESC_POPCNT64(_x)  static_cast<unsigned int>(_mm_popcnt_u64(_x))
+#elif defined(__GNUC__)
+#	define MRPT_DESC_POPCNT64(_x)  static_cast<unsigned int>(__builtin_popcountll(_x))
+#endif
+
+// Brute-force descriptor matching engine shared by descriptor_pairing.cpp and
+//  vision_utils.cpp (matchFeatures), private to MRPT.
+
+namespace mrpt
+{
+	namespace vision
+	{
+		namespace detail
+		{
+			/** Minimum number of descriptor pairs per thread worth spawning a new thread for */
+			const size_t MIN_DESC_PAIRS_PER_THREAD = 64*1024;
+
+			inline unsigned int popcount64(uint64_t x)
+			{
+#ifdef MRPT_DESC_POPCNT64
+				return MRPT_DESC_POPCNT64(x);
+#else
+				x = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+				x = (x & UINT64_C(0x3333333333333333)) + ((x >> 2) & UINT64_C(0x3333333333333333));
+				x = (x + (x >> 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+				return static_cast<unsigned int>((x * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+			}
+
+			/** Hamming distance between two binary descriptors of `len` bytes */
+			inline unsigned int hammingDistance(const uint8_t *a, const uint8_t *b, const size_t len)
+			{
+				unsigned int dist = 0;
+				size_t k = 0;
+				for (;k+8<=len;k+=8)
+				{
+					uint64_t va,vb;
+					::memcpy(&va,a+k,8); // memcpy(): descriptors are not necessarily 8-byte aligned
+					::memcpy(&vb,b+k,8);
+					dist += popcount64(va ^ vb);
+				}
+				for (;k<len;k++)
+					dist += popcount64(static_cast<uint64_t>(a[k] ^ b[k]));
+				return dist;
+			}
+
+			struct THammingDistance
+			{
+				const uint8_t *descs1, *descs2;
+				size_t len;
+				THammingDistance(const uint8_t *d1, const uint8_t *d2, size_t l) : descs1(d1), descs2(d2), len(l) {}
+				inline float operator()(size_t i, size_t j) const {
+					return static_cast<float>( hammingDistance(descs1+i*len,descs2+j*len,len) );
+				}
+			};
+
+			/** Returns the *squared* Euclidean distance, so the square root is only taken for the two final winners.
+			  *  T can be float (SURF) or uint8_t (SIFT), which is evaluated in floating point too. */
+			template <typename T>
+			struct TSquaredL2Distance
+			{
+				const T *descs1, *descs2;
+				size_t len;
+				TSquaredL2Distance(const T *d1, const T *d2, size_t l) : descs1(d1), descs2(d2), len(l) {}
+				inline float operator()(size_t i, size_t j) const {
+					typedef Eigen::Map<const Eigen::Matrix<T,Eigen::Dynamic,1> > TMap;
+					return ( TMap(descs1+i*len,len).template cast<float>() - TMap(descs2+j*len,len).template cast<float>() ).squaredNorm();
+				}
+			};
+
+			/** Pair filter which accepts all the pairs */
+			struct TAcceptAllPairs
+			{
+				inline bool operator()(size_t, size_t) const { return true; }
+			};
+
+			/** Each block of query descriptors (rows of set #1) is scanned against the whole set #2 */
+			template <class DISTANCE, class PAIR_FILTER>
+			struct TFindBestMatchesBlock
+			{
+				const DISTANCE &dist;
+				const PAIR_FILTER &filter;
+				const size_t n2;
+				std::vector<TDescriptorMatchCandidate> &out;
+
+				TFindBestMatchesBlock(const DISTANCE &d, const PAIR_FILTER &f, size_t n2_, std::vector<TDescriptorMatchCandidate> &out_) :
+					dist(d), filter(f), n2(n2_), out(out_)
+				{}
+
+				void operator()(size_t first, size_t last, unsigned int)
+				{
+					for (size_t i=first;i<last;i++)
+					{
+						TDescriptorMatchCandidate &m = out[i];
+						m = TDescriptorMatchCandidate();
+						for (size_t j=0;j<n2;j++)
+						{
+							if (!filter(i,j)) continue;
+							const float d = dist(i,j);
+							if (d<m.dist1)
+							{
+								m.dist2 = m.dist1;
+								m.dist1 = d;
+								m.idx = static_cast<int>(j);
+							}
+							else if (d<m.dist2)
+								m.dist2 = d;
+						}
+					}
+				}
+			};
+
+			/** Runs the brute-force search for the best two neighbors of each descriptor in set #1, in parallel blocks of rows. */
+			template <class DISTANCE, class PAIR_FILTER>
+			void findBestMatches(const DISTANCE &dist, const PAIR_FILTER &filter, const size_t n1, const size_t n2, std::vector<TDescriptorMatchCandidate> &out, unsigned int num_threads)
+			{
+				out.resize(n1);
+				if (!num_threads) num_threads = mrpt::system::getNumberOfProcessors();
+				const size_t max_useful_threads = std::max<size_t>(1, (n1*n2)/MIN_DESC_PAIRS_PER_THREAD);
+				num_threads = static_cast<unsigned int>( std::min<size_t>(num_threads, max_useful_threads) );
+
+				TFindBestMatchesBlock<DISTANCE,PAIR_FILTER> functor(dist,filter,n2,out);
+				mrpt::system::parallelForBlocks(n1,functor,num_threads);
+			}
+
+			/** Converts squared Euclidean distances into scaled Euclidean ones, keeping the "no candidate" markers */
+			inline void sqrtMatchDistances(std::vector<TDescriptorMatchCandidate> &matches, const float scale = 1.0f)
+			{
+				const float NO_DIST = std::numeric_limits<float>::max();
+				for (size_t i=0;i<matches.size();i++)
+				{
+					TDescriptorMatchCandidate &m = matches[i];
+					if (m.dist1!=NO_DIST) m.dist1 = std::sqrt(m.dist1)*scale;
+					if (m.dist2!=NO_DIST) m.dist2 = std::sqrt(m.dist2)*scale;
+				}
+			}
+
+		} // end detail
+	}
+}
+
+#endif
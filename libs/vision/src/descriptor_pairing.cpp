@@ -0,0 +1,117 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"   // Precompiled headers
+#include <mrpt/vision/descriptor_pairing.h>
+#include "descriptor_matching_internals.h"
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace std;
+
+namespace
+{
+	/** Common implementation of packDescriptors*(): DESCRIPTOR_GETTER returns a reference to the descriptor vector of a feature */
+	template <typename T, class DESCRIPTOR_GETTER>
+	void packDescriptors(const CFeatureList &list, std::vector<T> &out_descs, size_t &out_desc_len, const DESCRIPTOR_GETTER &getter, const char *desc_name)
+	{
+		const size_t N = list.size();
+		out_desc_len = N ? getter(*list[0]).size() : 0;
+		out_descs.resize(N*out_desc_len);
+		for (size_t i=0;i<N;i++)
+		{
+			const std::vector<typename DESCRIPTOR_GETTER::value_type> &d = getter(*list[i]);
+			if (d.empty() || d.size()!=out_desc_len)
+				THROW_EXCEPTION_CUSTOM_MSG1("All features must have %s descriptors of the same length",desc_name)
+			std::copy(d.begin(),d.end(),out_descs.begin()+i*out_desc_len);
+		}
+	}
+
+	struct TGetORB  { typedef uint8_t value_type; const std::vector<uint8_t> & operator()(const CFeature &f) const { return f.descriptors.ORB; } };
+	struct TGetSIFT { typedef uint8_t value_type; const std::vector<uint8_t> & operator()(const CFeature &f) const { return f.descriptors.SIFT; } };
+	struct TGetSURF { typedef float   value_type; const std::vector<float>   & operator()(const CFeature &f) const { return f.descriptors.SURF; } };
+}
+
+void vision::packDescriptorsORB(const CFeatureList &list, std::vector<uint8_t> &out_descs, size_t &out_desc_len)
+{
+	packDescriptors(list,out_descs,out_desc_len,TGetORB(),"ORB");
+}
+
+void vision::packDescriptorsSIFT(const CFeatureList &list, std::vector<float> &out_descs, size_t &out_desc_len)
+{
+	packDescriptors(list,out_descs,out_desc_len,TGetSIFT(),"SIFT");
+}
+
+void vision::packDescriptorsSURF(const CFeatureList &list, std::vector<float> &out_descs, size_t &out_desc_len)
+{
+	packDescriptors(list,out_descs,out_desc_len,TGetSURF(),"SURF");
+}
+
+void vision::findDescriptorMatchesHamming(
+	const uint8_t *descs1, const size_t n1,
+	const uint8_t *descs2, const size_t n2,
+	const size_t desc_len,
+	std::vector<TDescriptorMatchCandidate> &out_matches,
+	const unsigned int num_threads )
+{
+	MRPT_START
+	ASSERT_( (descs1!=NULL || n1==0) && (descs2!=NULL || n2==0) )
+
+	detail::findBestMatches(
+		detail::THammingDistance(descs1,descs2,desc_len), detail::TAcceptAllPairs(),
+		n1, n2, out_matches, num_threads);
+	MRPT_END
+}
+
+void vision::findDescriptorMatchesL2(
+	const float *descs1, const size_t n1,
+	const float *descs2, const size_t n2,
+	const size_t desc_len,
+	std::vector<TDescriptorMatchCandidate> &out_matches,
+	const unsigned int num_threads )
+{
+	MRPT_START
+	ASSERT_( (descs1!=NULL || n1==0) && (descs2!=NULL || n2==0) )
+
+	detail::findBestMatches(
+		detail::TSquaredL2Distance<float>(descs1,descs2,desc_len), detail::TAcceptAllPairs(),
+		n1, n2, out_matches, num_threads);
+	detail::sqrtMatchDistances(out_matches);
+	MRPT_END
+}
+
+size_t vision::filterDescriptorMatches(
+	const std::vector<TDescriptorMatchCandidate> &matches_1_to_2,
+	const std::vector<TDescriptorMatchCandidate> *matches_2_to_1,
+	const float max_distance,
+	const float max_ratio,
+	std::vector<std::pair<size_t,size_t> > &out_pairings )
+{
+	out_pairings.clear();
+	out_pairings.reserve(matches_1_to_2.size());
+
+	for (size_t i=0;i<matches_1_to_2.size();i++)
+	{
+		const TDescriptorMatchCandidate &m = matches_1_to_2[i];
+		if (m.idx<0 || m.dist1>=max_distance)
+			continue;
+		// Ratio test (written as a product to also handle dist2==0):
+		if (max_ratio<1.0f && !(m.dist1 < max_ratio*m.dist2))
+			continue;
+		// Cross-check:
+		if (matches_2_to_1)
+		{
+			ASSERT_( static_cast<size_t>(m.idx) < matches_2_to_1->size() )
+			if ( (*matches_2_to_1)[m.idx].idx != static_cast<int>(i) )
+				continue;
+		}
+		out_pairings.push_back( std::make_pair(i, static_cast<size_t>(m.idx)) );
+	}
+	return out_pairings.size();
+}
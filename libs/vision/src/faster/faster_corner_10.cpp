@@ -51,7 +51,7 @@ void faster_corner_detect_10(const IplImage* I, mrpt::vision::TSimpleFeatureList
 		*ptr_feat_index_by_row++ = corners.size();
 	}
 
-	const int w = I->width;
+	const int w = I->widthStep; // Row stride, which may differ from the width for ROIs and tile views
 	const int stride = 3*I->widthStep; // 3*w;
 
 	// The compiler refuses to reserve a register for this
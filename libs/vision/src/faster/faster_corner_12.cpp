@@ -82,6 +82,7 @@ void faster_corner_detect_12(const IplImage* I, mrpt::vision::TSimpleFeatureList
 	}
 
 const int w = I->width;
+const int row_stride = I->widthStep;
 const int stride = 3*I->widthStep; // 3*w;
 typedef std::list<const uint8_t*> Passed;
 Passed passed;
@@ -121,7 +122,7 @@ for (int i=3; i<I->height-3; ++i) {
 		}
 		const unsigned int at_least_three = (either_ud & (left_flags & right_flags)) | (both_ud & (left_flags | right_flags));
 		if (at_least_three) {
-		    process_16<4>(at_least_three, p, w, barrier, passed);
+		    process_16<4>(at_least_three, p, row_stride, barrier, passed);
 		}
 	    }
 	}
@@ -149,7 +150,7 @@ for (int i=3; i<I->height-3; ++i) {
 
 
 	    //Only do a complete check if num_above is 3
-	    if((num_above&1) && is_corner_12<Greater>(p, w, barrier))
+	    if((num_above&1) && is_corner_12<Greater>(p, row_stride, barrier))
 	    	passed.push_back(p);
 	}
 	else if(num_below & 2)
@@ -158,7 +159,7 @@ for (int i=3; i<I->height-3; ++i) {
 		num_below += p[3] < c_b;
 
 
-	    if((num_below&1) && is_corner_12<Less>(p, w, barrier))
+	    if((num_below&1) && is_corner_12<Less>(p, row_stride, barrier))
 	    	passed.push_back(p);
 	}
     }
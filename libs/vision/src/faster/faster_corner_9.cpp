@@ -43,7 +43,7 @@ void faster_corner_detect_9(const IplImage* I, mrpt::vision::TSimpleFeatureList
 		ptr_feat_index_by_row = NULL;
 	}
 
-	const int w = I->width;
+	const int w = I->widthStep; // Row stride, which may differ from the width for ROIs and tile views
 	const int stride = 3*I->widthStep; // 3*w;
 
 	// The compiler refuses to reserve a register for this
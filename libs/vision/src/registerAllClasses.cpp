@@ -32,6 +32,7 @@ void registerAllClasses_mrpt_vision()
 {
 #if !defined(DISABLE_MRPT_AUTO_CLASS_REGISTRATION)
 	registerClass( CLASS_ID( CFeature ) );
+	registerClass( CLASS_ID( CBinaryVocabulary ) );
 
 	registerClass( CLASS_ID( CLandmark ) );
 	registerClass( CLASS_ID( CLandmarksMap ) );
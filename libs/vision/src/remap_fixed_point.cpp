@@ -0,0 +1,212 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"   // Precompiled headers
+#include <mrpt/system/threads.h>
+#include <mrpt/utils/SSE_types.h>
+#include <cstring>
+#include "remap_internals.h"
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::vision::detail;
+
+namespace
+{
+	/** Minimum number of rows per thread worth spawning a new thread for */
+	const size_t MIN_REMAP_ROWS_PER_THREAD = 32;
+
+	/** Fixed-point bilinear weights (w00,w01,w10,w11), adding up to 2^WEIGHT_BITS, for each fractional index of the maps */
+	const int WEIGHT_BITS = 2*REMAP_INTER_BITS;
+	const int WEIGHT_ROUND = 1<<(WEIGHT_BITS-1);
+
+	struct TBilinearWeightsTable
+	{
+		MRPT_ALIGN16 int16_t w[REMAP_INTER_TAB_SIZE*REMAP_INTER_TAB_SIZE][4];
+
+		TBilinearWeightsTable()
+		{
+			for (int fy=0;fy<REMAP_INTER_TAB_SIZE;fy++)
+				for (int fx=0;fx<REMAP_INTER_TAB_SIZE;fx++)
+				{
+					int16_t *W = w[(fy<<REMAP_INTER_BITS)|fx];
+					W[0] = static_cast<int16_t>( (REMAP_INTER_TAB_SIZE-fx)*(REMAP_INTER_TAB_SIZE-fy) );
+					W[1] = static_cast<int16_t>( fx*(REMAP_INTER_TAB_SIZE-fy) );
+					W[2] = static_cast<int16_t>( (REMAP_INTER_TAB_SIZE-fx)*fy );
+					W[3] = static_cast<int16_t>( fx*fy );
+				}
+		}
+	};
+	const TBilinearWeightsTable bilinear_weights;
+
+	const unsigned int FRAC_MASK = REMAP_INTER_TAB_SIZE*REMAP_INTER_TAB_SIZE-1;
+
+	/** Bilinear interpolation of one pixel (all its channels), taking zeros for source pixels out of the image */
+	inline void remapPixelBilinear(const TRemapJob &job, const int x, const int y, const int16_t *W, uint8_t *out)
+	{
+		const int nCh = job.nChannels;
+		if (static_cast<unsigned int>(x)<static_cast<unsigned int>(job.src_width-1) && static_cast<unsigned int>(y)<static_cast<unsigned int>(job.src_height-1))
+		{
+			const uint8_t *p0 = job.src + y*job.src_stride + x*nCh;
+			const uint8_t *p1 = p0 + job.src_stride;
+			for (int ch=0;ch<nCh;ch++)
+				out[ch] = static_cast<uint8_t>( (p0[ch]*W[0] + p0[ch+nCh]*W[1] + p1[ch]*W[2] + p1[ch+nCh]*W[3] + WEIGHT_ROUND) >> WEIGHT_BITS );
+		}
+		else
+		{
+			// Border: out-of-image neighbors count as zeros:
+			const bool x0_ok = x>=0   && x<job.src_width,   x1_ok = x+1>=0 && x+1<job.src_width;
+			const bool y0_ok = y>=0   && y<job.src_height,  y1_ok = y+1>=0 && y+1<job.src_height;
+			for (int ch=0;ch<nCh;ch++)
+			{
+				int v = WEIGHT_ROUND;
+				if (y0_ok)
+				{
+					const uint8_t *p = job.src + y*job.src_stride + ch;
+					if (x0_ok) v += p[x*nCh]*W[0];
+					if (x1_ok) v += p[(x+1)*nCh]*W[1];
+				}
+				if (y1_ok)
+				{
+					const uint8_t *p = job.src + (y+1)*job.src_stride + ch;
+					if (x0_ok) v += p[x*nCh]*W[2];
+					if (x1_ok) v += p[(x+1)*nCh]*W[3];
+				}
+				out[ch] = static_cast<uint8_t>(v >> WEIGHT_BITS);
+			}
+		}
+	}
+
+	void remapRowBilinear(const TRemapJob &job, const int row)
+	{
+		const int16_t  *mxy = job.map_xy + 2*static_cast<size_t>(row)*job.dst_width;
+		const uint16_t *mfr = job.map_frac + static_cast<size_t>(row)*job.dst_width;
+		uint8_t *out = job.dst + row*job.dst_stride;
+		const int nCh = job.nChannels;
+
+		int c = 0;
+#if MRPT_HAS_SSE2
+		if (nCh==1)
+		{
+			// 4 pixels at once: gather the 2x2 neighborhoods as int16 and compute the weighted sums with _mm_madd_epi16():
+			const unsigned int max_x = job.src_width-1, max_y = job.src_height-1;
+			const size_t S = job.src_stride;
+			MRPT_ALIGN16 int16_t px[16];
+			for (;c+4<=job.dst_width;c+=4)
+			{
+				bool all_inside = true;
+				for (int k=0;k<4;k++)
+					all_inside = all_inside && static_cast<unsigned int>(mxy[2*(c+k)])<max_x && static_cast<unsigned int>(mxy[2*(c+k)+1])<max_y;
+				if (!all_inside)
+				{
+					for (int k=0;k<4;k++)
+						remapPixelBilinear(job, mxy[2*(c+k)], mxy[2*(c+k)+1], bilinear_weights.w[mfr[c+k] & FRAC_MASK], out+c+k);
+					continue;
+				}
+				for (int k=0;k<4;k++)
+				{
+					const uint8_t *p = job.src + mxy[2*(c+k)+1]*S + mxy[2*(c+k)];
+					px[4*k+0] = p[0];
+					px[4*k+1] = p[1];
+					px[4*k+2] = p[S];
+					px[4*k+3] = p[S+1];
+				}
+				const __m128i w01 = _mm_unpacklo_epi64(
+					_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bilinear_weights.w[mfr[c+0] & FRAC_MASK])),
+					_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bilinear_weights.w[mfr[c+1] & FRAC_MASK])) );
+				const __m128i w23 = _mm_unpacklo_epi64(
+					_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bilinear_weights.w[mfr[c+2] & FRAC_MASK])),
+					_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bilinear_weights.w[mfr[c+3] & FRAC_MASK])) );
+
+				// m01 = [top0,bottom0,top1,bottom1], m23 = [top2,bottom2,top3,bottom3]
+				const __m128i m01 = _mm_madd_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(px)),   w01);
+				const __m128i m23 = _mm_madd_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(px+8)), w23);
+				const __m128i tops    = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(m01),_mm_castsi128_ps(m23),_MM_SHUFFLE(2,0,2,0)));
+				const __m128i bottoms = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(m01),_mm_castsi128_ps(m23),_MM_SHUFFLE(3,1,3,1)));
+
+				__m128i sum = _mm_add_epi32(_mm_add_epi32(tops,bottoms), _mm_set1_epi32(WEIGHT_ROUND));
+				sum = _mm_srai_epi32(sum, WEIGHT_BITS);
+				const __m128i sum16 = _mm_packs_epi32(sum,sum);
+				const int res = _mm_cvtsi128_si32(_mm_packus_epi16(sum16,sum16));
+				::memcpy(out+c, &res, 4);
+			}
+		}
+#endif
+		for (;c<job.dst_width;c++)
+			remapPixelBilinear(job, mxy[2*c], mxy[2*c+1], bilinear_weights.w[mfr[c] & FRAC_MASK], out+c*nCh);
+	}
+
+	/** Nearest-neighbor remap of one row: as cv::remap() with INTER_NEAREST, only the integer part of the maps is used (the fractional one is ignored) */
+	void remapRowNearest(const TRemapJob &job, const int row)
+	{
+		const int16_t  *mxy = job.map_xy + 2*static_cast<size_t>(row)*job.dst_width;
+		uint8_t *out = job.dst + row*job.dst_stride;
+		const int nCh = job.nChannels;
+
+		for (int c=0;c<job.dst_width;c++, out+=nCh)
+		{
+			const int x = mxy[2*c];
+			const int y = mxy[2*c+1];
+			if (static_cast<unsigned int>(x)<static_cast<unsigned int>(job.src_width) && static_cast<unsigned int>(y)<static_cast<unsigned int>(job.src_height))
+			{
+				const uint8_t *p = job.src + y*job.src_stride + x*nCh;
+				for (int ch=0;ch<nCh;ch++) out[ch]=p[ch];
+			}
+			else
+			{
+				for (int ch=0;ch<nCh;ch++) out[ch]=0;
+			}
+		}
+	}
+
+	/** Processes a block of rows, indexed as consecutive rows of all the jobs */
+	struct TRemapRowsBlock
+	{
+		const TRemapJob *jobs;
+		const size_t num_jobs;
+		const bool bilinear;
+
+		TRemapRowsBlock(const TRemapJob *j, size_t n, bool bil) : jobs(j), num_jobs(n), bilinear(bil) {}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			size_t job_idx = 0, job_first_row = 0;
+			for (size_t r=first;r<last;r++)
+			{
+				while (r>=job_first_row+jobs[job_idx].dst_height)
+					job_first_row += jobs[job_idx++].dst_height;
+				const int row = static_cast<int>(r-job_first_row);
+				if (bilinear)
+					remapRowBilinear(jobs[job_idx],row);
+				else remapRowNearest(jobs[job_idx],row);
+			}
+		}
+	};
+}
+
+void mrpt::vision::detail::remapFixedPoint(const TRemapJob *jobs, const size_t num_jobs, const bool bilinear, const unsigned int num_threads)
+{
+	MRPT_START
+	size_t total_rows = 0;
+	for (size_t i=0;i<num_jobs;i++)
+	{
+		const TRemapJob &j = jobs[i];
+		ASSERT_(j.src && j.dst && j.map_xy && j.map_frac)
+		ASSERT_(j.nChannels==1 || j.nChannels==3)
+		ASSERT_(j.src!=j.dst)
+		total_rows += j.dst_height;
+	}
+
+	unsigned int nThreads = num_threads ? num_threads : mrpt::system::getNumberOfProcessors();
+	nThreads = static_cast<unsigned int>( std::max<size_t>(1, std::min<size_t>(nThreads, total_rows/MIN_REMAP_ROWS_PER_THREAD)) );
+
+	TRemapRowsBlock functor(jobs,num_jobs,bilinear);
+	mrpt::system::parallelForBlocks(total_rows, functor, nThreads);
+	MRPT_END
+}
@@ -0,0 +1,89 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#ifndef remap_internals_H
+#define remap_internals_H
+
+#include <mrpt/utils/types_simple.h>
+#include <mrpt/utils/mrpt_macros.h>
+#include <cstddef>
+#include <vector>
+
+// Native image remapping with fixed-point maps, shared by CUndistortMap and
+//  CStereoRectifyMap, private to MRPT.
+
+namespace mrpt
+{
+	namespace vision
+	{
+		namespace detail
+		{
+			/** Bits of the fractional part of the fixed-point maps (as OpenCV's INTER_BITS) */
+			const int REMAP_INTER_BITS = 5;
+			const int REMAP_INTER_TAB_SIZE = 1<<REMAP_INTER_BITS;
+
+			/** One image to be remapped with a pair of fixed-point maps in OpenCV's format:
+			  *  - map_xy: (x,y) integer source coordinates of each target pixel (like a CV_16SC2 matrix)
+			  *  - map_frac: (fy<<REMAP_INTER_BITS)|fx fractional parts, in units of 1/REMAP_INTER_TAB_SIZE (like a CV_16UC1 matrix)
+			  *  Both maps have dst_width x dst_height entries. Only 8-bit images are supported. */
+			struct TRemapJob
+			{
+				TRemapJob() : src(NULL),src_width(0),src_height(0),src_stride(0),dst(NULL),dst_width(0),dst_height(0),dst_stride(0),nChannels(1),map_xy(NULL),map_frac(NULL) {}
+
+				const uint8_t *src;
+				int    src_width, src_height;
+				size_t src_stride; //!< In bytes
+				uint8_t *dst;
+				int    dst_width, dst_height;
+				size_t dst_stride; //!< In bytes
+				int    nChannels;  //!< 1 or 3
+				const int16_t  *map_xy;
+				const uint16_t *map_frac;
+			};
+
+			/** Remaps all the images, with bilinear or nearest-neighbor interpolation, and zeros for source pixels out of the image.
+			  *  Nearest-neighbor takes the integer part of the maps (map_frac is ignored), as cv::remap() does with INTER_NEAREST.
+			  *  The rows of all the jobs are processed together in parallel blocks, so several images (e.g. a stereo pair) are remapped concurrently.
+			  * \param num_threads 0=as many as CPU cores. */
+			void remapFixedPoint(const TRemapJob *jobs, const size_t num_jobs, const bool bilinear, const unsigned int num_threads);
+
+			/** Fills a TRemapJob from an OpenCV IplImage pair (the template avoids depending on OpenCV headers here).
+			  * \return false if the images are not supported by remapFixedPoint() (not 8-bit, or neither 1 nor 3 channels) */
+			template <class IPLIMAGE>
+			bool fillRemapJob(
+				const IPLIMAGE *src, IPLIMAGE *dst,
+				const std::vector<int16_t> &map_xy, const std::vector<uint16_t> &map_frac,
+				const int dst_width, const int dst_height,
+				TRemapJob &job)
+			{
+				const int DEPTH_8U = 8; // IPL_DEPTH_8U
+				if (src->depth!=DEPTH_8U || dst->depth!=DEPTH_8U || src->nChannels!=dst->nChannels || (src->nChannels!=1 && src->nChannels!=3))
+					return false;
+				ASSERT_(dst->width==dst_width && dst->height==dst_height)
+				ASSERT_(map_xy.size()==2*static_cast<size_t>(dst_width)*dst_height && map_frac.size()==static_cast<size_t>(dst_width)*dst_height)
+
+				job.src = reinterpret_cast<const uint8_t*>(src->imageData);
+				job.src_width  = src->width;
+				job.src_height = src->height;
+				job.src_stride = src->widthStep;
+				job.dst = reinterpret_cast<uint8_t*>(dst->imageData);
+				job.dst_width  = dst_width;
+				job.dst_height = dst_height;
+				job.dst_stride = dst->widthStep;
+				job.nChannels  = src->nChannels;
+				job.map_xy   = &map_xy[0];
+				job.map_frac = &map_frac[0];
+				return true;
+			}
+
+		} // end detail
+	}
+}
+
+#endif
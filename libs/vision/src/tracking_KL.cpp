@@ -10,6 +10,7 @@
 #include "vision-precomp.h"   // Precompiled headers
 
 #include <mrpt/system/memory.h>
+#include <mrpt/system/threads.h>
 #include <mrpt/vision/tracking.h>
 #include <mrpt/vision/CFeatureExtraction.h>
 
@@ -26,13 +27,91 @@ using namespace mrpt::vision;
 using namespace mrpt::utils;
 using namespace std;
 
+CFeatureTracker_KL::TPyramidCache::TPyramidCache() : pyramid(NULL), levels(0), win_width(0), win_height(0)
+{
+}
+
+CFeatureTracker_KL::TPyramidCache::TPyramidCache(const TPyramidCache &) : pyramid(NULL), levels(0), win_width(0), win_height(0)
+{
+}
+
+CFeatureTracker_KL::TPyramidCache & CFeatureTracker_KL::TPyramidCache::operator =(const TPyramidCache &o)
+{
+	if (this!=&o) clear();
+	return *this;
+}
+
+CFeatureTracker_KL::TPyramidCache::~TPyramidCache()
+{
+	clear();
+}
+
+void CFeatureTracker_KL::TPyramidCache::clear()
+{
+#if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM>=0x240
+	delete static_cast<std::vector<cv::Mat>*>(pyramid);
+#endif
+	pyramid = NULL;
+	levels = win_width = win_height = 0;
+}
+
+#if MRPT_HAS_OPENCV && MRPT_OPENCV_VERSION_NUM>=0x240
+namespace
+{
+	/** Minimum number of features per thread worth spawning a new thread for */
+	const size_t MIN_LK_FEATURES_PER_THREAD = 32;
+
+	/** Returns true if both 8-bit images have identical size and pixels */
+	bool sameImageContents(const IplImage *a, const IplImage *b)
+	{
+		if (!a || !b) return false;
+		if (a->width!=b->width || a->height!=b->height || a->nChannels!=b->nChannels || a->depth!=b->depth || a->depth!=IPL_DEPTH_8U)
+			return false;
+		const size_t row_len = a->width*a->nChannels;
+		for (int r=0;r<a->height;r++)
+			if (::memcmp(a->imageData+r*a->widthStep, b->imageData+r*b->widthStep, row_len)!=0)
+				return false;
+		return true;
+	}
+
+	/** Tracks a block of features with cv::calcOpticalFlowPyrLK() over two already built (read-only) pyramids */
+	struct TTrackLKBlock
+	{
+		const std::vector<cv::Mat> &prev_pyr, &cur_pyr;
+		CvPoint2D32fVector &prev_pts, &cur_pts;
+		std::vector<char> &status;
+		std::vector<float> &track_error;
+		const cv::Size win_size;
+		const int levels;
+		const cv::TermCriteria criteria;
+
+		TTrackLKBlock(const std::vector<cv::Mat> &pp, const std::vector<cv::Mat> &cp, CvPoint2D32fVector &ppts, CvPoint2D32fVector &cpts,
+			std::vector<char> &st, std::vector<float> &err, cv::Size win, int lev, cv::TermCriteria crit) :
+			prev_pyr(pp), cur_pyr(cp), prev_pts(ppts), cur_pts(cpts), status(st), track_error(err),
+			win_size(win), levels(lev), criteria(crit)
+		{}
+
+		void operator()(size_t first, size_t last, unsigned int)
+		{
+			// Headers over this block of the output vectors, already of the right size and type so OpenCV fills them in place:
+			const int n = static_cast<int>(last-first);
+			const cv::Mat prev_blk(n,1,CV_32FC2,&prev_pts[first]);
+			cv::Mat cur_blk(n,1,CV_32FC2,&cur_pts[first]);
+			cv::Mat status_blk(n,1,CV_8U,&status[first]);
+			cv::Mat err_blk(n,1,CV_32F,&track_error[first]);
+			cv::calcOpticalFlowPyrLK(prev_pyr, cur_pyr, prev_blk, cur_blk, status_blk, err_blk, win_size, levels, criteria);
+		}
+	};
+}
+#endif
+
 
 /** Track a set of features from old_img -> new_img using sparse optimal flow (classic KL method)
   *  Optional parameters that can be passed in "extra_params":
   *		- "window_width"  (Default=15)
   *		- "window_height" (Default=15)
   *
-  *  \sa OpenCV's method cvCalcOpticalFlowPyrLK
+  *  \sa OpenCV's methods cv::buildOpticalFlowPyramid, cv::calcOpticalFlowPyrLK
   */
 template <typename FEATLIST>
 void CFeatureTracker_KL::trackFeatures_impl_templ(
@@ -50,6 +129,8 @@ MRPT_START
 	const int 	LK_max_iters = extra_params.getWithDefaultVal("LK_max_iters",10);
 	const int 	LK_epsilon   = extra_params.getWithDefaultVal("LK_epsilon",0.1);
 	const float LK_max_tracking_error = extra_params.getWithDefaultVal("LK_max_tracking_error",150.0f);
+	const bool  LK_cache_pyramids = extra_params.getWithDefaultVal("LK_cache_pyramids",1)!=0;
+	const unsigned int LK_num_threads = extra_params.getWithDefaultVal("LK_num_threads",0);
 
 
 	// Both images must be of the same size
@@ -67,12 +148,12 @@ MRPT_START
 	// Array conversion MRPT->OpenCV
 	if (nFeatures>0)
 	{
-		CvPoint2D32f *points[2];
-
-		points[0] = reinterpret_cast<CvPoint2D32f *>( mrpt_alloca(sizeof(CvPoint2D32f)*nFeatures) );
-		points[1] = reinterpret_cast<CvPoint2D32f *>( mrpt_alloca(sizeof(CvPoint2D32f)*nFeatures) );
+		CvPoint2D32fVector points[2];
+		points[0].resize(nFeatures);
+		points[1].resize(nFeatures);
 
 		std::vector<char>	status(nFeatures);
+		std::vector<float>	track_error(nFeatures);
 
 		for(size_t i=0;i<nFeatures;++i)
 		{
@@ -80,25 +161,51 @@ MRPT_START
 			points[0][i].y = featureList.getFeatureY(i);
 		} // end for
 
-		// local scope for auxiliary variables around cvCalcOpticalFlowPyrLK()
-		const IplImage *prev_gray_ipl = prev_gray.getAs<IplImage>();
-		const IplImage *cur_gray_ipl  = cur_gray.getAs<IplImage>();
-
-		// Pyramids
-		// JL: It seems that cache'ing the pyramids of previous images doesn't really improve the efficiency (!?!?)
-		IplImage* pPyr = NULL;
-		IplImage* cPyr = NULL;
-
-		int	flags = 0;
+#if MRPT_OPENCV_VERSION_NUM>=0x240
+		const cv::Size win_size( window_width, window_height );
+		const cv::TermCriteria criteria(cv::TermCriteria::COUNT|cv::TermCriteria::EPS,LK_max_iters,LK_epsilon);
 
-		float* track_error = reinterpret_cast<float*>( mrpt_alloca(sizeof(float)*nFeatures) );
-
-		cvCalcOpticalFlowPyrLK(prev_gray_ipl, cur_gray_ipl, pPyr, cPyr,
-			&points[0][0], &points[1][0], nFeatures, cvSize( window_width, window_height ), LK_levels, &status[0], track_error,
-			cvTermCriteria(CV_TERMCRIT_ITER|CV_TERMCRIT_EPS,LK_max_iters,LK_epsilon), flags );
-
-		cvReleaseImage( &pPyr );
-		cvReleaseImage( &cPyr );
+		// Pyramids are built only once per image, and the one of the previous "new_img" is reused if it's now our "old_img":
+		std::vector<cv::Mat> *prev_pyr = NULL;
+		if (LK_cache_pyramids && m_pyramid_cache.pyramid && m_pyramid_cache.levels==LK_levels &&
+			m_pyramid_cache.win_width==static_cast<int>(window_width) && m_pyramid_cache.win_height==static_cast<int>(window_height) &&
+			sameImageContents(m_pyramid_cache.gray.getAs<IplImage>(), prev_gray.getAs<IplImage>()) )
+		{
+			prev_pyr = static_cast<std::vector<cv::Mat>*>(m_pyramid_cache.pyramid);
+			m_pyramid_cache.pyramid = NULL;
+		}
+		else
+		{
+			prev_pyr = new std::vector<cv::Mat>();
+			cv::buildOpticalFlowPyramid(cv::cvarrToMat(prev_gray.getAs<IplImage>()), *prev_pyr, win_size, LK_levels, true, cv::BORDER_REFLECT_101, cv::BORDER_CONSTANT, false);
+		}
+		std::vector<cv::Mat> *cur_pyr = new std::vector<cv::Mat>();
+		cv::buildOpticalFlowPyramid(cv::cvarrToMat(cur_gray.getAs<IplImage>()), *cur_pyr, win_size, LK_levels, true, cv::BORDER_REFLECT_101, cv::BORDER_CONSTANT, false);
+
+		// Features are split among threads, all of them reading the same pyramids:
+		unsigned int num_threads = LK_num_threads ? LK_num_threads : mrpt::system::getNumberOfProcessors();
+		num_threads = static_cast<unsigned int>( std::max<size_t>(1, std::min<size_t>(num_threads, nFeatures/MIN_LK_FEATURES_PER_THREAD)) );
+
+		TTrackLKBlock functor(*prev_pyr, *cur_pyr, points[0], points[1], status, track_error, win_size, LK_levels, criteria);
+		mrpt::system::parallelForBlocks(nFeatures, functor, num_threads);
+
+		delete prev_pyr;
+		m_pyramid_cache.clear();
+		if (LK_cache_pyramids)
+		{
+			m_pyramid_cache.pyramid = cur_pyr;
+			m_pyramid_cache.levels = LK_levels;
+			m_pyramid_cache.win_width = window_width;
+			m_pyramid_cache.win_height = window_height;
+			m_pyramid_cache.gray = cur_gray;
+		}
+		else delete cur_pyr;
+#else
+		// Older OpenCV versions: pyramids are built by each call, so neither cached nor shared among threads
+		cvCalcOpticalFlowPyrLK(prev_gray.getAs<IplImage>(), cur_gray.getAs<IplImage>(), NULL, NULL,
+			&points[0][0], &points[1][0], nFeatures, cvSize( window_width, window_height ), LK_levels, &status[0], &track_error[0],
+			cvTermCriteria(CV_TERMCRIT_ITER|CV_TERMCRIT_EPS,LK_max_iters,LK_epsilon), 0 );
+#endif
 
 		for(size_t i=0;i<nFeatures;++i)
 		{
@@ -122,11 +229,6 @@ MRPT_START
 			} // end else
 		} // end for
 
-		mrpt_alloca_free( points[0] );
-		mrpt_alloca_free( points[1] );
-		mrpt_alloca_free( track_error );
-
-
 		// In case it needs to rebuild a kd-tree or whatever
 		featureList.mark_as_outdated();
 	}
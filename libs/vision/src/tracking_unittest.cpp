@@ -0,0 +1,124 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/tracking.h>
+#include <mrpt/math/CMatrixTemplateNumeric.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace std;
+
+#if MRPT_HAS_OPENCV
+
+namespace
+{
+	// A smooth synthetic texture, shifted by (dx,dy) pixels:
+	void generate_image(CImage &img, double dx, double dy)
+	{
+		mrpt::math::CMatrixFloat m(240,320);
+		for (int r=0;r<240;r++)
+			for (int c=0;c<320;c++)
+			{
+				const double x = c-dx, y = r-dy;
+				m(r,c) = static_cast<float>( 0.5 + 0.2*sin(x/7.0)*cos(y/5.0) + 0.15*sin((x+y)/11.0) );
+			}
+		img = CImage(m,true);
+	}
+
+	void generate_features(TSimpleFeaturefList &feats)
+	{
+		feats.clear();
+		for (int y=40;y<200;y+=8)
+			for (int x=40;x<280;x+=8)
+			{
+				TSimpleFeaturef f(x,y);
+				f.ID = feats.size();
+				f.track_status = status_IDLE;
+				feats.push_back(f);
+			}
+	}
+
+	void track(CFeatureTracker_KL &tracker, const CImage &img1, const CImage &img2, TSimpleFeaturefList &feats)
+	{
+		tracker.extra_params["check_KLT_response_every"] = 0;
+		tracker.extra_params["remove_lost_features"] = 0;
+		tracker.trackFeatures(img1,img2,feats);
+	}
+
+	void expect_same_tracking(const TSimpleFeaturefList &a, const TSimpleFeaturefList &b)
+	{
+		ASSERT_EQ(a.size(), b.size());
+		for (size_t i=0;i<a.size();i++)
+		{
+			EXPECT_EQ(a[i].track_status, b[i].track_status) << "i=" << i;
+			EXPECT_FLOAT_EQ(a[i].pt.x, b[i].pt.x) << "i=" << i;
+			EXPECT_FLOAT_EQ(a[i].pt.y, b[i].pt.y) << "i=" << i;
+		}
+	}
+}
+
+TEST(CFeatureTracker_KL, ThreadsGiveSameResults)
+{
+	CImage img1, img2;
+	generate_image(img1, 0,0);
+	generate_image(img2, 1.5,0.75);
+
+	TSimpleFeaturefList feats1, featsN;
+	generate_features(feats1);
+	generate_features(featsN);
+	ASSERT_GT(feats1.size(), 4*32u);  // Enough features to actually use several threads
+
+	CFeatureTracker_KL tracker1, trackerN;
+	tracker1.extra_params["LK_num_threads"] = 1;
+	trackerN.extra_params["LK_num_threads"] = 4;
+	track(tracker1, img1,img2, feats1);
+	track(trackerN, img1,img2, featsN);
+
+	expect_same_tracking(feats1, featsN);
+
+	size_t nTracked = 0;
+	for (size_t i=0;i<feats1.size();i++)
+	{
+		if (feats1[i].track_status!=status_TRACKED) continue;
+		nTracked++;
+		const TSimpleFeaturef f0(40+8*(i%30), 40+8*(i/30));
+		EXPECT_NEAR(feats1[i].pt.x-f0.pt.x, 1.5, 0.1) << "i=" << i;
+		EXPECT_NEAR(feats1[i].pt.y-f0.pt.y, 0.75, 0.1) << "i=" << i;
+	}
+	EXPECT_GT(nTracked, feats1.size()*9/10);
+}
+
+TEST(CFeatureTracker_KL, CachedPyramidGivesSameResults)
+{
+	CImage img1, img2, img3;
+	generate_image(img1, 0,0);
+	generate_image(img2, 1.5,0.75);
+	generate_image(img3, 2.5,1.0);
+
+	// With cache: the pyramid of img2 built in the first call is reused in the second one.
+	TSimpleFeaturefList feats_cache, feats_nocache;
+	generate_features(feats_cache);
+	generate_features(feats_nocache);
+
+	CFeatureTracker_KL tracker_cache, tracker_nocache;
+	tracker_cache.extra_params["LK_cache_pyramids"] = 1;
+	tracker_nocache.extra_params["LK_cache_pyramids"] = 0;
+	for (int k=0;k<2;k++)
+	{
+		const CImage &a = k==0 ? img1 : img2;
+		const CImage &b = k==0 ? img2 : img3;
+		track(tracker_cache, a,b, feats_cache);
+		track(tracker_nocache, a,b, feats_nocache);
+		expect_same_tracking(feats_cache, feats_nocache);
+	}
+}
+
+#endif
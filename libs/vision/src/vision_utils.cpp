@@ -14,6 +14,7 @@
 #include <mrpt/vision/pinhole.h>
 #include <mrpt/vision/CFeatureExtraction.h>
 #include <mrpt/vision/CFeature.h>
+#include <mrpt/vision/descriptor_pairing.h>
 
 #include <mrpt/poses/CPoint3D.h>
 #include <mrpt/maps/CLandmarksMap.h>
@@ -26,6 +27,7 @@
 #include <mrpt/math/ops_vectors.h>
 #include <mrpt/math/lightweight_geom_data.h>
 #include <mrpt/math/geometry.h>
+#include "descriptor_matching_internals.h"
 
 // Universal include for all versions of OpenCV
 #include <mrpt/otherlibs/do_opencv_includes.h>
@@ -454,6 +456,37 @@ void vision::normalizeImage(
     nimage.setFromMatrix( nim );
 } // end normalizeImage
 
+namespace
+{
+	/** The epipolar and x-coordinate restrictions of matchFeatures(), as a pair filter for the descriptor matching engine */
+	struct TMatchFeaturesPairFilter
+	{
+		const TFeatureListColumns &cols1, &cols2;
+		const TMatchingOptions &options;
+		const std::vector<TLine2D> &epilines; //!< Only used if !parallelOpticalAxis
+
+		TMatchFeaturesPairFilter(const TFeatureListColumns &c1, const TFeatureListColumns &c2, const TMatchingOptions &opts, const std::vector<TLine2D> &epilines_) :
+			cols1(c1), cols2(c2), options(opts), epilines(epilines_)
+		{}
+
+		inline bool operator()(size_t i, size_t j) const
+		{
+			if( options.useEpipolarRestriction )
+			{
+				const double d = options.parallelOpticalAxis ?
+					cols1.y[i] - cols2.y[j]
+					:
+					epilines[i].distance( TPoint2D(cols2.x[j],cols2.y[j]) );
+				if( !(fabs(d) < options.epipolar_TH) )
+					return false;
+			}
+			if( options.useXRestriction && !((cols1.x[i] - cols2.x[j]) > 0) )
+				return false;
+			return true;
+		}
+	};
+}
+
 /*-------------------------------------------------------------
 						matchFeatures
 -------------------------------------------------------------*/
@@ -496,6 +529,58 @@ size_t vision::matchFeatures(
 	int minLeftIdx = 0, minRightIdx;
 	int nMatches = 0;
 
+	// Descriptor-based methods: find the two nearest neighbors of all the left features at once,
+	// with the contiguous-buffer matching engine (popcnt Hamming / vectorized L2, parallel blocks of rows):
+	const bool use_descriptor_engine =
+		options.matching_method==TMatchingOptions::mmDescriptorSIFT ||
+		options.matching_method==TMatchingOptions::mmDescriptorSURF ||
+		options.matching_method==TMatchingOptions::mmDescriptorORB;
+	std::vector<TDescriptorMatchCandidate> desc_candidates;
+	if( use_descriptor_engine )
+	{
+		if( options.useEpipolarRestriction && !options.parallelOpticalAxis )
+			ASSERT_( options.hasFundamentalMatrix );
+
+		std::vector<TLine2D> epilines;
+		if( options.useEpipolarRestriction && !options.parallelOpticalAxis )
+		{
+			// The epipolar line only depends on the left feature:
+			epilines.resize(sz1);
+			for( size_t i = 0; i < sz1; ++i )
+			{
+				CMatrixDouble31 l, p;
+				p(0,0) = list1[i]->x;
+				p(1,0) = list1[i]->y;
+				p(2,0) = 1;
+				l = params.F*p;
+				for( int k = 0; k < 3; ++k )
+					epilines[i].coefs[k] = l(k,0);
+			}
+		}
+		// Coordinates and descriptors are taken from a contiguous, columnar snapshot of each list:
+		const TFeatureListColumns cols1(list1), cols2(list2);
+		const TMatchFeaturesPairFilter filter( cols1, cols2, options, epilines );
+		switch( options.matching_method )
+		{
+		case TMatchingOptions::mmDescriptorORB:
+			ASSERTMSG_( cols1.ORB_len>0 && cols1.ORB_len==cols2.ORB_len, "All features must have ORB descriptors of the same length" )
+			detail::findBestMatches( detail::THammingDistance(&cols1.ORB[0],&cols2.ORB[0],cols1.ORB_len), filter, sz1, sz2, desc_candidates, 0 );
+			break;
+		case TMatchingOptions::mmDescriptorSIFT:
+			ASSERTMSG_( cols1.SIFT_len>0 && cols1.SIFT_len==cols2.SIFT_len, "All features must have SIFT descriptors of the same length" )
+			detail::findBestMatches( detail::TSquaredL2Distance<uint8_t>(&cols1.SIFT[0],&cols2.SIFT[0],cols1.SIFT_len), filter, sz1, sz2, desc_candidates, 0 );
+			// Same normalized distances than CFeature::descriptorSIFTDistanceTo():
+			detail::sqrtMatchDistances( desc_candidates, 1.0f/( std::sqrt(static_cast<float>(cols1.SIFT_len)) * 64.0f ) );
+			break;
+		default: // mmDescriptorSURF
+			ASSERTMSG_( cols1.SURF_len>0 && cols1.SURF_len==cols2.SURF_len, "All features must have SURF descriptors of the same length" )
+			detail::findBestMatches( detail::TSquaredL2Distance<float>(&cols1.SURF[0],&cols2.SURF[0],cols1.SURF_len), filter, sz1, sz2, desc_candidates, 0 );
+			// Same normalized distances than CFeature::descriptorSURFDistanceTo():
+			detail::sqrtMatchDistances( desc_candidates, 1.0f/( std::sqrt(static_cast<float>(cols1.SURF_len)) * 0.20f ) );
+			break;
+		}
+	}
+
 	// For each feature in list1 ...
 	for( lFeat = 0, itList1 = list1.begin(); itList1 != list1.end(); ++itList1, ++lFeat )
 	{
@@ -514,7 +599,21 @@ size_t vision::matchFeatures(
 		// For all the cases
 		minRightIdx = 0;
 
-		for( rFeat = 0, itList2 = list2.begin(); itList2 != list2.end(); ++itList2, ++rFeat )		// ... compare with all the features in list2.
+		if( use_descriptor_engine )
+		{
+			// Descriptor-based methods: the two nearest neighbors have already been found above
+			const TDescriptorMatchCandidate &cand = desc_candidates[lFeat];
+			if( cand.idx >= 0 )
+			{
+				minDist1 = cand.dist1;
+				if( cand.dist2 != std::numeric_limits<float>::max() )
+					minDist2 = cand.dist2;
+				minLeftIdx  = lFeat;
+				minRightIdx = cand.idx;
+			}
+		}
+
+		for( rFeat = 0, itList2 = list2.begin(); !use_descriptor_engine && itList2 != list2.end(); ++itList2, ++rFeat )		// ... compare with all the features in list2 (already done above for descriptor-based methods).
 		{
 			// Filter out by epipolar constraint
 			double d = 0.0;														// Distance to the epipolar line
@@ -0,0 +1,95 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2016, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision/utils.h>
+#include <mrpt/vision/CFeature.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace std;
+
+namespace
+{
+	// N features with random ORB descriptors, on a row of the image:
+	void generate_ORB_features(size_t N, CFeatureList &feats)
+	{
+		feats.clear();
+		for (size_t i=0;i<N;i++)
+		{
+			CFeaturePtr ft = CFeature::Create();
+			ft->ID = i;
+			ft->x = 10.0f + 5*i;
+			ft->y = 100.0f;
+			ft->descriptors.ORB.resize(32);
+			for (size_t k=0;k<32;k++)
+				ft->descriptors.ORB[k] = static_cast<uint8_t>( mrpt::random::randomGenerator.drawUniform32bit() );
+			feats.push_back(ft);
+		}
+	}
+
+	// The same features (copies) in reverse order:
+	void reversed_copy(const CFeatureList &in, CFeatureList &out)
+	{
+		out.clear();
+		for (size_t i=in.size();i-->0;)
+		{
+			CFeaturePtr ft = CFeature::Create();
+			*ft = *in[i];
+			ft->ID = 1000+i;
+			out.push_back(ft);
+		}
+	}
+
+	// For each left feature ID, the ID of the matched right feature:
+	std::map<TFeatureID,TFeatureID> match_ORB(const CFeatureList &list1, const CFeatureList &list2)
+	{
+		TMatchingOptions opts;
+		opts.matching_method = TMatchingOptions::mmDescriptorORB;
+		opts.maxORB_dist = 20;
+		opts.useXRestriction = false;
+		opts.useEpipolarRestriction = true;
+		opts.parallelOpticalAxis = true;
+		opts.epipolar_TH = 2.0;
+
+		CMatchedFeatureList matches;
+		matchFeatures(list1, list2, matches, opts);
+		std::map<TFeatureID,TFeatureID> ret;
+		for (CMatchedFeatureList::const_iterator it=matches.begin();it!=matches.end();++it)
+			ret[it->first->ID] = it->second->ID;
+		return ret;
+	}
+}
+
+TEST(vision_utils, matchFeatures_AfterEditingFeatures)
+{
+	mrpt::random::randomGenerator.randomize(1234);
+	const size_t N = 20;
+	CFeatureList list1, list2;
+	generate_ORB_features(N, list1);
+	reversed_copy(list1, list2);
+
+	std::map<TFeatureID,TFeatureID> m = match_ORB(list1, list2);
+	ASSERT_EQ(m.size(), N);
+	for (size_t i=0;i<N;i++)
+		EXPECT_EQ(m[i], 1000+i);
+
+	// Swap two descriptors and move a feature out of the epipolar band, through the feature pointers:
+	list2[0]->descriptors.ORB.swap(list2[1]->descriptors.ORB); // Right features #1019 and #1018
+	list2[2]->y += 50; // Right feature #1017
+
+	m = match_ORB(list1, list2);
+	EXPECT_EQ(m.size(), N-1);
+	EXPECT_EQ(m[N-1], 1000+N-2);
+	EXPECT_EQ(m[N-2], 1000+N-1);
+	EXPECT_TRUE(m.find(N-3)==m.end());
+	for (size_t i=0;i<N-3;i++)
+		EXPECT_EQ(m[i], 1000+i);
+}
@@ -149,7 +149,8 @@ void BenchmarkGridmaps()
 		COccupancyGridMap2D::cellType  logodd_obs = COccupancyGridMap2D::p2l( p );
 		//float   p_1 = 1-p;
 
-		COccupancyGridMap2D::cellType  *theMapArray = gridMap->getRow(0);
+		std::vector<COccupancyGridMap2D::cellType> cells(gridMap->getSizeX()*gridMap->getSizeY(), COccupancyGridMap2D::p2l(0.5f));
+		COccupancyGridMap2D::cellType  *theMapArray = &cells[0];
 		unsigned  theMapSize_x = gridMap->getSizeX();
 		COccupancyGridMap2D::cellType   logodd_thres_occupied =  COccupancyGridMap2D::OCCGRID_CELLTYPE_MIN+logodd_obs;
 